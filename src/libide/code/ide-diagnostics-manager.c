@@ -78,6 +78,9 @@ typedef struct
   /* The last language id we were notified about */
   const gchar *lang_id;
 
+  /* When the current diagnosis began, to profile provider latency */
+  gint64 diagnose_begin_time;
+
   /*
    * This is our sequence number for diagnostics. It is monotonically
    * increasing with every diagnostic discovered.
@@ -317,6 +320,20 @@ ide_diagnostics_group_diagnose_cb (GObject      *object,
 
   diagnostics = ide_diagnostic_provider_diagnose_finish (provider, result, &error);
 
+  /*
+   * This fetches the group our provider belongs to. Since the group is
+   * reference counted (and we only release it when our provider is
+   * finalized), we should be guaranteed we have a valid group.
+   */
+  group = g_object_get_data (G_OBJECT (provider), "IDE_DIAGNOSTICS_GROUP");
+
+  if (group != NULL)
+    ide_profiler_mark (group->diagnose_begin_time,
+                       g_get_monotonic_time (),
+                       "diagnostics",
+                       G_OBJECT_TYPE_NAME (provider),
+                       group->lang_id);
+
   IDE_TRACE_MSG ("%s diagnosis completed (%s)",
                  G_OBJECT_TYPE_NAME (provider),
                  error ? error->message : "success");
@@ -326,13 +343,6 @@ ide_diagnostics_group_diagnose_cb (GObject      *object,
       !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
     g_debug ("%s", error->message);
 
-  /*
-   * This fetches the group our provider belongs to. Since the group is
-   * reference counted (and we only release it when our provider is
-   * finalized), we should be guaranteed we have a valid group.
-   */
-  group = g_object_get_data (G_OBJECT (provider), "IDE_DIAGNOSTICS_GROUP");
-
   if (group == NULL)
     {
       /* Warning and bail if we failed to get the diagnostic group.
@@ -475,6 +485,7 @@ ide_diagnostics_group_diagnose (IdeDiagnosticsGroup   *group,
 
   group->needs_diagnose = FALSE;
   group->has_diagnostics = FALSE;
+  group->diagnose_begin_time = g_get_monotonic_time ();
 
   if (group->contents == NULL)
     group->contents = g_bytes_new ("", 0);
@@ -41,6 +41,27 @@
 
 #define RUN_UNCHECKED GSIZE_TO_POINTER(0)
 #define RUN_CHECKED   GSIZE_TO_POINTER(1)
+/* Dropped under memory pressure, only redone once a view comes near */
+#define RUN_DEFERRED  GSIZE_TO_POINTER(2)
+
+/* Lines around each visible range that are treated as visible so that
+ * scrolling a little does not reveal unhighlighted text. Ranges far larger
+ * than this use their own height instead.
+ */
+#define VIEWPORT_MARGIN_LINES 100
+
+/* Under memory pressure, highlighting is kept for this many viewport
+ * margins around each view and dropped everywhere else.
+ */
+#define VIEWPORT_KEEP_MARGINS 4
+
+typedef struct
+{
+  gconstpointer owner;
+  guint         begin_line;
+  guint         end_line;
+  guint         margin;
+} Viewport;
 
 struct _IdeHighlightEngine
 {
@@ -56,6 +77,11 @@ struct _IdeHighlightEngine
 
   CjhTextRegion       *region;
 
+  /* Array of Viewport, one per view showing the buffer */
+  GArray              *viewports;
+
+  GMemoryMonitor      *memory_monitor;
+
   GSList              *private_tags;
   GSList              *public_tags;
 
@@ -266,8 +292,9 @@ ide_highlight_engine_apply_style (const GtkTextIter *begin,
 
 typedef struct
 {
-  gsize offset;
-  gsize length;
+  gsize    offset;
+  gsize    length;
+  gboolean include_deferred;
 } GetUncheckedRange;
 
 static inline gboolean
@@ -276,14 +303,18 @@ get_unchecked_start_cb (gsize                   offset,
                         gpointer                user_data)
 {
   GetUncheckedRange *range = user_data;
+  gboolean needs_work;
 
   g_assert (run != NULL);
   g_assert (run->length > 0);
 
-  if (range->offset == G_MAXSIZE && run->data == RUN_CHECKED)
+  needs_work = run->data == RUN_UNCHECKED ||
+               (range->include_deferred && run->data == RUN_DEFERRED);
+
+  if (range->offset == G_MAXSIZE && !needs_work)
     return FALSE;
 
-  if (run->data == RUN_UNCHECKED)
+  if (needs_work)
     {
       if (range->offset == G_MAXSIZE)
         range->offset = offset;
@@ -294,15 +325,81 @@ get_unchecked_start_cb (gsize                   offset,
   return TRUE;
 }
 
+static void
+viewport_get_bounds (const Viewport *viewport,
+                     GtkTextBuffer  *buffer,
+                     guint           n_margins,
+                     GtkTextIter    *begin,
+                     GtkTextIter    *end)
+{
+  guint margin = viewport->margin * n_margins;
+  guint begin_line = viewport->begin_line > margin ? viewport->begin_line - margin : 0;
+  guint end_line = MIN ((guint64)viewport->end_line + margin, G_MAXINT);
+
+  /* Both are clamped to the buffer by GtkTextBuffer */
+  gtk_text_buffer_get_iter_at_line (buffer, begin, begin_line);
+  gtk_text_buffer_get_iter_at_line (buffer, end, end_line);
+
+  if (!gtk_text_iter_ends_line (end))
+    gtk_text_iter_forward_to_line_end (end);
+}
+
 static gboolean
-get_next_range (CjhTextRegion *region,
-                GtkTextBuffer *buffer,
-                GtkTextIter   *begin,
-                GtkTextIter   *end)
+get_next_range (IdeHighlightEngine *self,
+                GtkTextBuffer      *buffer,
+                GtkTextIter        *begin,
+                GtkTextIter        *end,
+                gboolean           *in_view)
 {
-  GetUncheckedRange range = {G_MAXSIZE, 0};
+  GetUncheckedRange range = {G_MAXSIZE, 0, FALSE};
+  gsize length;
 
-  _cjh_text_region_foreach (region, get_unchecked_start_cb, &range);
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (in_view != NULL);
+
+  length = _cjh_text_region_get_length (self->region);
+
+  /* Anything within (or near) what is on screen always goes first, even
+   * if it was deferred under memory pressure.
+   */
+  for (guint i = 0; i < self->viewports->len; i++)
+    {
+      const Viewport *viewport = &g_array_index (self->viewports, Viewport, i);
+      GetUncheckedRange visible = {G_MAXSIZE, 0, TRUE};
+      GtkTextIter vbegin;
+      GtkTextIter vend;
+      gsize vbegin_offset;
+      gsize vend_offset;
+
+      viewport_get_bounds (viewport, buffer, 1, &vbegin, &vend);
+
+      vbegin_offset = MIN (length, gtk_text_iter_get_offset (&vbegin));
+      vend_offset = MIN (length, gtk_text_iter_get_offset (&vend));
+
+      _cjh_text_region_foreach_in_range (self->region,
+                                         vbegin_offset,
+                                         vend_offset,
+                                         get_unchecked_start_cb,
+                                         &visible);
+
+      if (visible.length > 0 && visible.offset != G_MAXSIZE)
+        {
+          gsize first = MAX (visible.offset, vbegin_offset);
+          gsize last = MIN (visible.offset + visible.length, vend_offset);
+
+          if (first < last)
+            {
+              gtk_text_buffer_get_iter_at_offset (buffer, begin, first);
+              gtk_text_buffer_get_iter_at_offset (buffer, end, last);
+              *in_view = TRUE;
+              return TRUE;
+            }
+        }
+    }
+
+  *in_view = FALSE;
+
+  _cjh_text_region_foreach (self->region, get_unchecked_start_cb, &range);
 
   if (range.length == 0 || range.offset == G_MAXSIZE)
     return FALSE;
@@ -321,6 +418,7 @@ ide_highlight_engine_tick (IdeHighlightEngine *self,
   GtkTextIter iter;
   GtkTextIter invalid_begin;
   GtkTextIter invalid_end;
+  gboolean in_view;
 
   IDE_PROBE;
 
@@ -330,14 +428,20 @@ ide_highlight_engine_tick (IdeHighlightEngine *self,
   if (!(buffer = g_weak_ref_get (&self->buffer_wref)))
     return G_SOURCE_REMOVE;
 
-  self->quanta_expiration = deadline;
-
-  if (!get_next_range (self->region, buffer, &invalid_begin, &invalid_end))
+  if (!get_next_range (self, buffer, &invalid_begin, &invalid_end, &in_view))
     return G_SOURCE_REMOVE;
 
 again:
   g_assert (gtk_text_iter_compare (&invalid_begin, &invalid_end) <= 0);
 
+  /* Off-screen work only gets half of what remains of the frame so that
+   * it does not compete with everything else the main loop has to do.
+   */
+  if (in_view)
+    self->quanta_expiration = deadline;
+  else
+    self->quanta_expiration = MIN (deadline, (g_get_monotonic_time () + deadline) / 2);
+
   IDE_TRACE_MSG ("Highlight Range [%u:%u,%u:%u] (%s)",
                  gtk_text_iter_get_line (&invalid_begin) + 1,
                  gtk_text_iter_get_line_offset (&invalid_begin) + 1,
@@ -369,7 +473,7 @@ again:
 
   if (gtk_text_iter_compare (&iter, &invalid_end) >= 0)
     {
-      if (get_next_range (self->region, buffer, &invalid_begin, &invalid_end))
+      if (get_next_range (self, buffer, &invalid_begin, &invalid_end, &in_view))
         IDE_GOTO (again);
     }
 
@@ -390,7 +494,16 @@ ide_highlight_engine_worker (gint64   deadline,
 
   if (self->enabled)
     {
-      if (ide_highlight_engine_tick (self, deadline))
+      gint64 begin_time = g_get_monotonic_time ();
+      gboolean ret = ide_highlight_engine_tick (self, deadline);
+
+      ide_profiler_mark (begin_time,
+                         g_get_monotonic_time (),
+                         "highlight",
+                         "tick",
+                         self->highlighter ? G_OBJECT_TYPE_NAME (self->highlighter) : NULL);
+
+      if (ret)
         return G_SOURCE_CONTINUE;
     }
 
@@ -434,6 +547,213 @@ ide_highlight_engine_advance (IdeHighlightEngine *self)
   ide_highlight_engine_queue_work (self);
 }
 
+static Viewport *
+find_viewport (IdeHighlightEngine *self,
+               gconstpointer       owner,
+               guint              *position)
+{
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+
+  for (guint i = 0; i < self->viewports->len; i++)
+    {
+      Viewport *viewport = &g_array_index (self->viewports, Viewport, i);
+
+      if (viewport->owner == owner)
+        {
+          if (position != NULL)
+            *position = i;
+          return viewport;
+        }
+    }
+
+  return NULL;
+}
+
+/**
+ * ide_highlight_engine_set_visible_range:
+ * @self: a #IdeHighlightEngine
+ * @owner: an opaque pointer identifying the view, such as the view itself
+ * @begin: the first visible position
+ * @end: the last visible position
+ *
+ * Notes that the view identified by @owner is showing the range of the
+ * buffer from @begin to @end.
+ *
+ * Invalid regions within (or near) any visible range are highlighted before
+ * the rest of the buffer so that what the user is looking at is updated
+ * first after an edit, reload, or scroll.
+ *
+ * Call ide_highlight_engine_clear_visible_range() when the view stops
+ * showing the buffer.
+ *
+ * Since: 44
+ */
+void
+ide_highlight_engine_set_visible_range (IdeHighlightEngine *self,
+                                        gconstpointer       owner,
+                                        const GtkTextIter  *begin,
+                                        const GtkTextIter  *end)
+{
+  Viewport *viewport;
+  guint begin_line;
+  guint end_line;
+
+  g_return_if_fail (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_return_if_fail (owner != NULL);
+  g_return_if_fail (begin != NULL);
+  g_return_if_fail (end != NULL);
+
+  begin_line = gtk_text_iter_get_line (begin);
+  end_line = gtk_text_iter_get_line (end);
+
+  if (begin_line > end_line)
+    {
+      guint tmp = begin_line;
+      begin_line = end_line;
+      end_line = tmp;
+    }
+
+  if (!(viewport = find_viewport (self, owner, NULL)))
+    {
+      Viewport empty = { owner };
+
+      g_array_append_val (self->viewports, empty);
+      viewport = &g_array_index (self->viewports, Viewport, self->viewports->len - 1);
+    }
+  else if (viewport->begin_line == begin_line && viewport->end_line == end_line)
+    return;
+
+  viewport->begin_line = begin_line;
+  viewport->end_line = end_line;
+  viewport->margin = MAX (VIEWPORT_MARGIN_LINES, end_line - begin_line);
+
+  ide_highlight_engine_queue_work (self);
+}
+
+/**
+ * ide_highlight_engine_clear_visible_range:
+ * @self: a #IdeHighlightEngine
+ * @owner: the owner passed to ide_highlight_engine_set_visible_range()
+ *
+ * Removes the visible range previously set for @owner.
+ *
+ * Since: 44
+ */
+void
+ide_highlight_engine_clear_visible_range (IdeHighlightEngine *self,
+                                          gconstpointer       owner)
+{
+  guint position;
+
+  g_return_if_fail (IDE_IS_HIGHLIGHT_ENGINE (self));
+
+  if (self->viewports != NULL && find_viewport (self, owner, &position))
+    g_array_remove_index_fast (self->viewports, position);
+}
+
+static int
+compare_kept_range (gconstpointer a,
+                    gconstpointer b)
+{
+  const gsize *range_a = a;
+  const gsize *range_b = b;
+
+  if (range_a[0] < range_b[0])
+    return -1;
+  else if (range_a[0] > range_b[0])
+    return 1;
+  else
+    return 0;
+}
+
+static void
+ide_highlight_engine_defer_range (IdeHighlightEngine *self,
+                                  GtkTextBuffer      *buffer,
+                                  gsize               begin_offset,
+                                  gsize               end_offset)
+{
+  GtkTextIter begin;
+  GtkTextIter end;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  end_offset = MIN (end_offset, _cjh_text_region_get_length (self->region));
+
+  if (begin_offset >= end_offset)
+    return;
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &begin, begin_offset);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, end_offset);
+
+  for (const GSList *iter = self->private_tags; iter; iter = iter->next)
+    gtk_text_buffer_remove_tag (buffer, iter->data, &begin, &end);
+
+  _cjh_text_region_replace (self->region,
+                            begin_offset,
+                            end_offset - begin_offset,
+                            RUN_DEFERRED);
+}
+
+static void
+ide_highlight_engine_low_memory_warning_cb (IdeHighlightEngine         *self,
+                                            GMemoryMonitorWarningLevel  level,
+                                            GMemoryMonitor             *monitor)
+{
+  g_autoptr(GtkTextBuffer) buffer = NULL;
+  g_autoptr(GArray) kept = NULL;
+  gsize length;
+  gsize last = 0;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (G_IS_MEMORY_MONITOR (monitor));
+
+  if (!(buffer = g_weak_ref_get (&self->buffer_wref)) ||
+      self->private_tags == NULL ||
+      !(length = _cjh_text_region_get_length (self->region)))
+    IDE_EXIT;
+
+  /* Keep highlighting close to any view so scrolling still looks right,
+   * and drop it everywhere else. Those runs are redone lazily once a view
+   * gets near them again.
+   */
+  kept = g_array_sized_new (FALSE, FALSE, sizeof (gsize) * 2, self->viewports->len);
+
+  for (guint i = 0; i < self->viewports->len; i++)
+    {
+      const Viewport *viewport = &g_array_index (self->viewports, Viewport, i);
+      GtkTextIter begin;
+      GtkTextIter end;
+      gsize range[2];
+
+      viewport_get_bounds (viewport, buffer, VIEWPORT_KEEP_MARGINS, &begin, &end);
+
+      range[0] = gtk_text_iter_get_offset (&begin);
+      range[1] = gtk_text_iter_get_offset (&end);
+
+      g_array_append_vals (kept, range, 1);
+    }
+
+  g_array_sort (kept, compare_kept_range);
+
+  for (guint i = 0; i < kept->len; i++)
+    {
+      const gsize *range = &((const gsize *)(gpointer)kept->data)[i * 2];
+
+      ide_highlight_engine_defer_range (self, buffer, last, MIN (range[0], length));
+      last = MAX (last, range[1]);
+    }
+
+  ide_highlight_engine_defer_range (self, buffer, last, length);
+
+  IDE_TRACE_MSG ("Dropped highlighting outside of %u visible ranges (level %u)",
+                 self->viewports->len, level);
+
+  IDE_EXIT;
+}
+
 static void
 ide_highlight_engine_reload (IdeHighlightEngine *self)
 {
@@ -737,6 +1057,8 @@ ide_highlight_engine__unbind_buffer_cb (IdeHighlightEngine  *self,
   g_clear_pointer (&self->public_tags, g_slist_free);
   g_clear_pointer (&self->private_tags, g_slist_free);
 
+  g_array_set_size (self->viewports, 0);
+
   IDE_EXIT;
 }
 
@@ -823,12 +1145,21 @@ ide_highlight_engine_destroy (IdeObject *object)
 {
   IdeHighlightEngine *self = (IdeHighlightEngine *)object;
 
+  if (self->memory_monitor != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (self->memory_monitor,
+                                            G_CALLBACK (ide_highlight_engine_low_memory_warning_cb),
+                                            self);
+      g_clear_object (&self->memory_monitor);
+    }
+
   g_weak_ref_set (&self->buffer_wref, NULL);
   g_clear_object (&self->signal_group);
   g_clear_object (&self->extension);
   g_clear_object (&self->highlighter);
   g_clear_object (&self->settings);
   g_clear_pointer (&self->region, _cjh_text_region_free);
+  g_clear_pointer (&self->viewports, g_array_unref);
 
   IDE_OBJECT_CLASS (ide_highlight_engine_parent_class)->destroy (object);
 }
@@ -925,6 +1256,14 @@ ide_highlight_engine_init (IdeHighlightEngine *self)
   self->signal_group = ide_signal_group_new (IDE_TYPE_BUFFER);
 
   self->region = _cjh_text_region_new (NULL, NULL);
+  self->viewports = g_array_new (FALSE, FALSE, sizeof (Viewport));
+
+  self->memory_monitor = g_memory_monitor_dup_default ();
+  g_signal_connect_object (self->memory_monitor,
+                           "low-memory-warning",
+                           G_CALLBACK (ide_highlight_engine_low_memory_warning_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
 
   ide_signal_group_connect_object (self->signal_group,
                                    "notify::language",
@@ -58,5 +58,13 @@ IDE_AVAILABLE_IN_ALL
 void                ide_highlight_engine_unpause         (IdeHighlightEngine *self);
 IDE_AVAILABLE_IN_ALL
 void                ide_highlight_engine_advance         (IdeHighlightEngine *self);
+IDE_AVAILABLE_IN_44
+void                ide_highlight_engine_set_visible_range   (IdeHighlightEngine *self,
+                                                              gconstpointer       owner,
+                                                              const GtkTextIter  *begin,
+                                                              const GtkTextIter  *end);
+IDE_AVAILABLE_IN_44
+void                ide_highlight_engine_clear_visible_range (IdeHighlightEngine *self,
+                                                              gconstpointer       owner);
 
 G_END_DECLS
@@ -282,6 +282,105 @@ _ide_trace_log (GLogLevelFlags  log_level,
     trace_vtable.log (log_level, domain, message);
 }
 
+/**
+ * ide_profiler_is_active:
+ *
+ * Checks if a profiler is collecting marks and counters from Builder.
+ *
+ * This may be used to avoid building messages for ide_profiler_mark()
+ * when nothing would record them.
+ *
+ * Returns: %TRUE if marks and counters are being recorded
+ *
+ * Since: 44
+ */
+gboolean
+ide_profiler_is_active (void)
+{
+  return trace_vtable.mark != NULL;
+}
+
+/**
+ * ide_profiler_mark:
+ * @begin_time_usec: the monotonic time the operation began
+ * @end_time_usec: the monotonic time the operation completed
+ * @group: the group of the mark, such as "lsp"
+ * @name: the name of the mark, such as the method called
+ * @message: (nullable): additional information for the mark
+ *
+ * Records an operation spanning from @begin_time_usec to @end_time_usec
+ * which will be displayed in the profiler. Times are in the same clock
+ * as g_get_monotonic_time().
+ *
+ * Since: 44
+ */
+void
+ide_profiler_mark (gint64      begin_time_usec,
+                   gint64      end_time_usec,
+                   const char *group,
+                   const char *name,
+                   const char *message)
+{
+  g_return_if_fail (group != NULL);
+  g_return_if_fail (name != NULL);
+
+  if (trace_vtable.mark == NULL)
+    return;
+
+  /* In case our clock is not reliable */
+  if (end_time_usec < begin_time_usec)
+    end_time_usec = begin_time_usec;
+
+  trace_vtable.mark (begin_time_usec, end_time_usec, group, name, message);
+}
+
+/**
+ * ide_profiler_define_counter:
+ * @category: the category of the counter
+ * @name: the name of the counter
+ * @description: a description of the counter
+ *
+ * Defines a new 64-bit integer counter which may be updated using
+ * ide_profiler_set_counter().
+ *
+ * Returns: the counter identifier, or 0 if no profiler is active
+ *
+ * Since: 44
+ */
+guint
+ide_profiler_define_counter (const char *category,
+                             const char *name,
+                             const char *description)
+{
+  g_return_val_if_fail (category != NULL, 0);
+  g_return_val_if_fail (name != NULL, 0);
+
+  if (trace_vtable.define_counter == NULL)
+    return 0;
+
+  return trace_vtable.define_counter (category, name, description ? description : "");
+}
+
+/**
+ * ide_profiler_set_counter:
+ * @counter_id: a counter from ide_profiler_define_counter()
+ * @value: the new value for the counter
+ *
+ * Updates the value of a counter. This function does nothing if
+ * @counter_id is zero.
+ *
+ * Since: 44
+ */
+void
+ide_profiler_set_counter (guint  counter_id,
+                          gint64 value)
+{
+  if (counter_id == 0 || trace_vtable.set_counter == NULL)
+    return;
+
+  trace_vtable.set_counter (counter_id, value);
+}
+
 static gchar **
 get_environ_from_stdout (GSubprocess *subprocess)
 {
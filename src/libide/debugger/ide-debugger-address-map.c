@@ -26,59 +26,62 @@
 
 struct _IdeDebuggerAddressMap
 {
-  GSequence    *seq;
+  /* Sorted by start address. Mappings do not overlap, so this is a simple
+   * interval array which we can binary search. There are only ever a few
+   * hundred entries (one per mapped segment) and lookups are far more
+   * common than insertions, so this is both smaller and faster than a
+   * tree while being friendlier to the CPU cache.
+   */
+  GArray       *entries;
   GStringChunk *chunk;
 };
 
-static inline gint
-uint64cmp (guint64 a,
-           guint64 b)
+/*
+ * Locates the index of the first entry with a start address greater
+ * than @address. The entry containing @address, if any, is the one
+ * immediately before it.
+ */
+static guint
+ide_debugger_address_map_upper_bound (const IdeDebuggerAddressMap *self,
+                                      IdeDebuggerAddress           address)
 {
-  if (a < b)
-    return -1;
-  else if (a > b)
-    return 1;
-  else
-    return 0;
-}
+  guint lo = 0;
+  guint hi = self->entries->len;
 
-static gint
-ide_debugger_address_map_entry_compare (gconstpointer a,
-                                        gconstpointer b,
-                                        gpointer      user_data)
-{
-  const IdeDebuggerAddressMapEntry *entry_a = a;
-  const IdeDebuggerAddressMapEntry *entry_b = b;
+  while (lo < hi)
+    {
+      guint mid = lo + ((hi - lo) / 2);
+      const IdeDebuggerAddressMapEntry *entry = &g_array_index (self->entries, IdeDebuggerAddressMapEntry, mid);
 
-  return uint64cmp (entry_a->start, entry_b->start);
+      if (entry->start <= address)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
 }
 
-static gint
-ide_debugger_address_map_entry_compare_in_range (gconstpointer a,
-                                                 gconstpointer b,
-                                                 gpointer      user_data)
+static gboolean
+ide_debugger_address_map_find (const IdeDebuggerAddressMap *self,
+                               IdeDebuggerAddress           address,
+                               guint                       *index)
 {
-  const IdeDebuggerAddressMapEntry *entry_a = a;
-  const IdeDebuggerAddressMapEntry *entry_b = b;
-
-  /*
-   * entry_b is the needle for the search.
-   * Only entry_b->start is set.
-   */
+  const IdeDebuggerAddressMapEntry *entry;
+  guint pos;
 
-  if ((entry_b->start >= entry_a->start) && (entry_b->start < entry_a->end))
-    return 0;
+  if (!(pos = ide_debugger_address_map_upper_bound (self, address)))
+    return FALSE;
 
-  return uint64cmp (entry_a->start, entry_b->start);
-}
+  entry = &g_array_index (self->entries, IdeDebuggerAddressMapEntry, pos - 1);
 
-static void
-ide_debugger_address_map_entry_free (gpointer data)
-{
-  IdeDebuggerAddressMapEntry *entry = data;
+  if (address >= entry->start && address < entry->end)
+    {
+      *index = pos - 1;
+      return TRUE;
+    }
 
-  if (entry != NULL)
-    g_slice_free (IdeDebuggerAddressMapEntry, entry);
+  return FALSE;
 }
 
 /**
@@ -100,7 +103,7 @@ ide_debugger_address_map_new (void)
   IdeDebuggerAddressMap *ret;
 
   ret = g_slice_new0 (IdeDebuggerAddressMap);
-  ret->seq = g_sequence_new (ide_debugger_address_map_entry_free);
+  ret->entries = g_array_new (FALSE, FALSE, sizeof (IdeDebuggerAddressMapEntry));
   ret->chunk = g_string_chunk_new (4096);
 
   return ret;
@@ -117,7 +120,7 @@ ide_debugger_address_map_free (IdeDebuggerAddressMap *self)
 {
   if (self != NULL)
     {
-      g_sequence_free (self->seq);
+      g_array_unref (self->entries);
       g_string_chunk_free (self->chunk);
       g_slice_free (IdeDebuggerAddressMap, self);
     }
@@ -149,10 +152,9 @@ ide_debugger_address_map_insert (IdeDebuggerAddressMap            *self,
   real.end = entry->end;
   real.offset = entry->offset;
 
-  g_sequence_insert_sorted (self->seq,
-                            g_slice_dup (IdeDebuggerAddressMapEntry, &real),
-                            ide_debugger_address_map_entry_compare,
-                            NULL);
+  g_array_insert_val (self->entries,
+                      ide_debugger_address_map_upper_bound (self, real.start),
+                      real);
 }
 
 /**
@@ -164,26 +166,23 @@ ide_debugger_address_map_insert (IdeDebuggerAddressMap            *self,
  * the region specified by #IdeDebuggerAddressMapEntry.start and
  * #IdeDebuggerAddressMapEntry.end.
  *
+ * The result is only valid until the next call to
+ * ide_debugger_address_map_insert() or ide_debugger_address_map_remove().
+ *
  * Returns: (nullable): An #IdeDebuggerAddressMapEntry or %NULL
  */
 const IdeDebuggerAddressMapEntry *
 ide_debugger_address_map_lookup (const IdeDebuggerAddressMap *self,
                                  guint64                      address)
 {
-  IdeDebuggerAddressMapEntry entry = { NULL, 0, address, 0 };
-  GSequenceIter *iter;
+  guint index;
 
   g_return_val_if_fail (self != NULL, NULL);
 
-  iter = g_sequence_lookup (self->seq,
-                            &entry,
-                            ide_debugger_address_map_entry_compare_in_range,
-                            NULL);
-
-  if (iter == NULL || g_sequence_iter_is_end (iter))
+  if (!ide_debugger_address_map_find (self, address, &index))
     return NULL;
 
-  return g_sequence_get (iter);
+  return &g_array_index (self->entries, IdeDebuggerAddressMapEntry, index);
 }
 
 /**
@@ -197,20 +196,14 @@ gboolean
 ide_debugger_address_map_remove (IdeDebuggerAddressMap *self,
                                  IdeDebuggerAddress     address)
 {
-  IdeDebuggerAddressMapEntry entry = { NULL, 0, address, 0 };
-  GSequenceIter *iter;
+  guint index;
 
   g_return_val_if_fail (self != NULL, FALSE);
 
-  iter = g_sequence_lookup (self->seq,
-                            &entry,
-                            ide_debugger_address_map_entry_compare_in_range,
-                            NULL);
-
-  if (iter == NULL || g_sequence_iter_is_end (iter))
+  if (!ide_debugger_address_map_find (self, address, &index))
     return FALSE;
 
-  g_sequence_remove (iter);
+  g_array_remove_index (self->entries, index);
 
   return TRUE;
 }
@@ -54,6 +54,89 @@ _ide_debugger_real_list_frames_finish (IdeDebugger   *self,
   return g_task_propagate_pointer (G_TASK (result), error);
 }
 
+typedef struct
+{
+  guint first;
+  guint n_frames;
+} ListFramesRange;
+
+static void
+_ide_debugger_real_list_frames_range_cb (GObject      *object,
+                                         GAsyncResult *result,
+                                         gpointer      user_data)
+{
+  IdeDebugger *self = (IdeDebugger *)object;
+  g_autoptr(GPtrArray) frames = NULL;
+  g_autoptr(GPtrArray) ret = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GTask) task = user_data;
+  ListFramesRange *range;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (G_IS_TASK (task));
+
+  if (!(frames = ide_debugger_list_frames_finish (self, result, &error)))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  range = g_task_get_task_data (task);
+  ret = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint i = range->first; i < frames->len && ret->len < range->n_frames; i++)
+    g_ptr_array_add (ret, g_object_ref (g_ptr_array_index (frames, i)));
+
+  g_task_return_pointer (task, g_steal_pointer (&ret), (GDestroyNotify)g_ptr_array_unref);
+}
+
+void
+_ide_debugger_real_list_frames_range_async (IdeDebugger         *self,
+                                            IdeDebuggerThread   *thread,
+                                            guint                first,
+                                            guint                n_frames,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  ListFramesRange *range;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (IDE_IS_DEBUGGER_THREAD (thread));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  /* Backends that cannot page through frames still list the whole stack,
+   * so just slice out the requested range from that.
+   */
+
+  range = g_new0 (ListFramesRange, 1);
+  range->first = first;
+  range->n_frames = n_frames;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, _ide_debugger_real_list_frames_range_async);
+  g_task_set_task_data (task, range, g_free);
+
+  ide_debugger_list_frames_async (self,
+                                  thread,
+                                  cancellable,
+                                  _ide_debugger_real_list_frames_range_cb,
+                                  g_steal_pointer (&task));
+}
+
+GPtrArray *
+_ide_debugger_real_list_frames_range_finish (IdeDebugger   *self,
+                                             GAsyncResult  *result,
+                                             GError       **error)
+{
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_TASK (result));
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 void
 _ide_debugger_real_interrupt_async (IdeDebugger            *self,
                                     IdeDebuggerThreadGroup *thread_group,
@@ -204,6 +287,35 @@ _ide_debugger_real_list_params_finish (IdeDebugger   *self,
   return g_task_propagate_pointer (G_TASK (result), error);
 }
 
+void
+_ide_debugger_real_list_children_async (IdeDebugger         *self,
+                                        IdeDebuggerVariable *variable,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data)
+{
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (IDE_IS_DEBUGGER_VARIABLE (variable));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  g_task_report_new_error (self, callback, user_data,
+                           _ide_debugger_real_list_children_async,
+                           G_IO_ERROR,
+                           G_IO_ERROR_NOT_SUPPORTED,
+                           "Listing variable children is not supported");
+}
+
+GPtrArray *
+_ide_debugger_real_list_children_finish (IdeDebugger   *self,
+                                         GAsyncResult  *result,
+                                         GError       **error)
+{
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_TASK (result));
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 void
 _ide_debugger_real_list_registers_async (IdeDebugger         *self,
                                          GCancellable        *cancellable,
@@ -288,3 +400,62 @@ _ide_debugger_real_interpret_finish (IdeDebugger   *self,
 
   return g_task_propagate_boolean (G_TASK (result), error);
 }
+
+void
+_ide_debugger_real_read_memory_async (IdeDebugger         *self,
+                                      IdeDebuggerAddress   address,
+                                      gsize                length,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  g_task_report_new_error (self, callback, user_data,
+                           _ide_debugger_real_read_memory_async,
+                           G_IO_ERROR,
+                           G_IO_ERROR_NOT_SUPPORTED,
+                           "Reading memory is not supported");
+}
+
+GBytes *
+_ide_debugger_real_read_memory_finish (IdeDebugger   *self,
+                                       GAsyncResult  *result,
+                                       GError       **error)
+{
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_TASK (result));
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+void
+_ide_debugger_real_write_memory_async (IdeDebugger         *self,
+                                       IdeDebuggerAddress   address,
+                                       GBytes              *contents,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (contents != NULL);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  g_task_report_new_error (self, callback, user_data,
+                           _ide_debugger_real_write_memory_async,
+                           G_IO_ERROR,
+                           G_IO_ERROR_NOT_SUPPORTED,
+                           "Writing memory is not supported");
+}
+
+gboolean
+_ide_debugger_real_write_memory_finish (IdeDebugger   *self,
+                                        GAsyncResult  *result,
+                                        GError       **error)
+{
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_TASK (result));
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
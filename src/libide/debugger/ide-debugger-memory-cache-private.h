@@ -0,0 +1,56 @@
+/* ide-debugger-memory-cache-private.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "ide-debugger-types.h"
+
+G_BEGIN_DECLS
+
+/* Memory is cached in page sized, page aligned blocks. This matches what
+ * the inferior can actually map and keeps a single unreadable page from
+ * failing reads of its readable neighbors.
+ */
+#define IDE_DEBUGGER_MEMORY_BLOCK_SIZE 4096
+
+typedef struct _IdeDebuggerMemoryCache IdeDebuggerMemoryCache;
+
+IdeDebuggerMemoryCache *ide_debugger_memory_cache_new              (guint                   max_blocks);
+void                    ide_debugger_memory_cache_free             (IdeDebuggerMemoryCache *self);
+guint                   ide_debugger_memory_cache_get_generation   (IdeDebuggerMemoryCache *self);
+GBytes                 *ide_debugger_memory_cache_lookup           (IdeDebuggerMemoryCache *self,
+                                                                    IdeDebuggerAddress      block);
+void                    ide_debugger_memory_cache_insert           (IdeDebuggerMemoryCache *self,
+                                                                    IdeDebuggerAddress      block,
+                                                                    GBytes                 *bytes);
+void                    ide_debugger_memory_cache_invalidate       (IdeDebuggerMemoryCache *self);
+void                    ide_debugger_memory_cache_invalidate_range (IdeDebuggerMemoryCache *self,
+                                                                    IdeDebuggerAddress      address,
+                                                                    gsize                   length);
+
+static inline IdeDebuggerAddress
+ide_debugger_memory_block_align (IdeDebuggerAddress address)
+{
+  return address & ~(IdeDebuggerAddress)(IDE_DEBUGGER_MEMORY_BLOCK_SIZE - 1);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (IdeDebuggerMemoryCache, ide_debugger_memory_cache_free)
+
+G_END_DECLS
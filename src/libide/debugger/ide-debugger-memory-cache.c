@@ -0,0 +1,257 @@
+/* ide-debugger-memory-cache.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "ide-debugger-memory-cache"
+
+#include "config.h"
+
+#include "ide-debugger-memory-cache-private.h"
+
+typedef struct
+{
+  /* Link within the LRU queue, most recently used at the head */
+  GList              link;
+  IdeDebuggerAddress address;
+  GBytes            *bytes;
+} Block;
+
+struct _IdeDebuggerMemoryCache
+{
+  /* IdeDebuggerAddress* (within Block) -> Block */
+  GHashTable *blocks;
+  GQueue      lru;
+  guint       max_blocks;
+
+  /* Incremented whenever the contents are invalidated so that reads which
+   * were in flight at the time do not repopulate the cache with stale data.
+   */
+  guint       generation;
+};
+
+static void
+block_free (gpointer data)
+{
+  Block *block = data;
+
+  g_clear_pointer (&block->bytes, g_bytes_unref);
+  g_slice_free (Block, block);
+}
+
+static void
+ide_debugger_memory_cache_remove (IdeDebuggerMemoryCache *self,
+                                  Block                  *block)
+{
+  g_queue_unlink (&self->lru, &block->link);
+  g_hash_table_remove (self->blocks, &block->address);
+}
+
+/**
+ * ide_debugger_memory_cache_new:
+ * @max_blocks: the maximum number of blocks to retain
+ *
+ * Creates a new cache of inferior memory, split into blocks of
+ * %IDE_DEBUGGER_MEMORY_BLOCK_SIZE bytes. The least recently used blocks
+ * are discarded once more than @max_blocks are cached.
+ *
+ * Returns: (transfer full): a new #IdeDebuggerMemoryCache
+ */
+IdeDebuggerMemoryCache *
+ide_debugger_memory_cache_new (guint max_blocks)
+{
+  IdeDebuggerMemoryCache *self;
+
+  g_return_val_if_fail (max_blocks > 0, NULL);
+
+  self = g_slice_new0 (IdeDebuggerMemoryCache);
+  self->blocks = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, block_free);
+  self->max_blocks = max_blocks;
+  g_queue_init (&self->lru);
+
+  return self;
+}
+
+void
+ide_debugger_memory_cache_free (IdeDebuggerMemoryCache *self)
+{
+  if (self != NULL)
+    {
+      /* Blocks are owned by the hash table, the queue only links them */
+      g_queue_init (&self->lru);
+      g_clear_pointer (&self->blocks, g_hash_table_unref);
+      g_slice_free (IdeDebuggerMemoryCache, self);
+    }
+}
+
+guint
+ide_debugger_memory_cache_get_generation (IdeDebuggerMemoryCache *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->generation;
+}
+
+/**
+ * ide_debugger_memory_cache_lookup:
+ * @self: a #IdeDebuggerMemoryCache
+ * @block: a block aligned address
+ *
+ * Looks up the cached contents of the block starting at @block.
+ *
+ * The contents may be shorter than %IDE_DEBUGGER_MEMORY_BLOCK_SIZE if
+ * the tail of the block could not be read from the inferior.
+ *
+ * Returns: (transfer full) (nullable): a #GBytes or %NULL
+ */
+GBytes *
+ide_debugger_memory_cache_lookup (IdeDebuggerMemoryCache *self,
+                                  IdeDebuggerAddress      block)
+{
+  Block *b;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (block == ide_debugger_memory_block_align (block), NULL);
+
+  if (!(b = g_hash_table_lookup (self->blocks, &block)))
+    return NULL;
+
+  g_queue_unlink (&self->lru, &b->link);
+  g_queue_push_head_link (&self->lru, &b->link);
+
+  return g_bytes_ref (b->bytes);
+}
+
+void
+ide_debugger_memory_cache_insert (IdeDebuggerMemoryCache *self,
+                                  IdeDebuggerAddress      block,
+                                  GBytes                 *bytes)
+{
+  Block *b;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (block == ide_debugger_memory_block_align (block));
+  g_return_if_fail (bytes != NULL);
+  g_return_if_fail (g_bytes_get_size (bytes) <= IDE_DEBUGGER_MEMORY_BLOCK_SIZE);
+
+  if ((b = g_hash_table_lookup (self->blocks, &block)))
+    {
+      g_bytes_ref (bytes);
+      g_clear_pointer (&b->bytes, g_bytes_unref);
+      b->bytes = bytes;
+
+      g_queue_unlink (&self->lru, &b->link);
+      g_queue_push_head_link (&self->lru, &b->link);
+
+      return;
+    }
+
+  b = g_slice_new0 (Block);
+  b->link.data = b;
+  b->address = block;
+  b->bytes = g_bytes_ref (bytes);
+
+  g_hash_table_insert (self->blocks, &b->address, b);
+  g_queue_push_head_link (&self->lru, &b->link);
+
+  while (self->lru.length > self->max_blocks)
+    ide_debugger_memory_cache_remove (self, self->lru.tail->data);
+}
+
+/**
+ * ide_debugger_memory_cache_invalidate:
+ * @self: a #IdeDebuggerMemoryCache
+ *
+ * Discards all cached memory, such as when the inferior has resumed
+ * execution and may have modified any of it.
+ */
+void
+ide_debugger_memory_cache_invalidate (IdeDebuggerMemoryCache *self)
+{
+  g_return_if_fail (self != NULL);
+
+  self->generation++;
+
+  g_queue_init (&self->lru);
+  g_hash_table_remove_all (self->blocks);
+}
+
+/**
+ * ide_debugger_memory_cache_invalidate_range:
+ * @self: a #IdeDebuggerMemoryCache
+ * @address: the start of the modified region
+ * @length: the length of the modified region in bytes
+ *
+ * Discards the blocks overlapping the region, such as after the memory
+ * has been written to.
+ */
+void
+ide_debugger_memory_cache_invalidate_range (IdeDebuggerMemoryCache *self,
+                                            IdeDebuggerAddress      address,
+                                            gsize                   length)
+{
+  IdeDebuggerAddress block;
+  IdeDebuggerAddress last;
+
+  g_return_if_fail (self != NULL);
+
+  if (length == 0)
+    return;
+
+  self->generation++;
+
+  block = ide_debugger_memory_block_align (address);
+
+  if (address + length - 1 < address)
+    last = ide_debugger_memory_block_align (G_MAXUINT64);
+  else
+    last = ide_debugger_memory_block_align (address + length - 1);
+
+  /* Walk whichever is smaller, the range or the cached blocks */
+  if ((last - block) / IDE_DEBUGGER_MEMORY_BLOCK_SIZE >= g_hash_table_size (self->blocks))
+    {
+      GHashTableIter iter;
+      Block *b;
+
+      g_hash_table_iter_init (&iter, self->blocks);
+
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&b))
+        {
+          if (b->address >= block && b->address <= last)
+            {
+              g_queue_unlink (&self->lru, &b->link);
+              g_hash_table_iter_remove (&iter);
+            }
+        }
+
+      return;
+    }
+
+  for (;;)
+    {
+      Block *b;
+
+      if ((b = g_hash_table_lookup (self->blocks, &block)))
+        ide_debugger_memory_cache_remove (self, b);
+
+      if (block == last)
+        break;
+
+      block += IDE_DEBUGGER_MEMORY_BLOCK_SIZE;
+    }
+}
@@ -46,6 +46,42 @@ void                    _ide_debugger_real_list_frames_async        (IdeDebugger
 GPtrArray              *_ide_debugger_real_list_frames_finish       (IdeDebugger                    *self,
                                                                      GAsyncResult                   *result,
                                                                      GError                        **error);
+void                    _ide_debugger_real_list_frames_range_async  (IdeDebugger                    *self,
+                                                                     IdeDebuggerThread              *thread,
+                                                                     guint                           first,
+                                                                     guint                           n_frames,
+                                                                     GCancellable                   *cancellable,
+                                                                     GAsyncReadyCallback             callback,
+                                                                     gpointer                        user_data);
+GPtrArray              *_ide_debugger_real_list_frames_range_finish (IdeDebugger                    *self,
+                                                                     GAsyncResult                   *result,
+                                                                     GError                        **error);
+void                    _ide_debugger_real_list_children_async      (IdeDebugger                    *self,
+                                                                     IdeDebuggerVariable            *variable,
+                                                                     GCancellable                   *cancellable,
+                                                                     GAsyncReadyCallback             callback,
+                                                                     gpointer                        user_data);
+GPtrArray              *_ide_debugger_real_list_children_finish     (IdeDebugger                    *self,
+                                                                     GAsyncResult                   *result,
+                                                                     GError                        **error);
+void                    _ide_debugger_real_read_memory_async        (IdeDebugger                    *self,
+                                                                     IdeDebuggerAddress              address,
+                                                                     gsize                           length,
+                                                                     GCancellable                   *cancellable,
+                                                                     GAsyncReadyCallback             callback,
+                                                                     gpointer                        user_data);
+GBytes                 *_ide_debugger_real_read_memory_finish       (IdeDebugger                    *self,
+                                                                     GAsyncResult                   *result,
+                                                                     GError                        **error);
+void                    _ide_debugger_real_write_memory_async       (IdeDebugger                    *self,
+                                                                     IdeDebuggerAddress              address,
+                                                                     GBytes                         *contents,
+                                                                     GCancellable                   *cancellable,
+                                                                     GAsyncReadyCallback             callback,
+                                                                     gpointer                        user_data);
+gboolean                _ide_debugger_real_write_memory_finish      (IdeDebugger                    *self,
+                                                                     GAsyncResult                   *result,
+                                                                     GError                        **error);
 void                    _ide_debugger_real_interpret_async          (IdeDebugger                    *self,
                                                                      const gchar                    *command,
                                                                      GCancellable                   *cancellable,
@@ -22,10 +22,18 @@
 
 #include "config.h"
 
+#include <libide-threading.h>
+
 #include "ide-debugger.h"
 #include "ide-debugger-address-map-private.h"
+#include "ide-debugger-memory-cache-private.h"
 #include "ide-debugger-private.h"
 
+/* 256 blocks of 4 KiB, enough to scroll back and forth through a
+ * megabyte of memory without talking to the backend again.
+ */
+#define MAX_MEMORY_BLOCKS 256
+
 /**
  * SECTION:ide-debugger
  * @title: IdeDebugger
@@ -48,6 +56,19 @@ typedef struct
   GListStore            *thread_groups;
   IdeDebuggerThread     *selected;
   IdeDebuggerAddressMap *map;
+
+  /* Cached inferior memory, invalidated whenever the inferior runs */
+  IdeDebuggerMemoryCache *memory;
+
+  /* Block aligned IdeDebuggerAddress* -> ReadBlock for reads in flight */
+  GHashTable            *memory_reads;
+
+  /* IdeDebuggerAddressRange -> GPtrArray of IdeDebuggerInstruction. Code
+   * does not change until a library is loaded or unloaded.
+   */
+  GHashTable            *disassembly;
+  guint                  disassembly_generation;
+
   guint                  has_started : 1;
   guint                  is_running : 1;
 } IdeDebuggerPrivate;
@@ -321,6 +342,9 @@ ide_debugger_finalize (GObject *object)
   IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
 
   g_clear_pointer (&priv->map, ide_debugger_address_map_free);
+  g_clear_pointer (&priv->memory, ide_debugger_memory_cache_free);
+  g_clear_pointer (&priv->memory_reads, g_hash_table_unref);
+  g_clear_pointer (&priv->disassembly, g_hash_table_unref);
   g_clear_pointer (&priv->display_name, g_free);
   g_clear_object (&priv->breakpoints);
   g_clear_object (&priv->threads);
@@ -471,6 +495,10 @@ ide_debugger_class_init (IdeDebuggerClass *klass)
   klass->library_unloaded = ide_debugger_real_library_unloaded;
   klass->list_frames_async = _ide_debugger_real_list_frames_async;
   klass->list_frames_finish = _ide_debugger_real_list_frames_finish;
+  klass->list_frames_range_async = _ide_debugger_real_list_frames_range_async;
+  klass->list_frames_range_finish = _ide_debugger_real_list_frames_range_finish;
+  klass->list_children_async = _ide_debugger_real_list_children_async;
+  klass->list_children_finish = _ide_debugger_real_list_children_finish;
   klass->list_locals_async = _ide_debugger_real_list_locals_async;
   klass->list_locals_finish = _ide_debugger_real_list_locals_finish;
   klass->list_params_async = _ide_debugger_real_list_params_async;
@@ -479,6 +507,8 @@ ide_debugger_class_init (IdeDebuggerClass *klass)
   klass->list_registers_finish = _ide_debugger_real_list_registers_finish;
   klass->modify_breakpoint_async = _ide_debugger_real_modify_breakpoint_async;
   klass->modify_breakpoint_finish = _ide_debugger_real_modify_breakpoint_finish;
+  klass->read_memory_async = _ide_debugger_real_read_memory_async;
+  klass->read_memory_finish = _ide_debugger_real_read_memory_finish;
   klass->running = ide_debugger_real_running;
   klass->send_signal_async = _ide_debugger_real_send_signal_async;
   klass->send_signal_finish = _ide_debugger_real_send_signal_finish;
@@ -490,6 +520,8 @@ ide_debugger_class_init (IdeDebuggerClass *klass)
   klass->thread_selected = ide_debugger_real_thread_selected;
   klass->interpret_async = _ide_debugger_real_interpret_async;
   klass->interpret_finish = _ide_debugger_real_interpret_finish;
+  klass->write_memory_async = _ide_debugger_real_write_memory_async;
+  klass->write_memory_finish = _ide_debugger_real_write_memory_finish;
 
   /**
    * IdeDebugger:display-name:
@@ -770,6 +802,24 @@ ide_debugger_class_init (IdeDebuggerClass *klass)
                   G_TYPE_NONE, 1, IDE_TYPE_DEBUGGER_LIBRARY);
 }
 
+static guint
+address_range_hash (gconstpointer data)
+{
+  const IdeDebuggerAddressRange *range = data;
+
+  return g_int64_hash (&range->from) ^ g_int64_hash (&range->to);
+}
+
+static gboolean
+address_range_equal (gconstpointer a,
+                     gconstpointer b)
+{
+  const IdeDebuggerAddressRange *range_a = a;
+  const IdeDebuggerAddressRange *range_b = b;
+
+  return range_a->from == range_b->from && range_a->to == range_b->to;
+}
+
 static void
 ide_debugger_init (IdeDebugger *self)
 {
@@ -777,6 +827,12 @@ ide_debugger_init (IdeDebugger *self)
 
   priv->breakpoints = g_list_store_new (IDE_TYPE_DEBUGGER_BREAKPOINT);
   priv->map = ide_debugger_address_map_new ();
+  priv->memory = ide_debugger_memory_cache_new (MAX_MEMORY_BLOCKS);
+  priv->memory_reads = g_hash_table_new (g_int64_hash, g_int64_equal);
+  priv->disassembly = g_hash_table_new_full (address_range_hash,
+                                             address_range_equal,
+                                             (GDestroyNotify)ide_debugger_address_range_free,
+                                             (GDestroyNotify)g_ptr_array_unref);
   priv->thread_groups = g_list_store_new (IDE_TYPE_DEBUGGER_THREAD_GROUP);
   priv->threads = g_list_store_new (IDE_TYPE_DEBUGGER_THREAD);
 }
@@ -891,6 +947,31 @@ ide_debugger_move_finish (IdeDebugger   *self,
   return IDE_DEBUGGER_GET_CLASS (self)->move_finish (self, result, error);
 }
 
+static void
+ide_debugger_invalidate_memory (IdeDebugger *self)
+{
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+
+  g_assert (IDE_IS_DEBUGGER (self));
+
+  /* Reads in flight still complete their waiters, but they will no
+   * longer be shared with new requests nor populate the cache.
+   */
+  ide_debugger_memory_cache_invalidate (priv->memory);
+  g_hash_table_remove_all (priv->memory_reads);
+}
+
+static void
+ide_debugger_invalidate_disassembly (IdeDebugger *self)
+{
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+
+  g_assert (IDE_IS_DEBUGGER (self));
+
+  priv->disassembly_generation++;
+  g_hash_table_remove_all (priv->disassembly);
+}
+
 /**
  * ide_debugger_emit_log:
  * @self: a #IdeDebugger
@@ -1120,6 +1201,8 @@ ide_debugger_emit_running (IdeDebugger *self)
 {
   g_return_if_fail (IDE_IS_DEBUGGER (self));
 
+  ide_debugger_invalidate_memory (self);
+
   g_signal_emit (self, signals [RUNNING], 0);
 }
 
@@ -1143,6 +1226,8 @@ ide_debugger_emit_stopped (IdeDebugger           *self,
   g_return_if_fail (IDE_IS_DEBUGGER_STOP_REASON (stop_reason));
   g_return_if_fail (IDE_IS_DEBUGGER_BREAKPOINT (breakpoint));
 
+  ide_debugger_invalidate_memory (self);
+
   g_signal_emit (self, signals [STOPPED], 0, stop_reason, breakpoint);
 }
 
@@ -1163,6 +1248,8 @@ ide_debugger_emit_library_loaded (IdeDebugger        *self,
   g_return_if_fail (IDE_IS_DEBUGGER (self));
   g_return_if_fail (IDE_IS_DEBUGGER_LIBRARY (library));
 
+  ide_debugger_invalidate_disassembly (self);
+
   g_signal_emit (self, signals [LIBRARY_LOADED], 0, library);
 }
 
@@ -1183,6 +1270,8 @@ ide_debugger_emit_library_unloaded (IdeDebugger        *self,
   g_return_if_fail (IDE_IS_DEBUGGER (self));
   g_return_if_fail (IDE_IS_DEBUGGER_LIBRARY (library));
 
+  ide_debugger_invalidate_disassembly (self);
+
   g_signal_emit (self, signals [LIBRARY_UNLOADED], 0, library);
 }
 
@@ -1507,6 +1596,73 @@ ide_debugger_list_frames_finish (IdeDebugger   *self,
   return IDE_DEBUGGER_GET_CLASS (self)->list_frames_finish (self, result, error);
 }
 
+/**
+ * ide_debugger_list_frames_range_async:
+ * @self: an #IdeDebugger
+ * @thread: an #IdeDebuggerThread
+ * @first: the depth of the first frame to list
+ * @n_frames: the maximum number of frames to list
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: A callback to call once the operation has finished
+ * @user_data: user data for @callback
+ *
+ * Like ide_debugger_list_frames_async() but only lists up to @n_frames
+ * frames starting from the frame at depth @first. This allows the UI to
+ * page through very deep stacks (such as with deep recursion) without
+ * requiring the backend to unwind the whole stack up front.
+ *
+ * Since: 44
+ */
+void
+ide_debugger_list_frames_range_async (IdeDebugger         *self,
+                                      IdeDebuggerThread   *thread,
+                                      guint                first,
+                                      guint                n_frames,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  g_return_if_fail (IDE_IS_DEBUGGER (self));
+  g_return_if_fail (IDE_IS_DEBUGGER_THREAD (thread));
+  g_return_if_fail (n_frames > 0);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  IDE_DEBUGGER_GET_CLASS (self)->list_frames_range_async (self,
+                                                          thread,
+                                                          first,
+                                                          n_frames,
+                                                          cancellable,
+                                                          callback,
+                                                          user_data);
+}
+
+/**
+ * ide_debugger_list_frames_range_finish:
+ * @self: a #IdeDebugger
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError or %NULL
+ *
+ * Completes an asynchronous request to ide_debugger_list_frames_range_async().
+ *
+ * If fewer frames than requested are returned, the end of the stack has
+ * been reached.
+ *
+ * Returns: (transfer full) (element-type Ide.DebuggerFrame) (nullable): An
+ *   array of debugger frames or %NULL and @error is set.
+ *
+ * Since: 44
+ */
+GPtrArray *
+ide_debugger_list_frames_range_finish (IdeDebugger   *self,
+                                       GAsyncResult  *result,
+                                       GError       **error)
+{
+  g_return_val_if_fail (IDE_IS_DEBUGGER (self), NULL);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+
+  return IDE_DEBUGGER_GET_CLASS (self)->list_frames_range_finish (self, result, error);
+}
+
 /**
  * ide_debugger_get_selected_thread:
  * @self: An #IdeDebugger
@@ -1751,6 +1907,65 @@ ide_debugger_list_params_finish (IdeDebugger   *self,
   return IDE_DEBUGGER_GET_CLASS (self)->list_params_finish (self, result, error);
 }
 
+/**
+ * ide_debugger_list_children_async:
+ * @self: an #IdeDebugger
+ * @variable: an #IdeDebuggerVariable
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: A callback to call once the operation has finished
+ * @user_data: user data for @callback
+ *
+ * Requests the debugger backend to list the children of @variable, such
+ * as the fields of a structure or the elements of an array.
+ *
+ * @variable must have been created by @self, such as from
+ * ide_debugger_list_locals_async() or a previous call to this function,
+ * and should have #IdeDebuggerVariable:has-children set.
+ *
+ * Since: 44
+ */
+void
+ide_debugger_list_children_async (IdeDebugger         *self,
+                                  IdeDebuggerVariable *variable,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  g_return_if_fail (IDE_IS_DEBUGGER (self));
+  g_return_if_fail (IDE_IS_DEBUGGER_VARIABLE (variable));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  IDE_DEBUGGER_GET_CLASS (self)->list_children_async (self,
+                                                      variable,
+                                                      cancellable,
+                                                      callback,
+                                                      user_data);
+}
+
+/**
+ * ide_debugger_list_children_finish:
+ * @self: a #IdeDebugger
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError or %NULL
+ *
+ * Completes an asynchronous request to ide_debugger_list_children_async().
+ *
+ * Returns: (transfer full) (element-type Ide.DebuggerVariable): a #GPtrArray of
+ *   #IdeDebuggerVariable if successful; otherwise %NULL and error is set.
+ *
+ * Since: 44
+ */
+GPtrArray *
+ide_debugger_list_children_finish (IdeDebugger   *self,
+                                   GAsyncResult  *result,
+                                   GError       **error)
+{
+  g_return_val_if_fail (IDE_IS_DEBUGGER (self), NULL);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+
+  return IDE_DEBUGGER_GET_CLASS (self)->list_children_finish (self, result, error);
+}
+
 /**
  * ide_debugger_list_registers_async:
  * @self: an #IdeDebugger
@@ -1794,6 +2009,60 @@ ide_debugger_list_registers_finish (IdeDebugger   *self,
   return IDE_DEBUGGER_GET_CLASS (self)->list_registers_finish (self, result, error);
 }
 
+static GPtrArray *
+copy_instructions (GPtrArray *instructions)
+{
+  GPtrArray *ret = g_ptr_array_new_full (instructions->len, g_object_unref);
+
+  for (guint i = 0; i < instructions->len; i++)
+    g_ptr_array_add (ret, g_object_ref (g_ptr_array_index (instructions, i)));
+
+  return ret;
+}
+
+typedef struct
+{
+  IdeDebuggerAddressRange range;
+  guint                   generation;
+} Disassemble;
+
+static void
+ide_debugger_disassemble_cb (GObject      *object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
+{
+  IdeDebugger *self = (IdeDebugger *)object;
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+  g_autoptr(GPtrArray) instructions = NULL;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  Disassemble *state;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  instructions = IDE_DEBUGGER_GET_CLASS (self)->disassemble_finish (self, result, &error);
+  IDE_PTR_ARRAY_SET_FREE_FUNC (instructions, g_object_unref);
+
+  if (instructions == NULL)
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  state = ide_task_get_task_data (task);
+
+  if (state->generation == priv->disassembly_generation)
+    g_hash_table_insert (priv->disassembly,
+                         ide_debugger_address_range_copy (&state->range),
+                         copy_instructions (instructions));
+
+  ide_task_return_pointer (task,
+                           g_steal_pointer (&instructions),
+                           g_ptr_array_unref);
+}
+
 /**
  * ide_debugger_disassemble_async:
  * @self: an #IdeDebugger
@@ -1803,6 +2072,9 @@ ide_debugger_list_registers_finish (IdeDebugger   *self,
  * @user_data: user data for @callback
  *
  * Disassembles the address range requested.
+ *
+ * Results are cached until the next library is loaded or unloaded, so
+ * requesting the same range again does not require the backend.
  */
 void
 ide_debugger_disassemble_async (IdeDebugger                   *self,
@@ -1811,11 +2083,34 @@ ide_debugger_disassemble_async (IdeDebugger                   *self,
                                 GAsyncReadyCallback            callback,
                                 gpointer                       user_data)
 {
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+  g_autoptr(IdeTask) task = NULL;
+  GPtrArray *cached;
+  Disassemble *state;
+
   g_return_if_fail (IDE_IS_DEBUGGER (self));
   g_return_if_fail (range != NULL);
   g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-  IDE_DEBUGGER_GET_CLASS (self)->disassemble_async (self, range, cancellable, callback, user_data);
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, ide_debugger_disassemble_async);
+
+  if ((cached = g_hash_table_lookup (priv->disassembly, range)))
+    {
+      ide_task_return_pointer (task, copy_instructions (cached), g_ptr_array_unref);
+      return;
+    }
+
+  state = g_new0 (Disassemble, 1);
+  state->range = *range;
+  state->generation = priv->disassembly_generation;
+  ide_task_set_task_data (task, state, g_free);
+
+  IDE_DEBUGGER_GET_CLASS (self)->disassemble_async (self,
+                                                    range,
+                                                    cancellable,
+                                                    ide_debugger_disassemble_cb,
+                                                    g_steal_pointer (&task));
 }
 
 /**
@@ -1834,10 +2129,452 @@ ide_debugger_disassemble_finish (IdeDebugger   *self,
                                  GAsyncResult  *result,
                                  GError       **error)
 {
+  GPtrArray *ret;
+
   g_return_val_if_fail (IDE_IS_DEBUGGER (self), NULL);
-  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+  g_return_val_if_fail (IDE_IS_TASK (result), NULL);
+
+  ret = ide_task_propagate_pointer (IDE_TASK (result), error);
+
+  return IDE_PTR_ARRAY_STEAL_FULL (&ret);
+}
+
+typedef struct
+{
+  IdeDebuggerAddress   address;
+  gsize                length;
+  IdeDebuggerAddress   first_block;
+  guint                n_blocks;
+  guint                n_active;
+  GBytes             **blocks;
+} ReadMemory;
+
+typedef struct
+{
+  IdeDebugger        *self;
+  IdeDebuggerAddress  address;
+  guint               generation;
+  /* IdeTask waiting on this block, if any (prefetches have none) */
+  GPtrArray          *waiters;
+} ReadBlock;
+
+static void
+read_memory_free (gpointer data)
+{
+  ReadMemory *state = data;
+
+  for (guint i = 0; i < state->n_blocks; i++)
+    g_clear_pointer (&state->blocks[i], g_bytes_unref);
+  g_clear_pointer (&state->blocks, g_free);
+  g_slice_free (ReadMemory, state);
+}
+
+static void
+read_block_free (ReadBlock *state)
+{
+  g_clear_object (&state->self);
+  g_clear_pointer (&state->waiters, g_ptr_array_unref);
+  g_slice_free (ReadBlock, state);
+}
+
+static void
+ide_debugger_read_memory_complete (IdeTask *task)
+{
+  g_autoptr(GByteArray) buffer = NULL;
+  IdeDebuggerAddress address;
+  ReadMemory *state;
+  gsize remaining;
+
+  g_assert (IDE_IS_TASK (task));
+
+  state = ide_task_get_task_data (task);
+
+  g_assert (state != NULL);
+  g_assert (state->n_active == 0);
+
+  buffer = g_byte_array_sized_new (state->length);
+  address = state->address;
+  remaining = state->length;
+
+  /* Copy out everything that is readable up to the first hole */
+  while (remaining > 0)
+    {
+      IdeDebuggerAddress block = ide_debugger_memory_block_align (address);
+      guint index = (block - state->first_block) / IDE_DEBUGGER_MEMORY_BLOCK_SIZE;
+      gsize offset = address - block;
+      const guint8 *data;
+      gsize avail;
+      gsize to_copy;
+
+      if (state->blocks[index] == NULL)
+        break;
+
+      data = g_bytes_get_data (state->blocks[index], &avail);
+
+      if (avail <= offset)
+        break;
+
+      to_copy = MIN (avail - offset, remaining);
+      g_byte_array_append (buffer, data + offset, to_copy);
+
+      address += to_copy;
+      remaining -= to_copy;
+
+      if (avail < IDE_DEBUGGER_MEMORY_BLOCK_SIZE)
+        break;
+    }
+
+  if (buffer->len == 0)
+    ide_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_FAILED,
+                               "Cannot access memory at address 0x%"G_GINT64_MODIFIER"x",
+                               state->address);
+  else
+    ide_task_return_pointer (task,
+                             g_byte_array_free_to_bytes (g_steal_pointer (&buffer)),
+                             g_bytes_unref);
+}
+
+static void
+ide_debugger_read_block_cb (GObject      *object,
+                            GAsyncResult *result,
+                            gpointer      user_data)
+{
+  IdeDebugger *self = (IdeDebugger *)object;
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+  ReadBlock *state = user_data;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (state != NULL);
+
+  if (!(bytes = IDE_DEBUGGER_GET_CLASS (self)->read_memory_finish (self, result, &error)))
+    g_debug ("Failed to read memory at 0x%"G_GINT64_MODIFIER"x: %s",
+             state->address, error->message);
+
+  if (g_hash_table_lookup (priv->memory_reads, &state->address) == state)
+    g_hash_table_remove (priv->memory_reads, &state->address);
+
+  if (bytes != NULL &&
+      g_bytes_get_size (bytes) <= IDE_DEBUGGER_MEMORY_BLOCK_SIZE &&
+      state->generation == ide_debugger_memory_cache_get_generation (priv->memory))
+    ide_debugger_memory_cache_insert (priv->memory, state->address, bytes);
+
+  for (guint i = 0; i < state->waiters->len; i++)
+    {
+      IdeTask *task = g_ptr_array_index (state->waiters, i);
+      ReadMemory *read = ide_task_get_task_data (task);
+      guint index = (state->address - read->first_block) / IDE_DEBUGGER_MEMORY_BLOCK_SIZE;
+
+      g_assert (index < read->n_blocks);
+      g_assert (read->blocks[index] == NULL);
+
+      if (bytes != NULL)
+        read->blocks[index] = g_bytes_ref (bytes);
+
+      read->n_active--;
+
+      if (read->n_active == 0)
+        ide_debugger_read_memory_complete (task);
+    }
+
+  read_block_free (state);
+}
+
+static void
+ide_debugger_read_block (IdeDebugger        *self,
+                         IdeDebuggerAddress  block,
+                         IdeTask            *waiter)
+{
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+  ReadBlock *state;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (block == ide_debugger_memory_block_align (block));
+  g_assert (!waiter || IDE_IS_TASK (waiter));
+
+  /* Share the read with any request for the same block in flight */
+  if (!(state = g_hash_table_lookup (priv->memory_reads, &block)))
+    {
+      state = g_slice_new0 (ReadBlock);
+      state->self = g_object_ref (self);
+      state->address = block;
+      state->generation = ide_debugger_memory_cache_get_generation (priv->memory);
+      state->waiters = g_ptr_array_new_with_free_func (g_object_unref);
+
+      g_hash_table_insert (priv->memory_reads, &state->address, state);
+
+      IDE_DEBUGGER_GET_CLASS (self)->read_memory_async (self,
+                                                        block,
+                                                        IDE_DEBUGGER_MEMORY_BLOCK_SIZE,
+                                                        NULL,
+                                                        ide_debugger_read_block_cb,
+                                                        state);
+    }
+
+  if (waiter != NULL)
+    g_ptr_array_add (state->waiters, g_object_ref (waiter));
+}
+
+static void
+ide_debugger_prefetch_block (IdeDebugger        *self,
+                             IdeDebuggerAddress  block)
+{
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+  g_autoptr(GBytes) cached = NULL;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+
+  if (g_hash_table_contains (priv->memory_reads, &block) ||
+      (cached = ide_debugger_memory_cache_lookup (priv->memory, block)))
+    return;
+
+  ide_debugger_read_block (self, block, NULL);
+}
+
+/**
+ * ide_debugger_read_memory_async:
+ * @self: an #IdeDebugger
+ * @address: the address to read from
+ * @length: the number of bytes to read
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: A callback to call once the operation has finished
+ * @user_data: user data for @callback
+ *
+ * Reads @length bytes of memory from the inferior starting at @address.
+ *
+ * Memory is requested from the backend in page-sized blocks which are
+ * cached until the inferior resumes execution or the memory is written
+ * with ide_debugger_write_memory_async(). The blocks adjacent to the
+ * request are prefetched so that scrolling through memory rarely needs
+ * to wait on the backend.
+ *
+ * Since: 44
+ */
+void
+ide_debugger_read_memory_async (IdeDebugger         *self,
+                                IdeDebuggerAddress   address,
+                                gsize                length,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+  g_autoptr(IdeTask) task = NULL;
+  IdeDebuggerAddress last_block;
+  ReadMemory *state;
+
+  g_return_if_fail (IDE_IS_DEBUGGER (self));
+  g_return_if_fail (length > 0);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  /* Don't wrap around the end of the address space */
+  if (address + length - 1 < address)
+    length = G_MAXUINT64 - address + 1;
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, ide_debugger_read_memory_async);
+
+  last_block = ide_debugger_memory_block_align (address + length - 1);
+
+  state = g_slice_new0 (ReadMemory);
+  state->address = address;
+  state->length = length;
+  state->first_block = ide_debugger_memory_block_align (address);
+  state->n_blocks = ((last_block - state->first_block) / IDE_DEBUGGER_MEMORY_BLOCK_SIZE) + 1;
+  state->blocks = g_new0 (GBytes *, state->n_blocks);
+  ide_task_set_task_data (task, state, read_memory_free);
+
+  /* Count what we're missing before issuing any reads so that a backend
+   * completing immediately cannot finish the request early.
+   */
+  for (guint i = 0; i < state->n_blocks; i++)
+    {
+      IdeDebuggerAddress block = state->first_block + (i * IDE_DEBUGGER_MEMORY_BLOCK_SIZE);
+
+      if (!(state->blocks[i] = ide_debugger_memory_cache_lookup (priv->memory, block)))
+        state->n_active++;
+    }
+
+  for (guint i = 0; i < state->n_blocks; i++)
+    {
+      if (state->blocks[i] == NULL)
+        ide_debugger_read_block (self,
+                                 state->first_block + (i * IDE_DEBUGGER_MEMORY_BLOCK_SIZE),
+                                 task);
+    }
+
+  if (state->first_block >= IDE_DEBUGGER_MEMORY_BLOCK_SIZE)
+    ide_debugger_prefetch_block (self, state->first_block - IDE_DEBUGGER_MEMORY_BLOCK_SIZE);
+
+  if (last_block + IDE_DEBUGGER_MEMORY_BLOCK_SIZE > last_block)
+    ide_debugger_prefetch_block (self, last_block + IDE_DEBUGGER_MEMORY_BLOCK_SIZE);
+
+  if (state->n_active == 0)
+    ide_debugger_read_memory_complete (task);
+}
+
+/**
+ * ide_debugger_read_memory_finish:
+ * @self: a #IdeDebugger
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError or %NULL
+ *
+ * Completes an asynchronous request to ide_debugger_read_memory_async().
+ *
+ * The result may be shorter than requested if only part of the range
+ * is readable.
+ *
+ * Returns: (transfer full): a #GBytes if successful; otherwise %NULL
+ *   and @error is set.
+ *
+ * Since: 44
+ */
+GBytes *
+ide_debugger_read_memory_finish (IdeDebugger   *self,
+                                 GAsyncResult  *result,
+                                 GError       **error)
+{
+  g_return_val_if_fail (IDE_IS_DEBUGGER (self), NULL);
+  g_return_val_if_fail (IDE_IS_TASK (result), NULL);
+
+  return ide_task_propagate_pointer (IDE_TASK (result), error);
+}
+
+static void
+ide_debugger_invalidate_memory_range (IdeDebugger        *self,
+                                      IdeDebuggerAddress  address,
+                                      gsize               length)
+{
+  IdeDebuggerPrivate *priv = ide_debugger_get_instance_private (self);
+  IdeDebuggerAddress first_block;
+  IdeDebuggerAddress last_block;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+
+  if (length == 0)
+    return;
+
+  ide_debugger_memory_cache_invalidate_range (priv->memory, address, length);
+
+  /* Bumping the generation above keeps reads in flight from caching stale
+   * contents, but new readers must not attach to them either.
+   */
+  first_block = ide_debugger_memory_block_align (address);
+  last_block = ide_debugger_memory_block_align (address + length - 1);
+
+  for (IdeDebuggerAddress block = first_block; block <= last_block; block += IDE_DEBUGGER_MEMORY_BLOCK_SIZE)
+    {
+      g_hash_table_remove (priv->memory_reads, &block);
+
+      if (block == last_block)
+        break;
+    }
+}
+
+typedef struct
+{
+  IdeDebuggerAddress address;
+  gsize              length;
+} WriteMemory;
+
+static void
+ide_debugger_write_memory_cb (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  IdeDebugger *self = (IdeDebugger *)object;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  WriteMemory *state;
+
+  g_assert (IDE_IS_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  /* Drop anything that was read while the write was in flight too */
+  state = ide_task_get_task_data (task);
+  ide_debugger_invalidate_memory_range (self, state->address, state->length);
+
+  if (!IDE_DEBUGGER_GET_CLASS (self)->write_memory_finish (self, result, &error))
+    ide_task_return_error (task, g_steal_pointer (&error));
+  else
+    ide_task_return_boolean (task, TRUE);
+}
+
+/**
+ * ide_debugger_write_memory_async:
+ * @self: an #IdeDebugger
+ * @address: the address to write to
+ * @contents: the bytes to write at @address
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: A callback to call once the operation has finished
+ * @user_data: user data for @callback
+ *
+ * Writes @contents into the memory of the inferior at @address.
+ *
+ * Any memory cached by ide_debugger_read_memory_async() which overlaps
+ * the written range is discarded.
+ *
+ * Since: 44
+ */
+void
+ide_debugger_write_memory_async (IdeDebugger         *self,
+                                 IdeDebuggerAddress   address,
+                                 GBytes              *contents,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  g_autoptr(IdeTask) task = NULL;
+  WriteMemory *state;
+
+  g_return_if_fail (IDE_IS_DEBUGGER (self));
+  g_return_if_fail (contents != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, ide_debugger_write_memory_async);
+
+  state = g_new0 (WriteMemory, 1);
+  state->address = address;
+  state->length = g_bytes_get_size (contents);
+  ide_task_set_task_data (task, state, g_free);
+
+  ide_debugger_invalidate_memory_range (self, state->address, state->length);
+
+  IDE_DEBUGGER_GET_CLASS (self)->write_memory_async (self,
+                                                     address,
+                                                     contents,
+                                                     cancellable,
+                                                     ide_debugger_write_memory_cb,
+                                                     g_steal_pointer (&task));
+}
+
+/**
+ * ide_debugger_write_memory_finish:
+ * @self: a #IdeDebugger
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError or %NULL
+ *
+ * Completes an asynchronous request to ide_debugger_write_memory_async().
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ *
+ * Since: 44
+ */
+gboolean
+ide_debugger_write_memory_finish (IdeDebugger   *self,
+                                  GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (IDE_IS_DEBUGGER (self), FALSE);
+  g_return_val_if_fail (IDE_IS_TASK (result), FALSE);
 
-  return IDE_DEBUGGER_GET_CLASS (self)->disassemble_finish (self, result, error);
+  return ide_task_propagate_boolean (IDE_TASK (result), error);
 }
 
 /**
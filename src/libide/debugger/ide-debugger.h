@@ -195,6 +195,42 @@ struct _IdeDebuggerClass
   gboolean   (*interpret_finish)         (IdeDebugger                    *self,
                                           GAsyncResult                   *result,
                                           GError                        **error);
+  void       (*list_frames_range_async)  (IdeDebugger                    *self,
+                                          IdeDebuggerThread              *thread,
+                                          guint                           first,
+                                          guint                           n_frames,
+                                          GCancellable                   *cancellable,
+                                          GAsyncReadyCallback             callback,
+                                          gpointer                        user_data);
+  GPtrArray *(*list_frames_range_finish) (IdeDebugger                    *self,
+                                          GAsyncResult                   *result,
+                                          GError                        **error);
+  void       (*list_children_async)      (IdeDebugger                    *self,
+                                          IdeDebuggerVariable            *variable,
+                                          GCancellable                   *cancellable,
+                                          GAsyncReadyCallback             callback,
+                                          gpointer                        user_data);
+  GPtrArray *(*list_children_finish)     (IdeDebugger                    *self,
+                                          GAsyncResult                   *result,
+                                          GError                        **error);
+  void       (*read_memory_async)        (IdeDebugger                    *self,
+                                          IdeDebuggerAddress              address,
+                                          gsize                           length,
+                                          GCancellable                   *cancellable,
+                                          GAsyncReadyCallback             callback,
+                                          gpointer                        user_data);
+  GBytes    *(*read_memory_finish)       (IdeDebugger                    *self,
+                                          GAsyncResult                   *result,
+                                          GError                        **error);
+  void       (*write_memory_async)       (IdeDebugger                    *self,
+                                          IdeDebuggerAddress              address,
+                                          GBytes                         *contents,
+                                          GCancellable                   *cancellable,
+                                          GAsyncReadyCallback             callback,
+                                          gpointer                        user_data);
+  gboolean   (*write_memory_finish)      (IdeDebugger                    *self,
+                                          GAsyncResult                   *result,
+                                          GError                        **error);
 };
 
 IDE_AVAILABLE_IN_ALL
@@ -234,6 +270,28 @@ IDE_AVAILABLE_IN_ALL
 GPtrArray         *ide_debugger_disassemble_finish        (IdeDebugger                    *self,
                                                            GAsyncResult                   *result,
                                                            GError                        **error);
+IDE_AVAILABLE_IN_44
+void               ide_debugger_read_memory_async         (IdeDebugger                    *self,
+                                                           IdeDebuggerAddress              address,
+                                                           gsize                           length,
+                                                           GCancellable                   *cancellable,
+                                                           GAsyncReadyCallback             callback,
+                                                           gpointer                        user_data);
+IDE_AVAILABLE_IN_44
+GBytes            *ide_debugger_read_memory_finish        (IdeDebugger                    *self,
+                                                           GAsyncResult                   *result,
+                                                           GError                        **error);
+IDE_AVAILABLE_IN_44
+void               ide_debugger_write_memory_async        (IdeDebugger                    *self,
+                                                           IdeDebuggerAddress              address,
+                                                           GBytes                         *contents,
+                                                           GCancellable                   *cancellable,
+                                                           GAsyncReadyCallback             callback,
+                                                           gpointer                        user_data);
+IDE_AVAILABLE_IN_44
+gboolean           ide_debugger_write_memory_finish       (IdeDebugger                    *self,
+                                                           GAsyncResult                   *result,
+                                                           GError                        **error);
 IDE_AVAILABLE_IN_ALL
 void               ide_debugger_insert_breakpoint_async   (IdeDebugger                    *self,
                                                            IdeDebuggerBreakpoint          *breakpoint,
@@ -294,6 +352,18 @@ IDE_AVAILABLE_IN_ALL
 GPtrArray         *ide_debugger_list_frames_finish        (IdeDebugger                    *self,
                                                            GAsyncResult                   *result,
                                                            GError                        **error);
+IDE_AVAILABLE_IN_44
+void               ide_debugger_list_frames_range_async   (IdeDebugger                    *self,
+                                                           IdeDebuggerThread              *thread,
+                                                           guint                           first,
+                                                           guint                           n_frames,
+                                                           GCancellable                   *cancellable,
+                                                           GAsyncReadyCallback             callback,
+                                                           gpointer                        user_data);
+IDE_AVAILABLE_IN_44
+GPtrArray         *ide_debugger_list_frames_range_finish  (IdeDebugger                    *self,
+                                                           GAsyncResult                   *result,
+                                                           GError                        **error);
 IDE_AVAILABLE_IN_ALL
 void               ide_debugger_list_locals_async         (IdeDebugger                    *self,
                                                            IdeDebuggerThread              *thread,
@@ -316,6 +386,16 @@ IDE_AVAILABLE_IN_ALL
 GPtrArray         *ide_debugger_list_params_finish        (IdeDebugger                    *self,
                                                            GAsyncResult                   *result,
                                                            GError                        **error);
+IDE_AVAILABLE_IN_44
+void               ide_debugger_list_children_async       (IdeDebugger                    *self,
+                                                           IdeDebuggerVariable            *variable,
+                                                           GCancellable                   *cancellable,
+                                                           GAsyncReadyCallback             callback,
+                                                           gpointer                        user_data);
+IDE_AVAILABLE_IN_44
+GPtrArray         *ide_debugger_list_children_finish      (IdeDebugger                    *self,
+                                                           GAsyncResult                   *result,
+                                                           GError                        **error);
 IDE_AVAILABLE_IN_ALL
 void               ide_debugger_list_registers_async      (IdeDebugger                    *self,
                                                            GCancellable                   *cancellable,
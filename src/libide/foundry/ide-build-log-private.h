@@ -21,6 +21,7 @@
 #pragma once
 
 #include <gio/gio.h>
+#include <libide-code.h>
 
 #include "ide-build-log.h"
 
@@ -30,17 +31,36 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (IdeBuildLog, ide_build_log, IDE, BUILD_LOG, GObject)
 
-IdeBuildLog *ide_build_log_new              (void);
-void         ide_build_log_observer         (IdeBuildLogStream    stream,
-                                             const gchar         *message,
-                                             gssize               message_len,
-                                             gpointer             user_data);
-guint        ide_build_log_add_observer     (IdeBuildLog         *self,
-                                             IdeBuildLogObserver  observer,
-                                             gpointer             observer_data,
-                                             GDestroyNotify       observer_data_destroy);
-gboolean     ide_build_log_remove_observer  (IdeBuildLog         *self,
-                                             guint                observer_id);
-
+IdeBuildLog *ide_build_log_new                  (void);
+IdeBuildLog *ide_build_log_new_with_capacity    (gsize                  capacity);
+void         ide_build_log_set_directory        (IdeBuildLog           *self,
+                                                 const char            *directory);
+void         ide_build_log_observer             (IdeBuildLogStream      stream,
+                                                 const gchar           *message,
+                                                 gssize                 message_len,
+                                                 gpointer               user_data);
+guint        ide_build_log_add_observer         (IdeBuildLog           *self,
+                                                 IdeBuildLogObserver    observer,
+                                                 gpointer               observer_data,
+                                                 GDestroyNotify         observer_data_destroy);
+gboolean     ide_build_log_remove_observer      (IdeBuildLog           *self,
+                                                 guint                  observer_id);
+guint64      ide_build_log_append               (IdeBuildLog           *self,
+                                                 const guint8          *data,
+                                                 gsize                  len);
+char        *ide_build_log_dup_line             (IdeBuildLog           *self,
+                                                 guint64                line);
+GArray      *ide_build_log_search               (IdeBuildLog           *self,
+                                                 const char            *text,
+                                                 guint                  max_matches);
+void         ide_build_log_add_diagnostic       (IdeBuildLog           *self,
+                                                 guint64                line,
+                                                 IdeDiagnosticSeverity  severity);
+guint        ide_build_log_get_n_diagnostics    (IdeBuildLog           *self,
+                                                 IdeDiagnosticSeverity  severity);
+gboolean     ide_build_log_get_diagnostic_line  (IdeBuildLog           *self,
+                                                 IdeDiagnosticSeverity  severity,
+                                                 guint                  nth,
+                                                 guint64               *line);
 
 G_END_DECLS
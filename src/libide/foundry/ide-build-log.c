@@ -22,8 +22,13 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
 #include <libide-core.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "ide-build-log.h"
 #include "ide-build-log-private.h"
@@ -32,6 +37,8 @@
 #define POINTER_UNMARK(p) GSIZE_TO_POINTER(GPOINTER_TO_SIZE(p)&~(gsize)1)
 #define POINTER_MARKED(p) (GPOINTER_TO_SIZE(p)&1)
 #define DISPATCH_MAX      20
+#define DEFAULT_CAPACITY  (128 * 1024 * 1024)
+#define N_SEVERITIES      (IDE_DIAGNOSTIC_FATAL + 1)
 
 struct _IdeBuildLog
 {
@@ -42,6 +49,31 @@ struct _IdeBuildLog
   GSource     *log_source;
 
   guint        sequence;
+
+  /* The raw output of the build is kept in a ring buffer backed by an
+   * unlinked temporary file so that it may be searched without keeping
+   * it in widget memory. Offsets below are the number of bytes written
+   * since the log was created, the ring only contains the last
+   * @capacity bytes of those. Everything below is protected by @mutex
+   * as output may arrive from any thread.
+   */
+  GMutex       mutex;
+  char        *directory;
+  guint8      *ring;
+  gsize        capacity;
+  guint64      head;
+
+  /* Offset of the start of each line still in the ring, starting from
+   * @lines_begin (which is line number @first_line). Lines are evicted
+   * by moving @lines_begin forward so that appending stays cheap once
+   * the ring has wrapped.
+   */
+  GArray      *lines;
+  guint        lines_begin;
+  guint64      first_line;
+
+  /* Line numbers which produced a diagnostic, per severity */
+  GArray      *diagnostics[N_SEVERITIES];
 };
 
 typedef struct
@@ -116,6 +148,16 @@ ide_build_log_finalize (GObject *object)
   g_clear_pointer (&self->log_source, g_source_destroy);
   g_clear_pointer (&self->observers, g_array_unref);
 
+  if (self->ring != NULL)
+    munmap (self->ring, self->capacity);
+  self->ring = NULL;
+
+  g_clear_pointer (&self->directory, g_free);
+  g_clear_pointer (&self->lines, g_array_unref);
+  for (guint i = 0; i < N_SEVERITIES; i++)
+    g_clear_pointer (&self->diagnostics[i], g_array_unref);
+  g_mutex_clear (&self->mutex);
+
   G_OBJECT_CLASS (ide_build_log_parent_class)->finalize (object);
 }
 
@@ -132,6 +174,15 @@ ide_build_log_init (IdeBuildLog *self)
 {
   self->observers = g_array_new (FALSE, FALSE, sizeof (Observer));
 
+  g_mutex_init (&self->mutex);
+  self->capacity = DEFAULT_CAPACITY;
+  self->lines = g_array_new (FALSE, FALSE, sizeof (guint64));
+  for (guint i = 0; i < N_SEVERITIES; i++)
+    self->diagnostics[i] = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  /* The first line begins at the first byte */
+  g_array_append_val (self->lines, self->head);
+
   self->log_queue = g_async_queue_new ();
 
   self->log_source = g_timeout_source_new (G_MAXINT);
@@ -245,3 +296,501 @@ ide_build_log_new (void)
 {
   return g_object_new (IDE_TYPE_BUILD_LOG, NULL);
 }
+
+IdeBuildLog *
+ide_build_log_new_with_capacity (gsize capacity)
+{
+  IdeBuildLog *self;
+
+  g_return_val_if_fail (capacity > 0, NULL);
+
+  self = ide_build_log_new ();
+  self->capacity = capacity;
+
+  return self;
+}
+
+/**
+ * ide_build_log_set_directory:
+ * @self: a #IdeBuildLog
+ * @directory: (nullable): the directory for the log storage
+ *
+ * Sets the directory in which the storage for the log is created, such
+ * as the cache directory of the project. The system temporary directory
+ * is used if it is %NULL or the storage cannot be created there.
+ *
+ * This only has an effect before anything is appended to the log.
+ */
+void
+ide_build_log_set_directory (IdeBuildLog *self,
+                             const char  *directory)
+{
+  g_return_if_fail (IDE_IS_BUILD_LOG (self));
+
+  g_mutex_lock (&self->mutex);
+  g_free (self->directory);
+  self->directory = g_strdup (directory);
+  g_mutex_unlock (&self->mutex);
+}
+
+static gboolean
+ide_build_log_ensure_ring_locked (IdeBuildLog *self)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree char *path = NULL;
+  gpointer map;
+  int fd = -1;
+
+  if G_LIKELY (self->ring != NULL)
+    return TRUE;
+
+  /* Only the mapping keeps the file alive, so it goes away with us
+   * even if we crash. Pages are only allocated once written. Prefer a
+   * directory on disk as /tmp is usually memory backed.
+   */
+  if (self->directory != NULL)
+    {
+      path = g_build_filename (self->directory, "build-log-XXXXXX", NULL);
+
+      if (g_mkdir_with_parents (self->directory, 0750) != 0 ||
+          -1 == (fd = g_mkstemp_full (path, O_RDWR | O_CLOEXEC, 0600)))
+        {
+          g_debug ("Failed to create build log storage in %s: %s",
+                   self->directory, g_strerror (errno));
+          g_clear_pointer (&path, g_free);
+        }
+    }
+
+  if (path == NULL &&
+      -1 == (fd = g_file_open_tmp ("gnome-builder-build-log-XXXXXX", &path, &error)))
+    {
+      g_warning ("Failed to create build log storage: %s", error->message);
+      return FALSE;
+    }
+
+  g_unlink (path);
+
+  if (ftruncate (fd, self->capacity) != 0 ||
+      MAP_FAILED == (map = mmap (NULL, self->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)))
+    {
+      g_warning ("Failed to map build log storage: %s", g_strerror (errno));
+      close (fd);
+      return FALSE;
+    }
+
+  close (fd);
+
+  self->ring = map;
+
+  return TRUE;
+}
+
+static inline guint64
+ide_build_log_get_tail_locked (IdeBuildLog *self)
+{
+  return self->head > self->capacity ? self->head - self->capacity : 0;
+}
+
+static inline guint
+ide_build_log_get_n_lines_locked (IdeBuildLog *self)
+{
+  return self->lines->len - self->lines_begin;
+}
+
+static inline guint64
+ide_build_log_get_line_offset_locked (IdeBuildLog *self,
+                                      guint64      line)
+{
+  g_assert (line >= self->first_line);
+  g_assert (line - self->first_line < ide_build_log_get_n_lines_locked (self));
+
+  return g_array_index (self->lines, guint64, self->lines_begin + (line - self->first_line));
+}
+
+static void
+ide_build_log_evict_locked (IdeBuildLog *self)
+{
+  guint64 tail = ide_build_log_get_tail_locked (self);
+
+  /* Always keep the line currently being written, even if it has been
+   * partially overwritten. Readers clamp to the tail of the ring.
+   */
+  while (ide_build_log_get_n_lines_locked (self) > 1 &&
+         g_array_index (self->lines, guint64, self->lines_begin) < tail)
+    {
+      self->lines_begin++;
+      self->first_line++;
+    }
+
+  if (self->lines_begin > 4096 && self->lines_begin > self->lines->len / 2)
+    {
+      g_array_remove_range (self->lines, 0, self->lines_begin);
+      self->lines_begin = 0;
+    }
+
+  for (guint i = 0; i < N_SEVERITIES; i++)
+    {
+      GArray *ar = self->diagnostics[i];
+      guint n = 0;
+
+      while (n < ar->len && g_array_index (ar, guint64, n) < self->first_line)
+        n++;
+
+      if (n > 0)
+        g_array_remove_range (ar, 0, n);
+    }
+}
+
+/**
+ * ide_build_log_append:
+ * @self: a #IdeBuildLog
+ * @data: the raw output
+ * @len: the length of @data in bytes
+ *
+ * Appends @data to the storage for the log. This does not notify
+ * observers, use ide_build_log_observer() for that.
+ *
+ * This function is safe to call from any thread.
+ *
+ * Returns: the line number which the first byte of @data is part of
+ */
+guint64
+ide_build_log_append (IdeBuildLog  *self,
+                      const guint8 *data,
+                      gsize         len)
+{
+  const guint8 *end = data + len;
+  guint64 first_line;
+
+  g_return_val_if_fail (IDE_IS_BUILD_LOG (self), 0);
+  g_return_val_if_fail (data != NULL || len == 0, 0);
+
+  g_mutex_lock (&self->mutex);
+
+  first_line = self->first_line + ide_build_log_get_n_lines_locked (self) - 1;
+
+  if (len == 0 || !ide_build_log_ensure_ring_locked (self))
+    goto unlock;
+
+  /* Only the last @capacity bytes can ever be read back */
+  if (len > self->capacity)
+    {
+      const guint8 *skip_to = end - self->capacity;
+
+      for (const guint8 *iter = data;
+           (iter = memchr (iter, '\n', skip_to - iter));
+           iter++)
+        {
+          guint64 offset = self->head + (iter - data) + 1;
+          g_array_append_val (self->lines, offset);
+        }
+
+      self->head += skip_to - data;
+      data = skip_to;
+      len = end - data;
+    }
+
+  for (const guint8 *iter = data;
+       (iter = memchr (iter, '\n', end - iter));
+       iter++)
+    {
+      guint64 offset = self->head + (iter - data) + 1;
+      g_array_append_val (self->lines, offset);
+    }
+
+  while (len > 0)
+    {
+      gsize pos = self->head % self->capacity;
+      gsize to_copy = MIN (len, self->capacity - pos);
+
+      memcpy (self->ring + pos, data, to_copy);
+
+      self->head += to_copy;
+      data += to_copy;
+      len -= to_copy;
+    }
+
+  ide_build_log_evict_locked (self);
+
+unlock:
+  g_mutex_unlock (&self->mutex);
+
+  return first_line;
+}
+
+static void
+ide_build_log_copy_locked (IdeBuildLog *self,
+                           guint64      begin,
+                           guint64      end,
+                           GByteArray  *out)
+{
+  g_assert (begin <= end);
+  g_assert (end <= self->head);
+  g_assert (begin >= ide_build_log_get_tail_locked (self));
+
+  while (begin < end)
+    {
+      gsize pos = begin % self->capacity;
+      gsize to_copy = MIN (end - begin, self->capacity - pos);
+
+      g_byte_array_append (out, self->ring + pos, to_copy);
+      begin += to_copy;
+    }
+}
+
+/**
+ * ide_build_log_dup_line:
+ * @self: a #IdeBuildLog
+ * @line: the line number, starting from zero
+ *
+ * Copies the contents of @line without the trailing newline.
+ *
+ * Returns: (transfer full) (nullable): the line, or %NULL if @line has
+ *   not been written yet or has been evicted from the log
+ */
+char *
+ide_build_log_dup_line (IdeBuildLog *self,
+                        guint64      line)
+{
+  g_autoptr(GByteArray) bytes = NULL;
+  guint64 begin;
+  guint64 end;
+
+  g_return_val_if_fail (IDE_IS_BUILD_LOG (self), NULL);
+
+  g_mutex_lock (&self->mutex);
+
+  if (self->ring == NULL ||
+      line < self->first_line ||
+      line - self->first_line >= ide_build_log_get_n_lines_locked (self))
+    {
+      g_mutex_unlock (&self->mutex);
+      return NULL;
+    }
+
+  begin = MAX (ide_build_log_get_line_offset_locked (self, line),
+               ide_build_log_get_tail_locked (self));
+
+  if (line - self->first_line + 1 < ide_build_log_get_n_lines_locked (self))
+    end = ide_build_log_get_line_offset_locked (self, line + 1);
+  else
+    end = self->head;
+
+  bytes = g_byte_array_sized_new (end - begin + 1);
+  ide_build_log_copy_locked (self, begin, end, bytes);
+
+  g_mutex_unlock (&self->mutex);
+
+  while (bytes->len > 0 &&
+         (bytes->data[bytes->len - 1] == '\n' || bytes->data[bytes->len - 1] == '\r'))
+    g_byte_array_set_size (bytes, bytes->len - 1);
+
+  g_byte_array_append (bytes, (const guint8 *)"", 1);
+
+  return (char *)g_byte_array_free (g_steal_pointer (&bytes), FALSE);
+}
+
+static guint64
+ide_build_log_find_line_locked (IdeBuildLog *self,
+                                guint64      offset)
+{
+  guint lo = self->lines_begin;
+  guint hi = self->lines->len;
+
+  /* Find the last line starting at or before @offset */
+  while (hi - lo > 1)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (g_array_index (self->lines, guint64, mid) <= offset)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  return self->first_line + (lo - self->lines_begin);
+}
+
+static void
+add_match_locked (IdeBuildLog *self,
+                  GArray      *matches,
+                  guint64      offset)
+{
+  guint64 line = ide_build_log_find_line_locked (self, offset);
+
+  /* Matches are found in order, so only the last can be the same line */
+  if (matches->len == 0 || g_array_index (matches, guint64, matches->len - 1) != line)
+    g_array_append_val (matches, line);
+}
+
+/**
+ * ide_build_log_search:
+ * @self: a #IdeBuildLog
+ * @text: the text to search for
+ * @max_matches: the maximum number of lines to locate, or 0 for no limit
+ *
+ * Locates the lines of the log containing @text.
+ *
+ * Returns: (transfer full) (element-type guint64): an array of line
+ *   numbers, in the order they were written
+ */
+GArray *
+ide_build_log_search (IdeBuildLog *self,
+                      const char  *text,
+                      guint        max_matches)
+{
+  GArray *matches;
+  gsize text_len;
+  guint64 tail;
+
+  g_return_val_if_fail (IDE_IS_BUILD_LOG (self), NULL);
+  g_return_val_if_fail (text != NULL, NULL);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  if (!(text_len = strlen (text)))
+    return matches;
+
+  if (max_matches == 0)
+    max_matches = G_MAXUINT;
+
+  g_mutex_lock (&self->mutex);
+
+  tail = ide_build_log_get_tail_locked (self);
+
+  if (self->ring == NULL || self->head - tail < text_len)
+    goto unlock;
+
+  /* Search the (at most two) contiguous regions of the ring directly,
+   * only copying out the bytes around the wrap-around point.
+   */
+  for (guint64 begin = tail; begin < self->head && matches->len < max_matches;)
+    {
+      gsize pos = begin % self->capacity;
+      gsize region_len = MIN (self->head - begin, self->capacity - pos);
+      const guint8 *region = self->ring + pos;
+      const guint8 *iter = region;
+      const guint8 *found;
+
+      while (matches->len < max_matches &&
+             (found = memmem (iter, region_len - (iter - region), text, text_len)))
+        {
+          add_match_locked (self, matches, begin + (found - region));
+          iter = found + 1;
+        }
+
+      begin += region_len;
+
+      if (begin < self->head && text_len > 1 && matches->len < max_matches)
+        {
+          g_autoptr(GByteArray) seam = g_byte_array_new ();
+          guint64 seam_begin = MAX (tail, begin - (text_len - 1));
+          guint64 seam_end = MIN (self->head, begin + (text_len - 1));
+
+          ide_build_log_copy_locked (self, seam_begin, seam_end, seam);
+
+          iter = seam->data;
+          while (matches->len < max_matches &&
+                 (found = memmem (iter, seam->len - (iter - seam->data), text, text_len)))
+            {
+              add_match_locked (self, matches, seam_begin + (found - seam->data));
+              iter = found + 1;
+            }
+        }
+    }
+
+unlock:
+  g_mutex_unlock (&self->mutex);
+
+  return matches;
+}
+
+/**
+ * ide_build_log_add_diagnostic:
+ * @self: a #IdeBuildLog
+ * @line: the line which produced the diagnostic
+ * @severity: the severity of the diagnostic
+ *
+ * Records that @line produced a diagnostic of @severity so that it can
+ * be located with ide_build_log_get_diagnostic_line().
+ */
+void
+ide_build_log_add_diagnostic (IdeBuildLog           *self,
+                              guint64                line,
+                              IdeDiagnosticSeverity  severity)
+{
+  GArray *ar;
+
+  g_return_if_fail (IDE_IS_BUILD_LOG (self));
+  g_return_if_fail (severity < N_SEVERITIES);
+
+  g_mutex_lock (&self->mutex);
+
+  ar = self->diagnostics[severity];
+
+  /* Multiple diagnostics for the same line only need one entry */
+  if (line >= self->first_line &&
+      (ar->len == 0 || g_array_index (ar, guint64, ar->len - 1) < line))
+    g_array_append_val (ar, line);
+
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * ide_build_log_get_n_diagnostics:
+ * @self: a #IdeBuildLog
+ * @severity: the severity of diagnostics
+ *
+ * Returns: the number of lines which produced a diagnostic of @severity
+ *   and are still available in the log
+ */
+guint
+ide_build_log_get_n_diagnostics (IdeBuildLog           *self,
+                                 IdeDiagnosticSeverity  severity)
+{
+  guint ret;
+
+  g_return_val_if_fail (IDE_IS_BUILD_LOG (self), 0);
+  g_return_val_if_fail (severity < N_SEVERITIES, 0);
+
+  g_mutex_lock (&self->mutex);
+  ret = self->diagnostics[severity]->len;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+/**
+ * ide_build_log_get_diagnostic_line:
+ * @self: a #IdeBuildLog
+ * @severity: the severity of diagnostics
+ * @nth: the index of the diagnostic
+ * @line: (out): a location for the line number
+ *
+ * Locates the @nth line still in the log which produced a diagnostic
+ * of @severity.
+ *
+ * Returns: %TRUE if @line was set
+ */
+gboolean
+ide_build_log_get_diagnostic_line (IdeBuildLog           *self,
+                                   IdeDiagnosticSeverity  severity,
+                                   guint                  nth,
+                                   guint64               *line)
+{
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail (IDE_IS_BUILD_LOG (self), FALSE);
+  g_return_val_if_fail (severity < N_SEVERITIES, FALSE);
+  g_return_val_if_fail (line != NULL, FALSE);
+
+  g_mutex_lock (&self->mutex);
+  if (nth < self->diagnostics[severity]->len)
+    {
+      *line = g_array_index (self->diagnostics[severity], guint64, nth);
+      ret = TRUE;
+    }
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
@@ -93,6 +93,17 @@ struct _IdeBuildManager
    */
   char             *default_build_target;
 
+  /* The file last focused in the editor. If focused builds are enabled
+   * then only the targets containing this file are built when building,
+   * and the rest of the project follows in the background.
+   */
+  GFile            *focus_file;
+
+  /* Cancelled when another build is requested so that the remainder of
+   * a focused build never delays the next one.
+   */
+  GCancellable     *background_cancellable;
+
   GTimer           *running_time;
 
   guint             diagnostic_count;
@@ -113,8 +124,11 @@ typedef struct
 {
   IdePipeline      *pipeline;
   GPtrArray        *targets;
+  GPtrArray        *background_targets;
   char             *default_target;
+  GFile            *focus_file;
   IdePipelinePhase  phase;
+  guint             focused : 1;
 } BuildState;
 
 static void initable_iface_init                           (GInitableIface  *iface);
@@ -182,6 +196,8 @@ build_state_free (BuildState *state)
 {
   g_clear_pointer (&state->default_target, g_free);
   g_clear_pointer (&state->targets, g_ptr_array_unref);
+  g_clear_pointer (&state->background_targets, g_ptr_array_unref);
+  g_clear_object (&state->focus_file);
   g_clear_object (&state->pipeline);
   g_slice_free (BuildState, state);
 }
@@ -877,6 +893,8 @@ ide_build_manager_finalize (GObject *object)
   ide_clear_and_destroy_object (&self->pipeline);
   g_clear_object (&self->pipeline_signals);
   g_clear_object (&self->cancellable);
+  g_clear_object (&self->background_cancellable);
+  g_clear_object (&self->focus_file);
   g_clear_pointer (&self->last_build_time, g_date_time_unref);
   g_clear_pointer (&self->running_time, g_timer_destroy);
   g_clear_pointer (&self->branch_name, g_free);
@@ -1416,6 +1434,93 @@ ide_build_manager_ref_pipeline (IdeBuildManager *self)
   return g_steal_pointer (&ret);
 }
 
+/**
+ * ide_build_manager_get_focus_file:
+ * @self: a #IdeBuildManager
+ *
+ * Gets the file set with ide_build_manager_set_focus_file().
+ *
+ * Returns: (transfer none) (nullable): a #GFile or %NULL
+ *
+ * Since: 44
+ */
+GFile *
+ide_build_manager_get_focus_file (IdeBuildManager *self)
+{
+  g_return_val_if_fail (IDE_IS_BUILD_MANAGER (self), NULL);
+
+  return self->focus_file;
+}
+
+/**
+ * ide_build_manager_set_focus_file:
+ * @self: a #IdeBuildManager
+ * @focus_file: (nullable): a #GFile or %NULL
+ *
+ * Sets the file the user is currently working on.
+ *
+ * If focused builds are enabled, building will first build only the
+ * targets containing @focus_file and then continue building the rest
+ * of the project in the background.
+ *
+ * Since: 44
+ */
+void
+ide_build_manager_set_focus_file (IdeBuildManager *self,
+                                  GFile           *focus_file)
+{
+  g_return_if_fail (IDE_IS_BUILD_MANAGER (self));
+  g_return_if_fail (!focus_file || G_IS_FILE (focus_file));
+
+  g_set_object (&self->focus_file, focus_file);
+}
+
+static void
+ide_build_manager_build_background_cb (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      user_data)
+{
+  IdePipeline *pipeline = (IdePipeline *)object;
+  g_autoptr(GError) error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_PIPELINE (pipeline));
+  g_assert (G_IS_ASYNC_RESULT (result));
+
+  if (!ide_pipeline_build_targets_finish (pipeline, result, &error) &&
+      !ide_error_ignore (error))
+    g_debug ("Background build failed: %s", error->message);
+
+  IDE_EXIT;
+}
+
+static void
+ide_build_manager_build_background (IdeBuildManager *self,
+                                    BuildState      *state)
+{
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_BUILD_MANAGER (self));
+  g_assert (state != NULL);
+  g_assert (IDE_IS_PIPELINE (state->pipeline));
+
+  g_cancellable_cancel (self->background_cancellable);
+  g_clear_object (&self->background_cancellable);
+
+  self->background_cancellable = g_cancellable_new ();
+  ide_cancellable_chain (self->background_cancellable, self->cancellable);
+
+  ide_pipeline_build_targets_async (state->pipeline,
+                                    state->phase,
+                                    state->background_targets,
+                                    self->background_cancellable,
+                                    ide_build_manager_build_background_cb,
+                                    NULL);
+
+  IDE_EXIT;
+}
+
 static void
 ide_build_manager_build_targets_cb (GObject      *object,
                                     GAsyncResult *result,
@@ -1424,6 +1529,7 @@ ide_build_manager_build_targets_cb (GObject      *object,
   IdePipeline *pipeline = (IdePipeline *)object;
   g_autoptr(IdeTask) task = user_data;
   g_autoptr(GError) error = NULL;
+  BuildState *state;
 
   IDE_ENTRY;
 
@@ -1431,6 +1537,8 @@ ide_build_manager_build_targets_cb (GObject      *object,
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
 
+  state = ide_task_get_task_data (task);
+
   if (!ide_pipeline_build_targets_finish (pipeline, result, &error))
     {
       ide_object_warning (pipeline, "%s", error->message);
@@ -1438,12 +1546,58 @@ ide_build_manager_build_targets_cb (GObject      *object,
       IDE_GOTO (failure);
     }
 
+  /* Only the targets containing the focused file were built, so let the
+   * rest of the project catch up now that the caller can continue.
+   */
+  if (state->focused)
+    ide_build_manager_build_background (ide_task_get_source_object (task), state);
+
   ide_task_return_boolean (task, TRUE);
 
 failure:
   IDE_EXIT;
 }
 
+static void
+add_dependent_targets (GPtrArray  *focused,
+                       GListModel *targets)
+{
+  guint n_items;
+  gboolean changed;
+
+  g_assert (focused != NULL);
+  g_assert (G_IS_LIST_MODEL (targets));
+
+  n_items = g_list_model_get_n_items (targets);
+
+  /* Targets only know their direct dependencies, so keep walking until
+   * no more dependents are found.
+   */
+  do
+    {
+      changed = FALSE;
+
+      for (guint i = 0; i < n_items; i++)
+        {
+          g_autoptr(IdeBuildTarget) target = g_list_model_get_item (targets, i);
+
+          if (g_ptr_array_find (focused, target, NULL))
+            continue;
+
+          for (guint j = 0; j < focused->len; j++)
+            {
+              if (ide_build_target_depends_on (target, g_ptr_array_index (focused, j)))
+                {
+                  g_ptr_array_add (focused, g_steal_pointer (&target));
+                  changed = TRUE;
+                  break;
+                }
+            }
+        }
+    }
+  while (changed);
+}
+
 static void
 ide_build_manager_build_list_targets_cb (GObject      *object,
                                          GAsyncResult *result,
@@ -1465,25 +1619,52 @@ ide_build_manager_build_list_targets_cb (GObject      *object,
 
   g_assert (state != NULL);
   g_assert (state->targets == NULL);
-  g_assert (state->default_target != NULL);
+  g_assert (state->default_target != NULL || state->focus_file != NULL);
   g_assert (IDE_IS_PIPELINE (state->pipeline));
 
   if ((targets = ide_build_manager_list_targets_finish (self, result, &error)))
     {
+      g_autoptr(GPtrArray) focused = g_ptr_array_new_with_free_func (g_object_unref);
+      g_autoptr(GPtrArray) preferred = NULL;
       guint n_items = g_list_model_get_n_items (targets);
 
       for (guint i = 0; i < n_items; i++)
         {
           g_autoptr(IdeBuildTarget) target = g_list_model_get_item (targets, i);
-          const char *name = ide_build_target_get_name (target);
+          g_autofree char *name = ide_build_target_get_name (target);
+
+          if (state->focus_file != NULL &&
+              ide_build_target_contains_file (target, state->focus_file))
+            g_ptr_array_add (focused, g_object_ref (target));
 
-          if (g_strcmp0 (name, state->default_target) == 0)
+          if (preferred == NULL &&
+              state->default_target != NULL &&
+              g_strcmp0 (name, state->default_target) == 0)
             {
-              state->targets = g_ptr_array_new_with_free_func (g_object_unref);
-              g_ptr_array_add (state->targets, g_steal_pointer (&target));
-              break;
+              preferred = g_ptr_array_new_with_free_func (g_object_unref);
+              g_ptr_array_add (preferred, g_steal_pointer (&target));
             }
         }
+
+      /* Anything linking against the focused targets must be rebuilt too,
+       * otherwise running afterwards would use a stale binary.
+       */
+      if (focused->len > 0)
+        add_dependent_targets (focused, targets);
+
+      /* Build the targets containing the focused file first, and then
+       * whatever would have been built otherwise in the background.
+       */
+      if (focused->len > 0)
+        {
+          state->focused = TRUE;
+          state->targets = g_steal_pointer (&focused);
+          state->background_targets = g_steal_pointer (&preferred);
+        }
+      else
+        {
+          state->targets = g_steal_pointer (&preferred);
+        }
     }
 
   if (error != NULL && !ide_error_ignore (error))
@@ -1523,7 +1704,7 @@ ide_build_manager_build_after_save (IdeTask *task)
    * anyway as part of the install process.
    */
   if (state->targets == NULL &&
-      state->default_target != NULL &&
+      (state->default_target != NULL || state->focus_file != NULL) &&
       state->phase < IDE_PIPELINE_PHASE_INSTALL)
     ide_build_manager_list_targets_async (self,
                                           ide_task_get_cancellable (task),
@@ -1636,6 +1817,20 @@ ide_build_manager_build_async (IdeBuildManager     *self,
   state->pipeline = g_object_ref (self->pipeline);
   ide_task_set_task_data (task, state, build_state_free);
 
+  if (self->focus_file != NULL)
+    {
+      g_autoptr(GSettings) settings = g_settings_new ("org.gnome.builder.build");
+
+      if (g_settings_get_boolean (settings, "build-focused-targets"))
+        state->focus_file = g_object_ref (self->focus_file);
+    }
+
+  /* Any remainder of a previous focused build would otherwise run
+   * before this request in the pipeline.
+   */
+  g_cancellable_cancel (self->background_cancellable);
+  g_clear_object (&self->background_cancellable);
+
   /*
    * Only update our "build time" if we are advancing to IDE_PIPELINE_PHASE_BUILD,
    * we don't really care about "builds" for configure stages and less.
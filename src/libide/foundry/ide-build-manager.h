@@ -61,6 +61,11 @@ IDE_AVAILABLE_IN_ALL
 IdePipeline      *ide_build_manager_get_pipeline        (IdeBuildManager      *self);
 IDE_AVAILABLE_IN_ALL
 IdePipeline      *ide_build_manager_ref_pipeline        (IdeBuildManager      *self);
+IDE_AVAILABLE_IN_44
+GFile            *ide_build_manager_get_focus_file      (IdeBuildManager      *self);
+IDE_AVAILABLE_IN_44
+void              ide_build_manager_set_focus_file      (IdeBuildManager      *self,
+                                                         GFile                *focus_file);
 IDE_AVAILABLE_IN_ALL
 void              ide_build_manager_rebuild_async       (IdeBuildManager      *self,
                                                          IdePipelinePhase      phase,
@@ -163,6 +163,63 @@ ide_build_target_compare (const IdeBuildTarget *left,
          ide_build_target_get_priority ((IdeBuildTarget *)right);
 }
 
+/**
+ * ide_build_target_contains_file:
+ * @self: a #IdeBuildTarget
+ * @file: a #GFile
+ *
+ * Checks if @file is one of the sources used to produce @self.
+ *
+ * This is used to locate the targets which need to be rebuilt after
+ * changing @file without building the whole project.
+ *
+ * Returns: %TRUE if @file is a source of @self, %FALSE if it is not
+ *   or the build target cannot tell.
+ *
+ * Since: 44
+ */
+gboolean
+ide_build_target_contains_file (IdeBuildTarget *self,
+                                GFile          *file)
+{
+  g_return_val_if_fail (IDE_IS_BUILD_TARGET (self), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+  if (IDE_BUILD_TARGET_GET_IFACE (self)->contains_file)
+    return IDE_BUILD_TARGET_GET_IFACE (self)->contains_file (self, file);
+
+  return FALSE;
+}
+
+/**
+ * ide_build_target_depends_on:
+ * @self: a #IdeBuildTarget
+ * @other: a #IdeBuildTarget
+ *
+ * Checks if @other is used to produce @self, such as a library that
+ * @self links against.
+ *
+ * Only direct dependencies need to be reported, callers walk the
+ * graph themselves when they need every dependent target.
+ *
+ * Returns: %TRUE if @self must be rebuilt when @other changes, %FALSE
+ *   if it does not or the build target cannot tell.
+ *
+ * Since: 44
+ */
+gboolean
+ide_build_target_depends_on (IdeBuildTarget *self,
+                             IdeBuildTarget *other)
+{
+  g_return_val_if_fail (IDE_IS_BUILD_TARGET (self), FALSE);
+  g_return_val_if_fail (IDE_IS_BUILD_TARGET (other), FALSE);
+
+  if (IDE_BUILD_TARGET_GET_IFACE (self)->depends_on)
+    return IDE_BUILD_TARGET_GET_IFACE (self)->depends_on (self, other);
+
+  return FALSE;
+}
+
 /**
  * ide_build_target_get_argv:
  * @self: a #IdeBuildTarget
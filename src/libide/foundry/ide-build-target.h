@@ -56,6 +56,10 @@ struct _IdeBuildTargetInterface
   gchar            *(*get_cwd)               (IdeBuildTarget *self);
   gchar            *(*get_language)          (IdeBuildTarget *self);
   IdeArtifactKind   (*get_kind)              (IdeBuildTarget *self);
+  gboolean          (*contains_file)         (IdeBuildTarget *self,
+                                              GFile          *file);
+  gboolean          (*depends_on)            (IdeBuildTarget *self,
+                                              IdeBuildTarget *other);
 };
 
 IDE_AVAILABLE_IN_ALL
@@ -76,6 +80,12 @@ IDE_AVAILABLE_IN_ALL
 gboolean          ide_build_target_get_install           (IdeBuildTarget       *self);
 IDE_AVAILABLE_IN_ALL
 IdeArtifactKind   ide_build_target_get_kind              (IdeBuildTarget       *self);
+IDE_AVAILABLE_IN_44
+gboolean          ide_build_target_contains_file         (IdeBuildTarget       *self,
+                                                          GFile                *file);
+IDE_AVAILABLE_IN_44
+gboolean          ide_build_target_depends_on            (IdeBuildTarget       *self,
+                                                          IdeBuildTarget       *other);
 IDE_AVAILABLE_IN_ALL
 gboolean          ide_build_target_compare               (const IdeBuildTarget *left,
                                                           const IdeBuildTarget *right);
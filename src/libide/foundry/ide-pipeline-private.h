@@ -26,5 +26,8 @@ G_BEGIN_DECLS
 
 void _ide_pipeline_attach_pty_to_run_context (IdePipeline   *self,
                                               IdeRunContext *run_context);
+void _ide_pipeline_extract_diagnostics       (IdePipeline   *self,
+                                              const guint8  *data,
+                                              gsize          len);
 
 G_END_DECLS
@@ -705,6 +705,7 @@ extract_directory_change (IdePipeline  *self,
 
 static void
 extract_diagnostics (IdePipeline  *self,
+                     guint64       lineno,
                      const guint8 *data,
                      gsize         len)
 {
@@ -734,7 +735,11 @@ extract_diagnostics (IdePipeline  *self,
 
   ide_line_reader_init (&reader, (gchar *)data, len);
 
-  while (NULL != (line = ide_line_reader_next (&reader, &line_len)))
+  /* @lineno is the line in the build log which @data starts on, so
+   * every line must be counted (even directory changes) to be able to
+   * record where diagnostics were found.
+   */
+  for (; NULL != (line = ide_line_reader_next (&reader, &line_len)); lineno++)
     {
       if (extract_directory_change (self, (const guint8 *)line, line_len))
         continue;
@@ -750,6 +755,10 @@ extract_diagnostics (IdePipeline  *self,
 
               if (diagnostic != NULL)
                 {
+                  if (self->log != NULL)
+                    ide_build_log_add_diagnostic (self->log,
+                                                  lineno,
+                                                  ide_diagnostic_get_severity (diagnostic));
                   ide_pipeline_emit_diagnostic (self, diagnostic);
                   break;
                 }
@@ -758,6 +767,25 @@ extract_diagnostics (IdePipeline  *self,
     }
 }
 
+/*
+ * _ide_pipeline_extract_diagnostics:
+ *
+ * Runs the registered error formats over @data as if it had been written
+ * to the build log, emitting #IdePipeline::diagnostic for each match.
+ * This lets benchmarks measure the parser without running a build.
+ */
+void
+_ide_pipeline_extract_diagnostics (IdePipeline  *self,
+                                   const guint8 *data,
+                                   gsize         len)
+{
+  g_return_if_fail (IDE_IS_PIPELINE (self));
+  g_return_if_fail (data != NULL || len == 0);
+
+  if (len > 0)
+    extract_diagnostics (self, 0, data, len);
+}
+
 static void
 ide_pipeline_log_observer (IdeBuildLogStream  stream,
                            const gchar       *message,
@@ -765,6 +793,7 @@ ide_pipeline_log_observer (IdeBuildLogStream  stream,
                            gpointer           user_data)
 {
   IdePipeline *self = user_data;
+  guint64 lineno = 0;
 
   g_assert (stream == IDE_BUILD_LOG_STDOUT || stream == IDE_BUILD_LOG_STDERR);
   g_assert (IDE_IS_PIPELINE (self));
@@ -774,9 +803,12 @@ ide_pipeline_log_observer (IdeBuildLogStream  stream,
     message_len = strlen (message);
 
   if (self->log != NULL)
-    ide_build_log_observer (stream, message, message_len, self->log);
+    {
+      lineno = ide_build_log_append (self->log, (const guint8 *)message, message_len);
+      ide_build_log_observer (stream, message, message_len, self->log);
+    }
 
-  extract_diagnostics (self, (const guint8 *)message, message_len);
+  extract_diagnostics (self, lineno, (const guint8 *)message, message_len);
 }
 
 static void
@@ -787,6 +819,7 @@ ide_pipeline_intercept_pty_consumer_cb (const IdePtyIntercept     *intercept,
                                         gpointer                   user_data)
 {
   IdePipeline *self = user_data;
+  guint64 lineno = 0;
 
   g_assert (intercept != NULL);
   g_assert (side != NULL);
@@ -794,7 +827,13 @@ ide_pipeline_intercept_pty_consumer_cb (const IdePtyIntercept     *intercept,
   g_assert (len > 0);
   g_assert (IDE_IS_PIPELINE (self));
 
-  extract_diagnostics (self, data, len);
+  /* The terminal renders PTY output itself, but keep a copy so that
+   * the output may still be searched and diagnostics located.
+   */
+  if (self->log != NULL)
+    lineno = ide_build_log_append (self->log, data, len);
+
+  extract_diagnostics (self, lineno, data, len);
 }
 
 static void
@@ -1610,6 +1649,7 @@ ide_pipeline_parent_set (IdeObject *object,
   IdeToolchainManager *toolchain_manager;
   g_autoptr(IdeContext) context = NULL;
   g_autoptr(GFile) workdir = NULL;
+  g_autofree char *log_dir = NULL;
 
   IDE_ENTRY;
 
@@ -1625,6 +1665,10 @@ ide_pipeline_parent_set (IdeObject *object,
 
   self->srcdir = g_file_get_path (workdir);
 
+  /* Keep the log storage on disk rather than in a memory backed /tmp */
+  log_dir = ide_context_cache_filename (context, NULL, NULL);
+  ide_build_log_set_directory (self->log, log_dir);
+
   toolchain_manager = ide_toolchain_manager_from_context (context);
   self->toolchain = ide_toolchain_manager_get_toolchain (toolchain_manager, "default");
 
@@ -3745,12 +3789,18 @@ static inline void
 ide_pipeline_log (IdePipeline *self,
                   const char  *message)
 {
+  gsize len;
+
   g_assert (IDE_IS_PIPELINE (self));
 
   if (self->log == NULL)
     return;
 
-  ide_build_log_observer (IDE_BUILD_LOG_STDOUT, message, strlen (message), self->log);
+  len = strlen (message);
+
+  ide_build_log_append (self->log, (const guint8 *)message, len);
+  ide_build_log_append (self->log, (const guint8 *)"\n", 1);
+  ide_build_log_observer (IDE_BUILD_LOG_STDOUT, message, len, self->log);
 }
 
 static void
@@ -4578,3 +4628,84 @@ ide_pipeline_create_run_context (IdePipeline   *self,
 
   return g_steal_pointer (&run_context);
 }
+
+/**
+ * ide_pipeline_dup_log_line:
+ * @self: a #IdePipeline
+ * @line: the line number within the build output, starting from zero
+ *
+ * Gets a line of the build output. Only the most recent output is
+ * retained, so older lines may no longer be available.
+ *
+ * Returns: (transfer full) (nullable): the line without the trailing
+ *   newline, or %NULL if it is not available
+ *
+ * Since: 44
+ */
+char *
+ide_pipeline_dup_log_line (IdePipeline *self,
+                           guint64      line)
+{
+  g_return_val_if_fail (IDE_IS_PIPELINE (self), NULL);
+
+  if (self->log == NULL)
+    return NULL;
+
+  return ide_build_log_dup_line (self->log, line);
+}
+
+/**
+ * ide_pipeline_search_log:
+ * @self: a #IdePipeline
+ * @text: the text to locate
+ * @max_matches: the maximum number of lines to return, or 0 for no limit
+ *
+ * Locates the lines of the build output containing @text.
+ *
+ * Returns: (transfer full) (element-type guint64): an array of line
+ *   numbers which may be passed to ide_pipeline_dup_log_line()
+ *
+ * Since: 44
+ */
+GArray *
+ide_pipeline_search_log (IdePipeline *self,
+                         const char  *text,
+                         guint        max_matches)
+{
+  g_return_val_if_fail (IDE_IS_PIPELINE (self), NULL);
+  g_return_val_if_fail (text != NULL, NULL);
+
+  if (self->log == NULL)
+    return g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  return ide_build_log_search (self->log, text, max_matches);
+}
+
+/**
+ * ide_pipeline_get_log_diagnostic:
+ * @self: a #IdePipeline
+ * @severity: the severity of the diagnostic
+ * @nth: the index of the diagnostic
+ * @line: (out): a location for the line number
+ *
+ * Locates the line of build output which produced the @nth diagnostic
+ * of @severity, such as to jump to the next error.
+ *
+ * Returns: %TRUE if @line was set
+ *
+ * Since: 44
+ */
+gboolean
+ide_pipeline_get_log_diagnostic (IdePipeline           *self,
+                                 IdeDiagnosticSeverity  severity,
+                                 guint                  nth,
+                                 guint64               *line)
+{
+  g_return_val_if_fail (IDE_IS_PIPELINE (self), FALSE);
+  g_return_val_if_fail (line != NULL, FALSE);
+
+  if (self->log == NULL)
+    return FALSE;
+
+  return ide_build_log_get_diagnostic_line (self->log, severity, nth, line);
+}
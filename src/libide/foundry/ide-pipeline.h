@@ -209,5 +209,17 @@ gboolean               ide_pipeline_contains_program_in_path (IdePipeline
                                                               GCancellable           *cancellable);
 IDE_AVAILABLE_IN_ALL
 IdeDeployStrategy     *ide_pipeline_get_deploy_strategy      (IdePipeline            *self);
+IDE_AVAILABLE_IN_44
+char                  *ide_pipeline_dup_log_line             (IdePipeline            *self,
+                                                              guint64                 line);
+IDE_AVAILABLE_IN_44
+GArray                *ide_pipeline_search_log               (IdePipeline            *self,
+                                                              const char             *text,
+                                                              guint                   max_matches);
+IDE_AVAILABLE_IN_44
+gboolean               ide_pipeline_get_log_diagnostic       (IdePipeline            *self,
+                                                              IdeDiagnosticSeverity   severity,
+                                                              guint                   nth,
+                                                              guint64                *line);
 
 G_END_DECLS
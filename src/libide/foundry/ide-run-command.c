@@ -41,6 +41,7 @@ typedef struct
   int priority;
   IdeRunCommandKind kind : 8;
   guint can_default : 1;
+  guint is_parallel : 1;
 } IdeRunCommandPrivate;
 
 enum {
@@ -52,6 +53,7 @@ enum {
   PROP_DISPLAY_NAME,
   PROP_ENVIRON,
   PROP_ID,
+  PROP_IS_PARALLEL,
   PROP_KIND,
   PROP_LANGUAGES,
   PROP_PRIORITY,
@@ -249,6 +251,10 @@ ide_run_command_get_property (GObject    *object,
       g_value_set_string (value, ide_run_command_get_id (self));
       break;
 
+    case PROP_IS_PARALLEL:
+      g_value_set_boolean (value, ide_run_command_get_is_parallel (self));
+      break;
+
     case PROP_KIND:
       g_value_set_enum (value, ide_run_command_get_kind (self));
       break;
@@ -308,6 +314,10 @@ ide_run_command_set_property (GObject      *object,
       ide_run_command_set_id (self, g_value_get_string (value));
       break;
 
+    case PROP_IS_PARALLEL:
+      ide_run_command_set_is_parallel (self, g_value_get_boolean (value));
+      break;
+
     case PROP_KIND:
       ide_run_command_set_kind (self, g_value_get_enum (value));
       break;
@@ -386,6 +396,22 @@ ide_run_command_class_init (IdeRunCommandClass *klass)
                          NULL,
                          (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * IdeRunCommand:is-parallel:
+   *
+   * If the command may be run concurrently with other commands.
+   *
+   * This is used by the #IdeTestManager to know which tests must be run
+   * on their own, such as those which are marked as not parallel safe by
+   * the build system.
+   *
+   * Since: 44
+   */
+  properties [PROP_IS_PARALLEL] =
+    g_param_spec_boolean ("is-parallel", NULL, NULL,
+                          TRUE,
+                          (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
   properties [PROP_KIND] =
     g_param_spec_enum ("kind", NULL, NULL,
                        IDE_TYPE_RUN_COMMAND_KIND,
@@ -430,6 +456,9 @@ ide_run_command_class_init (IdeRunCommandClass *klass)
 static void
 ide_run_command_init (IdeRunCommand *self)
 {
+  IdeRunCommandPrivate *priv = ide_run_command_get_instance_private (self);
+
+  priv->is_parallel = TRUE;
 }
 
 IdeRunCommand *
@@ -707,6 +736,43 @@ ide_run_command_set_can_default (IdeRunCommand *self,
     }
 }
 
+/**
+ * ide_run_command_get_is_parallel:
+ * @self: a #IdeRunCommand
+ *
+ * Gets if the command may be run concurrently with other commands.
+ *
+ * Returns: %TRUE if the command is parallel safe, which is the default
+ *
+ * Since: 44
+ */
+gboolean
+ide_run_command_get_is_parallel (IdeRunCommand *self)
+{
+  IdeRunCommandPrivate *priv = ide_run_command_get_instance_private (self);
+
+  g_return_val_if_fail (IDE_IS_RUN_COMMAND (self), FALSE);
+
+  return priv->is_parallel;
+}
+
+void
+ide_run_command_set_is_parallel (IdeRunCommand *self,
+                                 gboolean       is_parallel)
+{
+  IdeRunCommandPrivate *priv = ide_run_command_get_instance_private (self);
+
+  g_return_if_fail (IDE_IS_RUN_COMMAND (self));
+
+  is_parallel = !!is_parallel;
+
+  if (is_parallel != priv->is_parallel)
+    {
+      priv->is_parallel = is_parallel;
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_IS_PARALLEL]);
+    }
+}
+
 const char *
 ide_run_command_getenv (IdeRunCommand *self,
                         const char    *key)
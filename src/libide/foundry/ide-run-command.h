@@ -122,6 +122,11 @@ gboolean            ide_run_command_get_can_default  (IdeRunCommand      *self);
 IDE_AVAILABLE_IN_ALL
 void                ide_run_command_set_can_default  (IdeRunCommand      *self,
                                                       gboolean            can_default);
+IDE_AVAILABLE_IN_44
+gboolean            ide_run_command_get_is_parallel  (IdeRunCommand      *self);
+IDE_AVAILABLE_IN_44
+void                ide_run_command_set_is_parallel  (IdeRunCommand      *self,
+                                                      gboolean            is_parallel);
 IDE_AVAILABLE_IN_ALL
 void                ide_run_command_prepare_to_run   (IdeRunCommand      *self,
                                                       IdeRunContext      *run_context,
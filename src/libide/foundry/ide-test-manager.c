@@ -41,7 +41,8 @@
 #include "ide-test-manager.h"
 #include "ide-test-private.h"
 
-#define MAX_UNIT_TESTS 4
+#define HISTORY_VERSION 1
+#define HISTORY_TYPE    "(ua{s(xb)})"
 
 /**
  * SECTION:ide-test-manager
@@ -66,14 +67,40 @@ struct _IdeTestManager
   IdePtyIntercept     intercept;
   int                 pty_producer;
   guint               n_active;
+
+  /* Test id -> TestHistory, persisted to the project cache so that
+   * run_all can start the longest (and previously failed) tests first.
+   */
+  GHashTable         *history;
+  guint               history_loaded : 1;
+  guint               history_dirty : 1;
 };
 
+typedef struct
+{
+  /* Duration of the last completed run in microseconds */
+  gint64 duration;
+  guint  failed : 1;
+} TestHistory;
+
+typedef struct
+{
+  gint64 begin_time;
+} Run;
+
 typedef struct
 {
   IdePipeline *pipeline;
   GPtrArray   *tests;
   VtePty      *pty;
+  GHashTable  *history;
+  guint        position;
   guint        n_active;
+  guint        max_active;
+  guint        n_failed;
+  guint        running_exclusive : 1;
+  guint        failed_first : 1;
+  guint        fail_fast : 1;
 } RunAll;
 
 static void ide_test_manager_actions_cancel   (IdeTestManager *self,
@@ -126,12 +153,208 @@ run_all_free (RunAll *state)
   g_assert (state->n_active == 0);
 
   g_clear_pointer (&state->tests, g_ptr_array_unref);
+  g_clear_pointer (&state->history, g_hash_table_unref);
   g_clear_object (&state->pipeline);
   g_clear_object (&state->pty);
 
   g_slice_free (RunAll, state);
 }
 
+static void
+run_free (Run *state)
+{
+  g_slice_free (Run, state);
+}
+
+static GFile *
+get_history_file (IdeTestManager *self)
+{
+  IdeContext *context = ide_object_get_context (IDE_OBJECT (self));
+
+  return ide_context_cache_file (context, "tests", "history.gvariant", NULL);
+}
+
+static void
+ide_test_manager_load_history (IdeTestManager *self)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) entries = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GFile) file = NULL;
+  guint32 version = 0;
+  gsize n_entries;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_TEST_MANAGER (self));
+
+  if (self->history_loaded || self->history == NULL)
+    IDE_EXIT;
+
+  self->history_loaded = TRUE;
+
+  /* This is small enough to be read synchronously, and only happens
+   * the first time tests are run for the project.
+   */
+  file = get_history_file (self);
+  if (!(mapped = g_mapped_file_new (g_file_peek_path (file), FALSE, NULL)))
+    IDE_EXIT;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (HISTORY_TYPE), bytes, FALSE));
+  g_variant_get (variant, "(u@a{s(xb)})", &version, &entries);
+
+  if (version != HISTORY_VERSION)
+    IDE_EXIT;
+
+  n_entries = g_variant_n_children (entries);
+
+  for (gsize i = 0; i < n_entries; i++)
+    {
+      TestHistory *history;
+      const char *id;
+      gboolean failed;
+      gint64 duration;
+
+      g_variant_get_child (entries, i, "{&s(xb)}", &id, &duration, &failed);
+
+      /* Don't clobber results from tests run before we loaded */
+      if (g_hash_table_contains (self->history, id))
+        continue;
+
+      history = g_new0 (TestHistory, 1);
+      history->duration = MAX (0, duration);
+      history->failed = !!failed;
+
+      g_hash_table_insert (self->history, g_strdup (id), history);
+    }
+
+  IDE_EXIT;
+}
+
+static void
+ide_test_manager_save_history (IdeTestManager *self)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GFile) parent = NULL;
+  g_autoptr(GFile) file = NULL;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  TestHistory *history;
+  const char *id;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_TEST_MANAGER (self));
+
+  if (!self->history_dirty || self->history == NULL)
+    IDE_EXIT;
+
+  /* Merge with what is on disk if we only ran individual tests */
+  ide_test_manager_load_history (self);
+
+  self->history_dirty = FALSE;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(xb)}"));
+  g_hash_table_iter_init (&iter, self->history);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&id, (gpointer *)&history))
+    g_variant_builder_add (&builder, "{s(xb)}", id, history->duration, (gboolean)history->failed);
+
+  variant = g_variant_ref_sink (g_variant_new ("(u@a{s(xb)})",
+                                               HISTORY_VERSION,
+                                               g_variant_builder_end (&builder)));
+  bytes = g_variant_get_data_as_bytes (variant);
+
+  file = get_history_file (self);
+  parent = g_file_get_parent (file);
+  g_file_make_directory_with_parents (parent, NULL, NULL);
+
+  g_file_replace_contents_bytes_async (file,
+                                       bytes,
+                                       NULL,
+                                       FALSE,
+                                       G_FILE_CREATE_REPLACE_DESTINATION,
+                                       NULL,
+                                       NULL,
+                                       NULL);
+
+  IDE_EXIT;
+}
+
+static gint64
+get_expected_duration (GHashTable *history,
+                       IdeTest    *test)
+{
+  const TestHistory *entry = g_hash_table_lookup (history, ide_test_get_id (test));
+
+  /* Tests we know nothing about could be slow, so start them early */
+  return entry ? entry->duration : G_MAXINT64;
+}
+
+static gboolean
+get_previously_failed (GHashTable *history,
+                       IdeTest    *test)
+{
+  const TestHistory *entry = g_hash_table_lookup (history, ide_test_get_id (test));
+
+  return entry ? entry->failed : FALSE;
+}
+
+static int
+compare_by_run_order (gconstpointer a,
+                      gconstpointer b,
+                      gpointer      user_data)
+{
+  IdeTest *test_a = *(IdeTest **)a;
+  IdeTest *test_b = *(IdeTest **)b;
+  IdeRunCommand *command_a = ide_test_get_run_command (test_a);
+  IdeRunCommand *command_b = ide_test_get_run_command (test_b);
+  RunAll *state = user_data;
+  gboolean parallel_a;
+  gboolean parallel_b;
+  gint64 duration_a;
+  gint64 duration_b;
+  int priority_a;
+  int priority_b;
+
+  if (state->failed_first)
+    {
+      gboolean failed_a = get_previously_failed (state->history, test_a);
+      gboolean failed_b = get_previously_failed (state->history, test_b);
+
+      if (failed_a != failed_b)
+        return failed_a ? -1 : 1;
+    }
+
+  priority_a = ide_run_command_get_priority (command_a);
+  priority_b = ide_run_command_get_priority (command_b);
+
+  if (priority_a != priority_b)
+    return priority_a < priority_b ? -1 : 1;
+
+  /* Run tests which must be run on their own after the others of the
+   * same priority so that we drain the queue as few times as possible.
+   */
+  parallel_a = ide_run_command_get_is_parallel (command_a);
+  parallel_b = ide_run_command_get_is_parallel (command_b);
+
+  if (parallel_a != parallel_b)
+    return parallel_a ? -1 : 1;
+
+  /* Longest first so that a slow test does not hold up the end of the run */
+  duration_a = get_expected_duration (state->history, test_a);
+  duration_b = get_expected_duration (state->history, test_b);
+
+  if (duration_a != duration_b)
+    return duration_a > duration_b ? -1 : 1;
+
+  return 0;
+}
+
 static GCancellable *
 get_cancellable (IdeTestManager *self)
 {
@@ -225,6 +448,7 @@ ide_test_manager_destroy (IdeObject *object)
   g_clear_object (&self->cancellable);
   g_clear_object (&self->filtered);
   g_clear_object (&self->tests);
+  g_clear_pointer (&self->history, g_hash_table_unref);
 
   g_clear_object (&self->pty);
   fd = pty_fd_steal (&self->pty_producer);
@@ -316,6 +540,7 @@ ide_test_manager_init (IdeTestManager *self)
 
   self->pty = ide_pty_new_sync (NULL);
   self->pty_producer = -1;
+  self->history = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 
   /* Now create intercept, which we'll use to apply PTY
    * to all the spawned processes instead of our VtePty.
@@ -331,6 +556,9 @@ ide_test_manager_init (IdeTestManager *self)
   self->tests = ide_cached_list_model_new (G_LIST_MODEL (map));
 }
 
+static void ide_test_manager_run_all_schedule (IdeTestManager *self,
+                                               IdeTask        *task);
+
 static void
 ide_test_manager_run_all_cb (GObject      *object,
                              GAsyncResult *result,
@@ -339,7 +567,6 @@ ide_test_manager_run_all_cb (GObject      *object,
   IdeTestManager *self = (IdeTestManager *)object;
   g_autoptr(IdeTask) task = user_data;
   g_autoptr(GError) error = NULL;
-  GCancellable *cancellable;
   RunAll *state;
 
   IDE_ENTRY;
@@ -349,7 +576,6 @@ ide_test_manager_run_all_cb (GObject      *object,
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
 
-  cancellable = ide_task_get_cancellable (task);
   state = ide_task_get_task_data (task);
 
   g_assert (state != NULL);
@@ -357,24 +583,65 @@ ide_test_manager_run_all_cb (GObject      *object,
   g_assert (state->tests != NULL);
 
   if (!ide_test_manager_run_finish (self, result, &error))
-    g_message ("%s", error->message);
+    {
+      g_message ("%s", error->message);
+
+      if (!ide_error_ignore (error))
+        state->n_failed++;
+    }
+
+  /* If an exclusive test was running, it was the only one */
+  state->running_exclusive = FALSE;
+  state->n_active--;
 
-  if (state->tests->len > 0 &&
-      !g_cancellable_is_cancelled (cancellable))
+  ide_test_manager_run_all_schedule (self, task);
+
+  IDE_EXIT;
+}
+
+static void
+ide_test_manager_run_all_schedule (IdeTestManager *self,
+                                   IdeTask        *task)
+{
+  GCancellable *cancellable;
+  RunAll *state;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_TEST_MANAGER (self));
+  g_assert (IDE_IS_TASK (task));
+
+  cancellable = ide_task_get_cancellable (task);
+  state = ide_task_get_task_data (task);
+
+  g_assert (state != NULL);
+  g_assert (state->max_active > 0);
+
+  while (state->position < state->tests->len &&
+         state->n_active < state->max_active &&
+         !state->running_exclusive &&
+         !(state->fail_fast && state->n_failed > 0) &&
+         !g_cancellable_is_cancelled (cancellable))
     {
-      g_autoptr(IdeTest) next_test = g_ptr_array_steal_index (state->tests, state->tests->len-1);
+      IdeTest *test = g_ptr_array_index (state->tests, state->position);
+      gboolean is_parallel = ide_run_command_get_is_parallel (ide_test_get_run_command (test));
+
+      /* Tests which are not parallel safe wait for the others to finish */
+      if (!is_parallel && state->n_active > 0)
+        break;
 
+      state->position++;
       state->n_active++;
+      state->running_exclusive = !is_parallel;
 
       ide_test_manager_run_async (self,
-                                  next_test,
+                                  test,
                                   cancellable,
                                   ide_test_manager_run_all_cb,
                                   g_object_ref (task));
     }
 
-  state->n_active--;
-
   if (state->n_active == 0)
     ide_task_return_boolean (task, TRUE);
 
@@ -394,7 +661,16 @@ ide_test_manager_emit_end_test_all (IdeTestManager *self)
  * @callback: a callback to execute upon completion
  * @user_data: user data for @callback
  *
- * Executes all tests in an undefined order.
+ * Executes all tests, running as many at once as configured by the
+ * "unit-test-parallel" setting.
+ *
+ * Tests are started in order of priority. Within the same priority,
+ * those which take the longest based on previous runs are started
+ * first. Tests which are not parallel safe (see
+ * ide_run_command_get_is_parallel()) are run on their own. Depending
+ * on the project settings, tests which failed during the previous run
+ * are started before all others and no further tests are started once
+ * a test has failed.
  *
  * Upon completion, @callback will be executed which must call
  * ide_test_manager_run_all_finish() to get the result.
@@ -409,13 +685,14 @@ ide_test_manager_run_all_async (IdeTestManager      *self,
                                 gpointer             user_data)
 {
   g_autoptr(IdeTask) task = NULL;
-  g_autoptr(GPtrArray) ar = NULL;
+  g_autoptr(IdeSettings) settings = NULL;
   IdeBuildManager *build_manager;
   IdePipeline *pipeline;
   GListModel *tests;
   IdeContext *context;
   RunAll *state;
   guint n_items;
+  int parallel;
 
   IDE_ENTRY;
 
@@ -447,34 +724,29 @@ ide_test_manager_run_all_async (IdeTestManager      *self,
                            self,
                            G_CONNECT_SWAPPED);
 
+  ide_test_manager_load_history (self);
+
+  settings = ide_context_ref_settings (context, "org.gnome.builder.project");
+  parallel = ide_settings_get_int (settings, "unit-test-parallel");
+
   tests = ide_test_manager_list_tests (self);
   n_items = g_list_model_get_n_items (tests);
 
-  ar = g_ptr_array_new_with_free_func (g_object_unref);
-  for (guint i = n_items; i > 0; i--)
-    g_ptr_array_add (ar, g_list_model_get_item (tests, i-1));
-
   state = g_slice_new0 (RunAll);
-  state->tests = g_ptr_array_ref (ar);
+  state->tests = g_ptr_array_new_full (n_items, g_object_unref);
   state->pipeline = g_object_ref (pipeline);
-  state->n_active = 0;
+  state->history = g_hash_table_ref (self->history);
+  state->max_active = parallel > 0 ? parallel : g_get_num_processors ();
+  state->failed_first = ide_settings_get_boolean (settings, "unit-test-failed-first");
+  state->fail_fast = ide_settings_get_boolean (settings, "unit-test-fail-fast");
   ide_task_set_task_data (task, state, run_all_free);
 
-  for (guint i = 0; i < MAX_UNIT_TESTS && ar->len > 0; i++)
-    {
-      g_autoptr(IdeTest) test = g_ptr_array_steal_index (state->tests, ar->len-1);
+  for (guint i = 0; i < n_items; i++)
+    g_ptr_array_add (state->tests, g_list_model_get_item (tests, i));
 
-      state->n_active++;
+  g_ptr_array_sort_with_data (state->tests, compare_by_run_order, state);
 
-      ide_test_manager_run_async (self,
-                                  test,
-                                  cancellable,
-                                  ide_test_manager_run_all_cb,
-                                  g_object_ref (task));
-    }
-
-  if (state->n_active == 0)
-    ide_task_return_boolean (task, TRUE);
+  ide_test_manager_run_all_schedule (self, task);
 
   g_signal_emit (self, signals[BEGIN_TEST_ALL], 0);
 
@@ -520,6 +792,10 @@ ide_test_manager_run_cb (GObject      *object,
   IdeTest *test = (IdeTest *)object;
   g_autoptr(IdeTask) task = user_data;
   g_autoptr(GError) error = NULL;
+  IdeTestManager *self;
+  TestHistory *history;
+  gboolean success;
+  Run *state;
 
   IDE_ENTRY;
 
@@ -528,7 +804,29 @@ ide_test_manager_run_cb (GObject      *object,
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
 
-  if (!ide_test_run_finish (test, result, &error))
+  self = ide_task_get_source_object (task);
+  state = ide_task_get_task_data (task);
+
+  g_assert (IDE_IS_TEST_MANAGER (self));
+  g_assert (state != NULL);
+
+  success = ide_test_run_finish (test, result, &error);
+
+  /* Cancelled runs tell us nothing about how long the test takes */
+  if (self->history != NULL && (success || !ide_error_ignore (error)))
+    {
+      if (!(history = g_hash_table_lookup (self->history, ide_test_get_id (test))))
+        {
+          history = g_new0 (TestHistory, 1);
+          g_hash_table_insert (self->history, g_strdup (ide_test_get_id (test)), history);
+        }
+
+      history->duration = g_get_monotonic_time () - state->begin_time;
+      history->failed = !success;
+      self->history_dirty = TRUE;
+    }
+
+  if (!success)
     ide_task_return_error (task, g_steal_pointer (&error));
   else
     ide_task_return_boolean (task, TRUE);
@@ -548,7 +846,10 @@ ide_test_manager_test_notify_completed_cb (IdeTestManager *self,
   self->n_active--;
 
   if (self->n_active == 0)
-    ide_test_manager_set_action_enabled (self, "cancel", FALSE);
+    {
+      ide_test_manager_set_action_enabled (self, "cancel", FALSE);
+      ide_test_manager_save_history (self);
+    }
 }
 
 /**
@@ -615,12 +916,20 @@ ide_test_manager_run_async (IdeTestManager      *self,
                                G_IO_ERROR_NOT_INITIALIZED,
                                "Pipeline is not ready, cannot run test");
   else
-    ide_test_run_async (test,
-                        pipeline,
-                        self->pty_producer,
-                        cancellable,
-                        ide_test_manager_run_cb,
-                        g_steal_pointer (&task));
+    {
+      Run *state;
+
+      state = g_slice_new0 (Run);
+      state->begin_time = g_get_monotonic_time ();
+      ide_task_set_task_data (task, state, run_free);
+
+      ide_test_run_async (test,
+                          pipeline,
+                          self->pty_producer,
+                          cancellable,
+                          ide_test_manager_run_cb,
+                          g_steal_pointer (&task));
+    }
 
   IDE_EXIT;
 }
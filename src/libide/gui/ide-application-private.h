@@ -90,11 +90,18 @@ struct _IdeApplication
   /* The time the application was started */
   GDateTime *started_at;
 
+  /* Index files shared by all of the loaded projects */
+  IdeIndexRegistry *index_registry;
+
   /* Sets the type of workspace to create when creating the next workspace
    * (such as when processing command line arguments).
    */
   GType workspace_type;
 
+  /* Heartbeat used to report main loop stalls to the profiler */
+  guint  stall_source;
+  gint64 last_heartbeat;
+
   /* If we've detected we lost network access */
   GNetworkMonitor *network_monitor;
   guint has_network : 1;
@@ -39,6 +39,9 @@
 #include "ide-primary-workspace.h"
 #include "ide-shortcut-manager-private.h"
 
+#define HEARTBEAT_INTERVAL_MSEC 10
+#define STALL_THRESHOLD_USEC    (G_USEC_PER_SEC / 30)
+
 typedef struct
 {
   IdeApplication  *self;
@@ -196,6 +199,27 @@ ide_application_load_typelibs (IdeApplication *self)
   IDE_EXIT;
 }
 
+static gboolean
+ide_application_heartbeat_cb (gpointer data)
+{
+  IdeApplication *self = data;
+  gint64 expected;
+  gint64 now;
+
+  g_assert (IDE_IS_APPLICATION (self));
+
+  now = g_get_monotonic_time ();
+  expected = self->last_heartbeat + HEARTBEAT_INTERVAL_MSEC * 1000L;
+
+  /* Anything beyond a frame or two late means the main loop was blocked */
+  if (now - expected > STALL_THRESHOLD_USEC)
+    ide_profiler_mark (expected, now, "main-loop", "stall", NULL);
+
+  self->last_heartbeat = now;
+
+  return G_SOURCE_CONTINUE;
+}
+
 static void
 ide_application_startup (GApplication *app)
 {
@@ -235,6 +259,16 @@ ide_application_startup (GApplication *app)
 
   /* Load language defaults into gsettings */
   ide_language_defaults_init_async (NULL, NULL, NULL);
+
+  /* Only pay for the heartbeat when someone is watching */
+  if (ide_profiler_is_active ())
+    {
+      self->last_heartbeat = g_get_monotonic_time ();
+      self->stall_source = g_timeout_add_full (G_PRIORITY_HIGH,
+                                               HEARTBEAT_INTERVAL_MSEC,
+                                               ide_application_heartbeat_cb,
+                                               self, NULL);
+    }
 }
 
 static void
@@ -247,6 +281,7 @@ ide_application_shutdown (GApplication *app)
 
   _ide_application_unload_addins (self);
 
+  g_clear_handle_id (&self->stall_source, g_source_remove);
   g_clear_pointer (&self->plugin_settings, g_hash_table_unref);
   g_clear_object (&self->addins);
   g_clear_object (&self->settings);
@@ -506,6 +541,7 @@ ide_application_dispose (GObject *object)
    * in ::shutdown.
    */
   g_clear_pointer (&self->started_at, g_date_time_unref);
+  g_clear_object (&self->index_registry);
   g_clear_pointer (&self->workbenches, g_ptr_array_unref);
   g_clear_pointer (&self->plugin_settings, g_hash_table_unref);
   g_clear_pointer (&self->plugin_gresources, g_hash_table_unref);
@@ -581,6 +617,7 @@ ide_application_init (IdeApplication *self)
   self->menu_merge_ids = g_hash_table_new (g_str_hash, g_str_equal);
   self->menu_manager = ide_menu_manager_new ();
   self->started_at = g_date_time_new_now_local ();
+  self->index_registry = ide_index_registry_new ();
   self->workspace_type = IDE_TYPE_PRIMARY_WORKSPACE;
   self->workbenches = g_ptr_array_new_with_free_func (g_object_unref);
   self->settings = g_settings_new ("org.gnome.builder");
@@ -798,6 +835,25 @@ ide_application_get_started_at (IdeApplication *self)
   return self->started_at;
 }
 
+/**
+ * ide_application_get_index_registry:
+ * @self: a #IdeApplication
+ *
+ * Gets the registry used to share index files between all of the
+ * projects open in the application.
+ *
+ * Returns: (transfer none): an #IdeIndexRegistry
+ *
+ * Since: 44
+ */
+IdeIndexRegistry *
+ide_application_get_index_registry (IdeApplication *self)
+{
+  g_return_val_if_fail (IDE_IS_APPLICATION (self), NULL);
+
+  return self->index_registry;
+}
+
 /**
  * ide_application_find_workbench_for_file:
  * @self: a #IdeApplication
@@ -27,6 +27,7 @@
 #include <adwaita.h>
 
 #include <libide-core.h>
+#include <libide-io.h>
 #include <libide-projects.h>
 
 #include "ide-workbench.h"
@@ -46,6 +47,9 @@ gchar        **ide_application_get_argv                 (IdeApplication
                                                          GApplicationCommandLine  *cmdline);
 IDE_AVAILABLE_IN_ALL
 GDateTime     *ide_application_get_started_at           (IdeApplication           *self);
+IDE_AVAILABLE_IN_44
+IdeIndexRegistry *
+               ide_application_get_index_registry       (IdeApplication           *self);
 IDE_AVAILABLE_IN_ALL
 gboolean       ide_application_get_command_line_handled (IdeApplication           *self,
                                                          GApplicationCommandLine  *cmdline);
@@ -0,0 +1,397 @@
+/* ide-index-registry.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "ide-index-registry"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "ide-index-registry.h"
+
+/**
+ * SECTION:ide-index-registry
+ * @title: IdeIndexRegistry
+ * @short_description: share loaded index files between contexts
+ *
+ * #IdeIndexRegistry lets every #IdeContext in the process share a single
+ * loaded instance of an index file, such as an #IdePersistentMap or a
+ * ctags index, rather than each workbench mapping and parsing its own copy.
+ *
+ * Files are identified by device, inode, modification time and size so
+ * that the same file reached through different paths is only loaded once,
+ * and a rewritten file is never confused with the previous version.
+ * The registry only holds weak references, so an index is released as
+ * soon as the last context using it lets go.
+ *
+ * It also knows where to find indexes which were built ahead of time for
+ * installed SDKs, see ide_index_registry_find_prebuilt().
+ *
+ * Since: 44
+ */
+
+#define FILE_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_UNIX_DEVICE"," \
+  G_FILE_ATTRIBUTE_UNIX_INODE"," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED"," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC"," \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE
+
+typedef struct
+{
+  GType    type;
+  char    *qualifier;
+  guint64  device;
+  guint64  inode;
+  guint64  mtime;
+  guint64  size;
+} IndexKey;
+
+typedef struct
+{
+  IndexKey key;
+  GWeakRef index;
+} IndexEntry;
+
+struct _IdeIndexRegistry
+{
+  GObject     parent_instance;
+
+  /* Protects all fields, the registry is used from indexer threads */
+  GMutex      mutex;
+
+  /* IndexKey* -> IndexEntry*, the key is owned by the entry */
+  GHashTable *entries;
+
+  /* Directories to search for prebuilt indexes, in priority order */
+  GPtrArray  *prebuilt_dirs;
+};
+
+G_DEFINE_FINAL_TYPE (IdeIndexRegistry, ide_index_registry, G_TYPE_OBJECT)
+
+static guint
+index_key_hash (gconstpointer data)
+{
+  const IndexKey *key = data;
+
+  return g_int64_hash (&key->inode) ^
+         g_int64_hash (&key->mtime) ^
+         g_direct_hash (GSIZE_TO_POINTER (key->type)) ^
+         (key->qualifier ? g_str_hash (key->qualifier) : 0);
+}
+
+static gboolean
+index_key_equal (gconstpointer a,
+                 gconstpointer b)
+{
+  const IndexKey *ka = a;
+  const IndexKey *kb = b;
+
+  return ka->type == kb->type &&
+         ka->device == kb->device &&
+         ka->inode == kb->inode &&
+         ka->mtime == kb->mtime &&
+         ka->size == kb->size &&
+         g_strcmp0 (ka->qualifier, kb->qualifier) == 0;
+}
+
+static gboolean
+index_key_init (IndexKey   *key,
+                GType       type,
+                GFile      *file,
+                const char *qualifier)
+{
+  g_autoptr(GFileInfo) info = NULL;
+
+  g_assert (key != NULL);
+  g_assert (G_IS_FILE (file));
+
+  /* Without a device and inode we cannot tell whether two paths are the
+   * same file, so such indexes are simply not shared.
+   */
+  if (!g_file_is_native (file) ||
+      !(info = g_file_query_info (file, FILE_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, NULL, NULL)) ||
+      !g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_UNIX_INODE))
+    return FALSE;
+
+  key->type = type;
+  key->qualifier = (char *)qualifier;
+  key->device = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_DEVICE);
+  key->inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
+  key->mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+               g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  key->size = g_file_info_get_size (info);
+
+  return TRUE;
+}
+
+static void
+index_entry_free (gpointer data)
+{
+  IndexEntry *entry = data;
+
+  g_weak_ref_clear (&entry->index);
+  g_free (entry->key.qualifier);
+  g_slice_free (IndexEntry, entry);
+}
+
+static void
+ide_index_registry_finalize (GObject *object)
+{
+  IdeIndexRegistry *self = (IdeIndexRegistry *)object;
+
+  g_clear_pointer (&self->entries, g_hash_table_unref);
+  g_clear_pointer (&self->prebuilt_dirs, g_ptr_array_unref);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (ide_index_registry_parent_class)->finalize (object);
+}
+
+static void
+ide_index_registry_class_init (IdeIndexRegistryClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = ide_index_registry_finalize;
+}
+
+static void
+ide_index_registry_init (IdeIndexRegistry *self)
+{
+  const char * const *system_dirs = g_get_system_data_dirs ();
+
+  g_mutex_init (&self->mutex);
+
+  self->entries = g_hash_table_new_full (index_key_hash, index_key_equal, NULL, index_entry_free);
+  self->prebuilt_dirs = g_ptr_array_new_with_free_func (g_free);
+
+  g_ptr_array_add (self->prebuilt_dirs,
+                   g_build_filename (g_get_user_data_dir (), ide_get_program_name (), "indexes", NULL));
+  for (guint i = 0; system_dirs[i]; i++)
+    g_ptr_array_add (self->prebuilt_dirs,
+                     g_build_filename (system_dirs[i], ide_get_program_name (), "indexes", NULL));
+}
+
+IdeIndexRegistry *
+ide_index_registry_new (void)
+{
+  return g_object_new (IDE_TYPE_INDEX_REGISTRY, NULL);
+}
+
+/**
+ * ide_index_registry_lookup:
+ * @self: a #IdeIndexRegistry
+ * @index_type: the #GType of the index object
+ * @file: the file the index was loaded from
+ * @qualifier: (nullable): an optional string for indexes whose contents
+ *   depend on more than the file, such as a path root
+ *
+ * Looks for an index of @index_type which is already loaded from the
+ * current contents of @file.
+ *
+ * Thread safety: this function may be called from any thread.
+ *
+ * Returns: (transfer full) (nullable) (type GObject): the shared index
+ *   or %NULL if it must be loaded by the caller.
+ *
+ * Since: 44
+ */
+gpointer
+ide_index_registry_lookup (IdeIndexRegistry *self,
+                           GType             index_type,
+                           GFile            *file,
+                           const char       *qualifier)
+{
+  IndexEntry *entry;
+  gpointer ret = NULL;
+  IndexKey key;
+
+  g_return_val_if_fail (IDE_IS_INDEX_REGISTRY (self), NULL);
+  g_return_val_if_fail (g_type_is_a (index_type, G_TYPE_OBJECT), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  if (!index_key_init (&key, index_type, file, qualifier))
+    return NULL;
+
+  g_mutex_lock (&self->mutex);
+
+  if ((entry = g_hash_table_lookup (self->entries, &key)) &&
+      !(ret = g_weak_ref_get (&entry->index)))
+    g_hash_table_remove (self->entries, &key);
+
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+static gboolean
+index_entry_is_dead (gpointer key,
+                     gpointer value,
+                     gpointer user_data)
+{
+  IndexEntry *entry = value;
+  g_autoptr(GObject) object = g_weak_ref_get (&entry->index);
+
+  return object == NULL;
+}
+
+/**
+ * ide_index_registry_insert:
+ * @self: a #IdeIndexRegistry
+ * @file: the file @index was loaded from
+ * @qualifier: (nullable): the qualifier used with ide_index_registry_lookup()
+ * @index: (type GObject): a loaded index
+ *
+ * Makes @index available to other callers of ide_index_registry_lookup().
+ *
+ * If another thread registered the same file in the meantime, that index
+ * is returned instead and @index should be discarded, so that only one
+ * copy stays alive.
+ *
+ * The registry does not keep @index alive.
+ *
+ * Thread safety: this function may be called from any thread.
+ *
+ * Returns: (transfer full) (type GObject): the index to use
+ *
+ * Since: 44
+ */
+gpointer
+ide_index_registry_insert (IdeIndexRegistry *self,
+                           GFile            *file,
+                           const char       *qualifier,
+                           gpointer          index)
+{
+  IndexEntry *entry;
+  gpointer ret = NULL;
+  IndexKey key;
+
+  g_return_val_if_fail (IDE_IS_INDEX_REGISTRY (self), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (G_IS_OBJECT (index), NULL);
+
+  /* If the file changed while it was being loaded we would register the old
+   * contents under the new identity. Callers load from files that are
+   * replaced atomically, so the window is a stat() call wide.
+   */
+  if (!index_key_init (&key, G_OBJECT_TYPE (index), file, qualifier))
+    return g_object_ref (index);
+
+  g_mutex_lock (&self->mutex);
+
+  if ((entry = g_hash_table_lookup (self->entries, &key)))
+    ret = g_weak_ref_get (&entry->index);
+
+  if (ret == NULL)
+    {
+      g_hash_table_foreach_remove (self->entries, index_entry_is_dead, NULL);
+
+      entry = g_slice_new0 (IndexEntry);
+      entry->key = key;
+      entry->key.qualifier = g_strdup (qualifier);
+      g_weak_ref_init (&entry->index, index);
+      g_hash_table_insert (self->entries, &entry->key, entry);
+
+      ret = g_object_ref (index);
+    }
+
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+/**
+ * ide_index_registry_add_prebuilt_dir:
+ * @self: a #IdeIndexRegistry
+ * @directory: a directory containing prebuilt indexes
+ *
+ * Adds @directory to the places searched by ide_index_registry_find_prebuilt().
+ *
+ * Directories added later take priority over earlier ones, which in turn
+ * take priority over the "indexes" directories within the user and system
+ * data directories.
+ *
+ * Since: 44
+ */
+void
+ide_index_registry_add_prebuilt_dir (IdeIndexRegistry *self,
+                                     const char       *directory)
+{
+  g_return_if_fail (IDE_IS_INDEX_REGISTRY (self));
+  g_return_if_fail (directory != NULL);
+
+  g_mutex_lock (&self->mutex);
+  g_ptr_array_insert (self->prebuilt_dirs, 0, g_strdup (directory));
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * ide_index_registry_find_prebuilt:
+ * @self: a #IdeIndexRegistry
+ * @kind: the kind of index, such as "code-index" or "ctags"
+ * @name: the name of the SDK the index was built for, such as the
+ *   identifier of an #IdeRuntime
+ *
+ * Locates an index which was built ahead of time for the headers of an
+ * installed SDK, found at "@kind/@name" below one of the prebuilt
+ * directories. Any ":" in @name is treated as a directory separator so
+ * that "flatpak:org.gnome.Sdk/x86_64/44" maps to nested directories.
+ *
+ * Thread safety: this function may be called from any thread.
+ *
+ * Returns: (transfer full) (nullable): a #GFile or %NULL
+ *
+ * Since: 44
+ */
+GFile *
+ide_index_registry_find_prebuilt (IdeIndexRegistry *self,
+                                  const char       *kind,
+                                  const char       *name)
+{
+  g_autofree char *relative = NULL;
+  GFile *ret = NULL;
+
+  g_return_val_if_fail (IDE_IS_INDEX_REGISTRY (self), NULL);
+  g_return_val_if_fail (kind != NULL, NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+
+  if (strstr (name, "..") != NULL)
+    return NULL;
+
+  relative = g_strdelimit (g_strdup (name), ":", G_DIR_SEPARATOR);
+
+  g_mutex_lock (&self->mutex);
+
+  for (guint i = 0; i < self->prebuilt_dirs->len; i++)
+    {
+      const char *dir = g_ptr_array_index (self->prebuilt_dirs, i);
+      g_autofree char *path = g_build_filename (dir, kind, relative, NULL);
+
+      if (g_file_test (path, G_FILE_TEST_EXISTS))
+        {
+          ret = g_file_new_for_path (path);
+          break;
+        }
+    }
+
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
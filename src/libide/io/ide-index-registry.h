@@ -0,0 +1,56 @@
+/* ide-index-registry.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#if !defined (IDE_IO_INSIDE) && !defined (IDE_IO_COMPILATION)
+# error "Only <libide-io.h> can be included directly."
+#endif
+
+#include <libide-core.h>
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_INDEX_REGISTRY (ide_index_registry_get_type())
+
+IDE_AVAILABLE_IN_44
+G_DECLARE_FINAL_TYPE (IdeIndexRegistry, ide_index_registry, IDE, INDEX_REGISTRY, GObject)
+
+IDE_AVAILABLE_IN_44
+IdeIndexRegistry *ide_index_registry_new              (void);
+IDE_AVAILABLE_IN_44
+gpointer          ide_index_registry_lookup           (IdeIndexRegistry *self,
+                                                       GType             index_type,
+                                                       GFile            *file,
+                                                       const char       *qualifier);
+IDE_AVAILABLE_IN_44
+gpointer          ide_index_registry_insert           (IdeIndexRegistry *self,
+                                                       GFile            *file,
+                                                       const char       *qualifier,
+                                                       gpointer          index);
+IDE_AVAILABLE_IN_44
+void              ide_index_registry_add_prebuilt_dir (IdeIndexRegistry *self,
+                                                       const char       *directory);
+IDE_AVAILABLE_IN_44
+GFile            *ide_index_registry_find_prebuilt    (IdeIndexRegistry *self,
+                                                       const char       *kind,
+                                                       const char       *name);
+
+G_END_DECLS
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "ide-line-reader.h"
+#include "ide-text-scan-private.h"
 
 void
 ide_line_reader_init (IdeLineReader *reader,
@@ -67,6 +68,7 @@ ide_line_reader_next (IdeLineReader *reader,
                       gsize         *length)
 {
   gchar *ret = NULL;
+  const char *eol;
 
   g_assert (reader);
   g_assert (length != NULL);
@@ -78,21 +80,20 @@ ide_line_reader_next (IdeLineReader *reader,
     }
 
   ret = &reader->contents [reader->pos];
+  eol = _ide_text_find_byte (ret, reader->length - reader->pos, '\n');
 
-  for (; reader->pos < reader->length; reader->pos++)
+  if (eol != NULL)
     {
-      if (reader->contents [reader->pos] == '\n')
-        {
-          *length = &reader->contents [reader->pos] - ret;
-          /* Ingore the \r in \r\n if provided */
-          if (*length > 0 && reader->pos > 0 && reader->contents [reader->pos - 1] == '\r')
-            (*length)--;
-          reader->pos++;
-          return ret;
-        }
+      *length = eol - ret;
+      /* Ignore the \r in \r\n if provided */
+      if (*length > 0 && eol[-1] == '\r')
+        (*length)--;
+      reader->pos = eol - reader->contents + 1;
+      return ret;
     }
 
-  *length = &reader->contents [reader->pos] - ret;
+  *length = reader->length - reader->pos;
+  reader->pos = reader->length;
 
   return ret;
 }
@@ -26,7 +26,9 @@
 #include <libide-threading.h>
 #include <string.h>
 
+#include "ide-persistent-map.h"
 #include "ide-persistent-map-builder.h"
+#include "ide-persistent-map-private.h"
 
 typedef struct
 {
@@ -49,6 +51,9 @@ typedef struct
 
   /* Where to write the file */
   GFile *destination;
+
+  /* If every value is a "(uuuu)" record, so we can write version 3 */
+  guint fixed_width : 1;
 } BuildState;
 
 typedef struct
@@ -107,6 +112,9 @@ ide_persistent_map_builder_insert (IdePersistentMapBuilder *self,
 
   local_value = g_variant_ref_sink (value);
 
+  if (!g_variant_is_of_type (local_value, G_VARIANT_TYPE (IDE_PERSISTENT_MAP_RECORD_TYPE)))
+    self->state->fixed_width = FALSE;
+
   if (0 != (value_index = GPOINTER_TO_UINT (g_hash_table_lookup (self->state->keys_hash, key))))
     {
       if (replace)
@@ -158,6 +166,169 @@ compare_keys (KVPair      *a,
   return g_strcmp0 (keys + a->key, keys + b->key);
 }
 
+static guint
+eytzinger_order (const KVPair *sorted,
+                 KVPair       *out,
+                 guint         n,
+                 guint         i,
+                 guint         k)
+{
+  /* In-order walk of the implicit tree rooted at 1-based slot @k */
+  if (k <= n)
+    {
+      i = eytzinger_order (sorted, out, n, i, 2 * k);
+      out[k - 1] = sorted[i++];
+      i = eytzinger_order (sorted, out, n, i, 2 * k + 1);
+    }
+
+  return i;
+}
+
+static inline void
+append_padding (GByteArray *bytes)
+{
+  static const guint8 zero[8];
+
+  if (bytes->len % 8 != 0)
+    g_byte_array_append (bytes, zero, 8 - (bytes->len % 8));
+}
+
+static GBytes *
+build_state_serialize_v3 (BuildState *state)
+{
+  g_autoptr(GVariant) metadata = NULL;
+  g_autoptr(GArray) ordered = NULL;
+  IdePersistentMapHeader header = {0};
+  const KVPair *sorted;
+  const gchar *keys;
+  const gchar *first;
+  const gchar *last;
+  GByteArray *bytes;
+  guint common = 0;
+  guint n;
+
+  g_assert (state != NULL);
+  g_assert (state->fixed_width);
+  g_assert (state->kvpairs->len > 0);
+
+  keys = (const gchar *)state->keys->data;
+  sorted = &g_array_index (state->kvpairs, KVPair, 0);
+  n = state->kvpairs->len;
+
+  /* Keys are sorted, so the prefix shared by the first and last key is
+   * shared by all of them. Skipping it keeps the prefix table useful for
+   * keys such as "c:@F@..." which would otherwise all look alike.
+   */
+  first = keys + sorted[0].key;
+  last = keys + sorted[n - 1].key;
+  while (first[common] != 0 && first[common] == last[common])
+    common++;
+
+  ordered = g_array_sized_new (FALSE, FALSE, sizeof (KVPair), n);
+  g_array_set_size (ordered, n);
+  eytzinger_order (sorted, &g_array_index (ordered, KVPair, 0), n, 0, 1);
+
+  metadata = g_variant_ref_sink (g_variant_dict_end (state->metadata));
+
+  bytes = g_byte_array_sized_new (sizeof header + (n * (4 + 4 + sizeof (IdePersistentMapRecord))) + state->keys->len);
+  g_byte_array_append (bytes, (const guint8 *)&header, sizeof header);
+
+  header.prefixes_offset = bytes->len;
+  for (guint i = 0; i < n; i++)
+    {
+      const KVPair *pair = &g_array_index (ordered, KVPair, i);
+      guint32 prefix = _ide_persistent_map_key_prefix (keys + pair->key + common);
+
+      g_byte_array_append (bytes, (const guint8 *)&prefix, sizeof prefix);
+    }
+  append_padding (bytes);
+
+  header.key_offsets_offset = bytes->len;
+  for (guint i = 0; i < n; i++)
+    {
+      const KVPair *pair = &g_array_index (ordered, KVPair, i);
+
+      g_byte_array_append (bytes, (const guint8 *)&pair->key, sizeof pair->key);
+    }
+  append_padding (bytes);
+
+  header.records_offset = bytes->len;
+  for (guint i = 0; i < n; i++)
+    {
+      const KVPair *pair = &g_array_index (ordered, KVPair, i);
+      GVariant *value = g_ptr_array_index (state->values, pair->value);
+      IdePersistentMapRecord record;
+
+      g_variant_get (value,
+                     IDE_PERSISTENT_MAP_RECORD_TYPE,
+                     &record.values[0],
+                     &record.values[1],
+                     &record.values[2],
+                     &record.values[3]);
+      g_byte_array_append (bytes, (const guint8 *)&record, sizeof record);
+    }
+
+  header.strings_offset = bytes->len;
+  header.strings_len = state->keys->len;
+  g_byte_array_append (bytes, state->keys->data, state->keys->len);
+  append_padding (bytes);
+
+  header.metadata_offset = bytes->len;
+  header.metadata_len = g_variant_get_size (metadata);
+  g_byte_array_append (bytes, g_variant_get_data (metadata), g_variant_get_size (metadata));
+
+  memcpy (header.magic, IDE_PERSISTENT_MAP_MAGIC, sizeof IDE_PERSISTENT_MAP_MAGIC);
+  header.version = IDE_PERSISTENT_MAP_V3;
+  header.byte_order = G_BYTE_ORDER;
+  header.n_records = n;
+  header.common_prefix_len = common;
+  memcpy (bytes->data, &header, sizeof header);
+
+  return g_byte_array_free_to_bytes (bytes);
+}
+
+static GBytes *
+build_state_serialize_v2 (BuildState *state)
+{
+  g_autoptr(GVariant) data = NULL;
+  GVariantDict dict;
+  GVariant *keys;
+  GVariant *values;
+  GVariant *kvpairs;
+  GVariant *metadata;
+
+  g_assert (state != NULL);
+
+  g_variant_dict_init (&dict, NULL);
+
+  keys = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                    state->keys->data,
+                                    state->keys->len,
+                                    sizeof (guint8));
+
+  values = g_variant_new_array (NULL,
+                                (GVariant * const *)(gpointer)state->values->pdata,
+                                state->values->len);
+
+  kvpairs = g_variant_new_fixed_array (G_VARIANT_TYPE ("(uu)"),
+                                       state->kvpairs->data,
+                                       state->kvpairs->len,
+                                       sizeof (KVPair));
+
+  metadata = g_variant_dict_end (state->metadata);
+
+  g_variant_dict_insert_value (&dict, "keys", keys);
+  g_variant_dict_insert_value (&dict, "values", values);
+  g_variant_dict_insert_value (&dict, "kvpairs", kvpairs);
+  g_variant_dict_insert_value (&dict, "metadata", metadata);
+  g_variant_dict_insert (&dict, "version", "i", 2);
+  g_variant_dict_insert (&dict, "byte-order", "i", G_BYTE_ORDER);
+
+  data = g_variant_take_ref (g_variant_dict_end (&dict));
+
+  return g_variant_get_data_as_bytes (data);
+}
+
 static void
 ide_persistent_map_builder_write_worker (IdeTask      *task,
                                          gpointer      source_object,
@@ -166,12 +337,7 @@ ide_persistent_map_builder_write_worker (IdeTask      *task,
 {
   BuildState *state = task_data;
   g_autoptr(GError) error = NULL;
-  g_autoptr(GVariant) data = NULL;
-  GVariantDict dict;
-  GVariant *keys;
-  GVariant *values;
-  GVariant *kvpairs;
-  GVariant *metadata;
+  g_autoptr(GBytes) bytes = NULL;
 
   g_assert (IDE_IS_TASK (task));
   g_assert (IDE_IS_PERSISTENT_MAP_BUILDER (source_object));
@@ -187,7 +353,7 @@ ide_persistent_map_builder_write_worker (IdeTask      *task,
   if (ide_task_return_error_if_cancelled (task))
     return;
 
-  if (state->keys->len == 0)
+  if (state->keys->len == 0 || state->kvpairs->len == 0)
     {
       g_autofree gchar *path = g_file_get_path (state->destination);
 
@@ -199,43 +365,21 @@ ide_persistent_map_builder_write_worker (IdeTask      *task,
       return;
     }
 
-  g_variant_dict_init (&dict, NULL);
-
-  keys = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
-                                    state->keys->data,
-                                    state->keys->len,
-                                    sizeof (guint8));
-
-  values = g_variant_new_array (NULL,
-                                (GVariant * const *)(gpointer)state->values->pdata,
-                                state->values->len);
-
   g_array_sort_with_data (state->kvpairs,
                           (GCompareDataFunc)compare_keys,
                           state->keys->data);
 
-  kvpairs = g_variant_new_fixed_array (G_VARIANT_TYPE ("(uu)"),
-                                       state->kvpairs->data,
-                                       state->kvpairs->len,
-                                       sizeof (KVPair));
-
-  metadata = g_variant_dict_end (state->metadata);
-
-  g_variant_dict_insert_value (&dict, "keys", keys);
-  g_variant_dict_insert_value (&dict, "values", values);
-  g_variant_dict_insert_value (&dict, "kvpairs", kvpairs);
-  g_variant_dict_insert_value (&dict, "metadata", metadata);
-  g_variant_dict_insert (&dict, "version", "i", 2);
-  g_variant_dict_insert (&dict, "byte-order", "i", G_BYTE_ORDER);
-
-  data = g_variant_take_ref (g_variant_dict_end (&dict));
+  if (state->fixed_width)
+    bytes = build_state_serialize_v3 (state);
+  else
+    bytes = build_state_serialize_v2 (state);
 
   if (ide_task_return_error_if_cancelled (task))
     return;
 
   if (g_file_replace_contents (state->destination,
-                               g_variant_get_data (data),
-                               g_variant_get_size (data),
+                               g_bytes_get_data (bytes, NULL),
+                               g_bytes_get_size (bytes),
                                NULL,
                                FALSE,
                                G_FILE_CREATE_NONE,
@@ -342,6 +486,7 @@ ide_persistent_map_builder_init (IdePersistentMapBuilder *self)
   self->state->values = g_ptr_array_new_with_free_func ((GDestroyNotify)g_variant_unref);
   self->state->kvpairs = g_array_new (FALSE, FALSE, sizeof (KVPair));
   self->state->metadata = g_variant_dict_new (NULL);
+  self->state->fixed_width = TRUE;
 }
 
 static void
@@ -0,0 +1,87 @@
+/* ide-persistent-map-private.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Version 3 of the persistent map is a flat file rather than a GVariant so
+ * that lookups can be done directly against the mapped file. It is only used
+ * when every value is a "(uuuu)" record, which is what the code-index stores.
+ *
+ * All sections start on an 8-byte boundary and are, in order:
+ *
+ *   prefixes[n_records]     guint32, first 4 bytes after the common prefix
+ *   key_offsets[n_records]  guint32, offset of the key within strings
+ *   records[n_records]      IdePersistentMapRecord
+ *   strings[strings_len]    Nil-terminated keys
+ *   metadata[metadata_len]  serialized a{sv}
+ *
+ * The first three arrays are in Eytzinger (breadth-first) order so that the
+ * search walks the prefix table from the front, keeping the hot levels of
+ * the tree within a few cache lines.
+ */
+
+#define IDE_PERSISTENT_MAP_MAGIC       "IDEPMAP"
+#define IDE_PERSISTENT_MAP_V3          3
+#define IDE_PERSISTENT_MAP_RECORD_TYPE "(uuuu)"
+
+typedef struct
+{
+  char    magic[8];
+  guint32 version;
+  guint32 byte_order;
+  guint32 n_records;
+  guint32 common_prefix_len;
+  guint32 prefixes_offset;
+  guint32 key_offsets_offset;
+  guint32 records_offset;
+  guint32 strings_offset;
+  guint32 strings_len;
+  guint32 metadata_offset;
+  guint32 metadata_len;
+  guint32 reserved[3];
+} IdePersistentMapHeader;
+
+G_STATIC_ASSERT (sizeof (IdePersistentMapHeader) == 64);
+
+/* Packs the first four bytes of @key big-endian so that comparing two
+ * prefixes as integers orders the same way as strcmp() would.
+ */
+static inline guint32
+_ide_persistent_map_key_prefix (const char *key)
+{
+  const guchar *p = (const guchar *)key;
+  guint32 prefix = 0;
+
+  for (guint i = 0; i < 4; i++)
+    {
+      prefix <<= 8;
+
+      if (*p != 0)
+        prefix |= *p++;
+    }
+
+  return prefix;
+}
+
+G_END_DECLS
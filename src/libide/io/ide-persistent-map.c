@@ -24,8 +24,10 @@
 #include "config.h"
 
 #include <libide-threading.h>
+#include <string.h>
 
 #include "ide-persistent-map.h"
+#include "ide-persistent-map-private.h"
 
 typedef struct
 {
@@ -55,59 +57,169 @@ struct _IdePersistentMap
 
   gint32             byte_order;
 
+  /* Fixed-width values, either from a version 3 file or from a version 2
+   * file whose values happen to be "(uuuu)" in our byte order.
+   */
+  const IdePersistentMapRecord *records;
+
+  gsize              n_records;
+
+  /* Version 3 only, all in Eytzinger order */
+  GBytes            *swapped;
+  const guint32     *prefixes;
+  const guint32     *key_offsets;
+  const gchar       *strings;
+  const gchar       *common_prefix;
+  gsize              common_prefix_len;
+
+  guint              version;
+
   guint              load_called : 1;
   guint              loaded : 1;
 };
 
 G_STATIC_ASSERT (sizeof (KVPair) == 8);
+G_STATIC_ASSERT (sizeof (IdePersistentMapRecord) == 16);
 
 G_DEFINE_FINAL_TYPE (IdePersistentMap, ide_persistent_map, G_TYPE_OBJECT)
 
+static inline gboolean
+section_is_valid (gsize   length,
+                  guint32 offset,
+                  guint64 size)
+{
+  return offset % 8 == 0 && offset >= sizeof (IdePersistentMapHeader) && (guint64)offset + size <= length;
+}
+
 static void
-ide_persistent_map_load_file_worker (IdeTask      *task,
-                                     gpointer      source_object,
-                                     gpointer      task_data,
-                                     GCancellable *cancellable)
+swap_guint32s (guint32 *data,
+               gsize    n_elements)
+{
+  for (gsize i = 0; i < n_elements; i++)
+    data[i] = GUINT32_SWAP_LE_BE (data[i]);
+}
+
+static gboolean
+ide_persistent_map_load_v3 (IdePersistentMap  *self,
+                            GMappedFile       *mapped_file,
+                            GError           **error)
 {
-  IdePersistentMap *self = source_object;
-  GFile *file = task_data;
-  g_autofree gchar *path = NULL;
-  g_autoptr(GMappedFile) mapped_file = NULL;
-  g_autoptr(GVariant) data = NULL;
-  g_autoptr(GVariant) keys = NULL;
-  g_autoptr(GVariant) values = NULL;
   g_autoptr(GVariant) metadata = NULL;
-  g_autoptr(GVariant) kvpairs = NULL;
-  g_autoptr(GError) error = NULL;
-  g_autoptr(GVariantDict) dict = NULL;
-  gint32 version;
-  gsize n_elements;
+  g_autoptr(GBytes) swapped = NULL;
+  IdePersistentMapHeader header;
+  const guint32 *key_offsets;
+  const guint8 *contents;
+  gboolean foreign;
+  gsize length;
 
-  g_assert (IDE_IS_TASK (task));
   g_assert (IDE_IS_PERSISTENT_MAP (self));
-  g_assert (G_IS_FILE (file));
-  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
-  g_assert (self->loaded == FALSE);
+  g_assert (mapped_file != NULL);
 
-  self->loaded = TRUE;
+  contents = (const guint8 *)g_mapped_file_get_contents (mapped_file);
+  length = g_mapped_file_get_length (mapped_file);
 
-  if (!g_file_is_native (file) || NULL == (path = g_file_get_path (file)))
+  g_assert (length >= sizeof header);
+
+  memcpy (&header, contents, sizeof header);
+
+  if ((foreign = header.byte_order != G_BYTE_ORDER))
+    swap_guint32s (&header.version, (sizeof header - G_STRUCT_OFFSET (IdePersistentMapHeader, version)) / 4);
+
+  if (header.version != IDE_PERSISTENT_MAP_V3 ||
+      (header.byte_order != G_LITTLE_ENDIAN && header.byte_order != G_BIG_ENDIAN) ||
+      header.n_records == 0 ||
+      header.strings_len == 0 ||
+      header.common_prefix_len >= header.strings_len ||
+      !section_is_valid (length, header.prefixes_offset, (guint64)header.n_records * 4) ||
+      !section_is_valid (length, header.key_offsets_offset, (guint64)header.n_records * 4) ||
+      !section_is_valid (length, header.records_offset, (guint64)header.n_records * sizeof (IdePersistentMapRecord)) ||
+      !section_is_valid (length, header.strings_offset, header.strings_len) ||
+      !section_is_valid (length, header.metadata_offset, header.metadata_len) ||
+      contents[header.strings_offset + header.strings_len - 1] != 0)
     {
-      ide_task_return_new_error (task,
-                                 G_IO_ERROR,
-                                 G_IO_ERROR_INVALID_FILENAME,
-                                 "Index must be a local file");
-      return;
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVAL,
+                   "Invalid persistent map header");
+      return FALSE;
     }
 
-  mapped_file = g_mapped_file_new (path, FALSE, &error);
+  /* Foreign byte-order files are rare (shared home directories), so just
+   * take a private copy we can swap rather than slowing down lookups.
+   */
+  if (foreign)
+    {
+      guint8 *copy = g_memdup2 (contents, length);
 
-  if (mapped_file == NULL)
+      swap_guint32s ((guint32 *)(gpointer)(copy + header.prefixes_offset), header.n_records);
+      swap_guint32s ((guint32 *)(gpointer)(copy + header.key_offsets_offset), header.n_records);
+      swap_guint32s ((guint32 *)(gpointer)(copy + header.records_offset), header.n_records * 4);
+
+      swapped = g_bytes_new_take (copy, length);
+      contents = copy;
+    }
+
+  /* Lookups skip the common prefix of each key, so make sure that
+   * can never step past the strings section.
+   */
+  key_offsets = (const guint32 *)(gconstpointer)(contents + header.key_offsets_offset);
+  for (guint i = 0; i < header.n_records; i++)
     {
-      ide_task_return_error (task, g_steal_pointer (&error));
-      return;
+      if ((guint64)key_offsets[i] + header.common_prefix_len >= header.strings_len)
+        {
+          g_set_error (error,
+                       G_IO_ERROR,
+                       G_IO_ERROR_INVAL,
+                       "Invalid key offset in persistent map");
+          return FALSE;
+        }
+    }
+
+  metadata = g_variant_new_from_data (G_VARIANT_TYPE_VARDICT,
+                                      contents + header.metadata_offset,
+                                      header.metadata_len,
+                                      FALSE, NULL, NULL);
+  g_variant_take_ref (metadata);
+
+  if (foreign)
+    {
+      GVariant *native = g_variant_byteswap (metadata);
+
+      g_variant_unref (metadata);
+      metadata = native;
     }
 
+  self->swapped = g_steal_pointer (&swapped);
+  self->prefixes = (const guint32 *)(gconstpointer)(contents + header.prefixes_offset);
+  self->key_offsets = key_offsets;
+  self->records = (const IdePersistentMapRecord *)(gconstpointer)(contents + header.records_offset);
+  self->strings = (const gchar *)(contents + header.strings_offset);
+  self->common_prefix = &self->strings[key_offsets[0]];
+  self->common_prefix_len = header.common_prefix_len;
+  self->n_records = header.n_records;
+  self->metadata = g_variant_dict_new (metadata);
+  self->version = IDE_PERSISTENT_MAP_V3;
+
+  return TRUE;
+}
+
+static gboolean
+ide_persistent_map_load_v2 (IdePersistentMap  *self,
+                            GMappedFile       *mapped_file,
+                            GError           **error)
+{
+  g_autoptr(GVariant) data = NULL;
+  g_autoptr(GVariant) keys = NULL;
+  g_autoptr(GVariant) values = NULL;
+  g_autoptr(GVariant) metadata = NULL;
+  g_autoptr(GVariant) kvpairs = NULL;
+  g_autoptr(GVariantDict) dict = NULL;
+  gint32 version;
+  gsize n_elements;
+
+  g_assert (IDE_IS_PERSISTENT_MAP (self));
+  g_assert (mapped_file != NULL);
+
   data = g_variant_new_from_data (G_VARIANT_TYPE_VARDICT,
                                   g_mapped_file_get_contents (mapped_file),
                                   g_mapped_file_get_length (mapped_file),
@@ -115,11 +227,11 @@ ide_persistent_map_load_file_worker (IdeTask      *task,
 
   if (data == NULL)
     {
-      ide_task_return_new_error (task,
-                                 G_IO_ERROR,
-                                 G_IO_ERROR_INVAL,
-                                 "Failed to parse GVariant");
-      return;
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVAL,
+                   "Failed to parse GVariant");
+      return FALSE;
     }
 
   g_variant_take_ref (data);
@@ -128,12 +240,12 @@ ide_persistent_map_load_file_worker (IdeTask      *task,
 
   if (!g_variant_dict_lookup (dict, "version", "i", &version) || version != 2)
     {
-      ide_task_return_new_error (task,
-                                 G_IO_ERROR,
-                                 G_IO_ERROR_INVAL,
-                                 "Version mismatch in gvariant. Got %d, expected 1",
-                                 version);
-      return;
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVAL,
+                   "Version mismatch in gvariant. Got %d, expected 1",
+                   version);
+      return FALSE;
     }
 
   keys = g_variant_dict_lookup_value (dict, "keys", G_VARIANT_TYPE_ARRAY);
@@ -146,22 +258,29 @@ ide_persistent_map_load_file_worker (IdeTask      *task,
 
   if (keys == NULL || values == NULL || kvpairs == NULL || metadata == NULL || !self->byte_order)
     {
-      ide_task_return_new_error (task,
-                                 G_IO_ERROR,
-                                 G_IO_ERROR_INVAL,
-                                 "Invalid GVariant index");
-      return;
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVAL,
+                   "Invalid GVariant index");
+      return FALSE;
     }
 
   self->keys = g_variant_get_fixed_array (keys, &n_elements, sizeof (guint8));
   self->kvpairs = g_variant_get_fixed_array (kvpairs, &self->n_kvpairs, sizeof (KVPair));
 
-  self->mapped_file = g_steal_pointer (&mapped_file);
+  /* Older code-index files already store "(uuuu)" values, which are laid
+   * out exactly like a record, so they can be borrowed too.
+   */
+  if (self->byte_order == G_BYTE_ORDER &&
+      g_variant_is_of_type (values, G_VARIANT_TYPE ("a" IDE_PERSISTENT_MAP_RECORD_TYPE)))
+    self->records = g_variant_get_fixed_array (values, &self->n_records, sizeof (IdePersistentMapRecord));
+
   self->data = g_steal_pointer (&data);
   self->keys_var = g_steal_pointer (&keys);
   self->values = g_steal_pointer (&values);
   self->kvpairs_var = g_steal_pointer (&kvpairs);
   self->metadata = g_variant_dict_new (metadata);
+  self->version = 2;
 
   g_assert (!g_variant_is_floating (self->data));
   g_assert (!g_variant_is_floating (self->keys_var));
@@ -171,6 +290,63 @@ ide_persistent_map_load_file_worker (IdeTask      *task,
   g_assert (self->kvpairs != NULL);
   g_assert (self->metadata != NULL);
 
+  return TRUE;
+}
+
+static void
+ide_persistent_map_load_file_worker (IdeTask      *task,
+                                     gpointer      source_object,
+                                     gpointer      task_data,
+                                     GCancellable *cancellable)
+{
+  IdePersistentMap *self = source_object;
+  GFile *file = task_data;
+  g_autofree gchar *path = NULL;
+  g_autoptr(GMappedFile) mapped_file = NULL;
+  g_autoptr(GError) error = NULL;
+  gboolean ret;
+
+  g_assert (IDE_IS_TASK (task));
+  g_assert (IDE_IS_PERSISTENT_MAP (self));
+  g_assert (G_IS_FILE (file));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+  g_assert (self->loaded == FALSE);
+
+  self->loaded = TRUE;
+
+  if (!g_file_is_native (file) || NULL == (path = g_file_get_path (file)))
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_INVALID_FILENAME,
+                                 "Index must be a local file");
+      return;
+    }
+
+  mapped_file = g_mapped_file_new (path, FALSE, &error);
+
+  if (mapped_file == NULL)
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  if (g_mapped_file_get_length (mapped_file) >= sizeof (IdePersistentMapHeader) &&
+      memcmp (g_mapped_file_get_contents (mapped_file),
+              IDE_PERSISTENT_MAP_MAGIC,
+              sizeof IDE_PERSISTENT_MAP_MAGIC) == 0)
+    ret = ide_persistent_map_load_v3 (self, mapped_file, &error);
+  else
+    ret = ide_persistent_map_load_v2 (self, mapped_file, &error);
+
+  if (!ret)
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  self->mapped_file = g_steal_pointer (&mapped_file);
+
   ide_task_return_boolean (task, TRUE);
 }
 
@@ -241,31 +417,19 @@ ide_persistent_map_load_file_finish (IdePersistentMap  *self,
   return ide_task_propagate_boolean (IDE_TASK (result), error);
 }
 
-/**
- * ide_persistent_map_lookup_value:
- * @self: An #IdePersistentMap instance.
- * @key: key to lookup value
- *
- * Returns: (transfer full) : value associalted with @key.
- */
-GVariant *
-ide_persistent_map_lookup_value (IdePersistentMap *self,
-                                 const gchar      *key)
+static gint64
+ide_persistent_map_lookup_v2 (IdePersistentMap *self,
+                              const gchar      *key)
 {
-  g_autoptr(GVariant) value = NULL;
   gint64 l;
   gint64 r;
 
-  g_return_val_if_fail (IDE_IS_PERSISTENT_MAP (self), NULL);
-  g_return_val_if_fail (self->loaded, NULL);
-  g_return_val_if_fail (self != NULL, NULL);
-  g_return_val_if_fail (self->kvpairs != NULL, NULL);
-  g_return_val_if_fail (self->keys != NULL, NULL);
-  g_return_val_if_fail (self->values != NULL, NULL);
-  g_return_val_if_fail (self->n_kvpairs < G_MAXINT64, NULL);
+  g_assert (IDE_IS_PERSISTENT_MAP (self));
+  g_assert (self->version == 2);
+  g_assert (key != NULL);
 
   if (self->n_kvpairs == 0)
-    return NULL;
+    return -1;
 
   /* unsigned long to signed long */
   r = (gint64)self->n_kvpairs - 1;
@@ -289,19 +453,150 @@ ide_persistent_map_lookup_value (IdePersistentMap *self,
         r = m - 1;
       else if (cmp > 0)
         l = m + 1;
+      else
+        return self->kvpairs [m].value;
+    }
+
+  return -1;
+}
+
+static const IdePersistentMapRecord *
+ide_persistent_map_lookup_v3 (IdePersistentMap *self,
+                              const gchar      *key)
+{
+  const guint32 *prefixes = self->prefixes;
+  gsize n_records = self->n_records;
+  gsize common = self->common_prefix_len;
+  guint32 prefix;
+  gsize k = 1;
+
+  g_assert (IDE_IS_PERSISTENT_MAP (self));
+  g_assert (self->version == IDE_PERSISTENT_MAP_V3);
+  g_assert (key != NULL);
+
+  if (strncmp (key, self->common_prefix, common) != 0)
+    return NULL;
+
+  key += common;
+  prefix = _ide_persistent_map_key_prefix (key);
+
+  /* Walk the implicit tree, only touching the key strings when the
+   * packed prefixes are equal.
+   */
+  while (k <= n_records)
+    {
+      guint32 p = prefixes[k - 1];
+
+#if defined(__GNUC__)
+      /* The sixteen descendants four levels down share a cache line */
+      __builtin_prefetch (&prefixes[16 * k - 1]);
+#endif
+
+      if (prefix < p)
+        k = 2 * k;
+      else if (prefix > p)
+        k = 2 * k + 1;
       else
         {
-          value = g_variant_get_child_value (self->values, self->kvpairs [m].value);
-          break;
+          int cmp = strcmp (key, &self->strings[self->key_offsets[k - 1] + common]);
+
+          if (cmp == 0)
+            return &self->records[k - 1];
+
+          k = 2 * k + (cmp > 0);
         }
     }
 
-  if (value != NULL && self->byte_order != G_BYTE_ORDER)
+  return NULL;
+}
+
+/**
+ * ide_persistent_map_lookup_value:
+ * @self: An #IdePersistentMap instance.
+ * @key: key to lookup value
+ *
+ * Returns: (transfer full) : value associalted with @key.
+ */
+GVariant *
+ide_persistent_map_lookup_value (IdePersistentMap *self,
+                                 const gchar      *key)
+{
+  g_autoptr(GVariant) value = NULL;
+  gint64 index;
+
+  g_return_val_if_fail (IDE_IS_PERSISTENT_MAP (self), NULL);
+  g_return_val_if_fail (self->loaded, NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+  g_return_val_if_fail (self->version != 0, NULL);
+
+  if (self->version == IDE_PERSISTENT_MAP_V3)
+    {
+      const IdePersistentMapRecord *record;
+
+      if (!(record = ide_persistent_map_lookup_v3 (self, key)))
+        return NULL;
+
+      return g_variant_ref_sink (g_variant_new (IDE_PERSISTENT_MAP_RECORD_TYPE,
+                                                record->values[0],
+                                                record->values[1],
+                                                record->values[2],
+                                                record->values[3]));
+    }
+
+  g_return_val_if_fail (self->kvpairs != NULL, NULL);
+  g_return_val_if_fail (self->keys != NULL, NULL);
+  g_return_val_if_fail (self->values != NULL, NULL);
+  g_return_val_if_fail (self->n_kvpairs < G_MAXINT64, NULL);
+
+  if ((index = ide_persistent_map_lookup_v2 (self, key)) < 0)
+    return NULL;
+
+  value = g_variant_get_child_value (self->values, index);
+
+  if (self->byte_order != G_BYTE_ORDER)
     return g_variant_byteswap (value);
 
   return g_steal_pointer (&value);
 }
 
+/**
+ * ide_persistent_map_lookup_record:
+ * @self: An #IdePersistentMap instance.
+ * @key: key to lookup value
+ *
+ * Looks up a fixed-width "(uuuu)" value without allocating, such as the
+ * symbol locations stored by the code-index.
+ *
+ * The result points into the mapped index and is valid for the lifetime
+ * of @self.
+ *
+ * Returns: (transfer none) (nullable): the record for @key, or %NULL if
+ *   @key was not found or the map does not contain fixed-width values.
+ *
+ * Since: 44
+ */
+const IdePersistentMapRecord *
+ide_persistent_map_lookup_record (IdePersistentMap *self,
+                                  const gchar      *key)
+{
+  gint64 index;
+
+  g_return_val_if_fail (IDE_IS_PERSISTENT_MAP (self), NULL);
+  g_return_val_if_fail (self->loaded, NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+
+  if (self->records == NULL)
+    return NULL;
+
+  if (self->version == IDE_PERSISTENT_MAP_V3)
+    return ide_persistent_map_lookup_v3 (self, key);
+
+  if ((index = ide_persistent_map_lookup_v2 (self, key)) < 0 || (gsize)index >= self->n_records)
+    return NULL;
+
+  return &self->records[index];
+}
+
 gint64
 ide_persistent_map_builder_get_metadata_int64 (IdePersistentMap *self,
                                                const gchar      *key)
@@ -325,12 +620,18 @@ ide_persistent_map_finalize (GObject *object)
 
   self->keys = NULL;
   self->kvpairs = NULL;
+  self->records = NULL;
+  self->prefixes = NULL;
+  self->key_offsets = NULL;
+  self->strings = NULL;
+  self->common_prefix = NULL;
 
   g_clear_pointer (&self->data, g_variant_unref);
   g_clear_pointer (&self->keys_var, g_variant_unref);
   g_clear_pointer (&self->values, g_variant_unref);
   g_clear_pointer (&self->kvpairs_var, g_variant_unref);
   g_clear_pointer (&self->metadata, g_variant_dict_unref);
+  g_clear_pointer (&self->swapped, g_bytes_unref);
   g_clear_pointer (&self->mapped_file, g_mapped_file_unref);
 
   G_OBJECT_CLASS (ide_persistent_map_parent_class)->finalize (object);
@@ -25,6 +25,19 @@
 
 #define IDE_TYPE_PERSISTENT_MAP (ide_persistent_map_get_type ())
 
+/**
+ * IdePersistentMapRecord:
+ * @values: the four members of a "(uuuu)" value
+ *
+ * A fixed-width value borrowed from the mapped index file.
+ *
+ * Since: 44
+ */
+typedef struct _IdePersistentMapRecord
+{
+  guint32 values[4];
+} IdePersistentMapRecord;
+
 IDE_AVAILABLE_IN_ALL
 G_DECLARE_FINAL_TYPE (IdePersistentMap, ide_persistent_map, IDE, PERSISTENT_MAP, GObject)
 
@@ -48,6 +61,10 @@ gboolean          ide_persistent_map_load_file_finish           (IdePersistentMa
 IDE_AVAILABLE_IN_ALL
 GVariant         *ide_persistent_map_lookup_value               (IdePersistentMap     *self,
                                                                  const gchar          *key);
+IDE_AVAILABLE_IN_44
+const IdePersistentMapRecord *
+                  ide_persistent_map_lookup_record              (IdePersistentMap     *self,
+                                                                 const gchar          *key);
 IDE_AVAILABLE_IN_ALL
 gint64            ide_persistent_map_builder_get_metadata_int64 (IdePersistentMap     *self,
                                                                  const gchar          *key);
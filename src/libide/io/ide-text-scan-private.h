@@ -0,0 +1,74 @@
+/* ide-text-scan-private.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  IDE_TEXT_SCAN_AUTO,
+  IDE_TEXT_SCAN_SCALAR,
+  IDE_TEXT_SCAN_SSE2,
+  IDE_TEXT_SCAN_AVX2,
+} IdeTextScanImpl;
+
+gboolean    _ide_text_scan_set_impl (IdeTextScanImpl  impl);
+const char *_ide_text_find_byte     (const char      *data,
+                                     gsize            len,
+                                     char             ch);
+const char *_ide_text_find_byte2    (const char      *data,
+                                     gsize            len,
+                                     char             ch1,
+                                     char             ch2);
+gsize       _ide_text_ascii_len     (const char      *data,
+                                     gsize            len);
+
+/* Decodes the character at *@pos, advancing it, taking a fast path when
+ * the character is ASCII. Embedded Nil bytes are returned as 0 rather
+ * than ending the string. Returns FALSE if the input is not valid UTF-8.
+ */
+static inline gboolean
+_ide_text_utf8_next (const char **pos,
+                     const char  *end,
+                     gunichar    *ch)
+{
+  const guchar *p = (const guchar *)*pos;
+
+  if G_LIKELY (*p < 0x80)
+    {
+      *ch = *p;
+      (*pos)++;
+      return TRUE;
+    }
+
+  *ch = g_utf8_get_char_validated (*pos, end - *pos);
+
+  if (*ch == (gunichar)-1 || *ch == (gunichar)-2)
+    return FALSE;
+
+  *pos = g_utf8_next_char (*pos);
+
+  return TRUE;
+}
+
+G_END_DECLS
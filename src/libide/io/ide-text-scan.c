@@ -0,0 +1,378 @@
+/* ide-text-scan.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "ide-text-scan"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "ide-text-scan-private.h"
+
+/* These kernels sit below the line readers used for build logs, grep
+ * output, ctags files and the codesearch indexer, which regularly see
+ * inputs that are hundreds of megabytes. The SSE2 and AVX2 variants are
+ * selected at runtime based on the CPU so that distribution builds do
+ * not need to target a newer baseline.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define HAVE_X86_KERNELS 1
+# include <immintrin.h>
+#endif
+
+typedef struct
+{
+  const char *(*find_byte)  (const char *data,
+                             gsize       len,
+                             char        ch);
+  const char *(*find_byte2) (const char *data,
+                             gsize       len,
+                             char        ch1,
+                             char        ch2);
+  gsize       (*ascii_len)  (const char *data,
+                             gsize       len);
+} IdeTextScanKernels;
+
+static IdeTextScanKernels kernels;
+
+static const char *
+find_byte_scalar (const char *data,
+                  gsize       len,
+                  char        ch)
+{
+  return memchr (data, ch, len);
+}
+
+static const char *
+find_byte2_scalar (const char *data,
+                   gsize       len,
+                   char        ch1,
+                   char        ch2)
+{
+  for (gsize i = 0; i < len; i++)
+    {
+      if (data[i] == ch1 || data[i] == ch2)
+        return &data[i];
+    }
+
+  return NULL;
+}
+
+static gsize
+ascii_len_scalar (const char *data,
+                  gsize       len)
+{
+  gsize i = 0;
+
+  for (; i + 8 <= len; i += 8)
+    {
+      guint64 word;
+
+      memcpy (&word, &data[i], sizeof word);
+
+      if (word & G_GUINT64_CONSTANT (0x8080808080808080))
+        break;
+    }
+
+  for (; i < len; i++)
+    {
+      if ((guchar)data[i] >= 0x80)
+        break;
+    }
+
+  return i;
+}
+
+#ifdef HAVE_X86_KERNELS
+__attribute__((target("sse2")))
+static const char *
+find_byte_sse2 (const char *data,
+                gsize       len,
+                char        ch)
+{
+  const __m128i needle = _mm_set1_epi8 (ch);
+  gsize i = 0;
+
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128 ((const __m128i *)(gconstpointer)&data[i]);
+      guint mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (chunk, needle));
+
+      if (mask != 0)
+        return &data[i + __builtin_ctz (mask)];
+    }
+
+  return find_byte_scalar (&data[i], len - i, ch);
+}
+
+__attribute__((target("sse2")))
+static const char *
+find_byte2_sse2 (const char *data,
+                 gsize       len,
+                 char        ch1,
+                 char        ch2)
+{
+  const __m128i needle1 = _mm_set1_epi8 (ch1);
+  const __m128i needle2 = _mm_set1_epi8 (ch2);
+  gsize i = 0;
+
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128 ((const __m128i *)(gconstpointer)&data[i]);
+      __m128i eq = _mm_or_si128 (_mm_cmpeq_epi8 (chunk, needle1),
+                                 _mm_cmpeq_epi8 (chunk, needle2));
+      guint mask = _mm_movemask_epi8 (eq);
+
+      if (mask != 0)
+        return &data[i + __builtin_ctz (mask)];
+    }
+
+  return find_byte2_scalar (&data[i], len - i, ch1, ch2);
+}
+
+__attribute__((target("sse2")))
+static gsize
+ascii_len_sse2 (const char *data,
+                gsize       len)
+{
+  gsize i = 0;
+
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128 ((const __m128i *)(gconstpointer)&data[i]);
+      guint mask = _mm_movemask_epi8 (chunk);
+
+      if (mask != 0)
+        return i + __builtin_ctz (mask);
+    }
+
+  return i + ascii_len_scalar (&data[i], len - i);
+}
+
+__attribute__((target("avx2")))
+static const char *
+find_byte_avx2 (const char *data,
+                gsize       len,
+                char        ch)
+{
+  const __m256i needle = _mm256_set1_epi8 (ch);
+  gsize i = 0;
+
+  for (; i + 32 <= len; i += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256 ((const __m256i *)(gconstpointer)&data[i]);
+      guint mask = (guint)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (chunk, needle));
+
+      if (mask != 0)
+        return &data[i + __builtin_ctz (mask)];
+    }
+
+  return find_byte_sse2 (&data[i], len - i, ch);
+}
+
+__attribute__((target("avx2")))
+static const char *
+find_byte2_avx2 (const char *data,
+                 gsize       len,
+                 char        ch1,
+                 char        ch2)
+{
+  const __m256i needle1 = _mm256_set1_epi8 (ch1);
+  const __m256i needle2 = _mm256_set1_epi8 (ch2);
+  gsize i = 0;
+
+  for (; i + 32 <= len; i += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256 ((const __m256i *)(gconstpointer)&data[i]);
+      __m256i eq = _mm256_or_si256 (_mm256_cmpeq_epi8 (chunk, needle1),
+                                    _mm256_cmpeq_epi8 (chunk, needle2));
+      guint mask = (guint)_mm256_movemask_epi8 (eq);
+
+      if (mask != 0)
+        return &data[i + __builtin_ctz (mask)];
+    }
+
+  return find_byte2_sse2 (&data[i], len - i, ch1, ch2);
+}
+
+__attribute__((target("avx2")))
+static gsize
+ascii_len_avx2 (const char *data,
+                gsize       len)
+{
+  gsize i = 0;
+
+  for (; i + 32 <= len; i += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256 ((const __m256i *)(gconstpointer)&data[i]);
+      guint mask = (guint)_mm256_movemask_epi8 (chunk);
+
+      if (mask != 0)
+        return i + __builtin_ctz (mask);
+    }
+
+  return i + ascii_len_sse2 (&data[i], len - i);
+}
+#endif
+
+static gboolean
+ide_text_scan_select (IdeTextScanImpl impl)
+{
+#ifdef HAVE_X86_KERNELS
+  if (impl == IDE_TEXT_SCAN_AUTO)
+    {
+      if (__builtin_cpu_supports ("avx2"))
+        impl = IDE_TEXT_SCAN_AVX2;
+      else if (__builtin_cpu_supports ("sse2"))
+        impl = IDE_TEXT_SCAN_SSE2;
+      else
+        impl = IDE_TEXT_SCAN_SCALAR;
+    }
+
+  switch (impl)
+    {
+    case IDE_TEXT_SCAN_AVX2:
+      if (!__builtin_cpu_supports ("avx2"))
+        return FALSE;
+      kernels.find_byte = find_byte_avx2;
+      kernels.find_byte2 = find_byte2_avx2;
+      kernels.ascii_len = ascii_len_avx2;
+      return TRUE;
+
+    case IDE_TEXT_SCAN_SSE2:
+      if (!__builtin_cpu_supports ("sse2"))
+        return FALSE;
+      kernels.find_byte = find_byte_sse2;
+      kernels.find_byte2 = find_byte2_sse2;
+      kernels.ascii_len = ascii_len_sse2;
+      return TRUE;
+
+    case IDE_TEXT_SCAN_AUTO:
+    case IDE_TEXT_SCAN_SCALAR:
+    default:
+      break;
+    }
+#else
+  if (impl != IDE_TEXT_SCAN_AUTO && impl != IDE_TEXT_SCAN_SCALAR)
+    return FALSE;
+#endif
+
+  kernels.find_byte = find_byte_scalar;
+  kernels.find_byte2 = find_byte2_scalar;
+  kernels.ascii_len = ascii_len_scalar;
+
+  return TRUE;
+}
+
+static inline const IdeTextScanKernels *
+get_kernels (void)
+{
+  static gsize initialized;
+
+  if (g_once_init_enter (&initialized))
+    {
+      ide_text_scan_select (IDE_TEXT_SCAN_AUTO);
+      g_once_init_leave (&initialized, TRUE);
+    }
+
+  return &kernels;
+}
+
+/*
+ * _ide_text_scan_set_impl:
+ * @impl: an #IdeTextScanImpl
+ *
+ * Overrides the kernels selected for the current CPU. This is meant for
+ * tests and benchmarks which need to exercise each implementation, and
+ * must be called before any other thread is scanning text.
+ *
+ * Returns: %FALSE if @impl is not supported by this CPU.
+ */
+gboolean
+_ide_text_scan_set_impl (IdeTextScanImpl impl)
+{
+  get_kernels ();
+
+  return ide_text_scan_select (impl);
+}
+
+/*
+ * _ide_text_find_byte:
+ *
+ * Like memchr(), locates the first @ch within the first @len bytes of @data.
+ *
+ * Returns: a pointer to the byte, or %NULL
+ */
+const char *
+_ide_text_find_byte (const char *data,
+                     gsize       len,
+                     char        ch)
+{
+  g_assert (data != NULL || len == 0);
+
+  if (len == 0)
+    return NULL;
+
+  return get_kernels ()->find_byte (data, len, ch);
+}
+
+/*
+ * _ide_text_find_byte2:
+ *
+ * Locates the first occurrence of either @ch1 or @ch2 within the first
+ * @len bytes of @data. This is useful for delimiter splitting where a
+ * line may end before the next delimiter.
+ *
+ * Returns: a pointer to the byte, or %NULL
+ */
+const char *
+_ide_text_find_byte2 (const char *data,
+                      gsize       len,
+                      char        ch1,
+                      char        ch2)
+{
+  g_assert (data != NULL || len == 0);
+
+  if (len == 0)
+    return NULL;
+
+  return get_kernels ()->find_byte2 (data, len, ch1, ch2);
+}
+
+/*
+ * _ide_text_ascii_len:
+ *
+ * Gets the number of leading bytes of @data which are 7-bit ASCII, and
+ * therefore may be treated as characters without UTF-8 decoding.
+ *
+ * Returns: the length of the ASCII run, up to @len
+ */
+gsize
+_ide_text_ascii_len (const char *data,
+                     gsize       len)
+{
+  g_assert (data != NULL || len == 0);
+
+  if (len == 0)
+    return 0;
+
+  return get_kernels ()->ascii_len (data, len);
+}
@@ -32,6 +32,7 @@ G_BEGIN_DECLS
 # include "ide-file-transfer.h"
 # include "ide-gfile.h"
 # include "ide-heap.h"
+# include "ide-index-registry.h"
 # include "ide-line-reader.h"
 # include "ide-io-enums.h"
 # include "ide-marked-content.h"
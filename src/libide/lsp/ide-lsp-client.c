@@ -44,6 +44,18 @@ typedef struct
   GVariant      *id;
 } AsyncCall;
 
+typedef struct
+{
+  char          *method;
+  gint64         begin_time;
+
+  /* Used to send $/cancelRequest if the call is cancelled */
+  JsonrpcClient *rpc_client;
+  GVariant      *id;
+  GCancellable  *cancellable;
+  gulong         cancel_id;
+} Call;
+
 typedef struct
 {
   GList         link;
@@ -117,9 +129,11 @@ enum {
   N_SIGNALS
 };
 
-static void ide_lsp_client_call_cb (GObject      *object,
-                                    GAsyncResult *result,
-                                    gpointer      user_data);
+static void ide_lsp_client_submit_call (JsonrpcClient *rpc_client,
+                                        const char    *method,
+                                        GVariant      *params,
+                                        GCancellable  *cancellable,
+                                        IdeTask       *task);
 
 static GParamSpec *properties [N_PROPS];
 static guint signals [N_SIGNALS];
@@ -186,12 +200,11 @@ pending_message_submit (PendingMessage *message,
   g_assert (!message->cancellable || G_IS_CANCELLABLE (message->cancellable));
   g_assert (message->method != NULL);
 
-  jsonrpc_client_call_async (rpc_client,
-                             message->method,
-                             message->params,
-                             message->cancellable,
-                             ide_lsp_client_call_cb,
-                             g_steal_pointer (&message->task));
+  ide_lsp_client_submit_call (rpc_client,
+                              message->method,
+                              message->params,
+                              message->cancellable,
+                              g_steal_pointer (&message->task));
 
   g_clear_object (&message->cancellable);
   g_clear_pointer (&message->method, g_free);
@@ -1969,6 +1982,44 @@ ide_lsp_client_stop (IdeLspClient *self)
   IDE_EXIT;
 }
 
+static void
+call_free (gpointer data)
+{
+  Call *call = data;
+
+  if (call->cancel_id != 0)
+    g_cancellable_disconnect (call->cancellable, call->cancel_id);
+
+  g_clear_pointer (&call->method, g_free);
+  g_clear_pointer (&call->id, g_variant_unref);
+  g_clear_object (&call->rpc_client);
+  g_clear_object (&call->cancellable);
+  g_slice_free (Call, call);
+}
+
+static void
+ide_lsp_client_call_cancelled (GCancellable *cancellable,
+                               Call         *call)
+{
+  GVariantDict dict;
+
+  g_assert (G_IS_CANCELLABLE (cancellable));
+  g_assert (call != NULL);
+  g_assert (call->id != NULL);
+  g_assert (JSONRPC_IS_CLIENT (call->rpc_client));
+
+  IDE_TRACE_MSG ("Cancelling LSP call to method %s", call->method);
+
+  /* Let the server stop working on a reply nobody is waiting for */
+  g_variant_dict_init (&dict, NULL);
+  g_variant_dict_insert_value (&dict, "id", call->id);
+
+  jsonrpc_client_send_notification_async (call->rpc_client,
+                                          "$/cancelRequest",
+                                          g_variant_dict_end (&dict),
+                                          NULL, NULL, NULL);
+}
+
 static void
 ide_lsp_client_call_cb (GObject      *object,
                         GAsyncResult *result,
@@ -1978,6 +2029,7 @@ ide_lsp_client_call_cb (GObject      *object,
   g_autoptr(GVariant) reply = NULL;
   g_autoptr(GError) error = NULL;
   g_autoptr(IdeTask) task = user_data;
+  Call *call;
 
   IDE_ENTRY;
 
@@ -1986,6 +2038,15 @@ ide_lsp_client_call_cb (GObject      *object,
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
 
+  call = ide_task_get_task_data (task);
+
+  if (call->begin_time != 0)
+    ide_profiler_mark (call->begin_time,
+                       g_get_monotonic_time (),
+                       "lsp",
+                       call->method,
+                       NULL);
+
   if (!jsonrpc_client_call_finish (client, result, &reply, &error))
     ide_task_return_error (task, g_steal_pointer (&error));
   else
@@ -1996,6 +2057,45 @@ ide_lsp_client_call_cb (GObject      *object,
   IDE_EXIT;
 }
 
+static void
+ide_lsp_client_submit_call (JsonrpcClient *rpc_client,
+                            const char    *method,
+                            GVariant      *params,
+                            GCancellable  *cancellable,
+                            IdeTask       *task)
+{
+  Call *call;
+
+  g_assert (JSONRPC_IS_CLIENT (rpc_client));
+  g_assert (method != NULL);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+  g_assert (IDE_IS_TASK (task));
+
+  call = ide_task_get_task_data (task);
+
+  g_assert (call != NULL);
+  g_assert (call->id == NULL);
+
+  /* @task completes from the main loop, so @call is still valid after */
+  jsonrpc_client_call_with_id_async (rpc_client,
+                                     method,
+                                     params,
+                                     &call->id,
+                                     cancellable,
+                                     ide_lsp_client_call_cb,
+                                     task);
+
+  if (cancellable != NULL && call->id != NULL)
+    {
+      call->rpc_client = g_object_ref (rpc_client);
+      call->cancellable = g_object_ref (cancellable);
+      call->cancel_id = g_cancellable_connect (cancellable,
+                                               G_CALLBACK (ide_lsp_client_call_cancelled),
+                                               call,
+                                               NULL);
+    }
+}
+
 static void
 ide_lsp_client_queue_message (IdeLspClient *self,
                               const char   *method,
@@ -2051,6 +2151,7 @@ ide_lsp_client_call_async (IdeLspClient        *self,
 {
   IdeLspClientPrivate *priv = ide_lsp_client_get_instance_private (self);
   g_autoptr(IdeTask) task = NULL;
+  Call *call;
 
   IDE_ENTRY;
 
@@ -2063,6 +2164,14 @@ ide_lsp_client_call_async (IdeLspClient        *self,
   task = ide_task_new (self, cancellable, callback, user_data);
   ide_task_set_source_tag (task, ide_lsp_client_call_async);
 
+  call = g_slice_new0 (Call);
+  call->method = g_strdup (method);
+  ide_task_set_task_data (task, call, call_free);
+
+  /* Round-trips include time spent queued waiting for initialization */
+  if (ide_profiler_is_active ())
+    call->begin_time = g_get_monotonic_time ();
+
   if (priv->rpc_client == NULL)
     ide_task_return_new_error (task,
                                G_IO_ERROR,
@@ -2077,12 +2186,11 @@ ide_lsp_client_call_async (IdeLspClient        *self,
                                   cancellable,
                                   g_steal_pointer (&task));
   else
-    jsonrpc_client_call_async (priv->rpc_client,
-                               method,
-                               params,
-                               cancellable,
-                               ide_lsp_client_call_cb,
-                               g_steal_pointer (&task));
+    ide_lsp_client_submit_call (priv->rpc_client,
+                                method,
+                                params,
+                                cancellable,
+                                g_steal_pointer (&task));
 
   IDE_EXIT;
 }
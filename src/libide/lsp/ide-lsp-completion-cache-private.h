@@ -0,0 +1,82 @@
+/* ide-lsp-completion-cache-private.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* LSP CompletionTriggerKind */
+#define IDE_LSP_COMPLETION_TRIGGER_INVOKED         1
+#define IDE_LSP_COMPLETION_TRIGGER_CHARACTER       2
+#define IDE_LSP_COMPLETION_TRIGGER_FOR_INCOMPLETE  3
+
+typedef struct _IdeLspCompletionCache IdeLspCompletionCache;
+
+typedef struct
+{
+  char      *uri;
+  char      *line_text;
+  char      *word;
+
+  /* The server reply, or %NULL while the request is in flight */
+  GVariant  *results;
+
+  /* IdeTask waiting for the reply, with the word to filter as task data */
+  GPtrArray *waiters;
+
+  gint64     created_at;
+  guint      line;
+  guint      column;
+  guint      is_incomplete : 1;
+  guint      failed : 1;
+} IdeLspCompletionCacheEntry;
+
+IdeLspCompletionCache      *_ide_lsp_completion_cache_new                (guint                       max_entries,
+                                                                         GTimeSpan                   max_age);
+void                        _ide_lsp_completion_cache_free               (IdeLspCompletionCache      *self);
+void                        _ide_lsp_completion_cache_clear              (IdeLspCompletionCache      *self);
+IdeLspCompletionCacheEntry *_ide_lsp_completion_cache_lookup             (IdeLspCompletionCache      *self,
+                                                                         const char                 *uri,
+                                                                         guint                       line,
+                                                                         guint                       column,
+                                                                         const char                 *line_text,
+                                                                         gint64                      now);
+void                        _ide_lsp_completion_cache_insert             (IdeLspCompletionCache      *self,
+                                                                         IdeLspCompletionCacheEntry *entry);
+IdeLspCompletionCacheEntry *_ide_lsp_completion_cache_entry_new          (const char                 *uri,
+                                                                         guint                       line,
+                                                                         guint                       column,
+                                                                         const char                 *line_text,
+                                                                         const char                 *word);
+IdeLspCompletionCacheEntry *_ide_lsp_completion_cache_entry_ref          (IdeLspCompletionCacheEntry *entry);
+void                        _ide_lsp_completion_cache_entry_unref        (IdeLspCompletionCacheEntry *entry);
+void                        _ide_lsp_completion_cache_entry_set_results  (IdeLspCompletionCacheEntry *entry,
+                                                                         GVariant                   *results,
+                                                                         gint64                      now);
+gboolean                    _ide_lsp_completion_cache_entry_can_reuse    (IdeLspCompletionCacheEntry *entry,
+                                                                         const char                 *word);
+int                         _ide_lsp_completion_cache_entry_trigger_kind (IdeLspCompletionCacheEntry *entry);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (IdeLspCompletionCache, _ide_lsp_completion_cache_free)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (IdeLspCompletionCacheEntry, _ide_lsp_completion_cache_entry_unref)
+
+G_END_DECLS
@@ -0,0 +1,270 @@
+/* ide-lsp-completion-cache.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "ide-lsp-completion-cache"
+
+#include "config.h"
+
+#include "ide-lsp-completion-cache-private.h"
+
+/*
+ * Result sets from previous requests, most recently used first. Each entry
+ * is keyed by document, position, and the text of the line up to that
+ * position so that completing the same word again, or typing more of it,
+ * does not need another round trip to the server.
+ */
+struct _IdeLspCompletionCache
+{
+  GQueue    entries;
+  GTimeSpan max_age;
+  guint     max_entries;
+};
+
+static void
+entry_finalize (gpointer data)
+{
+  IdeLspCompletionCacheEntry *entry = data;
+
+  g_clear_pointer (&entry->uri, g_free);
+  g_clear_pointer (&entry->line_text, g_free);
+  g_clear_pointer (&entry->word, g_free);
+  g_clear_pointer (&entry->results, g_variant_unref);
+  g_clear_pointer (&entry->waiters, g_ptr_array_unref);
+}
+
+IdeLspCompletionCacheEntry *
+_ide_lsp_completion_cache_entry_new (const char *uri,
+                                     guint       line,
+                                     guint       column,
+                                     const char *line_text,
+                                     const char *word)
+{
+  IdeLspCompletionCacheEntry *entry = g_rc_box_new0 (IdeLspCompletionCacheEntry);
+
+  entry->uri = g_strdup (uri);
+  entry->line = line;
+  entry->column = column;
+  entry->line_text = g_strdup (line_text);
+  entry->word = g_strdup (word ? word : "");
+  entry->waiters = g_ptr_array_new_with_free_func (g_object_unref);
+  entry->created_at = g_get_monotonic_time ();
+
+  return entry;
+}
+
+IdeLspCompletionCacheEntry *
+_ide_lsp_completion_cache_entry_ref (IdeLspCompletionCacheEntry *entry)
+{
+  return g_rc_box_acquire (entry);
+}
+
+void
+_ide_lsp_completion_cache_entry_unref (IdeLspCompletionCacheEntry *entry)
+{
+  g_rc_box_release_full (entry, entry_finalize);
+}
+
+/**
+ * _ide_lsp_completion_cache_entry_set_results:
+ * @entry: an #IdeLspCompletionCacheEntry
+ * @results: the reply to textDocument/completion
+ * @now: the current monotonic time
+ *
+ * Stores the reply for @entry. Only the {isIncomplete, items} style of
+ * reply may be incomplete.
+ */
+void
+_ide_lsp_completion_cache_entry_set_results (IdeLspCompletionCacheEntry *entry,
+                                             GVariant                   *results,
+                                             gint64                      now)
+{
+  gboolean is_incomplete = FALSE;
+
+  g_return_if_fail (entry != NULL);
+  g_return_if_fail (results != NULL);
+
+  if (g_variant_is_of_type (results, G_VARIANT_TYPE_VARDICT))
+    g_variant_lookup (results, "isIncomplete", "b", &is_incomplete);
+
+  g_clear_pointer (&entry->results, g_variant_unref);
+  entry->results = g_variant_ref_sink (results);
+  entry->is_incomplete = !!is_incomplete;
+  entry->created_at = now;
+}
+
+/**
+ * _ide_lsp_completion_cache_entry_can_reuse:
+ * @entry: an #IdeLspCompletionCacheEntry
+ * @word: (nullable): the word being completed
+ *
+ * Whether the result set can be filtered down to @word. An incomplete
+ * result set is only valid for the exact word it was requested with,
+ * as the server may have omitted items which match a longer word.
+ *
+ * Returns: %TRUE if @entry can be used for @word
+ */
+gboolean
+_ide_lsp_completion_cache_entry_can_reuse (IdeLspCompletionCacheEntry *entry,
+                                           const char                 *word)
+{
+  g_return_val_if_fail (entry != NULL, FALSE);
+
+  if (entry->failed)
+    return FALSE;
+
+  if (word == NULL)
+    word = "";
+
+  if (entry->results != NULL && entry->is_incomplete)
+    return g_str_equal (word, entry->word);
+
+  return g_str_has_prefix (word, entry->word);
+}
+
+/**
+ * _ide_lsp_completion_cache_entry_trigger_kind:
+ * @entry: an #IdeLspCompletionCacheEntry
+ *
+ * Gets the trigger kind to use when requesting results again at the
+ * position of @entry for a word it cannot be reused for.
+ *
+ * Only incomplete result sets are re-requested as such. A complete
+ * result set can't be reused for a shorter word, such as after
+ * backspacing, which is a regular request.
+ *
+ * Returns: an LSP CompletionTriggerKind
+ */
+int
+_ide_lsp_completion_cache_entry_trigger_kind (IdeLspCompletionCacheEntry *entry)
+{
+  g_return_val_if_fail (entry != NULL, IDE_LSP_COMPLETION_TRIGGER_INVOKED);
+
+  if (entry->results != NULL && entry->is_incomplete)
+    return IDE_LSP_COMPLETION_TRIGGER_FOR_INCOMPLETE;
+
+  return IDE_LSP_COMPLETION_TRIGGER_INVOKED;
+}
+
+IdeLspCompletionCache *
+_ide_lsp_completion_cache_new (guint     max_entries,
+                               GTimeSpan max_age)
+{
+  IdeLspCompletionCache *self;
+
+  g_return_val_if_fail (max_entries > 0, NULL);
+
+  self = g_slice_new0 (IdeLspCompletionCache);
+  self->max_entries = max_entries;
+  self->max_age = max_age;
+
+  return self;
+}
+
+void
+_ide_lsp_completion_cache_clear (IdeLspCompletionCache *self)
+{
+  IdeLspCompletionCacheEntry *entry;
+
+  g_return_if_fail (self != NULL);
+
+  while ((entry = g_queue_pop_head (&self->entries)))
+    _ide_lsp_completion_cache_entry_unref (entry);
+}
+
+void
+_ide_lsp_completion_cache_free (IdeLspCompletionCache *self)
+{
+  if (self != NULL)
+    {
+      _ide_lsp_completion_cache_clear (self);
+      g_slice_free (IdeLspCompletionCache, self);
+    }
+}
+
+/**
+ * _ide_lsp_completion_cache_lookup:
+ * @self: an #IdeLspCompletionCache
+ * @uri: the uri of the document
+ * @line: the line of the completion
+ * @column: the column of the completion
+ * @line_text: the text of @line up to @column
+ * @now: the current monotonic time
+ *
+ * Finds the entry for a position, dropping failed entries and result
+ * sets older than the max age along the way since other lines may have
+ * changed since. In-flight requests never expire.
+ *
+ * Returns: (transfer none) (nullable): an #IdeLspCompletionCacheEntry
+ */
+IdeLspCompletionCacheEntry *
+_ide_lsp_completion_cache_lookup (IdeLspCompletionCache *self,
+                                  const char            *uri,
+                                  guint                  line,
+                                  guint                  column,
+                                  const char            *line_text,
+                                  gint64                 now)
+{
+  GList *iter;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
+  g_return_val_if_fail (line_text != NULL, NULL);
+
+  iter = self->entries.head;
+
+  while (iter != NULL)
+    {
+      IdeLspCompletionCacheEntry *entry = iter->data;
+      GList *next = iter->next;
+
+      if (entry->failed ||
+          (entry->results != NULL && now - entry->created_at > self->max_age))
+        {
+          g_queue_delete_link (&self->entries, iter);
+          _ide_lsp_completion_cache_entry_unref (entry);
+        }
+      else if (entry->line == line &&
+               entry->column == column &&
+               g_str_equal (entry->uri, uri) &&
+               g_str_equal (entry->line_text, line_text))
+        {
+          g_queue_unlink (&self->entries, iter);
+          g_queue_push_head_link (&self->entries, iter);
+          return entry;
+        }
+
+      iter = next;
+    }
+
+  return NULL;
+}
+
+void
+_ide_lsp_completion_cache_insert (IdeLspCompletionCache      *self,
+                                  IdeLspCompletionCacheEntry *entry)
+{
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (entry != NULL);
+
+  g_queue_push_head (&self->entries, _ide_lsp_completion_cache_entry_ref (entry));
+
+  while (self->entries.length > self->max_entries)
+    _ide_lsp_completion_cache_entry_unref (g_queue_pop_tail (&self->entries));
+}
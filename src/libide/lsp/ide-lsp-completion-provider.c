@@ -27,17 +27,27 @@
 #include <libide-threading.h>
 #include <jsonrpc-glib.h>
 
+#include "ide-lsp-completion-cache-private.h"
 #include "ide-lsp-completion-provider.h"
 #include "ide-lsp-completion-item.h"
-#include "ide-lsp-completion-results.h"
+#include "ide-lsp-completion-results-private.h"
 #include "ide-lsp-util.h"
 
+/* How many result sets are kept around, across all documents */
+#define CACHE_SIZE    8
+/* How long a result set may be reused, since other lines may change */
+#define CACHE_MAX_AGE (30 * G_USEC_PER_SEC)
+
 typedef struct
 {
   IdeLspClient  *client;
   char          *word;
   char         **trigger_chars;
   char          *refilter_word;
+
+  /* Result sets from previous requests, across all documents */
+  IdeLspCompletionCache *cache;
+
   guint          has_loaded : 1;
 } IdeLspCompletionProviderPrivate;
 
@@ -55,6 +65,16 @@ enum {
 
 static GParamSpec *properties [N_PROPS];
 
+static char *
+get_line_text (const GtkTextIter *begin)
+{
+  GtkTextIter line_start = *begin;
+
+  gtk_text_iter_set_line_offset (&line_start, 0);
+
+  return gtk_text_iter_get_slice (&line_start, begin);
+}
+
 static void
 ide_lsp_completion_provider_real_load (IdeLspCompletionProvider *self)
 {
@@ -69,6 +89,7 @@ ide_lsp_completion_provider_finalize (GObject *object)
   g_clear_object (&priv->client);
   g_clear_pointer (&priv->word, g_free);
   g_clear_pointer (&priv->trigger_chars, g_free);
+  g_clear_pointer (&priv->cache, _ide_lsp_completion_cache_free);
 
   G_OBJECT_CLASS (ide_lsp_completion_provider_parent_class)->finalize (object);
 }
@@ -135,6 +156,9 @@ ide_lsp_completion_provider_class_init (IdeLspCompletionProviderClass *klass)
 static void
 ide_lsp_completion_provider_init (IdeLspCompletionProvider *self)
 {
+  IdeLspCompletionProviderPrivate *priv = ide_lsp_completion_provider_get_instance_private (self);
+
+  priv->cache = _ide_lsp_completion_cache_new (CACHE_SIZE, CACHE_MAX_AGE);
 }
 
 /**
@@ -202,6 +226,8 @@ ide_lsp_completion_provider_set_client (IdeLspCompletionProvider *self,
 
   if (g_set_object (&priv->client, client))
     {
+      _ide_lsp_completion_cache_clear (priv->cache);
+
       if (client != NULL)
         {
           g_signal_connect_object (client,
@@ -223,51 +249,144 @@ ide_lsp_completion_provider_get_priority (GtkSourceCompletionProvider *provider,
   return IDE_LSP_COMPLETION_PROVIDER_PRIORITY;
 }
 
+static IdeLspCompletionResults *
+ide_lsp_completion_provider_create_results (IdeLspCompletionProvider *self,
+                                            GVariant                 *results,
+                                            const char               *word)
+{
+  IdeCompletionHistory *history = NULL;
+  IdeLspCompletionResults *ret;
+  IdeContext *context;
+
+  g_assert (IDE_IS_LSP_COMPLETION_PROVIDER (self));
+  g_assert (results != NULL);
+
+  if ((context = ide_object_get_context (IDE_OBJECT (self))))
+    history = ide_completion_history_from_context (context);
+
+  ret = _ide_lsp_completion_results_new_with_history (results, history);
+
+  g_debug ("%s populated initial result set of %u items",
+           G_OBJECT_TYPE_NAME (self),
+           g_list_model_get_n_items (G_LIST_MODEL (ret)));
+
+  if (!ide_str_empty0 (word))
+    {
+      IDE_TRACE_MSG ("Filtering results to %s", word);
+      ide_lsp_completion_results_refilter (ret, word);
+    }
+
+  return ret;
+}
+
+static void ide_lsp_completion_provider_request (IdeLspClient               *client,
+                                                 IdeLspCompletionCacheEntry *entry,
+                                                 gint                        trigger_kind);
+
 static void
 ide_lsp_completion_provider_complete_cb (GObject      *object,
                                          GAsyncResult *result,
                                          gpointer      user_data)
 {
-  IdeLspCompletionProviderPrivate *priv;
-  IdeLspCompletionProvider *self;
   IdeLspClient *client = (IdeLspClient *)object;
+  g_autoptr(GPtrArray) waiters = NULL;
   g_autoptr(GVariant) return_value = NULL;
-  g_autoptr(IdeTask) task = user_data;
   g_autoptr(GError) error = NULL;
-  IdeLspCompletionResults *ret;
+  IdeLspCompletionCacheEntry *entry = user_data;
 
   IDE_ENTRY;
 
   g_assert (IDE_IS_LSP_CLIENT (client));
   g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (entry != NULL);
+
+  waiters = g_steal_pointer (&entry->waiters);
+  entry->waiters = g_ptr_array_new_with_free_func (g_object_unref);
 
   if (!ide_lsp_client_call_finish (client, result, &return_value, &error))
     {
       IDE_TRACE_MSG ("Completion call failed: %s", error->message);
-      ide_task_return_error (task, g_steal_pointer (&error));
-      return;
-    }
 
-  self = ide_task_get_source_object (task);
-  priv = ide_lsp_completion_provider_get_instance_private (self);
+      entry->failed = TRUE;
 
-  ret = ide_lsp_completion_results_new (return_value);
+      for (guint i = 0; i < waiters->len; i++)
+        ide_task_return_error (g_ptr_array_index (waiters, i), g_error_copy (error));
 
-  g_debug ("%s populated initial result set of %u items",
-           G_OBJECT_TYPE_NAME (self),
-           g_list_model_get_n_items (G_LIST_MODEL (ret)));
+      _ide_lsp_completion_cache_entry_unref (entry);
+
+      IDE_EXIT;
+    }
+
+  _ide_lsp_completion_cache_entry_set_results (entry, return_value, g_get_monotonic_time ());
 
-  if (!ide_str_empty0 (priv->word))
+  for (guint i = 0; i < waiters->len; i++)
     {
-      IDE_TRACE_MSG ("Filtering results to %s", priv->word);
-      ide_lsp_completion_results_refilter (ret, priv->word);
+      IdeTask *task = g_ptr_array_index (waiters, i);
+      IdeLspCompletionProvider *self = ide_task_get_source_object (task);
+      const char *word = ide_task_get_task_data (task);
+
+      if (_ide_lsp_completion_cache_entry_can_reuse (entry, word))
+        {
+          ide_task_return_object (task,
+                                  ide_lsp_completion_provider_create_results (self, entry->results, word));
+        }
+      else
+        {
+          IdeLspCompletionProviderPrivate *priv = ide_lsp_completion_provider_get_instance_private (self);
+          g_autoptr(IdeLspCompletionCacheEntry) next = NULL;
+
+          /* The user typed more while an incomplete result set was in
+           * flight, so ask the server again for the longer word.
+           */
+          next = _ide_lsp_completion_cache_entry_new (entry->uri, entry->line, entry->column, entry->line_text, word);
+          g_ptr_array_add (next->waiters, g_object_ref (task));
+          _ide_lsp_completion_cache_insert (priv->cache, next);
+          ide_lsp_completion_provider_request (client,
+                                               next,
+                                               _ide_lsp_completion_cache_entry_trigger_kind (entry));
+        }
     }
 
-  ide_task_return_object (task, g_steal_pointer (&ret));
+  _ide_lsp_completion_cache_entry_unref (entry);
 
   IDE_EXIT;
 }
 
+static void
+ide_lsp_completion_provider_request (IdeLspClient               *client,
+                                     IdeLspCompletionCacheEntry *entry,
+                                     gint                        trigger_kind)
+{
+  g_autoptr(GVariant) params = NULL;
+
+  g_assert (IDE_IS_LSP_CLIENT (client));
+  g_assert (entry != NULL);
+  g_assert (entry->results == NULL);
+
+  params = JSONRPC_MESSAGE_NEW (
+    "textDocument", "{",
+      "uri", JSONRPC_MESSAGE_PUT_STRING (entry->uri),
+    "}",
+    "position", "{",
+      "line", JSONRPC_MESSAGE_PUT_INT32 (entry->line),
+      "character", JSONRPC_MESSAGE_PUT_INT32 (entry->column),
+    "}",
+    "context", "{",
+      "triggerKind", JSONRPC_MESSAGE_PUT_INT32 (trigger_kind),
+    "}"
+  );
+
+  /* Not cancellable, as a cancelled populate may be followed by another
+   * populate which can reuse the reply.
+   */
+  ide_lsp_client_call_async (client,
+                             "textDocument/completion",
+                             params,
+                             NULL,
+                             ide_lsp_completion_provider_complete_cb,
+                             _ide_lsp_completion_cache_entry_ref (entry));
+}
+
 static void
 ide_lsp_completion_provider_populate_async (GtkSourceCompletionProvider *provider,
                                             GtkSourceCompletionContext  *context,
@@ -278,10 +397,12 @@ ide_lsp_completion_provider_populate_async (GtkSourceCompletionProvider *provide
   IdeLspCompletionProvider *self = (IdeLspCompletionProvider *)provider;
   IdeLspCompletionProviderPrivate *priv = ide_lsp_completion_provider_get_instance_private (self);
   GtkSourceCompletionActivation activation;
+  g_autoptr(IdeLspCompletionCacheEntry) created = NULL;
   g_autoptr(IdeTask) task = NULL;
-  g_autoptr(GVariant) params = NULL;
+  g_autofree char *line_text = NULL;
   g_autofree char *uri = NULL;
   GtkTextIter iter, end;
+  IdeLspCompletionCacheEntry *entry;
   GtkSourceBuffer *buffer;
   gint trigger_kind;
   gint line;
@@ -318,37 +439,42 @@ ide_lsp_completion_provider_populate_async (GtkSourceCompletionProvider *provide
   activation = gtk_source_completion_context_get_activation (context);
 
   if (activation == GTK_SOURCE_COMPLETION_ACTIVATION_INTERACTIVE)
-    trigger_kind = 2;
+    trigger_kind = IDE_LSP_COMPLETION_TRIGGER_CHARACTER;
   else
-    trigger_kind = 1;
+    trigger_kind = IDE_LSP_COMPLETION_TRIGGER_INVOKED;
 
   priv->word = gtk_source_completion_context_get_word (context);
+  ide_task_set_task_data (task, g_strdup (priv->word), g_free);
 
   buffer = gtk_source_completion_context_get_buffer (context);
   uri = ide_buffer_dup_uri (IDE_BUFFER (buffer));
 
   line = gtk_text_iter_get_line (&iter);
   column = gtk_text_iter_get_line_offset (&iter);
+  line_text = get_line_text (&iter);
 
-  params = JSONRPC_MESSAGE_NEW (
-    "textDocument", "{",
-      "uri", JSONRPC_MESSAGE_PUT_STRING (uri),
-    "}",
-    "position", "{",
-      "line", JSONRPC_MESSAGE_PUT_INT32 (line),
-      "character", JSONRPC_MESSAGE_PUT_INT32 (column),
-    "}",
-    "context", "{",
-      "triggerKind", JSONRPC_MESSAGE_PUT_INT32 (trigger_kind),
-    "}"
-  );
+  if ((entry = _ide_lsp_completion_cache_lookup (priv->cache, uri, line, column, line_text, g_get_monotonic_time ())) &&
+      _ide_lsp_completion_cache_entry_can_reuse (entry, priv->word))
+    {
+      if (entry->results == NULL)
+        {
+          IDE_TRACE_MSG ("Waiting for in-flight completion request");
+          g_ptr_array_add (entry->waiters, g_steal_pointer (&task));
+        }
+      else
+        {
+          IDE_TRACE_MSG ("Reusing cached completion results");
+          ide_task_return_object (task,
+                                  ide_lsp_completion_provider_create_results (self, entry->results, priv->word));
+        }
 
-  ide_lsp_client_call_async (priv->client,
-                             "textDocument/completion",
-                             params,
-                             cancellable,
-                             ide_lsp_completion_provider_complete_cb,
-                             g_steal_pointer (&task));
+      IDE_EXIT;
+    }
+
+  created = _ide_lsp_completion_cache_entry_new (uri, line, column, line_text, priv->word);
+  g_ptr_array_add (created->waiters, g_steal_pointer (&task));
+  _ide_lsp_completion_cache_insert (priv->cache, created);
+  ide_lsp_completion_provider_request (priv->client, created, trigger_kind);
 
   IDE_EXIT;
 }
@@ -370,6 +496,37 @@ ide_lsp_completion_provider_populate_finish (GtkSourceCompletionProvider  *provi
   IDE_RETURN (ret);
 }
 
+static void
+ide_lsp_completion_provider_refresh_cb (GObject      *object,
+                                        GAsyncResult *result,
+                                        gpointer      user_data)
+{
+  IdeLspCompletionProvider *self = (IdeLspCompletionProvider *)object;
+  IdeLspCompletionProviderPrivate *priv = ide_lsp_completion_provider_get_instance_private (self);
+  g_autoptr(IdeLspCompletionResults) results = user_data;
+  g_autoptr(IdeLspCompletionResults) fresh = NULL;
+  g_autoptr(GError) error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_LSP_COMPLETION_PROVIDER (self));
+  g_assert (IDE_IS_TASK (result));
+  g_assert (IDE_IS_LSP_COMPLETION_RESULTS (results));
+
+  if (!(fresh = ide_task_propagate_object (IDE_TASK (result), &error)))
+    {
+      g_debug ("Failed to refresh incomplete completion results: %s", error->message);
+      IDE_EXIT;
+    }
+
+  _ide_lsp_completion_results_replace (results, fresh);
+
+  if (priv->refilter_word != NULL)
+    ide_lsp_completion_results_refilter (results, priv->refilter_word);
+
+  IDE_EXIT;
+}
+
 static void
 ide_lsp_completion_provider_refilter (GtkSourceCompletionProvider *provider,
                                       GtkSourceCompletionContext  *context,
@@ -378,6 +535,7 @@ ide_lsp_completion_provider_refilter (GtkSourceCompletionProvider *provider,
   IdeLspCompletionProvider *self = (IdeLspCompletionProvider *)provider;
   IdeLspCompletionProviderPrivate *priv = ide_lsp_completion_provider_get_instance_private (self);
   IdeLspCompletionResults *results = (IdeLspCompletionResults *)model;
+  GtkTextIter begin, end;
 
   g_assert (IDE_IS_LSP_COMPLETION_PROVIDER (self));
   g_assert (GTK_SOURCE_IS_COMPLETION_CONTEXT (context));
@@ -387,6 +545,42 @@ ide_lsp_completion_provider_refilter (GtkSourceCompletionProvider *provider,
   priv->refilter_word = gtk_source_completion_context_get_word (context);
 
   ide_lsp_completion_results_refilter (results, priv->refilter_word);
+
+  /* An incomplete result set has to be requested again as the word grows,
+   * and any result set once the word is shorter than it was requested for.
+   * Keep showing what matched so far until the new results arrive.
+   */
+  if (priv->client != NULL &&
+      gtk_source_completion_context_get_bounds (context, &begin, &end))
+    {
+      g_autofree char *line_text = get_line_text (&begin);
+      g_autofree char *uri = ide_buffer_dup_uri (IDE_BUFFER (gtk_source_completion_context_get_buffer (context)));
+      guint line = gtk_text_iter_get_line (&begin);
+      guint column = gtk_text_iter_get_line_offset (&begin);
+      g_autoptr(IdeLspCompletionCacheEntry) next = NULL;
+      g_autoptr(IdeTask) task = NULL;
+      IdeLspCompletionCacheEntry *entry;
+
+      if (!(entry = _ide_lsp_completion_cache_lookup (priv->cache, uri, line, column, line_text, g_get_monotonic_time ())) ||
+          entry->results == NULL ||
+          _ide_lsp_completion_cache_entry_can_reuse (entry, priv->refilter_word))
+        return;
+
+      task = ide_task_new (self, NULL, ide_lsp_completion_provider_refresh_cb, g_object_ref (results));
+      ide_task_set_source_tag (task, ide_lsp_completion_provider_refilter);
+      ide_task_set_task_data (task, g_strdup (priv->refilter_word), g_free);
+
+      IDE_TRACE_MSG ("Requesting completion results for %s after %s%s",
+                     priv->refilter_word, entry->word,
+                     entry->is_incomplete ? " (incomplete)" : "");
+
+      next = _ide_lsp_completion_cache_entry_new (uri, line, column, line_text, priv->refilter_word);
+      g_ptr_array_add (next->waiters, g_steal_pointer (&task));
+      _ide_lsp_completion_cache_insert (priv->cache, next);
+      ide_lsp_completion_provider_request (priv->client,
+                                           next,
+                                           _ide_lsp_completion_cache_entry_trigger_kind (entry));
+    }
 }
 
 static void
@@ -443,6 +637,7 @@ ide_lsp_completion_provider_activate (GtkSourceCompletionProvider *provider,
   GtkSourceSnippetChunk *chunk;
   GtkSourceBuffer *buffer;
   GtkSourceView *view;
+  IdeContext *ide_context;
   GtkTextIter begin, end;
   const char *text = NULL;
 
@@ -469,6 +664,9 @@ ide_lsp_completion_provider_activate (GtkSourceCompletionProvider *provider,
   gtk_source_view_push_snippet (GTK_SOURCE_VIEW (view), snippet, &begin);
   gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (buffer));
 
+  if ((ide_context = ide_object_get_context (IDE_OBJECT (provider))))
+    ide_completion_history_record_proposal (ide_completion_history_from_context (ide_context), proposal);
+
   additional_text_edits =
     ide_lsp_completion_item_get_additional_text_edits (IDE_LSP_COMPLETION_ITEM (proposal),
                                                        ide_buffer_get_file (IDE_BUFFER (buffer)));
@@ -482,6 +680,79 @@ ide_lsp_completion_provider_activate (GtkSourceCompletionProvider *provider,
                                           NULL);
 }
 
+/* Starts a request as soon as an identifier is started after "." or "::",
+ * before the completion window asks for proposals, so that the reply is
+ * likely to be cached by the time it does.
+ */
+static void
+ide_lsp_completion_provider_prefetch (IdeLspCompletionProvider *self,
+                                      const GtkTextIter        *iter,
+                                      gunichar                  ch)
+{
+  IdeLspCompletionProviderPrivate *priv = ide_lsp_completion_provider_get_instance_private (self);
+  g_autoptr(IdeLspCompletionCacheEntry) entry = NULL;
+  g_autofree char *line_text = NULL;
+  g_autofree char *uri = NULL;
+  g_autofree char *word = NULL;
+  GtkTextBuffer *buffer;
+  GtkTextIter begin;
+  GtkTextIter prev;
+  gunichar prev_ch;
+
+  g_assert (IDE_IS_LSP_COMPLETION_PROVIDER (self));
+  g_assert (iter != NULL);
+
+  if (priv->client == NULL || !(g_unichar_isalpha (ch) || ch == '_'))
+    return;
+
+  buffer = gtk_text_iter_get_buffer (iter);
+  if (!IDE_IS_BUFFER (buffer))
+    return;
+
+  /* @iter is placed after the inserted character */
+  begin = *iter;
+  if (!gtk_text_iter_backward_char (&begin) || gtk_text_iter_get_char (&begin) != ch)
+    return;
+
+  prev = begin;
+  if (!gtk_text_iter_backward_char (&prev))
+    return;
+
+  prev_ch = gtk_text_iter_get_char (&prev);
+
+  if (prev_ch == ':')
+    {
+      if (!gtk_text_iter_backward_char (&prev) || gtk_text_iter_get_char (&prev) != ':')
+        return;
+    }
+  else if (prev_ch != '.')
+    {
+      return;
+    }
+
+  uri = ide_buffer_dup_uri (IDE_BUFFER (buffer));
+  line_text = get_line_text (&begin);
+  word = gtk_text_iter_get_slice (&begin, iter);
+
+  if (_ide_lsp_completion_cache_lookup (priv->cache,
+                                        uri,
+                                        gtk_text_iter_get_line (&begin),
+                                        gtk_text_iter_get_line_offset (&begin),
+                                        line_text,
+                                        g_get_monotonic_time ()))
+    return;
+
+  IDE_TRACE_MSG ("Prefetching completion results for %s", word);
+
+  entry = _ide_lsp_completion_cache_entry_new (uri,
+                                               gtk_text_iter_get_line (&begin),
+                                               gtk_text_iter_get_line_offset (&begin),
+                                               line_text,
+                                               word);
+  _ide_lsp_completion_cache_insert (priv->cache, entry);
+  ide_lsp_completion_provider_request (priv->client, entry, IDE_LSP_COMPLETION_TRIGGER_CHARACTER);
+}
+
 static gboolean
 ide_lsp_completion_provider_is_trigger (GtkSourceCompletionProvider *provider,
                                         const GtkTextIter           *iter,
@@ -495,6 +766,8 @@ ide_lsp_completion_provider_is_trigger (GtkSourceCompletionProvider *provider,
   g_assert (IDE_IS_LSP_COMPLETION_PROVIDER (self));
   g_assert (iter != NULL);
 
+  ide_lsp_completion_provider_prefetch (self, iter, ch);
+
   trigger_chars = priv->trigger_chars ? (const char * const *)priv->trigger_chars : default_trigger_chars;
 
   for (guint i = 0; trigger_chars[i]; i++)
@@ -0,0 +1,34 @@
+/* ide-lsp-completion-results-private.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <libide-sourceview.h>
+
+#include "ide-lsp-completion-results.h"
+
+G_BEGIN_DECLS
+
+IdeLspCompletionResults *_ide_lsp_completion_results_new_with_history (GVariant                *results,
+                                                                       IdeCompletionHistory    *history);
+void                     _ide_lsp_completion_results_replace          (IdeLspCompletionResults *self,
+                                                                       IdeLspCompletionResults *other);
+
+G_END_DECLS
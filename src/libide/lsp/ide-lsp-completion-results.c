@@ -25,21 +25,15 @@
 #include <libide-sourceview.h>
 
 #include "ide-lsp-completion-item.h"
-#include "ide-lsp-completion-results.h"
+#include "ide-lsp-completion-results-private.h"
 
 struct _IdeLspCompletionResults
 {
-  GObject   parent_instance;
-  GVariant *results;
-  GArray   *items;
+  GObject              parent_instance;
+  GVariant            *results;
+  IdeCompletionRanker *ranker;
 };
 
-typedef struct
-{
-  guint index;
-  guint priority;
-} Item;
-
 static void list_model_iface_init (GListModelInterface *iface);
 
 G_DEFINE_FINAL_TYPE_WITH_CODE (IdeLspCompletionResults, ide_lsp_completion_results, G_TYPE_OBJECT,
@@ -50,8 +44,8 @@ ide_lsp_completion_results_finalize (GObject *object)
 {
   IdeLspCompletionResults *self = (IdeLspCompletionResults *)object;
 
+  g_clear_object (&self->ranker);
   g_clear_pointer (&self->results, g_variant_unref);
-  g_clear_pointer (&self->items, g_array_unref);
 
   G_OBJECT_CLASS (ide_lsp_completion_results_parent_class)->finalize (object);
 }
@@ -67,19 +61,24 @@ ide_lsp_completion_results_class_init (IdeLspCompletionResultsClass *klass)
 static void
 ide_lsp_completion_results_init (IdeLspCompletionResults *self)
 {
-  self->items = g_array_new (FALSE, FALSE, sizeof (Item));
 }
 
 IdeLspCompletionResults *
-ide_lsp_completion_results_new (GVariant *results)
+_ide_lsp_completion_results_new_with_history (GVariant             *results,
+                                              IdeCompletionHistory *history)
 {
   IdeLspCompletionResults *self;
   g_autoptr(GVariant) items = NULL;
+  GVariantIter iter;
+  GVariant *node;
+  guint index = 0;
 
   g_return_val_if_fail (results != NULL, NULL);
+  g_return_val_if_fail (!history || IDE_IS_COMPLETION_HISTORY (history), NULL);
 
   self = g_object_new (IDE_TYPE_LSP_COMPLETION_RESULTS, NULL);
   self->results = g_variant_ref_sink (results);
+  self->ranker = ide_completion_ranker_new (history);
 
   /* Possibly unwrap the {items: []} style result. */
   if (g_variant_is_of_type (results, G_VARIANT_TYPE_VARDICT) &&
@@ -93,11 +92,59 @@ ide_lsp_completion_results_new (GVariant *results)
         self->results = g_steal_pointer (&items);
     }
 
-  ide_lsp_completion_results_refilter (self, NULL);
+  /* Keywords are borrowed from @results, which outlives the ranker, so they
+   * only need to be extracted once rather than on every refilter. Some
+   * servers leave out the label, so fall back to the text used to filter
+   * or insert the item so that it may still be matched.
+   */
+  g_variant_iter_init (&iter, self->results);
+  while (g_variant_iter_loop (&iter, "v", &node))
+    {
+      const char *keyword;
+
+      if (g_variant_lookup (node, "label", "&s", &keyword) ||
+          g_variant_lookup (node, "filterText", "&s", &keyword) ||
+          g_variant_lookup (node, "insertText", "&s", &keyword))
+        ide_completion_ranker_add_candidate (self->ranker, index, keyword);
+
+      index++;
+    }
+
+  ide_completion_ranker_refilter (self->ranker, NULL);
 
   return self;
 }
 
+IdeLspCompletionResults *
+ide_lsp_completion_results_new (GVariant *results)
+{
+  return _ide_lsp_completion_results_new_with_history (results, NULL);
+}
+
+/* Takes the result set of @other, used when a newer reply for the same
+ * completion replaces an incomplete one while the model is displayed.
+ */
+void
+_ide_lsp_completion_results_replace (IdeLspCompletionResults *self,
+                                     IdeLspCompletionResults *other)
+{
+  guint old_len;
+
+  g_return_if_fail (IDE_IS_LSP_COMPLETION_RESULTS (self));
+  g_return_if_fail (IDE_IS_LSP_COMPLETION_RESULTS (other));
+
+  old_len = ide_completion_ranker_get_n_matches (self->ranker);
+
+  g_clear_pointer (&self->results, g_variant_unref);
+  self->results = g_variant_ref (other->results);
+  g_set_object (&self->ranker, other->ranker);
+
+  g_list_model_items_changed (G_LIST_MODEL (self),
+                              0,
+                              old_len,
+                              ide_completion_ranker_get_n_matches (self->ranker));
+}
+
 static GType
 ide_lsp_completion_results_get_item_type (GListModel *model)
 {
@@ -111,7 +158,7 @@ ide_lsp_completion_results_get_n_items (GListModel *model)
 
   g_assert (IDE_IS_LSP_COMPLETION_RESULTS (self));
 
-  return self->items->len;
+  return ide_completion_ranker_get_n_matches (self->ranker);
 }
 
 static gpointer
@@ -120,13 +167,16 @@ ide_lsp_completion_results_get_item (GListModel *model,
 {
   IdeLspCompletionResults *self = (IdeLspCompletionResults *)model;
   g_autoptr(GVariant) child = NULL;
-  const Item *item;
+  guint index;
 
   g_assert (IDE_IS_LSP_COMPLETION_RESULTS (self));
   g_assert (self->results != NULL);
 
-  item = &g_array_index (self->items, Item, position);
-  child = g_variant_get_child_value (self->results, item->index);
+  if (position >= ide_completion_ranker_get_n_matches (self->ranker))
+    return NULL;
+
+  index = ide_completion_ranker_get_index (self->ranker, position);
+  child = g_variant_get_child_value (self->results, index);
 
   return ide_lsp_completion_item_new (child);
 }
@@ -139,68 +189,17 @@ list_model_iface_init (GListModelInterface *iface)
   iface->get_item_type = ide_lsp_completion_results_get_item_type;
 }
 
-static gint
-compare_items (const Item *a,
-               const Item *b)
-{
-  return (gint)a->priority - (gint)b->priority;
-}
-
 void
 ide_lsp_completion_results_refilter (IdeLspCompletionResults *self,
                                      const char              *typed_text)
 {
-  g_autofree gchar *query = NULL;
-  GVariantIter iter;
-  GVariant *node;
-  guint index = 0;
   guint old_len;
+  guint new_len;
 
   g_return_if_fail (IDE_IS_LSP_COMPLETION_RESULTS (self));
 
-  if ((old_len = self->items->len))
-    g_array_remove_range (self->items, 0, old_len);
-
-  if (self->results == NULL)
-    return;
-
-  if (typed_text == NULL || *typed_text == 0)
-    {
-      guint n_items = g_variant_n_children (self->results);
-
-      for (guint i = 0; i < n_items; i++)
-        {
-          Item item = { .index = i };
-          g_array_append_val (self->items, item);
-        }
-
-      g_list_model_items_changed (G_LIST_MODEL (self), 0, old_len, n_items);
-
-      return;
-    }
-
-  query = g_utf8_casefold (typed_text, -1);
-
-  g_variant_iter_init (&iter, self->results);
-
-  while (g_variant_iter_loop (&iter, "v", &node))
-    {
-      const gchar *label;
-      guint priority;
-
-      if (!g_variant_lookup (node, "label", "&s", &label))
-        continue;
-
-      if (gtk_source_completion_fuzzy_match (label, query, &priority))
-        {
-          Item item = { .index = index, .priority = priority };
-          g_array_append_val (self->items, item);
-        }
-
-      index++;
-    }
-
-  g_array_sort (self->items, (GCompareFunc)compare_items);
+  old_len = ide_completion_ranker_get_n_matches (self->ranker);
+  new_len = ide_completion_ranker_refilter (self->ranker, typed_text);
 
-  g_list_model_items_changed (G_LIST_MODEL (self), 0, old_len, index);
+  g_list_model_items_changed (G_LIST_MODEL (self), 0, old_len, new_len);
 }
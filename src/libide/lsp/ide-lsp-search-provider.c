@@ -154,74 +154,200 @@ ide_lsp_search_provider_init (IdeLspSearchProvider *self)
 {
 }
 
+/*
+ * A workspace/symbol request in flight. Servers which support partial
+ * results send batches of symbols as $/progress notifications for
+ * @partial_token before the final reply, which are appended to @store
+ * as they arrive. The store is returned to the search engine with the
+ * first batch so that results are displayed without waiting for the
+ * server to finish the whole workspace.
+ */
+typedef struct
+{
+  IdeLspClient *client;
+  IdeTask      *task;
+  GListStore   *store;
+  char         *partial_token;
+  char         *progress_token;
+  gulong        notification_handler;
+  guint         max_results;
+} Search;
+
+static void
+search_free (Search *search)
+{
+  g_clear_signal_handler (&search->notification_handler, search->client);
+  g_clear_object (&search->client);
+  g_clear_object (&search->task);
+  g_clear_object (&search->store);
+  g_clear_pointer (&search->partial_token, g_free);
+  g_clear_pointer (&search->progress_token, g_free);
+  g_slice_free (Search, search);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (Search, search_free)
+
+static IdeLspSearchResult *
+ide_lsp_search_provider_decode (GVariant *symbol_information)
+{
+  g_autoptr(IdeLocation) location = NULL;
+  g_autoptr(GFile) gfile = NULL;
+  g_autofree char *base = NULL;
+  IdeSymbolKind symbol_kind;
+  const char *icon_name;
+  const char *title = NULL;
+  const char *uri = NULL;
+  gint64 kind = 0;
+  gint64 line = 0;
+  gint64 character = 0;
+
+  if (!JSONRPC_MESSAGE_PARSE (symbol_information,
+                              "name", JSONRPC_MESSAGE_GET_STRING (&title),
+                              "kind", JSONRPC_MESSAGE_GET_INT64 (&kind),
+                              "location", "{",
+                                "uri", JSONRPC_MESSAGE_GET_STRING (&uri),
+                              "}"))
+    return NULL;
+
+  /* WorkspaceSymbol may omit the range, to be resolved later */
+  JSONRPC_MESSAGE_PARSE (symbol_information,
+                         "location", "{",
+                           "range", "{",
+                             "start", "{",
+                               "line", JSONRPC_MESSAGE_GET_INT64 (&line),
+                               "character", JSONRPC_MESSAGE_GET_INT64 (&character),
+                             "}",
+                           "}",
+                         "}");
+
+  symbol_kind = ide_lsp_decode_symbol_kind (kind);
+  icon_name = ide_symbol_kind_get_icon_name (symbol_kind);
+
+  gfile = g_file_new_for_uri (uri);
+  location = ide_location_new (gfile, line, character);
+  base = g_file_get_basename (gfile);
+
+  return ide_lsp_search_result_new (title, base, location, icon_name);
+}
+
+static void
+search_append (Search   *search,
+               GVariant *symbols)
+{
+  g_autoptr(GPtrArray) items = NULL;
+  GVariantIter iter;
+  GVariant *symbol_information;
+  guint n_items;
+
+  g_assert (search != NULL);
+
+  if (symbols == NULL || !g_variant_is_of_type (symbols, G_VARIANT_TYPE ("av")))
+    return;
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (search->store));
+  items = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_variant_iter_init (&iter, symbols);
+  while (n_items + items->len < search->max_results &&
+         g_variant_iter_loop (&iter, "v", &symbol_information))
+    {
+      IdeLspSearchResult *item;
+
+      if ((item = ide_lsp_search_provider_decode (symbol_information)))
+        g_ptr_array_add (items, item);
+    }
+
+  /* Insert the whole batch at once to emit a single items-changed */
+  if (items->len > 0)
+    g_list_store_splice (search->store, n_items, 0, items->pdata, items->len);
+}
+
+static void
+search_return (Search *search)
+{
+  g_autoptr(IdeTask) task = g_steal_pointer (&search->task);
+
+  if (task != NULL)
+    ide_task_return_pointer (task, g_object_ref (search->store), g_object_unref);
+}
+
+static void
+ide_lsp_search_provider_progress_cb (IdeLspClient *client,
+                                     const char   *method,
+                                     GVariant     *params,
+                                     Search       *search)
+{
+  g_autoptr(GVariant) value = NULL;
+  const char *token = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_LSP_CLIENT (client));
+  g_assert (search != NULL);
+
+  if (params == NULL ||
+      !g_variant_lookup (params, "token", "&s", &token) ||
+      !(value = g_variant_lookup_value (params, "value", NULL)))
+    IDE_EXIT;
+
+  if (g_variant_is_of_type (value, G_VARIANT_TYPE_VARIANT))
+    {
+      GVariant *unboxed = g_variant_get_variant (value);
+      g_variant_unref (value);
+      value = unboxed;
+    }
+
+  if (g_strcmp0 (token, search->partial_token) == 0)
+    {
+      IDE_TRACE_MSG ("Received partial workspace/symbol results");
+      search_append (search, value);
+      search_return (search);
+    }
+  else if (g_strcmp0 (token, search->progress_token) != 0)
+    {
+      IDE_EXIT;
+    }
+
+  /* Work done progress for the search is not interesting enough to be
+   * displayed as a notification, so do not let the client handle it.
+   */
+  g_signal_stop_emission_by_name (client, "notification::$/progress");
+
+  IDE_EXIT;
+}
+
 static void
 ide_lsp_search_provider_search_cb (GObject      *object,
                                    GAsyncResult *result,
                                    gpointer      user_data)
 {
   IdeLspClient *client = (IdeLspClient *)object;
-  g_autoptr(IdeTask) task = user_data;
-  g_autoptr(GVariantIter) iter = NULL;
-  g_autoptr(GListStore) store = NULL;
+  g_autoptr(Search) search = user_data;
   g_autoptr(GVariant) res = NULL;
   g_autoptr(GError) error = NULL;
-  GVariant *symbol_information;
 
   IDE_ENTRY;
 
   g_assert (IDE_IS_MAIN_THREAD ());
   g_assert (IDE_IS_LSP_CLIENT (client));
   g_assert (G_IS_ASYNC_RESULT (result));
-  g_assert (IDE_IS_TASK (task));
+  g_assert (search != NULL);
 
   if (!ide_lsp_client_call_finish (client, result, &res, &error))
     {
-      ide_task_return_error (task, g_steal_pointer (&error));
-      IDE_EXIT;
-    }
-
-  store = g_list_store_new (IDE_TYPE_SEARCH_RESULT);
-  iter = g_variant_iter_new (res);
+      /* Partial results may have been returned already */
+      if (search->task != NULL)
+        ide_task_return_error (search->task, g_steal_pointer (&error));
+      else
+        g_debug ("workspace/symbol failed after partial results: %s", error->message);
 
-  while (g_variant_iter_loop (iter, "v", &symbol_information))
-    {
-      g_autoptr(IdeLspSearchResult) item = NULL;
-      g_autoptr(IdeLocation) location = NULL;
-      g_autoptr(GFile) gfile = NULL;
-      g_autofree char *base = NULL;
-      IdeSymbolKind symbol_kind;
-      const char *icon_name;
-      const char *title;
-      const char *uri;
-      gint64 kind;
-      gint64 line;
-      gint64 character;
-
-      JSONRPC_MESSAGE_PARSE (symbol_information,
-                             "name", JSONRPC_MESSAGE_GET_STRING (&title),
-                             "kind", JSONRPC_MESSAGE_GET_INT64 (&kind),
-                             "location", "{",
-                               "uri", JSONRPC_MESSAGE_GET_STRING (&uri),
-                               "range", "{",
-                                 "start", "{",
-                                   "line", JSONRPC_MESSAGE_GET_INT64 (&line),
-                                   "character", JSONRPC_MESSAGE_GET_INT64 (&character),
-                                 "}",
-                               "}",
-                             "}");
-
-      symbol_kind = ide_lsp_decode_symbol_kind (kind);
-      icon_name = ide_symbol_kind_get_icon_name (symbol_kind);
-
-      gfile = g_file_new_for_uri (uri);
-      location = ide_location_new (gfile, line, character);
-      base = g_file_get_basename (gfile);
-
-      item = ide_lsp_search_result_new (title, base, location, icon_name);
-      g_list_store_append (store, item);
+      IDE_EXIT;
     }
 
-  ide_task_return_pointer (task, g_steal_pointer (&store), g_object_unref);
+  /* With partial results, the reply only contains the remainder */
+  search_append (search, res);
+  search_return (search);
 
   IDE_EXIT;
 }
@@ -234,10 +360,13 @@ ide_lsp_search_provider_search_async (IdeSearchProvider   *provider,
                                       GAsyncReadyCallback  callback,
                                       gpointer             user_data)
 {
+  static guint last_search_id;
   IdeLspSearchProvider *self = (IdeLspSearchProvider *)provider;
   IdeLspSearchProviderPrivate *priv = ide_lsp_search_provider_get_instance_private (self);
   g_autoptr(IdeTask) task = NULL;
   g_autoptr(GVariant) params = NULL;
+  Search *search;
+  guint search_id;
 
   IDE_ENTRY;
 
@@ -258,14 +387,34 @@ ide_lsp_search_provider_search_async (IdeSearchProvider   *provider,
       IDE_EXIT;
     }
 
-  params = JSONRPC_MESSAGE_NEW ("query", JSONRPC_MESSAGE_PUT_STRING (query));
-
+  search_id = ++last_search_id;
+
+  search = g_slice_new0 (Search);
+  search->client = g_object_ref (priv->client);
+  search->task = g_steal_pointer (&task);
+  search->store = g_list_store_new (IDE_TYPE_SEARCH_RESULT);
+  search->partial_token = g_strdup_printf ("builder-workspace-symbol-partial-%u", search_id);
+  search->progress_token = g_strdup_printf ("builder-workspace-symbol-progress-%u", search_id);
+  search->max_results = max_results ? max_results : G_MAXUINT;
+  search->notification_handler =
+    g_signal_connect (priv->client,
+                      "notification::$/progress",
+                      G_CALLBACK (ide_lsp_search_provider_progress_cb),
+                      search);
+
+  params = JSONRPC_MESSAGE_NEW (
+    "query", JSONRPC_MESSAGE_PUT_STRING (query),
+    "workDoneToken", JSONRPC_MESSAGE_PUT_STRING (search->progress_token),
+    "partialResultToken", JSONRPC_MESSAGE_PUT_STRING (search->partial_token)
+  );
+
+  /* Cancelling sends $/cancelRequest, which happens when the query changes */
   ide_lsp_client_call_async (priv->client,
                              "workspace/symbol",
                              params,
                              cancellable,
                              ide_lsp_search_provider_search_cb,
-                             g_steal_pointer (&task));
+                             search);
 
   IDE_EXIT;
 }
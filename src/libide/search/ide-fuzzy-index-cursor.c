@@ -37,6 +37,18 @@ struct _IdeFuzzyIndexCursor
   GArray          *matches;
   guint            max_matches;
   guint            case_sensitive : 1;
+
+  /*
+   * The casefolded query without whitespace, which is the sequence of
+   * character tables that were walked, along with the sorted lookaside
+   * ids which matched it before deduplication and truncation. Queries
+   * which extend @needle can only match a subset of @candidates.
+   */
+  gchar           *needle;
+  GArray          *candidates;
+
+  /* Only set until the worker has completed */
+  IdeFuzzyIndexCursor *previous;
 };
 
 typedef struct
@@ -127,6 +139,9 @@ ide_fuzzy_index_cursor_finalize (GObject *object)
   g_clear_pointer (&self->query, g_free);
   g_clear_pointer (&self->matches, g_array_unref);
   g_clear_pointer (&self->tables, g_variant_dict_unref);
+  g_clear_pointer (&self->needle, g_free);
+  g_clear_pointer (&self->candidates, g_array_unref);
+  g_clear_object (&self->previous);
 
   G_OBJECT_CLASS (ide_fuzzy_index_cursor_parent_class)->finalize (object);
 }
@@ -326,6 +341,37 @@ fuzzy_do_match (const IdeFuzzyLookup    *lookup,
   return FALSE;
 }
 
+static gsize
+fuzzy_lower_bound (const IdeFuzzyIndexItem *table,
+                   gsize                    n_elements,
+                   gsize                    begin,
+                   guint                    lookaside_id)
+{
+  gsize end = n_elements;
+
+  while (begin < end)
+    {
+      gsize mid = begin + (end - begin) / 2;
+
+      if (table[mid].lookaside_id < lookaside_id)
+        begin = mid + 1;
+      else
+        end = mid;
+    }
+
+  return begin;
+}
+
+static gint
+compare_uint (gconstpointer a,
+              gconstpointer b)
+{
+  guint ua = *(const guint *)a;
+  guint ub = *(const guint *)b;
+
+  return ua < ub ? -1 : ua > ub;
+}
+
 static void
 ide_fuzzy_index_cursor_worker (GTask        *task,
                                gpointer      source_object,
@@ -337,20 +383,26 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
   g_autoptr(GHashTable) by_document = NULL;
   g_autoptr(GPtrArray) tables = NULL;
   g_autoptr(GArray) tables_n_elements = NULL;
+  g_autoptr(GArray) candidates = NULL;
+  g_autoptr(GString) needle = NULL;
   g_autofree gint *tables_state = NULL;
   g_autofree gchar *freeme = NULL;
+  const GArray *previous = NULL;
   const gchar *query;
   IdeFuzzyLookup lookup = { 0 };
   GHashTableIter iter;
   const gchar *str;
   gpointer key, value;
+  gint64 begin_time;
   guint i;
 
   g_assert (IDE_IS_FUZZY_INDEX_CURSOR (self));
   g_assert (G_IS_TASK (task));
 
+  begin_time = g_get_monotonic_time ();
+
   if (g_task_return_error_if_cancelled (task))
-    return;
+    goto finish;
 
   /* No matches with empty query */
   if (self->query == NULL || *self->query == '\0')
@@ -361,11 +413,38 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
   if (!self->case_sensitive)
     query = freeme = g_utf8_casefold (query, -1);
 
+  needle = g_string_new (NULL);
+  for (str = query; *str; str = g_utf8_next_char (str))
+    {
+      gunichar ch = g_utf8_get_char (str);
+
+      if (!g_unichar_isspace (ch))
+        g_string_append_unichar (needle, ch);
+    }
+
+  if (needle->len == 0)
+    goto cleanup;
+
+  /* From here on the candidates are valid for @needle, even if no
+   * table exists for one of the characters (leaving it empty).
+   */
+  candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  /* If the previous query was a prefix of this one, then we only need
+   * to check the documents which matched it. This is the normal case
+   * as the user types into a search entry.
+   */
+  if (self->previous != NULL &&
+      self->previous->tables == self->tables &&
+      self->previous->candidates != NULL &&
+      g_str_has_prefix (needle->str, self->previous->needle))
+    previous = self->previous->candidates;
+
   tables = g_ptr_array_new ();
   tables_n_elements = g_array_new (FALSE, FALSE, sizeof (gsize));
   matches = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)ide_int_pair_free);
 
-  for (str = query; *str; str = g_utf8_next_char (str))
+  for (str = needle->str; *str; str = g_utf8_next_char (str))
     {
       gunichar ch = g_utf8_get_char (str);
       g_autoptr(GVariant) table = NULL;
@@ -373,9 +452,6 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
       gsize n_elements;
       gchar char_key[8];
 
-      if (g_unichar_isspace (ch))
-        continue;
-
       char_key [g_unichar_to_utf8 (ch, char_key)] = '\0';
       table = g_variant_dict_lookup_value (self->tables,
                                            char_key,
@@ -390,9 +466,6 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
       g_ptr_array_add (tables, (gpointer)fixed);
     }
 
-  if (tables->len == 0)
-    goto cleanup;
-
   g_assert (tables->len > 0);
   g_assert (tables->len == tables_n_elements->len);
 
@@ -409,26 +482,87 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
 
   if G_LIKELY (lookup.n_tables > 1)
     {
-      for (i = 0; i < lookup.tables_n_elements[0]; i++)
+      if (previous == NULL)
+        {
+          for (i = 0; i < lookup.tables_n_elements[0]; i++)
+            {
+              const IdeFuzzyIndexItem *item = &lookup.tables[0][i];
+
+              fuzzy_do_match (&lookup, item, 1, MIN (16, item->position * 2));
+            }
+        }
+      else
         {
-          const IdeFuzzyIndexItem *item = &lookup.tables[0][i];
+          gsize pos = 0;
+
+          /* Jump each table forward to the candidate rather than walking
+           * every item in between. Since the tables are sorted by
+           * lookaside id, this visits the same items as the full walk
+           * would for the candidate.
+           */
+          for (i = 0; i < previous->len; i++)
+            {
+              guint lookaside_id = g_array_index (previous, guint, i);
 
-          fuzzy_do_match (&lookup, item, 1, MIN (16, item->position * 2));
+              pos = fuzzy_lower_bound (lookup.tables[0], lookup.tables_n_elements[0], pos, lookaside_id);
+
+              for (guint j = 1; j < lookup.n_tables; j++)
+                tables_state[j] = fuzzy_lower_bound (lookup.tables[j],
+                                                     lookup.tables_n_elements[j],
+                                                     MAX (0, tables_state[j]),
+                                                     lookaside_id);
+
+              for (; pos < lookup.tables_n_elements[0]; pos++)
+                {
+                  const IdeFuzzyIndexItem *item = &lookup.tables[0][pos];
+
+                  if (item->lookaside_id != lookaside_id)
+                    break;
+
+                  fuzzy_do_match (&lookup, item, 1, MIN (16, item->position * 2));
+                }
+            }
         }
     }
   else
     {
       guint last_id = G_MAXUINT;
+      gsize pos = 0;
 
-      for (i = 0; i < lookup.tables_n_elements[0]; i++)
+      for (i = 0; ; i++)
         {
-          const IdeFuzzyIndexItem *item = &lookup.tables[0][i];
+          const IdeFuzzyIndexItem *item;
           IdeFuzzyMatch match;
 
+          if (previous == NULL)
+            {
+              if (i >= lookup.tables_n_elements[0])
+                break;
+              pos = i;
+            }
+          else
+            {
+              if (i >= previous->len)
+                break;
+              pos = fuzzy_lower_bound (lookup.tables[0],
+                                       lookup.tables_n_elements[0],
+                                       pos,
+                                       g_array_index (previous, guint, i));
+              if (pos >= lookup.tables_n_elements[0])
+                break;
+            }
+
+          item = &lookup.tables[0][pos];
+
+          if (previous != NULL && item->lookaside_id != g_array_index (previous, guint, i))
+            continue;
+
           if (item->lookaside_id != last_id)
             {
               last_id = item->lookaside_id;
 
+              g_array_append_val (candidates, item->lookaside_id);
+
               if G_UNLIKELY (!_ide_fuzzy_index_resolve (self->index,
                                                         item->lookaside_id,
                                                         &match.document_id,
@@ -447,7 +581,7 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
     }
 
   if (g_task_return_error_if_cancelled (task))
-    return;
+    goto finish;
 
   by_document = g_hash_table_new (NULL, NULL);
 
@@ -462,6 +596,8 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
       IdeFuzzyMatch match = {0};
       guint lookaside_id = GPOINTER_TO_UINT (key);
 
+      g_array_append_val (candidates, lookaside_id);
+
       if G_UNLIKELY (!_ide_fuzzy_index_resolve (self->index,
                                                 lookaside_id,
                                                 &match.document_id,
@@ -486,6 +622,8 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
       g_array_append_val (self->matches, match);
     }
 
+  g_array_sort (candidates, compare_uint);
+
   /*
    * Because we have to do the deduplication of documents after
    * searching all the potential matches, we could have duplicates
@@ -516,7 +654,7 @@ ide_fuzzy_index_cursor_worker (GTask        *task,
     }
 
   if (g_task_return_error_if_cancelled (task))
-    return;
+    goto finish;
 
 cleanup:
   if (self->matches != NULL)
@@ -526,7 +664,22 @@ cleanup:
         g_array_set_size (self->matches, lookup.max_matches);
     }
 
+  if (candidates != NULL)
+    {
+      self->needle = g_string_free (g_steal_pointer (&needle), FALSE);
+      self->candidates = g_steal_pointer (&candidates);
+    }
+
+  ide_profiler_mark (begin_time,
+                     g_get_monotonic_time (),
+                     "fuzzy-index",
+                     previous ? "refine" : "query",
+                     self->query);
+
   g_task_return_boolean (task, TRUE);
+
+finish:
+  g_clear_object (&self->previous);
 }
 
 static void
@@ -614,6 +767,17 @@ list_model_iface_init (GListModelInterface *iface)
   iface->get_item = ide_fuzzy_index_cursor_get_item;
 }
 
+void
+_ide_fuzzy_index_cursor_set_previous (IdeFuzzyIndexCursor *self,
+                                      IdeFuzzyIndexCursor *previous)
+{
+  g_return_if_fail (IDE_IS_FUZZY_INDEX_CURSOR (self));
+  g_return_if_fail (!previous || IDE_IS_FUZZY_INDEX_CURSOR (previous));
+  g_return_if_fail (self != previous);
+
+  g_set_object (&self->previous, previous);
+}
+
 /**
  * ide_fuzzy_index_cursor_get_index:
  * @self: A #IdeFuzzyIndexCursor
@@ -19,18 +19,21 @@
 #pragma once
 
 #include "ide-fuzzy-index.h"
+#include "ide-fuzzy-index-cursor.h"
 
 G_BEGIN_DECLS
 
-GVariant *_ide_fuzzy_index_lookup_document (IdeFuzzyIndex  *self,
-                                            guint           document_id);
-gboolean  _ide_fuzzy_index_resolve         (IdeFuzzyIndex  *self,
-                                            guint           lookaside_id,
-                                            guint          *document_id,
-                                            const char    **key,
-                                            guint          *priority,
-                                            guint           in_score,
-                                            guint           last_offset,
-                                            float          *out_score);
+GVariant *_ide_fuzzy_index_lookup_document     (IdeFuzzyIndex        *self,
+                                                guint                 document_id);
+gboolean  _ide_fuzzy_index_resolve             (IdeFuzzyIndex        *self,
+                                                guint                 lookaside_id,
+                                                guint                *document_id,
+                                                const char          **key,
+                                                guint                *priority,
+                                                guint                 in_score,
+                                                guint                 last_offset,
+                                                float                *out_score);
+void      _ide_fuzzy_index_cursor_set_previous (IdeFuzzyIndexCursor  *self,
+                                                IdeFuzzyIndexCursor  *previous);
 
 G_END_DECLS
@@ -109,6 +109,7 @@ ide_fuzzy_index_finalize (GObject *object)
   g_clear_pointer (&self->documents, g_variant_unref);
   g_clear_pointer (&self->keys, g_variant_unref);
   g_clear_pointer (&self->tables, g_variant_dict_unref);
+  g_weak_ref_clear (&self->last_cursor);
   g_clear_pointer (&self->lookaside, g_variant_unref);
   g_clear_pointer (&self->metadata, g_variant_dict_unref);
 
@@ -126,6 +127,7 @@ ide_fuzzy_index_class_init (IdeFuzzyIndexClass *klass)
 static void
 ide_fuzzy_index_init (IdeFuzzyIndex *self)
 {
+  g_weak_ref_init (&self->last_cursor, NULL);
 }
 
 IdeFuzzyIndex *
@@ -309,15 +311,22 @@ ide_fuzzy_index_query_cb (GObject      *object,
   IdeFuzzyIndexCursor *cursor = (IdeFuzzyIndexCursor *)object;
   g_autoptr(GTask) task = user_data;
   g_autoptr(GError) error = NULL;
+  IdeFuzzyIndex *self;
 
   g_assert (IDE_IS_FUZZY_INDEX_CURSOR (cursor));
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (G_IS_TASK (task));
 
+  self = g_task_get_source_object (task);
+
   if (!g_async_initable_init_finish (G_ASYNC_INITABLE (cursor), result, &error))
-    g_task_return_error (task, g_steal_pointer (&error));
-  else
-    g_task_return_pointer (task, g_object_ref (cursor), g_object_unref);
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  g_weak_ref_set (&self->last_cursor, cursor);
+  g_task_return_pointer (task, g_object_ref (cursor), g_object_unref);
 }
 
 void
@@ -330,6 +339,7 @@ ide_fuzzy_index_query_async (IdeFuzzyIndex       *self,
 {
   g_autoptr(GTask) task = NULL;
   g_autoptr(IdeFuzzyIndexCursor) cursor = NULL;
+  g_autoptr(IdeFuzzyIndexCursor) previous = NULL;
 
   g_return_if_fail (IDE_IS_FUZZY_INDEX (self));
   g_return_if_fail (query != NULL);
@@ -347,6 +357,9 @@ ide_fuzzy_index_query_async (IdeFuzzyIndex       *self,
                          "tables", self->tables,
                          NULL);
 
+  if ((previous = g_weak_ref_get (&self->last_cursor)))
+    _ide_fuzzy_index_cursor_set_previous (cursor, previous);
+
   g_async_initable_init_async (G_ASYNC_INITABLE (cursor),
                                G_PRIORITY_LOW,
                                cancellable,
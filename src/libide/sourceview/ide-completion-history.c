@@ -0,0 +1,491 @@
+/* ide-completion-history.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "ide-completion-history"
+
+#include "config.h"
+
+#include <libide-threading.h>
+
+#include "ide-completion-history.h"
+
+#define HISTORY_VERSION     1
+#define HISTORY_TYPE        "(ua{s(ux)})"
+#define HISTORY_MAX_ENTRIES 2000
+#define SAVE_DELAY_SECONDS  5
+
+/* Boosts are in the same units as the fuzzy match priority, where each
+ * skipped character costs 2. So a proposal picked many times recently
+ * can beat a match which is a few characters tighter.
+ */
+#define MAX_FREQUENCY_BOOST 24
+#define MAX_RECENCY_BOOST   16
+
+/**
+ * SECTION:ide-completion-history
+ * @title: IdeCompletionHistory
+ * @short_description: Tracks completion proposals accepted by the user
+ *
+ * #IdeCompletionHistory records how often and how recently each
+ * completion proposal was accepted within the project. The history is
+ * persisted to the project cache and used by #IdeCompletionRanker to
+ * move proposals the user picks often to the top of the results.
+ *
+ * Since: 44
+ */
+
+struct _IdeCompletionHistory
+{
+  IdeObject   parent_instance;
+
+  /* Keyword -> HistoryEntry */
+  GHashTable *entries;
+
+  guint       save_source;
+  guint       loading : 1;
+  guint       loaded : 1;
+  guint       dirty : 1;
+};
+
+typedef struct
+{
+  guint  count;
+  gint64 last_used;
+} HistoryEntry;
+
+G_DEFINE_FINAL_TYPE (IdeCompletionHistory, ide_completion_history, IDE_TYPE_OBJECT)
+
+static gboolean ide_completion_history_save_cb (gpointer data);
+
+static GFile *
+get_history_file (IdeCompletionHistory *self)
+{
+  IdeContext *context = ide_object_get_context (IDE_OBJECT (self));
+
+  return ide_context_cache_file (context, "completion", "history.gvariant", NULL);
+}
+
+static void
+ide_completion_history_load_worker (IdeTask      *task,
+                                    gpointer      source_object,
+                                    gpointer      task_data,
+                                    GCancellable *cancellable)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) entries = NULL;
+  g_autoptr(GHashTable) table = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  GFile *file = task_data;
+  guint32 version = 0;
+  gsize n_entries;
+
+  g_assert (IDE_IS_TASK (task));
+  g_assert (G_IS_FILE (file));
+
+  table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  if (!(mapped = g_mapped_file_new (g_file_peek_path (file), FALSE, NULL)))
+    goto finish;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (HISTORY_TYPE), bytes, FALSE));
+  g_variant_get (variant, "(u@a{s(ux)})", &version, &entries);
+
+  if (version != HISTORY_VERSION)
+    goto finish;
+
+  n_entries = g_variant_n_children (entries);
+
+  for (gsize i = 0; i < n_entries; i++)
+    {
+      HistoryEntry *entry;
+      const char *keyword;
+      guint32 count;
+      gint64 last_used;
+
+      g_variant_get_child (entries, i, "{&s(ux)}", &keyword, &count, &last_used);
+
+      entry = g_new0 (HistoryEntry, 1);
+      entry->count = count;
+      entry->last_used = last_used;
+
+      g_hash_table_insert (table, g_strdup (keyword), entry);
+    }
+
+finish:
+  ide_task_return_pointer (task, g_steal_pointer (&table), g_hash_table_unref);
+}
+
+static void
+ide_completion_history_load_cb (GObject      *object,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+  IdeCompletionHistory *self = (IdeCompletionHistory *)object;
+  g_autoptr(GHashTable) table = NULL;
+  GHashTableIter iter;
+  HistoryEntry *loaded;
+  char *keyword;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_COMPLETION_HISTORY (self));
+  g_assert (IDE_IS_TASK (result));
+
+  self->loading = FALSE;
+  self->loaded = TRUE;
+
+  /* Saving is held off until now so the file is never replaced with
+   * just the proposals accepted while loading.
+   */
+  if (self->dirty &&
+      self->save_source == 0 &&
+      !ide_object_in_destruction (IDE_OBJECT (self)) &&
+      ide_object_get_context (IDE_OBJECT (self)) != NULL)
+    self->save_source = g_timeout_add_seconds (SAVE_DELAY_SECONDS,
+                                               ide_completion_history_save_cb,
+                                               self);
+
+  if (!(table = ide_task_propagate_pointer (IDE_TASK (result), NULL)))
+    IDE_EXIT;
+
+  /* Merge in proposals accepted while we were loading */
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&keyword, (gpointer *)&loaded))
+    {
+      HistoryEntry *entry;
+
+      if ((entry = g_hash_table_lookup (self->entries, keyword)))
+        {
+          entry->count = (guint)MIN ((guint64)entry->count + loaded->count, G_MAXUINT32);
+          entry->last_used = MAX (entry->last_used, loaded->last_used);
+          continue;
+        }
+
+      g_hash_table_iter_steal (&iter);
+      g_hash_table_insert (self->entries, keyword, loaded);
+    }
+
+  IDE_EXIT;
+}
+
+static void
+ide_completion_history_load (IdeCompletionHistory *self)
+{
+  g_autoptr(IdeTask) task = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_COMPLETION_HISTORY (self));
+
+  if (self->loaded || self->loading || ide_object_in_destruction (IDE_OBJECT (self)))
+    IDE_EXIT;
+
+  self->loading = TRUE;
+
+  /* Proposals are ranked without history until this completes, rather
+   * than blocking the first completion within the project on I/O.
+   */
+  task = ide_task_new (self, NULL, ide_completion_history_load_cb, NULL);
+  ide_task_set_source_tag (task, ide_completion_history_load);
+  ide_task_set_task_data (task, get_history_file (self), g_object_unref);
+  ide_task_run_in_thread (task, ide_completion_history_load_worker);
+
+  IDE_EXIT;
+}
+
+static gint
+compare_by_last_used (gconstpointer a,
+                      gconstpointer b,
+                      gpointer      user_data)
+{
+  GHashTable *entries = user_data;
+  const HistoryEntry *ea = g_hash_table_lookup (entries, *(const char * const *)a);
+  const HistoryEntry *eb = g_hash_table_lookup (entries, *(const char * const *)b);
+
+  if (ea->last_used > eb->last_used)
+    return -1;
+  else if (ea->last_used < eb->last_used)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+ide_completion_history_save (IdeCompletionHistory *self)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GFile) file = NULL;
+  g_autoptr(GFile) parent = NULL;
+  g_autofree const char **keywords = NULL;
+  GVariantBuilder builder;
+  guint n_keywords;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_COMPLETION_HISTORY (self));
+
+  if (!self->dirty || !self->loaded)
+    IDE_EXIT;
+
+  self->dirty = FALSE;
+
+  /* Only keep the most recently used entries so that the table, which
+   * is loaded on every start, stays small.
+   */
+  keywords = (const char **)g_hash_table_get_keys_as_array (self->entries, &n_keywords);
+  g_qsort_with_data (keywords, n_keywords, sizeof (char *), compare_by_last_used, self->entries);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(ux)}"));
+  for (guint i = 0; i < MIN (n_keywords, HISTORY_MAX_ENTRIES); i++)
+    {
+      const HistoryEntry *entry = g_hash_table_lookup (self->entries, keywords[i]);
+
+      g_variant_builder_add (&builder, "{s(ux)}", keywords[i], entry->count, entry->last_used);
+    }
+
+  for (guint i = HISTORY_MAX_ENTRIES; i < n_keywords; i++)
+    g_hash_table_remove (self->entries, keywords[i]);
+
+  variant = g_variant_ref_sink (g_variant_new ("(u@a{s(ux)})",
+                                               HISTORY_VERSION,
+                                               g_variant_builder_end (&builder)));
+  bytes = g_variant_get_data_as_bytes (variant);
+
+  file = get_history_file (self);
+  parent = g_file_get_parent (file);
+  g_file_make_directory_with_parents (parent, NULL, NULL);
+
+  g_file_replace_contents_bytes_async (file,
+                                       bytes,
+                                       NULL,
+                                       FALSE,
+                                       G_FILE_CREATE_REPLACE_DESTINATION,
+                                       NULL,
+                                       NULL,
+                                       NULL);
+
+  IDE_EXIT;
+}
+
+static gboolean
+ide_completion_history_save_cb (gpointer data)
+{
+  IdeCompletionHistory *self = data;
+
+  g_assert (IDE_IS_COMPLETION_HISTORY (self));
+
+  self->save_source = 0;
+  ide_completion_history_save (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+ide_completion_history_destroy (IdeObject *object)
+{
+  IdeCompletionHistory *self = (IdeCompletionHistory *)object;
+
+  g_clear_handle_id (&self->save_source, g_source_remove);
+
+  if (ide_object_get_context (object) != NULL)
+    ide_completion_history_save (self);
+
+  IDE_OBJECT_CLASS (ide_completion_history_parent_class)->destroy (object);
+}
+
+static void
+ide_completion_history_finalize (GObject *object)
+{
+  IdeCompletionHistory *self = (IdeCompletionHistory *)object;
+
+  g_clear_pointer (&self->entries, g_hash_table_unref);
+
+  G_OBJECT_CLASS (ide_completion_history_parent_class)->finalize (object);
+}
+
+static void
+ide_completion_history_class_init (IdeCompletionHistoryClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  IdeObjectClass *i_object_class = IDE_OBJECT_CLASS (klass);
+
+  object_class->finalize = ide_completion_history_finalize;
+
+  i_object_class->destroy = ide_completion_history_destroy;
+}
+
+static void
+ide_completion_history_init (IdeCompletionHistory *self)
+{
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+/**
+ * ide_completion_history_from_context:
+ * @context: an #IdeContext
+ *
+ * Gets the completion history for the project.
+ *
+ * Returns: (transfer none): an #IdeCompletionHistory
+ *
+ * Since: 44
+ */
+IdeCompletionHistory *
+ide_completion_history_from_context (IdeContext *context)
+{
+  IdeCompletionHistory *self;
+
+  g_return_val_if_fail (IDE_IS_MAIN_THREAD (), NULL);
+  g_return_val_if_fail (IDE_IS_CONTEXT (context), NULL);
+
+  ide_object_lock (IDE_OBJECT (context));
+  if (!(self = ide_context_peek_child_typed (context, IDE_TYPE_COMPLETION_HISTORY)))
+    {
+      g_autoptr(IdeCompletionHistory) created = NULL;
+      created = ide_object_ensure_child_typed (IDE_OBJECT (context),
+                                               IDE_TYPE_COMPLETION_HISTORY);
+      self = ide_context_peek_child_typed (context, IDE_TYPE_COMPLETION_HISTORY);
+    }
+  ide_object_unlock (IDE_OBJECT (context));
+
+  return self;
+}
+
+/**
+ * ide_completion_history_record:
+ * @self: an #IdeCompletionHistory
+ * @keyword: the text of the accepted proposal
+ *
+ * Records that the user accepted a completion proposal for @keyword.
+ *
+ * Since: 44
+ */
+void
+ide_completion_history_record (IdeCompletionHistory *self,
+                               const char           *keyword)
+{
+  HistoryEntry *entry;
+
+  g_return_if_fail (IDE_IS_MAIN_THREAD ());
+  g_return_if_fail (IDE_IS_COMPLETION_HISTORY (self));
+
+  if (ide_str_empty0 (keyword))
+    return;
+
+  ide_completion_history_load (self);
+
+  if (!(entry = g_hash_table_lookup (self->entries, keyword)))
+    {
+      entry = g_new0 (HistoryEntry, 1);
+      g_hash_table_insert (self->entries, g_strdup (keyword), entry);
+    }
+
+  if (entry->count < G_MAXUINT32)
+    entry->count++;
+  entry->last_used = g_get_real_time () / G_USEC_PER_SEC;
+
+  self->dirty = TRUE;
+
+  if (self->save_source == 0)
+    self->save_source = g_timeout_add_seconds (SAVE_DELAY_SECONDS,
+                                               ide_completion_history_save_cb,
+                                               self);
+}
+
+/**
+ * ide_completion_history_record_proposal:
+ * @self: an #IdeCompletionHistory
+ * @proposal: the accepted #GtkSourceCompletionProposal
+ *
+ * Records @proposal using its typed text.
+ *
+ * This is meant to be called from the activate implementation of
+ * completion providers which use #IdeCompletionRanker.
+ *
+ * Since: 44
+ */
+void
+ide_completion_history_record_proposal (IdeCompletionHistory        *self,
+                                        GtkSourceCompletionProposal *proposal)
+{
+  g_autofree char *typed_text = NULL;
+
+  g_return_if_fail (IDE_IS_COMPLETION_HISTORY (self));
+  g_return_if_fail (GTK_SOURCE_IS_COMPLETION_PROPOSAL (proposal));
+
+  typed_text = gtk_source_completion_proposal_get_typed_text (proposal);
+  ide_completion_history_record (self, typed_text);
+}
+
+/**
+ * ide_completion_history_get_boost:
+ * @self: an #IdeCompletionHistory
+ * @keyword: the text of a proposal
+ *
+ * Gets how much the priority of a proposal for @keyword should be
+ * improved based on how often and how recently it was accepted.
+ *
+ * Returns: the boost, in units of fuzzy match priority
+ *
+ * Since: 44
+ */
+int
+ide_completion_history_get_boost (IdeCompletionHistory *self,
+                                  const char           *keyword)
+{
+  const HistoryEntry *entry;
+  gint64 age;
+  int boost = 0;
+
+  g_return_val_if_fail (IDE_IS_MAIN_THREAD (), 0);
+  g_return_val_if_fail (IDE_IS_COMPLETION_HISTORY (self), 0);
+
+  if (keyword == NULL)
+    return 0;
+
+  ide_completion_history_load (self);
+
+  if (!(entry = g_hash_table_lookup (self->entries, keyword)))
+    return 0;
+
+  /* Frequency is logarithmic so that a handful of uses matters, but a
+   * proposal used hundreds of times does not drown out a close match.
+   */
+  for (guint count = entry->count; count > 0 && boost < MAX_FREQUENCY_BOOST; count >>= 1)
+    boost += 4;
+  boost = MIN (boost, MAX_FREQUENCY_BOOST);
+
+  age = g_get_real_time () / G_USEC_PER_SEC - entry->last_used;
+
+  if (age < 10 * 60)
+    boost += MAX_RECENCY_BOOST;
+  else if (age < 24 * 60 * 60)
+    boost += MAX_RECENCY_BOOST / 2;
+  else if (age < 7 * 24 * 60 * 60)
+    boost += MAX_RECENCY_BOOST / 4;
+
+  return boost;
+}
@@ -0,0 +1,50 @@
+/* ide-completion-history.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#if !defined (IDE_SOURCEVIEW_INSIDE) && !defined (IDE_SOURCEVIEW_COMPILATION)
+# error "Only <libide-sourceview.h> can be included directly."
+#endif
+
+#include <gtksourceview/gtksource.h>
+
+#include <libide-core.h>
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_COMPLETION_HISTORY (ide_completion_history_get_type())
+
+IDE_AVAILABLE_IN_44
+G_DECLARE_FINAL_TYPE (IdeCompletionHistory, ide_completion_history, IDE, COMPLETION_HISTORY, IdeObject)
+
+IDE_AVAILABLE_IN_44
+IdeCompletionHistory *ide_completion_history_from_context    (IdeContext                  *context);
+IDE_AVAILABLE_IN_44
+void                  ide_completion_history_record          (IdeCompletionHistory        *self,
+                                                              const char                  *keyword);
+IDE_AVAILABLE_IN_44
+void                  ide_completion_history_record_proposal (IdeCompletionHistory        *self,
+                                                              GtkSourceCompletionProposal *proposal);
+IDE_AVAILABLE_IN_44
+int                   ide_completion_history_get_boost       (IdeCompletionHistory        *self,
+                                                              const char                  *keyword);
+
+G_END_DECLS
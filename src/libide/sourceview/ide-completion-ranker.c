@@ -0,0 +1,489 @@
+/* ide-completion-ranker.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "ide-completion-ranker"
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtksourceview/gtksource.h>
+
+#include "ide-text-scan-private.h"
+
+#include "ide-completion-ranker.h"
+
+/* The completion window only shows a handful of rows, so only that many
+ * matches are sorted up front. The rest are sorted if they are scrolled to.
+ */
+#define TOP_K 32
+
+/**
+ * SECTION:ide-completion-ranker
+ * @title: IdeCompletionRanker
+ * @short_description: Filters and sorts completion proposals
+ *
+ * #IdeCompletionRanker is used by completion providers to filter their
+ * proposals against the typed text and sort them, so that providers do
+ * not each need their own fuzzy matching and sorting.
+ *
+ * Proposals are scored with the same cost model as
+ * gtk_source_completion_fuzzy_match(), adjusted by how often and how
+ * recently the user accepted the proposal according to the
+ * #IdeCompletionHistory.
+ *
+ * When the typed text extends the previous typed text, only the previous
+ * matches are scored again.
+ *
+ * Since: 44
+ */
+
+struct _IdeCompletionRanker
+{
+  GObject               parent_instance;
+
+  IdeCompletionHistory *history;
+
+  /* Array of Candidate, in the order they were added */
+  GArray               *candidates;
+
+  /* Array of Match. Matches before @n_sorted are in their final order. */
+  GArray               *matches;
+  guint                 n_sorted;
+
+  /* The casefolded typed text used for @matches, or %NULL */
+  char                 *needle;
+};
+
+typedef struct
+{
+  const char *keyword;
+  guint64     mask;
+  guint       index;
+  guint       len;
+  int         boost;
+} Candidate;
+
+typedef struct
+{
+  guint candidate;
+  int   score;
+} Match;
+
+G_DEFINE_FINAL_TYPE (IdeCompletionRanker, ide_completion_ranker, G_TYPE_OBJECT)
+
+static inline guint64
+char_mask (guchar ch)
+{
+  return G_GUINT64_CONSTANT (1) << (g_ascii_tolower (ch) & 63);
+}
+
+/* Returns a bitmask of the ASCII characters in @str so that candidates
+ * which cannot possibly contain the needle are skipped without scanning.
+ */
+static guint64
+string_mask (const char *str,
+             gsize       len)
+{
+  guint64 mask = 0;
+
+  for (gsize i = 0; i < len; i++)
+    {
+      if ((guchar)str[i] < 0x80)
+        mask |= char_mask (str[i]);
+    }
+
+  return mask;
+}
+
+static inline gboolean
+match_less (const Match *a,
+            const Match *b)
+{
+  return a->score < b->score ||
+         (a->score == b->score && a->candidate < b->candidate);
+}
+
+static int
+compare_match (const void *a,
+               const void *b)
+{
+  if (match_less (a, b))
+    return -1;
+  else if (match_less (b, a))
+    return 1;
+  else
+    return 0;
+}
+
+/* Moves the best @k matches to the front of @matches, in no particular
+ * order, without sorting the whole array.
+ */
+static void
+select_top_k (Match  *matches,
+              gssize  n_matches,
+              gssize  k)
+{
+  gssize kth = k - 1;
+  gssize left = 0;
+  gssize right = n_matches - 1;
+
+  while (left < right)
+    {
+      Match pivot = matches[left + (right - left) / 2];
+      gssize i = left;
+      gssize j = right;
+
+      while (i <= j)
+        {
+          while (match_less (&matches[i], &pivot))
+            i++;
+
+          while (match_less (&pivot, &matches[j]))
+            j--;
+
+          if (i <= j)
+            {
+              Match tmp = matches[i];
+              matches[i] = matches[j];
+              matches[j] = tmp;
+              i++;
+              j--;
+            }
+        }
+
+      if (kth <= j)
+        right = j;
+      else if (kth >= i)
+        left = i;
+      else
+        break;
+    }
+}
+
+/* Same cost model as gtk_source_completion_fuzzy_match() for an ASCII
+ * needle, but each character is located with the vectorized byte scan
+ * instead of two calls to strchr().
+ */
+static gboolean
+fuzzy_match_ascii (const Candidate *candidate,
+                   const char      *needle,
+                   gsize            needle_len,
+                   guint           *priority)
+{
+  const char *haystack = candidate->keyword;
+  const char *end = candidate->keyword + candidate->len;
+  guint score = 0;
+
+  if (candidate->len == 0)
+    return FALSE;
+
+  for (gsize i = 0; i < needle_len; i++)
+    {
+      char ch = needle[i];
+      char chup = g_ascii_toupper (ch);
+      const char *found;
+
+      if (!(found = _ide_text_find_byte2 (haystack, end - haystack, ch, chup)))
+        return FALSE;
+
+      score += (found - haystack) * 2;
+
+      if (*haystack == chup)
+        score += 1;
+
+      haystack = found + 1;
+    }
+
+  *priority = score + (end - haystack);
+
+  return TRUE;
+}
+
+static gboolean
+ide_completion_ranker_score (IdeCompletionRanker *self,
+                             guint                position,
+                             const char          *needle,
+                             gsize                needle_len,
+                             gboolean             needle_is_ascii,
+                             guint64              needle_mask,
+                             int                 *score)
+{
+  const Candidate *candidate = &g_array_index (self->candidates, Candidate, position);
+  guint priority;
+
+  if ((candidate->mask & needle_mask) != needle_mask)
+    return FALSE;
+
+  if (needle_is_ascii)
+    {
+      if (!fuzzy_match_ascii (candidate, needle, needle_len, &priority))
+        return FALSE;
+    }
+  else
+    {
+      if (!gtk_source_completion_fuzzy_match (candidate->keyword, needle, &priority))
+        return FALSE;
+    }
+
+  *score = (int)priority - candidate->boost;
+
+  return TRUE;
+}
+
+static void
+ide_completion_ranker_finalize (GObject *object)
+{
+  IdeCompletionRanker *self = (IdeCompletionRanker *)object;
+
+  g_clear_object (&self->history);
+  g_clear_pointer (&self->candidates, g_array_unref);
+  g_clear_pointer (&self->matches, g_array_unref);
+  g_clear_pointer (&self->needle, g_free);
+
+  G_OBJECT_CLASS (ide_completion_ranker_parent_class)->finalize (object);
+}
+
+static void
+ide_completion_ranker_class_init (IdeCompletionRankerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = ide_completion_ranker_finalize;
+}
+
+static void
+ide_completion_ranker_init (IdeCompletionRanker *self)
+{
+  self->candidates = g_array_new (FALSE, FALSE, sizeof (Candidate));
+  self->matches = g_array_new (FALSE, FALSE, sizeof (Match));
+}
+
+/**
+ * ide_completion_ranker_new:
+ * @history: (nullable): an #IdeCompletionHistory or %NULL
+ *
+ * Creates a new #IdeCompletionRanker.
+ *
+ * If @history is %NULL, proposals are ranked only by how well they
+ * match the typed text.
+ *
+ * Returns: (transfer full): a new #IdeCompletionRanker
+ *
+ * Since: 44
+ */
+IdeCompletionRanker *
+ide_completion_ranker_new (IdeCompletionHistory *history)
+{
+  IdeCompletionRanker *self;
+
+  g_return_val_if_fail (!history || IDE_IS_COMPLETION_HISTORY (history), NULL);
+
+  self = g_object_new (IDE_TYPE_COMPLETION_RANKER, NULL);
+  g_set_object (&self->history, history);
+
+  return self;
+}
+
+/**
+ * ide_completion_ranker_add_candidate:
+ * @self: an #IdeCompletionRanker
+ * @index: the position of the proposal within the provider's results
+ * @keyword: the text to match against the typed text
+ *
+ * Adds a proposal to be ranked. @index is returned from
+ * ide_completion_ranker_get_index() when the proposal matches.
+ *
+ * @keyword is not copied and must remain valid for the lifetime of @self.
+ * It is generally owned by the result set of the provider.
+ *
+ * Since: 44
+ */
+void
+ide_completion_ranker_add_candidate (IdeCompletionRanker *self,
+                                     guint                index,
+                                     const char          *keyword)
+{
+  Candidate candidate;
+
+  g_return_if_fail (IDE_IS_COMPLETION_RANKER (self));
+  g_return_if_fail (keyword != NULL);
+
+  candidate.keyword = keyword;
+  candidate.len = strlen (keyword);
+  candidate.mask = string_mask (keyword, candidate.len);
+  candidate.index = index;
+  candidate.boost = self->history ? ide_completion_history_get_boost (self->history, keyword) : 0;
+
+  g_array_append_val (self->candidates, candidate);
+
+  /* Matches must be recomputed from the candidates */
+  g_clear_pointer (&self->needle, g_free);
+}
+
+/**
+ * ide_completion_ranker_refilter:
+ * @self: an #IdeCompletionRanker
+ * @typed_text: (nullable): the text typed by the user
+ *
+ * Filters the candidates to those matching @typed_text and ranks them.
+ *
+ * If @typed_text is %NULL or empty, all candidates match and are ranked
+ * by their history alone.
+ *
+ * Returns: the number of matching candidates
+ *
+ * Since: 44
+ */
+guint
+ide_completion_ranker_refilter (IdeCompletionRanker *self,
+                                const char          *typed_text)
+{
+  g_autofree char *needle = NULL;
+
+  g_return_val_if_fail (IDE_IS_COMPLETION_RANKER (self), 0);
+
+  if (typed_text != NULL && typed_text[0] != 0)
+    needle = g_utf8_casefold (typed_text, -1);
+
+  if (needle == NULL)
+    {
+      g_array_set_size (self->matches, self->candidates->len);
+
+      for (guint i = 0; i < self->candidates->len; i++)
+        {
+          Match *match = &g_array_index (self->matches, Match, i);
+
+          match->candidate = i;
+          match->score = -g_array_index (self->candidates, Candidate, i).boost;
+        }
+    }
+  else
+    {
+      gsize needle_len = strlen (needle);
+      gboolean needle_is_ascii = _ide_text_ascii_len (needle, needle_len) == needle_len;
+      guint64 needle_mask = string_mask (needle, needle_len);
+      guint pos = 0;
+
+      /* Typing more characters can only remove matches, so only the
+       * previous matches need to be scored again.
+       */
+      if (self->needle != NULL && g_str_has_prefix (needle, self->needle))
+        {
+          for (guint i = 0; i < self->matches->len; i++)
+            {
+              Match match = g_array_index (self->matches, Match, i);
+
+              if (ide_completion_ranker_score (self, match.candidate,
+                                               needle, needle_len,
+                                               needle_is_ascii, needle_mask,
+                                               &match.score))
+                g_array_index (self->matches, Match, pos++) = match;
+            }
+        }
+      else
+        {
+          g_array_set_size (self->matches, self->candidates->len);
+
+          for (guint i = 0; i < self->candidates->len; i++)
+            {
+              Match match = { .candidate = i };
+
+              if (ide_completion_ranker_score (self, i,
+                                               needle, needle_len,
+                                               needle_is_ascii, needle_mask,
+                                               &match.score))
+                g_array_index (self->matches, Match, pos++) = match;
+            }
+        }
+
+      g_array_set_size (self->matches, pos);
+    }
+
+  g_free (self->needle);
+  self->needle = needle ? g_steal_pointer (&needle) : g_strdup ("");
+
+  /* Only the first page of results is sorted now */
+  self->n_sorted = MIN (TOP_K, self->matches->len);
+
+  if (self->matches->len > TOP_K)
+    select_top_k ((Match *)(gpointer)self->matches->data, self->matches->len, TOP_K);
+
+  qsort (self->matches->data, self->n_sorted, sizeof (Match), compare_match);
+
+  return self->matches->len;
+}
+
+/**
+ * ide_completion_ranker_get_n_matches:
+ * @self: an #IdeCompletionRanker
+ *
+ * Gets the number of candidates matching the typed text of the last
+ * call to ide_completion_ranker_refilter().
+ *
+ * Returns: the number of matches
+ *
+ * Since: 44
+ */
+guint
+ide_completion_ranker_get_n_matches (IdeCompletionRanker *self)
+{
+  g_return_val_if_fail (IDE_IS_COMPLETION_RANKER (self), 0);
+
+  return self->matches->len;
+}
+
+/**
+ * ide_completion_ranker_get_index:
+ * @self: an #IdeCompletionRanker
+ * @position: the position within the ranked matches
+ *
+ * Gets the index that was provided to ide_completion_ranker_add_candidate()
+ * for the match at @position.
+ *
+ * Returns: the index of the candidate
+ *
+ * Since: 44
+ */
+guint
+ide_completion_ranker_get_index (IdeCompletionRanker *self,
+                                 guint                position)
+{
+  const Match *match;
+
+  g_return_val_if_fail (IDE_IS_COMPLETION_RANKER (self), 0);
+  g_return_val_if_fail (position < self->matches->len, 0);
+
+  if G_UNLIKELY (position >= self->n_sorted)
+    {
+      Match *matches = (Match *)(gpointer)self->matches->data;
+
+      qsort (&matches[self->n_sorted],
+             self->matches->len - self->n_sorted,
+             sizeof (Match),
+             compare_match);
+      self->n_sorted = self->matches->len;
+    }
+
+  match = &g_array_index (self->matches, Match, position);
+
+  return g_array_index (self->candidates, Candidate, match->candidate).index;
+}
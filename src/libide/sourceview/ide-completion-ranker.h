@@ -0,0 +1,53 @@
+/* ide-completion-ranker.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#if !defined (IDE_SOURCEVIEW_INSIDE) && !defined (IDE_SOURCEVIEW_COMPILATION)
+# error "Only <libide-sourceview.h> can be included directly."
+#endif
+
+#include <libide-core.h>
+
+#include "ide-completion-history.h"
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_COMPLETION_RANKER (ide_completion_ranker_get_type())
+
+IDE_AVAILABLE_IN_44
+G_DECLARE_FINAL_TYPE (IdeCompletionRanker, ide_completion_ranker, IDE, COMPLETION_RANKER, GObject)
+
+IDE_AVAILABLE_IN_44
+IdeCompletionRanker *ide_completion_ranker_new           (IdeCompletionHistory *history);
+IDE_AVAILABLE_IN_44
+void                 ide_completion_ranker_add_candidate (IdeCompletionRanker  *self,
+                                                          guint                 index,
+                                                          const char           *keyword);
+IDE_AVAILABLE_IN_44
+guint                ide_completion_ranker_refilter      (IdeCompletionRanker  *self,
+                                                          const char           *typed_text);
+IDE_AVAILABLE_IN_44
+guint                ide_completion_ranker_get_n_matches (IdeCompletionRanker  *self);
+IDE_AVAILABLE_IN_44
+guint                ide_completion_ranker_get_index     (IdeCompletionRanker  *self,
+                                                          guint                 position);
+
+G_END_DECLS
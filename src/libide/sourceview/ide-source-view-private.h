@@ -72,6 +72,10 @@ struct _IdeSourceView
   /* GSource used to update bottom margin */
   guint overscroll_source;
 
+  /* Tracked so we can tell the highlight engine what is on screen */
+  GtkAdjustment *vadjustment;
+  guint visible_range_source;
+
   /* Mouse click position */
   double click_x;
   double click_y;
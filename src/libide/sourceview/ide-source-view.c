@@ -25,6 +25,7 @@
 #include <glib/gi18n.h>
 #include <math.h>
 
+#include "ide-buffer-private.h"
 #include "ide-source-view-private.h"
 
 #define MIN_BUBBLE_SCALE -2
@@ -484,6 +485,88 @@ ide_source_view_delete_range_cb (IdeSourceView *self,
     gtk_text_iter_forward_char (end);
 }
 
+static void
+ide_source_view_update_visible_range (IdeSourceView *self)
+{
+  IdeHighlightEngine *engine;
+  GdkRectangle visible_rect;
+  GtkTextIter begin;
+  GtkTextIter end;
+
+  g_assert (IDE_IS_SOURCE_VIEW (self));
+
+  if (self->buffer == NULL ||
+      !(engine = _ide_buffer_get_highlight_engine (self->buffer)))
+    return;
+
+  gtk_text_view_get_visible_rect (GTK_TEXT_VIEW (self), &visible_rect);
+  gtk_text_view_get_iter_at_location (GTK_TEXT_VIEW (self), &begin,
+                                      visible_rect.x,
+                                      visible_rect.y);
+  gtk_text_view_get_iter_at_location (GTK_TEXT_VIEW (self), &end,
+                                      visible_rect.x + visible_rect.width,
+                                      visible_rect.y + visible_rect.height);
+
+  ide_highlight_engine_set_visible_range (engine, self, &begin, &end);
+}
+
+static gboolean
+ide_source_view_update_visible_range_cb (gpointer data)
+{
+  IdeSourceView *self = data;
+
+  g_assert (IDE_IS_SOURCE_VIEW (self));
+
+  self->visible_range_source = 0;
+
+  ide_source_view_update_visible_range (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Scrolling and typing can change what is visible many times per frame,
+ * so only look up the visible range once things have settled.
+ */
+static void
+ide_source_view_queue_update_visible_range (IdeSourceView *self)
+{
+  g_assert (IDE_IS_SOURCE_VIEW (self));
+
+  if (self->visible_range_source == 0)
+    self->visible_range_source = g_idle_add (ide_source_view_update_visible_range_cb, self);
+}
+
+static void
+ide_source_view_notify_vadjustment_cb (IdeSourceView *self,
+                                       GParamSpec    *pspec,
+                                       gpointer       user_data)
+{
+  GtkAdjustment *vadjustment;
+
+  g_assert (IDE_IS_SOURCE_VIEW (self));
+
+  vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (self));
+
+  if (vadjustment == self->vadjustment)
+    return;
+
+  if (self->vadjustment != NULL)
+    g_signal_handlers_disconnect_by_func (self->vadjustment,
+                                          G_CALLBACK (ide_source_view_queue_update_visible_range),
+                                          self);
+
+  g_set_object (&self->vadjustment, vadjustment);
+
+  if (vadjustment != NULL)
+    g_signal_connect_object (vadjustment,
+                             "value-changed",
+                             G_CALLBACK (ide_source_view_queue_update_visible_range),
+                             self,
+                             G_CONNECT_SWAPPED);
+
+  ide_source_view_queue_update_visible_range (self);
+}
+
 static void
 ide_source_view_connect_buffer (IdeSourceView *self,
                                 IdeBuffer     *buffer)
@@ -534,19 +617,47 @@ ide_source_view_connect_buffer (IdeSourceView *self,
                            self,
                            G_CONNECT_SWAPPED);
 
+  /* Edits move text in and out of view without scrolling */
+  g_signal_connect_object (buffer,
+                           "changed",
+                           G_CALLBACK (ide_source_view_queue_update_visible_range),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  /* The highlight engine only starts working once the buffer has been
+   * loaded, which may be after we were connected to it.
+   */
+  g_signal_connect_object (buffer,
+                           "loaded",
+                           G_CALLBACK (ide_source_view_queue_update_visible_range),
+                           self,
+                           G_CONNECT_SWAPPED);
+
   /* Load addins immediately */
   language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (buffer));
   _ide_source_view_addins_init (self, language);
+
+  /* Let semantic highlighting start with what we are showing */
+  ide_source_view_queue_update_visible_range (self);
 }
 
 static void
 ide_source_view_disconnect_buffer (IdeSourceView *self)
 {
+  IdeHighlightEngine *engine;
+
   g_assert (IDE_IS_SOURCE_VIEW (self));
 
   if (self->buffer == NULL)
     return;
 
+  g_signal_handlers_disconnect_by_func (self->buffer,
+                                        G_CALLBACK (ide_source_view_queue_update_visible_range),
+                                        self);
+
+  if ((engine = _ide_buffer_get_highlight_engine (self->buffer)))
+    ide_highlight_engine_clear_visible_range (engine, self);
+
   _ide_source_view_addins_shutdown (self);
 
   g_clear_object (&self->buffer);
@@ -717,6 +828,8 @@ ide_source_view_size_allocate (GtkWidget *widget,
 
   if (self->overscroll_source == 0)
     self->overscroll_source = g_idle_add (ide_source_view_update_overscroll, self);
+
+  ide_source_view_queue_update_visible_range (self);
 }
 
 static void
@@ -1115,9 +1228,18 @@ ide_source_view_dispose (GObject *object)
   IDE_ENTRY;
 
   g_clear_handle_id (&self->overscroll_source, g_source_remove);
+  g_clear_handle_id (&self->visible_range_source, g_source_remove);
 
   ide_source_view_disconnect_buffer (self);
 
+  if (self->vadjustment != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (self->vadjustment,
+                                            G_CALLBACK (ide_source_view_queue_update_visible_range),
+                                            self);
+      g_clear_object (&self->vadjustment);
+    }
+
   g_clear_object (&self->search_context);
   g_clear_object (&self->joined_menu);
   g_clear_object (&self->css_provider);
@@ -1341,6 +1463,12 @@ ide_source_view_init (IdeSourceView *self)
                     G_CALLBACK (ide_source_view_notify_buffer_cb),
                     NULL);
 
+  /* Track scrolling so highlighting follows what is visible */
+  g_signal_connect (self,
+                    "notify::vadjustment",
+                    G_CALLBACK (ide_source_view_notify_vadjustment_cb),
+                    NULL);
+
   /* Setup our extra menu so that consumers can use
    * ide_source_view_append_menu() or similar to update menus.
    */
@@ -26,6 +26,8 @@ G_BEGIN_DECLS
 
 #define IDE_SOURCEVIEW_INSIDE
 
+#include "ide-completion-history.h"
+#include "ide-completion-ranker.h"
 #include "ide-line-change-gutter-renderer.h"
 #include "ide-gutter.h"
 #include "ide-source-style-scheme.h"
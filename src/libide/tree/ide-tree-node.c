@@ -39,6 +39,12 @@ struct _IdeTreeNode
   GQueue children;
   GList link;
 
+  /* Mirrors @children so that positional access from the GListModel
+   * interface (and binary search when inserting) does not need to walk
+   * the linked list, which is painfully slow for large directories.
+   */
+  GPtrArray *index;
+
   char *title;
   GIcon *icon;
   GIcon *expanded_icon;
@@ -56,6 +62,7 @@ struct _IdeTreeNode
   guint reset_on_collapse : 1;
   guint use_markup : 1;
   guint loading : 1;
+  guint built : 1;
 };
 
 enum {
@@ -86,7 +93,7 @@ enum {
 static guint
 list_model_get_n_items (GListModel *model)
 {
-  return IDE_TREE_NODE (model)->children.length;
+  return IDE_TREE_NODE (model)->index->len;
 }
 
 static GType
@@ -101,16 +108,10 @@ list_model_get_item (GListModel *model,
 {
   IdeTreeNode *self = IDE_TREE_NODE (model);
 
-  if (position >= self->children.length)
+  if (position >= self->index->len)
     return NULL;
 
-  if (position == 0)
-    return g_object_ref (g_queue_peek_head (&self->children));
-
-  if (position == self->children.length-1)
-    return g_object_ref (g_queue_peek_tail (&self->children));
-
-  return g_object_ref (g_queue_peek_nth (&self->children, position));
+  return g_object_ref (g_ptr_array_index (self->index, position));
 }
 
 static void
@@ -127,6 +128,57 @@ G_DEFINE_TYPE_WITH_CODE (IdeTreeNode, ide_tree_node, G_TYPE_OBJECT,
 static GParamSpec *properties [N_PROPS];
 static guint signals [N_SIGNALS];
 
+static guint
+ide_tree_node_index_of (IdeTreeNode *self,
+                        IdeTreeNode *child)
+{
+  guint position;
+
+  g_assert (IDE_IS_TREE_NODE (self));
+  g_assert (IDE_IS_TREE_NODE (child));
+  g_assert (child->parent == self);
+
+  /* Appending is the common case, so check the tail first */
+  if (self->index->len > 0 &&
+      g_ptr_array_index (self->index, self->index->len - 1) == child)
+    return self->index->len - 1;
+
+  if (!g_ptr_array_find (self->index, child, &position))
+    g_assert_not_reached ();
+
+  return position;
+}
+
+static void
+ide_tree_node_remove_all (IdeTreeNode *self)
+{
+  g_autoptr(GPtrArray) children = NULL;
+
+  g_assert (IDE_IS_TREE_NODE (self));
+
+  if (self->index->len == 0)
+    return;
+
+  /* Detach everything at once so that we only notify the list model a
+   * single time instead of once per child.
+   */
+  children = g_steal_pointer (&self->index);
+  self->index = g_ptr_array_new ();
+
+  for (guint i = 0; i < children->len; i++)
+    {
+      IdeTreeNode *child = g_ptr_array_index (children, i);
+
+      g_queue_unlink (&self->children, &child->link);
+      child->parent = NULL;
+    }
+
+  g_list_model_items_changed (G_LIST_MODEL (self), 0, children->len, 0);
+
+  for (guint i = 0; i < children->len; i++)
+    g_object_unref (g_ptr_array_index (children, i));
+}
+
 IdeTree *
 _ide_tree_node_get_tree (IdeTreeNode *self)
 {
@@ -157,9 +209,7 @@ _ide_tree_node_collapsed (IdeTreeNode *self)
   if (self->reset_on_collapse)
     {
       self->children_built = FALSE;
-
-      while (self->children.head != NULL)
-        ide_tree_node_unparent (g_queue_peek_head (&self->children));
+      ide_tree_node_remove_all (self);
     }
 }
 
@@ -168,8 +218,7 @@ ide_tree_node_dispose (GObject *object)
 {
   IdeTreeNode *self = (IdeTreeNode *)object;
 
-  while (self->children.head != NULL)
-    ide_tree_node_unparent (self->children.head->data);
+  ide_tree_node_remove_all (self);
 
   if (self->parent != NULL)
     ide_tree_node_unparent (self);
@@ -193,6 +242,16 @@ ide_tree_node_dispose (GObject *object)
   g_assert (self->link.next == NULL);
 }
 
+static void
+ide_tree_node_finalize (GObject *object)
+{
+  IdeTreeNode *self = (IdeTreeNode *)object;
+
+  g_clear_pointer (&self->index, g_ptr_array_unref);
+
+  G_OBJECT_CLASS (ide_tree_node_parent_class)->finalize (object);
+}
+
 static void
 ide_tree_node_get_property (GObject    *object,
                             guint       prop_id,
@@ -337,6 +396,7 @@ ide_tree_node_class_init (IdeTreeNodeClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->dispose = ide_tree_node_dispose;
+  object_class->finalize = ide_tree_node_finalize;
   object_class->get_property = ide_tree_node_get_property;
   object_class->set_property = ide_tree_node_set_property;
 
@@ -461,6 +521,7 @@ static void
 ide_tree_node_init (IdeTreeNode *self)
 {
   self->link.data = self;
+  self->index = g_ptr_array_new ();
   self->reset_on_collapse = TRUE;
 }
 
@@ -776,7 +837,8 @@ ide_tree_node_set_parent (IdeTreeNode *self,
   g_object_ref (self);
   self->parent = parent;
   g_queue_push_tail_link (&parent->children, &self->link);
-  pos = g_queue_link_index (&parent->children, &self->link);
+  g_ptr_array_add (parent->index, self);
+  pos = parent->index->len - 1;
 
   g_list_model_items_changed (G_LIST_MODEL (parent), pos, 0, 1);
 }
@@ -793,8 +855,8 @@ ide_tree_node_unparent (IdeTreeNode *self)
     return;
 
   parent = self->parent;
-  child_position = g_queue_link_index (&parent->children, &self->link);
-  g_return_if_fail (child_position > -1);
+  child_position = ide_tree_node_index_of (parent, self);
+  g_ptr_array_remove_index (parent->index, child_position);
   g_queue_unlink (&parent->children, &self->link);
   self->parent = NULL;
 
@@ -932,11 +994,17 @@ ide_tree_node_insert_after (IdeTreeNode *self,
   self->parent = parent;
 
   if (previous_sibling != NULL)
-    g_queue_insert_after_link (&parent->children, &previous_sibling->link, &self->link);
+    {
+      child_position = ide_tree_node_index_of (parent, previous_sibling) + 1;
+      g_queue_insert_after_link (&parent->children, &previous_sibling->link, &self->link);
+    }
   else
-    g_queue_push_head_link (&parent->children, &self->link);
+    {
+      child_position = 0;
+      g_queue_push_head_link (&parent->children, &self->link);
+    }
 
-  child_position = g_queue_link_index (&parent->children, &self->link);
+  g_ptr_array_insert (parent->index, child_position, self);
 
   g_list_model_items_changed (G_LIST_MODEL (parent), child_position, 0, 1);
 }
@@ -961,11 +1029,17 @@ ide_tree_node_insert_before (IdeTreeNode *self,
   self->parent = parent;
 
   if (next_sibling != NULL)
-    g_queue_insert_before_link (&parent->children, &next_sibling->link, &self->link);
+    {
+      child_position = ide_tree_node_index_of (parent, next_sibling);
+      g_queue_insert_before_link (&parent->children, &next_sibling->link, &self->link);
+    }
   else
-    g_queue_push_tail_link (&parent->children, &self->link);
+    {
+      child_position = parent->index->len;
+      g_queue_push_tail_link (&parent->children, &self->link);
+    }
 
-  child_position = g_queue_link_index (&parent->children, &self->link);
+  g_ptr_array_insert (parent->index, child_position, self);
 
   g_list_model_items_changed (G_LIST_MODEL (parent), child_position, 0, 1);
 }
@@ -978,26 +1052,90 @@ ide_tree_node_insert_before (IdeTreeNode *self,
  *
  * Insert @child as a child of @self at the sorted position
  * determined by @cmpfn.
+ *
+ * The children of @self must already be sorted according to @cmpfn
+ * as the position is located using a binary search.
  */
 void
 ide_tree_node_insert_sorted (IdeTreeNode        *self,
                              IdeTreeNode        *child,
                              IdeTreeNodeCompare  cmpfn)
 {
-  GList *link;
+  guint lo = 0;
+  guint hi;
 
   g_return_if_fail (IDE_IS_TREE_NODE (self));
   g_return_if_fail (IDE_IS_TREE_NODE (child));
   g_return_if_fail (child->parent == NULL);
 
-  link = g_queue_find_custom (&self->children, child, (GCompareFunc)cmpfn);
+  hi = self->index->len;
+
+  /* Find the first sibling which @child does not sort after */
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (cmpfn (g_ptr_array_index (self->index, mid), child) > 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
 
-  if (link != NULL)
-    ide_tree_node_insert_before (child, self, link->data);
+  if (lo < self->index->len)
+    ide_tree_node_insert_before (child, self, g_ptr_array_index (self->index, lo));
   else
     ide_tree_node_insert_before (child, self, NULL);
 }
 
+/**
+ * ide_tree_node_append_children:
+ * @self: an #IdeTreeNode
+ * @children: (array length=n_children): the nodes to append
+ * @n_children: the number of nodes in @children
+ *
+ * Appends @children to @self in order.
+ *
+ * This is equivalent to calling ide_tree_node_insert_before() for each
+ * of @children but only notifies the list model once, which matters
+ * when populating nodes with many children.
+ *
+ * Since: 44
+ */
+void
+ide_tree_node_append_children (IdeTreeNode  *self,
+                               IdeTreeNode **children,
+                               guint         n_children)
+{
+  guint position;
+
+  g_return_if_fail (IDE_IS_TREE_NODE (self));
+  g_return_if_fail (children != NULL || n_children == 0);
+
+  if (n_children == 0)
+    return;
+
+  for (guint i = 0; i < n_children; i++)
+    {
+      g_return_if_fail (IDE_IS_TREE_NODE (children[i]));
+      g_return_if_fail (children[i]->parent == NULL);
+      g_return_if_fail (children[i]->link.prev == NULL);
+      g_return_if_fail (children[i]->link.next == NULL);
+    }
+
+  position = self->index->len;
+
+  for (guint i = 0; i < n_children; i++)
+    {
+      IdeTreeNode *child = children[i];
+
+      child->parent = self;
+      g_queue_push_tail_link (&self->children, &child->link);
+      g_ptr_array_add (self->index, g_object_ref (child));
+    }
+
+  g_list_model_items_changed (G_LIST_MODEL (self), position, 0, n_children);
+}
+
 IdeTreeNodeFlags
 ide_tree_node_get_flags (IdeTreeNode *self)
 {
@@ -1153,27 +1291,6 @@ expand_free (Expand *state)
   g_slice_free (Expand, state);
 }
 
-static void
-ide_tree_node_build_node_cb (IdeExtensionSetAdapter *addins,
-                             PeasPluginInfo         *plugin_info,
-                             PeasExtension          *extension,
-                             gpointer                user_data)
-{
-  IdeTreeAddin *addin = (IdeTreeAddin *)extension;
-  Expand *state = user_data;
-
-  g_assert (IDE_IS_EXTENSION_SET_ADAPTER (addins));
-  g_assert (plugin_info != NULL);
-  g_assert (IDE_IS_TREE_ADDIN (addin));
-  g_assert (state != NULL);
-  g_assert (IDE_IS_TREE_NODE (state->node));
-
-  for (IdeTreeNode *child = ide_tree_node_get_first_child (state->node);
-       child != NULL;
-       child = ide_tree_node_get_next_sibling (child))
-    ide_tree_addin_build_node (addin, child);
-}
-
 static void
 ide_tree_node_expand_build_children_cb (GObject      *object,
                                         GAsyncResult *result,
@@ -1206,13 +1323,11 @@ ide_tree_node_expand_build_children_cb (GObject      *object,
         g_warning ("%s", error->message);
     }
 
+  /* Children are built by addins lazily when they are first bound to a
+   * row, see _ide_tree_node_build().
+   */
   if (state->active->len == 0)
-    {
-      ide_extension_set_adapter_foreach (state->addins,
-                                         ide_tree_node_build_node_cb,
-                                         state);
-      ide_task_return_boolean (task, TRUE);
-    }
+    ide_task_return_boolean (task, TRUE);
 }
 
 static void
@@ -1316,6 +1431,50 @@ _ide_tree_node_expand_finish (IdeTreeNode   *self,
   return ide_task_propagate_boolean (IDE_TASK (result), error);
 }
 
+static void
+ide_tree_node_build_node_cb (IdeExtensionSetAdapter *addins,
+                             PeasPluginInfo         *plugin_info,
+                             PeasExtension          *extension,
+                             gpointer                user_data)
+{
+  IdeTreeAddin *addin = (IdeTreeAddin *)extension;
+  IdeTreeNode *node = user_data;
+
+  g_assert (IDE_IS_EXTENSION_SET_ADAPTER (addins));
+  g_assert (plugin_info != NULL);
+  g_assert (IDE_IS_TREE_ADDIN (addin));
+  g_assert (IDE_IS_TREE_NODE (node));
+
+  ide_tree_addin_build_node (addin, node);
+}
+
+/**
+ * _ide_tree_node_build:
+ * @self: a #IdeTreeNode
+ * @addins: the #IdeExtensionSetAdapter of #IdeTreeAddin
+ *
+ * Allows @addins to decorate @self the first time it is needed.
+ *
+ * This is deferred until the node is bound to a row so that expanding
+ * a node with many children only does the work for the visible rows.
+ */
+void
+_ide_tree_node_build (IdeTreeNode            *self,
+                      IdeExtensionSetAdapter *addins)
+{
+  g_return_if_fail (IDE_IS_TREE_NODE (self));
+  g_return_if_fail (!addins || IDE_IS_EXTENSION_SET_ADAPTER (addins));
+
+  if (self->built || addins == NULL)
+    return;
+
+  self->built = TRUE;
+
+  ide_extension_set_adapter_foreach (addins,
+                                     ide_tree_node_build_node_cb,
+                                     self);
+}
+
 gboolean
 _ide_tree_node_children_built (IdeTreeNode *self)
 {
@@ -1331,7 +1490,7 @@ _ide_tree_node_get_child_index (IdeTreeNode *parent,
   g_return_val_if_fail (IDE_IS_TREE_NODE (parent), 0);
   g_return_val_if_fail (IDE_IS_TREE_NODE (child), 0);
 
-  return g_queue_link_index (&parent->children, &child->link);
+  return ide_tree_node_index_of (parent, child);
 }
 
 guint
@@ -75,7 +75,8 @@ typedef IdeTreeNodeVisit (*IdeTreeTraverseFunc) (IdeTreeNode *node,
 
  * This callback function is a convenience wrapper around GCompareFunc
  *
- * Returns: int
+ * Returns: a value greater than zero if @child sorts after @node,
+ *   otherwise zero or less.
  */
 typedef int (*IdeTreeNodeCompare) (IdeTreeNode *node,
                                    IdeTreeNode *child);
@@ -180,6 +181,10 @@ IDE_AVAILABLE_IN_ALL
 void              ide_tree_node_insert_sorted          (IdeTreeNode         *self,
                                                         IdeTreeNode         *child,
                                                         IdeTreeNodeCompare   cmpfn);
+IDE_AVAILABLE_IN_44
+void              ide_tree_node_append_children        (IdeTreeNode         *self,
+                                                        IdeTreeNode        **children,
+                                                        guint                n_children);
 IDE_AVAILABLE_IN_ALL
 void              ide_tree_node_traverse               (IdeTreeNode         *self,
                                                         GTraverseType        traverse_type,
@@ -30,6 +30,8 @@ G_BEGIN_DECLS
 GtkTreeListRow *_ide_tree_get_row_at_node      (IdeTree                 *self,
                                                 IdeTreeNode             *node,
                                                 gboolean                 expand_to_row);
+void            _ide_tree_node_build           (IdeTreeNode             *self,
+                                                IdeExtensionSetAdapter  *addins);
 gboolean        _ide_tree_node_children_built  (IdeTreeNode             *self);
 guint           _ide_tree_node_get_child_index (IdeTreeNode             *parent,
                                                 IdeTreeNode             *child);
@@ -930,6 +930,7 @@ ide_tree_list_item_bind_cb (IdeTree                  *self,
                             GtkListItem              *item,
                             GtkSignalListItemFactory *factory)
 {
+  IdeTreePrivate *priv = ide_tree_get_instance_private (self);
   g_autoptr(IdeTreeNode) node = NULL;
   IdeTreeExpander *expander;
   GtkTreeListRow *row;
@@ -948,6 +949,8 @@ ide_tree_list_item_bind_cb (IdeTree                  *self,
   g_assert (IDE_IS_TREE_EXPANDER (expander));
   g_assert (IDE_IS_TREE_NODE (node));
 
+  _ide_tree_node_build (node, priv->addins);
+
   ide_tree_expander_set_list_row (expander, row);
 
 #define BIND_PROPERTY(name) \
@@ -69,6 +69,27 @@ ide_html_generator_real_generate_finish (IdeHtmlGenerator  *self,
   return ide_task_propagate_pointer (IDE_TASK (result), error);
 }
 
+static void
+ide_html_generator_real_generate_patch_async (IdeHtmlGenerator    *self,
+                                              GCancellable        *cancellable,
+                                              GAsyncReadyCallback  callback,
+                                              gpointer             user_data)
+{
+  g_autoptr(IdeTask) task = NULL;
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, ide_html_generator_real_generate_patch_async);
+  ide_task_return_unsupported_error (task);
+}
+
+static GBytes *
+ide_html_generator_real_generate_patch_finish (IdeHtmlGenerator  *self,
+                                               GAsyncResult      *result,
+                                               GError           **error)
+{
+  return ide_task_propagate_pointer (IDE_TASK (result), error);
+}
+
 static void
 ide_html_generator_dispose (GObject *object)
 {
@@ -129,6 +150,8 @@ ide_html_generator_class_init (IdeHtmlGeneratorClass *klass)
 
   klass->generate_async = ide_html_generator_real_generate_async;
   klass->generate_finish = ide_html_generator_real_generate_finish;
+  klass->generate_patch_async = ide_html_generator_real_generate_patch_async;
+  klass->generate_patch_finish = ide_html_generator_real_generate_patch_finish;
 
   properties [PROP_BASE_URI] =
     g_param_spec_string ("base-uri", NULL, NULL, NULL,
@@ -232,6 +255,68 @@ ide_html_generator_generate_finish (IdeHtmlGenerator  *self,
   return ret;
 }
 
+/**
+ * ide_html_generator_generate_patch_async:
+ * @self: a #IdeHtmlGenerator
+ * @cancellable: a #GCancellable
+ * @callback: a function to call after completion
+ * @user_data: closure data for @callback
+ *
+ * Asynchronously generate a patch for the previously generated HTML.
+ *
+ * Subclasses may implement this to produce JavaScript which, when evaluated
+ * within the document last generated by the generator (including any patches
+ * since), updates it to reflect the current contents. This allows a preview
+ * to be updated in place without reloading the document, which preserves the
+ * scroll position and avoids laying out the whole document again.
+ *
+ * Generating a patch implies that the caller will apply it. Generators that
+ * cannot produce a patch for the current change complete with
+ * %G_IO_ERROR_NOT_SUPPORTED, in which case the caller should use
+ * ide_html_generator_generate_async() instead.
+ *
+ * Since: 44
+ */
+void
+ide_html_generator_generate_patch_async (IdeHtmlGenerator    *self,
+                                         GCancellable        *cancellable,
+                                         GAsyncReadyCallback  callback,
+                                         gpointer             user_data)
+{
+  g_return_if_fail (IDE_IS_HTML_GENERATOR (self));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  IDE_HTML_GENERATOR_GET_CLASS (self)->generate_patch_async (self, cancellable, callback, user_data);
+}
+
+/**
+ * ide_html_generator_generate_patch_finish:
+ * @self: a #IdeHtmlGenerator
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError
+ *
+ * Completes a request to generate a patch.
+ *
+ * As with ide_html_generator_generate_finish(), the resulting bytes
+ * have a NULL terminator which is not part of the bytes length. The
+ * bytes are empty if nothing has changed.
+ *
+ * Returns: (transfer full): a #GBytes containing JavaScript if successful;
+ *   otherwise %NULL and @error is set.
+ *
+ * Since: 44
+ */
+GBytes *
+ide_html_generator_generate_patch_finish (IdeHtmlGenerator  *self,
+                                          GAsyncResult      *result,
+                                          GError           **error)
+{
+  g_return_val_if_fail (IDE_IS_HTML_GENERATOR (self), NULL);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+
+  return IDE_HTML_GENERATOR_GET_CLASS (self)->generate_patch_finish (self, result, error);
+}
+
 /**
  * ide_html_generator_invalidate:
  * @self: a #IdeHtmlGenerator
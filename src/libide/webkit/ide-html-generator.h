@@ -43,6 +43,13 @@ struct _IdeHtmlGeneratorClass
   GBytes *(*generate_finish) (IdeHtmlGenerator     *self,
                               GAsyncResult         *result,
                               GError              **error);
+  void    (*generate_patch_async)  (IdeHtmlGenerator     *self,
+                                    GCancellable         *cancellable,
+                                    GAsyncReadyCallback   callback,
+                                    gpointer              user_data);
+  GBytes *(*generate_patch_finish) (IdeHtmlGenerator     *self,
+                                    GAsyncResult         *result,
+                                    GError              **error);
 };
 
 IDE_AVAILABLE_IN_ALL
@@ -61,6 +68,15 @@ IDE_AVAILABLE_IN_ALL
 GBytes           *ide_html_generator_generate_finish (IdeHtmlGenerator     *self,
                                                       GAsyncResult         *result,
                                                       GError              **error);
+IDE_AVAILABLE_IN_44
+void              ide_html_generator_generate_patch_async  (IdeHtmlGenerator     *self,
+                                                            GCancellable         *cancellable,
+                                                            GAsyncReadyCallback   callback,
+                                                            gpointer              user_data);
+IDE_AVAILABLE_IN_44
+GBytes           *ide_html_generator_generate_patch_finish (IdeHtmlGenerator     *self,
+                                                            GAsyncResult         *result,
+                                                            GError              **error);
 IDE_AVAILABLE_IN_ALL
 IdeHtmlGenerator *ide_html_generator_new_for_buffer  (GtkTextBuffer        *buffer);
 
@@ -40,6 +40,12 @@ typedef struct
   guint               dirty : 1;
   guint               generating : 1;
   guint               disposed : 1;
+
+  /* Set when the document was loaded from the generator and has finished
+   * loading, so that further changes may be patched in place.
+   */
+  guint               loading_generated : 1;
+  guint               patchable : 1;
 } IdeWebkitPagePrivate;
 
 enum {
@@ -53,6 +59,8 @@ G_DEFINE_TYPE_WITH_PRIVATE (IdeWebkitPage, ide_webkit_page, IDE_TYPE_PAGE)
 
 static GParamSpec *properties [N_PROPS];
 
+static void ide_webkit_page_generate (IdeWebkitPage *self);
+
 static gboolean
 transform_title_with_fallback (GBinding     *binding,
                                const GValue *from_value,
@@ -211,13 +219,12 @@ reload_action (GtkWidget  *widget,
                GVariant   *param)
 {
   IdeWebkitPage *self = (IdeWebkitPage *)widget;
-  IdeWebkitPagePrivate *priv = ide_webkit_page_get_instance_private (self);
 
   IDE_ENTRY;
 
   g_assert (IDE_IS_WEBKIT_PAGE (self));
 
-  webkit_web_view_reload (priv->web_view);
+  ide_webkit_page_reload (self);
 
   IDE_EXIT;
 }
@@ -593,6 +600,18 @@ ide_webkit_page_reload (IdeWebkitPage *self)
   if (webkit_web_view_is_loading (priv->web_view))
     webkit_web_view_stop_loading (priv->web_view);
 
+  /* Reloading would show the document as it was first loaded, without
+   * any of the patches applied since, so regenerate it instead.
+   */
+  if (priv->generator != NULL)
+    {
+      priv->loading_generated = FALSE;
+      priv->patchable = FALSE;
+      priv->dirty = TRUE;
+      ide_webkit_page_generate (self);
+      return;
+    }
+
   webkit_web_view_reload (priv->web_view);
 }
 
@@ -636,46 +655,185 @@ ide_webkit_page_generate_cb (GObject      *object,
   if (priv->disposed)
     return;
 
+  priv->loading_generated = TRUE;
+  priv->patchable = FALSE;
+
   webkit_web_view_load_html (priv->web_view,
                              (const char *)g_bytes_get_data (bytes, NULL),
                              ide_html_generator_get_base_uri (generator));
 
-  /* See if we need to run again, and check for re-entrantcy */
-  if (priv->dirty && !priv->generating)
+  /* Changes made while loading are picked up once the load has
+   * finished (see on_web_view_load_changed_cb()) so that we do not
+   * tear down the document again before it was ever displayed.
+   */
+}
+
+#if WEBKIT_CHECK_VERSION(2, 40, 0)
+static void
+ide_webkit_page_evaluate_patch_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  WebKitWebView *web_view = (WebKitWebView *)object;
+  g_autoptr(IdeWebkitPage) self = user_data;
+  IdeWebkitPagePrivate *priv = ide_webkit_page_get_instance_private (self);
+  g_autoptr(JSCValue) value = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (WEBKIT_IS_WEB_VIEW (web_view));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_WEBKIT_PAGE (self));
+
+  if (!(value = webkit_web_view_evaluate_javascript_finish (web_view, result, &error)))
     {
-      priv->dirty = FALSE;
-      priv->generating = TRUE;
-      ide_html_generator_generate_async (generator,
-                                         NULL,
-                                         ide_webkit_page_generate_cb,
-                                         g_steal_pointer (&self));
+      if (priv->disposed)
+        return;
+
+      /* The document no longer matches what the generator patched against,
+       * so reload it from scratch.
+       */
+      g_debug ("Failed to apply HTML patch: %s", error->message);
+
+      priv->patchable = FALSE;
+      priv->dirty = TRUE;
+
+      ide_webkit_page_generate (self);
     }
 }
+#endif
 
 static void
-ide_webkit_page_generator_invalidate_cb (IdeWebkitPage    *self,
-                                         IdeHtmlGenerator *generator)
+ide_webkit_page_generate_patch_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  IdeHtmlGenerator *generator = (IdeHtmlGenerator *)object;
+  g_autoptr(IdeWebkitPage) self = user_data;
+  IdeWebkitPagePrivate *priv = ide_webkit_page_get_instance_private (self);
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+
+  g_assert (IDE_IS_HTML_GENERATOR (generator));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_WEBKIT_PAGE (self));
+
+  priv->generating = FALSE;
+
+  if (priv->disposed)
+    return;
+
+  if (!(bytes = ide_html_generator_generate_patch_finish (generator, result, &error)))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+        g_warning ("Failed to generate HTML patch: %s", error->message);
+
+      /* Fallback to reloading the whole document */
+      priv->patchable = FALSE;
+      priv->dirty = TRUE;
+    }
+#if WEBKIT_CHECK_VERSION(2, 40, 0)
+  else if (g_bytes_get_size (bytes) > 0)
+    {
+      gsize len;
+      const char *script = g_bytes_get_data (bytes, &len);
+
+      webkit_web_view_evaluate_javascript (priv->web_view,
+                                           script, len,
+                                           NULL, NULL, NULL,
+                                           ide_webkit_page_evaluate_patch_cb,
+                                           g_object_ref (self));
+    }
+#endif
+
+  if (priv->dirty)
+    ide_webkit_page_generate (self);
+}
+
+static void
+ide_webkit_page_generate (IdeWebkitPage *self)
 {
   IdeWebkitPagePrivate *priv = ide_webkit_page_get_instance_private (self);
 
   g_assert (IDE_IS_MAIN_THREAD ());
   g_assert (IDE_IS_WEBKIT_PAGE (self));
-  g_assert (IDE_IS_HTML_GENERATOR (generator));
+  g_assert (priv->generator != NULL);
 
-  priv->dirty = TRUE;
+  if (priv->generating || !priv->dirty)
+    return;
 
-  if (priv->generating)
+  /* Wait for the document to finish loading, we'll check dirty again
+   * once it has. Otherwise we'd restart the load on every keystroke.
+   */
+  if (priv->loading_generated)
     return;
 
   priv->generating = TRUE;
   priv->dirty = FALSE;
 
-  ide_html_generator_generate_async (generator,
+#if WEBKIT_CHECK_VERSION(2, 40, 0)
+  if (priv->patchable)
+    {
+      ide_html_generator_generate_patch_async (priv->generator,
+                                               NULL,
+                                               ide_webkit_page_generate_patch_cb,
+                                               g_object_ref (self));
+      return;
+    }
+#endif
+
+  ide_html_generator_generate_async (priv->generator,
                                      NULL,
                                      ide_webkit_page_generate_cb,
                                      g_object_ref (self));
 }
 
+static void
+ide_webkit_page_generator_invalidate_cb (IdeWebkitPage    *self,
+                                         IdeHtmlGenerator *generator)
+{
+  IdeWebkitPagePrivate *priv = ide_webkit_page_get_instance_private (self);
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_WEBKIT_PAGE (self));
+  g_assert (IDE_IS_HTML_GENERATOR (generator));
+
+  priv->dirty = TRUE;
+
+  ide_webkit_page_generate (self);
+}
+
+static void
+on_web_view_load_changed_cb (IdeWebkitPage   *self,
+                             WebKitLoadEvent  load_event,
+                             WebKitWebView   *web_view)
+{
+  IdeWebkitPagePrivate *priv = ide_webkit_page_get_instance_private (self);
+
+  g_assert (IDE_IS_WEBKIT_PAGE (self));
+  g_assert (WEBKIT_IS_WEB_VIEW (web_view));
+
+  if (priv->generator == NULL)
+    return;
+
+  switch (load_event)
+    {
+    case WEBKIT_LOAD_STARTED:
+      priv->patchable = FALSE;
+      break;
+
+    case WEBKIT_LOAD_FINISHED:
+      priv->patchable = priv->loading_generated;
+      priv->loading_generated = FALSE;
+      ide_webkit_page_generate (self);
+      break;
+
+    case WEBKIT_LOAD_REDIRECTED:
+    case WEBKIT_LOAD_COMMITTED:
+    default:
+      break;
+    }
+}
+
 IdeWebkitPage *
 ide_webkit_page_new_for_generator (IdeHtmlGenerator *generator)
 {
@@ -693,6 +851,11 @@ ide_webkit_page_new_for_generator (IdeHtmlGenerator *generator)
                            G_CALLBACK (ide_webkit_page_generator_invalidate_cb),
                            self,
                            G_CONNECT_SWAPPED);
+  g_signal_connect_object (priv->web_view,
+                           "load-changed",
+                           G_CALLBACK (on_web_view_load_changed_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
   ide_webkit_page_generator_invalidate_cb (self, generator);
 
   return self;
@@ -98,6 +98,52 @@ trace_log (GLogLevelFlags  log_level,
   sysprof_collector_log (log_level, domain, message);
 }
 
+static void
+trace_mark (gint64       begin_time_usec,
+            gint64       end_time_usec,
+            const gchar *group,
+            const gchar *name,
+            const gchar *message)
+{
+  sysprof_collector_mark (begin_time_usec * 1000L,
+                          (end_time_usec - begin_time_usec) * 1000L,
+                          group,
+                          name,
+                          message ? message : "");
+}
+
+static guint
+trace_define_counter (const gchar *category,
+                      const gchar *name,
+                      const gchar *description)
+{
+  SysprofCaptureCounter counter = {{0}};
+
+  counter.id = sysprof_collector_request_counters (1);
+  counter.type = SYSPROF_CAPTURE_COUNTER_INT64;
+  counter.value.v64 = 0;
+  g_strlcpy (counter.category, category, sizeof counter.category);
+  g_strlcpy (counter.name, name, sizeof counter.name);
+  g_strlcpy (counter.description, description, sizeof counter.description);
+
+  sysprof_collector_define_counters (&counter, 1);
+
+  /* Zero means "no counter" to callers, so offset our identifiers */
+  return counter.id + 1;
+}
+
+static void
+trace_set_counter (guint  counter_id,
+                   gint64 value)
+{
+  SysprofCaptureCounterValue counter_value;
+  unsigned int id = counter_id - 1;
+
+  counter_value.v64 = value;
+
+  sysprof_collector_set_counters (&id, &counter_value, 1);
+}
+
 static IdeTraceVTable trace_vtable = {
   trace_load,
   trace_unload,
@@ -265,6 +311,23 @@ main (gint   argc,
     desktop = "unknown";
 
 #ifdef ENABLE_TRACING_SYSCAP
+  /* Only record marks and counters when spawned by a profiler so that
+   * instrumented code paths can skip the work otherwise.
+   *
+   * These are recorded by the collector from sysprof-capture, which is
+   * what ENABLE_TRACING_SYSCAP checks for and is a dependency of the
+   * sysprof plugin anyway. The plugin profiles programs run by Builder
+   * and does not collect from this process, so there is nothing to hook
+   * up there; the capture from `sysprof-cli -- gnome-builder` can be
+   * opened with it.
+   */
+  if (g_getenv ("SYSPROF_TRACE_FD") != NULL)
+    {
+      trace_vtable.mark = trace_mark;
+      trace_vtable.define_counter = trace_define_counter;
+      trace_vtable.set_counter = trace_set_counter;
+    }
+
   _ide_trace_init (&trace_vtable);
 #endif
 
@@ -421,11 +421,39 @@ gbp_buildui_workspace_addin_unload (IdeWorkspaceAddin *addin,
   self->workspace = NULL;
 }
 
+static void
+gbp_buildui_workspace_addin_page_changed (IdeWorkspaceAddin *addin,
+                                          IdePage           *page)
+{
+  GbpBuilduiWorkspaceAddin *self = (GbpBuilduiWorkspaceAddin *)addin;
+  IdeBuildManager *build_manager;
+  IdeContext *context;
+
+  IDE_ENTRY;
+
+  g_assert (GBP_IS_BUILDUI_WORKSPACE_ADDIN (self));
+  g_assert (!page || IDE_IS_PAGE (page));
+
+  /* Keep the last file around when switching to other pages so that
+   * building from a terminal still builds what was being edited.
+   */
+  if (!IDE_IS_EDITOR_PAGE (page))
+    IDE_EXIT;
+
+  context = ide_widget_get_context (GTK_WIDGET (page));
+  build_manager = ide_build_manager_from_context (context);
+  ide_build_manager_set_focus_file (build_manager,
+                                    ide_editor_page_get_file (IDE_EDITOR_PAGE (page)));
+
+  IDE_EXIT;
+}
+
 static void
 workspace_addin_iface_init (IdeWorkspaceAddinInterface *iface)
 {
   iface->load = gbp_buildui_workspace_addin_load;
   iface->unload = gbp_buildui_workspace_addin_unload;
+  iface->page_changed = gbp_buildui_workspace_addin_page_changed;
 }
 
 G_DEFINE_FINAL_TYPE_WITH_CODE (GbpBuilduiWorkspaceAddin, gbp_buildui_workspace_addin, G_TYPE_OBJECT,
@@ -59,6 +59,7 @@ typedef struct
   GVariant       *params;
   GVariant       *id;
   gulong          cancel_id;
+  gint64          begin_time;
 } Call;
 
 G_DEFINE_FINAL_TYPE (IdeClangClient, ide_clang_client, IDE_TYPE_OBJECT)
@@ -471,11 +472,21 @@ ide_clang_client_call_cb (GObject      *object,
   g_autoptr(IdeTask) task = user_data;
   g_autoptr(GVariant) reply = NULL;
   g_autoptr(GError) error = NULL;
+  Call *call;
 
   g_assert (JSONRPC_IS_CLIENT (rpc_client));
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
 
+  call = ide_task_get_task_data (task);
+
+  /* Includes waiting for the daemon to spawn and the worker to finish */
+  ide_profiler_mark (call->begin_time,
+                     g_get_monotonic_time (),
+                     "clang",
+                     call->method,
+                     NULL);
+
   if (!jsonrpc_client_call_finish (rpc_client, result, &reply, &error))
     ide_task_return_error (task, g_steal_pointer (&error));
   else
@@ -573,6 +584,7 @@ ide_clang_client_call_async (IdeClangClient      *self,
   call->self = g_object_ref (self);
   call->method = g_strdup (method);
   call->params = params ? g_variant_ref_sink (params) : NULL;
+  call->begin_time = g_get_monotonic_time ();
 
   task = ide_task_new (self, cancellable, callback, user_data);
   ide_task_set_source_tag (task, ide_clang_client_call_async);
@@ -197,6 +197,7 @@ ide_clang_completion_provider_activate (GtkSourceCompletionProvider *provider,
   IdeFileSettings *file_settings;
   GtkSourceBuffer *buffer;
   GtkSourceView *view;
+  IdeContext *ide_context;
   GtkTextIter begin, end;
   guint n_chunks;
 
@@ -297,6 +298,9 @@ ide_clang_completion_provider_activate (GtkSourceCompletionProvider *provider,
   gtk_source_view_push_snippet (view, snippet, &begin);
 
   gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (buffer));
+
+  if ((ide_context = ide_object_get_context (IDE_OBJECT (self))))
+    ide_completion_history_record_proposal (ide_completion_history_from_context (ide_context), proposal);
 }
 
 static void
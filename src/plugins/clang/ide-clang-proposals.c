@@ -70,13 +70,18 @@ struct _IdeClangProposals
   ResultsRef results_ref;
 
   /*
-   * Instead of inflating GObjects for each of our matches, we instead keep
-   * an index for all of the items that match the current result set. When
-   * the new result variant is returned, this is set to an array that is 1:1
-   * of the variant indexes or filtered based on the typed_text to only include
-   * the items that match).
+   * Instead of inflating GObjects for each of our matches, the ranker keeps
+   * the index of each result along with its keyword. It filters and sorts
+   * them based on the typed_text, and reuses the previous matches when the
+   * user continues typing the same word.
    */
-  GArray *match_indexes;
+  IdeCompletionRanker *ranker;
+
+  /*
+   * The number of items exposed through the GListModel. This is zero after
+   * the proposals are cleared even though the ranker still has matches.
+   */
+  guint n_items;
 
   /*
    * The word we are trying to filter. If we are waiting on a previous query
@@ -129,13 +134,6 @@ typedef struct
   guint           query_id;
 } Query;
 
-typedef struct
-{
-  ProposalRef ref;
-  const char *keyword;
-  guint priority;
-} Item;
-
 enum {
   PROP_0,
   PROP_CLIENT,
@@ -171,7 +169,7 @@ ide_clang_proposals_finalize (GObject *object)
   g_clear_object (&self->client);
   g_clear_object (&self->cancellable);
   g_clear_pointer (&self->filter, g_free);
-  g_clear_pointer (&self->match_indexes, g_array_unref);
+  g_clear_object (&self->ranker);
   g_clear_pointer (&self->results, g_variant_unref);
   self->results_ref = (ResultsRef) { NULL, 0 };
 
@@ -240,7 +238,6 @@ ide_clang_proposals_init (IdeClangProposals *self)
 {
   self->line = -1;
   self->line_offset = -1;
-  self->match_indexes = g_array_new (FALSE, FALSE, sizeof (Item));
 }
 
 void
@@ -258,8 +255,8 @@ ide_clang_proposals_clear (IdeClangProposals *self)
 
   ide_clear_string (&self->filter);
 
-  if ((old_len = self->match_indexes->len))
-    g_array_remove_range (self->match_indexes, 0, self->match_indexes->len);
+  old_len = self->n_items;
+  self->n_items = 0;
 
   list = g_steal_pointer (&self->queued_tasks.head);
   self->queued_tasks.head = NULL;
@@ -300,118 +297,61 @@ ide_clang_proposals_get_client (IdeClangProposals *self)
   return self->client;
 }
 
-static gint
-sort_by_priority (gconstpointer a,
-                  gconstpointer b)
-{
-  const Item *ai = a;
-  const Item *bi = b;
-
-  if (ai->priority < bi->priority)
-    return -1;
-  else if (ai->priority > bi->priority)
-    return 1;
-  else
-    return 0;
-}
-
 static void
-ide_clang_proposals_do_refilter (IdeClangProposals *self,
-                                 gboolean           fast_refilter)
+ide_clang_proposals_do_refilter (IdeClangProposals *self)
 {
-  g_autofree gchar *folded = NULL;
-  VariantRef v;
-  guint old_len = 0;
-  guint n_items;
+  guint old_len;
 
   IDE_ENTRY;
 
   g_assert (IDE_IS_CLANG_PROPOSALS (self));
 
-  old_len = self->match_indexes->len;
-
-  if (self->filter != NULL)
-    folded = g_utf8_casefold (self->filter, -1);
-
-  if (fast_refilter)
-    {
-      for (guint i = old_len; i > 0; i--)
-        {
-          Item *item = &g_array_index (self->match_indexes, Item, i - 1);
-          guint priority;
-
-          if (item->keyword == NULL || !gtk_source_completion_fuzzy_match (item->keyword, folded, &priority))
-            g_array_remove_index_fast (self->match_indexes, i - 1);
-          else
-            item->priority = priority;
-        }
-
-      g_array_sort (self->match_indexes, sort_by_priority);
-
-      g_list_model_items_changed (G_LIST_MODEL (self), 0, old_len, self->match_indexes->len);
-
-      IDE_EXIT;
-    }
-
-  if (old_len > 0)
-    g_array_remove_range (self->match_indexes, 0, old_len);
-
-  if (self->results != NULL)
-    n_items = (guint)results_get_length (self->results_ref);
-  else
-    n_items = 0;
-
   IDE_TRACE_MSG ("Filtering with filter: '%s'", self->filter ? self->filter : "");
 
-  if (self->filter == NULL || self->filter[0] == 0)
-    {
-      g_array_set_size (self->match_indexes, n_items);
+  old_len = self->n_items;
 
-      for (guint i = 0; i < n_items; i++)
-        {
-          Item *item = &g_array_index (self->match_indexes, Item, i);
+  if (self->ranker != NULL)
+    self->n_items = ide_completion_ranker_refilter (self->ranker, self->filter);
+  else
+    self->n_items = 0;
 
-          item->ref = results_get_at (self->results_ref, i);
-          item->priority = i;
+  IDE_TRACE_MSG ("Filtered into %u proposals", self->n_items);
 
-          if (proposal_lookup (item->ref, "keyword", NULL, &v))
-            item->keyword = variant_get_string (v);
-          else
-            item->keyword = "";
-        }
-    }
-  else if (self->results != NULL)
-    {
-      guint pos = 0;
+  g_list_model_items_changed (G_LIST_MODEL (self), 0, old_len, self->n_items);
 
-      g_array_set_size (self->match_indexes, n_items);
+  IDE_EXIT;
+}
 
-      for (guint i = 0; i < n_items; i++)
-        {
-          Item *item = &g_array_index (self->match_indexes, Item, pos);
+static IdeCompletionRanker *
+ide_clang_proposals_create_ranker (IdeClangProposals *self)
+{
+  IdeCompletionHistory *history = NULL;
+  IdeCompletionRanker *ranker;
+  IdeContext *context;
+  guint n_items;
 
-          item->ref = results_get_at (self->results_ref, i);
+  g_assert (IDE_IS_CLANG_PROPOSALS (self));
+  g_assert (self->results != NULL);
 
-          if (proposal_lookup (item->ref, "keyword", NULL, &v))
-            item->keyword = variant_get_string (v);
-          else
-            continue;
+  if ((context = ide_object_get_context (IDE_OBJECT (self->client))))
+    history = ide_completion_history_from_context (context);
 
-          if (!gtk_source_completion_fuzzy_match (item->keyword, folded, &item->priority))
-            continue;
+  ranker = ide_completion_ranker_new (history);
+  n_items = (guint)results_get_length (self->results_ref);
 
-          pos++;
-        }
+  for (guint i = 0; i < n_items; i++)
+    {
+      ProposalRef ref = results_get_at (self->results_ref, i);
+      VariantRef v;
 
-      g_array_set_size (self->match_indexes, pos);
-      g_array_sort (self->match_indexes, sort_by_priority);
+      /* Proposals without a keyword only match an empty filter */
+      if (proposal_lookup (ref, "keyword", NULL, &v))
+        ide_completion_ranker_add_candidate (ranker, i, variant_get_string (v));
+      else
+        ide_completion_ranker_add_candidate (ranker, i, "");
     }
 
-  IDE_TRACE_MSG ("Filtered %u into %u proposals", n_items, self->match_indexes->len);
-
-  g_list_model_items_changed (G_LIST_MODEL (self), 0, old_len, self->match_indexes->len);
-
-  IDE_EXIT;
+  return ranker;
 }
 
 static void
@@ -434,15 +374,19 @@ ide_clang_proposals_flush (IdeClangProposals *self,
   g_clear_pointer (&self->results, g_variant_unref);
   self->results = results;
 
+  g_clear_object (&self->ranker);
+
   if (results != NULL)
-    self->results_ref = results_from_gvariant (results);
+    {
+      self->results_ref = results_from_gvariant (results);
+      self->ranker = ide_clang_proposals_create_ranker (self);
+    }
   else
-    self->results_ref = (ResultsRef) { NULL, 0 };
-
-  if (self->match_indexes->len > 0)
-    g_array_remove_range (self->match_indexes, 0, self->match_indexes->len);
+    {
+      self->results_ref = (ResultsRef) { NULL, 0 };
+    }
 
-  ide_clang_proposals_do_refilter (self, FALSE);
+  ide_clang_proposals_do_refilter (self);
 
   list = g_steal_pointer (&self->queued_tasks.head);
   self->queued_tasks.head = NULL;
@@ -692,23 +636,11 @@ ide_clang_proposals_populate_async (IdeClangProposals   *self,
 
   /*
    * Now we know we have results and can refilter them. If the current word
-   * contains the previous word as a prefix, then we can simply refilter using
-   * the linked-list (rather than reset from the array).
-   */
-  if (self->filter == NULL || (word && g_str_has_prefix (word, self->filter)))
-    {
-      g_set_str (&self->filter, word);
-      ide_clang_proposals_do_refilter (self, TRUE);
-      ide_task_return_boolean (task, TRUE);
-      IDE_EXIT;
-    }
-
-  /*
-   * So we can reuse the results, but since the user backspaced we have to
-   * clear the linked list and update by walking the whole array.
+   * contains the previous word as a prefix, the ranker only needs to look
+   * at the previous matches. Otherwise it walks all of the results.
    */
   g_set_str (&self->filter, word);
-  ide_clang_proposals_do_refilter (self, FALSE);
+  ide_clang_proposals_do_refilter (self);
   ide_task_return_boolean (task, TRUE);
 
   IDE_EXIT;
@@ -733,7 +665,7 @@ query_client:
    * attached as intermediate results, we have something useful to display.
    */
   if (self->results != NULL)
-    ide_clang_proposals_do_refilter (self, FALSE);
+    ide_clang_proposals_do_refilter (self);
 
   ide_clang_proposals_query_async (self,
                                    file,
@@ -769,15 +701,12 @@ void
 ide_clang_proposals_refilter (IdeClangProposals *self,
                               const gchar       *word)
 {
-  gboolean fast_refilter;
-
   IDE_ENTRY;
 
   g_assert (IDE_IS_CLANG_PROPOSALS (self));
 
-  fast_refilter = self->filter && word && g_str_has_prefix (word, self->filter);
   g_set_str (&self->filter, word);
-  ide_clang_proposals_do_refilter (self, fast_refilter);
+  ide_clang_proposals_do_refilter (self);
 
   IDE_EXIT;
 }
@@ -785,7 +714,7 @@ ide_clang_proposals_refilter (IdeClangProposals *self,
 static guint
 ide_clang_proposals_get_n_items (GListModel *model)
 {
-  return IDE_CLANG_PROPOSALS (model)->match_indexes->len;
+  return IDE_CLANG_PROPOSALS (model)->n_items;
 }
 
 static GType
@@ -800,10 +729,10 @@ ide_clang_proposals_get_item (GListModel *model,
 {
   IdeClangProposals *self = IDE_CLANG_PROPOSALS (model);
 
-  if G_LIKELY (position < self->match_indexes->len)
+  if G_LIKELY (position < self->n_items)
     {
-      Item *item = &g_array_index (self->match_indexes, Item, position);
-      return ide_clang_completion_item_new (self->results, item->ref);
+      guint index = ide_completion_ranker_get_index (self->ranker, position);
+      return ide_clang_completion_item_new (self->results, results_get_at (self->results_ref, index));
     }
 
   return NULL;
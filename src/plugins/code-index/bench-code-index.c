@@ -0,0 +1,249 @@
+/* bench-code-index.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-code.h>
+#include <libide-core.h>
+
+#include "gbp-code-index-builder.h"
+#include "ide-code-index-index.h"
+
+#include "tests/bench-util.h"
+
+/* Symbols are spread over files like a medium sized C project */
+#define SYMBOLS_PER_FILE 50
+
+static const char *queries[] = {
+  "buf", "ide_buf_get", "pipln", "gcmc", "function fuzzy_index_query", "lsp_cl", "xyz",
+};
+
+typedef struct
+{
+  const char        *corpus;
+  GPtrArray         *identifiers;
+  GPtrArray         *files;
+  GFile             *source_dir;
+  GFile             *index_dir;
+  IdeContext        *context;
+  IdeCodeIndexIndex *index;
+} Corpus;
+
+static GPtrArray *
+create_entries (Corpus *corpus,
+                guint   file_index)
+{
+  g_autoptr(IdeCodeIndexEntryBuilder) builder = ide_code_index_entry_builder_new ();
+  GPtrArray *entries = g_ptr_array_new_with_free_func ((GDestroyNotify)ide_code_index_entry_free);
+  guint begin = file_index * SYMBOLS_PER_FILE;
+  guint end = MIN (begin + SYMBOLS_PER_FILE, corpus->identifiers->len);
+
+  for (guint i = begin; i < end; i++)
+    {
+      const char *name = g_ptr_array_index (corpus->identifiers, i);
+      g_autofree char *key = g_strdup_printf ("c:@F@%s", name);
+      g_autofree char *fuzzy_name = g_strdup_printf ("f\x1F%s", name);
+      guint line = (i - begin) * 20 + 1;
+
+      /* Same shape as the entries produced by the clang indexer */
+      ide_code_index_entry_builder_set_key (builder, key);
+      ide_code_index_entry_builder_set_name (builder, fuzzy_name);
+      ide_code_index_entry_builder_set_kind (builder, IDE_SYMBOL_KIND_FUNCTION);
+      ide_code_index_entry_builder_set_flags (builder, IDE_SYMBOL_FLAGS_IS_DEFINITION);
+      ide_code_index_entry_builder_set_range (builder, line, 1, line, 1);
+
+      g_ptr_array_add (entries, ide_code_index_entry_builder_build (builder));
+    }
+
+  return entries;
+}
+
+static void
+run_cb (GObject      *object,
+        GAsyncResult *result,
+        gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+  gboolean *done = user_data;
+
+  gbp_code_index_builder_run_finish (GBP_CODE_INDEX_BUILDER (object), result, &error);
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static void
+builder_run (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(GbpCodeIndexBuilder) builder = NULL;
+  gboolean done = FALSE;
+
+  builder = gbp_code_index_builder_new (corpus->source_dir, corpus->index_dir);
+
+  /* The builder numbers files from 0 while lookups treat a file id of 0
+   * as missing, so the first file is left empty to keep every symbol
+   * reachable.
+   */
+  gbp_code_index_builder_add_entries (builder, g_ptr_array_index (corpus->files, 0), NULL);
+
+  for (guint i = 1; i < corpus->files->len; i++)
+    {
+      g_autoptr(GPtrArray) entries = create_entries (corpus, i - 1);
+
+      gbp_code_index_builder_add_entries (builder,
+                                          g_ptr_array_index (corpus->files, i),
+                                          entries);
+    }
+
+  gbp_code_index_builder_run_async (builder, NULL, run_cb, &done);
+  bench_wait (&done);
+}
+
+static void
+populate_cb (GObject      *object,
+             GAsyncResult *result,
+             gpointer      user_data)
+{
+  g_autoptr(GPtrArray) results = NULL;
+  g_autoptr(GError) error = NULL;
+  gboolean *done = user_data;
+
+  results = ide_code_index_index_populate_finish (IDE_CODE_INDEX_INDEX (object), result, NULL, &error);
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static void
+index_query (gpointer data)
+{
+  Corpus *corpus = data;
+
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    {
+      gboolean done = FALSE;
+
+      ide_code_index_index_populate_async (corpus->index, queries[i], 100, NULL, populate_cb, &done);
+      bench_wait (&done);
+    }
+}
+
+static void
+index_lookup_symbol (gpointer data)
+{
+  Corpus *corpus = data;
+  char key[256];
+
+  for (guint i = 0; i < corpus->identifiers->len; i++)
+    {
+      g_autoptr(IdeSymbol) symbol = NULL;
+
+      g_snprintf (key, sizeof key, "c:@F@%s", (const char *)g_ptr_array_index (corpus->identifiers, i));
+      symbol = ide_code_index_index_lookup_symbol (corpus->index, key);
+      g_assert_nonnull (symbol);
+    }
+}
+
+static void
+index_load (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdeCodeIndexIndex) index = ide_code_index_index_new (IDE_OBJECT (corpus->context));
+  g_autoptr(GError) error = NULL;
+
+  ide_code_index_index_load (index, corpus->index_dir, corpus->source_dir, NULL, &error);
+  g_assert_no_error (error);
+
+  ide_object_destroy (IDE_OBJECT (index));
+}
+
+static void
+bench_corpus (const char *name,
+              GPtrArray  *identifiers)
+{
+  g_autoptr(IdeContext) context = ide_context_new ();
+  g_autoptr(GPtrArray) files = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr(GFile) source_dir = NULL;
+  g_autoptr(GFile) index_dir = NULL;
+  g_autoptr(GFile) keys_file = NULL;
+  g_autoptr(GFile) names_file = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree char *tmpdir = NULL;
+  guint n_files;
+  Corpus corpus;
+
+  tmpdir = g_dir_make_tmp ("bench-code-index-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  source_dir = g_file_new_for_path (tmpdir);
+  index_dir = g_file_get_child (source_dir, ".index");
+  keys_file = g_file_get_child (index_dir, "SymbolKeys");
+  names_file = g_file_get_child (index_dir, "SymbolNames");
+
+  n_files = (identifiers->len + SYMBOLS_PER_FILE - 1) / SYMBOLS_PER_FILE;
+  for (guint i = 0; i < n_files + 1; i++)
+    {
+      g_autofree char *child = g_strdup_printf ("file-%u.c", i);
+      g_ptr_array_add (files, g_file_get_child (source_dir, child));
+    }
+
+  corpus = (Corpus) {
+    .corpus = name,
+    .identifiers = identifiers,
+    .files = files,
+    .source_dir = source_dir,
+    .index_dir = index_dir,
+    .context = context,
+  };
+
+  bench_run ("code-index-builder", name, identifiers->len, builder_run, &corpus);
+  bench_run ("code-index-load", name, 1, index_load, &corpus);
+
+  corpus.index = ide_code_index_index_new (IDE_OBJECT (context));
+  ide_code_index_index_load (corpus.index, index_dir, source_dir, NULL, &error);
+  g_assert_no_error (error);
+
+  bench_run ("code-index-query", name, G_N_ELEMENTS (queries), index_query, &corpus);
+  bench_run ("code-index-lookup-symbol", name, identifiers->len, index_lookup_symbol, &corpus);
+
+  ide_object_destroy (IDE_OBJECT (corpus.index));
+  g_clear_object (&corpus.index);
+
+  ide_object_destroy (IDE_OBJECT (context));
+
+  g_file_delete (keys_file, NULL, NULL);
+  g_file_delete (names_file, NULL, NULL);
+  g_file_delete (index_dir, NULL, NULL);
+  g_file_delete (source_dir, NULL, NULL);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GPtrArray) synthetic = bench_synthetic_identifiers (50000);
+  g_autoptr(GPtrArray) recorded = bench_recorded_identifiers ();
+
+  bench_begin ("code-index");
+  bench_corpus ("synthetic", synthetic);
+  bench_corpus ("recorded", recorded);
+  bench_end ();
+
+  return EXIT_SUCCESS;
+}
@@ -52,6 +52,35 @@ typedef struct
 
 G_DEFINE_FINAL_TYPE (GbpCodeIndexBuilder, gbp_code_index_builder, IDE_TYPE_OBJECT)
 
+static guint files_counter_id;
+static guint symbols_counter_id;
+static gint64 n_files_indexed;
+static gint64 n_symbols_indexed;
+
+static void
+update_counters (guint n_symbols)
+{
+  static gboolean defined;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+
+  if (!ide_profiler_is_active ())
+    return;
+
+  if (!defined)
+    {
+      defined = TRUE;
+      files_counter_id = ide_profiler_define_counter ("Code Index", "Files", "Files indexed");
+      symbols_counter_id = ide_profiler_define_counter ("Code Index", "Symbols", "Symbols indexed");
+    }
+
+  n_files_indexed++;
+  n_symbols_indexed += n_symbols;
+
+  ide_profiler_set_counter (files_counter_id, n_files_indexed);
+  ide_profiler_set_counter (symbols_counter_id, n_symbols_indexed);
+}
+
 static void
 run_free (Run *state)
 {
@@ -114,6 +143,8 @@ gbp_code_index_builder_submit (GbpCodeIndexBuilder *self,
   ide_fuzzy_index_builder_set_metadata_uint32 (self->fuzzy, filename, file_id);
   ide_fuzzy_index_builder_set_metadata_string (self->fuzzy, num, filename);
 
+  update_counters (entries ? entries->len : 0);
+
   if (entries == NULL)
     return;
 
@@ -192,6 +223,29 @@ gbp_code_index_builder_add_item (GbpCodeIndexBuilder        *self,
   g_ptr_array_add (self->items, gbp_code_index_plan_item_copy (item));
 }
 
+/**
+ * gbp_code_index_builder_add_entries:
+ * @self: a #GbpCodeIndexBuilder
+ * @file: the file the entries were collected from
+ * @entries: (element-type IdeCodeIndexEntry) (nullable): entries for @file
+ *
+ * Adds entries which were already collected for @file, bypassing the
+ * indexer plugins. They are persisted along with the indexed items
+ * when gbp_code_index_builder_run_async() is called.
+ */
+void
+gbp_code_index_builder_add_entries (GbpCodeIndexBuilder *self,
+                                    GFile               *file,
+                                    GPtrArray           *entries)
+{
+  g_return_if_fail (IDE_IS_MAIN_THREAD ());
+  g_return_if_fail (GBP_IS_CODE_INDEX_BUILDER (self));
+  g_return_if_fail (self->has_run == FALSE);
+  g_return_if_fail (G_IS_FILE (file));
+
+  gbp_code_index_builder_submit (self, file, entries);
+}
+
 static void
 code_index_entries_collect_cb (GObject      *object,
                                GAsyncResult *result,
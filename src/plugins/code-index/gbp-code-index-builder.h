@@ -34,6 +34,9 @@ GbpCodeIndexBuilder *gbp_code_index_builder_new         (GFile
                                                          GFile                       *index_dir);
 void                 gbp_code_index_builder_add_item    (GbpCodeIndexBuilder         *self,
                                                          const GbpCodeIndexPlanItem  *item);
+void                 gbp_code_index_builder_add_entries (GbpCodeIndexBuilder         *self,
+                                                         GFile                       *file,
+                                                         GPtrArray                   *entries);
 void                 gbp_code_index_builder_run_async   (GbpCodeIndexBuilder         *self,
                                                          GCancellable                *cancellable,
                                                          GAsyncReadyCallback          callback,
@@ -26,6 +26,7 @@
 #include <gtksourceview/gtksource.h>
 #include <libide-code.h>
 #include <libide-foundry.h>
+#include <libide-gui.h>
 #include <libide-projects.h>
 #include <libide-vcs.h>
 #include <libpeas/peas.h>
@@ -59,6 +60,8 @@ typedef struct
   IdeCodeIndexIndex *index;
   GFile *workdir;
   GFile *indexdir;
+  IdeIndexRegistry *registry;
+  char *runtime_id;
 } LoadIndexes;
 
 enum {
@@ -86,6 +89,8 @@ load_indexes_free (LoadIndexes *state)
   g_clear_object (&state->index);
   g_clear_object (&state->indexdir);
   g_clear_object (&state->workdir);
+  g_clear_object (&state->registry);
+  g_clear_pointer (&state->runtime_id, g_free);
   g_slice_free (LoadIndexes, state);
 }
 
@@ -701,6 +706,24 @@ gbp_code_index_service_load_indexes_cb (GFile     *directory,
                              NULL);
 }
 
+static void
+gbp_code_index_service_load_sdk_indexes_cb (GFile     *directory,
+                                            GPtrArray *file_infos,
+                                            gpointer   user_data)
+{
+  LoadIndexes *state = user_data;
+
+  g_assert (G_IS_FILE (directory));
+  g_assert (state != NULL);
+
+  /* Prebuilt indexes store absolute paths to the SDK headers */
+  ide_code_index_index_load (state->index,
+                             directory,
+                             directory,
+                             NULL,
+                             NULL);
+}
+
 static void
 gbp_code_index_service_load_indexes (IdeTask      *task,
                                      gpointer      source_object,
@@ -722,6 +745,18 @@ gbp_code_index_service_load_indexes (IdeTask      *task,
                    gbp_code_index_service_load_indexes_cb,
                    state);
 
+  if (state->registry != NULL && state->runtime_id != NULL)
+    {
+      g_autoptr(GFile) sdkdir = NULL;
+
+      if ((sdkdir = ide_index_registry_find_prebuilt (state->registry, "code-index", state->runtime_id)))
+        ide_g_file_walk (sdkdir,
+                         NULL,
+                         cancellable,
+                         gbp_code_index_service_load_sdk_indexes_cb,
+                         state);
+    }
+
   ide_task_return_boolean (task, TRUE);
 }
 
@@ -729,7 +764,10 @@ static void
 gbp_code_index_service_reload_indexes (GbpCodeIndexService *self)
 {
   g_autoptr(IdeContext) context = NULL;
+  g_autoptr(IdeConfig) config = NULL;
   g_autoptr(IdeTask) task = NULL;
+  IdeConfigManager *config_manager;
+  IdeRuntime *runtime;
   LoadIndexes *state;
 
   g_assert (IDE_IS_MAIN_THREAD ());
@@ -738,11 +776,20 @@ gbp_code_index_service_reload_indexes (GbpCodeIndexService *self)
   if (!(context = ide_object_ref_context (IDE_OBJECT (self))))
     return;
 
+  config_manager = ide_config_manager_from_context (context);
+  config = ide_config_manager_ref_current (config_manager);
+
   state = g_slice_new0 (LoadIndexes);
   state->index = g_object_ref (self->index);
   state->workdir = ide_context_ref_workdir (context);
   state->indexdir = ide_context_cache_file (context, "code-index", NULL);
 
+  /* Also pick up indexes prebuilt for the headers of the current SDK */
+  if (IDE_IS_APPLICATION (g_application_get_default ()))
+    state->registry = g_object_ref (ide_application_get_index_registry (IDE_APPLICATION_DEFAULT));
+  if (config != NULL && (runtime = ide_config_get_runtime (config)))
+    state->runtime_id = g_strdup (ide_runtime_get_id (runtime));
+
   task = ide_task_new (self, NULL, NULL, NULL);
   ide_task_set_source_tag (task, gbp_code_index_service_reload_indexes);
   ide_task_set_task_data (task, state, load_indexes_free);
@@ -23,6 +23,8 @@
 #include <glib/gprintf.h>
 #include <glib/gi18n.h>
 
+#include <libide-gui.h>
+
 #include "ide-code-index-search-result.h"
 #include "ide-code-index-index.h"
 
@@ -38,6 +40,9 @@ struct _IdeCodeIndexIndex
   GMutex      mutex;
   GHashTable *directories;
   GPtrArray  *indexes;
+
+  /* Shares identical index files with other projects, may be NULL */
+  IdeIndexRegistry *registry;
 };
 
 typedef struct
@@ -140,12 +145,65 @@ fuzzy_match_compare (const FuzzyMatch *a,
     return 0;
 }
 
+static IdePersistentMap *
+load_symbol_keys (IdeIndexRegistry  *registry,
+                  GFile             *file,
+                  GCancellable      *cancellable,
+                  GError           **error)
+{
+  g_autoptr(IdePersistentMap) map = NULL;
+
+  g_assert (!registry || IDE_IS_INDEX_REGISTRY (registry));
+  g_assert (G_IS_FILE (file));
+
+  if (registry != NULL &&
+      (map = ide_index_registry_lookup (registry, IDE_TYPE_PERSISTENT_MAP, file, NULL)))
+    return g_steal_pointer (&map);
+
+  map = ide_persistent_map_new ();
+
+  if (!ide_persistent_map_load_file (map, file, cancellable, error))
+    return NULL;
+
+  if (registry != NULL)
+    return ide_index_registry_insert (registry, file, NULL, map);
+
+  return g_steal_pointer (&map);
+}
+
+static IdeFuzzyIndex *
+load_symbol_names (IdeIndexRegistry  *registry,
+                   GFile             *file,
+                   GCancellable      *cancellable,
+                   GError           **error)
+{
+  g_autoptr(IdeFuzzyIndex) index = NULL;
+
+  g_assert (!registry || IDE_IS_INDEX_REGISTRY (registry));
+  g_assert (G_IS_FILE (file));
+
+  if (registry != NULL &&
+      (index = ide_index_registry_lookup (registry, IDE_TYPE_FUZZY_INDEX, file, NULL)))
+    return g_steal_pointer (&index);
+
+  index = ide_fuzzy_index_new ();
+
+  if (!ide_fuzzy_index_load_file (index, file, cancellable, error))
+    return NULL;
+
+  if (registry != NULL)
+    return ide_index_registry_insert (registry, file, NULL, index);
+
+  return g_steal_pointer (&index);
+}
+
 /* This function will load indexes and returns them */
 static DirectoryIndex *
-directory_index_new (GFile         *directory,
-                     GFile         *source_directory,
-                     GCancellable  *cancellable,
-                     GError       **error)
+directory_index_new (IdeIndexRegistry  *registry,
+                     GFile             *directory,
+                     GFile             *source_directory,
+                     GCancellable      *cancellable,
+                     GError           **error)
 {
   g_autoptr(GFile) keys_file = NULL;
   g_autoptr(GFile) names_file = NULL;
@@ -153,19 +211,18 @@ directory_index_new (GFile         *directory,
   g_autoptr(IdePersistentMap) symbol_keys = NULL;
   g_autoptr(DirectoryIndex) dir_index = NULL;
 
+  g_assert (!registry || IDE_IS_INDEX_REGISTRY (registry));
   g_assert (G_IS_FILE (directory));
   g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-  symbol_keys = ide_persistent_map_new ();
   keys_file = g_file_get_child (directory, "SymbolKeys");
 
-  if (!ide_persistent_map_load_file (symbol_keys, keys_file, cancellable, error))
+  if (!(symbol_keys = load_symbol_keys (registry, keys_file, cancellable, error)))
     return NULL;
 
-  symbol_names = ide_fuzzy_index_new ();
   names_file = g_file_get_child (directory, "SymbolNames");
 
-  if (!ide_fuzzy_index_load_file (symbol_names, names_file, cancellable, error))
+  if (!(symbol_names = load_symbol_names (registry, names_file, cancellable, error)))
     return NULL;
 
   dir_index = g_slice_new0 (DirectoryIndex);
@@ -251,7 +308,7 @@ ide_code_index_index_load (IdeCodeIndexIndex   *self,
   dir_name = g_file_get_path (directory);
   g_debug ("Loading code index from %s", dir_name);
 
-  if (!(dir_index = directory_index_new (directory, source_directory, cancellable, error)))
+  if (!(dir_index = directory_index_new (self->registry, directory, source_directory, cancellable, error)))
     return FALSE;
 
   g_mutex_lock (&self->mutex);
@@ -582,16 +639,31 @@ ide_code_index_index_lookup_symbol (IdeCodeIndexIndex *self,
 
   for (guint i = 0; i < self->indexes->len; i++)
     {
-      g_autoptr(GVariant) variant = NULL;
+      const IdePersistentMapRecord *record;
 
       dir_index = g_ptr_array_index (self->indexes, i);
 
-      if (!(variant = ide_persistent_map_lookup_value (dir_index->symbol_keys, key)))
-        continue;
+      if (!(record = ide_persistent_map_lookup_record (dir_index->symbol_keys, key)))
+        {
+          g_autoptr(GVariant) variant = NULL;
+
+          /* Maps with non-native byte order cannot be borrowed from */
+          if (!(variant = ide_persistent_map_lookup_value (dir_index->symbol_keys, key)))
+            continue;
 
-      symbol_names = dir_index->symbol_names;
+          symbol_names = dir_index->symbol_names;
 
-      g_variant_get (variant, "(uuuu)", &file_id, &line, &line_offset, &flags);
+          g_variant_get (variant, "(uuuu)", &file_id, &line, &line_offset, &flags);
+        }
+      else
+        {
+          symbol_names = dir_index->symbol_names;
+
+          file_id = record->values[0];
+          line = record->values[1];
+          line_offset = record->values[2];
+          flags = record->values[3];
+        }
 
       if (flags & IDE_SYMBOL_FLAGS_IS_DEFINITION)
         break;
@@ -623,6 +695,7 @@ ide_code_index_index_finalize (GObject *object)
 
   g_clear_pointer (&self->directories, g_hash_table_unref);
   g_clear_pointer (&self->indexes, g_ptr_array_unref);
+  g_clear_object (&self->registry);
 
   g_mutex_clear (&self->mutex);
 
@@ -635,6 +708,9 @@ ide_code_index_index_init (IdeCodeIndexIndex *self)
   self->directories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
   self->indexes = g_ptr_array_new_with_free_func ((GDestroyNotify)directory_index_free);
 
+  if (IDE_IS_APPLICATION (g_application_get_default ()))
+    self->registry = g_object_ref (ide_application_get_index_registry (IDE_APPLICATION_DEFAULT));
+
   g_mutex_init (&self->mutex);
 }
 
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include "ide-text-scan-private.h"
+
 #include "code-index.h"
 #include "code-sparse-set.h"
 
@@ -52,31 +54,44 @@ _code_trigram_iter_next_char (CodeTrigramIter *iter,
   if (iter->pos >= iter->end)
     return FALSE;
 
-  /* Since we're reading files they may not be in modified UTF-8 format.
-   * If they're in regular UTF-8 there could be embedded Nil bytes. Handle
-   * those specifically because g_utf8_*() will not.
+  /* Most of what we index is ASCII, so locate runs of it using the text
+   * scanning kernels and avoid UTF-8 decoding within them entirely.
+   *
+   * Since we're reading files they may not be in modified UTF-8 format.
+   * If they're in regular UTF-8 there could be embedded Nil bytes, which
+   * are part of the ASCII run because g_utf8_*() will not handle them.
    */
+  if (iter->pos >= iter->ascii_end)
+    iter->ascii_end = iter->pos + _ide_text_ascii_len (iter->pos, iter->end - iter->pos);
 
-  if G_UNLIKELY (iter->pos[0] == 0)
+  if G_LIKELY (iter->pos < iter->ascii_end)
     {
-      *ch = 0;
+      *ch = *(const guchar *)iter->pos;
       iter->pos++;
       return TRUE;
     }
 
-  *ch = g_utf8_get_char_validated (iter->pos, iter->end - iter->pos);
-
-  if (*ch == (gunichar)-1 || *ch == (gunichar)-2)
+  if (!_ide_text_utf8_next (&iter->pos, iter->end, ch))
     {
       iter->pos = iter->end;
       return FALSE;
     }
 
-  iter->pos = g_utf8_next_char (iter->pos);
-
   return TRUE;
 }
 
+static inline gboolean
+_code_trigram_isspace (gunichar ch)
+{
+  /* Matches g_unichar_isspace() which, unlike g_ascii_isspace(),
+   * does not treat vertical tab as a space.
+   */
+  if G_LIKELY (ch < 0x80)
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+
+  return g_unichar_isspace (ch);
+}
+
 void
 code_trigram_iter_init (CodeTrigramIter *iter,
                         const char      *text,
@@ -87,6 +102,7 @@ code_trigram_iter_init (CodeTrigramIter *iter,
 
   iter->pos = text;
   iter->end = text + len;
+  iter->ascii_end = text;
 
   if (_code_trigram_iter_next_char (iter, &iter->trigram.y))
     _code_trigram_iter_next_char (iter, &iter->trigram.z);
@@ -105,9 +121,9 @@ code_trigram_iter_next (CodeTrigramIter *iter,
   if (!_code_trigram_iter_next_char (iter, &iter->trigram.z))
     return FALSE;
 
-  trigram->x = !g_unichar_isspace (iter->trigram.x) ? iter->trigram.x : '_';
-  trigram->y = !g_unichar_isspace (iter->trigram.y) ? iter->trigram.y : '_';
-  trigram->z = !g_unichar_isspace (iter->trigram.z) ? iter->trigram.z : '_';
+  trigram->x = !_code_trigram_isspace (iter->trigram.x) ? iter->trigram.x : '_';
+  trigram->y = !_code_trigram_isspace (iter->trigram.y) ? iter->trigram.y : '_';
+  trigram->z = !_code_trigram_isspace (iter->trigram.z) ? iter->trigram.z : '_';
 
   return TRUE;
 }
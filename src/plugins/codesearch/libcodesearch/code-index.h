@@ -42,6 +42,7 @@ typedef struct _CodeTrigramIter
 {
   const char *pos;
   const char *end;
+  const char *ascii_end;
   CodeTrigram trigram;
 } CodeTrigramIter;
 
@@ -22,6 +22,8 @@
 
 #include <string.h>
 
+#include "ide-text-scan-private.h"
+
 #include "code-line-reader.h"
 
 void
@@ -65,6 +67,7 @@ code_line_reader_next (CodeLineReader *reader,
                        gsize          *length)
 {
   char *ret = NULL;
+  const char *eol;
 
   g_assert (reader);
   g_assert (length != NULL);
@@ -76,21 +79,20 @@ code_line_reader_next (CodeLineReader *reader,
     }
 
   ret = &reader->contents [reader->pos];
+  eol = _ide_text_find_byte (ret, reader->length - reader->pos, '\n');
 
-  for (; reader->pos < reader->length; reader->pos++)
+  if (eol != NULL)
     {
-      if (reader->contents [reader->pos] == '\n')
-        {
-          *length = &reader->contents [reader->pos] - ret;
-          /* Ignore the \r in \r\n if provcoded */
-          if (*length > 0 && reader->pos > 0 && reader->contents [reader->pos - 1] == '\r')
-            (*length)--;
-          reader->pos++;
-          return ret;
-        }
+      *length = eol - ret;
+      /* Ignore the \r in \r\n if provided */
+      if (*length > 0 && eol[-1] == '\r')
+        (*length)--;
+      reader->pos = eol - reader->contents + 1;
+      return ret;
     }
 
-  *length = &reader->contents [reader->pos] - ret;
+  *length = reader->length - reader->pos;
+  reader->pos = reader->length;
 
   return ret;
 }
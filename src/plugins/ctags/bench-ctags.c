@@ -0,0 +1,154 @@
+/* bench-ctags.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <gio/gio.h>
+
+#include "ide-ctags-index.h"
+
+#include "tests/bench-util.h"
+
+typedef struct
+{
+  GFile         *file;
+  GPtrArray     *identifiers;
+  IdeCtagsIndex *index;
+} Corpus;
+
+static void
+init_cb (GObject      *object,
+         GAsyncResult *result,
+         gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+  gboolean *done = user_data;
+
+  g_async_initable_init_finish (G_ASYNC_INITABLE (object), result, &error);
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static IdeCtagsIndex *
+load_index (GFile *file)
+{
+  IdeCtagsIndex *index = ide_ctags_index_new (file, NULL, 0);
+  gboolean done = FALSE;
+
+  g_async_initable_init_async (G_ASYNC_INITABLE (index),
+                               G_PRIORITY_DEFAULT,
+                               NULL,
+                               init_cb,
+                               &done);
+  bench_wait (&done);
+
+  return index;
+}
+
+static void
+load (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdeCtagsIndex) index = load_index (corpus->file);
+}
+
+static void
+lookup (gpointer data)
+{
+  Corpus *corpus = data;
+
+  for (guint i = 0; i < corpus->identifiers->len; i++)
+    {
+      const char *name = g_ptr_array_index (corpus->identifiers, i);
+      gsize n_entries;
+
+      ide_ctags_index_lookup (corpus->index, name, &n_entries);
+    }
+}
+
+static int
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+  return strcmp (*(const char * const *)a, *(const char * const *)b);
+}
+
+/* Writes @identifiers in the format produced by `ctags -f`, sorted as
+ * ctags would so that the index sees realistic input.
+ */
+static GFile *
+write_tags (GPtrArray *identifiers)
+{
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GPtrArray) sorted = g_ptr_array_copy (identifiers, NULL, NULL);
+  g_autoptr(GString) str = g_string_new (NULL);
+  g_autoptr(GError) error = NULL;
+  GFile *file;
+
+  g_ptr_array_sort (sorted, compare_strings);
+
+  for (guint i = 0; i < sorted->len; i++)
+    g_string_append_printf (str, "%s\tsrc/file-%u.c\t/^%s (void)$/;\"\tf\n",
+                            (const char *)g_ptr_array_index (sorted, i), i % 97,
+                            (const char *)g_ptr_array_index (sorted, i));
+
+  file = g_file_new_tmp ("bench-ctags-XXXXXX", &stream, &error);
+  g_assert_no_error (error);
+
+  g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (stream)),
+                             str->str, str->len, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  g_io_stream_close (G_IO_STREAM (stream), NULL, &error);
+  g_assert_no_error (error);
+
+  return file;
+}
+
+static void
+bench_corpus (const char *name,
+              GPtrArray  *identifiers)
+{
+  g_autoptr(GFile) file = write_tags (identifiers);
+  Corpus corpus = { file, identifiers };
+
+  bench_run ("ctags-index-load", name, identifiers->len, load, &corpus);
+
+  corpus.index = load_index (file);
+  bench_run ("ctags-index-lookup", name, identifiers->len, lookup, &corpus);
+  g_clear_object (&corpus.index);
+
+  g_file_delete (file, NULL, NULL);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GPtrArray) synthetic = bench_synthetic_identifiers (100000);
+  g_autoptr(GPtrArray) recorded = bench_recorded_identifiers ();
+
+  bench_begin ("ctags");
+  bench_corpus ("synthetic", synthetic);
+  if (recorded->len > 0)
+    bench_corpus ("recorded", recorded);
+  bench_end ();
+
+  return EXIT_SUCCESS;
+}
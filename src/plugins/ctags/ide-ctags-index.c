@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "ide-ctags-index.h"
+#include "ide-text-scan-private.h"
 
 /* This object is meant to be immutable after loading so that
  * it can be used from threads safely.
@@ -102,11 +103,12 @@ ide_ctags_index_entry_compare (gconstpointer a,
 }
 
 static inline gchar *
-forward_to_tab (gchar *iter)
+forward_to_tab (gchar       *iter,
+                const gchar *end)
 {
-  while (*iter && g_utf8_get_char (iter) != '\t')
-    iter = g_utf8_next_char (iter);
-  return *iter ? iter : NULL;
+  /* A tab can never be part of a multi-byte UTF-8 sequence */
+  iter = (gchar *)_ide_text_find_byte2 (iter, end - iter, '\t', '\0');
+  return iter && *iter ? iter : NULL;
 }
 
 static inline gchar *
@@ -124,8 +126,10 @@ forward_to_nontab_and_zero (gchar *iter)
 
 static gboolean
 ide_ctags_index_parse_line (gchar              *line,
+                            gsize               line_length,
                             IdeCtagsIndexEntry *entry)
 {
+  const gchar *end = line + line_length;
   gchar *iter = line;
 
   g_assert (line != NULL);
@@ -134,19 +138,19 @@ ide_ctags_index_parse_line (gchar              *line,
   memset (entry, 0, sizeof *entry);
 
   entry->name = iter;
-  if (!(iter = forward_to_tab (iter)))
+  if (!(iter = forward_to_tab (iter, end)))
     return FALSE;
   if (!(iter = forward_to_nontab_and_zero (iter)))
     return FALSE;
 
   entry->path = iter;
-  if (!(iter = forward_to_tab (iter)))
+  if (!(iter = forward_to_tab (iter, end)))
     return FALSE;
   if (!(iter = forward_to_nontab_and_zero (iter)))
     return FALSE;
 
   entry->pattern = iter;
-  if (!(iter = forward_to_tab (iter)))
+  if (!(iter = forward_to_tab (iter, end)))
     return FALSE;
   if (!(iter = forward_to_nontab_and_zero (iter)))
     return FALSE;
@@ -175,7 +179,7 @@ ide_ctags_index_parse_line (gchar              *line,
     }
 
   /* Store a pointer to the beginning of the key/val pairs */
-  if (NULL != (iter = forward_to_tab (iter)))
+  if (NULL != (iter = forward_to_tab (iter, end)))
     entry->keyval = iter;
   else
     entry->keyval = NULL;
@@ -233,7 +237,7 @@ ide_ctags_index_build_index (IdeTask      *task,
        * We could potentially avoid the sort later if we know the tags
        * file was sorted on creation.
        */
-      if (ide_ctags_index_parse_line (line, &entry))
+      if (ide_ctags_index_parse_line (line, line_length, &entry))
         g_array_append_val (index, entry);
     }
 
@@ -24,6 +24,8 @@
 #include <gtksourceview/gtksource.h>
 
 #include <libide-code.h>
+#include <libide-foundry.h>
+#include <libide-gui.h>
 #include <libide-vcs.h>
 
 #include "ide-ctags-builder.h"
@@ -157,6 +159,17 @@ hide_notification (IdeCtagsService *self)
     }
 }
 
+static IdeIndexRegistry *
+get_index_registry (void)
+{
+  GApplication *app = g_application_get_default ();
+
+  if (IDE_IS_APPLICATION (app))
+    return ide_application_get_index_registry (IDE_APPLICATION (app));
+
+  return NULL;
+}
+
 static void
 ide_ctags_service_build_index_init_cb (GObject      *object,
                                        GAsyncResult *result,
@@ -177,7 +190,21 @@ ide_ctags_service_build_index_init_cb (GObject      *object,
                              G_IO_ERROR_NONE,
                              "tags file is empty");
   else
-    g_task_return_pointer (task, g_object_ref (index), g_object_unref);
+    {
+      IdeIndexRegistry *registry = get_index_registry ();
+      IdeCtagsIndex *shared;
+
+      /* Let other projects using the same tags file reuse this index */
+      if (registry != NULL)
+        shared = ide_index_registry_insert (registry,
+                                            ide_ctags_index_get_file (index),
+                                            ide_ctags_index_get_path_root (index),
+                                            index);
+      else
+        shared = g_object_ref (index);
+
+      g_task_return_pointer (task, shared, g_object_unref);
+    }
 }
 
 static guint64
@@ -255,6 +282,7 @@ ide_ctags_service_build_index_cb (IdeTaskCache  *cache,
   g_autoptr(IdeCtagsIndex) index = NULL;
   GFile *file = (GFile *)key;
   g_autofree gchar *path_root = NULL;
+  IdeIndexRegistry *registry;
 
   IDE_ENTRY;
 
@@ -264,6 +292,15 @@ ide_ctags_service_build_index_cb (IdeTaskCache  *cache,
   g_assert (G_IS_TASK (task));
 
   path_root = resolve_path_root (self, file);
+
+  if ((registry = get_index_registry ()) &&
+      (index = ide_index_registry_lookup (registry, IDE_TYPE_CTAGS_INDEX, file, path_root)))
+    {
+      IDE_TRACE_MSG ("Reusing shared ctags index");
+      g_task_return_pointer (task, g_steal_pointer (&index), g_object_unref);
+      IDE_EXIT;
+    }
+
   index = ide_ctags_index_new (file, path_root, get_file_mtime (file));
 
 #ifdef IDE_ENABLE_TRACE
@@ -504,6 +541,10 @@ ide_ctags_service_do_mine (gpointer data)
   g_autoptr(GTask) task = NULL;
   g_autoptr(GArray) mine_info = NULL;
   g_autoptr(GFile) workdir = NULL;
+  g_autoptr(GFile) prebuilt = NULL;
+  g_autoptr(IdeConfig) config = NULL;
+  IdeIndexRegistry *registry;
+  IdeRuntime *runtime;
   MineInfo info;
 
   IDE_ENTRY;
@@ -538,6 +579,17 @@ ide_ctags_service_do_mine (gpointer data)
       info.recursive = TRUE;
       g_array_append_val (mine_info, info);
 
+      /* mine: $XDG_DATA_DIRS/gnome-builder/indexes/ctags/$runtime_id/ */
+      if ((registry = get_index_registry ()) &&
+          (config = ide_config_manager_ref_current (ide_config_manager_from_context (context))) &&
+          (runtime = ide_config_get_runtime (config)) &&
+          (prebuilt = ide_index_registry_find_prebuilt (registry, "ctags", ide_runtime_get_id (runtime))))
+        {
+          info.path = g_file_get_path (prebuilt);
+          info.recursive = FALSE;
+          g_array_append_val (mine_info, info);
+        }
+
       task = g_task_new (self, NULL, NULL, NULL);
       g_task_set_source_tag (task, ide_ctags_service_do_mine);
       g_task_set_priority (task, G_PRIORITY_LOW + 1000);
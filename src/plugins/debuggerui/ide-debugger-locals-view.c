@@ -139,6 +139,159 @@ string_property_cell_data_func (GtkCellLayout   *cell_layout,
   g_object_set_property (G_OBJECT (cell), "text", &value);
 }
 
+typedef struct
+{
+  IdeDebuggerLocalsView *self;
+  GtkTreeRowReference   *row;
+} ListChildren;
+
+static void
+list_children_free (ListChildren *state)
+{
+  g_clear_object (&state->self);
+  g_clear_pointer (&state->row, gtk_tree_row_reference_free);
+  g_slice_free (ListChildren, state);
+}
+
+static void
+ide_debugger_locals_view_append (IdeDebuggerLocalsView *self,
+                                 GtkTreeIter           *parent,
+                                 IdeDebuggerVariable   *var)
+{
+  GtkTreeIter iter;
+
+  g_assert (IDE_IS_DEBUGGER_LOCALS_VIEW (self));
+  g_assert (parent != NULL);
+  g_assert (IDE_IS_DEBUGGER_VARIABLE (var));
+
+  gtk_tree_store_append (self->tree_store, &iter, parent);
+  gtk_tree_store_set (self->tree_store, &iter, 0, var, -1);
+
+  /* Add a dummy row that we can backfill when the user requests
+   * that the variable is expanded.
+   */
+  if (ide_debugger_variable_get_has_children (var))
+    {
+      GtkTreeIter dummy;
+
+      gtk_tree_store_append (self->tree_store, &dummy, &iter);
+    }
+}
+
+static void
+ide_debugger_locals_view_list_children_cb (GObject      *object,
+                                           GAsyncResult *result,
+                                           gpointer      user_data)
+{
+  IdeDebugger *debugger = (IdeDebugger *)object;
+  ListChildren *state = user_data;
+  g_autoptr(GPtrArray) children = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GtkTreePath) path = NULL;
+  GtkTreeIter iter;
+  GtkTreeIter dummy;
+
+  g_assert (IDE_IS_DEBUGGER (debugger));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (state != NULL);
+  g_assert (IDE_IS_DEBUGGER_LOCALS_VIEW (state->self));
+
+  children = ide_debugger_list_children_finish (debugger, result, &error);
+  IDE_PTR_ARRAY_SET_FREE_FUNC (children, g_object_unref);
+
+  /* The store is cleared when the debugger resumes, or we were disposed */
+  if (state->self->tree_store == NULL ||
+      !gtk_tree_row_reference_valid (state->row))
+    goto cleanup;
+
+  path = gtk_tree_row_reference_get_path (state->row);
+
+  if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (state->self->tree_store), &iter, path))
+    goto cleanup;
+
+  /* Remove the placeholder row */
+  while (gtk_tree_model_iter_children (GTK_TREE_MODEL (state->self->tree_store), &dummy, &iter))
+    gtk_tree_store_remove (state->self->tree_store, &dummy);
+
+  if (children == NULL)
+    {
+      g_debug ("Failed to list children: %s", error->message);
+      goto cleanup;
+    }
+
+  for (guint i = 0; i < children->len; i++)
+    ide_debugger_locals_view_append (state->self, &iter, g_ptr_array_index (children, i));
+
+  gtk_tree_view_expand_row (state->self->tree_view, path, FALSE);
+
+cleanup:
+  list_children_free (state);
+}
+
+static gboolean
+ide_debugger_locals_view_test_expand_row (IdeDebuggerLocalsView *self,
+                                          GtkTreeIter           *iter,
+                                          GtkTreePath           *path,
+                                          GtkTreeView           *tree_view)
+{
+  g_autoptr(IdeDebuggerVariable) var = NULL;
+  g_autoptr(GObject) child_var = NULL;
+  g_autofree gchar *child_text = NULL;
+  GtkTreeModel *model = (GtkTreeModel *)self->tree_store;
+  IdeDebugger *debugger;
+  ListChildren *state;
+  GtkTreeIter dummy;
+
+  g_assert (IDE_IS_DEBUGGER_LOCALS_VIEW (self));
+  g_assert (iter != NULL);
+  g_assert (path != NULL);
+  g_assert (GTK_IS_TREE_VIEW (tree_view));
+
+  gtk_tree_model_get (model, iter, 0, &var, -1);
+
+  if (var == NULL ||
+      !gtk_tree_model_iter_children (model, &dummy, iter) ||
+      !(debugger = ide_debugger_locals_view_get_debugger (self)))
+    return FALSE;
+
+  /* Only the placeholder row has neither a variable nor a label. Once the
+   * request is in flight it shows a label until the children arrive.
+   */
+  gtk_tree_model_get (model, &dummy, 0, &child_var, 1, &child_text, -1);
+  if (child_var != NULL || child_text != NULL)
+    return FALSE;
+
+  gtk_tree_store_set (self->tree_store, &dummy, 1, _("Loading…"), -1);
+
+  state = g_slice_new0 (ListChildren);
+  state->self = g_object_ref (self);
+  state->row = gtk_tree_row_reference_new (model, path);
+
+  ide_debugger_list_children_async (debugger,
+                                    var,
+                                    NULL,
+                                    ide_debugger_locals_view_list_children_cb,
+                                    state);
+
+  return FALSE;
+}
+
+static void
+ide_debugger_locals_view_expand_group (IdeDebuggerLocalsView *self,
+                                       GtkTreeIter           *parent)
+{
+  g_autoptr(GtkTreePath) path = NULL;
+
+  g_assert (IDE_IS_DEBUGGER_LOCALS_VIEW (self));
+  g_assert (parent != NULL);
+
+  /* Only expand the group, variables are expanded (and their children
+   * fetched from the debugger) when requested by the user.
+   */
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (self->tree_store), parent);
+  gtk_tree_view_expand_row (self->tree_view, path, FALSE);
+}
+
 static void
 ide_debugger_locals_view_finalize (GObject *object)
 {
@@ -234,6 +387,11 @@ ide_debugger_locals_view_init (IdeDebuggerLocalsView *self)
                                     G_CALLBACK (ide_debugger_locals_view_stopped),
                                     self);
 
+  g_signal_connect_swapped (self->tree_view,
+                            "test-expand-row",
+                            G_CALLBACK (ide_debugger_locals_view_test_expand_row),
+                            self);
+
   gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (self->variable_column),
                                       GTK_CELL_RENDERER (self->variable_cell),
                                       name_cell_data_func, NULL, NULL);
@@ -312,25 +470,9 @@ ide_debugger_locals_view_load_locals_cb (GObject      *object,
   gtk_tree_store_set (self->tree_store, &parent, 1, _("Locals"), -1);
 
   for (guint i = 0; i < locals->len; i++)
-    {
-      IdeDebuggerVariable *var = g_ptr_array_index (locals, i);
-      GtkTreeIter iter;
+    ide_debugger_locals_view_append (self, &parent, g_ptr_array_index (locals, i));
 
-      gtk_tree_store_append (self->tree_store, &iter, &parent);
-      gtk_tree_store_set (self->tree_store, &iter, 0, var, -1);
-
-      /* Add a deummy row that we can backfill when the user requests
-       * that the variable is expanded.
-       */
-      if (ide_debugger_variable_get_has_children (var))
-        {
-          GtkTreeIter dummy;
-
-          gtk_tree_store_append (self->tree_store, &dummy, &iter);
-        }
-    }
-
-  gtk_tree_view_expand_all (self->tree_view);
+  ide_debugger_locals_view_expand_group (self, &parent);
 
   ide_task_return_boolean (task, TRUE);
 }
@@ -367,23 +509,9 @@ ide_debugger_locals_view_load_params_cb (GObject      *object,
   gtk_tree_store_set (self->tree_store, &parent, 1, _("Parameters"), -1);
 
   for (guint i = 0; i < params->len; i++)
-    {
-      IdeDebuggerVariable *var = g_ptr_array_index (params, i);
-      GtkTreeIter iter;
-
-      gtk_tree_store_append (self->tree_store, &iter, &parent);
-      gtk_tree_store_set (self->tree_store, &iter, 0, var, -1);
+    ide_debugger_locals_view_append (self, &parent, g_ptr_array_index (params, i));
 
-      /* Add a deummy row that we can backfill when the user requests
-       * that the variable is expanded.
-       */
-      if (ide_debugger_variable_get_has_children (var))
-        {
-          GtkTreeIter dummy;
-
-          gtk_tree_store_append (self->tree_store, &dummy, &iter);
-        }
-    }
+  ide_debugger_locals_view_expand_group (self, &parent);
 }
 
 void
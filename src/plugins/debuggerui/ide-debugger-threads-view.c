@@ -29,14 +29,22 @@
 
 #include "ide-debugger-threads-view.h"
 
+/* Frames are fetched in pages so that very deep stacks (such as with
+ * runaway recursion) only cost what is actually scrolled into view.
+ */
+#define FRAMES_PAGE_SIZE 100
+
 struct _IdeDebuggerThreadsView
 {
   AdwBin               parent_instance;
 
   /* Owned references */
   IdeSignalGroup      *debugger_signals;
+  IdeDebuggerThread   *frames_thread;
+  GCancellable        *frames_cancellable;
 
   /* Template References */
+  GtkScrolledWindow   *frames_scroller;
   GtkTreeView         *frames_tree_view;
   GtkTreeView         *thread_groups_tree_view;
   GtkTreeView         *threads_tree_view;
@@ -57,6 +65,9 @@ struct _IdeDebuggerThreadsView
   GtkCellRendererText *location_cell;
   GtkCellRendererText *thread_cell;
   GtkCellRendererText *function_cell;
+
+  guint                loading_frames : 1;
+  guint                frames_complete : 1;
 };
 
 enum {
@@ -75,6 +86,21 @@ G_DEFINE_FINAL_TYPE (IdeDebuggerThreadsView, ide_debugger_threads_view, ADW_TYPE
 static GParamSpec *properties [N_PROPS];
 static guint signals [N_SIGNALS];
 
+static void
+ide_debugger_threads_view_reset_frames (IdeDebuggerThreadsView *self)
+{
+  g_assert (IDE_IS_DEBUGGER_THREADS_VIEW (self));
+
+  g_cancellable_cancel (self->frames_cancellable);
+  g_clear_object (&self->frames_cancellable);
+  g_clear_object (&self->frames_thread);
+
+  self->loading_frames = FALSE;
+  self->frames_complete = FALSE;
+
+  gtk_list_store_clear (self->frames_store);
+}
+
 static IdeDebuggerThread *
 ide_debugger_threads_view_get_current_thread (IdeDebuggerThreadsView *self)
 {
@@ -101,7 +127,7 @@ ide_debugger_threads_view_running (IdeDebuggerThreadsView *self,
   g_assert (IDE_IS_DEBUGGER_THREADS_VIEW (self));
   g_assert (IDE_IS_DEBUGGER (debugger));
 
-  gtk_list_store_clear (self->frames_store);
+  ide_debugger_threads_view_reset_frames (self);
 
   gtk_widget_set_sensitive (GTK_WIDGET (self->frames_tree_view), FALSE);
   gtk_widget_set_sensitive (GTK_WIDGET (self->thread_groups_tree_view), FALSE);
@@ -275,21 +301,36 @@ ide_debugger_threads_view_list_frames_cb (GObject      *object,
   g_autoptr(GError) error = NULL;
   GtkTreeSelection *selection;
   GtkTreeIter iter;
+  gboolean was_empty;
 
   g_assert (IDE_IS_DEBUGGER (debugger));
   g_assert (IDE_IS_DEBUGGER_THREADS_VIEW (self));
   g_assert (G_IS_ASYNC_RESULT (result));
 
-  frames = ide_debugger_list_frames_finish (debugger, result, &error);
+  frames = ide_debugger_list_frames_range_finish (debugger, result, &error);
   IDE_PTR_ARRAY_SET_FREE_FUNC (frames, g_object_unref);
 
+  /* A newer request replaced this one */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self->loading_frames = FALSE;
+
+  was_empty = !gtk_tree_model_get_iter_first (GTK_TREE_MODEL (self->frames_store), &iter);
+
+  /* Requesting a page past the end of the stack is an error with some
+   * backends, so only warn when we failed to get any frames at all.
+   */
   if (frames == NULL)
     {
-      g_warning ("%s", error->message);
+      self->frames_complete = TRUE;
+      if (was_empty)
+        g_warning ("%s", error->message);
       return;
     }
 
-  gtk_list_store_clear (self->frames_store);
+  if (frames->len < FRAMES_PAGE_SIZE)
+    self->frames_complete = TRUE;
 
   for (guint i = 0; i < frames->len; i++)
     {
@@ -301,7 +342,8 @@ ide_debugger_threads_view_list_frames_cb (GObject      *object,
       gtk_list_store_set (self->frames_store, &iter, 0, frame, -1);
     }
 
-  if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (self->frames_store), &iter))
+  if (was_empty &&
+      gtk_tree_model_get_iter_first (GTK_TREE_MODEL (self->frames_store), &iter))
     {
       GtkTreePath *path;
 
@@ -314,6 +356,52 @@ ide_debugger_threads_view_list_frames_cb (GObject      *object,
     }
 }
 
+static void
+ide_debugger_threads_view_load_frames (IdeDebuggerThreadsView *self)
+{
+  IdeDebugger *debugger;
+  guint n_frames;
+
+  g_assert (IDE_IS_DEBUGGER_THREADS_VIEW (self));
+
+  if (self->loading_frames ||
+      self->frames_complete ||
+      self->frames_thread == NULL ||
+      !(debugger = ide_signal_group_get_target (self->debugger_signals)))
+    return;
+
+  n_frames = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (self->frames_store), NULL);
+
+  self->loading_frames = TRUE;
+
+  if (self->frames_cancellable == NULL)
+    self->frames_cancellable = g_cancellable_new ();
+
+  ide_debugger_list_frames_range_async (debugger,
+                                        self->frames_thread,
+                                        n_frames,
+                                        FRAMES_PAGE_SIZE,
+                                        self->frames_cancellable,
+                                        ide_debugger_threads_view_list_frames_cb,
+                                        g_object_ref (self));
+}
+
+static void
+ide_debugger_threads_view_frames_scrolled (IdeDebuggerThreadsView *self,
+                                           GtkAdjustment          *vadj)
+{
+  double page_size;
+
+  g_assert (IDE_IS_DEBUGGER_THREADS_VIEW (self));
+  g_assert (GTK_IS_ADJUSTMENT (vadj));
+
+  /* Fetch the next page once the user is within a page of the end */
+  page_size = gtk_adjustment_get_page_size (vadj);
+
+  if (gtk_adjustment_get_value (vadj) + (page_size * 2) >= gtk_adjustment_get_upper (vadj))
+    ide_debugger_threads_view_load_frames (self);
+}
+
 static void
 ide_debugger_threads_view_bind (IdeDebuggerThreadsView *self,
                                 IdeDebugger            *debugger,
@@ -363,7 +451,8 @@ ide_debugger_threads_view_unbind (IdeDebuggerThreadsView *self,
 
   gtk_list_store_clear (self->thread_groups_store);
   gtk_list_store_clear (self->threads_store);
-  gtk_list_store_clear (self->frames_store);
+
+  ide_debugger_threads_view_reset_frames (self);
 }
 
 static void
@@ -573,11 +662,9 @@ ide_debugger_threads_view_threads_row_activated (IdeDebuggerThreadsView *self,
 
       if (thread != NULL)
         {
-          ide_debugger_list_frames_async (debugger,
-                                          thread,
-                                          NULL,
-                                          ide_debugger_threads_view_list_frames_cb,
-                                          g_object_ref (self));
+          ide_debugger_threads_view_reset_frames (self);
+          self->frames_thread = g_steal_pointer (&thread);
+          ide_debugger_threads_view_load_frames (self);
         }
     }
 }
@@ -620,6 +707,9 @@ ide_debugger_threads_view_dispose (GObject *object)
 {
   IdeDebuggerThreadsView *self = (IdeDebuggerThreadsView *)object;
 
+  g_cancellable_cancel (self->frames_cancellable);
+  g_clear_object (&self->frames_cancellable);
+  g_clear_object (&self->frames_thread);
   g_clear_object (&self->debugger_signals);
 
   G_OBJECT_CLASS (ide_debugger_threads_view_parent_class)->dispose (object);
@@ -696,6 +786,7 @@ ide_debugger_threads_view_class_init (IdeDebuggerThreadsViewClass *klass)
   gtk_widget_class_bind_template_child (widget_class, IdeDebuggerThreadsView, binary_column);
   gtk_widget_class_bind_template_child (widget_class, IdeDebuggerThreadsView, depth_cell);
   gtk_widget_class_bind_template_child (widget_class, IdeDebuggerThreadsView, depth_column);
+  gtk_widget_class_bind_template_child (widget_class, IdeDebuggerThreadsView, frames_scroller);
   gtk_widget_class_bind_template_child (widget_class, IdeDebuggerThreadsView, frames_store);
   gtk_widget_class_bind_template_child (widget_class, IdeDebuggerThreadsView, frames_tree_view);
   gtk_widget_class_bind_template_child (widget_class, IdeDebuggerThreadsView, function_cell);
@@ -800,6 +891,12 @@ ide_debugger_threads_view_init (IdeDebuggerThreadsView *self)
                             "row-activated",
                             G_CALLBACK (ide_debugger_threads_view_frames_row_activated),
                             self);
+
+  g_signal_connect_object (gtk_scrolled_window_get_vadjustment (self->frames_scroller),
+                           "value-changed",
+                           G_CALLBACK (ide_debugger_threads_view_frames_scrolled),
+                           self,
+                           G_CONNECT_SWAPPED);
 }
 
 /**
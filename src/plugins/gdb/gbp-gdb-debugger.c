@@ -33,9 +33,15 @@
 #include <libide-terminal.h>
 
 #include "gbp-gdb-debugger.h"
+#include "gbp-gdb-variable.h"
 
 #define READ_BUFFER_LEN 4096
 
+/* Upper bound on the number of children we request for a single variable
+ * object so that expanding a huge array does not stall the debugger.
+ */
+#define MAX_CHILDREN 1000
+
 struct _GbpGdbDebugger
 {
   IdeDebugger               parent_instance;
@@ -47,6 +53,12 @@ struct _GbpGdbDebugger
   GFile                    *builddir;
   IdeConfig                *current_config;
 
+  /* Variable object name (such as "var1.field") to GbpGdbVariable */
+  GHashTable               *varobjs;
+
+  /* Frame activation key to root GbpGdbVariable with a variable object */
+  GHashTable               *frame_variables;
+
   struct gdbwire_mi_parser *parser;
 
   GQueue                    writequeue;
@@ -565,6 +577,230 @@ gbp_gdb_debugger_handle_breakpoint (GbpGdbDebugger              *self,
     }
 }
 
+static void
+gbp_gdb_debugger_clear_variable (GbpGdbVariable *variable)
+{
+  GPtrArray *children;
+
+  g_assert (GBP_IS_GDB_VARIABLE (variable));
+
+  if ((children = gbp_gdb_variable_get_children (variable)))
+    {
+      for (guint i = 0; i < children->len; i++)
+        gbp_gdb_debugger_clear_variable (g_ptr_array_index (children, i));
+    }
+
+  gbp_gdb_variable_set_varobj (variable, NULL);
+  gbp_gdb_variable_set_children (variable, NULL);
+}
+
+static gboolean
+remove_varobj_and_children (gpointer key,
+                            gpointer value,
+                            gpointer user_data)
+{
+  const char *varobj = key;
+  const char *prefix = user_data;
+  gsize len = strlen (prefix);
+
+  return strncmp (varobj, prefix, len) == 0 &&
+         (varobj[len] == 0 || varobj[len] == '.');
+}
+
+static gboolean
+remove_variable (gpointer key,
+                 gpointer value,
+                 gpointer user_data)
+{
+  return value == user_data;
+}
+
+static void
+gbp_gdb_debugger_forget_variable (GbpGdbDebugger *self,
+                                  GbpGdbVariable *variable)
+{
+  g_autoptr(GbpGdbVariable) hold = NULL;
+  const char *varobj;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (GBP_IS_GDB_VARIABLE (variable));
+
+  hold = g_object_ref (variable);
+
+  if ((varobj = gbp_gdb_variable_get_varobj (variable)))
+    g_hash_table_foreach_remove (self->varobjs,
+                                 remove_varobj_and_children,
+                                 (gpointer)varobj);
+
+  g_hash_table_foreach_remove (self->frame_variables, remove_variable, variable);
+
+  gbp_gdb_debugger_clear_variable (variable);
+}
+
+static void
+gbp_gdb_debugger_forget_children (GbpGdbDebugger *self,
+                                  GbpGdbVariable *variable)
+{
+  g_autoptr(GPtrArray) children = NULL;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (GBP_IS_GDB_VARIABLE (variable));
+
+  if (!(children = gbp_gdb_variable_get_children (variable)))
+    return;
+
+  g_ptr_array_ref (children);
+  gbp_gdb_variable_set_children (variable, NULL);
+
+  for (guint i = 0; i < children->len; i++)
+    gbp_gdb_debugger_forget_variable (self, g_ptr_array_index (children, i));
+}
+
+static void
+gbp_gdb_debugger_forget_variables (GbpGdbDebugger *self)
+{
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+
+  g_hash_table_remove_all (self->frame_variables);
+  g_hash_table_remove_all (self->varobjs);
+}
+
+static void
+gbp_gdb_debugger_handle_varobj_change (GbpGdbDebugger                 *self,
+                                       const struct gdbwire_mi_result *result)
+{
+  const struct gdbwire_mi_result *iter;
+  GbpGdbVariable *variable;
+  const char *name = NULL;
+  const char *value = NULL;
+  const char *in_scope = NULL;
+  const char *type_changed = NULL;
+  const char *new_type = NULL;
+  const char *new_num_children = NULL;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+
+  for (iter = result; iter != NULL; iter = iter->next)
+    {
+      if (iter->kind == GDBWIRE_MI_CSTRING)
+        {
+          if (g_strcmp0 (iter->variable, "name") == 0)
+            name = iter->variant.cstring;
+          else if (g_strcmp0 (iter->variable, "value") == 0)
+            value = iter->variant.cstring;
+          else if (g_strcmp0 (iter->variable, "in_scope") == 0)
+            in_scope = iter->variant.cstring;
+          else if (g_strcmp0 (iter->variable, "type_changed") == 0)
+            type_changed = iter->variant.cstring;
+          else if (g_strcmp0 (iter->variable, "new_type") == 0)
+            new_type = iter->variant.cstring;
+          else if (g_strcmp0 (iter->variable, "new_num_children") == 0)
+            new_num_children = iter->variant.cstring;
+        }
+    }
+
+  if (name == NULL || !(variable = g_hash_table_lookup (self->varobjs, name)))
+    return;
+
+  /* The frame is gone (or the variable object can no longer be evaluated)
+   * so release it in gdb too. Deleting a root also deletes its children.
+   */
+  if (g_strcmp0 (in_scope, "true") != 0)
+    {
+      if (strchr (name, '.') == NULL)
+        {
+          g_autofree char *command = g_strdup_printf ("-var-delete %s", name);
+          gbp_gdb_debugger_exec_async (self, command, NULL, NULL, NULL);
+        }
+
+      gbp_gdb_debugger_forget_variable (self, variable);
+
+      return;
+    }
+
+  if (value != NULL)
+    ide_debugger_variable_set_value (IDE_DEBUGGER_VARIABLE (variable), value);
+
+  if (new_type != NULL)
+    ide_debugger_variable_set_type_name (IDE_DEBUGGER_VARIABLE (variable), new_type);
+
+  /* gdb drops the children when the type changes, so they must be
+   * fetched again the next time the variable is expanded.
+   */
+  if (g_strcmp0 (type_changed, "true") == 0 || new_num_children != NULL)
+    gbp_gdb_debugger_forget_children (self, variable);
+
+  if (new_num_children != NULL)
+    ide_debugger_variable_set_has_children (IDE_DEBUGGER_VARIABLE (variable),
+                                            g_ascii_strtoll (new_num_children, NULL, 10) > 0);
+}
+
+static void
+gbp_gdb_debugger_update_variables_cb (GObject      *object,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)object;
+  g_autoptr(GError) error = NULL;
+  struct gdbwire_mi_output *output;
+  const struct gdbwire_mi_result *res;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+
+  output = gbp_gdb_debugger_exec_finish (self, result, &error);
+
+  if (output == NULL || gbp_gdb_debugger_unwrap (output, &error))
+    {
+      g_debug ("Failed to update variable objects: %s", error->message);
+      goto cleanup;
+    }
+
+  /*
+   * Example:
+   *
+   * ^done,changelist=[{name="var1",value="3",in_scope="true",
+   *                    type_changed="false",has_more="0"}]
+   */
+
+  for (res = output->variant.result_record->result; res != NULL; res = res->next)
+    {
+      if (res->kind == GDBWIRE_MI_LIST &&
+          g_strcmp0 (res->variable, "changelist") == 0)
+        {
+          const struct gdbwire_mi_result *liter;
+
+          for (liter = res->variant.result; liter != NULL; liter = liter->next)
+            {
+              if (liter->kind == GDBWIRE_MI_TUPLE)
+                gbp_gdb_debugger_handle_varobj_change (self, liter->variant.result);
+            }
+        }
+    }
+
+cleanup:
+  g_clear_pointer (&output, gdbwire_mi_output_free);
+}
+
+static void
+gbp_gdb_debugger_update_variables (GbpGdbDebugger *self)
+{
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+
+  /* Only variable objects the user has expanded exist, so this is a no-op
+   * until something is expanded. Otherwise, gdb will only report the values
+   * which have changed since the previous stop.
+   */
+  if (g_hash_table_size (self->varobjs) == 0)
+    return;
+
+  gbp_gdb_debugger_exec_async (self,
+                               "-var-update --all-values *",
+                               NULL,
+                               gbp_gdb_debugger_update_variables_cb,
+                               NULL);
+}
+
 static void
 gbp_gdb_debugger_handle_stopped (GbpGdbDebugger                 *self,
                                  struct gdbwire_mi_output       *output,
@@ -697,6 +933,16 @@ gbp_gdb_debugger_handle_stopped (GbpGdbDebugger                 *self,
   thread = ide_debugger_thread_new (thread_id);
   ide_debugger_thread_set_group (thread, group_id);
 
+  /* Queue the variable object update before notifying the UI so that it is
+   * processed by gdb before any request to list locals for the new stop.
+   */
+  if (stop_reason == IDE_DEBUGGER_STOP_EXITED_SIGNALED ||
+      stop_reason == IDE_DEBUGGER_STOP_EXITED_NORMALLY ||
+      stop_reason == IDE_DEBUGGER_STOP_EXITED)
+    gbp_gdb_debugger_forget_variables (self);
+  else
+    gbp_gdb_debugger_update_variables (self);
+
   ide_debugger_emit_thread_selected (IDE_DEBUGGER (self), thread);
   ide_debugger_emit_stopped (IDE_DEBUGGER (self), stop_reason, breakpoint);
 
@@ -1724,6 +1970,58 @@ gbp_gdb_debugger_list_frames_finish (IdeDebugger   *debugger,
   return IDE_PTR_ARRAY_STEAL_FULL (&ret);
 }
 
+static void
+gbp_gdb_debugger_list_frames_range_async (IdeDebugger         *debugger,
+                                          IdeDebuggerThread   *thread,
+                                          guint                first,
+                                          guint                n_frames,
+                                          GCancellable        *cancellable,
+                                          GAsyncReadyCallback  callback,
+                                          gpointer             user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)debugger;
+  g_autoptr(IdeTask) task = NULL;
+  g_autofree gchar *command = NULL;
+  const gchar *tid = NULL;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (IDE_IS_DEBUGGER_THREAD (thread));
+  g_assert (n_frames > 0);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_priority (task, G_PRIORITY_LOW);
+  ide_task_set_source_tag (task, gbp_gdb_debugger_list_frames_range_async);
+
+  /* The frame range is inclusive, and gdb only unwinds as far as it needs
+   * to satisfy the request which is what makes deep stacks cheap.
+   */
+  tid = ide_debugger_thread_get_id (thread);
+  command = g_strdup_printf ("-stack-list-frames --thread %s %u %u",
+                             tid, first, first + n_frames - 1);
+
+  gbp_gdb_debugger_exec_async (self,
+                               command,
+                               cancellable,
+                               gbp_gdb_debugger_list_frames_cb,
+                               g_steal_pointer (&task));
+}
+
+static GPtrArray *
+gbp_gdb_debugger_list_frames_range_finish (IdeDebugger   *debugger,
+                                           GAsyncResult  *result,
+                                           GError       **error)
+{
+  GPtrArray *ret;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (debugger));
+  g_assert (IDE_IS_TASK (result));
+
+  ret = ide_task_propagate_pointer (IDE_TASK (result), error);
+
+  return IDE_PTR_ARRAY_STEAL_FULL (&ret);
+}
+
 static void
 gbp_gdb_debugger_interrupt_cb (GObject      *object,
                                GAsyncResult *result,
@@ -1940,11 +2238,30 @@ gbp_gdb_debugger_modify_breakpoint_finish (IdeDebugger   *debugger,
   return ide_task_propagate_boolean (IDE_TASK (result), error);
 }
 
+typedef struct
+{
+  gchar    *thread_id;
+  gchar    *function;
+  gchar    *frame_sp;
+  guint     depth;
+  gboolean  arguments;
+} ListVariables;
+
+static void
+list_variables_free (gpointer data)
+{
+  ListVariables *state = data;
+
+  g_clear_pointer (&state->thread_id, g_free);
+  g_clear_pointer (&state->function, g_free);
+  g_clear_pointer (&state->frame_sp, g_free);
+  g_slice_free (ListVariables, state);
+}
+
 static void
 gbp_gdb_debugger_handle_list_variables (GObject      *object,
                                         GAsyncResult *result,
-                                        gpointer      user_data,
-                                        gboolean      arguments)
+                                        gpointer      user_data)
 {
   GbpGdbDebugger *self = (GbpGdbDebugger *)object;
   g_autoptr(GError) error = NULL;
@@ -1952,6 +2269,7 @@ gbp_gdb_debugger_handle_list_variables (GObject      *object,
   g_autoptr(IdeTask) task = user_data;
   struct gdbwire_mi_output *output;
   struct gdbwire_mi_result *res;
+  ListVariables *state;
 
   g_assert (GBP_IS_GDB_DEBUGGER (self));
   g_assert (G_IS_ASYNC_RESULT (result));
@@ -1965,6 +2283,7 @@ gbp_gdb_debugger_handle_list_variables (GObject      *object,
       goto cleanup;
     }
 
+  state = ide_task_get_task_data (task);
   ar = g_ptr_array_new_with_free_func (g_object_unref);
 
   /* Decode variables */
@@ -1981,8 +2300,10 @@ gbp_gdb_debugger_handle_list_variables (GObject      *object,
           if (iter->kind == GDBWIRE_MI_TUPLE)
             {
               struct gdbwire_mi_result *titer;
-              g_autoptr(IdeDebuggerVariable) var = NULL;
-              G_GNUC_UNUSED const gchar *value = NULL;
+              g_autoptr(GbpGdbVariable) var = NULL;
+              g_autofree gchar *key = NULL;
+              GbpGdbVariable *cached;
+              const gchar *value = NULL;
               const gchar *type = NULL;
               const gchar *name = NULL;
               gboolean is_arg = FALSE;
@@ -2002,16 +2323,42 @@ gbp_gdb_debugger_handle_list_variables (GObject      *object,
                     }
                 }
 
-              if ((name == NULL) || (arguments != is_arg))
+              if ((name == NULL) || (state->arguments != is_arg))
                 continue;
 
-              var = ide_debugger_variable_new (name);
-              ide_debugger_variable_set_type_name (var, type);
-              ide_debugger_variable_set_value (var, value);
+              /* The stack pointer identifies this activation of the frame
+               * so that we never confuse it with another call to the same
+               * function at the same depth (such as with recursion).
+               */
+              if (state->frame_sp != NULL)
+                key = g_strdup_printf ("%s:%u:%s:%s:%s",
+                                       state->thread_id,
+                                       state->depth,
+                                       state->function ? state->function : "",
+                                       state->frame_sp,
+                                       name);
+
+              /* If the user expanded this variable during a previous stop
+               * we already have a variable object for it which has been
+               * refreshed with -var-update, including any children.
+               */
+              if (key != NULL &&
+                  (cached = g_hash_table_lookup (self->frame_variables, key)))
+                {
+                  g_ptr_array_add (ar, g_object_ref (cached));
+                  continue;
+                }
+
+              var = gbp_gdb_variable_new (name);
+              gbp_gdb_variable_set_frame (var, state->thread_id, state->depth);
+              gbp_gdb_variable_set_key (var, key);
+              ide_debugger_variable_set_type_name (IDE_DEBUGGER_VARIABLE (var), type);
+              ide_debugger_variable_set_value (IDE_DEBUGGER_VARIABLE (var), value);
 
-              /* TODO: We really need to create frozen variables for this
-               *       so that we can get the updated value.
+              /* --simple-values omits the value for arrays, structures and
+               * unions. Those are expanded on demand with a variable object.
                */
+              ide_debugger_variable_set_has_children (IDE_DEBUGGER_VARIABLE (var), value == NULL);
 
               g_ptr_array_add (ar, g_steal_pointer (&var));
             }
@@ -2025,11 +2372,85 @@ cleanup:
 }
 
 static void
-gbp_gdb_debugger_list_locals_cb (GObject      *object,
-                                 GAsyncResult *result,
-                                 gpointer      user_data)
+gbp_gdb_debugger_list_variables_sp_cb (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)object;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *command = NULL;
+  struct gdbwire_mi_output *output;
+  ListVariables *state;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  state = ide_task_get_task_data (task);
+
+  /* Failing to get the stack pointer only means we cannot reuse variable
+   * objects from a previous stop, so it is not fatal.
+   */
+  output = gbp_gdb_debugger_exec_finish (self, result, &error);
+
+  if (output != NULL && !gbp_gdb_debugger_unwrap (output, &error))
+    {
+      const struct gdbwire_mi_result *res = output->variant.result_record->result;
+
+      if (res != NULL &&
+          res->kind == GDBWIRE_MI_CSTRING &&
+          g_strcmp0 (res->variable, "value") == 0)
+        state->frame_sp = g_strdup (res->variant.cstring);
+    }
+  else
+    g_debug ("Failed to locate frame stack pointer: %s", error->message);
+
+  g_clear_pointer (&output, gdbwire_mi_output_free);
+
+  if (ide_task_return_error_if_cancelled (task))
+    return;
+
+  command = g_strdup_printf ("-stack-list-variables --thread %s --frame %u --simple-values",
+                             state->thread_id, state->depth);
+
+  gbp_gdb_debugger_exec_async (self,
+                               command,
+                               ide_task_get_cancellable (task),
+                               gbp_gdb_debugger_handle_list_variables,
+                               g_steal_pointer (&task));
+}
+
+static void
+gbp_gdb_debugger_list_variables (GbpGdbDebugger    *self,
+                                 IdeTask           *task,
+                                 IdeDebuggerThread *thread,
+                                 IdeDebuggerFrame  *frame,
+                                 gboolean           arguments)
 {
-  gbp_gdb_debugger_handle_list_variables (object, result, user_data, FALSE);
+  g_autofree gchar *command = NULL;
+  ListVariables *state;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (IDE_IS_TASK (task));
+  g_assert (IDE_IS_DEBUGGER_THREAD (thread));
+  g_assert (IDE_IS_DEBUGGER_FRAME (frame));
+
+  state = g_slice_new0 (ListVariables);
+  state->thread_id = g_strdup (ide_debugger_thread_get_id (thread));
+  state->function = g_strdup (ide_debugger_frame_get_function (frame));
+  state->depth = ide_debugger_frame_get_depth (frame);
+  state->arguments = !!arguments;
+  ide_task_set_task_data (task, state, list_variables_free);
+
+  command = g_strdup_printf ("-data-evaluate-expression --thread %s --frame %u $sp",
+                             state->thread_id, state->depth);
+
+  gbp_gdb_debugger_exec_async (self,
+                               command,
+                               ide_task_get_cancellable (task),
+                               gbp_gdb_debugger_list_variables_sp_cb,
+                               g_object_ref (task));
 }
 
 static void
@@ -2042,9 +2463,6 @@ gbp_gdb_debugger_list_locals_async (IdeDebugger         *debugger,
 {
   GbpGdbDebugger *self = (GbpGdbDebugger *)debugger;
   g_autoptr(IdeTask) task = NULL;
-  g_autofree gchar *command = NULL;
-  const gchar *tid = NULL;
-  guint depth;
 
   g_assert (GBP_IS_GDB_DEBUGGER (self));
   g_assert (IDE_IS_DEBUGGER_THREAD (thread));
@@ -2055,16 +2473,7 @@ gbp_gdb_debugger_list_locals_async (IdeDebugger         *debugger,
   ide_task_set_priority (task, G_PRIORITY_LOW);
   ide_task_set_source_tag (task, gbp_gdb_debugger_list_locals_async);
 
-  tid = ide_debugger_thread_get_id (thread);
-  depth = ide_debugger_frame_get_depth (frame);
-  command = g_strdup_printf ("-stack-list-variables --thread %s --frame %u --simple-values",
-                             tid, depth);
-
-  gbp_gdb_debugger_exec_async (self,
-                               command,
-                               cancellable,
-                               gbp_gdb_debugger_list_locals_cb,
-                               g_steal_pointer (&task));
+  gbp_gdb_debugger_list_variables (self, task, thread, frame, FALSE);
 }
 
 static GPtrArray *
@@ -2082,14 +2491,6 @@ gbp_gdb_debugger_list_locals_finish (IdeDebugger   *debugger,
   return IDE_PTR_ARRAY_STEAL_FULL (&ret);
 }
 
-static void
-gbp_gdb_debugger_list_params_cb (GObject      *object,
-                                 GAsyncResult *result,
-                                 gpointer      user_data)
-{
-  gbp_gdb_debugger_handle_list_variables (object, result, user_data, TRUE);
-}
-
 static void
 gbp_gdb_debugger_list_params_async (IdeDebugger         *debugger,
                                     IdeDebuggerThread   *thread,
@@ -2100,9 +2501,6 @@ gbp_gdb_debugger_list_params_async (IdeDebugger         *debugger,
 {
   GbpGdbDebugger *self = (GbpGdbDebugger *)debugger;
   g_autoptr(IdeTask) task = NULL;
-  g_autofree gchar *command = NULL;
-  guint depth;
-  const gchar *tid = NULL;
 
   g_assert (GBP_IS_GDB_DEBUGGER (self));
   g_assert (IDE_IS_DEBUGGER_THREAD (thread));
@@ -2113,22 +2511,286 @@ gbp_gdb_debugger_list_params_async (IdeDebugger         *debugger,
   ide_task_set_priority (task, G_PRIORITY_LOW);
   ide_task_set_source_tag (task, gbp_gdb_debugger_list_params_async);
 
-  tid = ide_debugger_thread_get_id (thread);
-  depth = ide_debugger_frame_get_depth (frame);
-  command = g_strdup_printf ("-stack-list-variables --thread %s --frame %u --simple-values",
-                             tid, depth);
+  gbp_gdb_debugger_list_variables (self, task, thread, frame, TRUE);
+}
 
-  gbp_gdb_debugger_exec_async (self,
-                               command,
+static GPtrArray *
+gbp_gdb_debugger_list_params_finish (IdeDebugger   *debugger,
+                                     GAsyncResult  *result,
+                                     GError       **error)
+{
+  GPtrArray *ret;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (debugger));
+  g_assert (IDE_IS_TASK (result));
+
+  ret = ide_task_propagate_pointer (IDE_TASK (result), error);
+
+  return IDE_PTR_ARRAY_STEAL_FULL (&ret);
+}
+
+static GPtrArray *
+copy_children (GPtrArray *children)
+{
+  GPtrArray *ret = g_ptr_array_new_full (children->len, g_object_unref);
+
+  for (guint i = 0; i < children->len; i++)
+    g_ptr_array_add (ret, g_object_ref (g_ptr_array_index (children, i)));
+
+  return ret;
+}
+
+static void
+gbp_gdb_debugger_list_children_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)object;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GPtrArray) children = NULL;
+  g_autoptr(GError) error = NULL;
+  struct gdbwire_mi_output *output;
+  const struct gdbwire_mi_result *res;
+  GbpGdbVariable *variable;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  output = gbp_gdb_debugger_exec_finish (self, result, &error);
+
+  if (output == NULL || gbp_gdb_debugger_unwrap (output, &error))
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      goto cleanup;
+    }
+
+  variable = ide_task_get_task_data (task);
+  children = g_ptr_array_new_with_free_func (g_object_unref);
+
+  /*
+   * Example:
+   *
+   * ^done,numchild="2",children=[child={name="var1.x",exp="x",numchild="0",
+   *      value="1",type="int",thread-id="1"},...],has_more="0"
+   */
+
+  for (res = output->variant.result_record->result; res != NULL; res = res->next)
+    {
+      const struct gdbwire_mi_result *liter;
+
+      if (res->kind != GDBWIRE_MI_LIST || g_strcmp0 (res->variable, "children") != 0)
+        continue;
+
+      for (liter = res->variant.result; liter != NULL; liter = liter->next)
+        {
+          g_autoptr(GbpGdbVariable) child = NULL;
+          const struct gdbwire_mi_result *iter;
+          const gchar *name = NULL;
+          const gchar *exp = NULL;
+          const gchar *type = NULL;
+          const gchar *value = NULL;
+          guint numchild = 0;
+
+          if (liter->kind != GDBWIRE_MI_TUPLE)
+            continue;
+
+          for (iter = liter->variant.result; iter != NULL; iter = iter->next)
+            {
+              if (iter->kind == GDBWIRE_MI_CSTRING)
+                {
+                  if (g_strcmp0 (iter->variable, "name") == 0)
+                    name = iter->variant.cstring;
+                  else if (g_strcmp0 (iter->variable, "exp") == 0)
+                    exp = iter->variant.cstring;
+                  else if (g_strcmp0 (iter->variable, "type") == 0)
+                    type = iter->variant.cstring;
+                  else if (g_strcmp0 (iter->variable, "value") == 0)
+                    value = iter->variant.cstring;
+                  else if (g_strcmp0 (iter->variable, "numchild") == 0)
+                    numchild = g_ascii_strtoll (iter->variant.cstring, NULL, 10);
+                }
+            }
+
+          if (name == NULL || exp == NULL)
+            continue;
+
+          child = gbp_gdb_variable_new (exp);
+          gbp_gdb_variable_set_frame (child,
+                                      gbp_gdb_variable_get_thread_id (variable),
+                                      gbp_gdb_variable_get_depth (variable));
+          gbp_gdb_variable_set_varobj (child, name);
+          ide_debugger_variable_set_type_name (IDE_DEBUGGER_VARIABLE (child), type);
+          ide_debugger_variable_set_value (IDE_DEBUGGER_VARIABLE (child), value);
+          ide_debugger_variable_set_has_children (IDE_DEBUGGER_VARIABLE (child), numchild > 0);
+
+          g_hash_table_insert (self->varobjs, g_strdup (name), g_object_ref (child));
+          g_ptr_array_add (children, g_steal_pointer (&child));
+        }
+    }
+
+  gbp_gdb_variable_set_children (variable, children);
+
+  ide_task_return_pointer (task, copy_children (children), g_ptr_array_unref);
+
+cleanup:
+  g_clear_pointer (&output, gdbwire_mi_output_free);
+}
+
+static void
+gbp_gdb_debugger_list_children (GbpGdbDebugger *self,
+                                IdeTask        *task)
+{
+  g_autofree gchar *command = NULL;
+  GbpGdbVariable *variable;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (IDE_IS_TASK (task));
+
+  variable = ide_task_get_task_data (task);
+
+  g_assert (GBP_IS_GDB_VARIABLE (variable));
+  g_assert (gbp_gdb_variable_get_varobj (variable) != NULL);
+
+  command = g_strdup_printf ("-var-list-children --simple-values %s 0 %u",
+                             gbp_gdb_variable_get_varobj (variable),
+                             MAX_CHILDREN);
+
+  gbp_gdb_debugger_exec_async (self,
+                               command,
+                               ide_task_get_cancellable (task),
+                               gbp_gdb_debugger_list_children_cb,
+                               g_object_ref (task));
+}
+
+static void
+gbp_gdb_debugger_create_varobj_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)object;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  struct gdbwire_mi_output *output;
+  const struct gdbwire_mi_result *res;
+  GbpGdbVariable *variable;
+  const gchar *name = NULL;
+  const gchar *key;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  output = gbp_gdb_debugger_exec_finish (self, result, &error);
+
+  if (output == NULL || gbp_gdb_debugger_unwrap (output, &error))
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      goto cleanup;
+    }
+
+  variable = ide_task_get_task_data (task);
+
+  /*
+   * Example:
+   *
+   * ^done,name="var1",numchild="2",type="struct point",thread-id="1",has_more="0"
+   */
+
+  for (res = output->variant.result_record->result; res != NULL; res = res->next)
+    {
+      if (res->kind == GDBWIRE_MI_CSTRING && g_strcmp0 (res->variable, "name") == 0)
+        name = res->variant.cstring;
+    }
+
+  if (name == NULL)
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_INVALID_DATA,
+                                 "Failed to create variable object");
+      goto cleanup;
+    }
+
+  gbp_gdb_variable_set_varobj (variable, name);
+  g_hash_table_insert (self->varobjs, g_strdup (name), g_object_ref (variable));
+
+  if ((key = gbp_gdb_variable_get_key (variable)))
+    g_hash_table_insert (self->frame_variables, g_strdup (key), g_object_ref (variable));
+
+  if (!ide_task_return_error_if_cancelled (task))
+    gbp_gdb_debugger_list_children (self, task);
+
+cleanup:
+  g_clear_pointer (&output, gdbwire_mi_output_free);
+}
+
+static void
+gbp_gdb_debugger_list_children_async (IdeDebugger         *debugger,
+                                      IdeDebuggerVariable *variable,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)debugger;
+  g_autoptr(IdeTask) task = NULL;
+  g_autofree gchar *command = NULL;
+  g_autofree gchar *escaped = NULL;
+  GbpGdbVariable *var = (GbpGdbVariable *)variable;
+  GPtrArray *children;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (IDE_IS_DEBUGGER_VARIABLE (variable));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_priority (task, G_PRIORITY_LOW);
+  ide_task_set_source_tag (task, gbp_gdb_debugger_list_children_async);
+
+  if (!GBP_IS_GDB_VARIABLE (variable))
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_NOT_SUPPORTED,
+                                 "Variable was not created by this debugger");
+      return;
+    }
+
+  /* Children are kept up to date by -var-update, so reuse them */
+  if ((children = gbp_gdb_variable_get_children (var)))
+    {
+      ide_task_return_pointer (task, copy_children (children), g_ptr_array_unref);
+      return;
+    }
+
+  ide_task_set_task_data (task, g_object_ref (var), g_object_unref);
+
+  if (gbp_gdb_variable_get_varobj (var) != NULL)
+    {
+      gbp_gdb_debugger_list_children (self, task);
+      return;
+    }
+
+  /* This is a root variable that has not been expanded yet. Create a
+   * variable object bound to the frame it was listed from.
+   */
+  escaped = g_strescape (ide_debugger_variable_get_name (variable), NULL);
+  command = g_strdup_printf ("-var-create --thread %s --frame %u - * \"%s\"",
+                             gbp_gdb_variable_get_thread_id (var),
+                             gbp_gdb_variable_get_depth (var),
+                             escaped);
+
+  gbp_gdb_debugger_exec_async (self,
+                               command,
                                cancellable,
-                               gbp_gdb_debugger_list_params_cb,
+                               gbp_gdb_debugger_create_varobj_cb,
                                g_steal_pointer (&task));
 }
 
 static GPtrArray *
-gbp_gdb_debugger_list_params_finish (IdeDebugger   *debugger,
-                                     GAsyncResult  *result,
-                                     GError       **error)
+gbp_gdb_debugger_list_children_finish (IdeDebugger   *debugger,
+                                       GAsyncResult  *result,
+                                       GError       **error)
 {
   GPtrArray *ret;
 
@@ -2369,6 +3031,250 @@ gbp_gdb_debugger_disassemble_finish (IdeDebugger   *debugger,
   return IDE_PTR_ARRAY_STEAL_FULL (&ret);
 }
 
+typedef struct
+{
+  IdeDebuggerAddress address;
+  gsize              length;
+} ReadMemory;
+
+static gboolean
+decode_hex (GByteArray *buffer,
+            const char *hex)
+{
+  for (; hex[0] && hex[1]; hex += 2)
+    {
+      int hi = g_ascii_xdigit_value (hex[0]);
+      int lo = g_ascii_xdigit_value (hex[1]);
+      guint8 byte;
+
+      if (hi < 0 || lo < 0)
+        return FALSE;
+
+      byte = (hi << 4) | lo;
+      g_byte_array_append (buffer, &byte, 1);
+    }
+
+  return hex[0] == 0;
+}
+
+static void
+gbp_gdb_debugger_read_memory_cb (GObject      *object,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)object;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GByteArray) buffer = NULL;
+  struct gdbwire_mi_output *output;
+  IdeDebuggerAddress next;
+  ReadMemory *state;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  output = gbp_gdb_debugger_exec_finish (self, result, &error);
+
+  if (output == NULL || gbp_gdb_debugger_unwrap (output, &error))
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      goto cleanup;
+    }
+
+  state = ide_task_get_task_data (task);
+  buffer = g_byte_array_sized_new (state->length);
+  next = state->address;
+
+  /* gdb replies with one region per readable span, in address order. We
+   * only keep what is contiguous from the requested address so that the
+   * caller can tell where the readable memory ends.
+   */
+  if (output->kind == GDBWIRE_MI_OUTPUT_RESULT &&
+      output->variant.result_record != NULL &&
+      output->variant.result_record->result_class == GDBWIRE_MI_DONE &&
+      output->variant.result_record->result != NULL &&
+      output->variant.result_record->result->kind == GDBWIRE_MI_LIST &&
+      g_strcmp0 (output->variant.result_record->result->variable, "memory") == 0)
+    {
+      const struct gdbwire_mi_result *res = output->variant.result_record->result;
+
+      for (const struct gdbwire_mi_result *liter = res->variant.result; liter; liter = liter->next)
+        {
+          IdeDebuggerAddress begin = 0;
+          IdeDebuggerAddress offset = 0;
+          const char *contents = NULL;
+
+          if (liter->kind != GDBWIRE_MI_TUPLE)
+            continue;
+
+          for (const struct gdbwire_mi_result *titer = liter->variant.result; titer; titer = titer->next)
+            {
+              if (titer->kind != GDBWIRE_MI_CSTRING)
+                continue;
+
+              if (g_strcmp0 (titer->variable, "begin") == 0)
+                begin = ide_debugger_address_parse (titer->variant.cstring);
+              else if (g_strcmp0 (titer->variable, "offset") == 0)
+                offset = ide_debugger_address_parse (titer->variant.cstring);
+              else if (g_strcmp0 (titer->variable, "contents") == 0)
+                contents = titer->variant.cstring;
+            }
+
+          if (contents == NULL || begin + offset != next)
+            break;
+
+          if (!decode_hex (buffer, contents))
+            break;
+
+          next = state->address + buffer->len;
+        }
+    }
+
+  if (buffer->len == 0)
+    ide_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_FAILED,
+                               "Cannot access memory at address 0x%"G_GINT64_MODIFIER"x",
+                               state->address);
+  else
+    ide_task_return_pointer (task,
+                             g_byte_array_free_to_bytes (g_steal_pointer (&buffer)),
+                             g_bytes_unref);
+
+cleanup:
+  g_clear_pointer (&output, gdbwire_mi_output_free);
+}
+
+static void
+gbp_gdb_debugger_read_memory_async (IdeDebugger         *debugger,
+                                    IdeDebuggerAddress   address,
+                                    gsize                length,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)debugger;
+  g_autoptr(IdeTask) task = NULL;
+  g_autofree gchar *command = NULL;
+  ReadMemory *state;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_gdb_debugger_read_memory_async);
+
+  state = g_new0 (ReadMemory, 1);
+  state->address = address;
+  state->length = length;
+  ide_task_set_task_data (task, state, g_free);
+
+  command = g_strdup_printf ("-data-read-memory-bytes "
+                             "0x%"G_GINT64_MODIFIER"x %"G_GSIZE_FORMAT,
+                             address, length);
+
+  gbp_gdb_debugger_exec_async (self,
+                               command,
+                               cancellable,
+                               gbp_gdb_debugger_read_memory_cb,
+                               g_steal_pointer (&task));
+}
+
+static GBytes *
+gbp_gdb_debugger_read_memory_finish (IdeDebugger   *debugger,
+                                     GAsyncResult  *result,
+                                     GError       **error)
+{
+  g_assert (GBP_IS_GDB_DEBUGGER (debugger));
+  g_assert (IDE_IS_TASK (result));
+
+  return ide_task_propagate_pointer (IDE_TASK (result), error);
+}
+
+static void
+gbp_gdb_debugger_write_memory_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  GbpGdbDebugger *self = (GbpGdbDebugger *)object;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  struct gdbwire_mi_output *output;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  output = gbp_gdb_debugger_exec_finish (self, result, &error);
+
+  if (output == NULL || gbp_gdb_debugger_unwrap (output, &error))
+    ide_task_return_error (task, g_steal_pointer (&error));
+  else
+    ide_task_return_boolean (task, TRUE);
+
+  g_clear_pointer (&output, gdbwire_mi_output_free);
+}
+
+static void
+gbp_gdb_debugger_write_memory_async (IdeDebugger         *debugger,
+                                     IdeDebuggerAddress   address,
+                                     GBytes              *contents,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  static const char hex[] = "0123456789abcdef";
+  GbpGdbDebugger *self = (GbpGdbDebugger *)debugger;
+  g_autoptr(IdeTask) task = NULL;
+  g_autoptr(GString) command = NULL;
+  const guint8 *data;
+  gsize len;
+
+  g_assert (GBP_IS_GDB_DEBUGGER (self));
+  g_assert (contents != NULL);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_gdb_debugger_write_memory_async);
+
+  data = g_bytes_get_data (contents, &len);
+
+  if (len == 0)
+    {
+      ide_task_return_boolean (task, TRUE);
+      return;
+    }
+
+  command = g_string_new (NULL);
+  g_string_append_printf (command,
+                          "-data-write-memory-bytes 0x%"G_GINT64_MODIFIER"x ",
+                          address);
+
+  for (gsize i = 0; i < len; i++)
+    {
+      g_string_append_c (command, hex[data[i] >> 4]);
+      g_string_append_c (command, hex[data[i] & 0xF]);
+    }
+
+  gbp_gdb_debugger_exec_async (self,
+                               command->str,
+                               cancellable,
+                               gbp_gdb_debugger_write_memory_cb,
+                               g_steal_pointer (&task));
+}
+
+static gboolean
+gbp_gdb_debugger_write_memory_finish (IdeDebugger   *debugger,
+                                      GAsyncResult  *result,
+                                      GError       **error)
+{
+  g_assert (GBP_IS_GDB_DEBUGGER (debugger));
+  g_assert (IDE_IS_TASK (result));
+
+  return ide_task_propagate_boolean (IDE_TASK (result), error);
+}
+
 static gboolean
 gbp_gdb_debugger_supports_run_command (IdeDebugger   *debugger,
                                        IdePipeline   *pipeline,
@@ -2597,6 +3503,8 @@ gbp_gdb_debugger_destroy (IdeObject *object)
 
   g_clear_object (&self->current_config);
 
+  gbp_gdb_debugger_forget_variables (self);
+
   list = self->cmdqueue.head;
 
   self->cmdqueue.head = NULL;
@@ -2641,6 +3549,8 @@ gbp_gdb_debugger_finalize (GObject *object)
   g_clear_pointer (&self->parser, gdbwire_mi_parser_destroy);
   g_clear_pointer (&self->read_buffer, g_free);
   g_clear_pointer (&self->register_names, g_hash_table_unref);
+  g_clear_pointer (&self->varobjs, g_hash_table_unref);
+  g_clear_pointer (&self->frame_variables, g_hash_table_unref);
   g_queue_clear (&self->cmdqueue);
 
   G_OBJECT_CLASS (gbp_gdb_debugger_parent_class)->finalize (object);
@@ -2670,6 +3580,10 @@ gbp_gdb_debugger_class_init (GbpGdbDebuggerClass *klass)
   debugger_class->list_breakpoints_finish = gbp_gdb_debugger_list_breakpoints_finish;
   debugger_class->list_frames_async = gbp_gdb_debugger_list_frames_async;
   debugger_class->list_frames_finish = gbp_gdb_debugger_list_frames_finish;
+  debugger_class->list_frames_range_async = gbp_gdb_debugger_list_frames_range_async;
+  debugger_class->list_frames_range_finish = gbp_gdb_debugger_list_frames_range_finish;
+  debugger_class->list_children_async = gbp_gdb_debugger_list_children_async;
+  debugger_class->list_children_finish = gbp_gdb_debugger_list_children_finish;
   debugger_class->list_locals_async = gbp_gdb_debugger_list_locals_async;
   debugger_class->list_locals_finish = gbp_gdb_debugger_list_locals_finish;
   debugger_class->list_params_async = gbp_gdb_debugger_list_params_async;
@@ -2678,6 +3592,8 @@ gbp_gdb_debugger_class_init (GbpGdbDebuggerClass *klass)
   debugger_class->list_registers_finish = gbp_gdb_debugger_list_registers_finish;
   debugger_class->modify_breakpoint_async = gbp_gdb_debugger_modify_breakpoint_async;
   debugger_class->modify_breakpoint_finish = gbp_gdb_debugger_modify_breakpoint_finish;
+  debugger_class->read_memory_async = gbp_gdb_debugger_read_memory_async;
+  debugger_class->read_memory_finish = gbp_gdb_debugger_read_memory_finish;
   debugger_class->move_async = gbp_gdb_debugger_move_async;
   debugger_class->move_finish = gbp_gdb_debugger_move_finish;
   debugger_class->remove_breakpoint_async = gbp_gdb_debugger_remove_breakpoint_async;
@@ -2686,6 +3602,8 @@ gbp_gdb_debugger_class_init (GbpGdbDebuggerClass *klass)
   debugger_class->send_signal_finish = gbp_gdb_debugger_send_signal_finish;
   debugger_class->interpret_async = gbp_gdb_debugger_interpret_async;
   debugger_class->interpret_finish = gbp_gdb_debugger_interpret_finish;
+  debugger_class->write_memory_async = gbp_gdb_debugger_write_memory_async;
+  debugger_class->write_memory_finish = gbp_gdb_debugger_write_memory_finish;
 }
 
 static void
@@ -2698,6 +3616,8 @@ gbp_gdb_debugger_init (GbpGdbDebugger *self)
   self->parser = gdbwire_mi_parser_create (callbacks);
   self->read_cancellable = g_cancellable_new ();
   self->read_buffer = g_malloc (READ_BUFFER_LEN);
+  self->varobjs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  self->frame_variables = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
 
   g_queue_init (&self->cmdqueue);
 }
@@ -0,0 +1,179 @@
+/* gbp-gdb-variable.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "gbp-gdb-variable"
+
+#include "config.h"
+
+#include "gbp-gdb-variable.h"
+
+struct _GbpGdbVariable
+{
+  IdeDebuggerVariable parent_instance;
+
+  /* The thread and frame depth the variable was listed from. This is
+   * used to create the variable object lazily for root variables.
+   */
+  char *thread_id;
+  guint depth;
+
+  /* Identifies the variable within a specific frame activation so that
+   * we can hand back the same instance (and variable object) when the
+   * locals of that frame are listed again after a step.
+   */
+  char *key;
+
+  /* The name of the GDB/MI variable object, or %NULL if one has not
+   * been created yet (or it was deleted after going out of scope).
+   */
+  char *varobj;
+
+  /* Children that have already been fetched, if any. Their values are
+   * kept up to date with -var-update after each stop.
+   */
+  GPtrArray *children;
+};
+
+G_DEFINE_FINAL_TYPE (GbpGdbVariable, gbp_gdb_variable, IDE_TYPE_DEBUGGER_VARIABLE)
+
+static void
+gbp_gdb_variable_finalize (GObject *object)
+{
+  GbpGdbVariable *self = (GbpGdbVariable *)object;
+
+  g_clear_pointer (&self->thread_id, g_free);
+  g_clear_pointer (&self->key, g_free);
+  g_clear_pointer (&self->varobj, g_free);
+  g_clear_pointer (&self->children, g_ptr_array_unref);
+
+  G_OBJECT_CLASS (gbp_gdb_variable_parent_class)->finalize (object);
+}
+
+static void
+gbp_gdb_variable_class_init (GbpGdbVariableClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_gdb_variable_finalize;
+}
+
+static void
+gbp_gdb_variable_init (GbpGdbVariable *self)
+{
+}
+
+GbpGdbVariable *
+gbp_gdb_variable_new (const char *name)
+{
+  return g_object_new (GBP_TYPE_GDB_VARIABLE,
+                       "name", name,
+                       NULL);
+}
+
+const char *
+gbp_gdb_variable_get_thread_id (GbpGdbVariable *self)
+{
+  g_return_val_if_fail (GBP_IS_GDB_VARIABLE (self), NULL);
+
+  return self->thread_id;
+}
+
+guint
+gbp_gdb_variable_get_depth (GbpGdbVariable *self)
+{
+  g_return_val_if_fail (GBP_IS_GDB_VARIABLE (self), 0);
+
+  return self->depth;
+}
+
+void
+gbp_gdb_variable_set_frame (GbpGdbVariable *self,
+                            const char     *thread_id,
+                            guint           depth)
+{
+  g_return_if_fail (GBP_IS_GDB_VARIABLE (self));
+
+  g_set_str (&self->thread_id, thread_id);
+  self->depth = depth;
+}
+
+const char *
+gbp_gdb_variable_get_key (GbpGdbVariable *self)
+{
+  g_return_val_if_fail (GBP_IS_GDB_VARIABLE (self), NULL);
+
+  return self->key;
+}
+
+void
+gbp_gdb_variable_set_key (GbpGdbVariable *self,
+                          const char     *key)
+{
+  g_return_if_fail (GBP_IS_GDB_VARIABLE (self));
+
+  g_set_str (&self->key, key);
+}
+
+const char *
+gbp_gdb_variable_get_varobj (GbpGdbVariable *self)
+{
+  g_return_val_if_fail (GBP_IS_GDB_VARIABLE (self), NULL);
+
+  return self->varobj;
+}
+
+void
+gbp_gdb_variable_set_varobj (GbpGdbVariable *self,
+                             const char     *varobj)
+{
+  g_return_if_fail (GBP_IS_GDB_VARIABLE (self));
+
+  g_set_str (&self->varobj, varobj);
+}
+
+/**
+ * gbp_gdb_variable_get_children:
+ * @self: a #GbpGdbVariable
+ *
+ * Returns: (transfer none) (nullable) (element-type GbpGdbVariable): the
+ *   children that have been fetched, or %NULL
+ */
+GPtrArray *
+gbp_gdb_variable_get_children (GbpGdbVariable *self)
+{
+  g_return_val_if_fail (GBP_IS_GDB_VARIABLE (self), NULL);
+
+  return self->children;
+}
+
+void
+gbp_gdb_variable_set_children (GbpGdbVariable *self,
+                               GPtrArray      *children)
+{
+  g_return_if_fail (GBP_IS_GDB_VARIABLE (self));
+
+  if (children == self->children)
+    return;
+
+  if (children != NULL)
+    g_ptr_array_ref (children);
+  g_clear_pointer (&self->children, g_ptr_array_unref);
+  self->children = children;
+}
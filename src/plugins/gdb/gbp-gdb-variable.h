@@ -0,0 +1,47 @@
+/* gbp-gdb-variable.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <libide-debugger.h>
+
+G_BEGIN_DECLS
+
+#define GBP_TYPE_GDB_VARIABLE (gbp_gdb_variable_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpGdbVariable, gbp_gdb_variable, GBP, GDB_VARIABLE, IdeDebuggerVariable)
+
+GbpGdbVariable *gbp_gdb_variable_new           (const char     *name);
+const char     *gbp_gdb_variable_get_thread_id (GbpGdbVariable *self);
+guint           gbp_gdb_variable_get_depth     (GbpGdbVariable *self);
+void            gbp_gdb_variable_set_frame     (GbpGdbVariable *self,
+                                                const char     *thread_id,
+                                                guint           depth);
+const char     *gbp_gdb_variable_get_key       (GbpGdbVariable *self);
+void            gbp_gdb_variable_set_key       (GbpGdbVariable *self,
+                                                const char     *key);
+const char     *gbp_gdb_variable_get_varobj    (GbpGdbVariable *self);
+void            gbp_gdb_variable_set_varobj    (GbpGdbVariable *self,
+                                                const char     *varobj);
+GPtrArray      *gbp_gdb_variable_get_children  (GbpGdbVariable *self);
+void            gbp_gdb_variable_set_children  (GbpGdbVariable *self,
+                                                GPtrArray      *children);
+
+G_END_DECLS
@@ -0,0 +1,66 @@
+/* gbp-grep-item.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-item"
+
+#include "config.h"
+
+#include "gbp-grep-item.h"
+
+/* Items are created on demand by GbpGrepModel as the list view asks for
+ * them, so they only carry the row position. All of the row data lives
+ * in the model's chunked storage and is resolved from there.
+ */
+struct _GbpGrepItem
+{
+  GObject parent_instance;
+  guint   position;
+};
+
+G_DEFINE_FINAL_TYPE (GbpGrepItem, gbp_grep_item, G_TYPE_OBJECT)
+
+static void
+gbp_grep_item_class_init (GbpGrepItemClass *klass)
+{
+}
+
+static void
+gbp_grep_item_init (GbpGrepItem *self)
+{
+}
+
+GbpGrepItem *
+gbp_grep_item_new (guint position)
+{
+  GbpGrepItem *self;
+
+  self = g_object_new (GBP_TYPE_GREP_ITEM, NULL);
+  self->position = position;
+
+  return self;
+}
+
+guint
+gbp_grep_item_get_position (GbpGrepItem *self)
+{
+  g_return_val_if_fail (GBP_IS_GREP_ITEM (self), 0);
+
+  return self->position;
+}
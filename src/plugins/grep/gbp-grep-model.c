@@ -22,16 +22,79 @@
 
 #include "config.h"
 
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
 #include <libide-code.h>
 #include <libide-vcs.h>
 
+#include "gbp-grep-item.h"
 #include "gbp-grep-model.h"
+#include "gbp-grep-scanner.h"
+
+/* How often we merge rows found by the scanner threads into the model.
+ * Merging happens in bulk so that the list view only sees a handful of
+ * ::items-changed emissions per second regardless of the match rate.
+ */
+#define FLUSH_INTERVAL_MSEC 100
+
+/* Upper bound on the number of rows we keep in memory. Queries which
+ * match nearly every line of a large tree are not useful to display, so
+ * we stop scanning and mark the model as truncated instead.
+ */
+#define MAX_ROWS 100000
 
+/* Only the location of a matching line is kept, the contents are read
+ * back from the file when the row is displayed or edited.
+ */
 typedef struct
 {
-  GBytes    *bytes;
-  GPtrArray *rows;
-} Index;
+  goffset offset;
+  guint   line;
+  guint   len;
+} Row;
+
+/* Rows are stored in chunks, one per file with matches. The path is only
+ * stored once per chunk. Chunks are immutable once they have been handed
+ * to the main thread.
+ */
+typedef struct
+{
+  char   *path;
+  GArray *rows;
+  guint   position;
+} Chunk;
+
+/* State shared between the main thread, the directory walker and the
+ * scanner threads. Everything that may be touched from more than one
+ * thread after the walk has started is protected by @mutex.
+ */
+typedef struct
+{
+  GMutex          mutex;
+  GbpGrepScanner *scanner;
+  IdeVcs         *vcs;
+  GFile          *root;
+  char           *root_path;
+  GCancellable   *cancellable;
+  GPtrArray      *pending;
+  guint           n_rows;
+  int             stopped;
+  guint           recursive : 1;
+  guint           is_directory : 1;
+  guint           truncated : 1;
+} Scan;
+
+typedef struct
+{
+  Scan       *scan;
+  Chunk      *chunk;
+  const char *data;
+} ScanFile;
 
 struct _GbpGrepModel
 {
@@ -42,22 +105,27 @@ struct _GbpGrepModel
   /* The root directory to start searching from. */
   GFile *directory;
 
-  /* The query text, which we use to send to grep as well as use with
-   * GRegex to extract the match positions from a specific line.
+  /* The query text, which we use to build the scanner as well as to
+   * extract the match positions from a specific line.
    */
   gchar *query;
 
-  /* We need to do client-side processing to extract the exact message
-   * locations after grep gives us the matching lines. This allows us to
-   * create IdeTextEdit source ranges later as well as creating the
-   * match positions for highlighting in the treeview cell renderers.
+  /* The compiled query, shared with the scanner threads. We also use its
+   * regex to extract the exact match locations within a line so that we
+   * can create IdeTextEdit source ranges later as well as the match
+   * positions for highlighting in the list cells.
    */
-  GRegex *message_regex;
+  GbpGrepScanner *scanner;
 
-  /* Our index of matches, which can be compiled off the main thread
-   * and then assigned to the model after it has completed building.
+  /* Our in-flight scan, if any. Rows are accumulated there by worker
+   * threads and periodically moved into @chunks from the main thread.
    */
-  Index *index;
+  Scan *scan;
+  guint flush_source;
+
+  /* Array of Chunk, sorted by position */
+  GPtrArray *chunks;
+  guint n_rows;
 
   /* We store the index of the toggled items here, and use that to
    * reverse their selection from a base "all" or "nothing" mode.
@@ -69,6 +137,13 @@ struct _GbpGrepModel
    * This saves us a bunch of repeated work.
    */
   GbpGrepModelLine prev_line;
+  const Row *prev_row;
+
+  /* The file of the last chunk we read a line from, as neighbouring
+   * rows are usually displayed (or edited) together.
+   */
+  const Chunk *fd_chunk;
+  int fd;
 
   guint mode;
 
@@ -78,12 +153,13 @@ struct _GbpGrepModel
   guint case_sensitive : 1;
   guint at_word_boundaries : 1;
   guint was_directory : 1;
+  guint truncated : 1;
 };
 
-static void tree_model_iface_init (GtkTreeModelIface *iface);
+static void list_model_iface_init (GListModelInterface *iface);
 
 G_DEFINE_FINAL_TYPE_WITH_CODE (GbpGrepModel, gbp_grep_model, G_TYPE_OBJECT,
-                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL, tree_model_iface_init))
+                               G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, list_model_iface_init))
 
 enum {
   PROP_0,
@@ -93,6 +169,7 @@ enum {
   PROP_RECURSIVE,
   PROP_USE_REGEX,
   PROP_QUERY,
+  PROP_TRUNCATED,
   N_PROPS
 };
 
@@ -102,109 +179,205 @@ enum {
 };
 
 static GParamSpec *properties [N_PROPS];
-static GRegex     *line_regex;
+
+static const char *vcs_dirs[] = { ".bzr", ".git", ".hg", ".svn" };
 
 static void
-index_free (gpointer data)
+chunk_free (gpointer data)
 {
-  Index *idx = data;
+  Chunk *chunk = data;
 
-  g_clear_pointer (&idx->rows, g_ptr_array_unref);
-  g_clear_pointer (&idx->bytes, g_bytes_unref);
-  g_slice_free (Index, idx);
+  g_clear_pointer (&chunk->path, g_free);
+  g_clear_pointer (&chunk->rows, g_array_unref);
+  g_slice_free (Chunk, chunk);
+}
+
+static Chunk *
+chunk_new (const char *path)
+{
+  Chunk *chunk;
+
+  chunk = g_slice_new0 (Chunk);
+  chunk->path = g_strdup (path);
+  chunk->rows = g_array_new (FALSE, FALSE, sizeof (Row));
+
+  return chunk;
+}
+
+static void
+scan_finalize (gpointer data)
+{
+  Scan *scan = data;
+
+  g_mutex_clear (&scan->mutex);
+  g_clear_pointer (&scan->scanner, gbp_grep_scanner_unref);
+  g_clear_pointer (&scan->pending, g_ptr_array_unref);
+  g_clear_pointer (&scan->root_path, g_free);
+  g_clear_object (&scan->vcs);
+  g_clear_object (&scan->root);
+  g_clear_object (&scan->cancellable);
+}
+
+static void
+scan_unref (Scan *scan)
+{
+  g_atomic_rc_box_release_full (scan, scan_finalize);
+}
+
+static inline gboolean
+scan_is_stopped (Scan *scan)
+{
+  return g_atomic_int_get (&scan->stopped) ||
+         g_cancellable_is_cancelled (scan->cancellable);
 }
 
 static void
 clear_line (GbpGrepModelLine *cl)
 {
   cl->start_of_line = NULL;
+  cl->start_of_message = NULL;
   cl->line = 0;
+  g_clear_pointer (&cl->text, g_free);
   g_clear_pointer (&cl->path, g_free);
   g_clear_pointer (&cl->matches, g_array_unref);
 }
 
-static gboolean
-gbp_grep_model_line_parse (GbpGrepModelLine *cl,
-                           const gchar      *line,
+static char *
+gbp_grep_model_read_line (GbpGrepModel *self,
+                          const Chunk  *chunk,
+                          const Row    *row)
+{
+  g_autofree char *buf = NULL;
+  gssize n_read;
+
+  g_assert (GBP_IS_GREP_MODEL (self));
+  g_assert (chunk != NULL);
+  g_assert (row != NULL);
+
+  if (chunk != self->fd_chunk)
+    {
+      g_autoptr(GFile) file = gbp_grep_model_get_file (self, chunk->path);
+      g_autofree char *path = g_file_get_path (file);
+
+      if (self->fd != -1)
+        g_close (self->fd, NULL);
+
+      self->fd_chunk = chunk;
+      self->fd = path ? g_open (path, O_RDONLY | O_CLOEXEC, 0) : -1;
+    }
+
+  if (self->fd == -1)
+    return g_strdup ("");
+
+  /* The file may have changed since it was scanned, in which case we
+   * just display whatever is there now.
+   */
+  buf = g_malloc (row->len + 1);
+  if ((n_read = pread (self->fd, buf, row->len, row->offset)) < 0)
+    n_read = 0;
+
+  return g_utf8_make_valid (buf, n_read);
+}
+
+static void
+gbp_grep_model_line_parse (GbpGrepModel     *self,
+                           GbpGrepModelLine *cl,
+                           const Chunk      *chunk,
+                           const Row        *row,
                            GRegex           *message_regex)
 {
-  g_autoptr(GMatchInfo) match = NULL;
-  gsize line_len;
+  g_autoptr(GMatchInfo) msg_match = NULL;
+  const char *text;
 
+  g_assert (GBP_IS_GREP_MODEL (self));
   g_assert (cl != NULL);
-  g_assert (line != NULL);
-  g_assert (line_regex != NULL);
+  g_assert (chunk != NULL);
+  g_assert (row != NULL);
   g_assert (message_regex != NULL);
 
-  line_len = strlen (line);
+  text = cl->text = gbp_grep_model_read_line (self, chunk, row);
+
+  cl->start_of_line = text;
+  cl->start_of_message = text;
+  cl->path = g_strdup (chunk->path);
+  cl->matches = g_array_new (FALSE, FALSE, sizeof (GbpGrepModelMatch));
+  cl->line = row->line;
 
-  if (g_regex_match_full (line_regex, line, line_len, 0, 0, &match, NULL))
+  /* Now parse the matches for the line so that we can highlight
+   * them in the list and also determine the IdeTextEdit source
+   * range when editing files. This is only done for rows as they
+   * are displayed (or edited) rather than for every match found.
+   */
+  if (g_regex_match_full (message_regex, text, -1, 0, 0, &msg_match, NULL))
     {
-      g_autofree gchar *pathstr = NULL;
-      g_autofree gchar *linestr = NULL;
-      gint msg_begin = -1;
-      gint msg_end = -1;
+      do
+        {
+          gint match_begin = -1;
+          gint match_end = -1;
 
-      pathstr = g_match_info_fetch (match, 1);
-      linestr = g_match_info_fetch (match, 2);
+          if (g_match_info_fetch_pos (msg_match, 0, &match_begin, &match_end))
+            {
+              GbpGrepModelMatch cm;
+
+              /*
+               * We need to convert match offsets from bytes into the
+               * number of UTF-8 (unichar) characters) so that we get
+               * proper columns into the target file. Otherwise we risk
+               * corrupting non-ASCII files.
+               */
+              cm.match_begin = g_utf8_strlen (text, match_begin);
+              cm.match_end = g_utf8_strlen (text, match_end);
+              cm.match_begin_bytes = match_begin;
+              cm.match_end_bytes = match_end;
+
+              g_array_append_val (cl->matches, cm);
+            }
+        }
+      while (g_match_info_next (msg_match, NULL));
+    }
+}
 
-      if (g_match_info_fetch_pos (match, 3, &msg_begin, &msg_end))
-        {
-          g_autoptr(GMatchInfo) msg_match = NULL;
-          gsize msg_len;
+static int
+chunk_compare_position (gconstpointer keyptr,
+                        gconstpointer chunkptr)
+{
+  guint position = *(const guint *)keyptr;
+  const Chunk *chunk = *(const Chunk * const *)chunkptr;
 
-          /* Make sure we parsed the message offset */
-          if (msg_begin < 0)
-            return FALSE;
+  if (position < chunk->position)
+    return -1;
+  else if (position >= chunk->position + chunk->rows->len)
+    return 1;
+  else
+    return 0;
+}
 
-          cl->start_of_line = line;
-          cl->start_of_message = line + msg_begin;
-          cl->path = g_steal_pointer (&pathstr);
-          cl->matches = g_array_new (FALSE, FALSE, sizeof (GbpGrepModelMatch));
-          cl->line = g_ascii_strtoll (linestr, NULL, 10);
+static gboolean
+gbp_grep_model_lookup (GbpGrepModel  *self,
+                       guint          position,
+                       const Chunk  **chunk,
+                       const Row    **row)
+{
+  const Chunk * const *found;
 
-          /* Now parse the matches for the line so that we can highlight
-           * them in the treeview and also determine the IdeTextEdit
-           * source range when editing files.
-           */
+  g_assert (GBP_IS_GREP_MODEL (self));
 
-          msg_len = line_len - msg_begin;
+  if (position >= self->n_rows)
+    return FALSE;
 
-          if (g_regex_match_full (message_regex, cl->start_of_message, msg_len, 0, 0, &msg_match, NULL))
-            {
-              do
-                {
-                  gint match_begin = -1;
-                  gint match_end = -1;
-
-                  if (g_match_info_fetch_pos (msg_match, 0, &match_begin, &match_end))
-                    {
-                      GbpGrepModelMatch cm;
-
-                      /*
-                       * We need to convert match offsets from bytes into the
-                       * number of UTF-8 (unichar) characters) so that we get
-                       * proper columns into the target file. Otherwise we risk
-                       * corrupting non-ASCII files.
-                       */
-                      cm.match_begin = g_utf8_strlen (cl->start_of_message, match_begin);
-                      cm.match_end = g_utf8_strlen (cl->start_of_message, match_end);
-                      cm.match_begin_bytes = match_begin;
-                      cm.match_end_bytes = match_end;
-
-                      g_array_append_val (cl->matches, cm);
-                    }
-                }
-              while (g_match_info_next (msg_match, NULL));
-
-              g_clear_pointer (&msg_match, g_match_info_free);
-            }
-        }
+  found = bsearch (&position,
+                   self->chunks->pdata,
+                   self->chunks->len,
+                   sizeof (gpointer),
+                   chunk_compare_position);
 
-      return TRUE;
-    }
+  if (found == NULL)
+    return FALSE;
 
-  return FALSE;
+  *chunk = *found;
+  *row = &g_array_index ((*found)->rows, Row, position - (*found)->position);
+
+  return TRUE;
 }
 
 GbpGrepModel *
@@ -225,8 +398,22 @@ gbp_grep_model_dispose (GObject *object)
 {
   GbpGrepModel *self = (GbpGrepModel *)object;
 
+  /* Stop the scanner threads, they will drop their reference to the
+   * scan as they finish up.
+   */
+  if (self->scan != NULL)
+    g_atomic_int_set (&self->scan->stopped, TRUE);
+
+  g_clear_handle_id (&self->flush_source, g_source_remove);
   g_clear_object (&self->context);
 
+  if (self->fd != -1)
+    {
+      g_close (self->fd, NULL);
+      self->fd = -1;
+    }
+  self->fd_chunk = NULL;
+
   G_OBJECT_CLASS (gbp_grep_model_parent_class)->dispose (object);
 }
 
@@ -239,10 +426,11 @@ gbp_grep_model_finalize (GObject *object)
 
   g_clear_object (&self->context);
   g_clear_object (&self->directory);
-  g_clear_pointer (&self->index, index_free);
+  g_clear_pointer (&self->scan, scan_unref);
+  g_clear_pointer (&self->chunks, g_ptr_array_unref);
   g_clear_pointer (&self->query, g_free);
   g_clear_pointer (&self->toggled, g_hash_table_unref);
-  g_clear_pointer (&self->message_regex, g_regex_unref);
+  g_clear_pointer (&self->scanner, gbp_grep_scanner_unref);
 
   G_OBJECT_CLASS (gbp_grep_model_parent_class)->finalize (object);
 }
@@ -281,6 +469,10 @@ gbp_grep_model_get_property (GObject    *object,
       g_value_set_string (value, gbp_grep_model_get_query (self));
       break;
 
+    case PROP_TRUNCATED:
+      g_value_set_boolean (value, gbp_grep_model_get_truncated (self));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -364,10 +556,12 @@ gbp_grep_model_class_init (GbpGrepModelClass *klass)
     g_param_spec_string ("query", NULL, NULL, NULL,
                          (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
 
-  g_object_class_install_properties (object_class, N_PROPS, properties);
+  properties [PROP_TRUNCATED] =
+    g_param_spec_boolean ("truncated", NULL, NULL,
+                          FALSE,
+                          (G_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
 
-  line_regex = g_regex_new ("([^:]+):(\\d+):(.*)", 0, 0, NULL);
-  g_assert (line_regex != NULL);
+  g_object_class_install_properties (object_class, N_PROPS, properties);
 }
 
 static void
@@ -375,43 +569,31 @@ gbp_grep_model_init (GbpGrepModel *self)
 {
   self->mode = MODE_ALL;
   self->toggled = g_hash_table_new (NULL, NULL);
+  self->chunks = g_ptr_array_new_with_free_func (chunk_free);
+  self->fd = -1;
 }
 
 static void
-gbp_grep_model_clear_regex (GbpGrepModel *self)
+gbp_grep_model_clear_scanner (GbpGrepModel *self)
 {
   g_assert (GBP_IS_GREP_MODEL (self));
 
-  g_clear_pointer (&self->message_regex, g_regex_unref);
+  g_clear_pointer (&self->scanner, gbp_grep_scanner_unref);
 }
 
 static gboolean
-gbp_grep_model_rebuild_regex (GbpGrepModel *self)
+gbp_grep_model_rebuild_scanner (GbpGrepModel  *self,
+                                GError       **error)
 {
-  GRegexCompileFlags compile_flags = G_REGEX_OPTIMIZE;
-  g_autoptr(GRegex) regex = NULL;
-  g_autoptr(GError) error = NULL;
-  g_autofree gchar *escaped = NULL;
-  const gchar *query;
-
   g_assert (GBP_IS_GREP_MODEL (self));
-  g_assert (self->message_regex == NULL);
-
-  if (self->use_regex)
-    query = self->query;
-  else
-    query = escaped = g_regex_escape_string (self->query, -1);
+  g_assert (self->scanner == NULL);
 
-  if (!self->case_sensitive)
-    compile_flags |= G_REGEX_CASELESS;
-
-  if (!(regex = g_regex_new (query, compile_flags, 0, &error)))
-    {
-      g_warning ("Failed to compile regex for match: %s", error->message);
-      return FALSE;
-    }
-
-  self->message_regex = g_steal_pointer (&regex);
+  if (!(self->scanner = gbp_grep_scanner_new (self->query,
+                                              self->use_regex,
+                                              self->case_sensitive,
+                                              self->at_word_boundaries,
+                                              error)))
+    return FALSE;
 
   return TRUE;
 }
@@ -432,7 +614,7 @@ gbp_grep_model_set_query (GbpGrepModel *self,
 
   if (g_set_str (&self->query, query))
     {
-      gbp_grep_model_clear_regex (self);
+      gbp_grep_model_clear_scanner (self);
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_QUERY]);
     }
 }
@@ -483,7 +665,7 @@ gbp_grep_model_set_use_regex (GbpGrepModel *self,
   if (use_regex != self->use_regex)
     {
       self->use_regex = use_regex;
-      gbp_grep_model_clear_regex (self);
+      gbp_grep_model_clear_scanner (self);
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_USE_REGEX]);
     }
 }
@@ -532,7 +714,7 @@ gbp_grep_model_set_case_sensitive (GbpGrepModel *self,
   if (case_sensitive != self->case_sensitive)
     {
       self->case_sensitive = case_sensitive;
-      gbp_grep_model_clear_regex (self);
+      gbp_grep_model_clear_scanner (self);
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_CASE_SENSITIVE]);
     }
 }
@@ -557,208 +739,326 @@ gbp_grep_model_set_at_word_boundaries (GbpGrepModel *self,
   if (at_word_boundaries != self->at_word_boundaries)
     {
       self->at_word_boundaries = at_word_boundaries;
-      gbp_grep_model_clear_regex (self);
+      gbp_grep_model_clear_scanner (self);
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_AT_WORD_BOUNDARIES]);
     }
 }
 
-static IdeSubprocessLauncher *
-gbp_grep_model_create_launcher (GbpGrepModel *self)
+/**
+ * gbp_grep_model_get_truncated:
+ * @self: a #GbpGrepModel
+ *
+ * Checks if the scan stopped early because too many lines matched.
+ *
+ * Returns: %TRUE if not every match is contained in the model
+ */
+gboolean
+gbp_grep_model_get_truncated (GbpGrepModel *self)
 {
-  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
-  const gchar *path;
-  IdeVcs *vcs;
-  GFile *workdir;
-  GType git_vcs;
-  gboolean use_git_grep = FALSE;
+  g_return_val_if_fail (GBP_IS_GREP_MODEL (self), FALSE);
 
-  g_assert (GBP_IS_GREP_MODEL (self));
-  g_assert (self->query != NULL);
-  g_assert (self->query[0] != '\0');
+  return self->truncated;
+}
 
-  vcs = ide_vcs_from_context (self->context);
-  workdir = ide_vcs_get_workdir (vcs);
-  git_vcs = g_type_from_name ("GbpGitVcs");
+static gboolean
+gbp_grep_model_scan_line_cb (const char *line,
+                             gsize       line_len,
+                             guint       lineno,
+                             gpointer    user_data)
+{
+  ScanFile *sf = user_data;
+  Row row;
 
-  if (self->directory != NULL)
-    path = g_file_peek_path (self->directory);
-  else
-    path = g_file_peek_path (workdir);
+  g_assert (sf != NULL);
+  g_assert (sf->chunk != NULL);
 
-  launcher = ide_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_PIPE);
+  row.offset = line - sf->data;
+  row.line = lineno;
+  row.len = line_len;
 
-  /*
-   * Soft runtime check for Git support, so that we can use "git grep"
-   * instead of the system "grep".
-   */
-  if (git_vcs != G_TYPE_INVALID && G_TYPE_CHECK_INSTANCE_TYPE (vcs, git_vcs))
-    use_git_grep = TRUE;
+  g_array_append_val (sf->chunk->rows, row);
 
-  if (use_git_grep)
-    {
-      ide_subprocess_launcher_push_argv (launcher, "git");
-      ide_subprocess_launcher_push_argv (launcher, "grep");
-    }
-  else
-    {
-#ifdef __FreeBSD__
-      ide_subprocess_launcher_push_argv (launcher, "bsdgrep");
-#else
-      ide_subprocess_launcher_push_argv (launcher, "grep");
-#endif
-    }
+  return sf->chunk->rows->len < MAX_ROWS && !scan_is_stopped (sf->scan);
+}
 
-  ide_subprocess_launcher_push_argv (launcher, "-I");
-  ide_subprocess_launcher_push_argv (launcher, "-H");
-  ide_subprocess_launcher_push_argv (launcher, "-n");
+static void
+gbp_grep_model_scan_file_worker (gpointer data,
+                                 gpointer user_data)
+{
+  g_autofree char *path = data;
+  g_autofree char *basename = NULL;
+  g_autoptr(GMappedFile) mapped = NULL;
+  Scan *scan = user_data;
+  const char *relative;
+  ScanFile sf;
 
-  if (!self->case_sensitive)
-    ide_subprocess_launcher_push_argv (launcher, "-i");
+  g_assert (path != NULL);
+  g_assert (scan != NULL);
 
-  if (self->at_word_boundaries)
-    ide_subprocess_launcher_push_argv (launcher, "-w");
+  if (scan_is_stopped (scan))
+    return;
 
-  if (!use_git_grep)
-    {
-      if (self->recursive)
-        ide_subprocess_launcher_push_argv (launcher, "-r");
-    }
+  if (!(mapped = g_mapped_file_new (path, FALSE, NULL)))
+    return;
+
+  if (!scan->is_directory)
+    relative = basename = g_path_get_basename (path);
+  else if (g_str_has_prefix (path, scan->root_path))
+    relative = path + strlen (scan->root_path);
   else
-    {
-      if (!self->recursive)
-        ide_subprocess_launcher_push_argv (launcher, "--max-depth=0");
+    relative = path;
 
-      /* Allow files that are untracked, but not ignored */
-      ide_subprocess_launcher_push_argv (launcher, "--untracked");
-    }
+  while (*relative == G_DIR_SEPARATOR)
+    relative++;
 
-  ide_subprocess_launcher_push_argv (launcher, "-E");
+  sf.scan = scan;
+  sf.chunk = chunk_new (relative);
+  sf.data = g_mapped_file_get_contents (mapped);
 
-  if (!self->use_regex)
-    {
-      g_autofree gchar *escaped = NULL;
+  gbp_grep_scanner_scan (scan->scanner,
+                         sf.data,
+                         g_mapped_file_get_length (mapped),
+                         gbp_grep_model_scan_line_cb,
+                         &sf);
 
-      escaped = g_regex_escape_string (self->query, -1);
-      ide_subprocess_launcher_push_argv (launcher, "-e");
-      ide_subprocess_launcher_push_argv (launcher, escaped);
-    }
-  else
+  if (sf.chunk->rows->len == 0)
     {
-      ide_subprocess_launcher_push_argv (launcher, "-e");
-      ide_subprocess_launcher_push_argv (launcher, self->query);
+      chunk_free (sf.chunk);
+      return;
     }
 
-  if (use_git_grep)
+  g_mutex_lock (&scan->mutex);
+
+  if (scan->n_rows + sf.chunk->rows->len >= MAX_ROWS)
     {
-      /* Avoid pathological lines up front before reading them into
-       * the UI process memory space.
-       *
-       * Note that we do this *after* our query match because it causes
-       * grep to have to look at every line up to it. So to do this in
-       * reverse order is incredibly slow.
-       */
-      ide_subprocess_launcher_push_argv (launcher, "--and");
-      ide_subprocess_launcher_push_argv (launcher, "-e");
-      ide_subprocess_launcher_push_argv (launcher, "^.{0,1024}$");
+      g_array_set_size (sf.chunk->rows, MAX_ROWS - scan->n_rows);
+      g_atomic_int_set (&scan->stopped, TRUE);
+      scan->truncated = TRUE;
     }
 
-  if (g_file_test (path, G_FILE_TEST_IS_DIR))
+  scan->n_rows += sf.chunk->rows->len;
+
+  if (sf.chunk->rows->len > 0)
+    g_ptr_array_add (scan->pending, g_steal_pointer (&sf.chunk));
+
+  g_mutex_unlock (&scan->mutex);
+
+  g_clear_pointer (&sf.chunk, chunk_free);
+}
+
+static gboolean
+is_vcs_dir (const char *name)
+{
+  for (guint i = 0; i < G_N_ELEMENTS (vcs_dirs); i++)
     {
-      ide_subprocess_launcher_set_cwd (launcher, path);
-      self->was_directory = TRUE;
+      if (strcmp (name, vcs_dirs[i]) == 0)
+        return TRUE;
     }
-  else
+
+  return FALSE;
+}
+
+static void
+gbp_grep_model_walk (Scan        *scan,
+                     GThreadPool *pool)
+{
+  GQueue directories = G_QUEUE_INIT;
+  GFile *directory;
+
+  g_assert (scan != NULL);
+  g_assert (pool != NULL);
+
+  g_queue_push_tail (&directories, g_object_ref (scan->root));
+
+  /* Breadth-first so that files closest to the search root are handed to
+   * the scanner threads (and therefore displayed) first.
+   */
+  while ((directory = g_queue_pop_head (&directories)))
     {
-      g_autofree gchar *parent = g_path_get_dirname (path);
-      g_autofree gchar *name = g_path_get_basename (path);
+      g_autoptr(GFileEnumerator) enumerator = NULL;
+      g_autoptr(GFile) dir = directory;
+
+      if (scan_is_stopped (scan))
+        continue;
+
+      if (!(enumerator = g_file_enumerate_children (dir,
+                                                    G_FILE_ATTRIBUTE_STANDARD_NAME","
+                                                    G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                    scan->cancellable,
+                                                    NULL)))
+        continue;
+
+      for (;;)
+        {
+          GFileInfo *info = NULL;
+          GFile *child = NULL;
+          GFileType file_type;
+
+          if (!g_file_enumerator_iterate (enumerator, &info, &child, scan->cancellable, NULL) ||
+              info == NULL ||
+              scan_is_stopped (scan))
+            break;
+
+          file_type = g_file_info_get_file_type (info);
+
+          if (file_type == G_FILE_TYPE_DIRECTORY)
+            {
+              if (!scan->recursive ||
+                  is_vcs_dir (g_file_info_get_name (info)) ||
+                  ide_vcs_is_ignored (scan->vcs, child, NULL))
+                continue;
 
-      self->was_directory = FALSE;
+              g_queue_push_tail (&directories, g_object_ref (child));
+            }
+          else if (file_type == G_FILE_TYPE_REGULAR)
+            {
+              if (ide_vcs_is_ignored (scan->vcs, child, NULL))
+                continue;
 
-      ide_subprocess_launcher_set_cwd (launcher, parent);
-      ide_subprocess_launcher_push_argv (launcher, name);
+              g_thread_pool_push (pool, g_file_get_path (child), NULL);
+            }
+        }
     }
 
-  return g_steal_pointer (&launcher);
+  g_queue_clear_full (&directories, g_object_unref);
 }
 
 static void
-gbp_grep_model_build_index (IdeTask      *task,
+gbp_grep_model_scan_worker (IdeTask      *task,
                             gpointer      source_object,
                             gpointer      task_data,
                             GCancellable *cancellable)
 {
-  GBytes *bytes = task_data;
-  IdeLineReader reader;
-  Index *idx;
-  gchar *buf;
-  gsize len;
+  g_autoptr(GTimer) timer = g_timer_new ();
+  g_autoptr(GError) error = NULL;
+  Scan *scan = task_data;
+  GThreadPool *pool;
+  guint n_threads;
 
   g_assert (IDE_IS_TASK (task));
   g_assert (GBP_IS_GREP_MODEL (source_object));
-  g_assert (bytes != NULL);
-  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+  g_assert (scan != NULL);
 
-  buf = (gchar *)g_bytes_get_data (bytes, &len);
-  ide_line_reader_init (&reader, buf, len);
+  if (!scan->is_directory)
+    {
+      gbp_grep_model_scan_file_worker (g_strdup (scan->root_path), scan);
+      ide_task_return_boolean (task, TRUE);
+      return;
+    }
 
-  idx = g_slice_new0 (Index);
-  idx->bytes = g_bytes_ref (bytes);
-  idx->rows = g_ptr_array_new ();
+  /* Scanning is mostly bound by page-faulting file contents in, so use
+   * every processor we have. The walker itself stays on this thread and
+   * keeps the pool fed.
+   */
+  n_threads = MAX (1, g_get_num_processors ());
 
-  while ((buf = ide_line_reader_next (&reader, &len)))
+  if (!(pool = g_thread_pool_new (gbp_grep_model_scan_file_worker, scan, n_threads, FALSE, &error)))
     {
-      g_ptr_array_add (idx->rows, buf);
-      buf[len] = 0;
+      ide_task_return_error (task, g_steal_pointer (&error));
+      return;
     }
 
-  ide_task_return_pointer (task, idx, index_free);
+  gbp_grep_model_walk (scan, pool);
+
+  /* Wait for the queued files to be processed */
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  g_debug ("Scanned %s in %0.4lf seconds, %u matching lines",
+           scan->root_path, g_timer_elapsed (timer, NULL), scan->n_rows);
+
+  if (g_cancellable_is_cancelled (scan->cancellable))
+    ide_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_CANCELLED,
+                               "The operation was cancelled");
+  else
+    ide_task_return_boolean (task, TRUE);
 }
 
 static void
-gbp_grep_model_scan_cb (GObject      *object,
-                        GAsyncResult *result,
-                        gpointer      user_data)
+gbp_grep_model_flush (GbpGrepModel *self)
 {
-  IdeSubprocess *subprocess = (IdeSubprocess *)object;
-  g_autoptr(IdeTask) task = user_data;
-  g_autoptr(GBytes) bytes = NULL;
-  g_autoptr(GError) error = NULL;
-  g_autofree gchar *stdout_buf = NULL;
-  gsize len;
+  g_autoptr(GPtrArray) pending = NULL;
+  gboolean truncated;
+  guint position;
 
-  IDE_ENTRY;
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (GBP_IS_GREP_MODEL (self));
 
-  g_assert (IDE_IS_SUBPROCESS (object));
-  g_assert (G_IS_ASYNC_RESULT (result));
-  g_assert (IDE_IS_TASK (task));
+  if (self->scan == NULL)
+    return;
 
-  if (!ide_subprocess_communicate_utf8_finish (subprocess, result, &stdout_buf, NULL, &error))
+  g_mutex_lock (&self->scan->mutex);
+  if (self->scan->pending->len > 0)
     {
-      ide_task_return_error (task, g_steal_pointer (&error));
-      IDE_EXIT;
+      pending = g_steal_pointer (&self->scan->pending);
+      self->scan->pending = g_ptr_array_new_with_free_func (chunk_free);
     }
+  truncated = self->scan->truncated;
+  g_mutex_unlock (&self->scan->mutex);
+
+  if (pending != NULL)
+    {
+      position = self->n_rows;
 
-  if (stdout_buf == NULL)
-    stdout_buf = g_strdup ("");
+      for (guint i = 0; i < pending->len; i++)
+        {
+          Chunk *chunk = g_ptr_array_index (pending, i);
 
-  len = strlen (stdout_buf);
-  bytes = g_bytes_new_take (g_steal_pointer (&stdout_buf), len);
-  ide_task_set_task_data (task, g_steal_pointer (&bytes), g_bytes_unref);
-  ide_task_run_in_thread (task, gbp_grep_model_build_index);
+          chunk->position = self->n_rows;
+          self->n_rows += chunk->rows->len;
+        }
 
-  IDE_EXIT;
+      g_ptr_array_extend_and_steal (self->chunks, g_steal_pointer (&pending));
+
+      g_list_model_items_changed (G_LIST_MODEL (self), position, 0, self->n_rows - position);
+    }
+
+  if (truncated != self->truncated)
+    {
+      self->truncated = truncated;
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_TRUNCATED]);
+    }
+}
+
+static gboolean
+gbp_grep_model_flush_cb (gpointer data)
+{
+  GbpGrepModel *self = data;
+
+  g_assert (GBP_IS_GREP_MODEL (self));
+
+  gbp_grep_model_flush (self);
+
+  return G_SOURCE_CONTINUE;
 }
 
+/**
+ * gbp_grep_model_scan_async:
+ * @self: a #GbpGrepModel
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: a callback to execute upon completion
+ * @user_data: closure data for @callback
+ *
+ * Searches the directory (or file) for the query in-process.
+ *
+ * Matching rows are added to the model as they are found, so consumers
+ * may attach to the model before the operation has completed.
+ */
 void
 gbp_grep_model_scan_async (GbpGrepModel        *self,
                            GCancellable        *cancellable,
                            GAsyncReadyCallback  callback,
                            gpointer             user_data)
 {
-  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
-  g_autoptr(IdeSubprocess) subprocess = NULL;
   g_autoptr(IdeTask) task = NULL;
   g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) workdir = NULL;
+  g_autoptr(GFile) root = NULL;
+  g_autofree char *root_path = NULL;
+  IdeVcs *vcs;
+  Scan *scan;
 
   IDE_ENTRY;
 
@@ -788,20 +1088,43 @@ gbp_grep_model_scan_async (GbpGrepModel        *self,
 
   self->has_scanned = TRUE;
 
-  launcher = gbp_grep_model_create_launcher (self);
-  subprocess = ide_subprocess_launcher_spawn (launcher, cancellable, &error);
-
-  if (subprocess == NULL)
+  if (self->scanner == NULL && !gbp_grep_model_rebuild_scanner (self, &error))
     {
       ide_task_return_error (task, g_steal_pointer (&error));
       IDE_EXIT;
     }
 
-  ide_subprocess_communicate_utf8_async (subprocess,
-                                         NULL,
-                                         cancellable,
-                                         gbp_grep_model_scan_cb,
-                                         g_steal_pointer (&task));
+  workdir = ide_context_ref_workdir (self->context);
+  root = self->directory ? g_object_ref (self->directory) : g_object_ref (workdir);
+
+  if (!(root_path = g_file_get_path (root)))
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_NOT_SUPPORTED,
+                                 "Only local files may be searched");
+      IDE_EXIT;
+    }
+
+  vcs = ide_vcs_from_context (self->context);
+
+  scan = g_atomic_rc_box_new0 (Scan);
+  g_mutex_init (&scan->mutex);
+  scan->scanner = gbp_grep_scanner_ref (self->scanner);
+  scan->vcs = vcs ? g_object_ref (vcs) : NULL;
+  scan->root = g_steal_pointer (&root);
+  scan->root_path = g_steal_pointer (&root_path);
+  scan->cancellable = cancellable ? g_object_ref (cancellable) : g_cancellable_new ();
+  scan->pending = g_ptr_array_new_with_free_func (chunk_free);
+  scan->recursive = self->recursive;
+  scan->is_directory = g_file_query_file_type (scan->root, 0, NULL) == G_FILE_TYPE_DIRECTORY;
+
+  self->was_directory = scan->is_directory;
+  self->scan = g_atomic_rc_box_acquire (scan);
+  self->flush_source = g_timeout_add (FLUSH_INTERVAL_MSEC, gbp_grep_model_flush_cb, self);
+
+  ide_task_set_task_data (task, scan, (GDestroyNotify)scan_unref);
+  ide_task_run_in_thread (task, gbp_grep_model_scan_worker);
 
   IDE_EXIT;
 }
@@ -813,17 +1136,13 @@ gbp_grep_model_scan_finish (GbpGrepModel  *self,
 {
   g_return_val_if_fail (GBP_IS_GREP_MODEL (self), FALSE);
   g_return_val_if_fail (IDE_IS_TASK (result), FALSE);
-  g_return_val_if_fail (self->index == NULL, FALSE);
 
-  self->index = ide_task_propagate_pointer (IDE_TASK (result), error);
+  /* Merge whatever is left over from the scanner threads */
+  g_clear_handle_id (&self->flush_source, g_source_remove);
+  gbp_grep_model_flush (self);
+  g_clear_pointer (&self->scan, scan_unref);
 
-  /*
-   * Normally, we might emit ::row-inserted() for each row. But that
-   * is expensive and our normal use case is that we don't attach the
-   * model until the search has completed.
-   */
-
-  return self->index != NULL;
+  return ide_task_propagate_boolean (IDE_TASK (result), error);
 }
 
 void
@@ -833,6 +1152,9 @@ gbp_grep_model_select_all (GbpGrepModel *self)
 
   self->mode = MODE_ALL;
   g_hash_table_remove_all (self->toggled);
+
+  if (self->n_rows > 0)
+    g_list_model_items_changed (G_LIST_MODEL (self), 0, self->n_rows, self->n_rows);
 }
 
 void
@@ -842,19 +1164,38 @@ gbp_grep_model_select_none (GbpGrepModel *self)
 
   self->mode = MODE_NONE;
   g_hash_table_remove_all (self->toggled);
+
+  if (self->n_rows > 0)
+    g_list_model_items_changed (G_LIST_MODEL (self), 0, self->n_rows, self->n_rows);
 }
 
 void
 gbp_grep_model_toggle_row (GbpGrepModel *self,
-                           GtkTreeIter  *iter)
+                           guint         position)
 {
   g_return_if_fail (GBP_IS_GREP_MODEL (self));
-  g_return_if_fail (iter != NULL);
+  g_return_if_fail (position < self->n_rows);
 
-  if (g_hash_table_contains (self->toggled, iter->user_data))
-    g_hash_table_remove (self->toggled, iter->user_data);
+  if (g_hash_table_contains (self->toggled, GUINT_TO_POINTER (position)))
+    g_hash_table_remove (self->toggled, GUINT_TO_POINTER (position));
   else
-    g_hash_table_add (self->toggled, iter->user_data);
+    g_hash_table_add (self->toggled, GUINT_TO_POINTER (position));
+}
+
+gboolean
+gbp_grep_model_get_row_selected (GbpGrepModel *self,
+                                 guint         position)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GBP_IS_GREP_MODEL (self), FALSE);
+
+  ret = self->mode == MODE_ALL;
+
+  if (g_hash_table_contains (self->toggled, GUINT_TO_POINTER (position)))
+    ret = !ret;
+
+  return ret;
 }
 
 void
@@ -868,218 +1209,36 @@ gbp_grep_model_toggle_mode (GbpGrepModel *self)
     gbp_grep_model_select_all (self);
 }
 
-static GtkTreeModelFlags
-gbp_grep_model_get_flags (GtkTreeModel *tree_model)
-{
-  return GTK_TREE_MODEL_LIST_ONLY;
-}
-
-static gint
-gbp_grep_model_get_n_columns (GtkTreeModel *tree_model)
-{
-  return 2;
-}
-
 static GType
-gbp_grep_model_get_column_type (GtkTreeModel *tree_model,
-                                gint          index_)
-{
-  switch (index_) {
-  case 0:  return G_TYPE_STRING;
-  case 1:  return G_TYPE_BOOLEAN;
-  default: return G_TYPE_INVALID;
-  }
-}
-
-static gboolean
-gbp_grep_model_get_iter (GtkTreeModel *tree_model,
-                         GtkTreeIter  *iter,
-                         GtkTreePath  *path)
-{
-  GbpGrepModel *self = (GbpGrepModel *)tree_model;
-  gint *indicies;
-  gint depth;
-
-  g_assert (GBP_IS_GREP_MODEL (self));
-  g_assert (iter != NULL);
-  g_assert (path != NULL);
-
-  if (self->index == NULL || self->index->rows == NULL)
-    return FALSE;
-
-  indicies = gtk_tree_path_get_indices_with_depth (path, &depth);
-
-  if (depth != 1)
-    return FALSE;
-
-  iter->user_data = GINT_TO_POINTER (indicies[0]);
-
-  return indicies[0] >= 0 && indicies[0] < self->index->rows->len;
-}
-
-static GtkTreePath *
-gbp_grep_model_get_path (GtkTreeModel *tree_model,
-                         GtkTreeIter  *iter)
+gbp_grep_model_get_item_type (GListModel *model)
 {
-  g_assert (GBP_IS_GREP_MODEL (tree_model));
-  g_assert (iter != NULL);
-
-  return gtk_tree_path_new_from_indices (GPOINTER_TO_INT (iter->user_data), -1);
+  return GBP_TYPE_GREP_ITEM;
 }
 
-static void
-gbp_grep_model_get_value (GtkTreeModel *tree_model,
-                          GtkTreeIter  *iter,
-                          gint          column,
-                          GValue       *value)
+static guint
+gbp_grep_model_get_n_items (GListModel *model)
 {
-  GbpGrepModel *self = (GbpGrepModel *)tree_model;
-  guint index_;
-
-  g_assert (GBP_IS_GREP_MODEL (self));
-  g_assert (iter != NULL);
-  g_assert (column == 0 || column == 1);
-  g_assert (value != NULL);
-
-  index_ = GPOINTER_TO_UINT (iter->user_data);
-
-  if (column == 0)
-    {
-      g_value_init (value, G_TYPE_STRING);
-      /* This is a hack that we can do because we know that our
-       * consumer will only use the string for a short time to
-       * parse it into the real value without holding the GValue
-       * past the lifetime of the model.
-       *
-       * It saves us a serious amount of string copies.
-       */
-      g_value_set_static_string (value,
-                                 g_ptr_array_index (self->index->rows, index_));
-    }
-  else if (column == 1)
-    {
-      gboolean b = self->mode;
-      if (g_hash_table_contains (self->toggled, iter->user_data))
-        b = !b;
-      g_value_init (value, G_TYPE_BOOLEAN);
-      g_value_set_boolean (value, b);
-    }
+  return GBP_GREP_MODEL (model)->n_rows;
 }
 
-static gboolean
-gbp_grep_model_iter_next (GtkTreeModel *tree_model,
-                          GtkTreeIter  *iter)
+static gpointer
+gbp_grep_model_get_item (GListModel *model,
+                         guint       position)
 {
-  GbpGrepModel *self = (GbpGrepModel *)tree_model;
-  guint index_;
+  GbpGrepModel *self = GBP_GREP_MODEL (model);
 
-  g_assert (GBP_IS_GREP_MODEL (self));
+  if (position >= self->n_rows)
+    return NULL;
 
-  if (self->index == NULL)
-    return FALSE;
-
-  index_ = GPOINTER_TO_UINT (iter->user_data);
-  if (index_ == G_MAXUINT)
-    return FALSE;
-
-  index_++;
-
-  iter->user_data = GUINT_TO_POINTER (index_);
-
-  return index_ < self->index->rows->len;
-}
-
-static gboolean
-gbp_grep_model_iter_children (GtkTreeModel *tree_model,
-                              GtkTreeIter  *iter,
-                              GtkTreeIter  *parent)
-{
-  GbpGrepModel *self = (GbpGrepModel *)tree_model;
-
-  g_assert (GBP_IS_GREP_MODEL (self));
-  g_assert (iter != NULL);
-
-  iter->user_data = NULL;
-
-  return parent == NULL &&
-         self->index != NULL &&
-         self->index->rows->len > 0;
-}
-
-static gboolean
-gbp_grep_model_iter_has_child (GtkTreeModel *tree_model,
-                               GtkTreeIter  *iter)
-{
-  GbpGrepModel *self = (GbpGrepModel *)tree_model;
-
-  g_assert (GBP_IS_GREP_MODEL (self));
-
-  if (iter == NULL)
-    return self->index != NULL && self->index->rows->len > 0;
-
-  return FALSE;
-}
-
-static gint
-gbp_grep_model_iter_n_children (GtkTreeModel *tree_model,
-                                GtkTreeIter  *iter)
-{
-  GbpGrepModel *self = (GbpGrepModel *)tree_model;
-
-  g_assert (GBP_IS_GREP_MODEL (self));
-
-  if (iter == NULL)
-    {
-      if (self->index != NULL)
-        return self->index->rows->len;
-    }
-
-  return 0;
-}
-
-static gboolean
-gbp_grep_model_iter_nth_child (GtkTreeModel *tree_model,
-                               GtkTreeIter  *iter,
-                               GtkTreeIter  *parent,
-                               gint          n)
-{
-  GbpGrepModel *self = (GbpGrepModel *)tree_model;
-
-  g_assert (GBP_IS_GREP_MODEL (self));
-  g_assert (iter != NULL);
-
-  if (parent == NULL && self->index != NULL)
-    {
-      iter->user_data = GUINT_TO_POINTER (n);
-      return n < self->index->rows->len;
-    }
-
-  return FALSE;
-}
-
-static gboolean
-gbp_grep_model_iter_parent (GtkTreeModel *tree_model,
-                            GtkTreeIter  *iter,
-                            GtkTreeIter  *parent)
-{
-  return FALSE;
+  return gbp_grep_item_new (position);
 }
 
 static void
-tree_model_iface_init (GtkTreeModelIface *iface)
+list_model_iface_init (GListModelInterface *iface)
 {
-  iface->get_flags = gbp_grep_model_get_flags;
-  iface->get_n_columns = gbp_grep_model_get_n_columns;
-  iface->get_column_type = gbp_grep_model_get_column_type;
-  iface->get_iter = gbp_grep_model_get_iter;
-  iface->get_path = gbp_grep_model_get_path;
-  iface->get_value = gbp_grep_model_get_value;
-  iface->iter_next = gbp_grep_model_iter_next;
-  iface->iter_children = gbp_grep_model_iter_children;
-  iface->iter_has_child = gbp_grep_model_iter_has_child;
-  iface->iter_n_children = gbp_grep_model_iter_n_children;
-  iface->iter_nth_child = gbp_grep_model_iter_nth_child;
-  iface->iter_parent = gbp_grep_model_iter_parent;
+  iface->get_item_type = gbp_grep_model_get_item_type;
+  iface->get_n_items = gbp_grep_model_get_n_items;
+  iface->get_item = gbp_grep_model_get_item;
 }
 
 static void
@@ -1090,9 +1249,6 @@ gbp_grep_model_foreach_selected (GbpGrepModel *self,
   g_assert (GBP_IS_GREP_MODEL (self));
   g_assert (callback != NULL);
 
-  if (self->index == NULL)
-    return;
-
   if (self->mode == MODE_NONE)
     {
       GHashTableIter iter;
@@ -1104,9 +1260,9 @@ gbp_grep_model_foreach_selected (GbpGrepModel *self,
     }
   else if (self->mode == MODE_ALL)
     {
-      for (guint i = 0; i < self->index->rows->len; i++)
+      for (guint i = 0; i < self->n_rows; i++)
         {
-          if (!g_hash_table_contains (self->toggled, GINT_TO_POINTER (i)))
+          if (!g_hash_table_contains (self->toggled, GUINT_TO_POINTER (i)))
             callback (self, i, user_data);
         }
     }
@@ -1121,40 +1277,40 @@ create_edits_cb (GbpGrepModel *self,
 {
   GPtrArray *edits = user_data;
   GbpGrepModelLine line = {0};
-  const gchar *row;
+  g_autoptr(GFile) file = NULL;
+  const Chunk *chunk;
+  const Row *row;
+  guint lineno;
 
   g_assert (GBP_IS_GREP_MODEL (self));
-  g_assert (self->message_regex != NULL);
+  g_assert (self->scanner != NULL);
   g_assert (edits != NULL);
 
-  row = g_ptr_array_index (self->index->rows, index_);
+  if (!gbp_grep_model_lookup (self, index_, &chunk, &row))
+    return;
 
-  if (gbp_grep_model_line_parse (&line, row, self->message_regex))
-    {
-      g_autoptr(GFile) file = NULL;
-      guint lineno;
+  gbp_grep_model_line_parse (self, &line, chunk, row, gbp_grep_scanner_get_regex (self->scanner));
 
-      file = gbp_grep_model_get_file (self, line.path);
-      g_assert (G_IS_FILE (file));
+  file = gbp_grep_model_get_file (self, line.path);
+  g_assert (G_IS_FILE (file));
 
-      lineno = line.line ? line.line - 1 : 0;
+  lineno = line.line ? line.line - 1 : 0;
 
-      for (guint i = 0; i < line.matches->len; i++)
-        {
-          const GbpGrepModelMatch *match = &g_array_index (line.matches, GbpGrepModelMatch, i);
-          g_autoptr(IdeTextEdit) edit = NULL;
-          g_autoptr(IdeRange) range = NULL;
-          g_autoptr(IdeLocation) begin = NULL;
-          g_autoptr(IdeLocation) end = NULL;
+  for (guint i = 0; i < line.matches->len; i++)
+    {
+      const GbpGrepModelMatch *match = &g_array_index (line.matches, GbpGrepModelMatch, i);
+      g_autoptr(IdeTextEdit) edit = NULL;
+      g_autoptr(IdeRange) range = NULL;
+      g_autoptr(IdeLocation) begin = NULL;
+      g_autoptr(IdeLocation) end = NULL;
 
-          begin = ide_location_new (file, lineno, match->match_begin);
-          end = ide_location_new (file, lineno, match->match_end);
-          range = ide_range_new (begin, end);
+      begin = ide_location_new (file, lineno, match->match_begin);
+      end = ide_location_new (file, lineno, match->match_end);
+      range = ide_range_new (begin, end);
 
-          edit = ide_text_edit_new (range, NULL);
+      edit = ide_text_edit_new (range, NULL);
 
-          g_ptr_array_add (edits, g_steal_pointer (&edit));
-        }
+      g_ptr_array_add (edits, g_steal_pointer (&edit));
     }
 
   clear_line (&line);
@@ -1173,11 +1329,8 @@ gbp_grep_model_create_edits (GbpGrepModel *self)
 
   g_return_val_if_fail (GBP_IS_GREP_MODEL (self), NULL);
 
-  if (self->message_regex == NULL)
-    {
-      if (!gbp_grep_model_rebuild_regex (self))
-        return NULL;
-    }
+  if (self->scanner == NULL)
+    return NULL;
 
   edits = g_ptr_array_new_with_free_func (g_object_unref);
   gbp_grep_model_foreach_selected (self, create_edits_cb, edits);
@@ -1188,43 +1341,37 @@ gbp_grep_model_create_edits (GbpGrepModel *self)
 /**
  * gbp_grep_model_get_line:
  * @self: a #GbpGrepModel
- * @iter: a #GtkTextIter
+ * @position: the position of the row
  * @line: (out): a location for the line info
  *
- * Gets information about the line that @iter points at.
+ * Gets information about the line at @position.
  */
 void
 gbp_grep_model_get_line (GbpGrepModel            *self,
-                         GtkTreeIter             *iter,
+                         guint                    position,
                          const GbpGrepModelLine **line)
 {
-  const gchar *str;
-  guint index_;
+  const Chunk *chunk;
+  const Row *row;
 
   g_return_if_fail (GBP_IS_GREP_MODEL (self));
-  g_return_if_fail (iter != NULL);
   g_return_if_fail (line != NULL);
-  g_return_if_fail (self->index != NULL);
-  g_return_if_fail (self->index->rows != NULL);
 
   *line = NULL;
 
-  index_ = GPOINTER_TO_UINT (iter->user_data);
-  g_return_if_fail (index_ < self->index->rows->len);
-
-  str = g_ptr_array_index (self->index->rows, index_);
+  if (self->scanner == NULL ||
+      !gbp_grep_model_lookup (self, position, &chunk, &row))
+    return;
 
-  if (str != self->prev_line.start_of_line)
+  if (row != self->prev_row)
     {
       clear_line (&self->prev_line);
-
-      if (self->message_regex == NULL)
-        {
-          if (!gbp_grep_model_rebuild_regex (self))
-            return;
-        }
-
-      gbp_grep_model_line_parse (&self->prev_line, str, self->message_regex);
+      self->prev_row = row;
+      gbp_grep_model_line_parse (self,
+                                 &self->prev_line,
+                                 chunk,
+                                 row,
+                                 gbp_grep_scanner_get_regex (self->scanner));
     }
 
   *line = &self->prev_line;
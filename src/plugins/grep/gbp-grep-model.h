@@ -38,6 +38,7 @@ typedef struct
 {
   const gchar *start_of_line;
   const gchar *start_of_message;
+  gchar       *text;
   gchar       *path;
   GArray      *matches;
   guint        line;
@@ -69,10 +70,13 @@ void          gbp_grep_model_select_all             (GbpGrepModel            *se
 void          gbp_grep_model_select_none            (GbpGrepModel            *self);
 void          gbp_grep_model_toggle_mode            (GbpGrepModel            *self);
 void          gbp_grep_model_toggle_row             (GbpGrepModel            *self,
-                                                     GtkTreeIter             *iter);
+                                                     guint                    position);
+gboolean      gbp_grep_model_get_row_selected       (GbpGrepModel            *self,
+                                                     guint                    position);
 void          gbp_grep_model_get_line               (GbpGrepModel            *self,
-                                                     GtkTreeIter             *iter,
+                                                     guint                    position,
                                                      const GbpGrepModelLine **line);
+gboolean      gbp_grep_model_get_truncated          (GbpGrepModel            *self);
 GFile        *gbp_grep_model_get_file               (GbpGrepModel            *self,
                                                      const gchar             *path);
 void          gbp_grep_model_scan_async             (GbpGrepModel            *self,
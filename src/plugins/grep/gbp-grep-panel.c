@@ -28,6 +28,7 @@
 #include <libide-editor.h>
 #include <libide-gui.h>
 
+#include "gbp-grep-item.h"
 #include "gbp-grep-panel.h"
 
 #define I_ g_intern_string
@@ -39,8 +40,8 @@ struct _GbpGrepPanel
   GCancellable      *cancellable;
 
   /* Unowned references */
-  GtkTreeView       *tree_view;
-  GtkTreeViewColumn *toggle_column;
+  GtkColumnView     *column_view;
+  GtkNoSelection    *selection;
   GtkCheckButton    *check;
 
   GtkStack          *stack;
@@ -71,23 +72,46 @@ G_DEFINE_FINAL_TYPE (GbpGrepPanel, gbp_grep_panel, IDE_TYPE_PANE)
 
 static GParamSpec *properties [N_PROPS];
 
+static guint
+list_item_get_position (GtkListItem *list_item)
+{
+  GbpGrepItem *item = gtk_list_item_get_item (list_item);
+
+  g_assert (GBP_IS_GREP_ITEM (item));
+
+  return gbp_grep_item_get_position (item);
+}
+
+static void
+match_setup_cb (GtkSignalListItemFactory *factory,
+                GtkListItem              *list_item,
+                GbpGrepPanel             *self)
+{
+  gtk_list_item_set_child (list_item,
+                           g_object_new (GTK_TYPE_LABEL,
+                                         "ellipsize", PANGO_ELLIPSIZE_END,
+                                         "xalign", 0.0f,
+                                         NULL));
+}
+
 static void
-match_data_func (GtkCellLayout   *layout,
-                 GtkCellRenderer *cell,
-                 GtkTreeModel    *model,
-                 GtkTreeIter     *iter,
-                 gpointer         user_data)
+match_bind_cb (GtkSignalListItemFactory *factory,
+               GtkListItem              *list_item,
+               GbpGrepPanel             *self)
 {
   const GbpGrepModelLine *line = NULL;
   PangoAttrList *attrs = NULL;
   const gchar *begin = NULL;
+  GtkLabel *label;
 
-  g_assert (GTK_IS_CELL_LAYOUT (layout));
-  g_assert (GTK_IS_CELL_RENDERER_TEXT (cell));
-  g_assert (GTK_IS_TREE_MODEL (model));
-  g_assert (iter != NULL);
+  g_assert (GTK_IS_SIGNAL_LIST_ITEM_FACTORY (factory));
+  g_assert (GTK_IS_LIST_ITEM (list_item));
+  g_assert (GBP_IS_GREP_PANEL (self));
 
-  gbp_grep_model_get_line (GBP_GREP_MODEL (model), iter, &line);
+  label = GTK_LABEL (gtk_list_item_get_child (list_item));
+  gbp_grep_model_get_line (gbp_grep_panel_get_model (self),
+                           list_item_get_position (list_item),
+                           &line);
 
   if G_LIKELY (line != NULL)
     {
@@ -139,29 +163,41 @@ match_data_func (GtkCellLayout   *layout,
         }
     }
 
-  g_object_set (cell,
-                "attributes", attrs,
-                "text", begin,
-                NULL);
+  gtk_label_set_text (label, begin);
+  gtk_label_set_attributes (label, attrs);
 
   g_clear_pointer (&attrs, pango_attr_list_unref);
 }
 
 static void
-path_data_func (GtkCellLayout   *layout,
-                GtkCellRenderer *cell,
-                GtkTreeModel    *model,
-                GtkTreeIter     *iter,
-                gpointer         user_data)
+path_setup_cb (GtkSignalListItemFactory *factory,
+               GtkListItem              *list_item,
+               GbpGrepPanel             *self)
+{
+  gtk_list_item_set_child (list_item,
+                           g_object_new (GTK_TYPE_LABEL,
+                                         "ellipsize", PANGO_ELLIPSIZE_END,
+                                         "width-chars", 20,
+                                         "xalign", 0.0f,
+                                         NULL));
+}
+
+static void
+path_bind_cb (GtkSignalListItemFactory *factory,
+              GtkListItem              *list_item,
+              GbpGrepPanel             *self)
 {
   const GbpGrepModelLine *line = NULL;
+  GtkLabel *label;
 
-  g_assert (GTK_IS_CELL_LAYOUT (layout));
-  g_assert (GTK_IS_CELL_RENDERER_TEXT (cell));
-  g_assert (GTK_IS_TREE_MODEL (model));
-  g_assert (iter != NULL);
+  g_assert (GTK_IS_SIGNAL_LIST_ITEM_FACTORY (factory));
+  g_assert (GTK_IS_LIST_ITEM (list_item));
+  g_assert (GBP_IS_GREP_PANEL (self));
 
-  gbp_grep_model_get_line (GBP_GREP_MODEL (model), iter, &line);
+  label = GTK_LABEL (gtk_list_item_get_child (list_item));
+  gbp_grep_model_get_line (gbp_grep_panel_get_model (self),
+                           list_item_get_position (list_item),
+                           &line);
 
   if G_LIKELY (line != NULL)
     {
@@ -170,29 +206,41 @@ path_data_func (GtkCellLayout   *layout,
       if (slash != NULL)
         {
           g_autofree gchar *path = g_strndup (line->path, slash - line->path);
-          g_object_set (cell, "text", path, NULL);
+          gtk_label_set_text (label, path);
           return;
         }
     }
 
-  g_object_set (cell, "text", ".", NULL);
+  gtk_label_set_text (label, ".");
+}
+
+static void
+filename_setup_cb (GtkSignalListItemFactory *factory,
+                   GtkListItem              *list_item,
+                   GbpGrepPanel             *self)
+{
+  gtk_list_item_set_child (list_item,
+                           g_object_new (GTK_TYPE_LABEL,
+                                         "xalign", 0.0f,
+                                         NULL));
 }
 
 static void
-filename_data_func (GtkCellLayout   *layout,
-                    GtkCellRenderer *cell,
-                    GtkTreeModel    *model,
-                    GtkTreeIter     *iter,
-                    gpointer         user_data)
+filename_bind_cb (GtkSignalListItemFactory *factory,
+                  GtkListItem              *list_item,
+                  GbpGrepPanel             *self)
 {
   const GbpGrepModelLine *line = NULL;
+  GtkLabel *label;
 
-  g_assert (GTK_IS_CELL_LAYOUT (layout));
-  g_assert (GTK_IS_CELL_RENDERER_TEXT (cell));
-  g_assert (GTK_IS_TREE_MODEL (model));
-  g_assert (iter != NULL);
+  g_assert (GTK_IS_SIGNAL_LIST_ITEM_FACTORY (factory));
+  g_assert (GTK_IS_LIST_ITEM (list_item));
+  g_assert (GBP_IS_GREP_PANEL (self));
 
-  gbp_grep_model_get_line (GBP_GREP_MODEL (model), iter, &line);
+  label = GTK_LABEL (gtk_list_item_get_child (list_item));
+  gbp_grep_model_get_line (gbp_grep_panel_get_model (self),
+                           list_item_get_position (list_item),
+                           &line);
 
   if G_LIKELY (line != NULL)
     {
@@ -206,102 +254,121 @@ filename_data_func (GtkCellLayout   *layout,
         shortpath = line->path;
 
       formatted = g_strdup_printf ("%s:%u", shortpath, line->line);
-      g_object_set (cell, "text", formatted, NULL);
+      gtk_label_set_text (label, formatted);
 
       return;
     }
 
-  g_object_set (cell, "text", NULL, NULL);
+  gtk_label_set_text (label, NULL);
 }
 
 static void
-gbp_grep_panel_row_activated_cb (GbpGrepPanel      *self,
-                                 GtkTreePath       *path,
-                                 GtkTreeViewColumn *column,
-                                 GtkTreeView       *tree_view)
+gbp_grep_panel_row_toggled_cb (GtkCheckButton *button,
+                               GtkListItem    *list_item)
 {
-  GtkTreeModel *model;
-  GtkTreeIter iter;
+  GbpGrepPanel *self;
 
-  g_assert (GBP_IS_GREP_PANEL (self));
-  g_assert (path != NULL);
-  g_assert (GTK_IS_TREE_VIEW_COLUMN (column));
-  g_assert (GTK_IS_TREE_VIEW (tree_view));
+  g_assert (GTK_IS_CHECK_BUTTON (button));
+  g_assert (GTK_IS_LIST_ITEM (list_item));
 
-  /* Ignore if this is the toggle checkbox column */
-  if (column == self->toggle_column)
-    return;
+  self = GBP_GREP_PANEL (gtk_widget_get_ancestor (GTK_WIDGET (button), GBP_TYPE_GREP_PANEL));
 
-  if ((model = gtk_tree_view_get_model (tree_view)) &&
-      gtk_tree_model_get_iter (model, &iter, path))
-    {
-      const GbpGrepModelLine *line = NULL;
+  gbp_grep_model_toggle_row (gbp_grep_panel_get_model (self),
+                             list_item_get_position (list_item));
+}
 
-      gbp_grep_model_get_line (GBP_GREP_MODEL (model), &iter, &line);
+static void
+toggle_setup_cb (GtkSignalListItemFactory *factory,
+                 GtkListItem              *list_item,
+                 GbpGrepPanel             *self)
+{
+  GtkWidget *check;
 
-      if G_LIKELY (line != NULL)
-        {
-          g_autoptr(IdeLocation) location = NULL;
-          g_autoptr(PanelPosition) position = NULL;
-          g_autoptr(GFile) child = NULL;
-          IdeWorkspace *workspace;
-          guint lineno = line->line;
+  check = g_object_new (GTK_TYPE_CHECK_BUTTON,
+                        "margin-start", 6,
+                        "margin-end", 6,
+                        NULL);
+  g_signal_connect_object (check,
+                           "toggled",
+                           G_CALLBACK (gbp_grep_panel_row_toggled_cb),
+                           list_item,
+                           0);
+  gtk_list_item_set_child (list_item, check);
+}
 
-          workspace = ide_widget_get_workspace (GTK_WIDGET (self));
+static void
+toggle_bind_cb (GtkSignalListItemFactory *factory,
+                GtkListItem              *list_item,
+                GbpGrepPanel             *self)
+{
+  GtkWidget *check;
 
-          if (lineno > 0)
-            lineno--;
+  g_assert (GTK_IS_SIGNAL_LIST_ITEM_FACTORY (factory));
+  g_assert (GTK_IS_LIST_ITEM (list_item));
+  g_assert (GBP_IS_GREP_PANEL (self));
 
-          child = gbp_grep_model_get_file (GBP_GREP_MODEL (model), line->path);
-          location = ide_location_new (child, lineno, -1);
+  check = gtk_list_item_get_child (list_item);
 
-          position = panel_position_new ();
-          ide_editor_focus_location (workspace, position, location);
-        }
-    }
+  g_signal_handlers_block_by_func (check, G_CALLBACK (gbp_grep_panel_row_toggled_cb), list_item);
+  gtk_check_button_set_active (GTK_CHECK_BUTTON (check),
+                               gbp_grep_model_get_row_selected (gbp_grep_panel_get_model (self),
+                                                                list_item_get_position (list_item)));
+  g_signal_handlers_unblock_by_func (check, G_CALLBACK (gbp_grep_panel_row_toggled_cb), list_item);
 }
 
 static void
-gbp_grep_panel_row_toggled_cb (GbpGrepPanel          *self,
-                               const gchar           *pathstr,
-                               GtkCellRendererToggle *toggle)
+gbp_grep_panel_activate_cb (GbpGrepPanel  *self,
+                            guint          position,
+                            GtkColumnView *column_view)
 {
-  GtkTreeModel *model;
-  GtkTreePath *path;
-  GtkTreeIter iter;
+  const GbpGrepModelLine *line = NULL;
+  GbpGrepModel *model;
 
   g_assert (GBP_IS_GREP_PANEL (self));
-  g_assert (pathstr != NULL);
-  g_assert (GTK_IS_CELL_RENDERER_TOGGLE (toggle));
+  g_assert (GTK_IS_COLUMN_VIEW (column_view));
+
+  if (!(model = gbp_grep_panel_get_model (self)))
+    return;
 
-  path = gtk_tree_path_new_from_string (pathstr);
-  model = gtk_tree_view_get_model (self->tree_view);
+  gbp_grep_model_get_line (model, position, &line);
 
-  if (gtk_tree_model_get_iter (model, &iter, path))
+  if G_LIKELY (line != NULL)
     {
-      gbp_grep_model_toggle_row (GBP_GREP_MODEL (model), &iter);
-      gtk_widget_queue_resize (GTK_WIDGET (self->tree_view));
-    }
+      g_autoptr(IdeLocation) location = NULL;
+      g_autoptr(PanelPosition) panel_position = NULL;
+      g_autoptr(GFile) child = NULL;
+      IdeWorkspace *workspace;
+      guint lineno = line->line;
+
+      workspace = ide_widget_get_workspace (GTK_WIDGET (self));
 
-  g_clear_pointer (&path, gtk_tree_path_free);
+      if (lineno > 0)
+        lineno--;
+
+      child = gbp_grep_model_get_file (model, line->path);
+      location = ide_location_new (child, lineno, -1);
+
+      panel_position = panel_position_new ();
+      ide_editor_focus_location (workspace, panel_position, location);
+    }
 }
 
 static void
-gbp_grep_panel_toggle_all_cb (GbpGrepPanel      *self,
-                              GtkTreeViewColumn *column)
+gbp_grep_panel_toggle_all_cb (GbpGrepPanel   *self,
+                              GtkCheckButton *check)
 {
-  GtkCheckButton *toggle;
-  GtkTreeModel *model;
+  GbpGrepModel *model;
 
   g_assert (GBP_IS_GREP_PANEL (self));
-  g_assert (GTK_IS_TREE_VIEW_COLUMN (column));
+  g_assert (GTK_IS_CHECK_BUTTON (check));
 
-  toggle = GTK_CHECK_BUTTON (self->check);
-  gtk_check_button_set_active (toggle, !gtk_check_button_get_active (toggle));
+  if (!(model = gbp_grep_panel_get_model (self)))
+    return;
 
-  model = gtk_tree_view_get_model (self->tree_view);
-  gbp_grep_model_toggle_mode (GBP_GREP_MODEL (model));
-  gtk_widget_queue_resize (GTK_WIDGET (self->tree_view));
+  if (gtk_check_button_get_active (check))
+    gbp_grep_model_select_all (model);
+  else
+    gbp_grep_model_select_none (model);
 }
 
 static void
@@ -336,7 +403,7 @@ gbp_grep_panel_replace_clicked_cb (GbpGrepPanel *self,
   g_assert (GBP_IS_GREP_PANEL (self));
   g_assert (GTK_IS_BUTTON (button));
 
-  edits = gbp_grep_model_create_edits (GBP_GREP_MODEL (gtk_tree_view_get_model (self->tree_view)));
+  edits = gbp_grep_model_create_edits (gbp_grep_panel_get_model (self));
   if (edits == NULL || edits->len == 0)
     return;
 
@@ -440,25 +507,50 @@ gbp_grep_panel_scan_cb (GObject      *object,
         ide_object_warning (ide_widget_get_context (GTK_WIDGET (self)),
                             "Failed to find files: %s", error->message);
     }
-  else
-    gbp_grep_panel_set_model (self, model);
+  else if (gbp_grep_model_get_truncated (model))
+    {
+      ide_object_message (ide_widget_get_context (GTK_WIDGET (self)),
+                          _("Search stopped after %u matching lines"),
+                          g_list_model_get_n_items (G_LIST_MODEL (model)));
+    }
 
   g_clear_object (&self->cancellable);
 
   gtk_spinner_stop (self->spinner);
   gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->scrolled_window));
 
-  /* The model defaults to selecting all items, so if the "Select all" header check box was
-   * unselected, then we'll end up in an inconsistent state where toggling the header check
-   * box will unselect the items when it should have selected all of them. To avoid this,
-   * just set back the "Select all" check box to "selected" when starting a new search.
-   */
-  gtk_check_button_set_active (GTK_CHECK_BUTTON (self->check), TRUE);
+  if (model == gbp_grep_panel_get_model (self))
+    {
+      gboolean has_item = g_list_model_get_n_items (G_LIST_MODEL (model)) > 0;
+
+      gtk_widget_set_sensitive (GTK_WIDGET (self->replace_button), has_item);
+      gtk_widget_set_sensitive (GTK_WIDGET (self->replace_entry), has_item);
+    }
 
   panel_widget_raise (PANEL_WIDGET (self));
   gtk_widget_grab_focus (GTK_WIDGET (self->replace_entry));
 }
 
+static void
+gbp_grep_panel_items_changed_cb (GbpGrepPanel *self,
+                                 guint         position,
+                                 guint         removed,
+                                 guint         added,
+                                 GListModel   *model)
+{
+  g_assert (GBP_IS_GREP_PANEL (self));
+  g_assert (G_IS_LIST_MODEL (model));
+
+  /* Show results as soon as the first ones stream in rather than waiting
+   * for the whole tree to be scanned.
+   */
+  if (added > 0 && model == G_LIST_MODEL (gbp_grep_panel_get_model (self)))
+    {
+      gtk_spinner_stop (self->spinner);
+      gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->scrolled_window));
+    }
+}
+
 /**
  * gbp_grep_panel_launch_search:
  * @self: a #GbpGrepPanel
@@ -469,19 +561,20 @@ gbp_grep_panel_scan_cb (GObject      *object,
 void
 gbp_grep_panel_launch_search (GbpGrepPanel *self)
 {
-  GbpGrepModel *model;
+  g_autoptr(GbpGrepModel) model = NULL;
   g_autoptr(GFile) root_dir = NULL;
+  GbpGrepModel *old_model;
 
   g_assert (GBP_IS_GREP_PANEL (self));
 
-  model = gbp_grep_panel_get_model (self);
+  old_model = gbp_grep_panel_get_model (self);
   /* Nothing's really reusable between search operations (and it isn't allowed anyway by
    * gbp_grep_model_scan_async()), so just start from a new one. The only part we keep
    * from it is the search directory because we can't modify it in the UI and so the
    * only place where it's actually stored is the (old) model.
    */
-  if (model)
-    root_dir = gbp_grep_model_get_directory (model);
+  if (old_model)
+    root_dir = gbp_grep_model_get_directory (old_model);
   if (root_dir)
     g_object_ref (root_dir);
   model = gbp_grep_model_new (ide_widget_get_context (GTK_WIDGET (self)));
@@ -494,6 +587,23 @@ gbp_grep_panel_launch_search (GbpGrepPanel *self)
 
   gbp_grep_model_set_recursive (model, gtk_check_button_get_active (GTK_CHECK_BUTTON (self->recursive_button)));
 
+  /* Results are streamed into the model while the search is running, so
+   * attach it right away. Rows show up as soon as the first ones arrive.
+   */
+  g_signal_connect_object (model,
+                           "items-changed",
+                           G_CALLBACK (gbp_grep_panel_items_changed_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+  gbp_grep_panel_set_model (self, model);
+
+  /* The model defaults to selecting all items, so if the "Select all" check box was
+   * unselected, then we'll end up in an inconsistent state where toggling the check
+   * box will unselect the items when it should have selected all of them. To avoid this,
+   * just set back the "Select all" check box to "selected" when starting a new search.
+   */
+  gtk_check_button_set_active (GTK_CHECK_BUTTON (self->check), TRUE);
+
   gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->spinner));
   gtk_spinner_start (self->spinner);
   gtk_widget_set_sensitive (GTK_WIDGET (self->replace_button), FALSE);
@@ -503,7 +613,7 @@ gbp_grep_panel_launch_search (GbpGrepPanel *self)
   gtk_widget_grab_focus (GTK_WIDGET (self));
 
   /* We allow making a new search even if there's already one running, but cancel the previous
-   * one to make sure it doesn't needlessly use resources for the grep process that's still
+   * one to make sure it doesn't needlessly use resources for the scan that's still
    * running. Useful for example when you realize that your regex is going to match almost
    * every single lines of the source tree and so it will never end…
    */
@@ -631,7 +741,9 @@ gbp_grep_panel_class_init (GbpGrepPanelClass *klass)
 
   gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, stack);
   gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, scrolled_window);
-  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, tree_view);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, column_view);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, selection);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, check);
   gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, spinner);
 
   gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, replace_button);
@@ -646,6 +758,28 @@ gbp_grep_panel_class_init (GbpGrepPanelClass *klass)
   gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, close_button);
 }
 
+static void
+gbp_grep_panel_append_column (GbpGrepPanel *self,
+                              const char   *title,
+                              gboolean      expand,
+                              GCallback     setup,
+                              GCallback     bind)
+{
+  g_autoptr(GtkListItemFactory) factory = NULL;
+  g_autoptr(GtkColumnViewColumn) column = NULL;
+
+  g_assert (GBP_IS_GREP_PANEL (self));
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", setup, self);
+  g_signal_connect (factory, "bind", bind, self);
+
+  column = gtk_column_view_column_new (title, g_steal_pointer (&factory));
+  gtk_column_view_column_set_expand (column, expand);
+  gtk_column_view_column_set_resizable (column, title != NULL);
+  gtk_column_view_append_column (self->column_view, column);
+}
+
 static const GActionEntry actions[] = {
   { "close-panel", gbp_grep_panel_close_panel_action },
 };
@@ -654,8 +788,6 @@ static void
 gbp_grep_panel_init (GbpGrepPanel *self)
 {
   g_autoptr(GSimpleActionGroup) group = NULL;
-  GtkTreeViewColumn *column;
-  GtkCellRenderer *cell;
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
@@ -701,74 +833,23 @@ gbp_grep_panel_init (GbpGrepPanel *self)
                            self,
                            G_CONNECT_SWAPPED);
 
-  g_signal_connect_object (self->tree_view,
-                           "row-activated",
-                           G_CALLBACK (gbp_grep_panel_row_activated_cb),
+  g_signal_connect_object (self->column_view,
+                           "activate",
+                           G_CALLBACK (gbp_grep_panel_activate_cb),
                            self,
                            G_CONNECT_SWAPPED);
 
-  self->check = g_object_new (GTK_TYPE_CHECK_BUTTON,
-                              "margin-bottom", 3,
-                              "margin-end", 6,
-                              "margin-start", 6,
-                              "margin-top", 3,
-                              "active", TRUE,
-                              NULL);
-  self->toggle_column = g_object_new (GTK_TYPE_TREE_VIEW_COLUMN,
-                                      "visible", TRUE,
-                                      "clickable", TRUE,
-                                      "widget", self->check,
-                                      NULL);
-  g_signal_connect_object (self->toggle_column,
-                           "clicked",
-                           G_CALLBACK (gbp_grep_panel_toggle_all_cb),
-                           self,
-                           G_CONNECT_SWAPPED);
-  cell = g_object_new (GTK_TYPE_CELL_RENDERER_TOGGLE,
-                       "activatable", TRUE,
-                       NULL);
-  g_signal_connect_object (cell,
+  g_signal_connect_object (self->check,
                            "toggled",
-                           G_CALLBACK (gbp_grep_panel_row_toggled_cb),
+                           G_CALLBACK (gbp_grep_panel_toggle_all_cb),
                            self,
                            G_CONNECT_SWAPPED);
-  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (self->toggle_column), cell, TRUE);
-  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (self->toggle_column), cell, "active", 1);
-  gtk_tree_view_column_set_expand (self->toggle_column, FALSE);
-  gtk_tree_view_append_column (self->tree_view, self->toggle_column);
-
-  column = gtk_tree_view_column_new ();
-  cell = gtk_cell_renderer_text_new ();
-  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (column), cell, TRUE);
-  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (column), cell, filename_data_func, NULL, NULL);
-  gtk_tree_view_column_set_title (column, _("Location"));
-  gtk_tree_view_column_set_expand (column, FALSE);
-  gtk_tree_view_column_set_resizable (column, TRUE);
-  gtk_tree_view_append_column (self->tree_view, column);
-
-  column = gtk_tree_view_column_new ();
-  cell = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
-                       "ellipsize", PANGO_ELLIPSIZE_END,
-                       NULL);
-  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (column), cell, TRUE);
+
+  gbp_grep_panel_append_column (self, NULL, FALSE, G_CALLBACK (toggle_setup_cb), G_CALLBACK (toggle_bind_cb));
+  gbp_grep_panel_append_column (self, _("Location"), FALSE, G_CALLBACK (filename_setup_cb), G_CALLBACK (filename_bind_cb));
   /* translators: the column header for the matches in the 'find in files' results */
-  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (column), cell, match_data_func, NULL, NULL);
-  gtk_tree_view_column_set_title (column, _("Match"));
-  gtk_tree_view_column_set_expand (column, TRUE);
-  gtk_tree_view_column_set_resizable (column, TRUE);
-  gtk_tree_view_append_column (self->tree_view, column);
-
-  column = gtk_tree_view_column_new ();
-  cell = g_object_new (GTK_TYPE_CELL_RENDERER_TEXT,
-                       "ellipsize", PANGO_ELLIPSIZE_END,
-                       "width-chars", 20,
-                       NULL);
-  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (column), cell, TRUE);
-  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (column), cell, path_data_func, NULL, NULL);
-  gtk_tree_view_column_set_title (column, _("Path"));
-  gtk_tree_view_column_set_expand (column, FALSE);
-  gtk_tree_view_column_set_resizable (column, TRUE);
-  gtk_tree_view_append_column (self->tree_view, column);
+  gbp_grep_panel_append_column (self, _("Match"), TRUE, G_CALLBACK (match_setup_cb), G_CALLBACK (match_bind_cb));
+  gbp_grep_panel_append_column (self, _("Path"), FALSE, G_CALLBACK (path_setup_cb), G_CALLBACK (path_bind_cb));
 }
 
 static char *
@@ -814,7 +895,7 @@ gbp_grep_panel_set_model (GbpGrepPanel *self,
       gboolean is_initial_panel = (search_directory == NULL);
       gboolean is_project_wide = (is_initial_panel || g_file_equal (workdir, search_directory));
 
-      gboolean has_item = (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (model), NULL) != 0);
+      gboolean has_item = (g_list_model_get_n_items (G_LIST_MODEL (model)) != 0);
 
       gtk_widget_set_sensitive (GTK_WIDGET (self->replace_button), has_item);
       gtk_widget_set_sensitive (GTK_WIDGET (self->replace_entry), has_item);
@@ -850,7 +931,7 @@ gbp_grep_panel_set_model (GbpGrepPanel *self,
                                    gbp_grep_model_get_recursive (model));
     }
 
-  gtk_tree_view_set_model (self->tree_view, GTK_TREE_MODEL (model));
+  gtk_no_selection_set_model (self->selection, G_LIST_MODEL (model));
 }
 
 /**
@@ -862,7 +943,7 @@ gbp_grep_panel_set_model (GbpGrepPanel *self,
 GbpGrepModel *
 gbp_grep_panel_get_model (GbpGrepPanel *self)
 {
-  return GBP_GREP_MODEL (gtk_tree_view_get_model (self->tree_view));
+  return GBP_GREP_MODEL (gtk_no_selection_get_model (self->selection));
 }
 
 GtkWidget *
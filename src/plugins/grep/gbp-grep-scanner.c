@@ -0,0 +1,338 @@
+/* gbp-grep-scanner.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-scanner"
+
+#include "config.h"
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <string.h>
+
+#include "gbp-grep-scanner.h"
+
+/* Same heuristic as GNU grep's -I, look for a NUL byte near the start of
+ * the file and treat it as binary content if we find one.
+ */
+#define BINARY_PROBE_LEN 8000
+
+struct _GbpGrepScanner
+{
+  /* Used to locate the matching lines when we cannot rely on the literal
+   * search alone (regex or whole-word queries) and by the model to locate
+   * the individual matches within a line for highlighting and edits.
+   */
+  GRegex *regex;
+
+  /* If the query is a literal, this is the raw query text which we use
+   * to discard files quickly with memmem()/memchr() before we ever need
+   * to run the regex engine (and validate UTF-8) over the contents. The
+   * libc implementations of those are vectorized on all the platforms
+   * we care about.
+   */
+  char *literal;
+  gsize literal_len;
+
+  /* If the literal alone is enough to locate matching lines */
+  guint literal_is_exact : 1;
+  guint case_sensitive : 1;
+};
+
+static void
+gbp_grep_scanner_finalize (gpointer data)
+{
+  GbpGrepScanner *self = data;
+
+  g_clear_pointer (&self->regex, g_regex_unref);
+  g_clear_pointer (&self->literal, g_free);
+}
+
+static gboolean
+is_ascii (const char *str)
+{
+  for (; *str; str++)
+    {
+      if ((guchar)*str >= 0x80)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+GbpGrepScanner *
+gbp_grep_scanner_new (const char  *query,
+                      gboolean     use_regex,
+                      gboolean     case_sensitive,
+                      gboolean     at_word_boundaries,
+                      GError     **error)
+{
+  GRegexCompileFlags compile_flags = G_REGEX_OPTIMIZE;
+  g_autoptr(GbpGrepScanner) self = NULL;
+  g_autofree char *escaped = NULL;
+  g_autofree char *bounded = NULL;
+  const char *pattern;
+
+  g_return_val_if_fail (query != NULL, NULL);
+  g_return_val_if_fail (query[0] != 0, NULL);
+
+  self = g_atomic_rc_box_new0 (GbpGrepScanner);
+  self->case_sensitive = !!case_sensitive;
+
+  if (use_regex)
+    pattern = query;
+  else
+    pattern = escaped = g_regex_escape_string (query, -1);
+
+  if (at_word_boundaries)
+    pattern = bounded = g_strdup_printf ("\\b(?:%s)\\b", pattern);
+
+  if (!case_sensitive)
+    compile_flags |= G_REGEX_CASELESS;
+
+  if (!(self->regex = g_regex_new (pattern, compile_flags, 0, error)))
+    return NULL;
+
+  /* Only ASCII can be folded with a simple byte comparison, anything else
+   * must go through the regex engine to get case-folding right. A literal
+   * spanning lines can never match as we match a line at a time.
+   */
+  if (!use_regex &&
+      (case_sensitive || is_ascii (query)) &&
+      strchr (query, '\n') == NULL)
+    {
+      self->literal = g_strdup (query);
+      self->literal_len = strlen (query);
+      self->literal_is_exact = !at_word_boundaries;
+    }
+
+  return g_steal_pointer (&self);
+}
+
+GbpGrepScanner *
+gbp_grep_scanner_ref (GbpGrepScanner *self)
+{
+  return g_atomic_rc_box_acquire (self);
+}
+
+void
+gbp_grep_scanner_unref (GbpGrepScanner *self)
+{
+  g_atomic_rc_box_release_full (self, gbp_grep_scanner_finalize);
+}
+
+/**
+ * gbp_grep_scanner_get_regex:
+ * @self: a #GbpGrepScanner
+ *
+ * Returns: (transfer none): a #GRegex
+ */
+GRegex *
+gbp_grep_scanner_get_regex (GbpGrepScanner *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return self->regex;
+}
+
+static const char *
+find_caseless (const char *haystack,
+               gsize       haystack_len,
+               const char *needle,
+               gsize       needle_len)
+{
+  const char *end = haystack + haystack_len;
+  const char *next_lower;
+  const char *next_upper;
+  char lower = g_ascii_tolower (needle[0]);
+  char upper = g_ascii_toupper (needle[0]);
+
+  /* Track the next candidate for each case separately so that a frequent
+   * lower-case byte does not cause us to rescan for a rare upper-case one
+   * over and over again.
+   */
+  next_lower = memchr (haystack, lower, haystack_len);
+  next_upper = lower != upper ? memchr (haystack, upper, haystack_len) : NULL;
+
+  while (next_lower != NULL || next_upper != NULL)
+    {
+      const char *candidate;
+
+      if (next_upper == NULL || (next_lower != NULL && next_lower < next_upper))
+        candidate = next_lower;
+      else
+        candidate = next_upper;
+
+      if (candidate + needle_len > end)
+        break;
+
+      if (g_ascii_strncasecmp (candidate, needle, needle_len) == 0)
+        return candidate;
+
+      if (candidate == next_lower)
+        next_lower = memchr (candidate + 1, lower, end - candidate - 1);
+      else
+        next_upper = memchr (candidate + 1, upper, end - candidate - 1);
+    }
+
+  return NULL;
+}
+
+static inline const char *
+find_literal (GbpGrepScanner *self,
+              const char     *data,
+              gsize           len)
+{
+  if (self->case_sensitive)
+    return memmem (data, len, self->literal, self->literal_len);
+  else
+    return find_caseless (data, len, self->literal, self->literal_len);
+}
+
+static gboolean
+line_matches (GbpGrepScanner *self,
+              const char     *line,
+              gsize           line_len)
+{
+  g_autofree char *valid = NULL;
+
+  if (self->literal_is_exact)
+    return TRUE;
+
+  /* GRegex requires valid UTF-8. Rather than skipping the whole file we
+   * match against a lossy copy of just this line, which is also how the
+   * model displays it.
+   */
+  if (!g_utf8_validate_len (line, line_len, NULL))
+    {
+      valid = g_utf8_make_valid (line, line_len);
+      line = valid;
+      line_len = strlen (valid);
+    }
+
+  return g_regex_match_full (self->regex, line, line_len, 0, 0, NULL, NULL);
+}
+
+static guint
+count_newlines (const char *data,
+                gsize       len)
+{
+  const char *end = data + len;
+  guint count = 0;
+
+  while ((data = memchr (data, '\n', end - data)))
+    {
+      count++;
+      data++;
+    }
+
+  return count;
+}
+
+/**
+ * gbp_grep_scanner_scan:
+ * @self: a #GbpGrepScanner
+ * @data: the file contents
+ * @len: the length of @data in bytes
+ * @func: a callback for each matching line
+ * @user_data: closure data for @func
+ *
+ * Locates every line in @data which matches the query. The query is
+ * matched against each line on its own, so a match never spans lines.
+ * @func is called once per line, even if the line contains multiple
+ * matches. Lines which are not valid UTF-8 are matched lossily.
+ *
+ * This function is safe to call from multiple threads at once.
+ *
+ * Returns: %FALSE if the contents were skipped (binary data or no
+ *   possible match), otherwise %TRUE.
+ */
+gboolean
+gbp_grep_scanner_scan (GbpGrepScanner     *self,
+                       const char         *data,
+                       gsize               len,
+                       GbpGrepScannerFunc  func,
+                       gpointer            user_data)
+{
+  const char *end = data + len;
+  const char *counted = data;
+  const char *pos = data;
+  guint lineno = 1;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  if (data == NULL || len == 0)
+    return FALSE;
+
+  if (memchr (data, 0, MIN (len, BINARY_PROBE_LEN)) != NULL)
+    return FALSE;
+
+  /* Fast path to discard the file without looking at lines */
+  if (self->literal != NULL && find_literal (self, data, len) == NULL)
+    return FALSE;
+
+  while (pos < end)
+    {
+      const char *line_begin = pos;
+      const char *line_end;
+      gsize line_len;
+
+      /* Skip straight to the next line containing the literal, if any,
+       * so that only those lines are handed to the regex engine.
+       */
+      if (self->literal != NULL)
+        {
+          const char *found = find_literal (self, pos, end - pos);
+
+          if (found == NULL)
+            break;
+
+          /* @pos is always the start of a line, so we never walk back past it */
+          if ((line_begin = memrchr (pos, '\n', found - pos)))
+            line_begin++;
+          else
+            line_begin = pos;
+
+          if (!(line_end = memchr (found, '\n', end - found)))
+            line_end = end;
+        }
+      else if (!(line_end = memchr (line_begin, '\n', end - line_begin)))
+        line_end = end;
+
+      line_len = line_end - line_begin;
+      if (line_len > 0 && line_begin[line_len - 1] == '\r')
+        line_len--;
+
+      if (line_len <= GBP_GREP_SCANNER_MAX_LINE_LEN &&
+          line_matches (self, line_begin, line_len))
+        {
+          lineno += count_newlines (counted, line_begin - counted);
+          counted = line_begin;
+
+          if (!func (line_begin, line_len, lineno, user_data))
+            break;
+        }
+
+      pos = line_end + 1;
+    }
+
+  return TRUE;
+}
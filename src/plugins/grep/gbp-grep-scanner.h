@@ -0,0 +1,65 @@
+/* gbp-grep-scanner.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Lines longer than this are skipped so that we do not pull pathological
+ * content (minified sources, generated data, etc) into the UI process.
+ */
+#define GBP_GREP_SCANNER_MAX_LINE_LEN 1024
+
+typedef struct _GbpGrepScanner GbpGrepScanner;
+
+/**
+ * GbpGrepScannerFunc:
+ * @line: the start of the matching line (not %NUL terminated, and not
+ *   necessarily valid UTF-8)
+ * @line_len: the length of @line in bytes, excluding the newline
+ * @lineno: the 1-based line number of @line
+ * @user_data: closure data
+ *
+ * Returns: %FALSE to stop scanning the current buffer
+ */
+typedef gboolean (*GbpGrepScannerFunc) (const char *line,
+                                        gsize       line_len,
+                                        guint       lineno,
+                                        gpointer    user_data);
+
+GbpGrepScanner *gbp_grep_scanner_new       (const char          *query,
+                                            gboolean             use_regex,
+                                            gboolean             case_sensitive,
+                                            gboolean             at_word_boundaries,
+                                            GError             **error);
+GbpGrepScanner *gbp_grep_scanner_ref       (GbpGrepScanner      *self);
+void            gbp_grep_scanner_unref     (GbpGrepScanner      *self);
+GRegex         *gbp_grep_scanner_get_regex (GbpGrepScanner      *self);
+gboolean        gbp_grep_scanner_scan      (GbpGrepScanner      *self,
+                                            const char          *data,
+                                            gsize                len,
+                                            GbpGrepScannerFunc   func,
+                                            gpointer             user_data);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GbpGrepScanner, gbp_grep_scanner_unref)
+
+G_END_DECLS
@@ -22,6 +22,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <libide-code.h>
 #include <libide-threading.h>
 
@@ -31,8 +33,27 @@ struct _GbpMarkdownHtmlGenerator
 {
   IdeHtmlGenerator parent_instance;
   GSignalGroup *buffer_signals;
+
+  /* The blocks as last delivered to the document, either by a full
+   * generation or a patch. Patches are diffed against these.
+   */
+  GPtrArray *blocks;
+  guint n_lines;
 };
 
+typedef struct
+{
+  /* 0-based line of the first line of the block */
+  guint line;
+
+  /* Number of lines from the first line of the block to the end of the
+   * document, used to detect when trailing blocks have only moved.
+   */
+  guint lines_to_end;
+
+  char *source;
+} Block;
+
 enum {
   PROP_0,
   PROP_BUFFER,
@@ -45,6 +66,314 @@ static char *markdown_html_prefix;
 static char *markdown_html_suffix;
 static GParamSpec *properties [N_PROPS];
 
+static void
+block_free (gpointer data)
+{
+  Block *block = data;
+
+  g_clear_pointer (&block->source, g_free);
+  g_slice_free (Block, block);
+}
+
+static inline gboolean
+is_blank (const char *line,
+          gsize       len)
+{
+  for (gsize i = 0; i < len; i++)
+    {
+      if (!g_ascii_isspace (line[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static inline gsize
+skip_indent (const char *line,
+             gsize       len)
+{
+  gsize i = 0;
+
+  while (i < len && i < 3 && line[i] == ' ')
+    i++;
+
+  return i;
+}
+
+static gboolean
+is_fence (const char *line,
+          gsize       len,
+          char       *fence_char,
+          gsize      *fence_len)
+{
+  gsize i = skip_indent (line, len);
+  gsize n = 0;
+
+  if (i >= len || (line[i] != '`' && line[i] != '~'))
+    return FALSE;
+
+  while (i + n < len && line[i + n] == line[i])
+    n++;
+
+  if (n < 3)
+    return FALSE;
+
+  /* Backtick fences may not contain backticks in the info string */
+  if (line[i] == '`' && memchr (line + i + n, '`', len - i - n))
+    return FALSE;
+
+  *fence_char = line[i];
+  *fence_len = n;
+
+  return TRUE;
+}
+
+static gboolean
+is_list_item (const char *line,
+              gsize       len)
+{
+  gsize i = skip_indent (line, len);
+  gsize digits = 0;
+
+  if (i + 1 < len && strchr ("-*+", line[i]) && line[i + 1] == ' ')
+    return TRUE;
+
+  while (i + digits < len && g_ascii_isdigit (line[i + digits]))
+    digits++;
+
+  i += digits;
+
+  return digits > 0 && i + 1 < len && (line[i] == '.' || line[i] == ')') && line[i + 1] == ' ';
+}
+
+static gboolean
+is_void_element (const char *name,
+                 gsize       len)
+{
+  static const char * const void_elements[] = {
+    "area", "base", "br", "col", "embed", "hr", "img",
+    "input", "link", "meta", "source", "track", "wbr",
+  };
+
+  for (guint i = 0; i < G_N_ELEMENTS (void_elements); i++)
+    {
+      if (strlen (void_elements[i]) == len &&
+          g_ascii_strncasecmp (name, void_elements[i], len) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * Tracks how a line starting with raw HTML opens or closes elements, so that
+ * elements such as <details> which commonly contain blank lines are not split
+ * across blocks. This only needs to be approximate, keeping too much in one
+ * block is always safe.
+ */
+static int
+html_depth_delta (const char *line,
+                  gsize       len)
+{
+  gsize i = skip_indent (line, len);
+  gsize name_len = 0;
+
+  if (i >= len || line[i] != '<')
+    return 0;
+
+  line += i + 1;
+  len -= i + 1;
+
+  if (len >= 3 && memcmp (line, "!--", 3) == 0)
+    return g_strstr_len (line, len, "-->") ? 0 : 1;
+
+  if (len >= 1 && line[0] == '/')
+    return -1;
+
+  while (name_len < len && g_ascii_isalnum (line[name_len]))
+    name_len++;
+
+  if (name_len == 0 ||
+      is_void_element (line, name_len) ||
+      g_strstr_len (line, len, "</") ||
+      g_strstr_len (line, len, "/>"))
+    return 0;
+
+  return 1;
+}
+
+static void
+add_block (GPtrArray *blocks,
+           GString   *source,
+           gsize      source_len,
+           guint      line)
+{
+  Block *block = g_slice_new0 (Block);
+
+  /* Drop trailing blank lines, they are not part of the block */
+  g_string_truncate (source, source_len);
+
+  block->line = line;
+  block->source = g_string_free (source, FALSE);
+
+  g_ptr_array_add (blocks, block);
+}
+
+/*
+ * Splits markdown into top-level blocks which can be rendered on their own.
+ *
+ * Blocks are separated by blank lines, except within fenced code or raw HTML
+ * elements, before indented continuation lines, and between items of the
+ * same list so that those keep rendering as a single element.
+ */
+static GPtrArray *
+split_blocks (const char *text,
+              gsize       len,
+              guint      *n_lines)
+{
+  g_autoptr(GPtrArray) blocks = g_ptr_array_new_with_free_func (block_free);
+  GString *current = NULL;
+  const char *end = text + len;
+  const char *line = text;
+  gboolean current_is_list = FALSE;
+  gboolean pending_break = FALSE;
+  gsize current_len = 0;
+  gsize fence_len = 0;
+  char fence_char = 0;
+  guint current_line = 0;
+  guint lineno = 0;
+  int html_depth = 0;
+
+  while (line < end)
+    {
+      const char *eol = memchr (line, '\n', end - line);
+      gsize line_len = (eol ? eol : end) - line;
+      gboolean content = TRUE;
+      char c;
+      gsize n;
+
+      if (fence_len > 0)
+        {
+          /* Inside fenced code, only the closing fence matters */
+          if (is_fence (line, line_len, &c, &n) && c == fence_char && n >= fence_len)
+            fence_len = 0;
+        }
+      else if (is_blank (line, line_len))
+        {
+          pending_break = current != NULL && html_depth <= 0;
+          content = FALSE;
+        }
+      else
+        {
+          gboolean list_item = is_list_item (line, line_len);
+
+          if (current != NULL &&
+              pending_break &&
+              line[0] != ' ' && line[0] != '\t' &&
+              !(current_is_list && list_item))
+            {
+              add_block (blocks, current, current_len, current_line);
+              current = NULL;
+            }
+
+          if (current == NULL)
+            {
+              current = g_string_new (NULL);
+              current_line = lineno;
+              current_is_list = list_item;
+              html_depth = 0;
+            }
+
+          pending_break = FALSE;
+
+          if (!is_fence (line, line_len, &fence_char, &fence_len))
+            html_depth += html_depth_delta (line, line_len);
+        }
+
+      if (current != NULL)
+        {
+          g_string_append_len (current, line, line_len);
+          g_string_append_c (current, '\n');
+
+          if (content)
+            current_len = current->len;
+        }
+
+      lineno++;
+
+      if (eol == NULL)
+        break;
+
+      line = eol + 1;
+    }
+
+  if (current != NULL)
+    add_block (blocks, current, current_len, current_line);
+
+  for (guint i = 0; i < blocks->len; i++)
+    {
+      Block *block = g_ptr_array_index (blocks, i);
+      block->lines_to_end = lineno - block->line;
+    }
+
+  *n_lines = lineno;
+
+  return g_steal_pointer (&blocks);
+}
+
+static void
+append_js_string (GString    *str,
+                  const char *text)
+{
+  g_string_append_c (str, '"');
+
+  for (const char *iter = text; *iter; iter = g_utf8_next_char (iter))
+    {
+      gunichar ch = g_utf8_get_char (iter);
+
+      switch (ch)
+        {
+        case '"':  g_string_append (str, "\\\""); break;
+        case '\\': g_string_append (str, "\\\\"); break;
+        case '\n': g_string_append (str, "\\n"); break;
+        case '\r': g_string_append (str, "\\r"); break;
+        case '\t': g_string_append (str, "\\t"); break;
+
+        /* Keep the script from being terminated if it is ever embedded */
+        case '<':  g_string_append (str, "\\u003c"); break;
+
+        default:
+          if (ch < 0x20 || ch == 0x2028 || ch == 0x2029)
+            g_string_append_printf (str, "\\u%04x", ch);
+          else
+            g_string_append_unichar (str, ch);
+          break;
+        }
+    }
+
+  g_string_append_c (str, '"');
+}
+
+static GBytes *
+dup_content (GbpMarkdownHtmlGenerator  *self,
+             GError                   **error)
+{
+  g_autoptr(IdeBuffer) buffer = NULL;
+
+  g_assert (GBP_IS_MARKDOWN_HTML_GENERATOR (self));
+
+  if (!(buffer = g_signal_group_dup_target (self->buffer_signals)))
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_CANCELLED,
+                           "Operation was cancelled");
+      return NULL;
+    }
+
+  return ide_buffer_dup_content (buffer);
+}
+
 static void
 gbp_markdown_html_generator_generate_async (IdeHtmlGenerator    *generator,
                                             GCancellable        *cancellable,
@@ -52,12 +381,12 @@ gbp_markdown_html_generator_generate_async (IdeHtmlGenerator    *generator,
                                             gpointer             user_data)
 {
   GbpMarkdownHtmlGenerator *self = (GbpMarkdownHtmlGenerator *)generator;
-  g_autoptr(IdeBuffer) buffer = NULL;
   g_autoptr(IdeTask) task = NULL;
   g_autoptr(GBytes) bytes = NULL;
-  g_autofree char *escaped = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GPtrArray) blocks = NULL;
+  GString *str;
   const char *input;
-  char *tmp;
   gsize len;
 
   g_assert (GBP_IS_MARKDOWN_HTML_GENERATOR (self));
@@ -66,25 +395,33 @@ gbp_markdown_html_generator_generate_async (IdeHtmlGenerator    *generator,
   task = ide_task_new (self, cancellable, callback, user_data);
   ide_task_set_source_tag (task, gbp_markdown_html_generator_generate_async);
 
-  if (!(buffer = g_signal_group_dup_target (self->buffer_signals)))
+  if (!(bytes = dup_content (self, &error)))
     {
-      ide_task_return_new_error (task,
-                                 G_IO_ERROR,
-                                 G_IO_ERROR_CANCELLED,
-                                 "Operation was cancelled");
+      ide_task_return_error (task, g_steal_pointer (&error));
       return;
     }
 
-  bytes = ide_buffer_dup_content (buffer);
   input = g_bytes_get_data (bytes, &len);
-  escaped = g_markup_escape_text (input, len);
-  tmp = g_strconcat (markdown_html_prefix,
-                     escaped,
-                     markdown_html_suffix,
-                     NULL);
+  blocks = split_blocks (input, len, &self->n_lines);
 
+  str = g_string_new (markdown_html_prefix);
+
+  for (guint i = 0; i < blocks->len; i++)
+    {
+      const Block *block = g_ptr_array_index (blocks, i);
+      g_autofree char *escaped = g_markup_escape_text (block->source, -1);
+
+      g_string_append_printf (str, "<div data-line=\"%u\">%s</div>", block->line, escaped);
+    }
+
+  g_string_append (str, markdown_html_suffix);
+
+  g_clear_pointer (&self->blocks, g_ptr_array_unref);
+  self->blocks = g_steal_pointer (&blocks);
+
+  len = str->len;
   ide_task_return_pointer (task,
-                           g_bytes_new_take (tmp, strlen (tmp)),
+                           g_bytes_new_take (g_string_free (str, FALSE), len),
                            g_bytes_unref);
 }
 
@@ -99,6 +436,115 @@ gbp_markdown_html_generator_generate_finish (IdeHtmlGenerator  *generator,
   return ide_task_propagate_pointer (IDE_TASK (result), error);
 }
 
+static void
+gbp_markdown_html_generator_generate_patch_async (IdeHtmlGenerator    *generator,
+                                                  GCancellable        *cancellable,
+                                                  GAsyncReadyCallback  callback,
+                                                  gpointer             user_data)
+{
+  GbpMarkdownHtmlGenerator *self = (GbpMarkdownHtmlGenerator *)generator;
+  g_autoptr(IdeTask) task = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GPtrArray) blocks = NULL;
+  GString *str;
+  const char *input;
+  guint n_lines;
+  guint prefix = 0;
+  guint suffix = 0;
+  gsize len;
+
+  g_assert (GBP_IS_MARKDOWN_HTML_GENERATOR (self));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_markdown_html_generator_generate_patch_async);
+
+  if (self->blocks == NULL)
+    {
+      ide_task_return_unsupported_error (task);
+      return;
+    }
+
+  if (!(bytes = dup_content (self, &error)))
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  input = g_bytes_get_data (bytes, &len);
+  blocks = split_blocks (input, len, &n_lines);
+
+  /* Edits are almost always contained to a single region of the document,
+   * so everything before and after it can be kept as is.
+   */
+  while (prefix < blocks->len && prefix < self->blocks->len)
+    {
+      const Block *a = g_ptr_array_index (blocks, prefix);
+      const Block *b = g_ptr_array_index (self->blocks, prefix);
+
+      if (a->line != b->line || !g_str_equal (a->source, b->source))
+        break;
+
+      prefix++;
+    }
+
+  while (suffix < blocks->len - prefix && suffix < self->blocks->len - prefix)
+    {
+      const Block *a = g_ptr_array_index (blocks, blocks->len - suffix - 1);
+      const Block *b = g_ptr_array_index (self->blocks, self->blocks->len - suffix - 1);
+
+      if (a->lines_to_end != b->lines_to_end || !g_str_equal (a->source, b->source))
+        break;
+
+      suffix++;
+    }
+
+  str = g_string_new (NULL);
+
+  if (prefix + suffix < blocks->len ||
+      prefix + suffix < self->blocks->len ||
+      n_lines != self->n_lines)
+    {
+      g_string_append_printf (str, "preview_patch(%u, %u, [",
+                              prefix, self->blocks->len - prefix - suffix);
+
+      for (guint i = prefix; i < blocks->len - suffix; i++)
+        {
+          const Block *block = g_ptr_array_index (blocks, i);
+
+          if (i > prefix)
+            g_string_append_c (str, ',');
+
+          g_string_append_printf (str, "[%u,", block->line);
+          append_js_string (str, block->source);
+          g_string_append_c (str, ']');
+        }
+
+      g_string_append_printf (str, "], %d);", (int)n_lines - (int)self->n_lines);
+    }
+
+  g_clear_pointer (&self->blocks, g_ptr_array_unref);
+  self->blocks = g_steal_pointer (&blocks);
+  self->n_lines = n_lines;
+
+  len = str->len;
+  ide_task_return_pointer (task,
+                           g_bytes_new_take (g_string_free (str, FALSE), len),
+                           g_bytes_unref);
+}
+
+static GBytes *
+gbp_markdown_html_generator_generate_patch_finish (IdeHtmlGenerator  *generator,
+                                                   GAsyncResult      *result,
+                                                   GError           **error)
+{
+  g_assert (GBP_IS_MARKDOWN_HTML_GENERATOR (generator));
+  g_assert (IDE_IS_TASK (result));
+
+  return ide_task_propagate_pointer (IDE_TASK (result), error);
+}
+
 static gboolean
 file_to_base_uri (GBinding     *binding,
                   const GValue *from,
@@ -132,6 +578,7 @@ gbp_markdown_html_generator_dispose (GObject *object)
   GbpMarkdownHtmlGenerator *self = (GbpMarkdownHtmlGenerator *)object;
 
   g_clear_object (&self->buffer_signals);
+  g_clear_pointer (&self->blocks, g_ptr_array_unref);
 
   G_OBJECT_CLASS (gbp_markdown_html_generator_parent_class)->dispose (object);
 }
@@ -190,6 +637,8 @@ gbp_markdown_html_generator_class_init (GbpMarkdownHtmlGeneratorClass *klass)
 
   generator_class->generate_async = gbp_markdown_html_generator_generate_async;
   generator_class->generate_finish = gbp_markdown_html_generator_generate_finish;
+  generator_class->generate_patch_async = gbp_markdown_html_generator_generate_patch_async;
+  generator_class->generate_patch_finish = gbp_markdown_html_generator_generate_patch_finish;
 
   properties [PROP_BUFFER] =
     g_param_spec_object ("buffer", NULL, NULL,
@@ -9,6 +9,110 @@ marked.setOptions({
   smartypants: false
 });
 
+/*
+ * The document is split into top-level blocks by the generator so that
+ * edits only need to re-render the blocks which changed. Each block keeps
+ * the link reference definitions it contains so that references may be
+ * resolved across blocks.
+ */
+var blocks = [];
+var links = Object.create(null);
+
+function createBlock(line, source) {
+  var element = document.createElement('div');
+
+  element.className = 'markdown-block';
+  element.dataset.line = line;
+
+  return {
+    line: line,
+    source: source,
+    links: marked.lexer(source).links,
+    element: element
+  };
+}
+
+function hasLinks(block) {
+  return Object.keys(block.links).length > 0;
+}
+
+function collectLinks() {
+  links = Object.create(null);
+
+  /* The first definition of a label wins */
+  for (var i = blocks.length - 1; i >= 0; i--)
+    Object.assign(links, blocks[i].links);
+}
+
+function renderBlock(block) {
+  var lexer = new marked.Lexer(marked.defaults);
+
+  lexer.tokens.links = Object.assign(Object.create(null), links);
+  block.element.innerHTML = marked.parser(lexer.lex(block.source), marked.defaults);
+}
+
 function preview() {
-  document.getElementById('preview').innerHTML = marked(document.getElementById('markdown-source').childNodes[0].nodeValue);
+  var source = document.getElementById('markdown-source');
+  var container = document.getElementById('preview');
+  var fragment = document.createDocumentFragment();
+
+  blocks = [];
+
+  for (var node = source.firstElementChild; node; node = node.nextElementSibling)
+    blocks.push(createBlock(parseInt(node.dataset.line), node.textContent));
+
+  source.remove();
+  collectLinks();
+
+  for (var i = 0; i < blocks.length; i++) {
+    renderBlock(blocks[i]);
+    fragment.appendChild(blocks[i].element);
+  }
+
+  container.appendChild(fragment);
+}
+
+/*
+ * Replaces @n_removed blocks starting at @index with @added, which is an
+ * array of [line, source] pairs. The blocks following them are moved by
+ * @line_delta lines.
+ */
+function preview_patch(index, n_removed, added, line_delta) {
+  var container = document.getElementById('preview');
+  var removed = blocks.slice(index, index + n_removed);
+  var inserted = added.map(function (pair) { return createBlock(pair[0], pair[1]); });
+  var next = index + n_removed < blocks.length ? blocks[index + n_removed].element : null;
+  var relink = removed.some(hasLinks) || inserted.some(hasLinks);
+  var fragment = document.createDocumentFragment();
+  var i;
+
+  blocks.splice.apply(blocks, [index, n_removed].concat(inserted));
+
+  if (relink)
+    collectLinks();
+
+  for (i = 0; i < inserted.length; i++) {
+    renderBlock(inserted[i]);
+    fragment.appendChild(inserted[i].element);
+  }
+
+  for (i = 0; i < removed.length; i++)
+    removed[i].element.remove();
+
+  container.insertBefore(fragment, next);
+
+  if (line_delta != 0) {
+    for (i = index + inserted.length; i < blocks.length; i++) {
+      blocks[i].line += line_delta;
+      blocks[i].element.dataset.line = blocks[i].line;
+    }
+  }
+
+  /* Link definitions changed, so references elsewhere may resolve differently */
+  if (relink) {
+    for (i = 0; i < blocks.length; i++) {
+      if (inserted.indexOf(blocks[i]) < 0)
+        renderBlock(blocks[i]);
+    }
+  }
 }
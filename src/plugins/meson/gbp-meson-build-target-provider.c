@@ -31,6 +31,20 @@ struct _GbpMesonBuildTargetProvider
   IdeObject parent_instance;
 };
 
+typedef struct
+{
+  GPtrArray  *targets;
+  GHashTable *by_path;
+} Query;
+
+static void
+query_free (Query *query)
+{
+  g_clear_pointer (&query->targets, g_ptr_array_unref);
+  g_clear_pointer (&query->by_path, g_hash_table_unref);
+  g_slice_free (Query, query);
+}
+
 static const gchar *
 get_first_string (JsonNode *member)
 {
@@ -51,6 +65,199 @@ get_first_string (JsonNode *member)
   return NULL;
 }
 
+static void
+add_target_sources (GbpMesonBuildTarget *target,
+                    JsonObject          *obj)
+{
+  JsonNode *member;
+  JsonArray *ar;
+  guint n_groups;
+
+  g_assert (GBP_IS_MESON_BUILD_TARGET (target));
+  g_assert (obj != NULL);
+
+  /* Each entry of target_sources groups the sources by compiler */
+  if (!(member = json_object_get_member (obj, "target_sources")) ||
+      !JSON_NODE_HOLDS_ARRAY (member) ||
+      !(ar = json_node_get_array (member)))
+    return;
+
+  n_groups = json_array_get_length (ar);
+
+  for (guint i = 0; i < n_groups; i++)
+    {
+      JsonNode *group = json_array_get_element (ar, i);
+      JsonArray *sources;
+      guint n_sources;
+
+      if (!JSON_NODE_HOLDS_OBJECT (group) ||
+          !(member = json_object_get_member (json_node_get_object (group), "sources")) ||
+          !JSON_NODE_HOLDS_ARRAY (member) ||
+          !(sources = json_node_get_array (member)))
+        continue;
+
+      n_sources = json_array_get_length (sources);
+
+      for (guint j = 0; j < n_sources; j++)
+        {
+          JsonNode *source = json_array_get_element (sources, j);
+          const char *path;
+
+          if (JSON_NODE_HOLDS_VALUE (source) &&
+              (path = json_node_get_string (source)) &&
+              g_path_is_absolute (path))
+            gbp_meson_build_target_add_source (target, path);
+        }
+    }
+}
+
+/*
+ * Parses the output of `ninja -t query` which looks like:
+ *
+ *   src/libfoo.so:
+ *     input: c_LINKER
+ *       src/libfoo.so.p/foo.c.o
+ *     outputs:
+ *       src/app
+ *
+ * Every output of a target that is also a target depends on it.
+ */
+static void
+apply_dependencies (Query *query,
+                    char  *output)
+{
+  GbpMesonBuildTarget *current = NULL;
+  IdeLineReader reader;
+  gboolean in_outputs = FALSE;
+  gsize line_len;
+  char *line;
+
+  g_assert (query != NULL);
+  g_assert (output != NULL);
+
+  ide_line_reader_init (&reader, output, -1);
+  while ((line = ide_line_reader_next (&reader, &line_len)))
+    {
+      line[line_len] = 0;
+
+      if (line_len == 0)
+        continue;
+
+      if (line[0] != ' ')
+        {
+          if (line[line_len - 1] == ':')
+            line[line_len - 1] = 0;
+
+          current = g_hash_table_lookup (query->by_path, line);
+          in_outputs = FALSE;
+        }
+      else if (g_str_has_prefix (line, "    "))
+        {
+          GbpMesonBuildTarget *dependent;
+
+          if (in_outputs &&
+              current != NULL &&
+              (dependent = g_hash_table_lookup (query->by_path, line + 4)) &&
+              dependent != current)
+            gbp_meson_build_target_add_dependency (dependent, gbp_meson_build_target_get_filename (current));
+        }
+      else
+        {
+          in_outputs = g_str_equal (line, "  outputs:");
+        }
+    }
+}
+
+static void
+gbp_meson_build_target_provider_query_cb (GObject      *object,
+                                          GAsyncResult *result,
+                                          gpointer      user_data)
+{
+  IdeSubprocess *subprocess = (IdeSubprocess *)object;
+  g_autofree char *stdout_buf = NULL;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  Query *query;
+
+  g_assert (IDE_IS_SUBPROCESS (subprocess));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  query = ide_task_get_task_data (task);
+
+  /* Targets are still usable without dependencies, they just won't pull
+   * in their dependents when building for a single file.
+   */
+  if (!ide_subprocess_communicate_utf8_finish (subprocess, result, &stdout_buf, NULL, &error))
+    g_debug ("Failed to query target dependencies: %s", error->message);
+  else if (stdout_buf != NULL)
+    apply_dependencies (query, stdout_buf);
+
+  ide_task_return_pointer (task, g_ptr_array_ref (query->targets), g_ptr_array_unref);
+}
+
+static void
+gbp_meson_build_target_provider_query_dependencies (GbpMesonBuildTargetProvider *self,
+                                                    IdeTask                     *task,
+                                                    IdePipeline                 *pipeline,
+                                                    Query                       *query)
+{
+  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
+  g_autoptr(IdeSubprocess) subprocess = NULL;
+  g_autoptr(IdeRunCommand) run_command = NULL;
+  g_autoptr(IdeRunContext) run_context = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree char *ninja = NULL;
+  IdeBuildSystem *build_system;
+  GHashTableIter iter;
+  const char *path;
+
+  g_assert (GBP_IS_MESON_BUILD_TARGET_PROVIDER (self));
+  g_assert (IDE_IS_TASK (task));
+  g_assert (IDE_IS_PIPELINE (pipeline));
+  g_assert (query != NULL);
+
+  ide_task_set_task_data (task, query, query_free);
+
+  if (g_hash_table_size (query->by_path) == 0)
+    {
+      ide_task_return_pointer (task, g_ptr_array_ref (query->targets), g_ptr_array_unref);
+      return;
+    }
+
+  build_system = ide_build_system_from_context (ide_object_get_context (IDE_OBJECT (self)));
+  ninja = gbp_meson_build_system_locate_ninja (GBP_MESON_BUILD_SYSTEM (build_system), pipeline);
+
+  run_command = ide_run_command_new ();
+  ide_run_command_set_argv (run_command, IDE_STRV_INIT (ninja, "-C", ide_pipeline_get_builddir (pipeline), "-t", "query"));
+
+  g_hash_table_iter_init (&iter, query->by_path);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&path, NULL))
+    ide_run_command_append_argv (run_command, path);
+
+  run_context = ide_pipeline_create_run_context (pipeline, run_command);
+  launcher = ide_run_context_end (run_context, &error);
+
+  if (launcher != NULL)
+    {
+      ide_subprocess_launcher_set_flags (launcher, G_SUBPROCESS_FLAGS_STDOUT_PIPE | G_SUBPROCESS_FLAGS_STDERR_SILENCE);
+      subprocess = ide_subprocess_launcher_spawn (launcher, ide_task_get_cancellable (task), &error);
+    }
+
+  if (subprocess == NULL)
+    {
+      g_debug ("Failed to query target dependencies: %s", error->message);
+      ide_task_return_pointer (task, g_ptr_array_ref (query->targets), g_ptr_array_unref);
+      return;
+    }
+
+  ide_subprocess_communicate_utf8_async (subprocess,
+                                         NULL,
+                                         ide_task_get_cancellable (task),
+                                         gbp_meson_build_target_provider_query_cb,
+                                         g_object_ref (task));
+}
+
 static void
 gbp_meson_build_target_provider_communicate_cb (GObject      *object,
                                                 GAsyncResult *result,
@@ -64,6 +271,8 @@ gbp_meson_build_target_provider_communicate_cb (GObject      *object,
   g_autoptr(GError) error = NULL;
   g_autoptr(GPtrArray) ret = NULL;
   g_autoptr(GFile) builddir = NULL;
+  g_autoptr(GHashTable) by_path = NULL;
+  Query *query;
   IdeBuildManager *build_manager;
   IdePipeline *pipeline;
   IdeContext *context;
@@ -113,6 +322,7 @@ gbp_meson_build_target_provider_communicate_cb (GObject      *object,
 
   len = json_array_get_length (array);
   ret = g_ptr_array_new_with_free_func (g_object_unref);
+  by_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
   for (guint i = 0; i < len; i++)
     {
@@ -156,12 +366,21 @@ gbp_meson_build_target_provider_communicate_cb (GObject      *object,
             kind = IDE_ARTIFACT_KIND_SHARED_LIBRARY;
 
           target = gbp_meson_build_target_new (context, dir, base, filename, kind);
+          add_target_sources (GBP_MESON_BUILD_TARGET (target), obj);
+
+          /* ninja knows the target by its path relative to the builddir */
+          if (base != NULL)
+            g_hash_table_insert (by_path, g_strdup (base), target);
 
           g_ptr_array_add (ret, g_steal_pointer (&target));
         }
     }
 
-  ide_task_return_pointer (task, g_steal_pointer (&ret), g_ptr_array_unref);
+  query = g_slice_new0 (Query);
+  query->targets = g_steal_pointer (&ret);
+  query->by_path = g_steal_pointer (&by_path);
+
+  gbp_meson_build_target_provider_query_dependencies (self, task, pipeline, query);
 }
 
 static void
@@ -30,6 +30,12 @@ struct _GbpMesonBuildTarget
   gchar           *name;
   gchar           *filename;
   IdeArtifactKind  kind;
+
+  /* Absolute paths of the files compiled into the target, used to
+   * find which targets to rebuild after changing a file.
+   */
+  GHashTable      *sources;
+  GHashTable      *dependencies;
 };
 
 enum {
@@ -68,12 +74,44 @@ gbp_meson_build_target_get_kind (IdeBuildTarget *target)
   return GBP_MESON_BUILD_TARGET (target)->kind;
 }
 
+static gboolean
+gbp_meson_build_target_contains_file (IdeBuildTarget *target,
+                                      GFile          *file)
+{
+  GbpMesonBuildTarget *self = (GbpMesonBuildTarget *)target;
+  const char *path;
+
+  g_assert (GBP_IS_MESON_BUILD_TARGET (self));
+  g_assert (G_IS_FILE (file));
+
+  return self->sources != NULL &&
+         (path = g_file_peek_path (file)) != NULL &&
+         g_hash_table_contains (self->sources, path);
+}
+
+static gboolean
+gbp_meson_build_target_depends_on (IdeBuildTarget *target,
+                                   IdeBuildTarget *other)
+{
+  GbpMesonBuildTarget *self = (GbpMesonBuildTarget *)target;
+
+  g_assert (GBP_IS_MESON_BUILD_TARGET (self));
+  g_assert (IDE_IS_BUILD_TARGET (other));
+
+  return self->dependencies != NULL &&
+         GBP_IS_MESON_BUILD_TARGET (other) &&
+         GBP_MESON_BUILD_TARGET (other)->filename != NULL &&
+         g_hash_table_contains (self->dependencies, GBP_MESON_BUILD_TARGET (other)->filename);
+}
+
 static void
 build_target_iface_init (IdeBuildTargetInterface *iface)
 {
   iface->get_install_directory = gbp_meson_build_target_get_install_directory;
   iface->get_name = gbp_meson_build_target_get_name;
   iface->get_kind = gbp_meson_build_target_get_kind;
+  iface->contains_file = gbp_meson_build_target_contains_file;
+  iface->depends_on = gbp_meson_build_target_depends_on;
 }
 
 G_DEFINE_FINAL_TYPE_WITH_CODE (GbpMesonBuildTarget, gbp_meson_build_target, IDE_TYPE_OBJECT,
@@ -140,6 +178,8 @@ gbp_meson_build_target_finalize (GObject *object)
 
   g_clear_object (&self->install_directory);
   g_clear_pointer (&self->name, g_free);
+  g_clear_pointer (&self->sources, g_hash_table_unref);
+  g_clear_pointer (&self->dependencies, g_hash_table_unref);
 
   G_OBJECT_CLASS (gbp_meson_build_target_parent_class)->finalize (object);
 }
@@ -211,3 +251,29 @@ gbp_meson_build_target_get_filename (GbpMesonBuildTarget *self)
 
   return self->filename;
 }
+
+void
+gbp_meson_build_target_add_source (GbpMesonBuildTarget *self,
+                                   const char          *path)
+{
+  g_return_if_fail (GBP_IS_MESON_BUILD_TARGET (self));
+  g_return_if_fail (path != NULL);
+
+  if (self->sources == NULL)
+    self->sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  g_hash_table_add (self->sources, g_canonicalize_filename (path, NULL));
+}
+
+void
+gbp_meson_build_target_add_dependency (GbpMesonBuildTarget *self,
+                                       const char          *filename)
+{
+  g_return_if_fail (GBP_IS_MESON_BUILD_TARGET (self));
+  g_return_if_fail (filename != NULL);
+
+  if (self->dependencies == NULL)
+    self->dependencies = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  g_hash_table_add (self->dependencies, g_strdup (filename));
+}
@@ -28,11 +28,15 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GbpMesonBuildTarget, gbp_meson_build_target, GBP, MESON_BUILD_TARGET, IdeObject)
 
-IdeBuildTarget *gbp_meson_build_target_new          (IdeContext          *context,
-                                                     GFile               *install_directory,
-                                                     const gchar         *name,
-                                                     const gchar         *filename,
-                                                     IdeArtifactKind      kind);
-const gchar    *gbp_meson_build_target_get_filename (GbpMesonBuildTarget *self);
+IdeBuildTarget *gbp_meson_build_target_new            (IdeContext          *context,
+                                                       GFile               *install_directory,
+                                                       const gchar         *name,
+                                                       const gchar         *filename,
+                                                       IdeArtifactKind      kind);
+const gchar    *gbp_meson_build_target_get_filename   (GbpMesonBuildTarget *self);
+void            gbp_meson_build_target_add_source     (GbpMesonBuildTarget *self,
+                                                       const char          *path);
+void            gbp_meson_build_target_add_dependency (GbpMesonBuildTarget *self,
+                                                       const char          *filename);
 
 G_END_DECLS
@@ -40,6 +40,11 @@ struct _GbpMesonIntrospection
 
   char *etag;
 
+  /* The converted sections of meson-info/, along with the mtime of the
+   * file each was read from. See gbp_meson_introspection_read_worker().
+   */
+  GVariant *cache;
+
   GListStore *run_commands;
 
   char *descriptive_name;
@@ -52,6 +57,12 @@ struct _GbpMesonIntrospection
 
 G_DEFINE_FINAL_TYPE (GbpMesonIntrospection, gbp_meson_introspection, IDE_TYPE_PIPELINE_STAGE)
 
+#define CACHE_VERSION    1
+#define PROJECTINFO_TYPE "(msmsms)"
+#define RUN_COMMAND_TYPE "(msmsuasasmsbbi)"
+#define SECTIONS_TYPE    "a{s(xv)}"
+#define CACHE_TYPE       "(u" SECTIONS_TYPE ")"
+
 static gboolean
 get_bool_member (JsonObject *object,
                  const char *member,
@@ -76,6 +87,30 @@ get_bool_member (JsonObject *object,
   return FALSE;
 }
 
+static gboolean
+get_int_member (JsonObject *object,
+                const char *member,
+                gint64     *location)
+{
+  JsonNode *node;
+
+  g_assert (object != NULL);
+  g_assert (member != NULL);
+  g_assert (location != NULL);
+
+  *location = 0;
+
+  if (json_object_has_member (object, member) &&
+      (node = json_object_get_member (object, member)) &&
+      JSON_NODE_HOLDS_VALUE (node))
+    {
+      *location = json_node_get_int (node);
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 static gboolean
 get_string_member (JsonObject  *object,
                    const char  *member,
@@ -182,51 +217,72 @@ get_environ_member (JsonObject   *object,
   return FALSE;
 }
 
-static void
-gbp_meson_introspection_load_buildoptions (GbpMesonIntrospection *self,
-                                           JsonArray             *buildoptions)
+static GVariant *
+load_projectinfo (JsonNode *node)
 {
-  IDE_ENTRY;
+  g_autofree char *version = NULL;
+  g_autofree char *descriptive_name = NULL;
+  g_autofree char *subproject_dir = NULL;
+  JsonObject *projectinfo;
 
-  g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (buildoptions != NULL);
+  g_assert (node != NULL);
 
-  IDE_EXIT;
+  if (!JSON_NODE_HOLDS_OBJECT (node) ||
+      !(projectinfo = json_node_get_object (node)))
+    return NULL;
+
+  get_string_member (projectinfo, "version", &version);
+  get_string_member (projectinfo, "descriptive_name", &descriptive_name);
+  get_string_member (projectinfo, "subproject_dir", &subproject_dir);
+
+  return g_variant_new (PROJECTINFO_TYPE, version, descriptive_name, subproject_dir);
 }
 
 static void
-gbp_meson_introspection_load_projectinfo (GbpMesonIntrospection *self,
-                                          JsonObject            *projectinfo)
+add_run_command (GVariantBuilder    *builder,
+                 const char         *id,
+                 const char         *display_name,
+                 IdeRunCommandKind   kind,
+                 const char * const *argv,
+                 const char * const *env,
+                 const char         *cwd,
+                 gboolean            can_default,
+                 gboolean            is_parallel,
+                 int                 priority)
 {
-  IDE_ENTRY;
-
-  g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (projectinfo != NULL);
-
-  get_string_member (projectinfo, "version", &self->version);
-  get_string_member (projectinfo, "descriptive_name", &self->descriptive_name);
-  get_string_member (projectinfo, "subproject_dir", &self->subproject_dir);
-
-  IDE_EXIT;
+  g_assert (builder != NULL);
+
+  g_variant_builder_add (builder, "(msmsu^as^asmsbbi)",
+                         id,
+                         display_name,
+                         (guint32)kind,
+                         argv ? argv : IDE_STRV_INIT (NULL),
+                         env ? env : IDE_STRV_INIT (NULL),
+                         cwd,
+                         can_default,
+                         is_parallel,
+                         priority);
 }
 
 static void
-gbp_meson_introspection_load_test (GbpMesonIntrospection *self,
-                                   JsonObject            *test)
+load_test (GVariantBuilder *builder,
+           JsonObject      *test)
 {
-  g_autoptr(IdeRunCommand) run_command = NULL;
   g_auto(GStrv) cmd = NULL;
   g_auto(GStrv) env = NULL;
   g_auto(GStrv) suite = NULL;
   g_autofree char *name = NULL;
   g_autofree char *workdir = NULL;
   g_autofree char *id = NULL;
+  gboolean is_parallel;
+  gint64 priority;
 
-  IDE_ENTRY;
-
-  g_assert (GBP_IS_MESON_INTROSPECTION (self));
+  g_assert (builder != NULL);
   g_assert (test != NULL);
 
+  if (!get_bool_member (test, "is_parallel", &is_parallel))
+    is_parallel = TRUE;
+  get_int_member (test, "priority", &priority);
   get_strv_member (test, "cmd", &cmd);
   get_strv_member (test, "suite", &suite);
   get_environ_member (test, "env", &env);
@@ -235,81 +291,76 @@ gbp_meson_introspection_load_test (GbpMesonIntrospection *self,
 
   id = g_strdup_printf ("meson:%s", name);
 
-  run_command = ide_run_command_new ();
-  ide_run_command_set_id (run_command, id);
-  ide_run_command_set_kind (run_command, IDE_RUN_COMMAND_KIND_TEST);
-  ide_run_command_set_display_name (run_command, name);
-  ide_run_command_set_environ (run_command, (const char * const *)env);
-  ide_run_command_set_argv (run_command, (const char * const *)cmd);
-  ide_run_command_set_cwd (run_command, workdir);
-  ide_run_command_set_can_default (run_command, FALSE);
-
-  g_list_store_append (self->run_commands, run_command);
-
-  IDE_EXIT;
+  /* Meson runs higher priority tests first, whereas lower values sort
+   * first for run commands.
+   */
+  add_run_command (builder,
+                   id,
+                   name,
+                   IDE_RUN_COMMAND_KIND_TEST,
+                   (const char * const *)cmd,
+                   (const char * const *)env,
+                   workdir,
+                   FALSE,
+                   is_parallel,
+                   -CLAMP (priority, -G_MAXINT, G_MAXINT));
 }
 
-static void
-gbp_meson_introspection_load_tests (GbpMesonIntrospection *self,
-                                    JsonArray             *tests)
+static GVariant *
+load_tests (JsonNode *node)
 {
+  GVariantBuilder builder;
+  JsonArray *tests;
   guint n_items;
 
-  IDE_ENTRY;
+  g_assert (node != NULL);
 
-  g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (tests != NULL);
+  if (!JSON_NODE_HOLDS_ARRAY (node) || !(tests = json_node_get_array (node)))
+    return NULL;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" RUN_COMMAND_TYPE));
 
   n_items = json_array_get_length (tests);
 
   for (guint i = 0; i < n_items; i++)
     {
-      JsonNode *node = json_array_get_element (tests, i);
+      JsonNode *element = json_array_get_element (tests, i);
       JsonObject *obj;
 
-      if (node != NULL &&
-          JSON_NODE_HOLDS_OBJECT (node) &&
-          (obj = json_node_get_object (node)))
-        gbp_meson_introspection_load_test (self, obj);
+      if (element != NULL &&
+          JSON_NODE_HOLDS_OBJECT (element) &&
+          (obj = json_node_get_object (element)))
+        load_test (&builder, obj);
     }
 
-  IDE_EXIT;
-}
-
-static void
-gbp_meson_introspection_load_benchmarks (GbpMesonIntrospection *self,
-                                         JsonArray             *benchmarks)
-{
-  IDE_ENTRY;
-
-  g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (benchmarks != NULL);
-
-  IDE_EXIT;
+  return g_variant_builder_end (&builder);
 }
 
-static void
-gbp_meson_introspection_load_targets (GbpMesonIntrospection *self,
-                                      JsonArray             *targets)
+static GVariant *
+load_targets (JsonNode *node)
 {
+  GVariantBuilder builder;
+  JsonArray *targets;
   guint length;
 
-  IDE_ENTRY;
+  g_assert (node != NULL);
 
-  g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (targets != NULL);
+  if (!JSON_NODE_HOLDS_ARRAY (node) || !(targets = json_node_get_array (node)))
+    return NULL;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" RUN_COMMAND_TYPE));
 
   length = json_array_get_length (targets);
 
   for (guint i = 0; i < length; i++)
     {
-      JsonNode *node = json_array_get_element (targets, i);
+      JsonNode *element = json_array_get_element (targets, i);
       g_autofree char *id = NULL;
       g_autofree char *name = NULL;
       g_autofree char *type = NULL;
       JsonObject *obj;
 
-      if (!JSON_NODE_HOLDS_OBJECT (node) || !(obj = json_node_get_object (node)))
+      if (!JSON_NODE_HOLDS_OBJECT (element) || !(obj = json_node_get_object (element)))
         continue;
 
       get_string_member (obj, "id", &id);
@@ -326,9 +377,9 @@ gbp_meson_introspection_load_targets (GbpMesonIntrospection *self,
 
           if (!ide_str_empty0 (filename))
             {
-              g_autoptr(IdeRunCommand) run_command = NULL;
               g_auto(GStrv) install_filename = NULL;
               g_autofree char *install_dir = NULL;
+              const char *path;
 
               if (get_strv_member (obj, "install_filename", &install_filename) &&
                   install_filename != NULL &&
@@ -340,47 +391,44 @@ gbp_meson_introspection_load_targets (GbpMesonIntrospection *self,
                   (install_dir == NULL || !g_str_has_suffix (install_dir, "/bin")))
                 continue;
 
-              run_command = ide_run_command_new ();
-
-              /* Setup basics for run command information */
-              ide_run_command_set_kind (run_command, IDE_RUN_COMMAND_KIND_UTILITY);
-              ide_run_command_set_id (run_command, id);
-              ide_run_command_set_display_name (run_command, name);
-
-              /* Only allow automatic discovery if it's installed */
-              ide_run_command_set_can_default (run_command, installed);
-
               /* Use installed path if it's provided. */
               if (install_filename != NULL && install_filename[0] != NULL)
-                ide_run_command_set_argv (run_command, IDE_STRV_INIT (install_filename[0]));
+                path = install_filename[0];
               else
-                ide_run_command_set_argv (run_command, IDE_STRV_INIT (filename[0]));
-
-              /* Lower priority for any executable not installed to somewhere/bin/ */
-              if (install_dir != NULL && g_str_has_suffix (install_dir, "/bin"))
-                ide_run_command_set_priority (run_command, 0);
-              else
-                ide_run_command_set_priority (run_command, 1000);
-
-              g_list_store_append (self->run_commands, run_command);
+                path = filename[0];
+
+              /* Only allow automatic discovery if it's installed, and lower
+               * priority for any executable not installed to somewhere/bin/
+               */
+              add_run_command (&builder,
+                               id,
+                               name,
+                               IDE_RUN_COMMAND_KIND_UTILITY,
+                               IDE_STRV_INIT (path),
+                               NULL,
+                               NULL,
+                               installed,
+                               TRUE,
+                               install_dir != NULL && g_str_has_suffix (install_dir, "/bin") ? 0 : 1000);
             }
         }
     }
 
-  IDE_EXIT;
+  return g_variant_builder_end (&builder);
 }
 
-static void
-gbp_meson_introspection_load_installed (GbpMesonIntrospection *self,
-                                        JsonObject            *installed)
-{
-  IDE_ENTRY;
-
-  g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (installed != NULL);
-
-  IDE_EXIT;
-}
+/* The sections of the introspection data we use. Each is converted into a
+ * compact GVariant so that the results can be cached for as long as the
+ * introspection file meson wrote for that section is unchanged.
+ */
+static const struct {
+  const char *name;
+  GVariant   *(*load) (JsonNode *node);
+} sections[] = {
+  { "projectinfo", load_projectinfo },
+  { "tests", load_tests },
+  { "targets", load_targets },
+};
 
 static char *
 get_current_etag (IdePipeline *pipeline)
@@ -423,47 +471,243 @@ gbp_meson_introspection_query (IdePipelineStage *stage,
                                     ide_str_equal0 (etag, self->etag));
 }
 
+typedef struct
+{
+  char     *meson_info_dir;
+  char     *cache_path;
+  GVariant *previous;
+} Read;
+
 static void
-gbp_meson_introspection_load_json (GbpMesonIntrospection *self,
-                                   JsonObject            *root)
+read_free (Read *read)
+{
+  g_clear_pointer (&read->meson_info_dir, g_free);
+  g_clear_pointer (&read->cache_path, g_free);
+  g_clear_pointer (&read->previous, g_variant_unref);
+  g_slice_free (Read, read);
+}
+
+static GVariant *
+lookup_section (GVariant   *cache,
+                const char *name)
 {
-  JsonNode *member;
+  GVariant *value = NULL;
+
+  g_assert (cache != NULL);
+  g_assert (name != NULL);
+
+  if (!g_variant_lookup (cache, name, "(xv)", NULL, &value))
+    return NULL;
+
+  return value;
+}
+
+static void
+gbp_meson_introspection_apply (GbpMesonIntrospection *self,
+                               GVariant              *cache)
+{
+  g_autoptr(GVariant) projectinfo = NULL;
 
   IDE_ENTRY;
 
   g_assert (IDE_IS_MAIN_THREAD ());
   g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (root != NULL);
-
-  if (json_object_has_member (root, "buildoptions") &&
-      (member = json_object_get_member (root, "buildoptions")) &&
-      JSON_NODE_HOLDS_ARRAY (member))
-    gbp_meson_introspection_load_buildoptions (self, json_node_get_array (member));
-
-  if (json_object_has_member (root, "projectinfo") &&
-      (member = json_object_get_member (root, "projectinfo")) &&
-      JSON_NODE_HOLDS_OBJECT (member))
-    gbp_meson_introspection_load_projectinfo (self, json_node_get_object (member));
-
-  if (json_object_has_member (root, "tests") &&
-      (member = json_object_get_member (root, "tests")) &&
-      JSON_NODE_HOLDS_ARRAY (member))
-    gbp_meson_introspection_load_tests (self, json_node_get_array (member));
-
-  if (json_object_has_member (root, "benchmarks") &&
-      (member = json_object_get_member (root, "benchmarks")) &&
-      JSON_NODE_HOLDS_ARRAY (member))
-    gbp_meson_introspection_load_benchmarks (self, json_node_get_array (member));
-
-  if (json_object_has_member (root, "installed") &&
-      (member = json_object_get_member (root, "installed")) &&
-      JSON_NODE_HOLDS_OBJECT (member))
-    gbp_meson_introspection_load_installed (self, json_node_get_object (member));
-
-  if (json_object_has_member (root, "targets") &&
-      (member = json_object_get_member (root, "targets")) &&
-      JSON_NODE_HOLDS_ARRAY (member))
-    gbp_meson_introspection_load_targets (self, json_node_get_array (member));
+  g_assert (cache != NULL);
+
+  /* Clear all of our previously loaded state */
+  g_list_store_remove_all (self->run_commands);
+
+  if ((projectinfo = lookup_section (cache, "projectinfo")) &&
+      g_variant_is_of_type (projectinfo, G_VARIANT_TYPE (PROJECTINFO_TYPE)))
+    {
+      g_clear_pointer (&self->version, g_free);
+      g_clear_pointer (&self->descriptive_name, g_free);
+      g_clear_pointer (&self->subproject_dir, g_free);
+
+      g_variant_get (projectinfo, PROJECTINFO_TYPE,
+                     &self->version,
+                     &self->descriptive_name,
+                     &self->subproject_dir);
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (sections); i++)
+    {
+      g_autoptr(GVariant) value = NULL;
+      GVariantIter iter;
+      const char *id;
+      const char *display_name;
+      const char *cwd;
+      guint32 kind;
+      g_autofree const char **argv = NULL;
+      g_autofree const char **env = NULL;
+      gboolean can_default;
+      gboolean is_parallel;
+      gint32 priority;
+
+      if (!(value = lookup_section (cache, sections[i].name)) ||
+          !g_variant_is_of_type (value, G_VARIANT_TYPE ("a" RUN_COMMAND_TYPE)))
+        continue;
+
+      g_variant_iter_init (&iter, value);
+      while (g_variant_iter_next (&iter, "(m&sm&su^a&s^a&sm&sbbi)",
+                                  &id, &display_name, &kind, &argv, &env, &cwd,
+                                  &can_default, &is_parallel, &priority))
+        {
+          g_autoptr(IdeRunCommand) run_command = ide_run_command_new ();
+
+          ide_run_command_set_id (run_command, id);
+          ide_run_command_set_kind (run_command, kind);
+          ide_run_command_set_display_name (run_command, display_name);
+          ide_run_command_set_argv (run_command, argv);
+          if (env[0] != NULL)
+            ide_run_command_set_environ (run_command, env);
+          ide_run_command_set_cwd (run_command, cwd);
+          ide_run_command_set_can_default (run_command, can_default);
+          ide_run_command_set_is_parallel (run_command, is_parallel);
+          ide_run_command_set_priority (run_command, priority);
+
+          g_list_store_append (self->run_commands, run_command);
+
+          g_clear_pointer (&argv, g_free);
+          g_clear_pointer (&env, g_free);
+        }
+    }
+
+  IDE_EXIT;
+}
+
+static gint64
+get_mtime (const char *path)
+{
+  g_autoptr(GFile) file = g_file_new_for_path (path);
+  g_autoptr(GFileInfo) info = NULL;
+  g_autoptr(GDateTime) dt = NULL;
+
+  if (!(info = g_file_query_info (file,
+                                  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                  G_FILE_QUERY_INFO_NONE,
+                                  NULL, NULL)) ||
+      !(dt = g_file_info_get_modification_date_time (info)))
+    return 0;
+
+  return g_date_time_to_unix (dt) * G_USEC_PER_SEC + g_date_time_get_microsecond (dt);
+}
+
+static GVariant *
+read_cache_file (const char *path)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  GVariant *sections_cache = NULL;
+  guint32 version = 0;
+
+  g_assert (path != NULL);
+
+  if (!(mapped = g_mapped_file_new (path, FALSE, NULL)))
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE));
+  g_variant_get (variant, "(u@" SECTIONS_TYPE ")", &version, &sections_cache);
+
+  if (version != CACHE_VERSION)
+    g_clear_pointer (&sections_cache, g_variant_unref);
+
+  return sections_cache;
+}
+
+static void
+gbp_meson_introspection_read_worker (IdeTask      *task,
+                                     gpointer      source_object,
+                                     gpointer      task_data,
+                                     GCancellable *cancellable)
+{
+  g_autoptr(GVariant) previous = NULL;
+  g_autoptr(GVariant) ret = NULL;
+  GVariantBuilder builder;
+  Read *read = task_data;
+  gboolean changed = FALSE;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_TASK (task));
+  g_assert (GBP_IS_MESON_INTROSPECTION (source_object));
+  g_assert (read != NULL);
+  g_assert (read->meson_info_dir != NULL);
+  g_assert (read->cache_path != NULL);
+
+  if (read->previous != NULL)
+    previous = g_variant_ref (read->previous);
+  else
+    previous = read_cache_file (read->cache_path);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (SECTIONS_TYPE));
+
+  for (guint i = 0; i < G_N_ELEMENTS (sections); i++)
+    {
+      g_autofree char *filename = g_strdup_printf ("intro-%s.json", sections[i].name);
+      g_autofree char *path = g_build_filename (read->meson_info_dir, filename, NULL);
+      g_autoptr(JsonParser) parser = NULL;
+      g_autoptr(GVariant) cached = NULL;
+      g_autoptr(GError) error = NULL;
+      gint64 cached_mtime = 0;
+      GVariant *value;
+      gint64 mtime;
+      JsonNode *root;
+
+      if (!(mtime = get_mtime (path)))
+        {
+          ide_task_return_new_error (task,
+                                     G_IO_ERROR,
+                                     G_IO_ERROR_NOT_FOUND,
+                                     "%s is missing from meson-info",
+                                     filename);
+          g_variant_builder_clear (&builder);
+          IDE_EXIT;
+        }
+
+      if (previous != NULL &&
+          g_variant_lookup (previous, sections[i].name, "(x@v)", &cached_mtime, &cached) &&
+          cached_mtime == mtime)
+        {
+          g_variant_builder_add (&builder, "{s(x@v)}", sections[i].name, mtime, cached);
+          continue;
+        }
+
+      parser = json_parser_new ();
+
+      if (!json_parser_load_from_file (parser, path, &error))
+        {
+          ide_task_return_error (task, g_steal_pointer (&error));
+          g_variant_builder_clear (&builder);
+          IDE_EXIT;
+        }
+
+      if (!(root = json_parser_get_root (parser)) ||
+          !(value = sections[i].load (root)))
+        continue;
+
+      g_variant_builder_add (&builder, "{s(xv)}", sections[i].name, mtime, value);
+      changed = TRUE;
+    }
+
+  ret = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  if (changed)
+    {
+      g_autoptr(GVariant) cache = g_variant_ref_sink (g_variant_new ("(u@" SECTIONS_TYPE ")", CACHE_VERSION, ret));
+      g_autoptr(GError) error = NULL;
+
+      if (!g_file_set_contents (read->cache_path,
+                                g_variant_get_data (cache),
+                                g_variant_get_size (cache),
+                                &error))
+        g_debug ("Failed to cache introspection: %s", error->message);
+    }
+
+  ide_task_return_pointer (task, g_steal_pointer (&ret), g_variant_unref);
 
   IDE_EXIT;
 }
@@ -476,7 +720,9 @@ gbp_meson_introspection_load_stream_cb (GObject      *object,
   JsonParser *parser = (JsonParser *)object;
   GbpMesonIntrospection *self;
   g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GVariant) cache = NULL;
   g_autoptr(GError) error = NULL;
+  GVariantBuilder builder;
   const char *etag;
   JsonObject *obj;
   JsonNode *root;
@@ -500,14 +746,31 @@ gbp_meson_introspection_load_stream_cb (GObject      *object,
   g_assert (GBP_IS_MESON_INTROSPECTION (self));
   g_assert (etag != NULL);
 
-  /* Clear all of our previously loaded state */
-  g_set_str (&self->etag, etag);
-  g_list_store_remove_all (self->run_commands);
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (SECTIONS_TYPE));
 
+  /* Without meson-info/ there is nothing to key a cache with, so these
+   * are stored without an mtime and are never reused.
+   */
   if ((root = json_parser_get_root (parser)) &&
       JSON_NODE_HOLDS_OBJECT (root) &&
       (obj = json_node_get_object (root)))
-    gbp_meson_introspection_load_json (self, obj);
+    {
+      for (guint i = 0; i < G_N_ELEMENTS (sections); i++)
+        {
+          JsonNode *member;
+          GVariant *value;
+
+          if (json_object_has_member (obj, sections[i].name) &&
+              (member = json_object_get_member (obj, sections[i].name)) &&
+              (value = sections[i].load (member)))
+            g_variant_builder_add (&builder, "{s(xv)}", sections[i].name, (gint64)0, value);
+        }
+    }
+
+  cache = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  g_set_str (&self->etag, etag);
+  gbp_meson_introspection_apply (self, cache);
 
   ide_task_return_boolean (task, TRUE);
 
@@ -515,18 +778,13 @@ gbp_meson_introspection_load_stream_cb (GObject      *object,
 }
 
 static void
-gbp_meson_introspection_build_async (IdePipelineStage    *stage,
-                                     IdePipeline         *pipeline,
-                                     GCancellable        *cancellable,
-                                     GAsyncReadyCallback  callback,
-                                     gpointer             user_data)
+gbp_meson_introspection_spawn (GbpMesonIntrospection *self,
+                               IdeTask               *task)
 {
-  GbpMesonIntrospection *self = (GbpMesonIntrospection *)stage;
   g_autoptr(IdeRunContext) run_context = NULL;
   g_autoptr(IdeSubprocess) subprocess = NULL;
   g_autoptr(JsonParser) parser = NULL;
   g_autoptr(GIOStream) io_stream = NULL;
-  g_autoptr(IdeTask) task = NULL;
   g_autoptr(GError) error = NULL;
   g_autofree char *meson = NULL;
   IdeBuildSystem *build_system;
@@ -535,25 +793,27 @@ gbp_meson_introspection_build_async (IdePipelineStage    *stage,
   IDE_ENTRY;
 
   g_assert (GBP_IS_MESON_INTROSPECTION (self));
-  g_assert (IDE_IS_PIPELINE (pipeline));
-  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
-
-  self->has_built_once = TRUE;
+  g_assert (IDE_IS_TASK (task));
 
-  task = ide_task_new (self, cancellable, callback, user_data);
-  ide_task_set_source_tag (task, gbp_meson_introspection_build_async);
-  ide_task_set_task_data (task, get_current_etag (pipeline), g_free);
+  if (self->pipeline == NULL)
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_CANCELLED,
+                                 "The pipeline was disposed");
+      IDE_EXIT;
+    }
 
   context = ide_object_get_context (IDE_OBJECT (self));
   build_system = ide_build_system_from_context (context);
-  meson = gbp_meson_build_system_locate_meson (GBP_MESON_BUILD_SYSTEM (build_system), pipeline);
+  meson = gbp_meson_build_system_locate_meson (GBP_MESON_BUILD_SYSTEM (build_system), self->pipeline);
 
   g_assert (IDE_IS_CONTEXT (context));
   g_assert (GBP_IS_MESON_BUILD_SYSTEM (build_system));
   g_assert (meson != NULL);
 
   run_context = ide_run_context_new ();
-  ide_pipeline_prepare_run_context (pipeline, run_context);
+  ide_pipeline_prepare_run_context (self->pipeline, run_context);
   ide_run_context_append_args (run_context, IDE_STRV_INIT (meson, "introspect", "--all", "--force-object-output"));
 
   /* Create a stream to communicate with the subprocess and then spawn it */
@@ -574,9 +834,9 @@ gbp_meson_introspection_build_async (IdePipelineStage    *stage,
   parser = json_parser_new ();
   json_parser_load_from_stream_async (parser,
                                       g_io_stream_get_input_stream (io_stream),
-                                      cancellable,
+                                      ide_task_get_cancellable (task),
                                       gbp_meson_introspection_load_stream_cb,
-                                      g_steal_pointer (&task));
+                                      g_object_ref (task));
 
   /* Make sure something watches the child */
   ide_subprocess_wait_async (subprocess, NULL, NULL, NULL);
@@ -584,6 +844,92 @@ gbp_meson_introspection_build_async (IdePipelineStage    *stage,
   IDE_EXIT;
 }
 
+static void
+gbp_meson_introspection_read_cb (GObject      *object,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  GbpMesonIntrospection *self = (GbpMesonIntrospection *)object;
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GVariant) cache = NULL;
+  g_autoptr(GError) error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (GBP_IS_MESON_INTROSPECTION (self));
+  g_assert (IDE_IS_TASK (result));
+  g_assert (IDE_IS_TASK (task));
+
+  if (!(cache = ide_task_propagate_pointer (IDE_TASK (result), &error)))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          ide_task_return_error (task, g_steal_pointer (&error));
+          IDE_EXIT;
+        }
+
+      g_debug ("Falling back to meson introspect: %s", error->message);
+      gbp_meson_introspection_spawn (self, task);
+      IDE_EXIT;
+    }
+
+  /* Nothing to do if none of the sections changed since the last pass */
+  if (self->cache == NULL || !g_variant_equal (self->cache, cache))
+    {
+      g_clear_pointer (&self->cache, g_variant_unref);
+      self->cache = g_variant_ref (cache);
+      gbp_meson_introspection_apply (self, cache);
+    }
+
+  g_set_str (&self->etag, ide_task_get_task_data (task));
+
+  ide_task_return_boolean (task, TRUE);
+
+  IDE_EXIT;
+}
+
+static void
+gbp_meson_introspection_build_async (IdePipelineStage    *stage,
+                                     IdePipeline         *pipeline,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  GbpMesonIntrospection *self = (GbpMesonIntrospection *)stage;
+  g_autoptr(IdeTask) read_task = NULL;
+  g_autoptr(IdeTask) task = NULL;
+  Read *read;
+
+  IDE_ENTRY;
+
+  g_assert (GBP_IS_MESON_INTROSPECTION (self));
+  g_assert (IDE_IS_PIPELINE (pipeline));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  self->has_built_once = TRUE;
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_meson_introspection_build_async);
+  ide_task_set_task_data (task, get_current_etag (pipeline), g_free);
+
+  /* Meson writes each section of the introspection data to meson-info/
+   * when configuring, so read those directly rather than spawning
+   * `meson introspect` and only parse the sections which changed.
+   */
+  read = g_slice_new0 (Read);
+  read->meson_info_dir = ide_pipeline_build_builddir_path (pipeline, "meson-info", NULL);
+  read->cache_path = ide_pipeline_build_builddir_path (pipeline, "gnome-builder-introspection.gvariant", NULL);
+  read->previous = self->cache ? g_variant_ref (self->cache) : NULL;
+
+  read_task = ide_task_new (self, cancellable, gbp_meson_introspection_read_cb, g_steal_pointer (&task));
+  ide_task_set_source_tag (read_task, gbp_meson_introspection_read_worker);
+  ide_task_set_task_data (read_task, read, read_free);
+  ide_task_run_in_thread (read_task, gbp_meson_introspection_read_worker);
+
+  IDE_EXIT;
+}
+
 static gboolean
 gbp_meson_introspection_build_finish (IdePipelineStage  *stage,
                                       GAsyncResult      *result,
@@ -612,6 +958,7 @@ gbp_meson_introspection_destroy (IdeObject *object)
   g_clear_pointer (&self->subproject_dir, g_free);
   g_clear_pointer (&self->version, g_free);
   g_clear_pointer (&self->etag, g_free);
+  g_clear_pointer (&self->cache, g_variant_unref);
 
   g_clear_weak_pointer (&self->pipeline);
 
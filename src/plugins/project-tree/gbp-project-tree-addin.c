@@ -22,6 +22,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib/gi18n.h>
 
 #include <libide-gui.h>
@@ -51,35 +53,73 @@ typedef struct
   IdeTreeNode *node;
 } FindFileNode;
 
-static gboolean
-project_file_is_ignored (IdeProjectFile *project_file,
-                         IdeVcs         *vcs)
+/* Number of nodes created per main loop iteration when populating a
+ * directory, so that huge directories do not stall the UI.
+ */
+#define BUILD_CHUNK_SIZE 500
+
+/* Number of GFileInfo requested from the enumerator at a time */
+#define ENUMERATE_CHUNK_SIZE 1000
+
+typedef struct
+{
+  GFile       *directory;
+  IdeVcs      *vcs;
+  GPtrArray   *infos;
+  IdeTreeNode *node;
+  guint        position;
+  guint        sort_directories_first : 1;
+  guint        show_ignored_files : 1;
+} ListChildren;
+
+typedef struct
+{
+  char      *key;
+  GFileInfo *info;
+  gboolean   is_dir;
+} SortEntry;
+
+static void
+list_children_free (ListChildren *state)
 {
-  g_autoptr(GFile) file = NULL;
+  g_clear_object (&state->directory);
+  g_clear_object (&state->vcs);
+  g_clear_object (&state->node);
+  g_clear_pointer (&state->infos, g_ptr_array_unref);
+  g_slice_free (ListChildren, state);
+}
 
-  g_assert (IDE_IS_PROJECT_FILE (project_file));
+static void
+sort_entry_clear (gpointer data)
+{
+  SortEntry *entry = data;
 
-  file = ide_project_file_ref_file (project_file);
+  g_clear_pointer (&entry->key, g_free);
+  g_clear_object (&entry->info);
+}
 
-  return ide_vcs_is_ignored (vcs, file, NULL);
+static int
+compare_entries (gconstpointer a,
+                 gconstpointer b)
+{
+  const SortEntry *entry_a = a;
+  const SortEntry *entry_b = b;
+
+  return strcmp (entry_a->key, entry_b->key);
 }
 
-static gint
-compare_files (gconstpointer a,
-               gconstpointer b,
-               gpointer      user_data)
+static int
+compare_entries_directories_first (gconstpointer a,
+                                   gconstpointer b)
 {
-  GbpProjectTreeAddin *self = user_data;
-  IdeProjectFile *file_a = *(IdeProjectFile **)a;
-  IdeProjectFile *file_b = *(IdeProjectFile **)b;
+  const SortEntry *entry_a = a;
+  const SortEntry *entry_b = b;
+  int ret;
 
-  g_assert (IDE_IS_PROJECT_FILE (file_a));
-  g_assert (IDE_IS_PROJECT_FILE (file_b));
+  if (!(ret = entry_b->is_dir - entry_a->is_dir))
+    ret = strcmp (entry_a->key, entry_b->key);
 
-  if (self->sort_directories_first)
-    return ide_project_file_compare_directories_first (file_a, file_b);
-  else
-    return ide_project_file_compare (file_a, file_b);
+  return ret;
 }
 
 static IdeTreeNode *
@@ -105,68 +145,159 @@ create_file_node (IdeProjectFile *file)
 }
 
 static void
-gbp_project_tree_addin_file_list_children_cb (GObject      *object,
-                                              GAsyncResult *result,
-                                              gpointer      user_data)
+gbp_project_tree_addin_list_children_worker (IdeTask      *task,
+                                             gpointer      source_object,
+                                             gpointer      task_data,
+                                             GCancellable *cancellable)
 {
-  IdeProjectFile *project_file = (IdeProjectFile *)object;
-  g_autoptr(IdeTask) task = user_data;
-  g_autoptr(GPtrArray) children = NULL;
+  g_autoptr(GFileEnumerator) enumerator = NULL;
+  g_autoptr(GArray) entries = NULL;
   g_autoptr(GError) error = NULL;
-  GbpProjectTreeAddin *self;
-  IdeTreeNode *last = NULL;
-  IdeTreeNode *node;
-  IdeTreeNode *root;
-  IdeContext *context;
-  IdeVcs *vcs;
+  ListChildren *state = task_data;
+  GList *infos;
 
-  g_assert (IDE_IS_PROJECT_FILE (project_file));
-  g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
-
-  if (!(children = ide_project_file_list_children_finish (project_file, result, &error)))
+  g_assert (state != NULL);
+  g_assert (G_IS_FILE (state->directory));
+
+  if (!(enumerator = g_file_enumerate_children (state->directory,
+                                                IDE_PROJECT_FILE_ATTRIBUTES,
+                                                G_FILE_QUERY_INFO_NONE,
+                                                cancellable,
+                                                &error)))
     {
       ide_task_return_error (task, g_steal_pointer (&error));
       return;
     }
 
-  IDE_PTR_ARRAY_SET_FREE_FUNC (children, g_object_unref);
+  entries = g_array_new (FALSE, FALSE, sizeof (SortEntry));
+  g_array_set_clear_func (entries, sort_entry_clear);
+
+  /* Everything which scales with the number of children (checking the
+   * VCS for ignored files and collating names for sorting) happens here
+   * rather than on the main thread.
+   */
+  while ((infos = g_file_enumerator_next_files (enumerator,
+                                                ENUMERATE_CHUNK_SIZE,
+                                                cancellable,
+                                                &error)))
+    {
+      for (const GList *iter = infos; iter; iter = iter->next)
+        {
+          GFileInfo *info = iter->data;
+          SortEntry entry;
 
-  self = ide_task_get_source_object (task);
-  node = ide_task_get_task_data (task);
-  root = ide_tree_node_get_root (node);
-  context = ide_tree_node_get_item (root);
-  vcs = ide_vcs_from_context (context);
+          if (!state->show_ignored_files)
+            {
+              g_autoptr(GFile) child = g_file_enumerator_get_child (enumerator, info);
 
-  g_assert (GBP_IS_PROJECT_TREE_ADDIN (self));
-  g_assert (IDE_IS_TREE_NODE (node));
+              if (ide_vcs_is_ignored (state->vcs, child, NULL))
+                continue;
+            }
+
+          entry.key = g_utf8_collate_key_for_filename (g_file_info_get_display_name (info), -1);
+          entry.info = g_object_ref (info);
+          entry.is_dir = g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY;
+
+          g_array_append_val (entries, entry);
+        }
 
-  g_ptr_array_sort_with_data (children, compare_files, self);
+      g_list_free_full (infos, g_object_unref);
+    }
 
-  for (guint i = 0; i < children->len; i++)
+  if (error != NULL)
     {
-      IdeProjectFile *file = g_ptr_array_index (children, i);
-      g_autoptr(IdeTreeNode) child = NULL;
+      ide_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
 
-      if (!self->show_ignored_files)
-        {
-          if (project_file_is_ignored (file, vcs))
-            continue;
-        }
+  if (state->sort_directories_first)
+    g_array_sort (entries, compare_entries_directories_first);
+  else
+    g_array_sort (entries, compare_entries);
 
-      ide_object_append (IDE_OBJECT (project_file), IDE_OBJECT (file));
+  state->infos = g_ptr_array_new_full (entries->len, g_object_unref);
 
-      child = create_file_node (file);
+  for (guint i = 0; i < entries->len; i++)
+    {
+      SortEntry *entry = &g_array_index (entries, SortEntry, i);
+      g_ptr_array_add (state->infos, g_steal_pointer (&entry->info));
+    }
 
-      if (last == NULL)
-        ide_tree_node_insert_before (child, node, NULL);
-      else
-        ide_tree_node_insert_after (child, node, last);
+  ide_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+gbp_project_tree_addin_populate_cb (gpointer user_data)
+{
+  IdeTask *task = user_data;
+  g_autoptr(GPtrArray) nodes = NULL;
+  IdeProjectFile *project_file;
+  ListChildren *state;
+  guint end;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_TASK (task));
+
+  state = ide_task_get_task_data (task);
+
+  g_assert (state != NULL);
+  g_assert (IDE_IS_TREE_NODE (state->node));
+  g_assert (state->infos != NULL);
+
+  if (ide_task_return_error_if_cancelled (task))
+    return G_SOURCE_REMOVE;
+
+  project_file = ide_tree_node_get_item (state->node);
+  end = MIN (state->position + BUILD_CHUNK_SIZE, state->infos->len);
+  nodes = g_ptr_array_new_full (end - state->position, g_object_unref);
+
+  for (; state->position < end; state->position++)
+    {
+      GFileInfo *info = g_ptr_array_index (state->infos, state->position);
+      g_autoptr(IdeProjectFile) file = ide_project_file_new (state->directory, info);
 
-      last = child;
+      ide_object_append (IDE_OBJECT (project_file), IDE_OBJECT (file));
+      g_ptr_array_add (nodes, create_file_node (file));
     }
 
+  ide_tree_node_append_children (state->node,
+                                 (IdeTreeNode **)(gpointer)nodes->pdata,
+                                 nodes->len);
+
+  if (state->position < state->infos->len)
+    return G_SOURCE_CONTINUE;
+
   ide_task_return_boolean (task, TRUE);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gbp_project_tree_addin_list_children_cb (GObject      *object,
+                                         GAsyncResult *result,
+                                         gpointer      user_data)
+{
+  g_autoptr(IdeTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_TASK (result));
+  g_assert (IDE_IS_TASK (task));
+
+  if (!ide_task_propagate_boolean (IDE_TASK (result), &error))
+    {
+      ide_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  /* Create the nodes in chunks from the main loop so that directories
+   * with tens of thousands of entries do not block input and drawing.
+   */
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                   gbp_project_tree_addin_populate_cb,
+                   g_steal_pointer (&task),
+                   g_object_unref);
 }
 
 static void
@@ -184,7 +315,6 @@ gbp_project_tree_addin_build_children_async (IdeTreeAddin        *addin,
 
   task = ide_task_new (addin, cancellable, callback, user_data);
   ide_task_set_source_tag (task, gbp_project_tree_addin_build_children_async);
-  ide_task_set_task_data (task, g_object_ref (node), g_object_unref);
 
   if (ide_tree_node_holds (node, IDE_TYPE_CONTEXT))
     {
@@ -216,12 +346,28 @@ gbp_project_tree_addin_build_children_async (IdeTreeAddin        *addin,
     }
   else if (ide_tree_node_holds (node, IDE_TYPE_PROJECT_FILE))
     {
+      GbpProjectTreeAddin *self = (GbpProjectTreeAddin *)addin;
       IdeProjectFile *project_file = ide_tree_node_get_item (node);
-
-      ide_project_file_list_children_async (project_file,
-                                            cancellable,
-                                            gbp_project_tree_addin_file_list_children_cb,
-                                            g_steal_pointer (&task));
+      IdeContext *context = ide_tree_node_get_item (ide_tree_node_get_root (node));
+      g_autoptr(IdeTask) list_task = NULL;
+      ListChildren *state;
+
+      state = g_slice_new0 (ListChildren);
+      state->directory = ide_project_file_ref_file (project_file);
+      g_set_object (&state->vcs, ide_vcs_from_context (context));
+      state->node = g_object_ref (node);
+      state->sort_directories_first = self->sort_directories_first;
+      state->show_ignored_files = self->show_ignored_files;
+      ide_task_set_task_data (task, state, list_children_free);
+
+      /* The inner task borrows @state from @task which outlives it */
+      list_task = ide_task_new (addin,
+                                cancellable,
+                                gbp_project_tree_addin_list_children_cb,
+                                g_steal_pointer (&task));
+      ide_task_set_source_tag (list_task, gbp_project_tree_addin_list_children_worker);
+      ide_task_set_task_data (list_task, state, NULL);
+      ide_task_run_in_thread (list_task, gbp_project_tree_addin_list_children_worker);
 
       return;
     }
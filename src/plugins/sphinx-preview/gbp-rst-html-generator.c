@@ -22,13 +22,11 @@
 
 #include "config.h"
 
-#include <errno.h>
-
 #include <libide-code.h>
-#include <libide-foundry.h>
 #include <libide-threading.h>
 
 #include "gbp-rst-html-generator.h"
+#include "gbp-sphinx-renderer.h"
 
 struct _GbpRstHtmlGenerator
 {
@@ -45,54 +43,32 @@ enum {
 G_DEFINE_FINAL_TYPE (GbpRstHtmlGenerator, gbp_rst_html_generator, IDE_TYPE_HTML_GENERATOR)
 
 static GParamSpec *properties [N_PROPS];
-static GBytes *rst2html;
 
 static void
-gbp_rst_html_generator_communicate_cb (GObject      *object,
-                                       GAsyncResult *result,
-                                       gpointer      user_data)
+gbp_rst_html_generator_render_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
 {
-  IdeSubprocess *subprocess = (IdeSubprocess *)object;
+  GbpSphinxRenderer *renderer = (GbpSphinxRenderer *)object;
   g_autoptr(IdeTask) task = user_data;
-  g_autoptr(GBytes) bytes = NULL;
   g_autoptr(GError) error = NULL;
-  g_autofree char *stdout_buf = NULL;
-  gsize len;
+  char *html;
 
-  g_assert (IDE_IS_SUBPROCESS (subprocess));
+  g_assert (GBP_IS_SPHINX_RENDERER (renderer));
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
 
-  if (!ide_subprocess_communicate_utf8_finish (subprocess, result, &stdout_buf, NULL, &error))
+  if (!(html = gbp_sphinx_renderer_render_finish (renderer, result, &error)))
     {
       ide_task_return_error (task, g_steal_pointer (&error));
       return;
     }
 
-  len = strlen (stdout_buf);
-  bytes = g_bytes_new_take (g_steal_pointer (&stdout_buf), len);
-
   ide_task_return_pointer (task,
-                           g_steal_pointer (&bytes),
+                           g_bytes_new_take (html, strlen (html)),
                            g_bytes_unref);
 }
 
-static const char *
-find_python (void)
-{
-  static const char *python;
-
-  if (python == NULL)
-    {
-      if (g_find_program_in_path ("python3"))
-        python = "python3";
-      else
-        python = "python";
-    }
-
-  return python;
-}
-
 static void
 gbp_rst_html_generator_generate_async (IdeHtmlGenerator    *generator,
                                        GCancellable        *cancellable,
@@ -100,17 +76,11 @@ gbp_rst_html_generator_generate_async (IdeHtmlGenerator    *generator,
                                        gpointer             user_data)
 {
   GbpRstHtmlGenerator *self = (GbpRstHtmlGenerator *)generator;
-  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
-  g_autoptr(IdeSubprocess) subprocess = NULL;
+  g_autoptr(IdeContext) context = NULL;
   g_autoptr(IdeBuffer) buffer = NULL;
   g_autoptr(IdeTask) task = NULL;
-  g_autoptr(GError) error = NULL;
   g_autoptr(GBytes) content = NULL;
-  GSubprocessFlags flags;
-  const char *python;
-  const char *source_path;
-  GFile *file;
-  int fd;
+  GbpSphinxRenderer *renderer;
 
   g_assert (GBP_IS_RST_HTML_GENERATOR (self));
   g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
@@ -118,7 +88,9 @@ gbp_rst_html_generator_generate_async (IdeHtmlGenerator    *generator,
   task = ide_task_new (self, cancellable, callback, user_data);
   ide_task_set_source_tag (task, gbp_rst_html_generator_generate_async);
 
-  if (!(buffer = g_signal_group_dup_target (self->buffer_signals)))
+  if (!(buffer = g_signal_group_dup_target (self->buffer_signals)) ||
+      !(context = ide_buffer_ref_context (buffer)) ||
+      ide_object_in_destruction (IDE_OBJECT (context)))
     {
       ide_task_return_new_error (task,
                                  G_IO_ERROR,
@@ -127,42 +99,18 @@ gbp_rst_html_generator_generate_async (IdeHtmlGenerator    *generator,
       return;
     }
 
+  /* The renderer is shared by every preview in the context and keeps a
+   * single python process with docutils loaded around between renders.
+   */
+  renderer = gbp_sphinx_renderer_from_context (context);
   content = ide_buffer_dup_content (buffer);
-  file = ide_buffer_get_file (buffer);
-  source_path = g_file_peek_path (file);
 
-  if (-1 == (fd = ide_foundry_bytes_to_memfd (content, "rst2html-input")))
-    {
-      int errsv = errno;
-      ide_task_return_new_error (task,
-                                 G_IO_ERROR,
-                                 g_io_error_from_errno (errsv),
-                                 "%s",
-                                 g_strerror (errsv));
-      return;
-    }
-
-  python = find_python ();
-  flags = G_SUBPROCESS_FLAGS_STDOUT_PIPE|G_SUBPROCESS_FLAGS_STDIN_PIPE;
-
-  if (!g_getenv ("RST_DEBUG"))
-    flags |= G_SUBPROCESS_FLAGS_STDERR_SILENCE;
-
-  launcher = ide_subprocess_launcher_new (flags);
-  ide_subprocess_launcher_push_args (launcher, IDE_STRV_INIT (python, "-", source_path));
-  ide_subprocess_launcher_take_fd (launcher, fd, 3);
-
-  if (!(subprocess = ide_subprocess_launcher_spawn (launcher, cancellable, &error)))
-    {
-      ide_task_return_error (task, g_steal_pointer (&error));
-      return;
-    }
-
-  ide_subprocess_communicate_utf8_async (subprocess,
-                                         (const char *)g_bytes_get_data (rst2html, NULL),
-                                         cancellable,
-                                         gbp_rst_html_generator_communicate_cb,
-                                         g_steal_pointer (&task));
+  gbp_sphinx_renderer_render_async (renderer,
+                                    ide_buffer_get_file (buffer),
+                                    content,
+                                    cancellable,
+                                    gbp_rst_html_generator_render_cb,
+                                    g_steal_pointer (&task));
 }
 
 static GBytes *
@@ -272,8 +220,6 @@ gbp_rst_html_generator_class_init (GbpRstHtmlGeneratorClass *klass)
                           G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_properties (object_class, N_PROPS, properties);
-
-  rst2html = g_resources_lookup_data ("/plugins/sphinx-preview/rst2html.py", 0, NULL);
 }
 
 static void
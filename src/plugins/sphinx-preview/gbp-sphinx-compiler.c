@@ -22,19 +22,19 @@
 
 #include "config.h"
 
-#include <glib/gstdio.h>
-
 #include <libide-io.h>
 #include <libide-threading.h>
 
 #include "gbp-sphinx-compiler.h"
+#include "gbp-sphinx-renderer.h"
 
 struct _GbpSphinxCompiler
 {
-  GObject  parent_instance;
-  GFile   *config_file;
-  GFile   *basedir;
-  GFile   *builddir;
+  GObject            parent_instance;
+  GbpSphinxRenderer *renderer;
+  GFile             *config_file;
+  GFile             *basedir;
+  GFile             *builddir;
 };
 
 G_DEFINE_FINAL_TYPE (GbpSphinxCompiler, gbp_sphinx_compiler, G_TYPE_OBJECT)
@@ -42,18 +42,22 @@ G_DEFINE_FINAL_TYPE (GbpSphinxCompiler, gbp_sphinx_compiler, G_TYPE_OBJECT)
 enum {
   PROP_0,
   PROP_CONFIG_FILE,
+  PROP_RENDERER,
   N_PROPS
 };
 
 static GParamSpec *properties [N_PROPS];
 
 GbpSphinxCompiler *
-gbp_sphinx_compiler_new (GFile *config_file)
+gbp_sphinx_compiler_new (GbpSphinxRenderer *renderer,
+                         GFile             *config_file)
 {
+  g_return_val_if_fail (GBP_IS_SPHINX_RENDERER (renderer), NULL);
   g_return_val_if_fail (G_IS_FILE (config_file), NULL);
 
   return g_object_new (GBP_TYPE_SPHINX_COMPILER,
                        "config-file", config_file,
+                       "renderer", renderer,
                        NULL);
 }
 
@@ -101,7 +105,9 @@ gbp_sphinx_compiler_constructed (GObject *object)
 
   G_OBJECT_CLASS (gbp_sphinx_compiler_parent_class)->constructed (object);
 
-  if (self->config_file == NULL)
+  if (self->renderer == NULL)
+    g_critical ("%s created without a renderer", G_OBJECT_TYPE_NAME (self));
+  else if (self->config_file == NULL)
     g_critical ("%s created without a config-file", G_OBJECT_TYPE_NAME (self));
   else if (!(self->basedir = g_file_get_parent (self->config_file)))
     g_critical ("Implausible GFile used as config-file");
@@ -128,6 +134,7 @@ gbp_sphinx_compiler_finalize (GObject *object)
 
   g_clear_object (&self->config_file);
   g_clear_object (&self->basedir);
+  g_clear_object (&self->renderer);
 
   G_OBJECT_CLASS (gbp_sphinx_compiler_parent_class)->finalize (object);
 }
@@ -146,6 +153,10 @@ gbp_sphinx_compiler_get_property (GObject    *object,
       g_value_set_object (value, self->config_file);
       break;
 
+    case PROP_RENDERER:
+      g_value_set_object (value, self->renderer);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -165,6 +176,10 @@ gbp_sphinx_compiler_set_property (GObject      *object,
       self->config_file = g_value_dup_object (value);
       break;
 
+    case PROP_RENDERER:
+      self->renderer = g_value_dup_object (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -187,6 +202,13 @@ gbp_sphinx_compiler_class_init (GbpSphinxCompilerClass *klass)
                          G_TYPE_FILE,
                          (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
 
+  properties [PROP_RENDERER] =
+    g_param_spec_object ("renderer",
+                         "Renderer",
+                         "The render server used to build documents",
+                         GBP_TYPE_SPHINX_RENDERER,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_properties (object_class, N_PROPS, properties);
 }
 
@@ -196,104 +218,25 @@ gbp_sphinx_compiler_init (GbpSphinxCompiler *self)
 }
 
 static void
-gbp_sphinx_compiler_load_cb (GObject      *object,
-                             GAsyncResult *result,
-                             gpointer      user_data)
+gbp_sphinx_compiler_build_cb (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
 {
-  GFile *file = (GFile *)object;
+  GbpSphinxRenderer *renderer = (GbpSphinxRenderer *)object;
   g_autoptr(IdeTask) task = user_data;
   g_autoptr(GError) error = NULL;
-  g_autofree char *contents = NULL;
-  gsize len;
+  char *html;
 
   IDE_ENTRY;
 
-  g_assert (G_IS_FILE (file));
+  g_assert (GBP_IS_SPHINX_RENDERER (renderer));
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (IDE_IS_TASK (task));
 
-  if (!g_file_load_contents_finish (file, result, &contents, &len, NULL, &error))
+  if (!(html = gbp_sphinx_renderer_build_finish (renderer, result, &error)))
     ide_task_return_error (task, g_steal_pointer (&error));
   else
-    ide_task_return_pointer (task, g_steal_pointer (&contents), g_free);
-
-  IDE_EXIT;
-}
-
-static void
-gbp_sphinx_compiler_compile_cb (GObject      *object,
-                                GAsyncResult *result,
-                                gpointer      user_data)
-{
-  IdeSubprocess *subprocess = (IdeSubprocess *)object;
-  g_autoptr(IdeTask) task = user_data;
-  g_autoptr(GError) error = NULL;
-  GCancellable *cancellable;
-  GFile *dest;
-
-  IDE_ENTRY;
-
-  g_assert (IDE_IS_SUBPROCESS (subprocess));
-  g_assert (G_IS_ASYNC_RESULT (result));
-  g_assert (IDE_IS_TASK (task));
-
-  if (!ide_subprocess_wait_check_finish (subprocess, result, &error))
-    {
-      ide_task_return_error (task, g_steal_pointer (&error));
-      IDE_EXIT;
-    }
-
-  dest = ide_task_get_task_data (task);
-  cancellable = ide_task_get_cancellable (task);
-
-  g_assert (G_IS_FILE (dest));
-  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
-
-  g_file_load_contents_async (dest,
-                              cancellable,
-                              gbp_sphinx_compiler_load_cb,
-                              g_steal_pointer (&task));
-
-  IDE_EXIT;
-}
-
-static char *
-replace_suffix (const char *str,
-                const char *suffix)
-{
-  const char *dot = strrchr (str, '.');
-  char *shortened;
-  char *ret;
-
-  if (dot == NULL)
-    return g_strdup (str);
-
-  shortened = g_strndup (str, dot - str);
-  ret = g_strconcat (shortened, suffix, NULL);
-  g_free (shortened);
-
-  return ret;
-}
-
-static void
-gbp_sphinx_compiler_purge_doctree (GbpSphinxCompiler *self,
-                                   const char        *relpath)
-{
-  g_autofree char *doctreepath = NULL;
-  g_autofree char *fullpath = NULL;
-
-  IDE_ENTRY;
-
-  g_assert (GBP_IS_SPHINX_COMPILER (self));
-  g_assert (relpath != NULL);
-
-  doctreepath = replace_suffix (relpath, ".doctree");
-  fullpath = g_build_filename (g_file_peek_path (self->builddir),
-                               ".doctrees",
-                               doctreepath,
-                               NULL);
-
-  g_unlink (fullpath);
+    ide_task_return_pointer (task, html, g_free);
 
   IDE_EXIT;
 }
@@ -306,14 +249,8 @@ gbp_sphinx_compiler_compile_async (GbpSphinxCompiler   *self,
                                    GAsyncReadyCallback  callback,
                                    gpointer             user_data)
 {
-  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
-  g_autoptr(IdeSubprocess) subprocess = NULL;
   g_autoptr(IdeTask) task = NULL;
-  g_autoptr(GError) error = NULL;
-  g_autoptr(GFile) tu = NULL;
-  g_autofree char *relpath = NULL;
-  g_autofree char *htmlpath = NULL;
-  const char *path;
+  g_autoptr(GBytes) bytes = NULL;
 
   IDE_ENTRY;
 
@@ -325,41 +262,26 @@ gbp_sphinx_compiler_compile_async (GbpSphinxCompiler   *self,
   task = ide_task_new (self, cancellable, callback, user_data);
   ide_task_set_source_tag (task, gbp_sphinx_compiler_compile_async);
 
-  if (!g_file_is_native (file))
+  if (!g_file_is_native (file) || self->builddir == NULL)
     {
       ide_task_return_unsupported_error (task);
       IDE_EXIT;
     }
 
-  path = g_file_peek_path (file);
-  relpath = g_file_get_relative_path (self->basedir, file);
-  htmlpath = replace_suffix (relpath, ".html");
-  tu = g_file_get_child (self->builddir, htmlpath);
-  ide_task_set_task_data (task, g_steal_pointer (&tu), g_object_unref);
-
-  gbp_sphinx_compiler_purge_doctree (self, relpath);
-
-  g_assert (path != NULL);
-  g_assert (G_IS_FILE (self->basedir));
-  g_assert (G_IS_FILE (self->builddir));
-  g_assert (g_file_peek_path (self->basedir) != NULL);
-  g_assert (g_file_peek_path (self->builddir) != NULL);
-
-  launcher = ide_subprocess_launcher_new (0);
-  ide_subprocess_launcher_push_args (launcher, IDE_STRV_INIT ("sphinx-build", "-Q", "-b", "html"));
-  ide_subprocess_launcher_push_argv (launcher, g_file_peek_path (self->basedir));
-  ide_subprocess_launcher_push_argv (launcher, g_file_peek_path (self->builddir));
-  ide_subprocess_launcher_push_argv (launcher, path);
-
-  if (!(subprocess = ide_subprocess_launcher_spawn (launcher, cancellable, &error)))
-    {
-      ide_task_return_error (task, g_steal_pointer (&error));
-      IDE_EXIT;
-    }
-
-  ide_subprocess_wait_check_async (subprocess,
+  /* The render server keeps the sphinx environment for @basedir alive
+   * between builds, so only the document that changed is re-read and
+   * written. Unsaved @contents are substituted for what is on disk.
+   */
+  if (contents != NULL)
+    bytes = g_bytes_new (contents, strlen (contents) + 1);
+
+  gbp_sphinx_renderer_build_async (self->renderer,
+                                   self->basedir,
+                                   self->builddir,
+                                   file,
+                                   bytes,
                                    cancellable,
-                                   gbp_sphinx_compiler_compile_cb,
+                                   gbp_sphinx_compiler_build_cb,
                                    g_steal_pointer (&task));
 
   IDE_EXIT;
@@ -22,13 +22,16 @@
 
 #include <gio/gio.h>
 
+#include "gbp-sphinx-renderer.h"
+
 G_BEGIN_DECLS
 
 #define GBP_TYPE_SPHINX_COMPILER (gbp_sphinx_compiler_get_type())
 
 G_DECLARE_FINAL_TYPE (GbpSphinxCompiler, gbp_sphinx_compiler, GBP, SPHINX_COMPILER, GObject)
 
-GbpSphinxCompiler *gbp_sphinx_compiler_new            (GFile               *config_file);
+GbpSphinxCompiler *gbp_sphinx_compiler_new            (GbpSphinxRenderer   *renderer,
+                                                       GFile               *config_file);
 void               gbp_sphinx_compiler_compile_async  (GbpSphinxCompiler   *self,
                                                        GFile               *file,
                                                        const char          *contents,
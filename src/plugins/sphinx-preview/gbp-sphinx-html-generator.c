@@ -82,6 +82,7 @@ gbp_sphinx_html_generator_generate_async (IdeHtmlGenerator    *generator,
   GbpSphinxHtmlGenerator *self = (GbpSphinxHtmlGenerator *)generator;
   g_autoptr(IdeBuffer) buffer = NULL;
   g_autoptr(IdeTask) task = NULL;
+  g_autoptr(GBytes) content = NULL;
   GFile *file;
 
   g_assert (GBP_IS_SPHINX_HTML_GENERATOR (self));
@@ -100,11 +101,13 @@ gbp_sphinx_html_generator_generate_async (IdeHtmlGenerator    *generator,
       return;
     }
 
+  /* Build from the buffer so that unsaved changes are previewed too */
   file = ide_buffer_get_file (buffer);
+  content = ide_buffer_dup_content (buffer);
 
   gbp_sphinx_compiler_compile_async (self->compiler,
                                      file,
-                                     NULL,
+                                     (const char *)g_bytes_get_data (content, NULL),
                                      cancellable,
                                      gbp_sphinx_html_generator_compile_cb,
                                      g_steal_pointer (&task));
@@ -31,6 +31,7 @@
 #include "gbp-sphinx-compiler.h"
 #include "gbp-sphinx-html-generator.h"
 #include "gbp-sphinx-preview-workspace-addin.h"
+#include "gbp-sphinx-renderer.h"
 
 struct _GbpSphinxPreviewWorkspaceAddin
 {
@@ -229,7 +230,10 @@ open_sphinx_preview (GbpSphinxPreviewWorkspaceAddin *self,
 
   if (!(compiler = g_hash_table_lookup (self->compilers, conf_py)))
     {
-      compiler = gbp_sphinx_compiler_new (conf_py);
+      IdeContext *context = ide_workspace_get_context (self->workspace);
+      GbpSphinxRenderer *renderer = gbp_sphinx_renderer_from_context (context);
+
+      compiler = gbp_sphinx_compiler_new (renderer, conf_py);
       g_hash_table_insert (self->compilers, g_file_dup (conf_py), compiler);
     }
 
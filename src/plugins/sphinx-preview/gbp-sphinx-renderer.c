@@ -0,0 +1,712 @@
+/* gbp-sphinx-renderer.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "gbp-sphinx-renderer"
+
+#include "config.h"
+
+#include <gio/gunixinputstream.h>
+#include <gio/gunixoutputstream.h>
+#include <glib-unix.h>
+#include <jsonrpc-glib.h>
+
+#include <libide-threading.h>
+
+#include "gbp-sphinx-renderer.h"
+
+/* GbpSphinxRenderer keeps a single Python process around which has docutils
+ * and sphinx imported (see sphinx-render-server.py) so that previews do not
+ * pay for interpreter start-up on every change.
+ *
+ * Only one request per document is sent to the server at a time. Requests
+ * made while one is active are coalesced so that once the active request
+ * completes, only the newest contents are rendered and that result is
+ * delivered to everyone who asked in the mean time.
+ */
+
+struct _GbpSphinxRenderer
+{
+  IdeObject                parent_instance;
+  IdeSubprocessSupervisor *supervisor;
+  JsonrpcClient           *rpc_client;
+  GQueue                   get_client;
+
+  /* "method:uri" -> Render */
+  GHashTable              *renders;
+
+  int                      state;
+};
+
+enum {
+  STATE_INITIAL,
+  STATE_SPAWNING,
+  STATE_RUNNING,
+  STATE_SHUTDOWN,
+};
+
+typedef struct
+{
+  GbpSphinxRenderer *self;
+  char              *key;
+  char              *method;
+
+  /* Tasks waiting on the request in flight */
+  GPtrArray         *active;
+  GVariant          *active_params;
+
+  /* Newest request made while one was in flight, and its waiters */
+  GVariant          *pending_params;
+  GPtrArray         *pending;
+} Render;
+
+G_DEFINE_FINAL_TYPE (GbpSphinxRenderer, gbp_sphinx_renderer, IDE_TYPE_OBJECT)
+
+static void gbp_sphinx_renderer_send (Render   *render,
+                                      GVariant *params);
+
+static void
+render_free (gpointer data)
+{
+  Render *render = data;
+
+  g_assert (render->active == NULL);
+  g_assert (render->pending == NULL);
+
+  g_clear_pointer (&render->active_params, g_variant_unref);
+  g_clear_pointer (&render->pending_params, g_variant_unref);
+  g_clear_pointer (&render->method, g_free);
+  g_clear_pointer (&render->key, g_free);
+  g_clear_object (&render->self);
+  g_slice_free (Render, render);
+}
+
+static void
+gbp_sphinx_renderer_subprocess_spawned (GbpSphinxRenderer       *self,
+                                        IdeSubprocess           *subprocess,
+                                        IdeSubprocessSupervisor *supervisor)
+{
+  g_autoptr(GIOStream) stream = NULL;
+  GOutputStream *output;
+  GInputStream *input;
+  GList *queued;
+  int fd;
+
+  IDE_ENTRY;
+
+  g_assert (GBP_IS_SPHINX_RENDERER (self));
+  g_assert (IDE_IS_SUBPROCESS (subprocess));
+  g_assert (IDE_IS_SUBPROCESS_SUPERVISOR (supervisor));
+  g_assert (self->rpc_client == NULL);
+
+  if (self->state == STATE_SPAWNING)
+    self->state = STATE_RUNNING;
+
+  input = ide_subprocess_get_stdout_pipe (subprocess);
+  output = ide_subprocess_get_stdin_pipe (subprocess);
+  stream = g_simple_io_stream_new (input, output);
+
+  g_assert (G_IS_UNIX_INPUT_STREAM (input));
+  g_assert (G_IS_UNIX_OUTPUT_STREAM (output));
+
+  fd = g_unix_input_stream_get_fd (G_UNIX_INPUT_STREAM (input));
+  g_unix_set_fd_nonblocking (fd, TRUE, NULL);
+
+  fd = g_unix_output_stream_get_fd (G_UNIX_OUTPUT_STREAM (output));
+  g_unix_set_fd_nonblocking (fd, TRUE, NULL);
+
+  self->rpc_client = jsonrpc_client_new (stream);
+  jsonrpc_client_set_use_gvariant (self->rpc_client, TRUE);
+
+  queued = g_steal_pointer (&self->get_client.head);
+
+  self->get_client.head = NULL;
+  self->get_client.tail = NULL;
+  self->get_client.length = 0;
+
+  for (const GList *iter = queued; iter != NULL; iter = iter->next)
+    {
+      IdeTask *task = iter->data;
+
+      ide_task_return_object (task, g_object_ref (self->rpc_client));
+    }
+
+  g_list_free_full (queued, g_object_unref);
+
+  IDE_EXIT;
+}
+
+static void
+gbp_sphinx_renderer_subprocess_exited (GbpSphinxRenderer       *self,
+                                       IdeSubprocess           *subprocess,
+                                       IdeSubprocessSupervisor *supervisor)
+{
+  IDE_ENTRY;
+
+  g_assert (GBP_IS_SPHINX_RENDERER (self));
+  g_assert (IDE_IS_SUBPROCESS (subprocess));
+  g_assert (IDE_IS_SUBPROCESS_SUPERVISOR (supervisor));
+
+  if (self->state == STATE_RUNNING)
+    self->state = STATE_SPAWNING;
+
+  g_clear_object (&self->rpc_client);
+
+  IDE_EXIT;
+}
+
+static const char *
+find_python (void)
+{
+  static const char *python;
+
+  if (python == NULL)
+    {
+      g_autofree char *path = g_find_program_in_path ("python3");
+
+      if (path != NULL)
+        python = "python3";
+      else
+        python = "python";
+    }
+
+  return python;
+}
+
+static void
+gbp_sphinx_renderer_parent_set (IdeObject *object,
+                                IdeObject *parent)
+{
+  GbpSphinxRenderer *self = (GbpSphinxRenderer *)object;
+  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
+  g_autoptr(GBytes) script = NULL;
+  GSubprocessFlags flags;
+
+  g_assert (GBP_IS_SPHINX_RENDERER (self));
+  g_assert (!parent || IDE_IS_OBJECT (parent));
+
+  if (parent == NULL)
+    return;
+
+  script = g_resources_lookup_data ("/plugins/sphinx-preview/sphinx-render-server.py", 0, NULL);
+
+  flags = G_SUBPROCESS_FLAGS_STDOUT_PIPE | G_SUBPROCESS_FLAGS_STDIN_PIPE;
+  if (!g_getenv ("RST_DEBUG"))
+    flags |= G_SUBPROCESS_FLAGS_STDERR_SILENCE;
+
+  launcher = ide_subprocess_launcher_new (flags);
+  ide_subprocess_launcher_set_cwd (launcher, g_get_home_dir ());
+  ide_subprocess_launcher_set_clear_env (launcher, FALSE);
+  ide_subprocess_launcher_push_args (launcher,
+                                     IDE_STRV_INIT (find_python (),
+                                                    "-c",
+                                                    (const char *)g_bytes_get_data (script, NULL)));
+
+  self->supervisor = ide_subprocess_supervisor_new ();
+  ide_subprocess_supervisor_set_launcher (self->supervisor, launcher);
+
+  g_signal_connect_object (self->supervisor,
+                           "spawned",
+                           G_CALLBACK (gbp_sphinx_renderer_subprocess_spawned),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->supervisor,
+                           "exited",
+                           G_CALLBACK (gbp_sphinx_renderer_subprocess_exited),
+                           self,
+                           G_CONNECT_SWAPPED);
+}
+
+static void
+gbp_sphinx_renderer_destroy (IdeObject *object)
+{
+  GbpSphinxRenderer *self = (GbpSphinxRenderer *)object;
+  GList *queued;
+
+  self->state = STATE_SHUTDOWN;
+
+  if (self->supervisor != NULL)
+    {
+      g_autoptr(IdeSubprocessSupervisor) supervisor = g_steal_pointer (&self->supervisor);
+
+      ide_subprocess_supervisor_stop (supervisor);
+    }
+
+  g_clear_object (&self->rpc_client);
+
+  queued = g_steal_pointer (&self->get_client.head);
+
+  self->get_client.head = NULL;
+  self->get_client.tail = NULL;
+  self->get_client.length = 0;
+
+  for (const GList *iter = queued; iter != NULL; iter = iter->next)
+    {
+      IdeTask *task = iter->data;
+
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_CANCELLED,
+                                 "Renderer is disposing");
+    }
+
+  g_list_free_full (queued, g_object_unref);
+
+  IDE_OBJECT_CLASS (gbp_sphinx_renderer_parent_class)->destroy (object);
+}
+
+static void
+gbp_sphinx_renderer_finalize (GObject *object)
+{
+  GbpSphinxRenderer *self = (GbpSphinxRenderer *)object;
+
+  /* Each Render holds a reference to us until completed */
+  g_assert (g_hash_table_size (self->renders) == 0);
+
+  g_clear_pointer (&self->renders, g_hash_table_unref);
+  g_clear_object (&self->rpc_client);
+  g_clear_object (&self->supervisor);
+
+  G_OBJECT_CLASS (gbp_sphinx_renderer_parent_class)->finalize (object);
+}
+
+static void
+gbp_sphinx_renderer_class_init (GbpSphinxRendererClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  IdeObjectClass *i_object_class = IDE_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_sphinx_renderer_finalize;
+
+  i_object_class->destroy = gbp_sphinx_renderer_destroy;
+  i_object_class->parent_set = gbp_sphinx_renderer_parent_set;
+}
+
+static void
+gbp_sphinx_renderer_init (GbpSphinxRenderer *self)
+{
+  self->renders = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         NULL,
+                                         render_free);
+}
+
+GbpSphinxRenderer *
+gbp_sphinx_renderer_from_context (IdeContext *context)
+{
+  GbpSphinxRenderer *ret;
+
+  g_return_val_if_fail (IDE_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail (!ide_object_in_destruction (IDE_OBJECT (context)), NULL);
+
+  if (!(ret = ide_context_peek_child_typed (context, GBP_TYPE_SPHINX_RENDERER)))
+    {
+      g_autoptr(GbpSphinxRenderer) renderer = NULL;
+
+      renderer = ide_object_ensure_child_typed (IDE_OBJECT (context), GBP_TYPE_SPHINX_RENDERER);
+      ret = ide_context_peek_child_typed (context, GBP_TYPE_SPHINX_RENDERER);
+    }
+
+  return ret;
+}
+
+static void
+gbp_sphinx_renderer_get_client_async (GbpSphinxRenderer   *self,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  g_autoptr(IdeTask) task = NULL;
+
+  g_assert (GBP_IS_SPHINX_RENDERER (self));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_sphinx_renderer_get_client_async);
+
+  switch (self->state)
+    {
+    case STATE_INITIAL:
+      self->state = STATE_SPAWNING;
+      g_queue_push_tail (&self->get_client, g_steal_pointer (&task));
+      ide_subprocess_supervisor_start (self->supervisor);
+      break;
+
+    case STATE_SPAWNING:
+      g_queue_push_tail (&self->get_client, g_steal_pointer (&task));
+      break;
+
+    case STATE_RUNNING:
+      ide_task_return_object (task, g_object_ref (self->rpc_client));
+      break;
+
+    case STATE_SHUTDOWN:
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_CLOSED,
+                                 "The renderer has been closed");
+      break;
+
+    default:
+      g_assert_not_reached ();
+      break;
+    }
+}
+
+static JsonrpcClient *
+gbp_sphinx_renderer_get_client_finish (GbpSphinxRenderer  *self,
+                                       GAsyncResult       *result,
+                                       GError            **error)
+{
+  g_assert (GBP_IS_SPHINX_RENDERER (self));
+  g_assert (IDE_IS_TASK (result));
+
+  return ide_task_propagate_object (IDE_TASK (result), error);
+}
+
+static void
+gbp_sphinx_renderer_complete (Render       *render,
+                              const char   *html,
+                              const GError *error)
+{
+  g_autoptr(GPtrArray) active = NULL;
+  GbpSphinxRenderer *self;
+
+  g_assert (render != NULL);
+  g_assert (render->active != NULL);
+  g_assert (html != NULL || error != NULL);
+
+  self = render->self;
+  active = g_steal_pointer (&render->active);
+
+  for (guint i = 0; i < active->len; i++)
+    {
+      IdeTask *task = g_ptr_array_index (active, i);
+
+      if (error != NULL)
+        ide_task_return_error (task, g_error_copy (error));
+      else
+        ide_task_return_pointer (task, g_strdup (html), g_free);
+    }
+
+  if (render->pending != NULL)
+    {
+      g_autoptr(GVariant) params = g_steal_pointer (&render->pending_params);
+
+      render->active = g_steal_pointer (&render->pending);
+      gbp_sphinx_renderer_send (render, params);
+      return;
+    }
+
+  g_hash_table_remove (self->renders, render->key);
+}
+
+static void
+gbp_sphinx_renderer_call_cb (GObject      *object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
+{
+  JsonrpcClient *client = (JsonrpcClient *)object;
+  Render *render = user_data;
+  g_autoptr(GVariant) reply = NULL;
+  g_autoptr(GError) error = NULL;
+  const char *html = NULL;
+
+  g_assert (JSONRPC_IS_CLIENT (client));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (render != NULL);
+
+  if (jsonrpc_client_call_finish (client, result, &reply, &error) &&
+      !JSONRPC_MESSAGE_PARSE (reply, "html", JSONRPC_MESSAGE_GET_STRING (&html)))
+    g_set_error_literal (&error,
+                         G_IO_ERROR,
+                         G_IO_ERROR_INVALID_DATA,
+                         "Invalid reply from renderer");
+
+  gbp_sphinx_renderer_complete (render, html, error);
+}
+
+static void
+gbp_sphinx_renderer_get_client_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  GbpSphinxRenderer *self = (GbpSphinxRenderer *)object;
+  g_autoptr(JsonrpcClient) client = NULL;
+  g_autoptr(GVariant) params = NULL;
+  g_autoptr(GError) error = NULL;
+  Render *render = user_data;
+
+  g_assert (GBP_IS_SPHINX_RENDERER (self));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (render != NULL);
+  g_assert (render->active_params != NULL);
+
+  params = g_steal_pointer (&render->active_params);
+
+  if (!(client = gbp_sphinx_renderer_get_client_finish (self, result, &error)))
+    {
+      gbp_sphinx_renderer_complete (render, NULL, error);
+      return;
+    }
+
+  jsonrpc_client_call_async (client,
+                             render->method,
+                             params,
+                             NULL,
+                             gbp_sphinx_renderer_call_cb,
+                             render);
+}
+
+static void
+gbp_sphinx_renderer_send (Render   *render,
+                          GVariant *params)
+{
+  g_assert (render != NULL);
+  g_assert (render->active != NULL);
+  g_assert (render->active_params == NULL);
+  g_assert (params != NULL);
+
+  render->active_params = g_variant_ref_sink (params);
+
+  gbp_sphinx_renderer_get_client_async (render->self,
+                                        NULL,
+                                        gbp_sphinx_renderer_get_client_cb,
+                                        render);
+}
+
+static void
+gbp_sphinx_renderer_queue (GbpSphinxRenderer *self,
+                           GFile             *file,
+                           const char        *method,
+                           GVariant          *params,
+                           IdeTask           *task)
+{
+  g_autofree char *uri = NULL;
+  g_autofree char *key = NULL;
+  Render *render;
+
+  g_assert (GBP_IS_SPHINX_RENDERER (self));
+  g_assert (G_IS_FILE (file));
+  g_assert (method != NULL);
+  g_assert (params != NULL);
+  g_assert (IDE_IS_TASK (task));
+
+  if (self->state == STATE_SHUTDOWN)
+    {
+      g_variant_unref (g_variant_ref_sink (params));
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_CLOSED,
+                                 "The renderer has been closed");
+      return;
+    }
+
+  uri = g_file_get_uri (file);
+  key = g_strdup_printf ("%s:%s", method, uri);
+
+  if ((render = g_hash_table_lookup (self->renders, key)))
+    {
+      /* Something is already in flight for this document. Replace whatever
+       * was waiting behind it with our newer contents and let everyone that
+       * was waiting share the result.
+       */
+      g_clear_pointer (&render->pending_params, g_variant_unref);
+      render->pending_params = g_variant_ref_sink (params);
+
+      if (render->pending == NULL)
+        render->pending = g_ptr_array_new_with_free_func (g_object_unref);
+      g_ptr_array_add (render->pending, g_object_ref (task));
+
+      return;
+    }
+
+  render = g_slice_new0 (Render);
+  render->self = g_object_ref (self);
+  render->key = g_steal_pointer (&key);
+  render->method = g_strdup (method);
+  render->active = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (render->active, g_object_ref (task));
+
+  g_hash_table_insert (self->renders, render->key, render);
+
+  gbp_sphinx_renderer_send (render, params);
+}
+
+void
+gbp_sphinx_renderer_render_async (GbpSphinxRenderer   *self,
+                                  GFile               *file,
+                                  GBytes              *contents,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  g_autoptr(IdeTask) task = NULL;
+  g_autofree char *path = NULL;
+  const char *text;
+  GVariant *params;
+  gsize len;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (GBP_IS_SPHINX_RENDERER (self));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (contents != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_sphinx_renderer_render_async);
+
+  /* Contents from IdeBuffer are always NUL terminated */
+  text = g_bytes_get_data (contents, &len);
+  path = g_file_get_path (file);
+
+  if (text == NULL || text[len] != 0 || !g_utf8_validate_len (text, len, NULL))
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_INVALID_DATA,
+                                 "Contents must be NUL terminated UTF-8");
+      IDE_EXIT;
+    }
+
+  params = JSONRPC_MESSAGE_NEW (
+    "path", JSONRPC_MESSAGE_PUT_STRING (path ? path : ""),
+    "contents", JSONRPC_MESSAGE_PUT_STRING (text)
+  );
+
+  gbp_sphinx_renderer_queue (self, file, "render", params, task);
+
+  IDE_EXIT;
+}
+
+/**
+ * gbp_sphinx_renderer_render_finish:
+ *
+ * Returns: (transfer full): the rendered HTML
+ */
+char *
+gbp_sphinx_renderer_render_finish (GbpSphinxRenderer  *self,
+                                   GAsyncResult       *result,
+                                   GError            **error)
+{
+  char *ret;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (GBP_IS_SPHINX_RENDERER (self), NULL);
+  g_return_val_if_fail (IDE_IS_TASK (result), NULL);
+
+  ret = ide_task_propagate_pointer (IDE_TASK (result), error);
+
+  IDE_RETURN (ret);
+}
+
+void
+gbp_sphinx_renderer_build_async (GbpSphinxRenderer   *self,
+                                 GFile               *basedir,
+                                 GFile               *builddir,
+                                 GFile               *file,
+                                 GBytes              *contents,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  g_autoptr(IdeTask) task = NULL;
+  g_autofree char *srcdir_path = NULL;
+  g_autofree char *builddir_path = NULL;
+  g_autofree char *path = NULL;
+  const char *text = NULL;
+  GVariant *params;
+  gsize len = 0;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (GBP_IS_SPHINX_RENDERER (self));
+  g_return_if_fail (G_IS_FILE (basedir));
+  g_return_if_fail (G_IS_FILE (builddir));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_sphinx_renderer_build_async);
+
+  srcdir_path = g_file_get_path (basedir);
+  builddir_path = g_file_get_path (builddir);
+  path = g_file_get_path (file);
+
+  if (srcdir_path == NULL || builddir_path == NULL || path == NULL)
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_NOT_SUPPORTED,
+                                 "Only local files may be built with sphinx");
+      IDE_EXIT;
+    }
+
+  /* Without @contents the server builds what is on disk */
+  if (contents != NULL)
+    {
+      text = g_bytes_get_data (contents, &len);
+
+      if (text == NULL || text[len] != 0 || !g_utf8_validate_len (text, len, NULL))
+        text = NULL;
+    }
+
+  if (text != NULL)
+    params = JSONRPC_MESSAGE_NEW (
+      "srcdir", JSONRPC_MESSAGE_PUT_STRING (srcdir_path),
+      "builddir", JSONRPC_MESSAGE_PUT_STRING (builddir_path),
+      "path", JSONRPC_MESSAGE_PUT_STRING (path),
+      "contents", JSONRPC_MESSAGE_PUT_STRING (text)
+    );
+  else
+    params = JSONRPC_MESSAGE_NEW (
+      "srcdir", JSONRPC_MESSAGE_PUT_STRING (srcdir_path),
+      "builddir", JSONRPC_MESSAGE_PUT_STRING (builddir_path),
+      "path", JSONRPC_MESSAGE_PUT_STRING (path)
+    );
+
+  gbp_sphinx_renderer_queue (self, file, "build", params, task);
+
+  IDE_EXIT;
+}
+
+/**
+ * gbp_sphinx_renderer_build_finish:
+ *
+ * Returns: (transfer full): the HTML generated by sphinx for the document
+ */
+char *
+gbp_sphinx_renderer_build_finish (GbpSphinxRenderer  *self,
+                                  GAsyncResult       *result,
+                                  GError            **error)
+{
+  char *ret;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (GBP_IS_SPHINX_RENDERER (self), NULL);
+  g_return_val_if_fail (IDE_IS_TASK (result), NULL);
+
+  ret = ide_task_propagate_pointer (IDE_TASK (result), error);
+
+  IDE_RETURN (ret);
+}
@@ -0,0 +1,53 @@
+/* gbp-sphinx-renderer.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <libide-core.h>
+
+G_BEGIN_DECLS
+
+#define GBP_TYPE_SPHINX_RENDERER (gbp_sphinx_renderer_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpSphinxRenderer, gbp_sphinx_renderer, GBP, SPHINX_RENDERER, IdeObject)
+
+GbpSphinxRenderer *gbp_sphinx_renderer_from_context  (IdeContext           *context);
+void               gbp_sphinx_renderer_render_async  (GbpSphinxRenderer    *self,
+                                                      GFile                *file,
+                                                      GBytes               *contents,
+                                                      GCancellable         *cancellable,
+                                                      GAsyncReadyCallback   callback,
+                                                      gpointer              user_data);
+char              *gbp_sphinx_renderer_render_finish (GbpSphinxRenderer    *self,
+                                                      GAsyncResult         *result,
+                                                      GError              **error);
+void               gbp_sphinx_renderer_build_async   (GbpSphinxRenderer    *self,
+                                                      GFile                *basedir,
+                                                      GFile                *builddir,
+                                                      GFile                *file,
+                                                      GBytes               *contents,
+                                                      GCancellable         *cancellable,
+                                                      GAsyncReadyCallback   callback,
+                                                      gpointer              user_data);
+char              *gbp_sphinx_renderer_build_finish  (GbpSphinxRenderer    *self,
+                                                      GAsyncResult         *result,
+                                                      GError              **error);
+
+G_END_DECLS
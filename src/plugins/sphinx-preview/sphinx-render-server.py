@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+
+# Copyright 2023 Christian Hergert <chergert@redhat.com>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+# A long-lived renderer for reStructuredText and Sphinx documents.
+#
+# Requests are JSON-RPC 2.0 messages framed with a Content-Length header
+# (the same framing used by jsonrpc-glib) on standard input, and replies
+# are written the same way to standard output. Keeping this process
+# around means we only pay for Python start-up and importing docutils or
+# sphinx once, rather than for every keystroke.
+
+import json
+import os
+import os.path
+import sys
+import traceback
+
+# Anything printed by docutils, sphinx, or extensions must not corrupt
+# our replies, so send it to standard error instead.
+protocol_in = sys.stdin.buffer
+protocol_out = sys.stdout.buffer
+sys.stdout = sys.stderr
+
+def read_message():
+    length = None
+    while True:
+        line = protocol_in.readline()
+        if not line:
+            return None
+        line = line.rstrip(b'\r\n')
+        if not line:
+            break
+        name, _, value = line.partition(b':')
+        if name.strip().lower() == b'content-length':
+            length = int(value.strip())
+    if length is None:
+        return None
+    return json.loads(protocol_in.read(length))
+
+def write_message(message):
+    data = json.dumps(message).encode('utf-8')
+    protocol_out.write(b'Content-Length: %d\r\n\r\n' % len(data))
+    protocol_out.write(data)
+    protocol_out.flush()
+
+def render(params):
+    import docutils.core
+
+    source_path = params['path']
+    html = docutils.core.publish_string(source=params['contents'],
+                                        source_path=source_path,
+                                        destination_path=os.path.splitext(source_path)[0] + '.html',
+                                        writer_name='html')
+    return {'html': html.decode('utf-8')}
+
+def conf_mtime(srcdir):
+    try:
+        return os.stat(os.path.join(srcdir, 'conf.py')).st_mtime_ns
+    except OSError:
+        return None
+
+class Project:
+    def __init__(self, srcdir, builddir):
+        from sphinx.application import Sphinx
+
+        self.srcdir = srcdir
+        self.overrides = {}
+        self.conf_mtime = conf_mtime(srcdir)
+        self.app = Sphinx(srcdir, srcdir, builddir,
+                          os.path.join(builddir, '.doctrees'),
+                          'html', status=None, warning=sys.stderr)
+        self.app.connect('source-read', self.source_read)
+        self.built = False
+
+    def is_stale(self):
+        from sphinx.environment import CONFIG_OK
+
+        # The configuration is only read when the application is created, so
+        # changes to conf.py (such as added extensions) need a new one. Also
+        # start over once after the environment reported a configuration
+        # change, so nothing set up from the stale pickled state is kept.
+        if conf_mtime(self.srcdir) != self.conf_mtime:
+            return True
+        return self.app.env.config_status != CONFIG_OK and self.built
+
+    def source_read(self, app, docname, source):
+        if docname in self.overrides:
+            source[0] = self.overrides[docname]
+
+    def build(self, path, contents):
+        env = self.app.env
+        docname = env.path2doc(path)
+        if docname is None:
+            raise ValueError('%s is not part of the Sphinx project' % path)
+
+        # Only the requested document is re-read and written. Dropping it from
+        # the environment forces it to be read again even though the file on
+        # disk has not changed, as we render the unsaved contents.
+        if contents is not None:
+            self.overrides[docname] = contents
+        else:
+            self.overrides.pop(docname, None)
+        env.all_docs.pop(docname, None)
+
+        # Documents changed on disk, such as a toctree in another file, are
+        # found by their mtime and read again along with this one.
+        self.app.build(False, [path])
+        self.built = True
+
+        with open(self.app.builder.get_outfilename(docname), encoding='utf-8') as f:
+            return {'html': f.read()}
+
+projects = {}
+
+def build(params):
+    key = (params['srcdir'], params['builddir'])
+    project = projects.get(key)
+    if project is None or project.is_stale():
+        project = projects[key] = Project(*key)
+    try:
+        return project.build(params['path'], params.get('contents'))
+    except Exception:
+        # The environment may be inconsistent now, start over next time
+        del projects[key]
+        raise
+
+methods = {
+    'render': render,
+    'build': build,
+}
+
+while True:
+    message = read_message()
+    if message is None:
+        break
+
+    # Notifications, such as $/cancelRequest, need no reply
+    if 'id' not in message:
+        continue
+
+    reply = {'jsonrpc': '2.0', 'id': message['id']}
+    method = methods.get(message.get('method'))
+
+    if method is None:
+        reply['error'] = {'code': -32601, 'message': 'No such method'}
+    else:
+        try:
+            reply['result'] = method(message.get('params') or {})
+        except BaseException as ex:
+            traceback.print_exc()
+            reply['error'] = {'code': -32603, 'message': str(ex) or type(ex).__name__}
+
+    write_message(reply)
@@ -0,0 +1,178 @@
+/* gbp-symbol-cache-node.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+
+#define G_LOG_DOMAIN "gbp-symbol-cache-node"
+
+#include "config.h"
+
+#include <libide-threading.h>
+
+#include "gbp-symbol-cache-node.h"
+
+struct _GbpSymbolCacheNode
+{
+  IdeSymbolNode  parent_instance;
+
+  GPtrArray     *children;
+
+  /* The location is resolved when the tree is stored so that activating a
+   * node from the cache never needs the resolver which created it. If @file
+   * is %NULL, the resolver could not provide a location.
+   */
+  GFile         *file;
+  guint          line;
+  guint          line_offset;
+};
+
+G_DEFINE_FINAL_TYPE (GbpSymbolCacheNode, gbp_symbol_cache_node, IDE_TYPE_SYMBOL_NODE)
+
+static void
+gbp_symbol_cache_node_get_location_async (IdeSymbolNode       *node,
+                                          GCancellable        *cancellable,
+                                          GAsyncReadyCallback  callback,
+                                          gpointer             user_data)
+{
+  GbpSymbolCacheNode *self = (GbpSymbolCacheNode *)node;
+  g_autoptr(IdeTask) task = NULL;
+
+  g_assert (GBP_IS_SYMBOL_CACHE_NODE (self));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_symbol_cache_node_get_location_async);
+
+  if (self->file == NULL)
+    ide_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_NOT_FOUND,
+                               "Failed to locate location for symbol");
+  else
+    ide_task_return_pointer (task,
+                             ide_location_new (self->file, self->line, self->line_offset),
+                             g_object_unref);
+}
+
+static IdeLocation *
+gbp_symbol_cache_node_get_location_finish (IdeSymbolNode  *node,
+                                           GAsyncResult   *result,
+                                           GError        **error)
+{
+  g_assert (GBP_IS_SYMBOL_CACHE_NODE (node));
+  g_assert (IDE_IS_TASK (result));
+
+  return ide_task_propagate_pointer (IDE_TASK (result), error);
+}
+
+static void
+gbp_symbol_cache_node_finalize (GObject *object)
+{
+  GbpSymbolCacheNode *self = (GbpSymbolCacheNode *)object;
+
+  g_clear_pointer (&self->children, g_ptr_array_unref);
+  g_clear_object (&self->file);
+
+  G_OBJECT_CLASS (gbp_symbol_cache_node_parent_class)->finalize (object);
+}
+
+static void
+gbp_symbol_cache_node_class_init (GbpSymbolCacheNodeClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  IdeSymbolNodeClass *symbol_node_class = IDE_SYMBOL_NODE_CLASS (klass);
+
+  object_class->finalize = gbp_symbol_cache_node_finalize;
+
+  symbol_node_class->get_location_async = gbp_symbol_cache_node_get_location_async;
+  symbol_node_class->get_location_finish = gbp_symbol_cache_node_get_location_finish;
+}
+
+static void
+gbp_symbol_cache_node_init (GbpSymbolCacheNode *self)
+{
+}
+
+GbpSymbolCacheNode *
+gbp_symbol_cache_node_new (const char     *name,
+                           const char     *display_name,
+                           IdeSymbolKind   kind,
+                           IdeSymbolFlags  flags,
+                           gboolean        use_markup,
+                           GFile          *file,
+                           guint           line,
+                           guint           line_offset)
+{
+  GbpSymbolCacheNode *self;
+
+  g_return_val_if_fail (!file || G_IS_FILE (file), NULL);
+
+  self = g_object_new (GBP_TYPE_SYMBOL_CACHE_NODE,
+                       "name", name,
+                       "display-name", display_name,
+                       "kind", kind,
+                       "flags", flags,
+                       "use-markup", use_markup,
+                       NULL);
+  g_set_object (&self->file, file);
+  self->line = line;
+  self->line_offset = line_offset;
+
+  return self;
+}
+
+void
+gbp_symbol_cache_node_append (GbpSymbolCacheNode *self,
+                              GbpSymbolCacheNode *child)
+{
+  g_return_if_fail (GBP_IS_SYMBOL_CACHE_NODE (self));
+  g_return_if_fail (GBP_IS_SYMBOL_CACHE_NODE (child));
+
+  if (self->children == NULL)
+    self->children = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_ptr_array_add (self->children, g_object_ref (child));
+}
+
+guint
+gbp_symbol_cache_node_get_n_children (GbpSymbolCacheNode *self)
+{
+  g_return_val_if_fail (GBP_IS_SYMBOL_CACHE_NODE (self), 0);
+
+  return self->children ? self->children->len : 0;
+}
+
+/**
+ * gbp_symbol_cache_node_get_nth_child:
+ * @self: a #GbpSymbolCacheNode
+ * @nth: the index of the child
+ *
+ * Returns: (transfer full) (nullable): an #IdeSymbolNode or %NULL
+ */
+IdeSymbolNode *
+gbp_symbol_cache_node_get_nth_child (GbpSymbolCacheNode *self,
+                                     guint               nth)
+{
+  g_return_val_if_fail (GBP_IS_SYMBOL_CACHE_NODE (self), NULL);
+
+  if (self->children == NULL || nth >= self->children->len)
+    return NULL;
+
+  return g_object_ref (g_ptr_array_index (self->children, nth));
+}
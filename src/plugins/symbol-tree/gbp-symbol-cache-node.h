@@ -0,0 +1,46 @@
+/* gbp-symbol-cache-node.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+
+#pragma once
+
+#include <libide-code.h>
+
+G_BEGIN_DECLS
+
+#define GBP_TYPE_SYMBOL_CACHE_NODE (gbp_symbol_cache_node_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpSymbolCacheNode, gbp_symbol_cache_node, GBP, SYMBOL_CACHE_NODE, IdeSymbolNode)
+
+GbpSymbolCacheNode *gbp_symbol_cache_node_new            (const char         *name,
+                                                          const char         *display_name,
+                                                          IdeSymbolKind       kind,
+                                                          IdeSymbolFlags      flags,
+                                                          gboolean            use_markup,
+                                                          GFile              *file,
+                                                          guint               line,
+                                                          guint               line_offset);
+void                gbp_symbol_cache_node_append         (GbpSymbolCacheNode *self,
+                                                          GbpSymbolCacheNode *child);
+guint               gbp_symbol_cache_node_get_n_children (GbpSymbolCacheNode *self);
+IdeSymbolNode      *gbp_symbol_cache_node_get_nth_child  (GbpSymbolCacheNode *self,
+                                                          guint               nth);
+
+G_END_DECLS
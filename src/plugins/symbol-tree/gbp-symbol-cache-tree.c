@@ -0,0 +1,189 @@
+/* gbp-symbol-cache-tree.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+
+#define G_LOG_DOMAIN "gbp-symbol-cache-tree"
+
+#include "config.h"
+
+#include "gbp-symbol-cache-node.h"
+#include "gbp-symbol-cache-tree.h"
+
+struct _GbpSymbolCacheTree
+{
+  GObject             parent_instance;
+  GbpSymbolCacheNode *root;
+};
+
+static guint
+gbp_symbol_cache_tree_get_n_children (IdeSymbolTree *tree,
+                                      IdeSymbolNode *node)
+{
+  GbpSymbolCacheTree *self = (GbpSymbolCacheTree *)tree;
+
+  g_assert (GBP_IS_SYMBOL_CACHE_TREE (self));
+  g_assert (!node || GBP_IS_SYMBOL_CACHE_NODE (node));
+
+  if (node == NULL)
+    node = IDE_SYMBOL_NODE (self->root);
+
+  return gbp_symbol_cache_node_get_n_children (GBP_SYMBOL_CACHE_NODE (node));
+}
+
+static IdeSymbolNode *
+gbp_symbol_cache_tree_get_nth_child (IdeSymbolTree *tree,
+                                     IdeSymbolNode *node,
+                                     guint          nth)
+{
+  GbpSymbolCacheTree *self = (GbpSymbolCacheTree *)tree;
+
+  g_assert (GBP_IS_SYMBOL_CACHE_TREE (self));
+  g_assert (!node || GBP_IS_SYMBOL_CACHE_NODE (node));
+
+  if (node == NULL)
+    node = IDE_SYMBOL_NODE (self->root);
+
+  return gbp_symbol_cache_node_get_nth_child (GBP_SYMBOL_CACHE_NODE (node), nth);
+}
+
+static void
+symbol_tree_iface_init (IdeSymbolTreeInterface *iface)
+{
+  iface->get_n_children = gbp_symbol_cache_tree_get_n_children;
+  iface->get_nth_child = gbp_symbol_cache_tree_get_nth_child;
+}
+
+G_DEFINE_FINAL_TYPE_WITH_CODE (GbpSymbolCacheTree, gbp_symbol_cache_tree, G_TYPE_OBJECT,
+                               G_IMPLEMENT_INTERFACE (IDE_TYPE_SYMBOL_TREE, symbol_tree_iface_init))
+
+static void
+gbp_symbol_cache_tree_finalize (GObject *object)
+{
+  GbpSymbolCacheTree *self = (GbpSymbolCacheTree *)object;
+
+  g_clear_object (&self->root);
+
+  G_OBJECT_CLASS (gbp_symbol_cache_tree_parent_class)->finalize (object);
+}
+
+static void
+gbp_symbol_cache_tree_class_init (GbpSymbolCacheTreeClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_symbol_cache_tree_finalize;
+}
+
+static void
+gbp_symbol_cache_tree_init (GbpSymbolCacheTree *self)
+{
+  self->root = gbp_symbol_cache_node_new (NULL, NULL, IDE_SYMBOL_KIND_NONE, 0, FALSE, NULL, 0, 0);
+}
+
+/**
+ * gbp_symbol_cache_tree_new_from_variant:
+ * @nodes: a #GVariant of type %GBP_SYMBOL_CACHE_NODES_TYPE
+ *
+ * Creates a new tree from the serialized nodes.
+ *
+ * This function is safe to call from a thread.
+ *
+ * Returns: (transfer full) (nullable): a #GbpSymbolCacheTree or %NULL if
+ *   @nodes is malformed.
+ */
+GbpSymbolCacheTree *
+gbp_symbol_cache_tree_new_from_variant (GVariant *nodes)
+{
+  g_autoptr(GbpSymbolCacheTree) self = NULL;
+  g_autoptr(GPtrArray) created = NULL;
+  g_autoptr(GFile) last_file = NULL;
+  const char *last_uri = NULL;
+  gsize n_nodes;
+
+  g_return_val_if_fail (nodes != NULL, NULL);
+  g_return_val_if_fail (g_variant_is_of_type (nodes, G_VARIANT_TYPE (GBP_SYMBOL_CACHE_NODES_TYPE)), NULL);
+
+  self = g_object_new (GBP_TYPE_SYMBOL_CACHE_TREE, NULL);
+  n_nodes = g_variant_n_children (nodes);
+  created = g_ptr_array_new_full (n_nodes, g_object_unref);
+
+  for (gsize i = 0; i < n_nodes; i++)
+    {
+      g_autoptr(GbpSymbolCacheNode) node = NULL;
+      GbpSymbolCacheNode *parent;
+      const char *display_name;
+      const char *name;
+      const char *uri;
+      gboolean use_markup;
+      guint32 kind;
+      guint32 flags;
+      guint32 line;
+      guint32 line_offset;
+      gint32 parent_index;
+
+      g_variant_get_child (nodes, i, "(i&s&suub&suu)",
+                           &parent_index, &name, &display_name,
+                           &kind, &flags, &use_markup,
+                           &uri, &line, &line_offset);
+
+      /* Parents always precede their children */
+      if (parent_index < -1 || parent_index >= (gint32)i || kind >= IDE_SYMBOL_KIND_LAST)
+        return NULL;
+
+      flags &= (IDE_SYMBOL_FLAGS_IS_STATIC |
+                IDE_SYMBOL_FLAGS_IS_MEMBER |
+                IDE_SYMBOL_FLAGS_IS_DEPRECATED |
+                IDE_SYMBOL_FLAGS_IS_DEFINITION);
+
+      /* Most nodes share the file of the previous one, avoid creating a
+       * new GFile for each of them.
+       */
+      if (uri[0] == 0)
+        {
+          g_clear_object (&last_file);
+          last_uri = NULL;
+        }
+      else if (g_strcmp0 (uri, last_uri) != 0)
+        {
+          g_clear_object (&last_file);
+          last_file = g_file_new_for_uri (uri);
+          last_uri = uri;
+        }
+
+      node = gbp_symbol_cache_node_new (name[0] ? name : NULL,
+                                        display_name[0] ? display_name : NULL,
+                                        kind,
+                                        flags,
+                                        use_markup,
+                                        last_file,
+                                        line,
+                                        line_offset);
+
+      if (parent_index == -1)
+        parent = self->root;
+      else
+        parent = g_ptr_array_index (created, parent_index);
+
+      gbp_symbol_cache_node_append (parent, node);
+      g_ptr_array_add (created, g_steal_pointer (&node));
+    }
+
+  return g_steal_pointer (&self);
+}
@@ -0,0 +1,41 @@
+/* gbp-symbol-cache-tree.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+
+#pragma once
+
+#include <libide-code.h>
+
+G_BEGIN_DECLS
+
+/* (parent, name, display-name, kind, flags, use-markup, uri, line, line-offset)
+ *
+ * Nodes are stored in pre-order so that a parent always precedes its
+ * children. An empty uri means the node has no location.
+ */
+#define GBP_SYMBOL_CACHE_NODES_TYPE "a(issuubsuu)"
+
+#define GBP_TYPE_SYMBOL_CACHE_TREE (gbp_symbol_cache_tree_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpSymbolCacheTree, gbp_symbol_cache_tree, GBP, SYMBOL_CACHE_TREE, GObject)
+
+GbpSymbolCacheTree *gbp_symbol_cache_tree_new_from_variant (GVariant *nodes);
+
+G_END_DECLS
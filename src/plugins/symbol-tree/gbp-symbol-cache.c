@@ -0,0 +1,720 @@
+/* gbp-symbol-cache.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+
+#define G_LOG_DOMAIN "gbp-symbol-cache"
+
+#include "config.h"
+
+#include <libide-threading.h>
+
+#include "gbp-symbol-cache.h"
+#include "gbp-symbol-cache-tree.h"
+
+#define CACHE_VERSION 1
+#define CACHE_TYPE    "(uss" GBP_SYMBOL_CACHE_NODES_TYPE ")"
+
+/* Number of deserialized trees kept in memory */
+#define MAX_ENTRIES 32
+
+/* Larger trees are not worth the cost of resolving every location */
+#define MAX_NODES 10000
+
+typedef struct
+{
+  GList               link;
+  char               *uri;
+  char               *content_hash;
+  GbpSymbolCacheTree *tree;
+} CacheEntry;
+
+struct _GbpSymbolCache
+{
+  GObject     parent_instance;
+
+  /* One serialized tree per source file, named by the checksum of the
+   * file's uri. Each contains the checksum of the contents it was
+   * created from so that we know when a refresh is necessary.
+   */
+  GFile      *directory;
+
+  /* Recently used trees so that switching between pages does not need
+   * to touch the disk. Accessed from worker threads, protected by @mutex.
+   */
+  GMutex      mutex;
+  GHashTable *entries;
+  GQueue      lru;
+};
+
+typedef struct
+{
+  char     *uri;
+  GBytes   *contents;
+  gboolean  is_current;
+} Lookup;
+
+typedef struct
+{
+  int             parent;
+  IdeSymbolNode  *node;
+  char           *name;
+  char           *display_name;
+  IdeSymbolKind   kind;
+  IdeSymbolFlags  flags;
+  gboolean        use_markup;
+  IdeLocation    *location;
+} StoreNode;
+
+typedef struct
+{
+  char   *uri;
+  GBytes *contents;
+  GArray *nodes;
+  guint   n_active;
+} Store;
+
+typedef struct
+{
+  IdeTask *task;
+  guint    index;
+} StoreLocate;
+
+G_DEFINE_FINAL_TYPE (GbpSymbolCache, gbp_symbol_cache, G_TYPE_OBJECT)
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+  g_clear_pointer (&entry->uri, g_free);
+  g_clear_pointer (&entry->content_hash, g_free);
+  g_clear_object (&entry->tree);
+  g_slice_free (CacheEntry, entry);
+}
+
+static void
+lookup_free (Lookup *lookup)
+{
+  g_clear_pointer (&lookup->uri, g_free);
+  g_clear_pointer (&lookup->contents, g_bytes_unref);
+  g_slice_free (Lookup, lookup);
+}
+
+static void
+store_node_clear (gpointer data)
+{
+  StoreNode *node = data;
+
+  g_clear_object (&node->node);
+  g_clear_object (&node->location);
+  g_clear_pointer (&node->name, g_free);
+  g_clear_pointer (&node->display_name, g_free);
+}
+
+static void
+store_free (Store *store)
+{
+  g_clear_pointer (&store->uri, g_free);
+  g_clear_pointer (&store->contents, g_bytes_unref);
+  g_clear_pointer (&store->nodes, g_array_unref);
+  g_slice_free (Store, store);
+}
+
+static void
+gbp_symbol_cache_finalize (GObject *object)
+{
+  GbpSymbolCache *self = (GbpSymbolCache *)object;
+
+  g_clear_pointer (&self->entries, g_hash_table_unref);
+  g_clear_object (&self->directory);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (gbp_symbol_cache_parent_class)->finalize (object);
+}
+
+static void
+gbp_symbol_cache_class_init (GbpSymbolCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_symbol_cache_finalize;
+}
+
+static void
+gbp_symbol_cache_init (GbpSymbolCache *self)
+{
+  g_mutex_init (&self->mutex);
+  self->entries = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         NULL,
+                                         (GDestroyNotify)cache_entry_free);
+}
+
+GbpSymbolCache *
+gbp_symbol_cache_new (GFile *directory)
+{
+  GbpSymbolCache *self;
+
+  g_return_val_if_fail (G_IS_FILE (directory), NULL);
+
+  self = g_object_new (GBP_TYPE_SYMBOL_CACHE, NULL);
+  self->directory = g_object_ref (directory);
+
+  return self;
+}
+
+static GFile *
+gbp_symbol_cache_get_cache_file (GbpSymbolCache *self,
+                                 const char     *uri)
+{
+  g_autofree char *checksum = NULL;
+  g_autofree char *name = NULL;
+
+  g_assert (GBP_IS_SYMBOL_CACHE (self));
+  g_assert (uri != NULL);
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  name = g_strdup_printf ("%s.gvariant", checksum);
+
+  return g_file_get_child (self->directory, name);
+}
+
+static gboolean
+gbp_symbol_cache_get_locked (GbpSymbolCache      *self,
+                             const char          *uri,
+                             GbpSymbolCacheTree **tree,
+                             char               **content_hash)
+{
+  CacheEntry *entry;
+
+  g_assert (GBP_IS_SYMBOL_CACHE (self));
+  g_assert (uri != NULL);
+  g_assert (tree != NULL);
+  g_assert (content_hash != NULL);
+
+  if (!(entry = g_hash_table_lookup (self->entries, uri)))
+    return FALSE;
+
+  g_queue_unlink (&self->lru, &entry->link);
+  g_queue_push_head_link (&self->lru, &entry->link);
+
+  *tree = g_object_ref (entry->tree);
+  *content_hash = g_strdup (entry->content_hash);
+
+  return TRUE;
+}
+
+static void
+gbp_symbol_cache_insert_locked (GbpSymbolCache     *self,
+                                const char         *uri,
+                                const char         *content_hash,
+                                GbpSymbolCacheTree *tree)
+{
+  CacheEntry *entry;
+
+  g_assert (GBP_IS_SYMBOL_CACHE (self));
+  g_assert (uri != NULL);
+  g_assert (content_hash != NULL);
+  g_assert (GBP_IS_SYMBOL_CACHE_TREE (tree));
+
+  if ((entry = g_hash_table_lookup (self->entries, uri)))
+    {
+      g_queue_unlink (&self->lru, &entry->link);
+      g_hash_table_remove (self->entries, uri);
+    }
+
+  entry = g_slice_new0 (CacheEntry);
+  entry->link.data = entry;
+  entry->uri = g_strdup (uri);
+  entry->content_hash = g_strdup (content_hash);
+  entry->tree = g_object_ref (tree);
+
+  g_hash_table_insert (self->entries, entry->uri, entry);
+  g_queue_push_head_link (&self->lru, &entry->link);
+
+  while (self->lru.length > MAX_ENTRIES)
+    {
+      CacheEntry *oldest = g_queue_peek_tail (&self->lru);
+
+      g_queue_unlink (&self->lru, &oldest->link);
+      g_hash_table_remove (self->entries, oldest->uri);
+    }
+}
+
+static GbpSymbolCacheTree *
+gbp_symbol_cache_load (GbpSymbolCache  *self,
+                       const char      *uri,
+                       char           **content_hash)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) nodes = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GFile) cache_file = NULL;
+  GbpSymbolCacheTree *tree;
+  const char *cached_uri = NULL;
+  const char *cached_hash = NULL;
+  guint32 version = 0;
+
+  g_assert (GBP_IS_SYMBOL_CACHE (self));
+  g_assert (uri != NULL);
+  g_assert (content_hash != NULL);
+
+  cache_file = gbp_symbol_cache_get_cache_file (self, uri);
+
+  if (!(mapped = g_mapped_file_new (g_file_peek_path (cache_file), FALSE, NULL)))
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE));
+  g_variant_get (variant, "(u&s&s@" GBP_SYMBOL_CACHE_NODES_TYPE ")",
+                 &version, &cached_uri, &cached_hash, &nodes);
+
+  /* Guard against checksum collisions as well as stale formats */
+  if (version != CACHE_VERSION ||
+      g_strcmp0 (cached_uri, uri) != 0 ||
+      !(tree = gbp_symbol_cache_tree_new_from_variant (nodes)))
+    return NULL;
+
+  *content_hash = g_strdup (cached_hash);
+
+  return tree;
+}
+
+static void
+gbp_symbol_cache_lookup_worker (IdeTask      *task,
+                                gpointer      source_object,
+                                gpointer      task_data,
+                                GCancellable *cancellable)
+{
+  GbpSymbolCache *self = source_object;
+  g_autoptr(GbpSymbolCacheTree) tree = NULL;
+  g_autofree char *content_hash = NULL;
+  g_autofree char *cached_hash = NULL;
+  Lookup *lookup = task_data;
+  gboolean found;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_TASK (task));
+  g_assert (GBP_IS_SYMBOL_CACHE (self));
+  g_assert (lookup != NULL);
+  g_assert (lookup->uri != NULL);
+  g_assert (lookup->contents != NULL);
+
+  content_hash = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, lookup->contents);
+
+  g_mutex_lock (&self->mutex);
+  found = gbp_symbol_cache_get_locked (self, lookup->uri, &tree, &cached_hash);
+  g_mutex_unlock (&self->mutex);
+
+  if (!found && (tree = gbp_symbol_cache_load (self, lookup->uri, &cached_hash)))
+    {
+      g_mutex_lock (&self->mutex);
+      /* Don't replace a tree stored while we were loading */
+      if (!g_hash_table_contains (self->entries, lookup->uri))
+        gbp_symbol_cache_insert_locked (self, lookup->uri, cached_hash, tree);
+      g_mutex_unlock (&self->mutex);
+    }
+
+  if (tree == NULL)
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_NOT_FOUND,
+                                 "No cached symbol tree for file");
+      IDE_EXIT;
+    }
+
+  lookup->is_current = g_strcmp0 (content_hash, cached_hash) == 0;
+
+  ide_task_return_object (task, g_steal_pointer (&tree));
+
+  IDE_EXIT;
+}
+
+/**
+ * gbp_symbol_cache_lookup_async:
+ * @self: a #GbpSymbolCache
+ * @file: the file the symbol tree belongs to
+ * @contents: the current contents of @file
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: a callback to execute upon completion
+ * @user_data: closure data for @callback
+ *
+ * Looks up the most recently stored symbol tree for @file, which may
+ * have been created from different contents than @contents.
+ */
+void
+gbp_symbol_cache_lookup_async (GbpSymbolCache      *self,
+                               GFile               *file,
+                               GBytes              *contents,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr(IdeTask) task = NULL;
+  Lookup *lookup;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (GBP_IS_SYMBOL_CACHE (self));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (contents != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  lookup = g_slice_new0 (Lookup);
+  lookup->uri = g_file_get_uri (file);
+  lookup->contents = g_bytes_ref (contents);
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_symbol_cache_lookup_async);
+  ide_task_set_task_data (task, lookup, lookup_free);
+  ide_task_run_in_thread (task, gbp_symbol_cache_lookup_worker);
+
+  IDE_EXIT;
+}
+
+/**
+ * gbp_symbol_cache_lookup_finish:
+ * @self: a #GbpSymbolCache
+ * @result: a #GAsyncResult
+ * @is_current: (out) (optional): location for whether the tree was
+ *   created from the same contents provided to the lookup
+ * @error: a location for a #GError
+ *
+ * Returns: (transfer full): an #IdeSymbolTree or %NULL with
+ *   %G_IO_ERROR_NOT_FOUND if nothing was cached for the file.
+ */
+IdeSymbolTree *
+gbp_symbol_cache_lookup_finish (GbpSymbolCache  *self,
+                                GAsyncResult    *result,
+                                gboolean        *is_current,
+                                GError         **error)
+{
+  IdeSymbolTree *ret;
+  Lookup *lookup;
+  gboolean current;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (GBP_IS_SYMBOL_CACHE (self), NULL);
+  g_return_val_if_fail (IDE_IS_TASK (result), NULL);
+
+  /* Task data is released when propagating */
+  lookup = ide_task_get_task_data (IDE_TASK (result));
+  current = lookup->is_current;
+
+  ret = ide_task_propagate_object (IDE_TASK (result), error);
+
+  if (is_current != NULL)
+    *is_current = ret != NULL && current;
+
+  IDE_RETURN (ret);
+}
+
+static inline const char *
+utf8_or_empty (const char *str)
+{
+  if (str == NULL || !g_utf8_validate (str, -1, NULL))
+    return "";
+  return str;
+}
+
+static void
+gbp_symbol_cache_store_worker (IdeTask      *task,
+                               gpointer      source_object,
+                               gpointer      task_data,
+                               GCancellable *cancellable)
+{
+  GbpSymbolCache *self = source_object;
+  g_autoptr(GbpSymbolCacheTree) tree = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) nodes = NULL;
+  g_autoptr(GFile) cache_file = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree char *content_hash = NULL;
+  Store *store = task_data;
+  GVariantBuilder builder;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_TASK (task));
+  g_assert (GBP_IS_SYMBOL_CACHE (self));
+  g_assert (store != NULL);
+  g_assert (store->n_active == 0);
+
+  content_hash = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, store->contents);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (GBP_SYMBOL_CACHE_NODES_TYPE));
+
+  for (guint i = 0; i < store->nodes->len; i++)
+    {
+      const StoreNode *node = &g_array_index (store->nodes, StoreNode, i);
+      g_autofree char *uri = NULL;
+      guint line = 0;
+      guint line_offset = 0;
+
+      if (node->location != NULL)
+        {
+          uri = g_file_get_uri (ide_location_get_file (node->location));
+          line = MAX (0, ide_location_get_line (node->location));
+          line_offset = MAX (0, ide_location_get_line_offset (node->location));
+        }
+
+      g_variant_builder_add (&builder, "(issuubsuu)",
+                             node->parent,
+                             utf8_or_empty (node->name),
+                             utf8_or_empty (node->display_name),
+                             node->kind,
+                             node->flags,
+                             node->use_markup,
+                             utf8_or_empty (uri),
+                             line,
+                             line_offset);
+    }
+
+  nodes = g_variant_ref_sink (g_variant_builder_end (&builder));
+  variant = g_variant_ref_sink (g_variant_new ("(uss@" GBP_SYMBOL_CACHE_NODES_TYPE ")",
+                                               CACHE_VERSION,
+                                               store->uri,
+                                               content_hash,
+                                               nodes));
+
+  /* Share the deserialized form with lookups so that the tree we hand out
+   * never references objects from the resolver which created it.
+   */
+  if ((tree = gbp_symbol_cache_tree_new_from_variant (nodes)))
+    {
+      g_mutex_lock (&self->mutex);
+      gbp_symbol_cache_insert_locked (self, store->uri, content_hash, tree);
+      g_mutex_unlock (&self->mutex);
+    }
+
+  cache_file = gbp_symbol_cache_get_cache_file (self, store->uri);
+  g_file_make_directory_with_parents (self->directory, NULL, NULL);
+
+  if (!g_file_replace_contents (cache_file,
+                                g_variant_get_data (variant),
+                                g_variant_get_size (variant),
+                                NULL,
+                                FALSE,
+                                G_FILE_CREATE_REPLACE_DESTINATION,
+                                NULL,
+                                cancellable,
+                                &error))
+    ide_task_return_error (task, g_steal_pointer (&error));
+  else
+    ide_task_return_boolean (task, TRUE);
+
+  IDE_EXIT;
+}
+
+static void
+gbp_symbol_cache_store_run (IdeTask *task)
+{
+  Store *store;
+
+  g_assert (IDE_IS_TASK (task));
+
+  store = ide_task_get_task_data (task);
+
+  g_assert (store != NULL);
+  g_assert (store->n_active == 0);
+
+  /* Release the resolver's nodes on the main thread */
+  for (guint i = 0; i < store->nodes->len; i++)
+    g_clear_object (&g_array_index (store->nodes, StoreNode, i).node);
+
+  if (ide_task_return_error_if_cancelled (task))
+    return;
+
+  ide_task_run_in_thread (task, gbp_symbol_cache_store_worker);
+}
+
+static void
+gbp_symbol_cache_store_locate_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  IdeSymbolNode *node = (IdeSymbolNode *)object;
+  StoreLocate *locate = user_data;
+  g_autoptr(IdeTask) task = g_steal_pointer (&locate->task);
+  guint index = locate->index;
+  StoreNode *store_node;
+  Store *store;
+
+  g_assert (IDE_IS_SYMBOL_NODE (node));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (IDE_IS_TASK (task));
+
+  g_slice_free (StoreLocate, locate);
+
+  store = ide_task_get_task_data (task);
+
+  g_assert (store != NULL);
+  g_assert (store->n_active > 0);
+  g_assert (index < store->nodes->len);
+
+  /* Nodes without a location are still useful for the outline */
+  store_node = &g_array_index (store->nodes, StoreNode, index);
+  store_node->location = ide_symbol_node_get_location_finish (node, result, NULL);
+
+  store->n_active--;
+
+  if (store->n_active == 0)
+    gbp_symbol_cache_store_run (task);
+}
+
+static gboolean
+gbp_symbol_cache_collect (IdeSymbolTree *tree,
+                          IdeSymbolNode *parent,
+                          int            parent_index,
+                          GArray        *nodes)
+{
+  guint n_children;
+
+  g_assert (IDE_IS_SYMBOL_TREE (tree));
+  g_assert (!parent || IDE_IS_SYMBOL_NODE (parent));
+  g_assert (nodes != NULL);
+
+  n_children = ide_symbol_tree_get_n_children (tree, parent);
+
+  for (guint i = 0; i < n_children; i++)
+    {
+      StoreNode store_node = {0};
+      IdeSymbolNode *node;
+
+      if (nodes->len >= MAX_NODES)
+        return FALSE;
+
+      if (!(node = ide_symbol_tree_get_nth_child (tree, parent, i)))
+        continue;
+
+      store_node.parent = parent_index;
+      store_node.node = node;
+      store_node.name = g_strdup (ide_symbol_node_get_name (node));
+      store_node.kind = ide_symbol_node_get_kind (node);
+      store_node.flags = ide_symbol_node_get_flags (node);
+      store_node.use_markup = ide_symbol_node_get_use_markup (node);
+      g_object_get (node, "display-name", &store_node.display_name, NULL);
+
+      g_array_append_val (nodes, store_node);
+
+      if (!gbp_symbol_cache_collect (tree, node, nodes->len - 1, nodes))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/**
+ * gbp_symbol_cache_store_async:
+ * @self: a #GbpSymbolCache
+ * @file: the file the symbol tree belongs to
+ * @contents: the contents @tree was created from
+ * @tree: an #IdeSymbolTree
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: (nullable): a callback to execute upon completion
+ * @user_data: closure data for @callback
+ *
+ * Resolves the location of every node in @tree and then serializes it
+ * to the cache, keyed by the checksum of @contents.
+ */
+void
+gbp_symbol_cache_store_async (GbpSymbolCache      *self,
+                              GFile               *file,
+                              GBytes              *contents,
+                              IdeSymbolTree       *tree,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+  g_autoptr(IdeTask) task = NULL;
+  Store *store;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (GBP_IS_SYMBOL_CACHE (self));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (contents != NULL);
+  g_return_if_fail (IDE_IS_SYMBOL_TREE (tree));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = ide_task_new (self, cancellable, callback, user_data);
+  ide_task_set_source_tag (task, gbp_symbol_cache_store_async);
+  ide_task_set_priority (task, G_PRIORITY_LOW);
+
+  store = g_slice_new0 (Store);
+  store->uri = g_file_get_uri (file);
+  store->contents = g_bytes_ref (contents);
+  store->nodes = g_array_new (FALSE, FALSE, sizeof (StoreNode));
+  g_array_set_clear_func (store->nodes, store_node_clear);
+  ide_task_set_task_data (task, store, store_free);
+
+  if (!gbp_symbol_cache_collect (tree, NULL, -1, store->nodes))
+    {
+      ide_task_return_new_error (task,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_NOT_SUPPORTED,
+                                 "Symbol tree is too large to cache");
+      IDE_EXIT;
+    }
+
+  if (store->nodes->len == 0)
+    {
+      gbp_symbol_cache_store_run (task);
+      IDE_EXIT;
+    }
+
+  store->n_active = store->nodes->len;
+
+  for (guint i = 0; i < store->nodes->len; i++)
+    {
+      IdeSymbolNode *node = g_array_index (store->nodes, StoreNode, i).node;
+      StoreLocate *locate;
+
+      locate = g_slice_new0 (StoreLocate);
+      locate->task = g_object_ref (task);
+      locate->index = i;
+
+      ide_symbol_node_get_location_async (node,
+                                          cancellable,
+                                          gbp_symbol_cache_store_locate_cb,
+                                          locate);
+    }
+
+  IDE_EXIT;
+}
+
+gboolean
+gbp_symbol_cache_store_finish (GbpSymbolCache  *self,
+                               GAsyncResult    *result,
+                               GError         **error)
+{
+  gboolean ret;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (GBP_IS_SYMBOL_CACHE (self), FALSE);
+  g_return_val_if_fail (IDE_IS_TASK (result), FALSE);
+
+  ret = ide_task_propagate_boolean (IDE_TASK (result), error);
+
+  IDE_RETURN (ret);
+}
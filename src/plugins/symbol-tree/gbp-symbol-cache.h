@@ -0,0 +1,54 @@
+/* gbp-symbol-cache.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+
+#pragma once
+
+#include <libide-code.h>
+
+G_BEGIN_DECLS
+
+#define GBP_TYPE_SYMBOL_CACHE (gbp_symbol_cache_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpSymbolCache, gbp_symbol_cache, GBP, SYMBOL_CACHE, GObject)
+
+GbpSymbolCache *gbp_symbol_cache_new           (GFile                *directory);
+void            gbp_symbol_cache_lookup_async  (GbpSymbolCache       *self,
+                                                GFile                *file,
+                                                GBytes               *contents,
+                                                GCancellable         *cancellable,
+                                                GAsyncReadyCallback   callback,
+                                                gpointer              user_data);
+IdeSymbolTree  *gbp_symbol_cache_lookup_finish (GbpSymbolCache       *self,
+                                                GAsyncResult         *result,
+                                                gboolean             *is_current,
+                                                GError              **error);
+void            gbp_symbol_cache_store_async   (GbpSymbolCache       *self,
+                                                GFile                *file,
+                                                GBytes               *contents,
+                                                IdeSymbolTree        *tree,
+                                                GCancellable         *cancellable,
+                                                GAsyncReadyCallback   callback,
+                                                gpointer              user_data);
+gboolean        gbp_symbol_cache_store_finish  (GbpSymbolCache       *self,
+                                                GAsyncResult         *result,
+                                                GError              **error);
+
+G_END_DECLS
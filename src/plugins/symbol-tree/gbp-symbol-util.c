@@ -243,15 +243,27 @@ gbp_symbol_get_symbol_tree_cb (GObject      *object,
   IDE_EXIT;
 }
 
+/**
+ * gbp_symbol_get_symbol_tree_async:
+ * @buffer: an #IdeBuffer
+ * @contents: (nullable): the contents to resolve, or %NULL to use the
+ *   current contents of @buffer
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: a callback to execute upon completion
+ * @user_data: closure data for @callback
+ *
+ * Asynchronously requests a symbol tree from the resolvers of @buffer.
+ */
 void
 gbp_symbol_get_symbol_tree_async (IdeBuffer           *buffer,
+                                  GBytes              *contents,
                                   GCancellable        *cancellable,
                                   GAsyncReadyCallback  callback,
                                   gpointer             user_data)
 {
   g_autoptr(IdeTask) task = NULL;
   g_autoptr(GPtrArray) resolvers = NULL;
-  g_autoptr(GBytes) contents = NULL;
+  g_autoptr(GBytes) owned_contents = NULL;
   GetSymbolTree *data;
   GFile *file;
 
@@ -264,9 +276,13 @@ gbp_symbol_get_symbol_tree_async (IdeBuffer           *buffer,
   ide_task_set_source_tag (task, gbp_symbol_get_symbol_tree_async);
 
   file = ide_buffer_get_file (buffer);
-  contents = ide_buffer_dup_content (buffer);
 
-  if (file == NULL || contents == NULL)
+  if (contents != NULL)
+    owned_contents = g_bytes_ref (contents);
+  else
+    owned_contents = ide_buffer_dup_content (buffer);
+
+  if (file == NULL || owned_contents == NULL)
     {
       ide_task_return_new_error (task,
                                  G_IO_ERROR,
@@ -291,7 +307,7 @@ gbp_symbol_get_symbol_tree_async (IdeBuffer           *buffer,
   data->resolvers = g_steal_pointer (&resolvers);
   data->buffer = ide_buffer_hold (buffer);
   data->file = g_object_ref (file);
-  data->contents = g_steal_pointer (&contents);
+  data->contents = g_steal_pointer (&owned_contents);
   ide_task_set_task_data (task, data, get_symbol_tree_free);
 
   ide_symbol_resolver_get_symbol_tree_async (g_ptr_array_index (data->resolvers, data->resolvers->len - 1),
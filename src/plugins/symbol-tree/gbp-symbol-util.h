@@ -32,6 +32,7 @@ IdeSymbol     *gbp_symbol_find_nearest_scope_finish (IdeBuffer            *buffe
                                                      GAsyncResult         *result,
                                                      GError              **error);
 void           gbp_symbol_get_symbol_tree_async     (IdeBuffer            *buffer,
+                                                     GBytes               *contents,
                                                      GCancellable         *cancellable,
                                                      GAsyncReadyCallback   callback,
                                                      gpointer              user_data);
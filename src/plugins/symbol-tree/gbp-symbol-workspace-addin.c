@@ -28,6 +28,7 @@
 #include <libide-editor.h>
 #include <libide-gui.h>
 
+#include "gbp-symbol-cache.h"
 #include "gbp-symbol-popover.h"
 #include "gbp-symbol-workspace-addin.h"
 #include "gbp-symbol-util.h"
@@ -47,11 +48,40 @@ struct _GbpSymbolWorkspaceAddin
   GtkImage         *menu_image;
   GbpSymbolPopover *popover;
 
+  GbpSymbolCache   *cache;
+
+  /* The latest tree of the current buffer, stored to the cache only once
+   * the buffer is unbound since every edit would make it stale again.
+   */
+  GFile            *pending_file;
+  GBytes           *pending_contents;
+  IdeSymbolTree    *pending_tree;
+
   IdeSignalGroup   *buffer_signals;
   guint             nearest_scope_timeout_source;
   guint             symbol_tree_timeout_source;
 };
 
+typedef struct
+{
+  GbpSymbolWorkspaceAddin *self;
+  IdeBuffer               *buffer;
+  GFile                   *file;
+  GBytes                  *contents;
+} UpdateSymbolTree;
+
+static void
+update_symbol_tree_free (UpdateSymbolTree *state)
+{
+  g_clear_object (&state->self);
+  g_clear_object (&state->buffer);
+  g_clear_object (&state->file);
+  g_clear_pointer (&state->contents, g_bytes_unref);
+  g_slice_free (UpdateSymbolTree, state);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (UpdateSymbolTree, update_symbol_tree_free)
+
 static void
 focus_action (GbpSymbolWorkspaceAddin *self,
               GVariant                *param)
@@ -148,21 +178,42 @@ failure:
   IDE_EXIT;
 }
 
+static void
+gbp_symbol_workspace_addin_store_pending (GbpSymbolWorkspaceAddin *self)
+{
+  g_autoptr(IdeSymbolTree) tree = NULL;
+  g_autoptr(GBytes) contents = NULL;
+  g_autoptr(GFile) file = NULL;
+
+  g_assert (GBP_IS_SYMBOL_WORKSPACE_ADDIN (self));
+
+  file = g_steal_pointer (&self->pending_file);
+  contents = g_steal_pointer (&self->pending_contents);
+  tree = g_steal_pointer (&self->pending_tree);
+
+  if (self->cache != NULL && tree != NULL)
+    gbp_symbol_cache_store_async (self->cache, file, contents, tree, NULL, NULL, NULL);
+}
+
 static void
 gbp_symbol_workspace_addin_get_symbol_tree_cb (GObject      *object,
                                                GAsyncResult *result,
                                                gpointer      user_data)
 {
   IdeBuffer *buffer = (IdeBuffer *)object;
-  g_autoptr(GbpSymbolWorkspaceAddin) self = user_data;
+  g_autoptr(UpdateSymbolTree) state = user_data;
   g_autoptr(IdeSymbolTree) tree = NULL;
   g_autoptr(GError) error = NULL;
+  GbpSymbolWorkspaceAddin *self;
 
   IDE_ENTRY;
 
   g_assert (IDE_IS_BUFFER (buffer));
   g_assert (G_IS_ASYNC_RESULT (result));
-  g_assert (GBP_IS_SYMBOL_WORKSPACE_ADDIN (self));
+  g_assert (state != NULL);
+  g_assert (GBP_IS_SYMBOL_WORKSPACE_ADDIN (state->self));
+
+  self = state->self;
 
   if (!(tree = gbp_symbol_get_symbol_tree_finish (buffer, result, &error)))
     {
@@ -171,8 +222,25 @@ gbp_symbol_workspace_addin_get_symbol_tree_cb (GObject      *object,
       IDE_GOTO (failure);
     }
 
+  /* The tree is still valid for these contents even if the user has
+   * since moved on to another page, in which case store it right away.
+   */
   if ((gpointer)buffer != ide_signal_group_get_target (self->buffer_signals))
-    IDE_GOTO (failure);
+    {
+      if (self->cache != NULL)
+        gbp_symbol_cache_store_async (self->cache,
+                                      state->file,
+                                      state->contents,
+                                      tree,
+                                      NULL, NULL, NULL);
+      IDE_GOTO (failure);
+    }
+
+  /* Otherwise replace the pending tree, which is for an older revision */
+  g_set_object (&self->pending_file, state->file);
+  g_clear_pointer (&self->pending_contents, g_bytes_unref);
+  self->pending_contents = g_bytes_ref (state->contents);
+  g_set_object (&self->pending_tree, tree);
 
   gbp_symbol_popover_set_symbol_tree (self->popover, tree);
 
@@ -189,6 +257,53 @@ failure:
   IDE_EXIT;
 }
 
+static void
+gbp_symbol_workspace_addin_lookup_cb (GObject      *object,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  GbpSymbolCache *cache = (GbpSymbolCache *)object;
+  g_autoptr(UpdateSymbolTree) state = user_data;
+  g_autoptr(IdeSymbolTree) tree = NULL;
+  GbpSymbolWorkspaceAddin *self;
+  gboolean is_current = FALSE;
+
+  IDE_ENTRY;
+
+  g_assert (GBP_IS_SYMBOL_CACHE (cache));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (state != NULL);
+  g_assert (GBP_IS_SYMBOL_WORKSPACE_ADDIN (state->self));
+
+  self = state->self;
+
+  /* Cache misses are expected, the resolvers will fill it in */
+  tree = gbp_symbol_cache_lookup_finish (cache, result, &is_current, NULL);
+
+  /* Raced against another query or cleanup and lost, just bail */
+  if ((gpointer)state->buffer != ide_signal_group_get_target (self->buffer_signals))
+    IDE_EXIT;
+
+  /* Show an out of date tree only if we have nothing else, so that the
+   * outline is available immediately after switching pages without
+   * resetting it on every edit.
+   */
+  if (tree != NULL &&
+      (is_current || gbp_symbol_popover_get_symbol_tree (self->popover) == NULL))
+    gbp_symbol_popover_set_symbol_tree (self->popover, tree);
+
+  if (is_current)
+    IDE_EXIT;
+
+  gbp_symbol_get_symbol_tree_async (state->buffer,
+                                    state->contents,
+                                    NULL,
+                                    gbp_symbol_workspace_addin_get_symbol_tree_cb,
+                                    g_steal_pointer (&state));
+
+  IDE_EXIT;
+}
+
 static void
 gbp_symbol_workspace_addin_update_nearest_scope (GbpSymbolWorkspaceAddin *self,
                                                  IdeBuffer               *buffer)
@@ -217,21 +332,39 @@ static void
 gbp_symbol_workspace_addin_update_symbol_tree (GbpSymbolWorkspaceAddin *self,
                                                IdeBuffer               *buffer)
 {
+  g_autoptr(GBytes) contents = NULL;
+  UpdateSymbolTree *state;
+  GFile *file;
+
   IDE_ENTRY;
 
   g_assert (GBP_IS_SYMBOL_WORKSPACE_ADDIN (self));
   g_assert (IDE_IS_BUFFER (buffer));
+  g_assert (GBP_IS_SYMBOL_CACHE (self->cache));
 
-  if (!ide_buffer_has_symbol_resolvers (buffer))
+  if (!ide_buffer_has_symbol_resolvers (buffer) ||
+      !(file = ide_buffer_get_file (buffer)) ||
+      !(contents = ide_buffer_dup_content (buffer)))
     {
       gbp_symbol_popover_set_symbol_tree (self->popover, NULL);
       IDE_EXIT;
     }
 
-  gbp_symbol_get_symbol_tree_async (buffer,
-                                    NULL,
-                                    gbp_symbol_workspace_addin_get_symbol_tree_cb,
-                                    g_object_ref (self));
+  /* Both the cache and the resolvers use the same snapshot so that the
+   * resulting tree is stored under the checksum of what was parsed.
+   */
+  state = g_slice_new0 (UpdateSymbolTree);
+  state->self = g_object_ref (self);
+  state->buffer = g_object_ref (buffer);
+  state->file = g_object_ref (file);
+  state->contents = g_steal_pointer (&contents);
+
+  gbp_symbol_cache_lookup_async (self->cache,
+                                 file,
+                                 state->contents,
+                                 NULL,
+                                 gbp_symbol_workspace_addin_lookup_cb,
+                                 state);
 
   IDE_EXIT;
 }
@@ -249,6 +382,16 @@ gbp_symbol_workspace_addin_buffer_bind_cb (GbpSymbolWorkspaceAddin *self,
   gbp_symbol_workspace_addin_update_symbol_tree (self, buffer);
 }
 
+static void
+gbp_symbol_workspace_addin_buffer_unbind_cb (GbpSymbolWorkspaceAddin *self,
+                                             IdeSignalGroup          *signal_group)
+{
+  g_assert (GBP_IS_SYMBOL_WORKSPACE_ADDIN (self));
+  g_assert (IDE_IS_SIGNAL_GROUP (signal_group));
+
+  gbp_symbol_workspace_addin_store_pending (self);
+}
+
 static gboolean
 gbp_symbol_workspace_addin_nearest_scope_timeout (gpointer data)
 {
@@ -320,6 +463,8 @@ gbp_symbol_workspace_addin_load (IdeWorkspaceAddin *addin,
                                  IdeWorkspace      *workspace)
 {
   GbpSymbolWorkspaceAddin *self = (GbpSymbolWorkspaceAddin *)addin;
+  g_autoptr(GFile) cache_dir = NULL;
+  IdeContext *context;
   GtkBox *box;
 
   IDE_ENTRY;
@@ -330,6 +475,10 @@ gbp_symbol_workspace_addin_load (IdeWorkspaceAddin *addin,
   self->workspace = workspace;
   self->statusbar = ide_workspace_get_statusbar (workspace);
 
+  context = ide_workspace_get_context (workspace);
+  cache_dir = ide_context_cache_file (context, "symbol-tree", NULL);
+  self->cache = gbp_symbol_cache_new (cache_dir);
+
   box = g_object_new (GTK_TYPE_BOX,
                       "orientation", GTK_ORIENTATION_HORIZONTAL,
                       "spacing", 6,
@@ -429,6 +578,10 @@ gbp_symbol_workspace_addin_finalize (GObject *object)
   GbpSymbolWorkspaceAddin *self = (GbpSymbolWorkspaceAddin *)object;
 
   g_clear_object (&self->buffer_signals);
+  g_clear_object (&self->cache);
+  g_clear_object (&self->pending_file);
+  g_clear_pointer (&self->pending_contents, g_bytes_unref);
+  g_clear_object (&self->pending_tree);
 
   G_OBJECT_CLASS (gbp_symbol_workspace_addin_parent_class)->finalize (object);
 }
@@ -450,6 +603,11 @@ gbp_symbol_workspace_addin_init (GbpSymbolWorkspaceAddin *self)
                            G_CALLBACK (gbp_symbol_workspace_addin_buffer_bind_cb),
                            self,
                            G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->buffer_signals,
+                           "unbind",
+                           G_CALLBACK (gbp_symbol_workspace_addin_buffer_unbind_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
   ide_signal_group_connect_object (self->buffer_signals,
                                    "cursor-moved",
                                    G_CALLBACK (gbp_symbol_workspace_addin_buffer_cursor_moved_cb),
@@ -20,47 +20,95 @@
 
 #define G_LOG_DOMAIN "gbp-todo-model"
 
-#include <gtk/gtk.h>
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
 #include <string.h>
 
+#include <gtk/gtk.h>
+
 #include <libide-code.h>
 #include <libide-gui.h>
 
 #include "gbp-todo-model.h"
 #include "gbp-todo-item.h"
 
+/* Same heuristic as GNU grep's -I, which is what we used to spawn */
+#define BINARY_PROBE_LEN 8000
+
+/* Avoid pulling pathological lines (minified sources, generated data)
+ * into the UI process memory space.
+ */
+#define MAX_LINE_LEN 256
+
+/* Bump this whenever the scanner changes what it would extract from a
+ * file so that stale caches are discarded rather than reused.
+ */
+#define CACHE_VERSION 2
+#define CACHE_TYPE    "(usa(sxta(uas)))"
+
 /*
- * If you feel like optimizing this, I would go the route of creating a custom
- * GtkTreeModelIface. Unfortunately GtkTreeDataList always copies strings from
- * the caller (even when using gtk_list_store_set_value() w/ static string) so
- * that prevents us from being clever about using GStringChunk/etc.
- *
- * My preference would be a 2-level tree, with the first level being the index
- * of files, and the second level being the items, with string pointers into
- * a GStringChunk. Most things wont change often, so that space for strings,
- * even when deleted, is more than fine.
+ * The model is a sorted GSequence of items, and we also track every file
+ * that was scanned (including those without any items) along with the
+ * mtime/size we saw when scanning it. That table is persisted to the
+ * project cache directory so that the next session only needs to rescan
+ * files which changed. The cache is only valid for the branch it was
+ * written on, as switching branches may leave files with the same size
+ * and mtime but different contents. VCS ignore rules are re-evaluated on
+ * every walk so that newly ignored files drop out of the model.
  */
 
+typedef struct
+{
+  gint64     mtime;
+  guint64    size;
+  GPtrArray *items;
+} TodoFile;
+
+typedef struct
+{
+  guint lineno;
+  guint n_lines;
+  gsize lines[5];
+} TodoFileMatch;
+
+typedef struct
+{
+  GString *buffer;
+  GArray  *matches;
+} TodoFileBuilder;
+
 struct _GbpTodoModel
 {
-  GObject    parent_instance;
-  GSequence *items;
-  IdeVcs    *vcs;
+  GObject     parent_instance;
+  GSequence  *items;
+  IdeVcs     *vcs;
+  GFile      *cache_file;
+
+  /* Relative path -> TodoFile, only accessed from the main thread. A
+   * snapshot is handed to the worker when mining.
+   */
+  GHashTable *files;
+
+  /* The branch @files was last mined on */
+  char       *branch;
 };
 
 typedef struct
 {
-  GFile *file;
-  GFile *workdir;
-  guint use_git_grep : 1;
+  GFile      *file;
+  GFile      *workdir;
+  GFile      *cache_file;
+  char       *branch;
+  GHashTable *known;
 } Mine;
 
 typedef struct
 {
   GbpTodoModel *self;
-  GSequence    *items;
-  GFile        *file;
-  GFile        *workdir;
+  GHashTable   *files;
+  char         *path;
+  TodoFile     *file;
   guint         single_file : 1;
 } ResultInfo;
 
@@ -102,13 +150,12 @@ G_DEFINE_FINAL_TYPE_WITH_CODE (GbpTodoModel, gbp_todo_model, G_TYPE_OBJECT,
 
 enum {
   PROP_0,
+  PROP_CACHE_FILE,
   PROP_VCS,
   N_PROPS
 };
 
 static GParamSpec *properties [N_PROPS];
-static GRegex *line1;
-static GRegex *line2;
 
 static const char *exclude_dirs[] = {
   ".bzr",
@@ -132,6 +179,7 @@ static const char *exclude_files[] = {
   "configure",
   "Makecache",
 };
+static GPatternSpec *exclude_specs[G_N_ELEMENTS (exclude_files)];
 
 static const char *keywords[] = {
   "FIXME",
@@ -140,11 +188,374 @@ static const char *keywords[] = {
   "HACK",
 };
 
+static TodoFile *
+todo_file_new (gint64  mtime,
+               guint64 size)
+{
+  TodoFile *file;
+
+  file = g_atomic_rc_box_new0 (TodoFile);
+  file->mtime = mtime;
+  file->size = size;
+  file->items = g_ptr_array_new_with_free_func (g_object_unref);
+
+  return file;
+}
+
+static TodoFile *
+todo_file_ref (TodoFile *file)
+{
+  return g_atomic_rc_box_acquire (file);
+}
+
+static void
+todo_file_finalize (gpointer data)
+{
+  TodoFile *file = data;
+
+  g_clear_pointer (&file->items, g_ptr_array_unref);
+}
+
+static void
+todo_file_unref (TodoFile *file)
+{
+  g_atomic_rc_box_release_full (file, todo_file_finalize);
+}
+
+static void
+todo_file_builder_init (TodoFileBuilder *builder,
+                        const char      *path)
+{
+  g_assert (builder != NULL);
+  g_assert (path != NULL);
+
+  /* The path is always at the head of the buffer */
+  builder->buffer = g_string_new (path);
+  builder->matches = g_array_new (FALSE, FALSE, sizeof (TodoFileMatch));
+}
+
+static void
+todo_file_builder_begin (TodoFileBuilder *builder,
+                         guint            lineno)
+{
+  TodoFileMatch match = { lineno, 0 };
+
+  g_array_append_val (builder->matches, match);
+}
+
+static gboolean
+todo_file_builder_add_line (TodoFileBuilder *builder,
+                            const char      *line,
+                            gsize            len)
+{
+  TodoFileMatch *match;
+
+  g_assert (builder->matches->len > 0);
+
+  match = &g_array_index (builder->matches, TodoFileMatch, builder->matches->len - 1);
+
+  if (match->n_lines == G_N_ELEMENTS (match->lines))
+    return FALSE;
+
+  /* Offsets rather than pointers since the buffer may be reallocated */
+  g_string_append_c (builder->buffer, 0);
+  match->lines[match->n_lines++] = builder->buffer->len;
+  g_string_append_len (builder->buffer, line, len);
+
+  return TRUE;
+}
+
+static TodoFile *
+todo_file_builder_end (TodoFileBuilder *builder,
+                       gint64           mtime,
+                       guint64          size)
+{
+  g_autoptr(GBytes) bytes = NULL;
+  TodoFile *file;
+  const char *base;
+
+  g_assert (builder != NULL);
+
+  file = todo_file_new (mtime, size);
+
+  /* To avoid lots of string allocations in the model, all of the items
+   * for a file share a single buffer and keep raw pointers into it.
+   */
+  bytes = g_string_free_to_bytes (g_steal_pointer (&builder->buffer));
+  base = g_bytes_get_data (bytes, NULL);
+
+  for (guint i = 0; i < builder->matches->len; i++)
+    {
+      const TodoFileMatch *match = &g_array_index (builder->matches, TodoFileMatch, i);
+      GbpTodoItem *item = gbp_todo_item_new (bytes);
+
+      gbp_todo_item_set_path (item, base);
+      gbp_todo_item_set_lineno (item, match->lineno);
+
+      for (guint j = 0; j < match->n_lines; j++)
+        gbp_todo_item_add_line (item, base + match->lines[j]);
+
+      g_ptr_array_add (file->items, item);
+    }
+
+  g_clear_pointer (&builder->matches, g_array_unref);
+
+  return file;
+}
+
+static gboolean
+contains_keyword (const char *data,
+                  gsize       len)
+{
+  const char *end = data + len;
+
+  for (guint i = 0; i < G_N_ELEMENTS (keywords); i++)
+    {
+      const char *keyword = keywords[i];
+      gsize keyword_len = strlen (keyword);
+      const char *iter = data;
+      const char *found;
+
+      while ((found = memmem (iter, end - iter, keyword, keyword_len)))
+        {
+          /* Same as the "KEYWORD(:| )" pattern we used to give grep */
+          if (found + keyword_len < end &&
+              (found[keyword_len] == ':' || found[keyword_len] == ' '))
+            return TRUE;
+
+          iter = found + 1;
+        }
+    }
+
+  return FALSE;
+}
+
+static TodoFile *
+todo_file_scan (const char *filename,
+                const char *path,
+                gint64      mtime,
+                guint64     size)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  TodoFileBuilder builder;
+  IdeLineReader reader;
+  char *contents;
+  char *line;
+  gsize line_len;
+  gsize len;
+  guint lineno = 0;
+
+  g_assert (filename != NULL);
+  g_assert (path != NULL);
+
+  /* Files we cannot read are cached as empty until their mtime changes */
+  if (!(mapped = g_mapped_file_new (filename, FALSE, NULL)) ||
+      !(contents = g_mapped_file_get_contents (mapped)) ||
+      !(len = g_mapped_file_get_length (mapped)) ||
+      memchr (contents, 0, MIN (len, BINARY_PROBE_LEN)) != NULL ||
+      !contains_keyword (contents, len))
+    return todo_file_new (mtime, size);
+
+  todo_file_builder_init (&builder, path);
+
+  ide_line_reader_init (&reader, contents, len);
+  while ((line = ide_line_reader_next (&reader, &line_len)))
+    {
+      IdeLineReader context;
+
+      lineno++;
+
+      if (line_len > MAX_LINE_LEN ||
+          !contains_keyword (line, line_len) ||
+          !g_utf8_validate_len (line, line_len, NULL))
+        continue;
+
+      todo_file_builder_begin (&builder, lineno);
+      todo_file_builder_add_line (&builder, line, line_len);
+
+      /* Peek at the following lines for context without advancing the
+       * main reader, as they may contain items of their own.
+       */
+      context = reader;
+      while ((line = ide_line_reader_next (&context, &line_len)))
+        {
+          if (line_len > MAX_LINE_LEN ||
+              !g_utf8_validate_len (line, line_len, NULL) ||
+              !todo_file_builder_add_line (&builder, line, line_len))
+            break;
+        }
+    }
+
+  return todo_file_builder_end (&builder, mtime, size);
+}
+
+static TodoFile *
+todo_file_new_from_variant (const char *path,
+                            gint64      mtime,
+                            guint64     size,
+                            GVariant   *items)
+{
+  TodoFileBuilder builder;
+  gsize n_items;
+
+  g_assert (path != NULL);
+  g_assert (items != NULL);
+
+  n_items = g_variant_n_children (items);
+
+  if (n_items == 0)
+    return todo_file_new (mtime, size);
+
+  todo_file_builder_init (&builder, path);
+
+  for (gsize i = 0; i < n_items; i++)
+    {
+      g_autofree const char **lines = NULL;
+      guint32 lineno;
+
+      g_variant_get_child (items, i, "(u^a&s)", &lineno, &lines);
+
+      if (lines == NULL || lines[0] == NULL)
+        continue;
+
+      todo_file_builder_begin (&builder, lineno);
+
+      for (guint j = 0; lines[j]; j++)
+        {
+          if (!todo_file_builder_add_line (&builder, lines[j], strlen (lines[j])))
+            break;
+        }
+    }
+
+  return todo_file_builder_end (&builder, mtime, size);
+}
+
+static void
+gbp_todo_model_load_cache (GFile      *cache_file,
+                           const char *branch,
+                           GHashTable *files)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) entries = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  const char *cached_branch = NULL;
+  guint32 version = 0;
+  gsize n_entries;
+
+  g_assert (G_IS_FILE (cache_file));
+  g_assert (branch != NULL);
+  g_assert (files != NULL);
+
+  if (!(mapped = g_mapped_file_new (g_file_peek_path (cache_file), FALSE, NULL)))
+    return;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE));
+  g_variant_get (variant, "(u&s@a(sxta(uas)))", &version, &cached_branch, &entries);
+
+  if (version != CACHE_VERSION)
+    return;
+
+  if (g_strcmp0 (cached_branch, branch) != 0)
+    {
+      g_debug ("Ignoring TODO cache for branch \"%s\"", cached_branch);
+      return;
+    }
+
+  n_entries = g_variant_n_children (entries);
+
+  for (gsize i = 0; i < n_entries; i++)
+    {
+      g_autoptr(GVariant) items = NULL;
+      const char *path = NULL;
+      guint64 size = 0;
+      gint64 mtime = 0;
+
+      g_variant_get_child (entries, i, "(&sxt@a(uas))", &path, &mtime, &size, &items);
+
+      if (ide_str_empty0 (path) || g_path_is_absolute (path))
+        continue;
+
+      g_hash_table_insert (files,
+                           g_strdup (path),
+                           todo_file_new_from_variant (path, mtime, size, items));
+    }
+
+  g_debug ("Loaded %u cached TODO files", g_hash_table_size (files));
+}
+
+static void
+gbp_todo_model_save_cache (GFile      *cache_file,
+                           const char *branch,
+                           GHashTable *files)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GFile) parent = NULL;
+  g_autoptr(GError) error = NULL;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  const char *path;
+  TodoFile *file;
+
+  g_assert (G_IS_FILE (cache_file));
+  g_assert (branch != NULL);
+  g_assert (files != NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sxta(uas))"));
+
+  g_hash_table_iter_init (&iter, files);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&path, (gpointer *)&file))
+    {
+      g_variant_builder_open (&builder, G_VARIANT_TYPE ("(sxta(uas))"));
+      g_variant_builder_add (&builder, "s", path);
+      g_variant_builder_add (&builder, "x", file->mtime);
+      g_variant_builder_add (&builder, "t", file->size);
+      g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(uas)"));
+
+      for (guint i = 0; i < file->items->len; i++)
+        {
+          GbpTodoItem *item = g_ptr_array_index (file->items, i);
+          const char *lines[G_N_ELEMENTS (item->lines) + 1] = { NULL };
+
+          for (guint j = 0; j < G_N_ELEMENTS (item->lines); j++)
+            lines[j] = item->lines[j];
+
+          g_variant_builder_add (&builder, "(u^as)", item->lineno, lines);
+        }
+
+      g_variant_builder_close (&builder);
+      g_variant_builder_close (&builder);
+    }
+
+  variant = g_variant_ref_sink (g_variant_new ("(us@a(sxta(uas)))",
+                                               CACHE_VERSION,
+                                               branch,
+                                               g_variant_builder_end (&builder)));
+
+  parent = g_file_get_parent (cache_file);
+  g_file_make_directory_with_parents (parent, NULL, NULL);
+
+  if (!g_file_replace_contents (cache_file,
+                                g_variant_get_data (variant),
+                                g_variant_get_size (variant),
+                                NULL,
+                                FALSE,
+                                G_FILE_CREATE_REPLACE_DESTINATION,
+                                NULL,
+                                NULL,
+                                &error))
+    g_debug ("Failed to save TODO cache: %s", error->message);
+}
+
 static void
 mine_free (Mine *m)
 {
   g_clear_object (&m->file);
   g_clear_object (&m->workdir);
+  g_clear_object (&m->cache_file);
+  g_clear_pointer (&m->branch, g_free);
+  g_clear_pointer (&m->known, g_hash_table_unref);
   g_slice_free (Mine, m);
 }
 
@@ -154,9 +565,9 @@ result_info_free (gpointer data)
   ResultInfo *info = data;
 
   g_clear_object (&info->self);
-  g_clear_object (&info->file);
-  g_clear_object (&info->workdir);
-  g_clear_pointer (&info->items, g_sequence_free);
+  g_clear_pointer (&info->files, g_hash_table_unref);
+  g_clear_pointer (&info->path, g_free);
+  g_clear_pointer (&info->file, todo_file_unref);
   g_slice_free (ResultInfo, info);
 }
 
@@ -170,6 +581,10 @@ gbp_todo_model_get_property (GObject    *object,
 
   switch (prop_id)
     {
+    case PROP_CACHE_FILE:
+      g_value_set_object (value, self->cache_file);
+      break;
+
     case PROP_VCS:
       g_value_set_object (value, self->vcs);
       break;
@@ -189,6 +604,10 @@ gbp_todo_model_set_property (GObject      *object,
 
   switch (prop_id)
     {
+    case PROP_CACHE_FILE:
+      self->cache_file = g_value_dup_object (value);
+      break;
+
     case PROP_VCS:
       self->vcs = g_value_dup_object (value);
       break;
@@ -204,6 +623,9 @@ gbp_todo_model_dispose (GObject *object)
   GbpTodoModel *self = (GbpTodoModel *)object;
 
   g_clear_pointer (&self->items, g_sequence_free);
+  g_clear_pointer (&self->files, g_hash_table_unref);
+  g_clear_object (&self->cache_file);
+  g_clear_pointer (&self->branch, g_free);
 
   G_OBJECT_CLASS (gbp_todo_model_parent_class)->dispose (object);
 }
@@ -212,12 +634,18 @@ static void
 gbp_todo_model_class_init (GbpTodoModelClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
-  g_autoptr(GError) error = NULL;
 
   object_class->dispose = gbp_todo_model_dispose;
   object_class->get_property = gbp_todo_model_get_property;
   object_class->set_property = gbp_todo_model_set_property;
 
+  properties [PROP_CACHE_FILE] =
+    g_param_spec_object ("cache-file",
+                         "Cache File",
+                         "The file used to persist scan results across sessions",
+                         G_TYPE_FILE,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
   properties [PROP_VCS] =
     g_param_spec_object ("vcs",
                          "Vcs",
@@ -227,33 +655,38 @@ gbp_todo_model_class_init (GbpTodoModelClass *klass)
 
   g_object_class_install_properties (object_class, N_PROPS, properties);
 
-  line1 = g_regex_new ("([a-zA-Z0-9@\\+\\-\\.\\/_]+):(\\d+):(.*)", 0, 0, &error);
-  g_assert_no_error (error);
-  g_assert (line1 != NULL);
-
-  line2 = g_regex_new ("([a-zA-Z0-9@\\+\\-\\.\\/_]+)-(\\d+)-(.*)", 0, 0, &error);
-  g_assert_no_error (error);
-  g_assert (line2 != NULL);
+  for (guint i = 0; i < G_N_ELEMENTS (exclude_files); i++)
+    exclude_specs[i] = g_pattern_spec_new (exclude_files[i]);
 }
 
 static void
 gbp_todo_model_init (GbpTodoModel *self)
 {
   self->items = g_sequence_new (g_object_unref);
+  self->files = g_hash_table_new_full (g_str_hash,
+                                       g_str_equal,
+                                       g_free,
+                                       (GDestroyNotify)todo_file_unref);
 }
 
 /**
  * gbp_todo_model_new:
  * @vcs: The Vcs to check for ignored files
+ * @cache_file: (nullable): a #GFile to persist results to
  *
  * Creates a new #GbpTodoModel.
  *
+ * If @cache_file is set, results from a previous session are loaded from
+ * it so that only files which changed since need to be scanned again.
+ *
  * Returns: (transfer full): A newly created #GbpTodoModel.
  */
 GbpTodoModel *
-gbp_todo_model_new (IdeVcs *vcs)
+gbp_todo_model_new (IdeVcs *vcs,
+                    GFile  *cache_file)
 {
   return g_object_new (GBP_TYPE_TODO_MODEL,
+                       "cache-file", cache_file,
                        "vcs", vcs,
                        NULL);
 }
@@ -262,10 +695,15 @@ static int
 gbp_todo_model_compare_func (GbpTodoItem *a,
                              GbpTodoItem *b)
 {
+  int ret;
+
   g_assert (GBP_IS_TODO_ITEM (a));
   g_assert (GBP_IS_TODO_ITEM (b));
 
-  return g_strcmp0 (a->path, b->path);
+  if (!(ret = g_strcmp0 (a->path, b->path)))
+    ret = (int)a->lineno - (int)b->lineno;
+
+  return ret;
 }
 
 static int
@@ -275,415 +713,368 @@ gbp_todo_model_compare_file (GbpTodoItem *a,
   g_assert (GBP_IS_TODO_ITEM (a));
   g_assert (path != NULL);
 
-  return g_strcmp0 (a->path, path);
+  /* Never report equality so that g_sequence_search() gives us the first
+   * item for @path rather than the position after the last one.
+   */
+  return g_strcmp0 (a->path, path) >= 0 ? 1 : -1;
+}
+
+static void
+gbp_todo_model_replace_path (GbpTodoModel *self,
+                             const char   *path,
+                             GPtrArray    *items)
+{
+  GSequenceIter *iter;
+  guint position;
+  guint removed = 0;
+  guint added = items ? items->len : 0;
+
+  g_assert (GBP_IS_TODO_MODEL (self));
+  g_assert (path != NULL);
+
+  iter = g_sequence_search (self->items,
+                            (gpointer)path,
+                            (GCompareDataFunc)gbp_todo_model_compare_file,
+                            NULL);
+  position = g_sequence_iter_get_position (iter);
+
+  while (!g_sequence_iter_is_end (iter) &&
+         g_strcmp0 (GBP_TODO_ITEM (g_sequence_get (iter))->path, path) == 0)
+    {
+      GSequenceIter *next = g_sequence_iter_next (iter);
+
+      g_sequence_remove (iter);
+      iter = next;
+      removed++;
+    }
+
+  for (guint i = 0; i < added; i++)
+    g_sequence_insert_before (iter, g_object_ref (g_ptr_array_index (items, i)));
+
+  if (removed || added)
+    g_list_model_items_changed (G_LIST_MODEL (self), position, removed, added);
 }
 
 static gboolean
 result_info_merge (gpointer user_data)
 {
   ResultInfo *r = user_data;
-  guint added;
+  GbpTodoModel *self;
+  GHashTableIter iter;
+  const char *path;
+  TodoFile *file;
 
   g_assert (r != NULL);
   g_assert (GBP_IS_TODO_MODEL (r->self));
-  g_assert (G_IS_FILE (r->file));
-  g_assert (r->items != NULL);
 
-  added = g_sequence_get_length (r->items);
+  self = r->self;
 
-  if (!r->single_file)
-    {
-      g_autoptr(GSequence) old_seq = g_steal_pointer (&r->self->items);
-      guint old_len = g_sequence_get_length (old_seq);
+  /* Disposed while we were mining */
+  if (self->items == NULL)
+    return G_SOURCE_REMOVE;
 
-      /* If we are not in single-file mode, then we just indexed the entire
-       * project directory tree. Just swap out our items lists and notify
-       * the list model interface of changes.
-       */
-      r->self->items = g_steal_pointer (&r->items);
+  if (r->single_file)
+    {
+      g_assert (r->path != NULL);
 
-      if (old_len || added)
-        g_list_model_items_changed (G_LIST_MODEL (r->self), 0, old_len, added);
+      if (r->file != NULL)
+        {
+          gbp_todo_model_replace_path (self, r->path, r->file->items);
+          g_hash_table_insert (self->files,
+                               g_steal_pointer (&r->path),
+                               g_steal_pointer (&r->file));
+        }
+      else
+        {
+          gbp_todo_model_replace_path (self, r->path, NULL);
+          g_hash_table_remove (self->files, r->path);
+        }
 
       return G_SOURCE_REMOVE;
     }
-  else
-    {
-      g_autofree char *path = NULL;
-      GSequenceIter *iter;
-      GSequenceIter *prev;
-      GSequenceIter *next;
-      guint position;
-      guint removed = 0;
-
-      /* We parsed a single file for TODOs, so we need to remove all of the old
-       * items first. We search for a GSequenceIter then walk backwards to the
-       * first matching position (since multiple iters returning TRUE from the
-       * compare func do not guarantee we're given the first). After the last
-       * iter is removed, we can start inserting our sorted result set.
-       */
 
-      path = g_file_get_relative_path (r->workdir, r->file);
-      iter = g_sequence_search (r->self->items,
-                                path,
-                                (GCompareDataFunc)gbp_todo_model_compare_file,
-                                NULL);
+  g_assert (r->files != NULL);
 
-      g_assert (iter != NULL);
+  if (g_sequence_is_empty (self->items))
+    {
+      guint added;
 
-      /* Walk backwards to first match. Necessary because GSequence does not
-       * guarantee our binary search will find the first matching iter when
-       * multiple iters may compare equally.
+      /* Common case when loading a project, avoid emitting items-changed
+       * for every file and just sort everything at once.
        */
-      while ((prev = g_sequence_iter_prev (iter)) &&
-             (prev != iter) &&
-             gbp_todo_model_compare_file (g_sequence_get (prev), path) == 0)
-        iter = prev;
-
-      position = g_sequence_iter_get_position (iter);
-
-      while ((next = g_sequence_iter_next (iter)) &&
-             (next != iter) &&
-             gbp_todo_model_compare_file (g_sequence_get (iter), path) == 0)
+      g_hash_table_iter_init (&iter, r->files);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&file))
         {
-          g_sequence_remove (iter);
-          iter = next;
-          removed++;
+          for (guint i = 0; i < file->items->len; i++)
+            g_sequence_append (self->items, g_object_ref (g_ptr_array_index (file->items, i)));
         }
 
-      if (removed > 0)
-        iter = g_sequence_iter_prev (iter);
+      g_sequence_sort (self->items, (GCompareDataFunc)gbp_todo_model_compare_func, NULL);
 
-      if (added > 0)
-        g_sequence_move_range (iter,
-                               g_sequence_get_begin_iter (r->items),
-                               g_sequence_get_end_iter (r->items));
+      g_clear_pointer (&self->files, g_hash_table_unref);
+      self->files = g_steal_pointer (&r->files);
 
-      g_list_model_items_changed (G_LIST_MODEL (r->self), position, removed, added);
+      if ((added = g_sequence_get_length (self->items)))
+        g_list_model_items_changed (G_LIST_MODEL (self), 0, 0, added);
 
       return G_SOURCE_REMOVE;
     }
 
-  g_assert_not_reached ();
-}
-
-static void
-gbp_todo_model_mine_worker (IdeTask      *task,
-                            gpointer      source_object,
-                            gpointer      task_data,
-                            GCancellable *cancellable)
-{
-  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
-  g_autoptr(IdeSubprocess) subprocess = NULL;
-  g_autoptr(GError) error = NULL;
-  g_autoptr(GSequence) items = NULL;
-  g_autoptr(GbpTodoItem) item = NULL;
-  g_autoptr(GBytes) bytes = NULL;
-  g_autoptr(GTimer) timer = g_timer_new ();
-  g_autofree char *workpath = NULL;
-  GbpTodoModel *self = source_object;
-  Mine *m = task_data;
-  IdeLineReader reader;
-  ResultInfo *info;
-  gboolean single_file = FALSE;
-  char *stdoutstr = NULL;
-  char *line;
-  gsize pathlen = 0;
-  gsize stdoutstr_len;
-  gsize len;
-
-  g_assert (IDE_IS_TASK (task));
-  g_assert (GBP_IS_TODO_MODEL (self));
-  g_assert (m != NULL);
-  g_assert (G_IS_FILE (m->file));
-  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
-
-  launcher = ide_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_PIPE);
+  /* Drop files which were removed or are now ignored */
+  g_hash_table_iter_init (&iter, self->files);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&path, NULL))
+    {
+      if (!g_hash_table_contains (r->files, path))
+        {
+          gbp_todo_model_replace_path (self, path, NULL);
+          g_hash_table_iter_remove (&iter);
+        }
+    }
 
-  if (!g_file_is_native (m->workdir) ||
-      !(workpath = g_file_get_path (m->workdir)))
+  /* Unchanged files share the same TodoFile as our snapshot, so we only
+   * need to touch the model for those which were rescanned.
+   */
+  g_hash_table_iter_init (&iter, r->files);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&path, (gpointer *)&file))
     {
-      ide_task_return_new_error (task,
-                                 G_IO_ERROR,
-                                 G_IO_ERROR_NOT_SUPPORTED,
-                                 "Cannot run on non-native file-systems");
-      return;
+      if (g_hash_table_lookup (self->files, path) != file)
+        {
+          gbp_todo_model_replace_path (self, path, file->items);
+          g_hash_table_insert (self->files, g_strdup (path), todo_file_ref (file));
+        }
     }
 
-  pathlen = strlen (workpath);
-  ide_subprocess_launcher_set_cwd (launcher, workpath);
+  return G_SOURCE_REMOVE;
+}
 
-  if (m->use_git_grep)
+static gboolean
+is_excluded_dir (const char *name)
+{
+  for (guint i = 0; i < G_N_ELEMENTS (exclude_dirs); i++)
     {
-      ide_subprocess_launcher_push_argv (launcher, "git");
-      ide_subprocess_launcher_push_argv (launcher, "grep");
+      if (strcmp (name, exclude_dirs[i]) == 0)
+        return TRUE;
     }
-  else
+
+  return FALSE;
+}
+
+static gboolean
+is_excluded_file (const char *name)
+{
+  for (guint i = 0; i < G_N_ELEMENTS (exclude_specs); i++)
     {
-#ifdef __FreeBSD__
-      ide_subprocess_launcher_push_argv (launcher, "bsdgrep");
-#else
-      ide_subprocess_launcher_push_argv (launcher, "grep");
-#endif
+      if (g_pattern_spec_match_string (exclude_specs[i], name))
+        return TRUE;
     }
 
-  ide_subprocess_launcher_push_argv (launcher, "-A");
-  ide_subprocess_launcher_push_argv (launcher, "5");
-  ide_subprocess_launcher_push_argv (launcher, "-I");
-  ide_subprocess_launcher_push_argv (launcher, "-H");
-  ide_subprocess_launcher_push_argv (launcher, "-n");
+  return FALSE;
+}
 
-  if (!m->use_git_grep)
-    ide_subprocess_launcher_push_argv (launcher, "-r");
+static gint64
+get_mtime (GFileInfo *info)
+{
+  return g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+       + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+}
 
-  ide_subprocess_launcher_push_argv (launcher, "-E");
+#define QUERY_ATTRIBUTES               \
+  G_FILE_ATTRIBUTE_STANDARD_NAME","    \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE","    \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE","    \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED","    \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
 
-  if (!m->use_git_grep)
-    {
-      for (guint i = 0; i < G_N_ELEMENTS (exclude_files); i++)
-        {
-          const char *exclude_file = exclude_files[i];
-          g_autofree char *arg = NULL;
+static void
+gbp_todo_model_mine_file (GbpTodoModel *self,
+                          IdeTask      *task,
+                          Mine         *m,
+                          GCancellable *cancellable)
+{
+  g_autoptr(GFileInfo) info = NULL;
+  ResultInfo *r;
 
-          arg = g_strdup_printf ("--exclude=%s", exclude_file);
-          ide_subprocess_launcher_push_argv (launcher, arg);
-        }
+  g_assert (GBP_IS_TODO_MODEL (self));
+  g_assert (IDE_IS_TASK (task));
+  g_assert (m != NULL);
 
-      for (guint i = 0; i < G_N_ELEMENTS (exclude_dirs); i++)
-        {
-          const char *exclude_dir = exclude_dirs[i];
-          g_autofree char *arg = NULL;
+  r = g_slice_new0 (ResultInfo);
+  r->self = g_object_ref (self);
+  r->single_file = TRUE;
 
-          arg = g_strdup_printf ("--exclude-dir=%s", exclude_dir);
-          ide_subprocess_launcher_push_argv (launcher, arg);
-        }
+  if (!(r->path = g_file_get_relative_path (m->workdir, m->file)))
+    {
+      /* Only files within the project are tracked */
+      result_info_free (r);
+      ide_task_return_boolean (task, TRUE);
+      return;
     }
 
-  for (guint i = 0; i < G_N_ELEMENTS (keywords); i++)
+  /*
+   * self->vcs is only set at construction, so safe to access via a
+   * worker thread. ide_vcs_is_ignored() is expected to be thread-safe
+   * as well. If the file vanished or is ignored, the merge removes it.
+   */
+  if ((info = g_file_query_info (m->file,
+                                 QUERY_ATTRIBUTES,
+                                 G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                 cancellable,
+                                 NULL)) &&
+      g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR &&
+      !is_excluded_file (g_file_info_get_name (info)) &&
+      !ide_vcs_is_ignored (self->vcs, m->file, NULL))
+    r->file = todo_file_scan (g_file_peek_path (m->file),
+                              r->path,
+                              get_mtime (info),
+                              g_file_info_get_size (info));
+
+  /* Persist the update so the next session does not rescan the file. If
+   * nothing was mined yet, update the previous session's results rather
+   * than replacing them with just this file.
+   */
+  if (m->cache_file != NULL)
     {
-      const char *keyword = keywords[i];
-      g_autofree char *arg = NULL;
+      if (g_hash_table_size (m->known) == 0)
+        gbp_todo_model_load_cache (m->cache_file, m->branch, m->known);
 
-      arg = g_strdup_printf ("%s(:| )", keyword);
-      ide_subprocess_launcher_push_argv (launcher, "-e");
-      ide_subprocess_launcher_push_argv (launcher, arg);
+      if (r->file != NULL)
+        g_hash_table_insert (m->known, g_strdup (r->path), todo_file_ref (r->file));
+      else
+        g_hash_table_remove (m->known, r->path);
 
-      if (m->use_git_grep)
-        {
-          /* Avoid pathological lines up front before reading them into
-           * the UI process memory space.
-           *
-           * Note that we do this *after* our TODO: match because it causes
-           * grep to have to look at every line up to it. So to do this in
-           * reverse order is incredibly slow.
-           */
-          ide_subprocess_launcher_push_argv (launcher, "--and");
-          ide_subprocess_launcher_push_argv (launcher, "-e");
-          ide_subprocess_launcher_push_argv (launcher, "^.{0,256}$");
-        }
+      gbp_todo_model_save_cache (m->cache_file, m->branch, m->known);
     }
 
-  if (g_file_query_file_type (m->file, 0, NULL) != G_FILE_TYPE_DIRECTORY)
-    {
-      ide_subprocess_launcher_push_argv (launcher, g_file_peek_path (m->file));
-      single_file = TRUE;
-    }
+  g_idle_add_full (G_PRIORITY_LOW + 100, result_info_merge, r, result_info_free);
 
-  /* Spawn our grep process */
-  if (!(subprocess = ide_subprocess_launcher_spawn (launcher, cancellable, &error)))
-    {
-      ide_task_return_error (task, g_steal_pointer (&error));
-      return;
-    }
+  ide_task_return_boolean (task, TRUE);
+}
 
-  /* Read all of the output into a giant string */
-  if (!ide_subprocess_communicate_utf8 (subprocess, NULL, NULL, &stdoutstr, NULL, &error))
+static void
+gbp_todo_model_mine_worker (IdeTask      *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  g_autoptr(GHashTable) files = NULL;
+  g_autoptr(GTimer) timer = g_timer_new ();
+  GbpTodoModel *self = source_object;
+  GQueue directories = G_QUEUE_INIT;
+  GFile *directory;
+  Mine *m = task_data;
+  ResultInfo *r;
+  guint n_reused = 0;
+  guint n_scanned = 0;
+
+  g_assert (IDE_IS_TASK (task));
+  g_assert (GBP_IS_TODO_MODEL (self));
+  g_assert (m != NULL);
+  g_assert (G_IS_FILE (m->file));
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  if (g_file_query_file_type (m->file, 0, NULL) != G_FILE_TYPE_DIRECTORY)
     {
-      ide_task_return_error (task, g_steal_pointer (&error));
+      gbp_todo_model_mine_file (self, task, m, cancellable);
       return;
     }
 
-  /*
-   * To avoid lots of string allocations in the model, we instead
-   * store GObjects which contain a reference to the whole buffer
-   * (the GBytes) and raw pointers into that data. We'll create
-   * the buffer up front, but still mutate the contents as we
-   * walk through it.
-   */
-  stdoutstr_len = strlen (stdoutstr);
-  bytes = g_bytes_new_take (stdoutstr, stdoutstr_len);
+  /* Nothing in memory yet, so try to reuse results from a previous session */
+  if (g_hash_table_size (m->known) == 0 && m->cache_file != NULL)
+    gbp_todo_model_load_cache (m->cache_file, m->branch, m->known);
 
-  items = g_sequence_new (g_object_unref);
+  files = g_hash_table_new_full (g_str_hash,
+                                 g_str_equal,
+                                 g_free,
+                                 (GDestroyNotify)todo_file_unref);
 
-  /*
-   * Process the STDOUT string iteratively, while trying to be tidy
-   * with additional allocations. If we overwrite the trailing \n to
-   * a \0, we can use it as a C string.
-   */
-  ide_line_reader_init (&reader, stdoutstr, stdoutstr_len);
-  while ((line = ide_line_reader_next (&reader, &len)))
+  g_queue_push_tail (&directories, g_object_ref (m->file));
+
+  while ((directory = g_queue_pop_head (&directories)))
     {
-      g_autoptr(GMatchInfo) match_info1 = NULL;
-      g_autoptr(GMatchInfo) match_info2 = NULL;
+      g_autoptr(GFileEnumerator) enumerator = NULL;
+      g_autoptr(GFile) dir = directory;
 
-      line[len] = '\0';
+      if (g_cancellable_is_cancelled (cancellable))
+        continue;
 
-      /* We just finished a group of lines, flush this item
-       * to the list of items and get started processing the
-       * next result.
-       */
-      if (g_str_has_prefix (line, "--"))
+      if (!(enumerator = g_file_enumerate_children (dir,
+                                                    QUERY_ATTRIBUTES,
+                                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                    cancellable,
+                                                    NULL)))
+        continue;
+
+      for (;;)
         {
-          if (item != NULL)
+          g_autofree char *path = NULL;
+          GFileInfo *info = NULL;
+          GFile *child = NULL;
+          const char *name;
+          TodoFile *file;
+          GFileType file_type;
+          guint64 size;
+          gint64 mtime;
+
+          if (!g_file_enumerator_iterate (enumerator, &info, &child, cancellable, NULL) ||
+              info == NULL)
+            break;
+
+          name = g_file_info_get_name (info);
+          file_type = g_file_info_get_file_type (info);
+
+          if (file_type == G_FILE_TYPE_DIRECTORY)
             {
-              if (m->use_git_grep)
-                {
-                  g_sequence_append (items, g_steal_pointer (&item));
-                }
-              else
-                {
-                  const char *pathstr = gbp_todo_item_get_path (item);
-
-                  /*
-                   * self->vcs is only set at construction, so safe to
-                   * access via a worker thread. ide_vcs_path_is_ignored()
-                   * is expected to be thread-safe as well.
-                   */
-                  if (!ide_vcs_path_is_ignored (self->vcs, pathstr, NULL))
-                    g_sequence_append (items, g_steal_pointer (&item));
-                  else
-                    g_clear_object (&item);
-                }
+              if (!is_excluded_dir (name) &&
+                  !ide_vcs_is_ignored (self->vcs, child, NULL))
+                g_queue_push_tail (&directories, g_object_ref (child));
+              continue;
             }
 
-          continue;
-        }
+          if (file_type != G_FILE_TYPE_REGULAR ||
+              is_excluded_file (name) ||
+              ide_vcs_is_ignored (self->vcs, child, NULL) ||
+              !(path = g_file_get_relative_path (m->workdir, child)))
+            continue;
 
-      if (ide_str_empty0 (line) || len > 256)
-        {
-          /* cancel anything if the line is too long so that we don't get into
-           * pathological cases.
-           */
-          g_clear_object (&item);
-          continue;
-        }
+          mtime = get_mtime (info);
+          size = g_file_info_get_size (info);
 
-      /* Try to match the first line */
-      if (item == NULL)
-        {
-          if (g_regex_match_full (line1, line, len, 0, 0, &match_info1, NULL))
+          if ((file = g_hash_table_lookup (m->known, path)) &&
+              file->mtime == mtime &&
+              file->size == size)
             {
-              gint begin;
-              gint end;
-
-              item = gbp_todo_item_new (bytes);
-
-              /* Get the path */
-              if (g_match_info_fetch_pos (match_info1, 1, &begin, &end))
-                {
-                  const char *pathstr;
-
-                  line[end] = '\0';
-                  pathstr = &line[begin];
-
-                  if (pathlen == 0 || strncmp (workpath, pathstr, pathlen) == 0)
-                    {
-                      pathstr += pathlen;
-
-                      while (*pathstr == G_DIR_SEPARATOR)
-                        pathstr++;
-                    }
-
-                  gbp_todo_item_set_path (item, pathstr);
-                }
-
-              /* Get the line number */
-              if (g_match_info_fetch_pos (match_info1, 2, &begin, &end))
-                {
-                  gint64 lineno;
-
-                  line[end] = '\0';
-                  lineno = g_ascii_strtoll (&line[begin], NULL, 10);
-                  gbp_todo_item_set_lineno (item, lineno);
-                }
-
-              /* Get the message */
-              if (g_match_info_fetch_pos (match_info1, 3, &begin, &end))
-                {
-                  line[end] = '\0';
-                  gbp_todo_item_add_line (item, &line[begin]);
-                }
+              todo_file_ref (file);
+              n_reused++;
             }
-
-          continue;
-        }
-
-      g_assert (item != NULL);
-
-      if (g_regex_match_full (line2, line, len, 0, 0, &match_info2, NULL))
-        {
-          gint begin;
-          gint end;
-
-          /* Get the message */
-          if (g_match_info_fetch_pos (match_info2, 3, &begin, &end))
+          else
             {
-              line[end] = '\0';
-              gbp_todo_item_add_line (item, &line[begin]);
+              file = todo_file_scan (g_file_peek_path (child), path, mtime, size);
+              n_scanned++;
             }
-        }
-    }
 
-  /* We might have a trailing item w/o final -- */
-  if (item != NULL)
-    {
-      if (m->use_git_grep)
-        {
-          g_sequence_append (items, g_steal_pointer (&item));
-        }
-      else
-        {
-          const char *pathstr = gbp_todo_item_get_path (item);
-
-          /*
-           * self->vcs is only set at construction, so safe to
-           * access via a worker thread. ide_vcs_path_is_ignored()
-           * is expected to be thread-safe as well.
-           */
-          if (!ide_vcs_path_is_ignored (self->vcs, pathstr, NULL))
-            g_sequence_append (items, g_steal_pointer (&item));
-          else
-            g_clear_object (&item);
+          g_hash_table_insert (files, g_steal_pointer (&path), file);
         }
     }
 
-  g_debug ("Located %d TODO items in %0.4lf seconds",
-           g_sequence_get_length (items),
-           g_timer_elapsed (timer, NULL));
+  g_queue_clear_full (&directories, g_object_unref);
 
-  info = g_slice_new0 (ResultInfo);
-  info->self = g_object_ref (source_object);
-  info->items = g_steal_pointer (&items);
-  info->file = g_object_ref (m->file);
-  info->single_file = single_file;
-  info->workdir = g_object_ref (m->workdir);
+  if (ide_task_return_error_if_cancelled (task))
+    return;
 
-  /* Sort our result set to help reduce how much sorting
-   * needs to be done on the main thread later.
-   */
-  g_sequence_sort (info->items, (GCompareDataFunc)gbp_todo_model_compare_func, NULL);
+  g_debug ("Scanned %u files for TODO items, reused %u, in %0.4lf seconds",
+           n_scanned, n_reused, g_timer_elapsed (timer, NULL));
 
-  g_idle_add_full (G_PRIORITY_LOW + 100,
-                   result_info_merge, info, result_info_free);
+  if (m->cache_file != NULL &&
+      (n_scanned > 0 || n_reused != g_hash_table_size (m->known)))
+    gbp_todo_model_save_cache (m->cache_file, m->branch, files);
 
-  ide_task_return_boolean (task, TRUE);
-}
+  r = g_slice_new0 (ResultInfo);
+  r->self = g_object_ref (self);
+  r->files = g_steal_pointer (&files);
 
-static gboolean
-is_typed (IdeVcs     *vcs,
-          const char *name)
-{
-  return g_strcmp0 (G_OBJECT_TYPE_NAME (vcs), name) == 0;
+  g_idle_add_full (G_PRIORITY_LOW + 100, result_info_merge, r, result_info_free);
+
+  ide_task_return_boolean (task, TRUE);
 }
 
 /**
@@ -696,8 +1087,9 @@ is_typed (IdeVcs     *vcs,
  *
  * Asynchronously mines @file.
  *
- * If @file is a directory, it will be recursively scanned.  @callback
- * will be called after the operation is complete.  Call
+ * If @file is a directory, it will be recursively scanned, reusing the
+ * results for any file which has not changed since it was last scanned.
+ * @callback will be called after the operation is complete.  Call
  * gbp_todo_model_mine_finish() to get the result of this operation.
  *
  * If @file is not a native file (meaning it is accessable on the
@@ -711,6 +1103,9 @@ gbp_todo_model_mine_async (GbpTodoModel        *self,
                            gpointer             user_data)
 {
   g_autoptr(IdeTask) task = NULL;
+  GHashTableIter iter;
+  const char *path;
+  TodoFile *todo_file;
   GFile *workdir;
   Mine *m;
 
@@ -737,9 +1132,32 @@ gbp_todo_model_mine_async (GbpTodoModel        *self,
   m = g_slice_new0 (Mine);
   m->file = g_object_ref (file);
   m->workdir = g_object_ref (workdir);
-  m->use_git_grep = is_typed (self->vcs, "IdeGitVcs");
+  m->cache_file = self->cache_file ? g_object_ref (self->cache_file) : NULL;
+  m->branch = ide_vcs_get_branch_name (self->vcs);
+  if (m->branch == NULL)
+    m->branch = g_strdup ("");
+  m->known = g_hash_table_new_full (g_str_hash,
+                                    g_str_equal,
+                                    g_free,
+                                    (GDestroyNotify)todo_file_unref);
   ide_task_set_task_data (task, m, mine_free);
 
+  /* TodoFile is immutable once created, so a shallow copy is enough for
+   * the worker to compare against. Results from another branch must all
+   * be scanned again.
+   */
+  if (g_strcmp0 (self->branch, m->branch) == 0)
+    {
+      g_hash_table_iter_init (&iter, self->files);
+      while (g_hash_table_iter_next (&iter, (gpointer *)&path, (gpointer *)&todo_file))
+        g_hash_table_insert (m->known, g_strdup (path), todo_file_ref (todo_file));
+    }
+  else
+    {
+      g_free (self->branch);
+      self->branch = g_strdup (m->branch);
+    }
+
   ide_task_run_in_thread (task, gbp_todo_model_mine_worker);
 }
 
@@ -28,7 +28,8 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GbpTodoModel, gbp_todo_model, GBP, TODO_MODEL, GObject)
 
-GbpTodoModel *gbp_todo_model_new         (IdeVcs               *vcs);
+GbpTodoModel *gbp_todo_model_new         (IdeVcs               *vcs,
+                                          GFile                *cache_file);
 void          gbp_todo_model_mine_async  (GbpTodoModel         *self,
                                           GFile                *file,
                                           GCancellable         *cancellable,
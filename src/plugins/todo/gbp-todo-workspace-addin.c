@@ -84,6 +84,28 @@ gbp_todo_workspace_addin_presented_cb (GbpTodoWorkspaceAddin *self,
                              g_object_ref (self));
 }
 
+static void
+gbp_todo_workspace_addin_vcs_changed (GbpTodoWorkspaceAddin *self,
+                                      IdeVcs                *vcs)
+{
+  g_assert (GBP_IS_TODO_WORKSPACE_ADDIN (self));
+  g_assert (IDE_IS_VCS (vcs));
+
+  /* A checkout or branch switch may have changed any file, so mine the
+   * whole tree again. Unchanged files are reused by the model.
+   */
+  if (self->model == NULL || !self->has_presented || self->is_global_mining)
+    return;
+
+  self->is_global_mining = TRUE;
+
+  gbp_todo_model_mine_async (self->model,
+                             self->workdir,
+                             self->cancellable,
+                             gbp_todo_workspace_addin_mine_cb,
+                             g_object_ref (self));
+}
+
 static void
 gbp_todo_workspace_addin_buffer_saved (GbpTodoWorkspaceAddin *self,
                                        IdeBuffer             *buffer,
@@ -113,6 +135,7 @@ gbp_todo_workspace_addin_load (IdeWorkspaceAddin *addin,
 {
   GbpTodoWorkspaceAddin *self = (GbpTodoWorkspaceAddin *)addin;
   g_autoptr(PanelPosition) position = NULL;
+  g_autoptr(GFile) cache_file = NULL;
   IdeBufferManager *bufmgr;
   IdeContext *context;
   IdeVcs *vcs;
@@ -136,7 +159,14 @@ gbp_todo_workspace_addin_load (IdeWorkspaceAddin *addin,
                            self,
                            G_CONNECT_SWAPPED);
 
-  self->model = gbp_todo_model_new (vcs);
+  g_signal_connect_object (vcs,
+                           "changed",
+                           G_CALLBACK (gbp_todo_workspace_addin_vcs_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  cache_file = ide_context_cache_file (context, "todo", "todo.gvariant", NULL);
+  self->model = gbp_todo_model_new (vcs, cache_file);
 
   self->panel = g_object_new (GBP_TYPE_TODO_PANEL,
                               "title", _("TODO/FIXMEs"),
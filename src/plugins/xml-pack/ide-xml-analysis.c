@@ -75,6 +75,23 @@ ide_xml_analysis_get_schemas (IdeXmlAnalysis *self)
   return self->schemas;
 }
 
+/**
+ * ide_xml_analysis_get_content:
+ * @self: an #IdeXmlAnalysis.
+ *
+ * Gets the content the analysis was built from, if its tree can be used
+ * to incrementally parse a newer version of the content.
+ *
+ * Returns: (nullable) (transfer none): a #GBytes or %NULL
+ */
+GBytes *
+ide_xml_analysis_get_content (IdeXmlAnalysis *self)
+{
+  g_return_val_if_fail (self, NULL);
+
+  return self->content;
+}
+
 void
 ide_xml_analysis_set_diagnostics (IdeXmlAnalysis *self,
                                   IdeDiagnostics *diagnostics)
@@ -109,6 +126,20 @@ ide_xml_analysis_set_schemas (IdeXmlAnalysis *self,
     }
 }
 
+void
+ide_xml_analysis_set_content (IdeXmlAnalysis *self,
+                              GBytes         *content)
+{
+  g_return_if_fail (self != NULL);
+
+  if (self->content != content)
+    {
+      g_clear_pointer (&self->content, g_bytes_unref);
+      if (content != NULL)
+        self->content = g_bytes_ref (content);
+    }
+}
+
 void
 ide_xml_analysis_set_sequence (IdeXmlAnalysis   *self,
                                gint64            sequence)
@@ -138,6 +169,7 @@ ide_xml_analysis_free (IdeXmlAnalysis *self)
 
   g_clear_object (&self->root_node);
   g_clear_object (&self->diagnostics);
+  g_clear_pointer (&self->content, g_bytes_unref);
   g_slice_free (IdeXmlAnalysis, self);
 }
 
@@ -36,6 +36,7 @@ struct _IdeXmlAnalysis
   IdeXmlSymbolNode *root_node;
   IdeDiagnostics   *diagnostics;
   GPtrArray        *schemas;       // array of IdeXmlSchemaCacheEntry
+  GBytes           *content;       // set if the tree can be reparsed incrementally
   gint64            sequence;
 };
 
@@ -44,6 +45,7 @@ IdeDiagnostics     *ide_xml_analysis_get_diagnostics     (IdeXmlAnalysis   *self
 IdeXmlSymbolNode   *ide_xml_analysis_get_root_node       (IdeXmlAnalysis   *self);
 gint64              ide_xml_analysis_get_sequence        (IdeXmlAnalysis   *self);
 GPtrArray          *ide_xml_analysis_get_schemas         (IdeXmlAnalysis   *self);
+GBytes             *ide_xml_analysis_get_content         (IdeXmlAnalysis   *self);
 void                ide_xml_analysis_set_diagnostics     (IdeXmlAnalysis   *self,
                                                           IdeDiagnostics   *diagnostics);
 void                ide_xml_analysis_set_root_node       (IdeXmlAnalysis   *self,
@@ -52,6 +54,8 @@ void                ide_xml_analysis_set_sequence        (IdeXmlAnalysis   *self
                                                           gint64            sequence);
 void                ide_xml_analysis_set_schemas         (IdeXmlAnalysis   *self,
                                                           GPtrArray        *schemas);
+void                ide_xml_analysis_set_content         (IdeXmlAnalysis   *self,
+                                                          GBytes           *content);
 IdeXmlAnalysis     *ide_xml_analysis_new                 (gint64            sequence);
 IdeXmlAnalysis     *ide_xml_analysis_ref                 (IdeXmlAnalysis   *self);
 void                ide_xml_analysis_unref               (IdeXmlAnalysis   *self);
@@ -66,6 +66,7 @@ typedef struct _ParserState
   GFile             *file;
   GBytes            *content;
   IdeXmlAnalysis    *analysis;
+  IdeXmlAnalysis    *previous;
   GPtrArray         *diagnostics_array;
   IdeXmlSymbolNode  *root_node;
   IdeXmlSymbolNode  *parent_node;
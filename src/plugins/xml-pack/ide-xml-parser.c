@@ -70,6 +70,7 @@ static void
 parser_state_free (ParserState *state)
 {
   g_clear_pointer (&state->analysis, ide_xml_analysis_unref);
+  g_clear_pointer (&state->previous, ide_xml_analysis_unref);
   g_clear_pointer (&state->diagnostics_array, g_ptr_array_unref);
   g_clear_object (&state->file);
   g_clear_object (&state->root_node);
@@ -559,6 +560,338 @@ ide_xml_parser_characters_sax_cb (ParserState    *state,
   ide_xml_parser_state_processing (self, state, element_value, NULL, IDE_XML_SAX_CALLBACK_TYPE_CHAR, FALSE);
 }
 
+static GArray *
+index_lines (const gchar *data,
+             gsize        len)
+{
+  const gchar *end = data + len;
+  const gchar *iter = data;
+  GArray *lines;
+  gsize offset = 0;
+
+  lines = g_array_new (FALSE, FALSE, sizeof (gsize));
+  g_array_append_val (lines, offset);
+
+  while ((iter = memchr (iter, '\n', end - iter)))
+    {
+      iter++;
+      offset = iter - data;
+      g_array_append_val (lines, offset);
+    }
+
+  return lines;
+}
+
+static guint
+count_newlines (const gchar *data,
+                gsize        len)
+{
+  const gchar *end = data + len;
+  guint count = 0;
+
+  while ((data = memchr (data, '\n', end - data)))
+    {
+      count++;
+      data++;
+    }
+
+  return count;
+}
+
+/* Returns the 1-based line containing @offset */
+static gint
+offset_to_line (GArray *lines,
+                gsize   offset)
+{
+  guint lo = 0;
+  guint hi = lines->len;
+
+  while (hi - lo > 1)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (g_array_index (lines, gsize, mid) <= offset)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  return lo + 1;
+}
+
+/* Locations from the sax parser are 1-based lines and byte columns */
+static gboolean
+location_to_offset (GArray *lines,
+                    gsize   len,
+                    gint    line,
+                    gint    line_offset,
+                    gsize  *offset)
+{
+  if (line < 1 || line_offset < 1 || (guint)line > lines->len)
+    return FALSE;
+
+  *offset = g_array_index (lines, gsize, line - 1) + line_offset - 1;
+
+  return *offset < len;
+}
+
+static gboolean
+node_get_range (IdeXmlSymbolNode *node,
+                GArray           *lines,
+                gsize             len,
+                gsize            *begin,
+                gsize            *end)
+{
+  gint start_line, start_line_offset;
+  gint end_line, end_line_offset;
+
+  if (!ide_xml_symbol_node_has_end_tag (node) ||
+      ide_xml_symbol_node_get_state (node) != IDE_XML_SYMBOL_NODE_STATE_OK)
+    return FALSE;
+
+  ide_xml_symbol_node_get_location (node, &start_line, &start_line_offset, NULL, NULL, NULL);
+  ide_xml_symbol_node_get_end_tag_location (node, NULL, NULL, &end_line, &end_line_offset, NULL);
+
+  if (!location_to_offset (lines, len, start_line, start_line_offset, begin) ||
+      !location_to_offset (lines, len, end_line, end_line_offset, end))
+    return FALSE;
+
+  /* Include the closing '>' of the end tag */
+  (*end)++;
+
+  return *begin < *end;
+}
+
+/* Returns the deepest element which strictly contains [@begin, @end) so that
+ * both of its tags are left untouched by the edit.
+ */
+static IdeXmlSymbolNode *
+find_enclosing_node (IdeXmlSymbolNode *root,
+                     GArray           *lines,
+                     gsize             len,
+                     gsize             begin,
+                     gsize             end,
+                     gsize            *node_begin,
+                     gsize            *node_end)
+{
+  IdeXmlSymbolNode *found = NULL;
+  IdeXmlSymbolNode *node = root;
+  gboolean descended;
+
+  do
+    {
+      guint n_children = ide_xml_symbol_node_get_n_direct_children (node);
+
+      descended = FALSE;
+
+      for (guint i = 0; i < n_children; i++)
+        {
+          g_autoptr(IdeXmlSymbolNode) child = NULL;
+          gsize child_begin;
+          gsize child_end;
+
+          child = IDE_XML_SYMBOL_NODE (ide_xml_symbol_node_get_nth_direct_child (node, i));
+
+          if (!node_get_range (child, lines, len, &child_begin, &child_end))
+            continue;
+
+          if (child_begin >= end)
+            break;
+
+          if (child_begin < begin && end < child_end)
+            {
+              found = node = child;
+              *node_begin = child_begin;
+              *node_end = child_end;
+              descended = TRUE;
+              break;
+            }
+        }
+    }
+  while (descended);
+
+  return found;
+}
+
+/* Labels of these .ui nodes are computed from their children during the
+ * post-processing, so they must be reparsed along with them.
+ */
+static gboolean
+ui_node_depends_on_children (IdeXmlSymbolNode *node)
+{
+  const gchar *element_name = ide_xml_symbol_node_get_element_name (node);
+
+  return ide_str_equal0 (element_name, "style") ||
+         ide_str_equal0 (element_name, "item") ||
+         ide_str_equal0 (element_name, "submenu") ||
+         ide_str_equal0 (element_name, "section");
+}
+
+/* Try to build the analysis by reparsing only the smallest element enclosing
+ * the change since the previous analysis, and splicing the result into a copy
+ * of its tree. Returns %NULL if the full document must be parsed instead.
+ *
+ * To keep the locations reported by the sax parser identical to the ones of
+ * a full parse, the element is preceded by as many newlines and spaces as
+ * needed to put it back at its position in the document.
+ */
+static IdeXmlAnalysis *
+ide_xml_parser_reparse (IdeXmlParser *self,
+                        ParserState  *state)
+{
+  g_autoptr(IdeXmlSymbolNode) stub = NULL;
+  g_autoptr(IdeXmlSymbolNode) root_node = NULL;
+  g_autoptr(IdeDiagnostics) diagnostics = NULL;
+  g_autoptr(GArray) lines = NULL;
+  g_autofree gchar *uri = NULL;
+  g_autofree gchar *fragment = NULL;
+  IdeXmlAnalysis *analysis;
+  IdeXmlSymbolNode *target;
+  IdeXmlSymbolNode *parent;
+  ParserState *fragment_state;
+  const gchar *old_data;
+  const gchar *new_data;
+  const gchar *nl;
+  gsize old_len;
+  gsize new_len;
+  gsize prefix = 0;
+  gsize suffix = 0;
+  gsize old_end;
+  gsize new_end;
+  gsize begin;
+  gsize end;
+  gsize fragment_len;
+  gsize padding;
+  gint target_line;
+  gint line;
+  gint line_offset;
+  gint new_line;
+  gint new_line_offset;
+
+  g_assert (IDE_IS_XML_PARSER (self));
+  g_assert (state != NULL);
+
+  if (state->previous == NULL ||
+      state->previous->content == NULL ||
+      state->previous->root_node == NULL)
+    return NULL;
+
+  old_data = g_bytes_get_data (state->previous->content, &old_len);
+  new_data = g_bytes_get_data (state->content, &new_len);
+
+  while (prefix < old_len && prefix < new_len && old_data[prefix] == new_data[prefix])
+    prefix++;
+
+  while (suffix < old_len - prefix &&
+         suffix < new_len - prefix &&
+         old_data[old_len - suffix - 1] == new_data[new_len - suffix - 1])
+    suffix++;
+
+  old_end = old_len - suffix;
+  new_end = new_len - suffix;
+
+  lines = index_lines (old_data, old_len);
+
+  if (!(target = find_enclosing_node (state->previous->root_node, lines, old_len,
+                                      prefix, old_end, &begin, &end)))
+    return NULL;
+
+  parent = ide_xml_symbol_node_get_parent (target);
+
+  while (state->file_is_ui && parent != NULL && ui_node_depends_on_children (parent))
+    {
+      target = parent;
+      if (!node_get_range (target, lines, old_len, &begin, &end))
+        return NULL;
+      parent = ide_xml_symbol_node_get_parent (target);
+    }
+
+  if (parent == NULL)
+    return NULL;
+
+  /* Position of the end of the edit, before and after it */
+  line = offset_to_line (lines, old_end);
+  line_offset = old_end - g_array_index (lines, gsize, line - 1) + 1;
+
+  new_line = line - count_newlines (old_data + prefix, old_end - prefix)
+                  + count_newlines (new_data + prefix, new_end - prefix);
+  nl = new_data + new_end;
+  while (nl > new_data && nl[-1] != '\n')
+    nl--;
+  new_line_offset = (new_data + new_end - nl) + 1;
+
+  /* Pad the element so it is found at its location in the document */
+  ide_xml_symbol_node_get_location (target, &target_line, NULL, NULL, NULL, NULL);
+  padding = (target_line - 1) + (begin - g_array_index (lines, gsize, target_line - 1));
+  fragment_len = padding + (end - begin) + new_len - old_len;
+  fragment = g_malloc (fragment_len + 1);
+  memset (fragment, ' ', padding);
+  memset (fragment, '\n', target_line - 1);
+  memcpy (fragment + padding, new_data + begin, fragment_len - padding);
+  fragment[fragment_len] = 0;
+
+  /* The stub stands in for the parent of @target so that specific parsers
+   * see the same context as during a full parse.
+   */
+  stub = ide_xml_symbol_node_new ("root", NULL,
+                                  ide_xml_symbol_node_get_element_name (parent),
+                                  IDE_SYMBOL_KIND_NONE);
+
+  fragment_state = g_slice_new0 (ParserState);
+  fragment_state->self = self;
+  fragment_state->file = g_object_ref (state->file);
+  fragment_state->diagnostics_array = g_ptr_array_new_with_free_func (g_object_unref);
+  fragment_state->schemas = g_ptr_array_new_with_free_func (g_object_unref);
+  fragment_state->sax_parser = ide_xml_sax_new ();
+  fragment_state->stack = ide_xml_stack_new ();
+  fragment_state->build_state = BUILD_STATE_NORMAL;
+  fragment_state->root_node = g_object_ref (stub);
+  fragment_state->parent_node = stub;
+  ide_xml_stack_push (fragment_state->stack, "root", stub, NULL, 0);
+
+  if (state->file_is_ui)
+    ide_xml_parser_ui_setup (self, fragment_state);
+  else
+    ide_xml_parser_generic_setup (self, fragment_state);
+
+  uri = g_file_get_uri (state->file);
+
+  /* Anything unusual (errors, schemas, or not exactly one element back)
+   * and we let the full parse deal with it.
+   */
+  if (!ide_xml_sax_parse (fragment_state->sax_parser, fragment, fragment_len, uri, fragment_state) ||
+      fragment_state->diagnostics_array->len > 0 ||
+      fragment_state->schemas->len > 0 ||
+      ide_xml_symbol_node_get_n_direct_children (stub) != 1)
+    {
+      parser_state_free (fragment_state);
+      return NULL;
+    }
+
+  if (self->post_processing_callback != NULL)
+    (self->post_processing_callback)(self, stub);
+
+  parser_state_free (fragment_state);
+
+  root_node = ide_xml_symbol_node_splice (state->previous->root_node,
+                                          target,
+                                          stub,
+                                          line, line_offset,
+                                          new_line, new_line_offset);
+
+  analysis = ide_xml_analysis_new (state->sequence);
+  ide_xml_analysis_set_root_node (analysis, root_node);
+  ide_xml_analysis_set_content (analysis, state->content);
+
+  diagnostics = ide_diagnostics_new ();
+  ide_xml_analysis_set_diagnostics (analysis, diagnostics);
+
+  /* The prolog did not change, neither did the schemas it references */
+  ide_xml_analysis_set_schemas (analysis, state->previous->schemas);
+
+  return analysis;
+}
+
 static void
 ide_xml_parser_get_analysis_worker (IdeTask      *task,
                                     gpointer      source_object,
@@ -585,6 +918,13 @@ ide_xml_parser_get_analysis_worker (IdeTask      *task,
   doc_data = g_bytes_get_data (state->content, &doc_size);
 
   state->file_is_ui = ide_xml_parser_file_is_ui (state->file, doc_data, doc_size);
+
+  if ((analysis = ide_xml_parser_reparse (self, state)))
+    {
+      ide_task_return_pointer (task, analysis, ide_xml_analysis_unref);
+      return;
+    }
+
   if (state->file_is_ui)
     ide_xml_parser_ui_setup (self, state);
   else
@@ -613,6 +953,12 @@ ide_xml_parser_get_analysis_worker (IdeTask      *task,
     }
   ide_xml_analysis_set_diagnostics (analysis, diagnostics);
 
+  /* Only a tree without errors can be spliced into later on, otherwise
+   * the recovery done by the parser may depend on what follows.
+   */
+  if (ide_diagnostics_get_size (diagnostics) == 0)
+    ide_xml_analysis_set_content (analysis, state->content);
+
   /* by default use gtk4builder.rng and only gtkbuilder.rng if explicitly stated in the ui file.
    * As gtkbuilder.rng is a subset of gtk4builder.rng this probably never makes problems.
    */
@@ -647,6 +993,7 @@ ide_xml_parser_get_analysis_async (IdeXmlParser        *self,
                                    GFile               *file,
                                    GBytes              *content,
                                    gint64               sequence,
+                                   IdeXmlAnalysis      *previous,
                                    GCancellable        *cancellable,
                                    GAsyncReadyCallback  callback,
                                    gpointer             user_data)
@@ -666,6 +1013,7 @@ ide_xml_parser_get_analysis_async (IdeXmlParser        *self,
   state->file = g_object_ref (file);
   state->content = g_bytes_ref (content);
   state->sequence = sequence;
+  state->previous = previous ? ide_xml_analysis_ref (previous) : NULL;
   state->diagnostics_array = g_ptr_array_new_with_free_func (g_object_unref);
   state->schemas = g_ptr_array_new_with_free_func (g_object_unref);
   state->sax_parser = ide_xml_sax_new ();
@@ -34,6 +34,7 @@ void               ide_xml_parser_get_analysis_async    (IdeXmlParser         *s
                                                          GFile                *file,
                                                          GBytes               *content,
                                                          gint64                sequence,
+                                                         IdeXmlAnalysis       *previous,
                                                          GCancellable         *cancellable,
                                                          GAsyncReadyCallback   callback,
                                                          gpointer              user_data);
@@ -0,0 +1,532 @@
+/* ide-xml-rng-cache.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "ide-xml-rng-cache"
+
+#include "config.h"
+
+#include <libide-core.h>
+#include <libxml/xmlstring.h>
+
+#include "ide-xml-rng-cache.h"
+
+/* Compiled schemas are stored as a flat array of defines where every link
+ * to another define is an index into the array (or -1). The first define
+ * is the start of the grammar. Only what the completion provider walks is
+ * kept, which is everything reachable from the start defines.
+ */
+#define CACHE_VERSION 1
+#define DEFINE_TYPE   "(umsmsiiiiinibb)"
+#define DEFINES_TYPE  "a" DEFINE_TYPE
+#define CACHE_TYPE    "(uss" DEFINES_TYPE ")"
+
+enum {
+  LINK_PARENT,
+  LINK_NEXT,
+  LINK_CONTENT,
+  LINK_ATTRIBUTES,
+  LINK_NAME_CLASS,
+  N_LINKS
+};
+
+typedef struct
+{
+  gint32 index[N_LINKS];
+} Links;
+
+typedef struct
+{
+  char         *content_hash;
+  IdeXmlSchema *schema;
+} Loaded;
+
+/* Schemas loaded in this process, keyed by uri, so that every project using
+ * a schema shares a single graph instead of each workbench parsing its own
+ * copy. Only the graph for the latest contents of each schema is kept, the
+ * previous one is released along with the projects still using it.
+ *
+ * This is not done through IdeIndexRegistry as that only holds weak
+ * references to objects, and IdeXmlSchema is a boxed type. Schemas are
+ * also identified by their contents rather than by the file on disk.
+ */
+G_LOCK_DEFINE_STATIC (loaded);
+static GHashTable *loaded;
+
+static void
+loaded_free (Loaded *entry)
+{
+  g_clear_pointer (&entry->content_hash, g_free);
+  g_clear_pointer (&entry->schema, ide_xml_schema_unref);
+  g_slice_free (Loaded, entry);
+}
+
+static GFile *
+get_cache_file (GFile *file)
+{
+  g_autofree char *uri = g_file_get_uri (file);
+  g_autofree char *name = g_compute_checksum_for_string (G_CHECKSUM_SHA256, uri, -1);
+
+  return g_file_new_build_filename (g_get_user_cache_dir (),
+                                    ide_get_program_name (),
+                                    "xml-schemas",
+                                    name,
+                                    NULL);
+}
+
+static IdeXmlSchema *
+lookup_loaded (const char *uri,
+               const char *content_hash)
+{
+  IdeXmlSchema *ret = NULL;
+  Loaded *entry;
+
+  G_LOCK (loaded);
+  if (loaded != NULL &&
+      (entry = g_hash_table_lookup (loaded, uri)) &&
+      g_str_equal (entry->content_hash, content_hash))
+    ret = ide_xml_schema_ref (entry->schema);
+  G_UNLOCK (loaded);
+
+  return ret;
+}
+
+static void
+insert_loaded (const char   *uri,
+               const char   *content_hash,
+               IdeXmlSchema *schema)
+{
+  Loaded *entry;
+
+  entry = g_slice_new0 (Loaded);
+  entry->content_hash = g_strdup (content_hash);
+  entry->schema = ide_xml_schema_ref (schema);
+
+  G_LOCK (loaded);
+  if (loaded == NULL)
+    loaded = g_hash_table_new_full (g_str_hash,
+                                    g_str_equal,
+                                    g_free,
+                                    (GDestroyNotify)loaded_free);
+  g_hash_table_insert (loaded, g_strdup (uri), entry);
+  G_UNLOCK (loaded);
+}
+
+static GPtrArray *
+decode_defines (GVariant *defines)
+{
+  g_autoptr(GPtrArray) table = NULL;
+  g_autofree Links *links = NULL;
+  g_autofree guint *in_degree = NULL;
+  gsize n_defines;
+
+  g_assert (defines != NULL);
+
+  n_defines = g_variant_n_children (defines);
+  if (n_defines == 0 || n_defines > G_MAXINT32)
+    return NULL;
+
+  table = g_ptr_array_new_full (n_defines, (GDestroyNotify)ide_xml_rng_define_unref);
+  links = g_new0 (Links, n_defines);
+  in_degree = g_new0 (guint, n_defines);
+
+  /* First validate everything so that we never have to unwind a partially
+   * linked graph, the file may be truncated or from a different build.
+   */
+  for (gsize i = 0; i < n_defines; i++)
+    {
+      const char *name = NULL;
+      const char *ns = NULL;
+      gboolean is_external_ref;
+      gboolean is_ref_simplified;
+      guint32 type;
+      gint16 depth;
+      gint32 pos;
+
+      g_variant_get_child (defines, i, "(um&sm&siiiiinibb)",
+                           &type, &name, &ns,
+                           &links[i].index[LINK_PARENT],
+                           &links[i].index[LINK_NEXT],
+                           &links[i].index[LINK_CONTENT],
+                           &links[i].index[LINK_ATTRIBUTES],
+                           &links[i].index[LINK_NAME_CLASS],
+                           &depth, &pos,
+                           &is_external_ref, &is_ref_simplified);
+
+      IdeXmlRngDefine *def;
+
+      if (type > IDE_XML_RNG_DEFINE_EXCEPT)
+        return NULL;
+
+      for (guint j = 0; j < N_LINKS; j++)
+        {
+          if (links[i].index[j] < -1 || links[i].index[j] >= (gint32)n_defines)
+            return NULL;
+
+          if (j != LINK_PARENT && links[i].index[j] >= 0)
+            in_degree[links[i].index[j]]++;
+        }
+
+      def = ide_xml_rng_define_new (NULL, NULL, (const guchar *)name, type);
+      def->ns = ns ? xmlStrdup ((const xmlChar *)ns) : NULL;
+      def->depth = depth;
+      def->pos = pos;
+      def->is_external_ref = !!is_external_ref;
+      def->is_ref_simplified = !!is_ref_simplified;
+
+      g_ptr_array_add (table, def);
+    }
+
+  /* Everything but the start was written because something pointed at it */
+  for (gsize i = 1; i < n_defines; i++)
+    {
+      if (in_degree[i] == 0)
+        return NULL;
+    }
+
+  /* The parser mixes owning and borrowed links, which we can't tell apart
+   * anymore, and the graph may contain cycles. So every link is borrowed
+   * and the table owns the defines, see ide_xml_schema_set_defines().
+   */
+  for (gsize i = 0; i < n_defines; i++)
+    {
+      IdeXmlRngDefine *def = g_ptr_array_index (table, i);
+
+#define LINK(field, idx) \
+      def->field = links[i].index[idx] >= 0 ? g_ptr_array_index (table, links[i].index[idx]) : NULL
+      LINK (parent, LINK_PARENT);
+      LINK (next, LINK_NEXT);
+      LINK (content, LINK_CONTENT);
+      LINK (attributes, LINK_ATTRIBUTES);
+      LINK (name_class, LINK_NAME_CLASS);
+#undef LINK
+    }
+
+  return g_steal_pointer (&table);
+}
+
+static void
+add_define (GHashTable      *indexes,
+            GPtrArray       *ordered,
+            IdeXmlRngDefine *def)
+{
+  if (def != NULL && !g_hash_table_contains (indexes, def))
+    {
+      g_hash_table_insert (indexes, def, GUINT_TO_POINTER (ordered->len));
+      g_ptr_array_add (ordered, def);
+    }
+}
+
+static gint32
+get_index (GHashTable      *indexes,
+           IdeXmlRngDefine *def)
+{
+  gpointer value;
+
+  if (def != NULL && g_hash_table_lookup_extended (indexes, def, NULL, &value))
+    return GPOINTER_TO_UINT (value);
+
+  return -1;
+}
+
+static GVariant *
+encode_defines (IdeXmlRngDefine *start)
+{
+  g_autoptr(GHashTable) indexes = g_hash_table_new (NULL, NULL);
+  g_autoptr(GPtrArray) ordered = g_ptr_array_new ();
+  GVariantBuilder builder;
+
+  g_assert (start != NULL);
+
+  /* Walk breadth-first rather than recursing, chains of next can be
+   * thousands of defines long with large schemas.
+   */
+  add_define (indexes, ordered, start);
+  for (guint i = 0; i < ordered->len; i++)
+    {
+      IdeXmlRngDefine *def = g_ptr_array_index (ordered, i);
+
+      add_define (indexes, ordered, def->next);
+      add_define (indexes, ordered, def->content);
+      add_define (indexes, ordered, def->attributes);
+      add_define (indexes, ordered, def->name_class);
+    }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (DEFINES_TYPE));
+
+  for (guint i = 0; i < ordered->len; i++)
+    {
+      IdeXmlRngDefine *def = g_ptr_array_index (ordered, i);
+
+      g_variant_builder_add (&builder, DEFINE_TYPE,
+                             (guint32)def->type,
+                             (const char *)def->name,
+                             (const char *)def->ns,
+                             get_index (indexes, def->parent),
+                             get_index (indexes, def->next),
+                             get_index (indexes, def->content),
+                             get_index (indexes, def->attributes),
+                             get_index (indexes, def->name_class),
+                             def->depth,
+                             (gint32)def->pos,
+                             (gboolean)def->is_external_ref,
+                             (gboolean)def->is_ref_simplified);
+    }
+
+  return g_variant_builder_end (&builder);
+}
+
+static GBytes *
+serialize (const char   *uri,
+           const char   *content_hash,
+           IdeXmlSchema *schema)
+{
+  g_autoptr(GVariant) variant = NULL;
+
+  g_assert (uri != NULL);
+  g_assert (content_hash != NULL);
+  g_assert (schema != NULL);
+
+  if (schema->top_grammar == NULL || schema->top_grammar->start_defines == NULL)
+    return NULL;
+
+  variant = g_variant_ref_sink (g_variant_new ("(uss@" DEFINES_TYPE ")",
+                                               CACHE_VERSION,
+                                               uri,
+                                               content_hash,
+                                               encode_defines (schema->top_grammar->start_defines)));
+
+  return g_variant_get_data_as_bytes (variant);
+}
+
+static IdeXmlSchema *
+deserialize (const char *uri,
+             const char *content_hash,
+             GBytes     *bytes)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) defines = NULL;
+  g_autoptr(GPtrArray) table = NULL;
+  IdeXmlRngGrammar *grammar;
+  IdeXmlSchema *schema;
+  const char *cached_uri = NULL;
+  const char *cached_hash = NULL;
+  guint32 version = 0;
+
+  g_assert (uri != NULL);
+  g_assert (content_hash != NULL);
+  g_assert (bytes != NULL);
+
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE));
+  g_variant_get (variant, "(u&s&s@" DEFINES_TYPE ")",
+                 &version, &cached_uri, &cached_hash, &defines);
+
+  if (version != CACHE_VERSION ||
+      g_strcmp0 (cached_uri, uri) != 0 ||
+      g_strcmp0 (cached_hash, content_hash) != 0 ||
+      !(table = decode_defines (defines)))
+    return NULL;
+
+  grammar = ide_xml_rng_grammar_new ();
+  grammar->start_defines = ide_xml_rng_define_ref (g_ptr_array_index (table, 0));
+
+  schema = ide_xml_schema_new ();
+  schema->top_grammar = grammar;
+  ide_xml_schema_set_defines (schema, g_steal_pointer (&table));
+
+  return schema;
+}
+
+static IdeXmlSchema *
+load_from_disk (GFile      *file,
+                const char *uri,
+                const char *content_hash)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GFile) cache_file = NULL;
+
+  g_assert (G_IS_FILE (file));
+  g_assert (uri != NULL);
+  g_assert (content_hash != NULL);
+
+  cache_file = get_cache_file (file);
+
+  if (!(mapped = g_mapped_file_new (g_file_peek_path (cache_file), FALSE, NULL)))
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+
+  return deserialize (uri, content_hash, bytes);
+}
+
+static void
+ide_xml_rng_cache_store_cb (GObject      *object,
+                            GAsyncResult *result,
+                            gpointer      user_data)
+{
+  GFile *cache_file = (GFile *)object;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (G_IS_FILE (cache_file));
+  g_assert (G_IS_ASYNC_RESULT (result));
+
+  if (!g_file_replace_contents_finish (cache_file, result, NULL, &error))
+    g_debug ("Failed to store compiled schema: %s", error->message);
+}
+
+/**
+ * ide_xml_rng_cache_lookup:
+ * @file: the #GFile of the schema
+ * @content: the current contents of @file
+ *
+ * Looks for a compiled version of the schema at @file, first within this
+ * process and then in the user's cache directory. Compiled schemas are
+ * only used if they were created from @content.
+ *
+ * Returns: (transfer full) (nullable): an #IdeXmlSchema or %NULL
+ */
+IdeXmlSchema *
+ide_xml_rng_cache_lookup (GFile  *file,
+                          GBytes *content)
+{
+  g_autofree char *content_hash = NULL;
+  g_autofree char *uri = NULL;
+  IdeXmlSchema *schema;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (content != NULL, NULL);
+
+  uri = g_file_get_uri (file);
+  content_hash = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, content);
+
+  if ((schema = lookup_loaded (uri, content_hash)))
+    return schema;
+
+  if ((schema = load_from_disk (file, uri, content_hash)))
+    insert_loaded (uri, content_hash, schema);
+
+  return schema;
+}
+
+/**
+ * ide_xml_rng_cache_store:
+ * @file: the #GFile of the schema
+ * @content: the contents @schema was parsed from
+ * @schema: an #IdeXmlSchema
+ *
+ * Shares @schema with other projects in this process, replacing any schema
+ * previously stored for @file, and writes a compiled version of it to the
+ * user's cache directory so that later sessions do not need to parse @file
+ * again.
+ */
+void
+ide_xml_rng_cache_store (GFile        *file,
+                         GBytes       *content,
+                         IdeXmlSchema *schema)
+{
+  g_autoptr(GFile) cache_file = NULL;
+  g_autoptr(GFile) directory = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autofree char *content_hash = NULL;
+  g_autofree char *uri = NULL;
+
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (content != NULL);
+  g_return_if_fail (schema != NULL);
+
+  uri = g_file_get_uri (file);
+  content_hash = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, content);
+
+  insert_loaded (uri, content_hash, schema);
+
+  if (!(bytes = serialize (uri, content_hash, schema)))
+    return;
+
+  cache_file = get_cache_file (file);
+  directory = g_file_get_parent (cache_file);
+  g_file_make_directory_with_parents (directory, NULL, NULL);
+
+  g_file_replace_contents_bytes_async (cache_file,
+                                       bytes,
+                                       NULL,
+                                       FALSE,
+                                       G_FILE_CREATE_REPLACE_DESTINATION,
+                                       NULL,
+                                       ide_xml_rng_cache_store_cb,
+                                       NULL);
+}
+
+/**
+ * ide_xml_rng_cache_serialize:
+ * @file: the #GFile of the schema
+ * @content: the contents @schema was parsed from
+ * @schema: an #IdeXmlSchema
+ *
+ * Compiles @schema into the format stored in the user's cache directory.
+ *
+ * Returns: (transfer full) (nullable): a #GBytes or %NULL if @schema
+ *   has no start defines
+ */
+GBytes *
+ide_xml_rng_cache_serialize (GFile        *file,
+                             GBytes       *content,
+                             IdeXmlSchema *schema)
+{
+  g_autofree char *content_hash = NULL;
+  g_autofree char *uri = NULL;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (content != NULL, NULL);
+  g_return_val_if_fail (schema != NULL, NULL);
+
+  uri = g_file_get_uri (file);
+  content_hash = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, content);
+
+  return serialize (uri, content_hash, schema);
+}
+
+/**
+ * ide_xml_rng_cache_deserialize:
+ * @file: the #GFile of the schema
+ * @content: the current contents of @file
+ * @bytes: data created with ide_xml_rng_cache_serialize()
+ *
+ * Loads a schema compiled with ide_xml_rng_cache_serialize(). This fails
+ * if @bytes was created for another file, other contents or is invalid.
+ *
+ * Returns: (transfer full) (nullable): an #IdeXmlSchema or %NULL
+ */
+IdeXmlSchema *
+ide_xml_rng_cache_deserialize (GFile  *file,
+                               GBytes *content,
+                               GBytes *bytes)
+{
+  g_autofree char *content_hash = NULL;
+  g_autofree char *uri = NULL;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (content != NULL, NULL);
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  uri = g_file_get_uri (file);
+  content_hash = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, content);
+
+  return deserialize (uri, content_hash, bytes);
+}
@@ -0,0 +1,41 @@
+/* ide-xml-rng-cache.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "ide-xml-schema.h"
+
+G_BEGIN_DECLS
+
+IdeXmlSchema *ide_xml_rng_cache_lookup      (GFile        *file,
+                                             GBytes       *content);
+void          ide_xml_rng_cache_store       (GFile        *file,
+                                             GBytes       *content,
+                                             IdeXmlSchema *schema);
+GBytes       *ide_xml_rng_cache_serialize   (GFile        *file,
+                                             GBytes       *content,
+                                             IdeXmlSchema *schema);
+IdeXmlSchema *ide_xml_rng_cache_deserialize (GFile        *file,
+                                             GBytes       *content,
+                                             GBytes       *bytes);
+
+G_END_DECLS
@@ -55,6 +55,25 @@ ide_xml_schema_free (IdeXmlSchema *self)
   if (self->top_grammar != NULL)
     ide_xml_rng_grammar_unref (self->top_grammar);
 
+  /* Links between these defines are borrowed, so clear them all before
+   * releasing the defines or they would be released again through them.
+   */
+  if (self->defines != NULL)
+    {
+      for (guint i = 0; i < self->defines->len; i++)
+        {
+          IdeXmlRngDefine *def = g_ptr_array_index (self->defines, i);
+
+          def->parent = NULL;
+          def->next = NULL;
+          def->content = NULL;
+          def->attributes = NULL;
+          def->name_class = NULL;
+        }
+
+      g_ptr_array_unref (self->defines);
+    }
+
   g_slice_free (IdeXmlSchema, self);
 }
 
@@ -78,3 +97,22 @@ ide_xml_schema_unref (IdeXmlSchema *self)
   if (g_atomic_int_dec_and_test (&self->ref_count))
     ide_xml_schema_free (self);
 }
+
+/**
+ * ide_xml_schema_set_defines:
+ * @self: a #IdeXmlSchema
+ * @defines: (transfer full): a #GPtrArray of #IdeXmlRngDefine
+ *
+ * Gives @self every define of its grammar when the links between them
+ * do not hold references, such as for graphs loaded from the cache which
+ * may contain cycles. They are released along with @self.
+ */
+void
+ide_xml_schema_set_defines (IdeXmlSchema *self,
+                            GPtrArray    *defines)
+{
+  g_return_if_fail (self);
+  g_return_if_fail (self->defines == NULL);
+
+  self->defines = defines;
+}
@@ -36,13 +36,16 @@ struct _IdeXmlSchema
   guint             ref_count;
 
   IdeXmlRngGrammar *top_grammar;
+  GPtrArray        *defines;
 };
 
-GType         ide_xml_schema_get_type (void);
-IdeXmlSchema *ide_xml_schema_new      (void);
-IdeXmlSchema *ide_xml_schema_copy     (IdeXmlSchema *self);
-IdeXmlSchema *ide_xml_schema_ref      (IdeXmlSchema *self);
-void          ide_xml_schema_unref    (IdeXmlSchema *self);
+GType         ide_xml_schema_get_type    (void);
+IdeXmlSchema *ide_xml_schema_new         (void);
+IdeXmlSchema *ide_xml_schema_copy        (IdeXmlSchema *self);
+IdeXmlSchema *ide_xml_schema_ref         (IdeXmlSchema *self);
+void          ide_xml_schema_unref       (IdeXmlSchema *self);
+void          ide_xml_schema_set_defines (IdeXmlSchema *self,
+                                          GPtrArray    *defines);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (IdeXmlSchema, ide_xml_schema_unref)
 
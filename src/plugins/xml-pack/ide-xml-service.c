@@ -25,6 +25,7 @@
 #include <math.h>
 
 #include "ide-xml-analysis.h"
+#include "ide-xml-rng-cache.h"
 #include "ide-xml-rng-parser.h"
 #include "ide-xml-schema-cache-entry.h"
 #include "ide-xml-tree-builder.h"
@@ -92,8 +93,12 @@ ide_xml_service_build_tree_cb (IdeTaskCache  *cache,
       return;
     }
 
+  /* The previous analysis stays in the cache until replaced, so the tree
+   * builder may reparse only what changed since then.
+   */
   ide_xml_tree_builder_build_tree_async (self->tree_builder,
                                          file,
+                                         ide_task_cache_peek (self->analyses, file),
                                          g_task_get_cancellable (task),
                                          ide_xml_service_build_tree_cb2,
                                          g_object_ref (task));
@@ -143,8 +148,17 @@ ide_xml_service_load_schema_cb3 (GObject      *object,
       cache_entry->content = g_bytes_new_take (content, len);
       if (kind == SCHEMA_KIND_RNG)
         {
-          rng_parser = ide_xml_rng_parser_new ();
-          if (NULL != (schema = ide_xml_rng_parser_parse (rng_parser, content, len, file)))
+          /* Schemas rarely change, so prefer a compiled version from
+           * another project or a previous session over parsing again.
+           */
+          if (NULL == (schema = ide_xml_rng_cache_lookup (file, cache_entry->content)))
+            {
+              rng_parser = ide_xml_rng_parser_new ();
+              if (NULL != (schema = ide_xml_rng_parser_parse (rng_parser, content, len, file)))
+                ide_xml_rng_cache_store (file, cache_entry->content, schema);
+            }
+
+          if (schema != NULL)
             {
               cache_entry->schema = schema;
               cache_entry->state = SCHEMA_STATE_PARSED;
@@ -777,3 +777,157 @@ ide_xml_symbol_node_get_namespace (IdeXmlSymbolNode  *self)
 
   return self->ns;
 }
+
+typedef struct
+{
+  IdeXmlSymbolNode *target;
+  IdeXmlSymbolNode *replacement;
+  gint              line;
+  gint              line_offset;
+  gint              new_line;
+  gint              new_line_offset;
+} Splice;
+
+static inline void
+splice_move (const Splice *splice,
+             gint         *line,
+             gint         *line_offset)
+{
+  if (*line < splice->line ||
+      (*line == splice->line && *line_offset < splice->line_offset))
+    return;
+
+  if (*line == splice->line)
+    *line_offset += splice->new_line_offset - splice->line_offset;
+
+  *line += splice->new_line - splice->line;
+}
+
+static void
+splice_move_range (const Splice *splice,
+                   NodeRange    *range)
+{
+  splice_move (splice, &range->start_line, &range->start_line_offset);
+  splice_move (splice, &range->end_line, &range->end_line_offset);
+}
+
+static IdeXmlSymbolNode *
+splice_copy (IdeXmlSymbolNode *self,
+             const Splice     *splice)
+{
+  IdeXmlSymbolNode *copy;
+  g_autofree gchar *display_name = NULL;
+
+  g_assert (IDE_IS_XML_SYMBOL_NODE (self));
+  g_assert (splice != NULL);
+
+  g_object_get (self, "display-name", &display_name, NULL);
+
+  copy = g_object_new (IDE_TYPE_XML_SYMBOL_NODE,
+                       "name", ide_symbol_node_get_name (IDE_SYMBOL_NODE (self)),
+                       "display-name", display_name,
+                       "kind", ide_symbol_node_get_kind (IDE_SYMBOL_NODE (self)),
+                       "flags", ide_symbol_node_get_flags (IDE_SYMBOL_NODE (self)),
+                       "use-markup", ide_symbol_node_get_use_markup (IDE_SYMBOL_NODE (self)),
+                       NULL);
+
+  copy->element_name = g_strdup (self->element_name);
+  copy->value = g_strdup (self->value);
+  copy->ns = g_strdup (self->ns);
+  copy->file = self->file ? g_object_ref (self->file) : NULL;
+  copy->state = self->state;
+  copy->start_tag = self->start_tag;
+  copy->end_tag = self->end_tag;
+  copy->has_end_tag = self->has_end_tag;
+
+  splice_move_range (splice, &copy->start_tag);
+  if (copy->has_end_tag)
+    splice_move_range (splice, &copy->end_tag);
+
+  if (self->attributes != NULL)
+    {
+      copy->attributes = g_array_sized_new (FALSE, FALSE, sizeof (Attribute), self->attributes->len);
+
+      for (guint i = 0; i < self->attributes->len; i++)
+        {
+          const Attribute *attr = &g_array_index (self->attributes, Attribute, i);
+          Attribute dup = { g_strdup (attr->name), g_strdup (attr->value) };
+
+          g_array_append_val (copy->attributes, dup);
+        }
+    }
+
+  if (self->children == NULL)
+    return copy;
+
+  for (guint i = 0; i < self->children->len; i++)
+    {
+      const NodeEntry *entry = &g_array_index (self->children, NodeEntry, i);
+
+      if (entry->node != splice->target)
+        {
+          take_child (copy, splice_copy (entry->node, splice), entry->is_internal);
+        }
+      else if (splice->replacement->children != NULL)
+        {
+          /* The replacement was parsed with new locations already, so it
+           * is re-parented as-is instead of being copied.
+           */
+          for (guint j = 0; j < splice->replacement->children->len; j++)
+            {
+              const NodeEntry *r = &g_array_index (splice->replacement->children, NodeEntry, j);
+
+              take_child (copy, g_object_ref (r->node), r->is_internal);
+            }
+        }
+    }
+
+  for (guint i = 0; i < copy->children->len; i++)
+    {
+      if (g_array_index (copy->children, NodeEntry, i).is_internal)
+        copy->nb_internal_children++;
+      else
+        copy->nb_children++;
+    }
+
+  return copy;
+}
+
+/**
+ * ide_xml_symbol_node_splice:
+ * @self: the root #IdeXmlSymbolNode of a tree
+ * @target: a descendant of @self to replace
+ * @replacement: a node whose direct children take the place of @target
+ * @line: the line of the end of the edit, before the edit
+ * @line_offset: the line offset of the end of the edit, before the edit
+ * @new_line: the line of the end of the edit, after the edit
+ * @new_line_offset: the line offset of the end of the edit, after the edit
+ *
+ * Creates a copy of the tree rooted at @self where @target has been
+ * replaced by the children of @replacement. Locations found at or after
+ * (@line, @line_offset) are moved to account for the edit.
+ *
+ * The tree of @self is left untouched so that it may still be used by
+ * anyone holding the previous analysis. The children of @replacement are
+ * shared with the new tree.
+ *
+ * Returns: (transfer full): a new #IdeXmlSymbolNode
+ */
+IdeXmlSymbolNode *
+ide_xml_symbol_node_splice (IdeXmlSymbolNode *self,
+                            IdeXmlSymbolNode *target,
+                            IdeXmlSymbolNode *replacement,
+                            gint              line,
+                            gint              line_offset,
+                            gint              new_line,
+                            gint              new_line_offset)
+{
+  Splice splice = { target, replacement, line, line_offset, new_line, new_line_offset };
+
+  g_return_val_if_fail (IDE_IS_XML_SYMBOL_NODE (self), NULL);
+  g_return_val_if_fail (IDE_IS_XML_SYMBOL_NODE (target), NULL);
+  g_return_val_if_fail (IDE_IS_XML_SYMBOL_NODE (replacement), NULL);
+  g_return_val_if_fail (self != target, NULL);
+
+  return splice_copy (self, &splice);
+}
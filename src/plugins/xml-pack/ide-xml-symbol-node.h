@@ -118,5 +118,12 @@ const gchar                      *ide_xml_symbol_node_get_attribute_value
                                                                                      const gchar            *name);
 void                              ide_xml_symbol_node_set_attributes                (IdeXmlSymbolNode       *self,
                                                                                      const gchar           **attributes);
+IdeXmlSymbolNode                 *ide_xml_symbol_node_splice                        (IdeXmlSymbolNode       *self,
+                                                                                     IdeXmlSymbolNode       *target,
+                                                                                     IdeXmlSymbolNode       *replacement,
+                                                                                     gint                    line,
+                                                                                     gint                    line_offset,
+                                                                                     gint                    new_line,
+                                                                                     gint                    new_line_offset);
 
 G_END_DECLS
@@ -495,6 +495,7 @@ ide_xml_tree_builder_build_tree_cb (GObject      *object,
 void
 ide_xml_tree_builder_build_tree_async (IdeXmlTreeBuilder   *self,
                                        GFile               *file,
+                                       IdeXmlAnalysis      *previous,
                                        GCancellable        *cancellable,
                                        GAsyncReadyCallback  callback,
                                        gpointer             user_data)
@@ -536,6 +537,7 @@ ide_xml_tree_builder_build_tree_async (IdeXmlTreeBuilder   *self,
                                      file,
                                      content,
                                      sequence,
+                                     previous,
                                      cancellable,
                                      ide_xml_tree_builder_build_tree_cb,
                                      g_steal_pointer (&task));
@@ -0,0 +1,254 @@
+/* test-xml-parser.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include "ide-xml-parser.h"
+#include "ide-xml-symbol-node.h"
+
+#define UI_DOCUMENT                                          \
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"             \
+  "<interface>\n"                                            \
+  "  <object class=\"GtkBox\" id=\"box\">\n"                 \
+  "    <child>\n"                                            \
+  "      <object class=\"GtkLabel\" id=\"label\">\n"         \
+  "        <property name=\"label\">Hello</property>\n"      \
+  "      </object>\n"                                        \
+  "    </child>\n"                                           \
+  "    <child>\n"                                            \
+  "      <object class=\"GtkButton\" id=\"button\">\n"       \
+  "        <property name=\"label\">Click</property>\n"      \
+  "      </object>\n"                                        \
+  "    </child>\n"                                           \
+  "  </object>\n"                                            \
+  "</interface>\n"
+
+typedef struct
+{
+  IdeXmlAnalysis *analysis;
+  gboolean        done;
+} Parse;
+
+static void
+parse_cb (GObject      *object,
+          GAsyncResult *result,
+          gpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+  Parse *parse = user_data;
+
+  parse->analysis = ide_xml_parser_get_analysis_finish (IDE_XML_PARSER (object), result, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (parse->analysis);
+  parse->done = TRUE;
+}
+
+static IdeXmlAnalysis *
+parse (const char     *text,
+       gint64          sequence,
+       IdeXmlAnalysis *previous)
+{
+  g_autoptr(IdeXmlParser) parser = ide_xml_parser_new ();
+  g_autoptr(GFile) file = g_file_new_for_path ("/project/window.ui");
+  g_autoptr(GBytes) content = g_bytes_new (text, strlen (text));
+  Parse parse = { NULL, FALSE };
+
+  ide_xml_parser_get_analysis_async (parser, file, content, sequence, previous, NULL, parse_cb, &parse);
+
+  while (!parse.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  return parse.analysis;
+}
+
+static char *
+replace (const char *text,
+         const char *old,
+         const char *new)
+{
+  const char *found = strstr (text, old);
+  GString *str;
+
+  g_assert_nonnull (found);
+
+  str = g_string_new_len (text, found - text);
+  g_string_append (str, new);
+  g_string_append (str, found + strlen (old));
+
+  return g_string_free (str, FALSE);
+}
+
+static void
+assert_nodes_equal (IdeXmlSymbolNode *a,
+                    IdeXmlSymbolNode *b)
+{
+  gint a_line, a_line_offset, a_end_line, a_end_line_offset;
+  gint b_line, b_line_offset, b_end_line, b_end_line_offset;
+  gsize a_size, b_size;
+  guint n_children;
+
+  g_assert_nonnull (a);
+  g_assert_nonnull (b);
+
+  g_assert_cmpstr (ide_xml_symbol_node_get_element_name (a), ==, ide_xml_symbol_node_get_element_name (b));
+  g_assert_cmpstr (ide_symbol_node_get_name (IDE_SYMBOL_NODE (a)), ==, ide_symbol_node_get_name (IDE_SYMBOL_NODE (b)));
+  g_assert_cmpint (ide_symbol_node_get_kind (IDE_SYMBOL_NODE (a)), ==, ide_symbol_node_get_kind (IDE_SYMBOL_NODE (b)));
+  g_assert_cmpstr (ide_xml_symbol_node_get_value (a), ==, ide_xml_symbol_node_get_value (b));
+  g_assert_cmpint (ide_xml_symbol_node_get_state (a), ==, ide_xml_symbol_node_get_state (b));
+
+  ide_xml_symbol_node_get_location (a, &a_line, &a_line_offset, &a_end_line, &a_end_line_offset, &a_size);
+  ide_xml_symbol_node_get_location (b, &b_line, &b_line_offset, &b_end_line, &b_end_line_offset, &b_size);
+  g_assert_cmpint (a_line, ==, b_line);
+  g_assert_cmpint (a_line_offset, ==, b_line_offset);
+  g_assert_cmpint (a_end_line, ==, b_end_line);
+  g_assert_cmpint (a_end_line_offset, ==, b_end_line_offset);
+  g_assert_cmpuint (a_size, ==, b_size);
+
+  g_assert_cmpint (ide_xml_symbol_node_has_end_tag (a), ==, ide_xml_symbol_node_has_end_tag (b));
+
+  if (ide_xml_symbol_node_has_end_tag (a))
+    {
+      ide_xml_symbol_node_get_end_tag_location (a, &a_line, &a_line_offset, &a_end_line, &a_end_line_offset, &a_size);
+      ide_xml_symbol_node_get_end_tag_location (b, &b_line, &b_line_offset, &b_end_line, &b_end_line_offset, &b_size);
+      g_assert_cmpint (a_line, ==, b_line);
+      g_assert_cmpint (a_line_offset, ==, b_line_offset);
+      g_assert_cmpint (a_end_line, ==, b_end_line);
+      g_assert_cmpint (a_end_line_offset, ==, b_end_line_offset);
+      g_assert_cmpuint (a_size, ==, b_size);
+    }
+
+  g_assert_cmpint (ide_xml_symbol_node_get_n_internal_children (a), ==, ide_xml_symbol_node_get_n_internal_children (b));
+
+  n_children = ide_xml_symbol_node_get_n_direct_children (a);
+  g_assert_cmpint (n_children, ==, ide_xml_symbol_node_get_n_direct_children (b));
+
+  for (guint i = 0; i < n_children; i++)
+    {
+      g_autoptr(IdeXmlSymbolNode) a_child = NULL;
+      g_autoptr(IdeXmlSymbolNode) b_child = NULL;
+
+      a_child = IDE_XML_SYMBOL_NODE (ide_xml_symbol_node_get_nth_direct_child (a, i));
+      b_child = IDE_XML_SYMBOL_NODE (ide_xml_symbol_node_get_nth_direct_child (b, i));
+
+      assert_nodes_equal (a_child, b_child);
+    }
+}
+
+/*
+ * Parses @before, then @after both incrementally from the analysis of
+ * @before and from scratch, and checks that both trees are the same.
+ * A reparse keeps the schemas of the previous analysis while a full
+ * parse of a .ui file looks them up again, which tells us which path
+ * was taken.
+ */
+static IdeXmlAnalysis *
+check_reparse (const char *before,
+               const char *after,
+               gboolean    expect_reparse)
+{
+  g_autoptr(IdeXmlAnalysis) previous = NULL;
+  g_autoptr(IdeXmlAnalysis) full = NULL;
+  g_autoptr(IdeXmlAnalysis) again = NULL;
+  IdeXmlAnalysis *incremental;
+
+  previous = parse (before, 1, NULL);
+  g_assert_nonnull (ide_xml_analysis_get_content (previous));
+  g_assert_nonnull (ide_xml_analysis_get_schemas (previous));
+
+  incremental = parse (after, 2, previous);
+  full = parse (after, 2, NULL);
+
+  if (expect_reparse)
+    g_assert_true (ide_xml_analysis_get_schemas (incremental) == ide_xml_analysis_get_schemas (previous));
+  else
+    g_assert_true (ide_xml_analysis_get_schemas (incremental) != ide_xml_analysis_get_schemas (previous));
+
+  assert_nodes_equal (ide_xml_analysis_get_root_node (incremental),
+                      ide_xml_analysis_get_root_node (full));
+
+  /* The previous tree must be left untouched by the splice */
+  again = parse (before, 3, NULL);
+  assert_nodes_equal (ide_xml_analysis_get_root_node (previous),
+                      ide_xml_analysis_get_root_node (again));
+
+  return incremental;
+}
+
+static void
+test_reparse_leaf (void)
+{
+  g_autofree char *after = replace (UI_DOCUMENT, "Hello<", "Hello world<");
+  g_autoptr(IdeXmlAnalysis) analysis = NULL;
+
+  analysis = check_reparse (UI_DOCUMENT, after, TRUE);
+}
+
+static void
+test_reparse_tags (void)
+{
+  g_autofree char *after = NULL;
+  g_autoptr(IdeXmlAnalysis) analysis = NULL;
+
+  /* Renaming both tags of the element leaves nothing for the ui parser
+   * to splice in, so the whole document must be parsed again.
+   */
+  after = replace (UI_DOCUMENT,
+                   "<property name=\"label\">Hello</property>",
+                   "<attribute name=\"label\">Hello</attribute>");
+  analysis = check_reparse (UI_DOCUMENT, after, FALSE);
+}
+
+static void
+test_reparse_multiline (void)
+{
+  g_autofree char *after = NULL;
+  g_autoptr(IdeXmlAnalysis) previous = NULL;
+  g_autoptr(IdeXmlAnalysis) analysis = NULL;
+  g_autoptr(IdeXmlSymbolNode) before_box = NULL;
+  g_autoptr(IdeXmlSymbolNode) after_box = NULL;
+  gint before_line;
+  gint after_line;
+
+  after = replace (UI_DOCUMENT,
+                   "Hello</property>\n",
+                   "Hello</property>\n"
+                   "        <property name=\"visible\">True</property>\n"
+                   "        <property name=\"xalign\">0</property>\n");
+  analysis = check_reparse (UI_DOCUMENT, after, TRUE);
+
+  /* The end tag of the box follows the edit and moves down two lines */
+  previous = parse (UI_DOCUMENT, 1, NULL);
+  before_box = IDE_XML_SYMBOL_NODE (ide_xml_symbol_node_get_nth_direct_child (ide_xml_analysis_get_root_node (previous), 0));
+  after_box = IDE_XML_SYMBOL_NODE (ide_xml_symbol_node_get_nth_direct_child (ide_xml_analysis_get_root_node (analysis), 0));
+  ide_xml_symbol_node_get_end_tag_location (before_box, &before_line, NULL, NULL, NULL, NULL);
+  ide_xml_symbol_node_get_end_tag_location (after_box, &after_line, NULL, NULL, NULL, NULL);
+  g_assert_cmpint (after_line, ==, before_line + 2);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/XmlPack/Parser/reparse-leaf", test_reparse_leaf);
+  g_test_add_func ("/XmlPack/Parser/reparse-tags", test_reparse_tags);
+  g_test_add_func ("/XmlPack/Parser/reparse-multiline", test_reparse_multiline);
+  return g_test_run ();
+}
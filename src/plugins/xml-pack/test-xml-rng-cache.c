@@ -0,0 +1,188 @@
+/* test-xml-rng-cache.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "ide-xml-rng-cache.h"
+
+static IdeXmlRngDefine *
+add_define (IdeXmlRngDefine     *parent,
+            const char          *name,
+            IdeXmlRngDefineType  type)
+{
+  IdeXmlRngDefine *def = ide_xml_rng_define_new (NULL, parent, (const guchar *)name, type);
+
+  def->depth = parent ? parent->depth + 1 : 0;
+
+  return def;
+}
+
+/*
+ * Builds the equivalent of:
+ *
+ *   <start>
+ *     <element name="interface">
+ *       <attribute name="domain"/>
+ *       <zeroOrMore>
+ *         <ref name="object"/>  (back to the element, like recursive schemas)
+ *       </zeroOrMore>
+ *     </element>
+ *   </start>
+ *
+ * The ref only borrows the element, as the parser does.
+ */
+static IdeXmlSchema *
+create_schema (void)
+{
+  IdeXmlSchema *schema = ide_xml_schema_new ();
+  IdeXmlRngGrammar *grammar = ide_xml_rng_grammar_new ();
+  IdeXmlRngDefine *start = add_define (NULL, NULL, IDE_XML_RNG_DEFINE_START);
+  IdeXmlRngDefine *element = add_define (start, "interface", IDE_XML_RNG_DEFINE_ELEMENT);
+  IdeXmlRngDefine *attribute = add_define (element, "domain", IDE_XML_RNG_DEFINE_ATTRIBUTE);
+  IdeXmlRngDefine *zero_or_more = add_define (element, NULL, IDE_XML_RNG_DEFINE_ZEROORMORE);
+  IdeXmlRngDefine *ref = add_define (zero_or_more, "object", IDE_XML_RNG_DEFINE_REF);
+
+  start->content = element;
+  element->attributes = attribute;
+  element->content = zero_or_more;
+  zero_or_more->content = ref;
+  ref->content = element;
+  ref->is_ref_simplified = TRUE;
+
+  grammar->start_defines = start;
+  schema->top_grammar = grammar;
+
+  return schema;
+}
+
+static void
+free_schema (IdeXmlSchema *schema)
+{
+  IdeXmlRngDefine *ref = schema->top_grammar->start_defines->content->content->content;
+
+  /* Drop the borrowed link before the owning ones are released */
+  ref->content = NULL;
+  ide_xml_schema_unref (schema);
+}
+
+static void
+assert_define_equal (IdeXmlRngDefine *a,
+                     IdeXmlRngDefine *b)
+{
+  g_assert_nonnull (a);
+  g_assert_nonnull (b);
+  g_assert_cmpint (a->type, ==, b->type);
+  g_assert_cmpstr ((const char *)a->name, ==, (const char *)b->name);
+  g_assert_cmpstr ((const char *)a->ns, ==, (const char *)b->ns);
+  g_assert_cmpint (a->depth, ==, b->depth);
+  g_assert_cmpint (a->is_ref_simplified, ==, b->is_ref_simplified);
+}
+
+static void
+test_rng_cache_round_trip (void)
+{
+  g_autoptr(GFile) file = g_file_new_for_path ("/schemas/gtkbuilder.rng");
+  g_autoptr(GFile) other_file = g_file_new_for_path ("/schemas/other.rng");
+  g_autoptr(GBytes) content = g_bytes_new_static ("<grammar/>", 10);
+  g_autoptr(GBytes) other_content = g_bytes_new_static ("<grammar />", 11);
+  g_autoptr(GBytes) garbage = g_bytes_new_static ("garbage", 7);
+  g_autoptr(GBytes) bytes = NULL;
+  IdeXmlSchema *schema = create_schema ();
+  IdeXmlSchema *loaded;
+  IdeXmlRngDefine *a;
+  IdeXmlRngDefine *b;
+
+  bytes = ide_xml_rng_cache_serialize (file, content, schema);
+  g_assert_nonnull (bytes);
+
+  loaded = ide_xml_rng_cache_deserialize (file, content, bytes);
+  g_assert_nonnull (loaded);
+  g_assert_nonnull (loaded->top_grammar);
+
+  /* start -> element */
+  a = schema->top_grammar->start_defines;
+  b = loaded->top_grammar->start_defines;
+  assert_define_equal (a, b);
+  assert_define_equal (a->content, b->content);
+  g_assert_true (b->content->parent == b);
+
+  /* element -> attribute, zeroOrMore -> ref */
+  a = a->content;
+  b = b->content;
+  assert_define_equal (a->attributes, b->attributes);
+  assert_define_equal (a->content, b->content);
+  assert_define_equal (a->content->content, b->content->content);
+  g_assert_null (b->next);
+
+  /* The ref links back to the same element, not a copy of it */
+  g_assert_true (b->content->content->content == b);
+
+  /* Releasing a cyclic graph must not touch freed defines */
+  ide_xml_schema_unref (loaded);
+
+  /* Compiled schemas are only used for the file and contents they are from */
+  g_assert_null (ide_xml_rng_cache_deserialize (other_file, content, bytes));
+  g_assert_null (ide_xml_rng_cache_deserialize (file, other_content, bytes));
+  g_assert_null (ide_xml_rng_cache_deserialize (file, content, garbage));
+
+  free_schema (schema);
+}
+
+static void
+test_rng_cache_replace (void)
+{
+  g_autoptr(GFile) file = g_file_new_for_path ("/schemas/project.rng");
+  g_autoptr(GBytes) content1 = g_bytes_new_static ("<grammar/>", 10);
+  g_autoptr(GBytes) content2 = g_bytes_new_static ("<grammar />", 11);
+  IdeXmlSchema *schema1 = create_schema ();
+  IdeXmlSchema *schema2 = create_schema ();
+  IdeXmlSchema *found;
+
+  ide_xml_rng_cache_store (file, content1, schema1);
+  g_assert_cmpint (schema1->ref_count, ==, 2);
+
+  found = ide_xml_rng_cache_lookup (file, content1);
+  g_assert_true (found == schema1);
+  ide_xml_schema_unref (found);
+
+  /* Saving the schema again must release the graph for the old contents */
+  ide_xml_rng_cache_store (file, content2, schema2);
+  g_assert_cmpint (schema1->ref_count, ==, 1);
+  g_assert_cmpint (schema2->ref_count, ==, 2);
+
+  found = ide_xml_rng_cache_lookup (file, content2);
+  g_assert_true (found == schema2);
+  ide_xml_schema_unref (found);
+
+  free_schema (schema1);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autofree char *cache_dir = g_dir_make_tmp ("test-xml-rng-cache-XXXXXX", NULL);
+
+  /* Keep compiled schemas out of the user's cache */
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/XmlPack/RngCache/round-trip", test_rng_cache_round_trip);
+  g_test_add_func ("/XmlPack/RngCache/replace", test_rng_cache_replace);
+  return g_test_run ();
+}
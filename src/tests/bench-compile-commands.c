@@ -0,0 +1,142 @@
+/* bench-compile-commands.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-foundry.h>
+
+#include "bench-util.h"
+
+#define N_SYNTHETIC_FILES 5000
+
+typedef struct
+{
+  GFile              *file;
+  IdeCompileCommands *commands;
+  GPtrArray          *lookups;
+} Corpus;
+
+static void
+load (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdeCompileCommands) commands = ide_compile_commands_new ();
+  g_autoptr(GError) error = NULL;
+
+  ide_compile_commands_load (commands, corpus->file, NULL, &error);
+  g_assert_no_error (error);
+}
+
+static void
+lookup (gpointer data)
+{
+  Corpus *corpus = data;
+
+  for (guint i = 0; i < corpus->lookups->len; i++)
+    {
+      g_auto(GStrv) argv = NULL;
+
+      argv = ide_compile_commands_lookup (corpus->commands,
+                                          g_ptr_array_index (corpus->lookups, i),
+                                          NULL, NULL, NULL);
+      g_assert (argv != NULL);
+    }
+}
+
+static void
+bench_corpus (const char *name,
+              Corpus     *corpus)
+{
+  g_autoptr(GError) error = NULL;
+
+  bench_run ("compile-commands-load", name, 1, load, corpus);
+
+  corpus->commands = ide_compile_commands_new ();
+  ide_compile_commands_load (corpus->commands, corpus->file, NULL, &error);
+  g_assert_no_error (error);
+
+  bench_run ("compile-commands-lookup", name, corpus->lookups->len, lookup, corpus);
+
+  g_clear_object (&corpus->commands);
+}
+
+static GFile *
+write_synthetic (GPtrArray *lookups)
+{
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GString) str = g_string_new ("[\n");
+  g_autoptr(GError) error = NULL;
+  GFile *file;
+
+  for (guint i = 0; i < N_SYNTHETIC_FILES; i++)
+    {
+      g_autofree char *path = g_strdup_printf ("/build/project/src/dir-%u/file-%u.c", i % 50, i);
+
+      g_string_append_printf (str,
+                              "%s  {\n"
+                              "    \"directory\": \"/build/project/_build\",\n"
+                              "    \"command\": \"cc -Isrc/dir-%u -I../src/dir-%u -I/usr/include/glib-2.0 "
+                              "-I/usr/lib64/glib-2.0/include -DG_LOG_DOMAIN=\\\"dir-%u\\\" -O2 -g "
+                              "-o src/dir-%u/file-%u.c.o -c %s\",\n"
+                              "    \"file\": \"%s\"\n"
+                              "  }",
+                              i ? ",\n" : "",
+                              i % 50, i % 50, i % 50, i % 50, i, path, path);
+
+      if (i % 10 == 0)
+        g_ptr_array_add (lookups, g_file_new_for_path (path));
+    }
+
+  g_string_append (str, "\n]\n");
+
+  file = g_file_new_tmp ("bench-compile-commands-XXXXXX.json", &stream, &error);
+  g_assert_no_error (error);
+
+  g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (stream)),
+                             str->str, str->len, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  g_io_stream_close (G_IO_STREAM (stream), NULL, &error);
+  g_assert_no_error (error);
+
+  return file;
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GPtrArray) synthetic_lookups = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr(GPtrArray) recorded_lookups = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr(GFile) synthetic = write_synthetic (synthetic_lookups);
+  g_autoptr(GFile) recorded = g_file_new_build_filename (TEST_DATA_DIR, "test-compile-commands.json", NULL);
+  Corpus synthetic_corpus = { synthetic, NULL, synthetic_lookups };
+  Corpus recorded_corpus = { recorded, NULL, recorded_lookups };
+
+  g_ptr_array_add (recorded_lookups, g_file_new_for_path ("/build/gnome-builder/subprojects/libgd/libgd/gd-types-catalog.c"));
+  g_ptr_array_add (recorded_lookups, g_file_new_for_path ("whatever.vala"));
+
+  bench_begin ("compile-commands");
+  bench_corpus ("synthetic", &synthetic_corpus);
+  bench_corpus ("recorded", &recorded_corpus);
+  bench_end ();
+
+  g_file_delete (synthetic, NULL, NULL);
+
+  return EXIT_SUCCESS;
+}
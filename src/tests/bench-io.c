@@ -0,0 +1,61 @@
+/* bench-io.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-io.h>
+
+#include "bench-util.h"
+
+static guint
+count_lines (GBytes *bytes)
+{
+  IdeLineReader reader;
+  gsize len;
+  guint n_lines = 0;
+
+  ide_line_reader_init (&reader,
+                        (char *)g_bytes_get_data (bytes, NULL),
+                        g_bytes_get_size (bytes));
+  while (ide_line_reader_next (&reader, &len))
+    n_lines++;
+
+  return n_lines;
+}
+
+static void
+line_reader (gpointer data)
+{
+  count_lines (data);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GBytes) synthetic = bench_synthetic_build_log (200000);
+  g_autoptr(GBytes) recorded = bench_recorded_sources ();
+
+  bench_begin ("io");
+  bench_run ("line-reader", "synthetic", count_lines (synthetic), line_reader, synthetic);
+  if (g_bytes_get_size (recorded) > 0)
+    bench_run ("line-reader", "recorded", count_lines (recorded), line_reader, recorded);
+  bench_end ();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/* bench-pipeline.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-foundry.h>
+
+#include "ide-pipeline-private.h"
+
+#include "bench-util.h"
+
+/* Same as the error format registered by the gcc plugin */
+#define GCC_ERROR_FORMAT                    \
+  "(?<filename>[a-zA-Z0-9\\+\\-\\.\\/_]+):" \
+  "(?<line>\\d+):"                          \
+  "(?<column>\\d+): "                       \
+  "(?<level>[\\w\\s]+): "                   \
+  "(?<message>.*)"
+
+#define BENCH_TYPE_CONFIG (bench_config_get_type())
+G_DECLARE_FINAL_TYPE (BenchConfig, bench_config, BENCH, CONFIG, IdeConfig)
+
+struct _BenchConfig
+{
+  IdeConfig parent_instance;
+};
+
+G_DEFINE_FINAL_TYPE (BenchConfig, bench_config, IDE_TYPE_CONFIG)
+
+static void
+bench_config_class_init (BenchConfigClass *klass)
+{
+}
+
+static void
+bench_config_init (BenchConfig *self)
+{
+}
+
+typedef struct
+{
+  IdePipeline *pipeline;
+  GBytes      *bytes;
+  guint        n_diagnostics;
+} Corpus;
+
+static void
+diagnostic_cb (IdePipeline   *pipeline,
+               IdeDiagnostic *diagnostic,
+               Corpus        *corpus)
+{
+  corpus->n_diagnostics++;
+}
+
+static void
+extract_diagnostics (gpointer data)
+{
+  Corpus *corpus = data;
+
+  _ide_pipeline_extract_diagnostics (corpus->pipeline,
+                                     g_bytes_get_data (corpus->bytes, NULL),
+                                     g_bytes_get_size (corpus->bytes));
+}
+
+static guint
+count_lines (GBytes *bytes)
+{
+  IdeLineReader reader;
+  gsize len;
+  guint n_lines = 0;
+
+  ide_line_reader_init (&reader,
+                        (char *)g_bytes_get_data (bytes, NULL),
+                        g_bytes_get_size (bytes));
+  while (ide_line_reader_next (&reader, &len))
+    n_lines++;
+
+  return n_lines;
+}
+
+/* Relative paths in the log resolve against the directory make or ninja
+ * says it entered, as they would in a real build.
+ */
+static GBytes *
+with_directory (GBytes *bytes)
+{
+  GString *str = g_string_new ("make: Entering directory '/bench/build'\n");
+
+  g_string_append_len (str, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+
+  return g_string_free_to_bytes (str);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(IdeContext) context = ide_context_new ();
+  g_autoptr(IdeConfig) config = g_object_new (BENCH_TYPE_CONFIG, "id", "bench", NULL);
+  g_autoptr(IdePipeline) pipeline = NULL;
+  g_autoptr(GBytes) synthetic_log = bench_synthetic_build_log (200000);
+  g_autoptr(GBytes) recorded_sources = bench_recorded_sources ();
+  g_autoptr(GBytes) synthetic = with_directory (synthetic_log);
+  g_autoptr(GBytes) recorded = with_directory (recorded_sources);
+  Corpus corpora[2];
+
+  pipeline = g_object_new (IDE_TYPE_PIPELINE,
+                           "config", config,
+                           NULL);
+  ide_object_append (IDE_OBJECT (context), IDE_OBJECT (pipeline));
+  ide_pipeline_add_error_format (pipeline, GCC_ERROR_FORMAT, G_REGEX_CASELESS);
+
+  corpora[0] = (Corpus) { pipeline, synthetic };
+  corpora[1] = (Corpus) { pipeline, recorded };
+
+  g_signal_connect (pipeline, "diagnostic", G_CALLBACK (diagnostic_cb), &corpora[0]);
+
+  bench_begin ("pipeline");
+
+  /* Roughly a quarter of the synthetic lines are diagnostics while the
+   * recorded sources exercise the much more common case of no match.
+   */
+  bench_run ("extract-diagnostics", "synthetic", count_lines (synthetic), extract_diagnostics, &corpora[0]);
+  g_assert_cmpint (corpora[0].n_diagnostics, >, 0);
+
+  bench_run ("extract-diagnostics", "recorded", count_lines (recorded), extract_diagnostics, &corpora[1]);
+
+  bench_end ();
+
+  ide_object_destroy (IDE_OBJECT (context));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,275 @@
+/* bench-search.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-io.h>
+#include <libide-search.h>
+
+#include "bench-util.h"
+
+static const char *queries[] = {
+  "buf", "ide_buf_get", "pipln", "gcmc", "fuzzy_index_query", "lsp_cl", "xyz",
+};
+
+typedef struct
+{
+  const char *corpus;
+  GPtrArray  *identifiers;
+  GFile      *fuzzy_file;
+  GFile      *map_file;
+} Corpus;
+
+static void
+mutable_insert (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdeFuzzyMutableIndex) index = ide_fuzzy_mutable_index_new (FALSE);
+
+  ide_fuzzy_mutable_index_begin_bulk_insert (index);
+  for (guint i = 0; i < corpus->identifiers->len; i++)
+    ide_fuzzy_mutable_index_insert (index,
+                                    g_ptr_array_index (corpus->identifiers, i),
+                                    GUINT_TO_POINTER (i + 1));
+  ide_fuzzy_mutable_index_end_bulk_insert (index);
+}
+
+static void
+mutable_match (gpointer data)
+{
+  IdeFuzzyMutableIndex *index = data;
+
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    {
+      g_autoptr(GArray) matches = ide_fuzzy_mutable_index_match (index, queries[i], 100);
+    }
+}
+
+/* Builds indexes with the same keys and values as GbpCodeIndexBuilder.
+ * The plugin itself is measured by bench-code-index.
+ */
+static void
+fuzzy_index_build (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdeFuzzyIndexBuilder) fuzzy = ide_fuzzy_index_builder_new ();
+  g_autoptr(GError) error = NULL;
+
+  for (guint i = 0; i < corpus->identifiers->len; i++)
+    {
+      const char *name = g_ptr_array_index (corpus->identifiers, i);
+      guint file_id = i % 1000;
+      guint line = i % 5000 + 1;
+
+      ide_fuzzy_index_builder_insert (fuzzy,
+                                      name,
+                                      g_variant_new ("(uuuuu)", file_id, line, 1, 0, 0),
+                                      0);
+    }
+
+  ide_fuzzy_index_builder_write (fuzzy, corpus->fuzzy_file, G_PRIORITY_DEFAULT, NULL, &error);
+  g_assert_no_error (error);
+}
+
+static void
+persistent_map_build (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdePersistentMapBuilder) map = ide_persistent_map_builder_new ();
+  g_autoptr(GError) error = NULL;
+
+  for (guint i = 0; i < corpus->identifiers->len; i++)
+    {
+      const char *name = g_ptr_array_index (corpus->identifiers, i);
+      g_autofree char *key = g_strdup_printf ("c:@F@%s", name);
+      guint file_id = i % 1000;
+      guint line = i % 5000 + 1;
+
+      ide_persistent_map_builder_insert (map,
+                                         key,
+                                         g_variant_new ("(uuuu)", file_id, line, 1, 0),
+                                         TRUE);
+    }
+
+  ide_persistent_map_builder_write (map, corpus->map_file, G_PRIORITY_DEFAULT, NULL, &error);
+  g_assert_no_error (error);
+}
+
+static void
+fuzzy_index_query_cb (GObject      *object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  g_autoptr(GListModel) model = NULL;
+  g_autoptr(GError) error = NULL;
+  gboolean *done = user_data;
+
+  model = ide_fuzzy_index_query_finish (IDE_FUZZY_INDEX (object), result, &error);
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static void
+fuzzy_index_refine_cb (GObject      *object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  GListModel **model = user_data;
+  g_autoptr(GError) error = NULL;
+
+  *model = ide_fuzzy_index_query_finish (IDE_FUZZY_INDEX (object), result, &error);
+  g_assert_no_error (error);
+}
+
+static void
+fuzzy_index_query (gpointer data)
+{
+  IdeFuzzyIndex *index = data;
+
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    {
+      gboolean done = FALSE;
+
+      ide_fuzzy_index_query_async (index, queries[i], 100, NULL, fuzzy_index_query_cb, &done);
+      bench_wait (&done);
+    }
+}
+
+/* Queries each prefix of a query as it would be typed */
+static void
+fuzzy_index_refine (gpointer data)
+{
+  IdeFuzzyIndex *index = data;
+  const char *typed = "ide_fuzzy_index_query";
+  g_autoptr(GListModel) previous = NULL;
+
+  for (guint len = 1; typed[len-1]; len++)
+    {
+      g_autofree char *prefix = g_strndup (typed, len);
+      GListModel *model = NULL;
+
+      ide_fuzzy_index_query_async (index, prefix, 100, NULL, fuzzy_index_refine_cb, &model);
+      while (model == NULL)
+        g_main_context_iteration (NULL, TRUE);
+
+      /* Keep the previous results alive as a search popover would */
+      g_clear_object (&previous);
+      previous = model;
+    }
+}
+
+static void
+persistent_map_lookup (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdePersistentMap) map = ide_persistent_map_new ();
+  g_autoptr(GError) error = NULL;
+
+  ide_persistent_map_load_file (map, corpus->map_file, NULL, &error);
+  g_assert_no_error (error);
+
+  for (guint i = 0; i < corpus->identifiers->len; i++)
+    {
+      g_autofree char *key = g_strdup_printf ("c:@F@%s", (const char *)g_ptr_array_index (corpus->identifiers, i));
+      g_autoptr(GVariant) value = ide_persistent_map_lookup_value (map, key);
+
+      g_assert (value != NULL);
+    }
+}
+
+static void
+persistent_map_lookup_record (gpointer data)
+{
+  Corpus *corpus = data;
+  g_autoptr(IdePersistentMap) map = ide_persistent_map_new ();
+  g_autoptr(GError) error = NULL;
+  char key[256];
+
+  ide_persistent_map_load_file (map, corpus->map_file, NULL, &error);
+  g_assert_no_error (error);
+
+  for (guint i = 0; i < corpus->identifiers->len; i++)
+    {
+      g_snprintf (key, sizeof key, "c:@F@%s", (const char *)g_ptr_array_index (corpus->identifiers, i));
+      g_assert (ide_persistent_map_lookup_record (map, key) != NULL);
+    }
+}
+
+static void
+bench_corpus (Corpus *corpus)
+{
+  g_autoptr(IdeFuzzyMutableIndex) mutable = ide_fuzzy_mutable_index_new (FALSE);
+  g_autoptr(IdeFuzzyIndex) index = ide_fuzzy_index_new ();
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GError) error = NULL;
+  guint n = corpus->identifiers->len;
+
+  corpus->fuzzy_file = g_file_new_tmp ("bench-search-XXXXXX.fuzzy", &stream, &error);
+  g_assert_no_error (error);
+  g_clear_object (&stream);
+
+  corpus->map_file = g_file_new_tmp ("bench-search-XXXXXX.map", &stream, &error);
+  g_assert_no_error (error);
+  g_clear_object (&stream);
+
+  bench_run ("fuzzy-mutable-index-insert", corpus->corpus, n, mutable_insert, corpus);
+
+  ide_fuzzy_mutable_index_begin_bulk_insert (mutable);
+  for (guint i = 0; i < n; i++)
+    ide_fuzzy_mutable_index_insert (mutable, g_ptr_array_index (corpus->identifiers, i), GUINT_TO_POINTER (i + 1));
+  ide_fuzzy_mutable_index_end_bulk_insert (mutable);
+  bench_run ("fuzzy-mutable-index-match", corpus->corpus, G_N_ELEMENTS (queries), mutable_match, mutable);
+
+  bench_run ("fuzzy-index-build", corpus->corpus, n, fuzzy_index_build, corpus);
+  bench_run ("persistent-map-build", corpus->corpus, n, persistent_map_build, corpus);
+
+  ide_fuzzy_index_load_file (index, corpus->fuzzy_file, NULL, &error);
+  g_assert_no_error (error);
+  bench_run ("fuzzy-index-query", corpus->corpus, G_N_ELEMENTS (queries), fuzzy_index_query, index);
+  bench_run ("fuzzy-index-refine", corpus->corpus, strlen ("ide_fuzzy_index_query"), fuzzy_index_refine, index);
+  bench_run ("persistent-map-lookup", corpus->corpus, n, persistent_map_lookup, corpus);
+  bench_run ("persistent-map-lookup-record", corpus->corpus, n, persistent_map_lookup_record, corpus);
+
+  g_file_delete (corpus->fuzzy_file, NULL, NULL);
+  g_file_delete (corpus->map_file, NULL, NULL);
+  g_clear_object (&corpus->fuzzy_file);
+  g_clear_object (&corpus->map_file);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GPtrArray) synthetic = bench_synthetic_identifiers (50000);
+  g_autoptr(GPtrArray) recorded = bench_recorded_identifiers ();
+  Corpus corpora[] = {
+    { "synthetic", synthetic },
+    { "recorded", recorded },
+  };
+
+  bench_begin ("search");
+  for (guint i = 0; i < G_N_ELEMENTS (corpora); i++)
+    {
+      if (corpora[i].identifiers->len > 0)
+        bench_corpus (&corpora[i]);
+    }
+  bench_end ();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,256 @@
+/* bench-util.h
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <string.h>
+
+G_BEGIN_DECLS
+
+/* Helpers shared by the benchmarks run with `meson test --benchmark`.
+ *
+ * Each benchmark executable prints a single JSON document to stdout
+ * so that results may be collected and compared between releases:
+ *
+ *   {"suite":"search","results":[{"name":...,"corpus":...,"ops":...}]}
+ *
+ * Corpora named "synthetic" are generated from a fixed seed so they are
+ * identical from run to run. Corpora named "recorded" come from real code:
+ *
+ *   bench-identifiers.txt  function names taken from Builder's sources,
+ *                          checked into tests/data/
+ *   libide/io/*.c          read from the source tree, for line lengths
+ *
+ * Regenerate the identifiers only when deliberately starting a new series
+ * of results, as numbers before and after are not comparable. The sources
+ * follow the tree, so compare their results within a single checkout.
+ */
+
+#define BENCH_MIN_USEC  (G_USEC_PER_SEC / 5)
+#define BENCH_MIN_RUNS  3
+#define BENCH_SEED      0x1DE
+
+typedef void (*BenchFunc) (gpointer data);
+
+static guint bench_n_results;
+
+static inline void
+bench_begin (const char *suite)
+{
+  g_print ("{\"suite\":\"%s\",\"results\":[", suite);
+}
+
+static inline void
+bench_end (void)
+{
+  g_print ("\n]}\n");
+}
+
+/* Runs @func until at least BENCH_MIN_USEC have elapsed and reports the
+ * best and mean time per operation, where each call performs @n_ops.
+ */
+static inline void
+bench_run (const char *name,
+           const char *corpus,
+           guint       n_ops,
+           BenchFunc   func,
+           gpointer    data)
+{
+  gint64 best = G_MAXINT64;
+  gint64 total = 0;
+  guint runs = 0;
+
+  g_assert (name != NULL);
+  g_assert (corpus != NULL);
+  g_assert (n_ops > 0);
+
+  while (runs < BENCH_MIN_RUNS || total < BENCH_MIN_USEC)
+    {
+      gint64 begin = g_get_monotonic_time ();
+      gint64 elapsed;
+
+      func (data);
+
+      elapsed = g_get_monotonic_time () - begin;
+      best = MIN (best, elapsed);
+      total += elapsed;
+      runs++;
+    }
+
+  g_print ("%s\n  {\"name\":\"%s\",\"corpus\":\"%s\",\"ops\":%u,\"runs\":%u,"
+           "\"best_ns_per_op\":%.1f,\"mean_ns_per_op\":%.1f}",
+           bench_n_results++ ? "," : "",
+           name, corpus, n_ops, runs,
+           best * 1000.0 / n_ops,
+           total * 1000.0 / runs / n_ops);
+}
+
+static inline void
+bench_wait (gboolean *done)
+{
+  while (!*done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+/* Identifiers in the style of C APIs, such as "ide_buffer_get_file" */
+static inline GPtrArray *
+bench_synthetic_identifiers (guint n_identifiers)
+{
+  static const char *words[] = {
+    "ide", "buffer", "get", "set", "file", "context", "build", "pipeline",
+    "search", "fuzzy", "index", "map", "async", "finish", "new", "free",
+    "symbol", "tree", "node", "cursor", "query", "result", "provider",
+    "manager", "runtime", "config", "lsp", "client", "diagnostic", "range",
+  };
+  GPtrArray *ar = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(GRand) rand = g_rand_new_with_seed (BENCH_SEED);
+  g_autoptr(GString) str = g_string_new (NULL);
+
+  for (guint i = 0; i < n_identifiers; i++)
+    {
+      guint n_words = g_rand_int_range (rand, 2, 6);
+
+      g_string_truncate (str, 0);
+
+      for (guint j = 0; j < n_words; j++)
+        {
+          if (j > 0)
+            g_string_append_c (str, '_');
+          g_string_append (str, words[g_rand_int_range (rand, 0, G_N_ELEMENTS (words))]);
+        }
+
+      /* Keep keys unique so that insert cost is comparable */
+      g_string_append_printf (str, "_%u", i);
+      g_ptr_array_add (ar, g_strdup (str->str));
+    }
+
+  return ar;
+}
+
+/* Lines in the style of compiler output, some of which are diagnostics */
+static inline GBytes *
+bench_synthetic_build_log (guint n_lines)
+{
+  g_autoptr(GRand) rand = g_rand_new_with_seed (BENCH_SEED);
+  GString *str = g_string_new (NULL);
+
+  for (guint i = 0; i < n_lines; i++)
+    {
+      switch (g_rand_int_range (rand, 0, 4))
+        {
+        case 0:
+          g_string_append_printf (str, "../src/file-%u.c:%u:%u: warning: unused variable 'v%u' [-Wunused-variable]\n",
+                                  i % 97, i % 1000 + 1, i % 80 + 1, i);
+          break;
+
+        case 1:
+          g_string_append_printf (str, "[%u/%u] Compiling C object src/file-%u.c.o\n", i, n_lines, i % 97);
+          break;
+
+        default:
+          g_string_append_printf (str, "cc -Isrc -Ibuild -DG_LOG_DOMAIN=\"x\" -O2 -g -c ../src/file-%u.c -o src/file-%u.c.o\n",
+                                  i % 97, i % 97);
+          break;
+        }
+    }
+
+  return g_string_free_to_bytes (str);
+}
+
+static inline GBytes *
+bench_load_data (const char *name)
+{
+  g_autofree char *path = g_build_filename (TEST_DATA_DIR, name, NULL);
+  g_autoptr(GError) error = NULL;
+  char *contents = NULL;
+  gsize len = 0;
+
+  if (!g_file_get_contents (path, &contents, &len, &error))
+    g_error ("Failed to load corpus: %s", error->message);
+
+  return g_bytes_new_take (contents, len);
+}
+
+static inline int
+bench_compare_names (gconstpointer a,
+                     gconstpointer b)
+{
+  return strcmp (*(const char * const *)a, *(const char * const *)b);
+}
+
+/* The C sources of libide-io, for real-world line lengths */
+static inline GBytes *
+bench_recorded_sources (void)
+{
+  g_autofree char *dir_path = g_build_filename (TEST_DATA_DIR, "..", "..", "libide", "io", NULL);
+  g_autoptr(GPtrArray) names = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GDir) dir = NULL;
+  GString *str = g_string_new (NULL);
+  const char *name;
+
+  if (!(dir = g_dir_open (dir_path, 0, &error)))
+    g_error ("Failed to open sources: %s", error->message);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      if (g_str_has_suffix (name, ".c"))
+        g_ptr_array_add (names, g_strdup (name));
+    }
+
+  /* Keep the order stable regardless of the file-system */
+  g_ptr_array_sort (names, bench_compare_names);
+
+  for (guint i = 0; i < names->len; i++)
+    {
+      g_autofree char *path = g_build_filename (dir_path, g_ptr_array_index (names, i), NULL);
+      g_autofree char *contents = NULL;
+      gsize len = 0;
+
+      if (!g_file_get_contents (path, &contents, &len, &error))
+        g_error ("Failed to load %s: %s", path, error->message);
+
+      g_string_append_len (str, contents, len);
+    }
+
+  return g_string_free_to_bytes (str);
+}
+
+/* Recorded function names, one per line */
+static inline GPtrArray *
+bench_recorded_identifiers (void)
+{
+  g_autoptr(GBytes) bytes = bench_load_data ("bench-identifiers.txt");
+  GPtrArray *ar = g_ptr_array_new_with_free_func (g_free);
+  g_auto(GStrv) lines = NULL;
+
+  lines = g_strsplit (g_bytes_get_data (bytes, NULL), "\n", 0);
+
+  for (guint i = 0; lines[i]; i++)
+    {
+      if (lines[i][0] != 0)
+        g_ptr_array_add (ar, g_strdup (lines[i]));
+    }
+
+  return ar;
+}
+
+G_END_DECLS
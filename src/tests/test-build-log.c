@@ -0,0 +1,152 @@
+/* test-build-log.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-foundry.h>
+#include <string.h>
+
+#include "ide-build-log-private.h"
+
+static void
+append (IdeBuildLog *log,
+        const char  *str)
+{
+  ide_build_log_append (log, (const guint8 *)str, strlen (str));
+}
+
+static void
+assert_line (IdeBuildLog *log,
+             guint64      line,
+             const char  *expected)
+{
+  g_autofree char *str = ide_build_log_dup_line (log, line);
+  g_assert_cmpstr (str, ==, expected);
+}
+
+static void
+test_build_log_lines (void)
+{
+  g_autoptr(IdeBuildLog) log = ide_build_log_new_with_capacity (4096);
+
+  g_assert_cmpint (ide_build_log_append (log, (const guint8 *)"abc", 3), ==, 0);
+  g_assert_cmpint (ide_build_log_append (log, (const guint8 *)"def\nghi\r\n", 9), ==, 0);
+  g_assert_cmpint (ide_build_log_append (log, (const guint8 *)"jkl\n", 4), ==, 2);
+  g_assert_cmpint (ide_build_log_append (log, (const guint8 *)"mno", 3), ==, 3);
+
+  assert_line (log, 0, "abcdef");
+  assert_line (log, 1, "ghi");
+  assert_line (log, 2, "jkl");
+  assert_line (log, 3, "mno");
+  assert_line (log, 4, NULL);
+}
+
+static void
+test_build_log_wrap (void)
+{
+  g_autoptr(IdeBuildLog) log = ide_build_log_new_with_capacity (64);
+  g_autoptr(GArray) matches = NULL;
+
+  /* 10 lines of 10 bytes, only the last 6 (and a bit) fit */
+  for (guint i = 0; i < 10; i++)
+    {
+      g_autofree char *str = g_strdup_printf ("line-%04u\n", i);
+      append (log, str);
+    }
+
+  assert_line (log, 0, NULL);
+  assert_line (log, 3, NULL);
+  assert_line (log, 4, "line-0004");
+  assert_line (log, 9, "line-0009");
+  assert_line (log, 10, "");
+
+  matches = ide_build_log_search (log, "line-000", 0);
+  g_assert_cmpint (matches->len, ==, 6);
+  g_assert_cmpint (g_array_index (matches, guint64, 0), ==, 4);
+  g_assert_cmpint (g_array_index (matches, guint64, 5), ==, 9);
+  g_clear_pointer (&matches, g_array_unref);
+
+  /* Byte 64 is in the middle of line 6, so this crosses the ring boundary */
+  matches = ide_build_log_search (log, "line-0006", 0);
+  g_assert_cmpint (matches->len, ==, 1);
+  g_assert_cmpint (g_array_index (matches, guint64, 0), ==, 6);
+  g_clear_pointer (&matches, g_array_unref);
+
+  matches = ide_build_log_search (log, "line-0002", 0);
+  g_assert_cmpint (matches->len, ==, 0);
+  g_clear_pointer (&matches, g_array_unref);
+
+  matches = ide_build_log_search (log, "line", 2);
+  g_assert_cmpint (matches->len, ==, 2);
+  g_clear_pointer (&matches, g_array_unref);
+}
+
+static void
+test_build_log_large_append (void)
+{
+  g_autoptr(IdeBuildLog) log = ide_build_log_new_with_capacity (16);
+  guint64 line;
+
+  line = ide_build_log_append (log, (const guint8 *)"a\nb\nc\nd\nefghijklmnop\nqrs", 24);
+  g_assert_cmpint (line, ==, 0);
+
+  assert_line (log, 3, NULL);
+  assert_line (log, 4, "efghijklmnop");
+  assert_line (log, 5, "qrs");
+}
+
+static void
+test_build_log_diagnostics (void)
+{
+  g_autoptr(IdeBuildLog) log = ide_build_log_new_with_capacity (64);
+  guint64 line;
+
+  for (guint i = 0; i < 10; i++)
+    {
+      g_autofree char *str = g_strdup_printf ("line-%04u\n", i);
+      guint64 lineno = ide_build_log_append (log, (const guint8 *)str, strlen (str));
+
+      if (i % 3 == 0)
+        ide_build_log_add_diagnostic (log, lineno, IDE_DIAGNOSTIC_ERROR);
+      ide_build_log_add_diagnostic (log, lineno, IDE_DIAGNOSTIC_WARNING);
+      ide_build_log_add_diagnostic (log, lineno, IDE_DIAGNOSTIC_WARNING);
+    }
+
+  /* Lines 0 and 3 have been evicted, 6 and 9 remain */
+  g_assert_cmpint (ide_build_log_get_n_diagnostics (log, IDE_DIAGNOSTIC_ERROR), ==, 2);
+  g_assert_true (ide_build_log_get_diagnostic_line (log, IDE_DIAGNOSTIC_ERROR, 0, &line));
+  g_assert_cmpint (line, ==, 6);
+  g_assert_true (ide_build_log_get_diagnostic_line (log, IDE_DIAGNOSTIC_ERROR, 1, &line));
+  g_assert_cmpint (line, ==, 9);
+  g_assert_false (ide_build_log_get_diagnostic_line (log, IDE_DIAGNOSTIC_ERROR, 2, &line));
+
+  g_assert_cmpint (ide_build_log_get_n_diagnostics (log, IDE_DIAGNOSTIC_WARNING), ==, 6);
+  g_assert_cmpint (ide_build_log_get_n_diagnostics (log, IDE_DIAGNOSTIC_NOTE), ==, 0);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/BuildLog/lines", test_build_log_lines);
+  g_test_add_func ("/Ide/BuildLog/wrap", test_build_log_wrap);
+  g_test_add_func ("/Ide/BuildLog/large-append", test_build_log_large_append);
+  g_test_add_func ("/Ide/BuildLog/diagnostics", test_build_log_diagnostics);
+  return g_test_run ();
+}
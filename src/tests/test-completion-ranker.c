@@ -0,0 +1,135 @@
+/* test-completion-ranker.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libide-sourceview.h>
+
+typedef struct
+{
+  guint index;
+  guint priority;
+} Expected;
+
+static gint
+compare_expected (gconstpointer a,
+                  gconstpointer b)
+{
+  const Expected *ea = a;
+  const Expected *eb = b;
+
+  if (ea->priority != eb->priority)
+    return ea->priority < eb->priority ? -1 : 1;
+
+  return ea->index < eb->index ? -1 : ea->index > eb->index;
+}
+
+/* Ranks @keywords with gtk_source_completion_fuzzy_match() and a full
+ * sort, which is what providers did before using the ranker.
+ */
+static void
+assert_ranked (IdeCompletionRanker *ranker,
+               GPtrArray           *keywords,
+               const char          *typed_text)
+{
+  g_autoptr(GArray) expected = g_array_new (FALSE, FALSE, sizeof (Expected));
+  g_autofree char *folded = g_utf8_casefold (typed_text, -1);
+  guint n_matches;
+
+  for (guint i = 0; i < keywords->len; i++)
+    {
+      Expected e = { .index = i };
+
+      if (typed_text[0] == 0 ||
+          gtk_source_completion_fuzzy_match (g_ptr_array_index (keywords, i), folded, &e.priority))
+        g_array_append_val (expected, e);
+    }
+
+  g_array_sort (expected, compare_expected);
+
+  n_matches = ide_completion_ranker_refilter (ranker, typed_text);
+  g_assert_cmpint (n_matches, ==, expected->len);
+  g_assert_cmpint (ide_completion_ranker_get_n_matches (ranker), ==, expected->len);
+
+  for (guint i = 0; i < expected->len; i++)
+    g_assert_cmpint (ide_completion_ranker_get_index (ranker, i), ==, g_array_index (expected, Expected, i).index);
+}
+
+static void
+test_completion_ranker_matches (void)
+{
+  static const char *typed[] = {
+    "g", "gt", "gtk", "gtk_w", "gtk_wi", "gtk_w", "gtk_", "gtk_widget_show", "", "GTK_", "é", "x",
+  };
+  g_autoptr(IdeCompletionRanker) ranker = ide_completion_ranker_new (NULL);
+  g_autoptr(GPtrArray) keywords = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(GRand) rand = g_rand_new_with_seed (42);
+  static const char *words[] = { "gtk", "widget", "show", "GTK", "get", "Widget", "é", "x" };
+
+  /* Enough candidates that only part of the matches are sorted eagerly */
+  for (guint i = 0; i < 500; i++)
+    {
+      GString *str = g_string_new (NULL);
+      guint n_words = g_rand_int_range (rand, 1, 5);
+
+      for (guint j = 0; j < n_words; j++)
+        {
+          if (j > 0)
+            g_string_append_c (str, '_');
+          g_string_append (str, words[g_rand_int_range (rand, 0, G_N_ELEMENTS (words))]);
+        }
+
+      g_ptr_array_add (keywords, g_string_free (str, FALSE));
+    }
+
+  for (guint i = 0; i < keywords->len; i++)
+    ide_completion_ranker_add_candidate (ranker, i, g_ptr_array_index (keywords, i));
+
+  /* Typing and backspacing exercises both the incremental and the full
+   * refilter paths.
+   */
+  for (guint i = 0; i < G_N_ELEMENTS (typed); i++)
+    assert_ranked (ranker, keywords, typed[i]);
+}
+
+static void
+test_completion_ranker_empty (void)
+{
+  g_autoptr(IdeCompletionRanker) ranker = ide_completion_ranker_new (NULL);
+
+  g_assert_cmpint (ide_completion_ranker_refilter (ranker, NULL), ==, 0);
+  g_assert_cmpint (ide_completion_ranker_refilter (ranker, "abc"), ==, 0);
+
+  ide_completion_ranker_add_candidate (ranker, 7, "");
+  ide_completion_ranker_add_candidate (ranker, 3, "abc");
+
+  g_assert_cmpint (ide_completion_ranker_refilter (ranker, NULL), ==, 2);
+  g_assert_cmpint (ide_completion_ranker_get_index (ranker, 0), ==, 7);
+  g_assert_cmpint (ide_completion_ranker_get_index (ranker, 1), ==, 3);
+
+  g_assert_cmpint (ide_completion_ranker_refilter (ranker, "ac"), ==, 1);
+  g_assert_cmpint (ide_completion_ranker_get_index (ranker, 0), ==, 3);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/CompletionRanker/matches", test_completion_ranker_matches);
+  g_test_add_func ("/Ide/CompletionRanker/empty", test_completion_ranker_empty);
+  return g_test_run ();
+}
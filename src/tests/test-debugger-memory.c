@@ -0,0 +1,169 @@
+/* test-debugger-memory.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-debugger.h>
+#include <string.h>
+
+#include "ide-debugger-address-map-private.h"
+#include "ide-debugger-memory-cache-private.h"
+
+static void
+insert_entry (IdeDebuggerAddressMap *map,
+              const gchar           *filename,
+              IdeDebuggerAddress     start,
+              IdeDebuggerAddress     end)
+{
+  IdeDebuggerAddressMapEntry entry = { filename, 0, start, end };
+
+  ide_debugger_address_map_insert (map, &entry);
+}
+
+static void
+test_address_map_basic (void)
+{
+  g_autoptr(IdeDebuggerAddressMap) map = ide_debugger_address_map_new ();
+  const IdeDebuggerAddressMapEntry *entry;
+
+  /* Insert out of order to exercise sorted insertion */
+  insert_entry (map, "libc.so", 0x7000, 0x8000);
+  insert_entry (map, "app", 0x1000, 0x2000);
+  insert_entry (map, "libglib.so", 0x4000, 0x6000);
+
+  g_assert_null (ide_debugger_address_map_lookup (map, 0x0));
+  g_assert_null (ide_debugger_address_map_lookup (map, 0xfff));
+  g_assert_null (ide_debugger_address_map_lookup (map, 0x2000));
+  g_assert_null (ide_debugger_address_map_lookup (map, 0x6000));
+  g_assert_null (ide_debugger_address_map_lookup (map, 0x9000));
+
+  entry = ide_debugger_address_map_lookup (map, 0x1000);
+  g_assert_nonnull (entry);
+  g_assert_cmpstr (entry->filename, ==, "app");
+
+  entry = ide_debugger_address_map_lookup (map, 0x1fff);
+  g_assert_nonnull (entry);
+  g_assert_cmpstr (entry->filename, ==, "app");
+
+  entry = ide_debugger_address_map_lookup (map, 0x5123);
+  g_assert_nonnull (entry);
+  g_assert_cmpstr (entry->filename, ==, "libglib.so");
+
+  entry = ide_debugger_address_map_lookup (map, 0x7fff);
+  g_assert_nonnull (entry);
+  g_assert_cmpstr (entry->filename, ==, "libc.so");
+
+  g_assert_true (ide_debugger_address_map_remove (map, 0x4000));
+  g_assert_false (ide_debugger_address_map_remove (map, 0x4000));
+  g_assert_null (ide_debugger_address_map_lookup (map, 0x5123));
+
+  entry = ide_debugger_address_map_lookup (map, 0x7000);
+  g_assert_nonnull (entry);
+  g_assert_cmpstr (entry->filename, ==, "libc.so");
+}
+
+static GBytes *
+make_block (guint8 fill)
+{
+  guint8 *data = g_malloc (IDE_DEBUGGER_MEMORY_BLOCK_SIZE);
+
+  memset (data, fill, IDE_DEBUGGER_MEMORY_BLOCK_SIZE);
+
+  return g_bytes_new_take (data, IDE_DEBUGGER_MEMORY_BLOCK_SIZE);
+}
+
+static void
+test_memory_cache_lru (void)
+{
+  g_autoptr(IdeDebuggerMemoryCache) cache = ide_debugger_memory_cache_new (2);
+  g_autoptr(GBytes) a = make_block ('a');
+  g_autoptr(GBytes) b = make_block ('b');
+  g_autoptr(GBytes) c = make_block ('c');
+  g_autoptr(GBytes) found = NULL;
+
+  ide_debugger_memory_cache_insert (cache, 0x1000, a);
+  ide_debugger_memory_cache_insert (cache, 0x2000, b);
+
+  /* Touch the first block so the second is the least recently used */
+  found = ide_debugger_memory_cache_lookup (cache, 0x1000);
+  g_assert_true (found == a);
+  g_clear_pointer (&found, g_bytes_unref);
+
+  ide_debugger_memory_cache_insert (cache, 0x3000, c);
+
+  found = ide_debugger_memory_cache_lookup (cache, 0x2000);
+  g_assert_null (found);
+
+  found = ide_debugger_memory_cache_lookup (cache, 0x1000);
+  g_assert_true (found == a);
+  g_clear_pointer (&found, g_bytes_unref);
+
+  found = ide_debugger_memory_cache_lookup (cache, 0x3000);
+  g_assert_true (found == c);
+  g_clear_pointer (&found, g_bytes_unref);
+}
+
+static void
+test_memory_cache_invalidate (void)
+{
+  g_autoptr(IdeDebuggerMemoryCache) cache = ide_debugger_memory_cache_new (16);
+  g_autoptr(GBytes) bytes = make_block ('x');
+  g_autoptr(GBytes) found = NULL;
+  guint generation;
+
+  g_assert_cmpint (ide_debugger_memory_block_align (0x1234), ==, 0x1000);
+  g_assert_cmpint (ide_debugger_memory_block_align (0x1000), ==, 0x1000);
+
+  for (guint i = 1; i <= 4; i++)
+    ide_debugger_memory_cache_insert (cache, i * IDE_DEBUGGER_MEMORY_BLOCK_SIZE, bytes);
+
+  generation = ide_debugger_memory_cache_get_generation (cache);
+
+  /* Touches the last byte of 0x1000 and the first byte of 0x2000 */
+  ide_debugger_memory_cache_invalidate_range (cache, 0x1fff, 2);
+  g_assert_cmpint (generation, !=, ide_debugger_memory_cache_get_generation (cache));
+
+  found = ide_debugger_memory_cache_lookup (cache, 0x1000);
+  g_assert_null (found);
+  found = ide_debugger_memory_cache_lookup (cache, 0x2000);
+  g_assert_null (found);
+
+  found = ide_debugger_memory_cache_lookup (cache, 0x3000);
+  g_assert_nonnull (found);
+  g_clear_pointer (&found, g_bytes_unref);
+
+  generation = ide_debugger_memory_cache_get_generation (cache);
+  ide_debugger_memory_cache_invalidate (cache);
+  g_assert_cmpint (generation, !=, ide_debugger_memory_cache_get_generation (cache));
+
+  found = ide_debugger_memory_cache_lookup (cache, 0x3000);
+  g_assert_null (found);
+  found = ide_debugger_memory_cache_lookup (cache, 0x4000);
+  g_assert_null (found);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/Debugger/AddressMap/basic", test_address_map_basic);
+  g_test_add_func ("/Ide/Debugger/MemoryCache/lru", test_memory_cache_lru);
+  g_test_add_func ("/Ide/Debugger/MemoryCache/invalidate", test_memory_cache_invalidate);
+  return g_test_run ();
+}
@@ -0,0 +1,134 @@
+/* test-fuzzy-index.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-search.h>
+
+static const char *keys[] = {
+  "ide_buffer_get_file", "ide_buffer_set_file", "ide_pipeline_build_async",
+  "ide_pipeline_build_finish", "ide_fuzzy_index_query_async", "ide_fuzzy_index_new",
+  "ide_fuzzy_mutable_index_match", "gbp_code_index_builder_new", "Ide Buffer",
+  "ide_context_ref_workdir", "ide_search_engine_search_async", "bfoo",
+};
+
+static void
+query_cb (GObject      *object,
+          GAsyncResult *result,
+          gpointer      user_data)
+{
+  GListModel **model = user_data;
+  g_autoptr(GError) error = NULL;
+
+  *model = ide_fuzzy_index_query_finish (IDE_FUZZY_INDEX (object), result, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (*model);
+}
+
+static GListModel *
+query (IdeFuzzyIndex *index,
+       const char    *text)
+{
+  GListModel *model = NULL;
+
+  ide_fuzzy_index_query_async (index, text, 0, NULL, query_cb, &model);
+  while (model == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  return model;
+}
+
+static IdeFuzzyIndex *
+load_index (GFile *file)
+{
+  IdeFuzzyIndex *index = ide_fuzzy_index_new ();
+  g_autoptr(GError) error = NULL;
+
+  ide_fuzzy_index_load_file (index, file, NULL, &error);
+  g_assert_no_error (error);
+
+  return index;
+}
+
+static void
+assert_same_results (GListModel *a,
+                     GListModel *b)
+{
+  guint n_items = g_list_model_get_n_items (a);
+
+  g_assert_cmpint (n_items, ==, g_list_model_get_n_items (b));
+
+  for (guint i = 0; i < n_items; i++)
+    {
+      g_autoptr(IdeFuzzyIndexMatch) ma = g_list_model_get_item (a, i);
+      g_autoptr(IdeFuzzyIndexMatch) mb = g_list_model_get_item (b, i);
+
+      g_assert_cmpstr (ide_fuzzy_index_match_get_key (ma), ==, ide_fuzzy_index_match_get_key (mb));
+      g_assert_cmpfloat (ide_fuzzy_index_match_get_score (ma), ==, ide_fuzzy_index_match_get_score (mb));
+    }
+}
+
+static void
+test_fuzzy_index_refine (void)
+{
+  static const char *typed[] = { "ide_buf", "ide_fuzzy_index_q", "i b", "bf", "xyz" };
+  g_autoptr(IdeFuzzyIndexBuilder) builder = ide_fuzzy_index_builder_new ();
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) file = NULL;
+
+  for (guint i = 0; i < G_N_ELEMENTS (keys); i++)
+    ide_fuzzy_index_builder_insert (builder, keys[i], g_variant_new_uint32 (i), 0);
+
+  file = g_file_new_tmp ("test-fuzzy-index-XXXXXX", &stream, &error);
+  g_assert_no_error (error);
+
+  ide_fuzzy_index_builder_write (builder, file, G_PRIORITY_DEFAULT, NULL, &error);
+  g_assert_no_error (error);
+
+  /* Type each query a character at a time, which refines the results
+   * of the previous query, and compare against a query from scratch.
+   */
+  for (guint i = 0; i < G_N_ELEMENTS (typed); i++)
+    {
+      g_autoptr(IdeFuzzyIndex) typing = load_index (file);
+      g_autoptr(GListModel) previous = NULL;
+
+      for (guint len = 1; typed[i][len-1]; len++)
+        {
+          g_autofree char *prefix = g_strndup (typed[i], len);
+          g_autoptr(IdeFuzzyIndex) fresh = load_index (file);
+          g_autoptr(GListModel) expected = query (fresh, prefix);
+          g_autoptr(GListModel) model = query (typing, prefix);
+
+          assert_same_results (expected, model);
+          g_set_object (&previous, model);
+        }
+    }
+
+  g_file_delete (file, NULL, NULL);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/FuzzyIndex/refine", test_fuzzy_index_refine);
+  return g_test_run ();
+}
@@ -0,0 +1,134 @@
+/* test-index-registry.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-io.h>
+#include <string.h>
+
+static GFile *
+create_file (const char *contents)
+{
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) file = NULL;
+
+  file = g_file_new_tmp ("test-index-registry-XXXXXX", &stream, &error);
+  g_assert_no_error (error);
+
+  g_file_replace_contents (file, contents, strlen (contents), NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  return g_steal_pointer (&file);
+}
+
+static void
+test_index_registry_share (void)
+{
+  g_autoptr(IdeIndexRegistry) registry = ide_index_registry_new ();
+  g_autoptr(GFile) file = create_file ("index");
+  g_autoptr(GFile) alias = g_file_new_for_path (g_file_peek_path (file));
+  g_autoptr(GObject) first = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr(GObject) second = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr(GObject) shared = NULL;
+  g_autoptr(GObject) found = NULL;
+  GObject *ret;
+
+  g_assert_null (ide_index_registry_lookup (registry, G_TYPE_OBJECT, file, NULL));
+
+  shared = ide_index_registry_insert (registry, file, NULL, first);
+  g_assert_true (shared == first);
+
+  /* Same file through another GFile, but not for another type or qualifier */
+  found = ide_index_registry_lookup (registry, G_TYPE_OBJECT, alias, NULL);
+  g_assert_true (found == first);
+  g_assert_null (ide_index_registry_lookup (registry, G_TYPE_INITIALLY_UNOWNED, file, NULL));
+  g_assert_null (ide_index_registry_lookup (registry, G_TYPE_OBJECT, file, "/root"));
+
+  /* A racing load gets the first index back */
+  ret = ide_index_registry_insert (registry, alias, NULL, second);
+  g_assert_true (ret == first);
+  g_object_unref (ret);
+
+  /* Only weak references are held */
+  g_clear_object (&found);
+  g_clear_object (&shared);
+  g_clear_object (&first);
+  g_assert_null (ide_index_registry_lookup (registry, G_TYPE_OBJECT, file, NULL));
+
+  g_file_delete (file, NULL, NULL);
+}
+
+static void
+test_index_registry_modified (void)
+{
+  g_autoptr(IdeIndexRegistry) registry = ide_index_registry_new ();
+  g_autoptr(GFile) file = create_file ("index");
+  g_autoptr(GObject) index = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr(GObject) shared = NULL;
+  g_autoptr(GError) error = NULL;
+
+  shared = ide_index_registry_insert (registry, file, NULL, index);
+
+  /* A rewritten file is a different index */
+  g_file_replace_contents (file, "longer index", 12, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_null (ide_index_registry_lookup (registry, G_TYPE_OBJECT, file, NULL));
+
+  g_file_delete (file, NULL, NULL);
+}
+
+static void
+test_index_registry_prebuilt (void)
+{
+  g_autoptr(IdeIndexRegistry) registry = ide_index_registry_new ();
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) found = NULL;
+  g_autofree char *tmpdir = NULL;
+  g_autofree char *sdkdir = NULL;
+
+  tmpdir = g_dir_make_tmp ("test-index-registry-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  sdkdir = g_build_filename (tmpdir, "code-index", "flatpak", "org.gnome.Sdk", "x86_64", "44", NULL);
+  g_assert_cmpint (g_mkdir_with_parents (sdkdir, 0750), ==, 0);
+
+  g_assert_null (ide_index_registry_find_prebuilt (registry, "code-index", "flatpak:org.gnome.Sdk/x86_64/44"));
+
+  ide_index_registry_add_prebuilt_dir (registry, tmpdir);
+
+  found = ide_index_registry_find_prebuilt (registry, "code-index", "flatpak:org.gnome.Sdk/x86_64/44");
+  g_assert_nonnull (found);
+  g_assert_cmpstr (g_file_peek_path (found), ==, sdkdir);
+
+  g_assert_null (ide_index_registry_find_prebuilt (registry, "ctags", "flatpak:org.gnome.Sdk/x86_64/44"));
+  g_assert_null (ide_index_registry_find_prebuilt (registry, "code-index", "../code-index/flatpak"));
+
+  g_rmdir (sdkdir);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/IndexRegistry/share", test_index_registry_share);
+  g_test_add_func ("/Ide/IndexRegistry/modified", test_index_registry_modified);
+  g_test_add_func ("/Ide/IndexRegistry/prebuilt", test_index_registry_prebuilt);
+  return g_test_run ();
+}
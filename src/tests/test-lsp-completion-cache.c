@@ -0,0 +1,146 @@
+/* test-lsp-completion-cache.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-lsp.h>
+
+#include "ide-lsp-completion-cache-private.h"
+
+#define URI       "file:///project/main.c"
+#define LINE_TEXT "  self->"
+#define MAX_AGE   (30 * G_USEC_PER_SEC)
+
+static GVariant *
+create_results (gboolean is_incomplete)
+{
+  return g_variant_new_parsed ("{'isIncomplete': <%b>, 'items': <@av []>}", is_incomplete);
+}
+
+static void
+test_completion_cache_reuse (void)
+{
+  g_autoptr(IdeLspCompletionCache) cache = _ide_lsp_completion_cache_new (8, MAX_AGE);
+  g_autoptr(IdeLspCompletionCacheEntry) entry = NULL;
+  gint64 now = g_get_monotonic_time ();
+
+  entry = _ide_lsp_completion_cache_entry_new (URI, 10, 8, LINE_TEXT, "fo");
+  _ide_lsp_completion_cache_insert (cache, entry);
+
+  /* Typing more while the request is in flight can wait for it */
+  g_assert_true (_ide_lsp_completion_cache_entry_can_reuse (entry, "foo"));
+
+  _ide_lsp_completion_cache_entry_set_results (entry, create_results (FALSE), now);
+  g_assert_false (entry->is_incomplete);
+
+  g_assert_true (_ide_lsp_completion_cache_lookup (cache, URI, 10, 8, LINE_TEXT, now) == entry);
+  g_assert_null (_ide_lsp_completion_cache_lookup (cache, URI, 10, 8, "  other->", now));
+  g_assert_null (_ide_lsp_completion_cache_lookup (cache, URI, 11, 8, LINE_TEXT, now));
+  g_assert_null (_ide_lsp_completion_cache_lookup (cache, "file:///project/other.c", 10, 8, LINE_TEXT, now));
+
+  /* A complete result set can be filtered for any longer word */
+  g_assert_true (_ide_lsp_completion_cache_entry_can_reuse (entry, "fo"));
+  g_assert_true (_ide_lsp_completion_cache_entry_can_reuse (entry, "foobar"));
+
+  /* but backspacing needs a regular request, not one for incomplete results */
+  g_assert_false (_ide_lsp_completion_cache_entry_can_reuse (entry, "f"));
+  g_assert_false (_ide_lsp_completion_cache_entry_can_reuse (entry, NULL));
+  g_assert_cmpint (_ide_lsp_completion_cache_entry_trigger_kind (entry), ==, IDE_LSP_COMPLETION_TRIGGER_INVOKED);
+}
+
+static void
+test_completion_cache_incomplete (void)
+{
+  g_autoptr(IdeLspCompletionCacheEntry) entry = NULL;
+
+  entry = _ide_lsp_completion_cache_entry_new (URI, 10, 8, LINE_TEXT, "fo");
+  _ide_lsp_completion_cache_entry_set_results (entry, create_results (TRUE), g_get_monotonic_time ());
+  g_assert_true (entry->is_incomplete);
+
+  /* Only the exact word may use an incomplete result set */
+  g_assert_true (_ide_lsp_completion_cache_entry_can_reuse (entry, "fo"));
+  g_assert_false (_ide_lsp_completion_cache_entry_can_reuse (entry, "foo"));
+  g_assert_false (_ide_lsp_completion_cache_entry_can_reuse (entry, "f"));
+  g_assert_cmpint (_ide_lsp_completion_cache_entry_trigger_kind (entry), ==, IDE_LSP_COMPLETION_TRIGGER_FOR_INCOMPLETE);
+
+  /* Replies without isIncomplete are always complete */
+  _ide_lsp_completion_cache_entry_set_results (entry, g_variant_new_parsed ("@av []"), g_get_monotonic_time ());
+  g_assert_false (entry->is_incomplete);
+  g_assert_true (_ide_lsp_completion_cache_entry_can_reuse (entry, "foo"));
+
+  /* Failed requests are never reused */
+  entry->failed = TRUE;
+  g_assert_false (_ide_lsp_completion_cache_entry_can_reuse (entry, "fo"));
+}
+
+static void
+test_completion_cache_expiry (void)
+{
+  g_autoptr(IdeLspCompletionCache) cache = _ide_lsp_completion_cache_new (2, MAX_AGE);
+  g_autoptr(IdeLspCompletionCacheEntry) in_flight = NULL;
+  g_autoptr(IdeLspCompletionCacheEntry) old = NULL;
+  g_autoptr(IdeLspCompletionCacheEntry) failed = NULL;
+  g_autoptr(IdeLspCompletionCacheEntry) a = NULL;
+  g_autoptr(IdeLspCompletionCacheEntry) b = NULL;
+  g_autoptr(IdeLspCompletionCacheEntry) c = NULL;
+  gint64 now = g_get_monotonic_time ();
+
+  old = _ide_lsp_completion_cache_entry_new (URI, 1, 0, "", "");
+  _ide_lsp_completion_cache_entry_set_results (old, create_results (FALSE), now);
+  _ide_lsp_completion_cache_insert (cache, old);
+
+  in_flight = _ide_lsp_completion_cache_entry_new (URI, 2, 0, "", "");
+  _ide_lsp_completion_cache_insert (cache, in_flight);
+
+  /* Result sets expire, since other lines may have changed since */
+  g_assert_true (_ide_lsp_completion_cache_lookup (cache, URI, 1, 0, "", now + MAX_AGE) == old);
+  g_assert_null (_ide_lsp_completion_cache_lookup (cache, URI, 1, 0, "", now + MAX_AGE + 1));
+
+  /* In-flight requests do not, as waiters are attached to them */
+  g_assert_true (_ide_lsp_completion_cache_lookup (cache, URI, 2, 0, "", now + 2 * MAX_AGE) == in_flight);
+
+  /* Failed requests are dropped */
+  failed = _ide_lsp_completion_cache_entry_new (URI, 3, 0, "", "");
+  failed->failed = TRUE;
+  _ide_lsp_completion_cache_insert (cache, failed);
+  g_assert_null (_ide_lsp_completion_cache_lookup (cache, URI, 3, 0, "", now));
+
+  /* The least recently used entry is evicted past the size */
+  _ide_lsp_completion_cache_clear (cache);
+  a = _ide_lsp_completion_cache_entry_new (URI, 1, 0, "", "");
+  b = _ide_lsp_completion_cache_entry_new (URI, 2, 0, "", "");
+  c = _ide_lsp_completion_cache_entry_new (URI, 3, 0, "", "");
+  _ide_lsp_completion_cache_insert (cache, a);
+  _ide_lsp_completion_cache_insert (cache, b);
+  g_assert_true (_ide_lsp_completion_cache_lookup (cache, URI, 1, 0, "", now) == a);
+  _ide_lsp_completion_cache_insert (cache, c);
+  g_assert_true (_ide_lsp_completion_cache_lookup (cache, URI, 1, 0, "", now) == a);
+  g_assert_true (_ide_lsp_completion_cache_lookup (cache, URI, 3, 0, "", now) == c);
+  g_assert_null (_ide_lsp_completion_cache_lookup (cache, URI, 2, 0, "", now));
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/Lsp/CompletionCache/reuse", test_completion_cache_reuse);
+  g_test_add_func ("/Ide/Lsp/CompletionCache/incomplete", test_completion_cache_incomplete);
+  g_test_add_func ("/Ide/Lsp/CompletionCache/expiry", test_completion_cache_expiry);
+  return g_test_run ();
+}
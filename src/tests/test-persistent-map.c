@@ -0,0 +1,193 @@
+/* test-persistent-map.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-io.h>
+
+#define N_KEYS 1000
+
+static GFile *
+write_map (gboolean fixed_width)
+{
+  g_autoptr(IdePersistentMapBuilder) builder = ide_persistent_map_builder_new ();
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) file = NULL;
+
+  file = g_file_new_tmp ("test-persistent-map-XXXXXX", &stream, &error);
+  g_assert_no_error (error);
+
+  for (guint i = 0; i < N_KEYS; i++)
+    {
+      g_autofree char *key = g_strdup_printf ("c:@F@symbol_%u", i);
+
+      GVariant *value;
+
+      if (fixed_width)
+        value = g_variant_new ("(uuuu)", i, i * 2, i * 3, i * 4);
+      else
+        value = g_variant_new ("(uuuus)", i, i * 2, i * 3, i * 4, key);
+
+      ide_persistent_map_builder_insert (builder, key, value, FALSE);
+    }
+
+  /* Duplicate keys keep the first value unless asked to replace */
+  ide_persistent_map_builder_insert (builder,
+                                     "c:@F@symbol_1",
+                                     fixed_width ? g_variant_new ("(uuuu)", 0, 0, 0, 0)
+                                                 : g_variant_new ("(uuuus)", 0, 0, 0, 0, ""),
+                                     FALSE);
+
+  ide_persistent_map_builder_set_metadata_int64 (builder, "n-keys", N_KEYS);
+  ide_persistent_map_builder_write (builder, file, G_PRIORITY_DEFAULT, NULL, &error);
+  g_assert_no_error (error);
+
+  return g_steal_pointer (&file);
+}
+
+static void
+check_map (gboolean fixed_width)
+{
+  g_autoptr(IdePersistentMap) map = ide_persistent_map_new ();
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) file = write_map (fixed_width);
+  const char *missing[] = { "", "c", "c:@F@", "c:@F@symbol_", "c:@F@symbol_1000", "d:@F@symbol_1", "c:@F@symbol_1x" };
+  gboolean r;
+
+  r = ide_persistent_map_load_file (map, file, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_true (r);
+
+  g_assert_cmpint (ide_persistent_map_builder_get_metadata_int64 (map, "n-keys"), ==, N_KEYS);
+
+  for (guint i = 0; i < N_KEYS; i++)
+    {
+      g_autofree char *key = g_strdup_printf ("c:@F@symbol_%u", i);
+      g_autoptr(GVariant) value = ide_persistent_map_lookup_value (map, key);
+      const IdePersistentMapRecord *record = ide_persistent_map_lookup_record (map, key);
+      guint32 v[4];
+
+      g_assert_nonnull (value);
+
+      /* Variable-width values cannot be borrowed as records */
+      if (!fixed_width)
+        {
+          const char *str;
+
+          g_variant_get (value, "(uuuu&s)", &v[0], &v[1], &v[2], &v[3], &str);
+          g_assert_cmpuint (v[0], ==, i);
+          g_assert_cmpuint (v[3], ==, i * 4);
+          g_assert_cmpstr (str, ==, key);
+          g_assert_null (record);
+          continue;
+        }
+
+      g_variant_get (value, "(uuuu)", &v[0], &v[1], &v[2], &v[3]);
+      g_assert_cmpuint (v[0], ==, i);
+      g_assert_cmpuint (v[3], ==, i * 4);
+
+      g_assert_nonnull (record);
+      g_assert_cmpuint (record->values[0], ==, i);
+      g_assert_cmpuint (record->values[1], ==, i * 2);
+      g_assert_cmpuint (record->values[2], ==, i * 3);
+      g_assert_cmpuint (record->values[3], ==, i * 4);
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (missing); i++)
+    {
+      g_assert_null (ide_persistent_map_lookup_value (map, missing[i]));
+      g_assert_null (ide_persistent_map_lookup_record (map, missing[i]));
+    }
+
+  g_file_delete (file, NULL, NULL);
+}
+
+static void
+test_persistent_map_records (void)
+{
+  check_map (TRUE);
+}
+
+static void
+test_persistent_map_variants (void)
+{
+  check_map (FALSE);
+}
+
+static void
+test_persistent_map_single (void)
+{
+  g_autoptr(IdePersistentMapBuilder) builder = ide_persistent_map_builder_new ();
+  g_autoptr(IdePersistentMap) map = ide_persistent_map_new ();
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) file = NULL;
+  const IdePersistentMapRecord *record;
+
+  file = g_file_new_tmp ("test-persistent-map-XXXXXX", &stream, &error);
+  g_assert_no_error (error);
+
+  /* A single key is entirely common prefix */
+  ide_persistent_map_builder_insert (builder, "key", g_variant_new ("(uuuu)", 1, 2, 3, 4), FALSE);
+  ide_persistent_map_builder_write (builder, file, G_PRIORITY_DEFAULT, NULL, &error);
+  g_assert_no_error (error);
+
+  ide_persistent_map_load_file (map, file, NULL, &error);
+  g_assert_no_error (error);
+
+  record = ide_persistent_map_lookup_record (map, "key");
+  g_assert_nonnull (record);
+  g_assert_cmpuint (record->values[3], ==, 4);
+  g_assert_null (ide_persistent_map_lookup_record (map, "ke"));
+  g_assert_null (ide_persistent_map_lookup_record (map, "keys"));
+
+  g_file_delete (file, NULL, NULL);
+}
+
+static void
+test_persistent_map_empty (void)
+{
+  g_autoptr(IdePersistentMapBuilder) builder = ide_persistent_map_builder_new ();
+  g_autoptr(GFileIOStream) stream = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GFile) file = NULL;
+  gboolean r;
+
+  file = g_file_new_tmp ("test-persistent-map-XXXXXX", &stream, &error);
+  g_assert_no_error (error);
+
+  /* Nothing inserted is an error, not an empty index */
+  r = ide_persistent_map_builder_write (builder, file, G_PRIORITY_DEFAULT, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_false (r);
+
+  g_file_delete (file, NULL, NULL);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/PersistentMap/records", test_persistent_map_records);
+  g_test_add_func ("/Ide/PersistentMap/variants", test_persistent_map_variants);
+  g_test_add_func ("/Ide/PersistentMap/single", test_persistent_map_single);
+  g_test_add_func ("/Ide/PersistentMap/empty", test_persistent_map_empty);
+  return g_test_run ();
+}
@@ -0,0 +1,129 @@
+/* test-text-scan.c
+ *
+ * Copyright 2023 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <libide-io.h>
+#include <string.h>
+
+#include "ide-text-scan-private.h"
+
+static const char *
+naive_find_byte2 (const char *data,
+                  gsize       len,
+                  char        ch1,
+                  char        ch2)
+{
+  for (gsize i = 0; i < len; i++)
+    {
+      if (data[i] == ch1 || data[i] == ch2)
+        return &data[i];
+    }
+
+  return NULL;
+}
+
+static gsize
+naive_ascii_len (const char *data,
+                 gsize       len)
+{
+  gsize i;
+
+  for (i = 0; i < len; i++)
+    {
+      if ((guchar)data[i] >= 0x80)
+        break;
+    }
+
+  return i;
+}
+
+static void
+test_text_scan_impl (gconstpointer data)
+{
+  IdeTextScanImpl impl = GPOINTER_TO_UINT (data);
+  g_autoptr(GRand) rand = g_rand_new_with_seed (1234);
+  char buf[256];
+
+  if (!_ide_text_scan_set_impl (impl))
+    {
+      g_test_skip ("Not supported by this CPU");
+      return;
+    }
+
+  /* Use random offsets and lengths so that every alignment and tail
+   * length is compared against the naive implementation.
+   */
+  for (guint i = 0; i < 20000; i++)
+    {
+      gsize offset = g_rand_int_range (rand, 0, 64);
+      gsize len = g_rand_int_range (rand, 0, sizeof buf - offset);
+      const char *str = &buf[offset];
+
+      for (guint j = 0; j < sizeof buf; j++)
+        {
+          switch (g_rand_int_range (rand, 0, 64))
+            {
+            case 0: buf[j] = '\n'; break;
+            case 1: buf[j] = '\t'; break;
+            case 2: buf[j] = (char)0xC3; break;
+            default: buf[j] = 'a' + j % 26; break;
+            }
+        }
+
+      g_assert_true (_ide_text_find_byte (str, len, '\n') == naive_find_byte2 (str, len, '\n', '\n'));
+      g_assert_true (_ide_text_find_byte2 (str, len, '\t', '\n') == naive_find_byte2 (str, len, '\t', '\n'));
+      g_assert_cmpint (_ide_text_ascii_len (str, len), ==, naive_ascii_len (str, len));
+    }
+
+  _ide_text_scan_set_impl (IDE_TEXT_SCAN_AUTO);
+}
+
+static void
+test_text_scan_utf8 (void)
+{
+  const char *str = "a\0é€";
+  const char *end = str + 7;
+  const char *pos = str;
+  gunichar ch;
+
+  g_assert_true (_ide_text_utf8_next (&pos, end, &ch));
+  g_assert_cmpint (ch, ==, 'a');
+  g_assert_true (_ide_text_utf8_next (&pos, end, &ch));
+  g_assert_cmpint (ch, ==, 0);
+  g_assert_true (_ide_text_utf8_next (&pos, end, &ch));
+  g_assert_cmpint (ch, ==, 0xE9);
+  g_assert_true (_ide_text_utf8_next (&pos, end, &ch));
+  g_assert_cmpint (ch, ==, 0x20AC);
+  g_assert_true (pos == end);
+
+  pos = "\xC3";
+  g_assert_false (_ide_text_utf8_next (&pos, pos + 1, &ch));
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_data_func ("/Ide/TextScan/scalar", GUINT_TO_POINTER (IDE_TEXT_SCAN_SCALAR), test_text_scan_impl);
+  g_test_add_data_func ("/Ide/TextScan/sse2", GUINT_TO_POINTER (IDE_TEXT_SCAN_SSE2), test_text_scan_impl);
+  g_test_add_data_func ("/Ide/TextScan/avx2", GUINT_TO_POINTER (IDE_TEXT_SCAN_AVX2), test_text_scan_impl);
+  g_test_add_func ("/Ide/TextScan/utf8", test_text_scan_utf8);
+  return g_test_run ();
+}